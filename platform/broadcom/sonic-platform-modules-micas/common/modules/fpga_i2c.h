@@ -26,6 +26,8 @@
 #include <linux/kallsyms.h>
 #include <linux/string.h>
 
+#include "wb_reg_access.h"
+
 #define mem_clear(data, size) memset((data), 0, (size))
 
 #if 0
@@ -97,6 +99,7 @@ typedef struct fpga_i2c_dev_s {
     uint32_t i2c_stretch_value;
     uint32_t i2c_timeout;
     uint32_t i2c_func_mode;
+    wb_reg_access_t reg_access;
     wait_queue_head_t queue;
     struct i2c_adapter adap;
     int adap_nr;
@@ -820,6 +820,11 @@ static int dfd_ko_cfg_init(void)
     }
     kfile_close(&kfile_ctrl);
 
+    rv = lnode_stats_create(&dfd_ko_cfg_list_root, KBUILD_MODNAME "_cfg_stats");
+    if (rv < 0) {
+        DBG_DEBUG(DBG_WARN, "create cfg stats fail, rv=%d\n", rv);
+    }
+
     return 0;
 }
 
@@ -830,6 +835,7 @@ int32_t dfd_dev_cfg_init(void)
 
 void dfd_dev_cfg_exit(void)
 {
+    lnode_stats_remove(&dfd_ko_cfg_list_root);
     lnode_free_list(&dfd_ko_cfg_list_root);
     return;
 }
@@ -1139,6 +1139,12 @@ static int dfd_ko_cfg_init(void)
     }
     kfile_close(&kfile_ctrl);
 
+    /* Lookup statistics, not being able to create them is not fatal */
+    rv = lnode_stats_create(&dfd_ko_cfg_list_root, KBUILD_MODNAME "_cfg_stats");
+    if (rv < 0) {
+        DBG_DEBUG(DBG_WARN, "create cfg stats fail, rv=%d\n", rv);
+    }
+
     /* todo Configure data validity check */
     return 0;
 }
@@ -1161,6 +1167,8 @@ int32_t dfd_dev_cfg_init(void)
 
 void dfd_dev_cfg_exit(void)
 {
+    dfd_ko_file_access_exit();
+    lnode_stats_remove(&dfd_ko_cfg_list_root);
     lnode_free_list(&dfd_ko_cfg_list_root);
     val_convert_node_lst_free(&dfd_lib_cfg_led_status_decode_conv_lst);
     val_convert_node_lst_free(&dfd_lib_cfg_fan_name_conv_dir_lst);
@@ -26,10 +26,31 @@
 #include <linux/delay.h>
 #include <linux/i2c.h>
 #include <linux/uio.h>
+#include <linux/mutex.h>
+#include <linux/hashtable.h>
+#include <linux/jhash.h>
 #include "wb_module.h"
 #include "dfd_cfg_file.h"
 #include "dfd_cfg.h"
 #include "dfd_cfg_adapter.h"
+#include "wb_reg_access.h"
+
+/*
+ * Paths of dfd_ko_read_file/dfd_ko_write_file, resolved on their first access.
+ * Only device nodes keep a handle open, the other paths are remembered so
+ * that they are not resolved again. Entries are added under the mutex and
+ * looked up under RCU, they are only freed at exit, after the last access.
+ */
+typedef struct dfd_ko_file_access_s {
+    struct hlist_node node;
+    int persistent;             /* access holds an open device node */
+    wb_reg_access_t access;
+    char fpath[DFD_KO_FILE_PATH_MAX_LEN];
+} dfd_ko_file_access_t;
+
+static DEFINE_HASHTABLE(dfd_ko_file_access_hash, DFD_KO_FILE_ACCESS_HASH_BITS);
+static int dfd_ko_file_access_num;
+static DEFINE_MUTEX(dfd_ko_file_access_lock);
 
 /* dfd_i2c_dev_t member string */
 char *g_dfd_i2c_dev_mem_str[DFD_I2C_DEV_MEM_END] = {
@@ -484,6 +505,90 @@ int32_t dfd_ko_i2c_write(int bus, int addr, int offset, uint8_t *buf, uint32_t s
 
 }
 
+static dfd_ko_file_access_t *dfd_ko_file_access_find(const char *fpath, u32 key)
+{
+    dfd_ko_file_access_t *file_access;
+
+    hash_for_each_possible_rcu(dfd_ko_file_access_hash, file_access, node, key,
+        lockdep_is_held(&dfd_ko_file_access_lock)) {
+        if (strcmp(file_access->fpath, fpath) == 0) {
+            return file_access;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * dfd_ko_get_file_access - Get the persistent access handle of a file
+ * @fpath: File path
+ * @write: The first access is a write: the handle is opened read-write,
+ *         otherwise read-only and the writes open the file themselves
+ *
+ * @returns: NULL the file is opened on each access, other the handle
+ */
+static wb_reg_access_t *dfd_ko_get_file_access(char *fpath, int write)
+{
+    dfd_ko_file_access_t *file_access;
+    size_t len;
+    u32 key;
+
+    len = strlen(fpath);
+    if (len >= DFD_KO_FILE_PATH_MAX_LEN) {
+        return NULL;
+    }
+    key = jhash(fpath, len, 0);
+
+    rcu_read_lock();
+    file_access = dfd_ko_file_access_find(fpath, key);
+    rcu_read_unlock();
+
+    if (file_access == NULL) {
+        mutex_lock(&dfd_ko_file_access_lock);
+        file_access = dfd_ko_file_access_find(fpath, key);
+        if ((file_access == NULL) && (dfd_ko_file_access_num < DFD_KO_FILE_ACCESS_MAX)) {
+            file_access = kzalloc(sizeof(dfd_ko_file_access_t), GFP_KERNEL);
+            if (file_access != NULL) {
+                strlcpy(file_access->fpath, fpath, sizeof(file_access->fpath));
+                wb_reg_access_init(&file_access->access, file_access->fpath, WB_REG_ACCESS_FILE, NULL, write);
+                file_access->persistent = (file_access->access.filp != NULL);
+                DBG_DEBUG(DBG_VERBOSE, "file[%s] access: %s\n", fpath, wb_reg_access_backend(&file_access->access));
+                hash_add_rcu(dfd_ko_file_access_hash, &file_access->node, key);
+                dfd_ko_file_access_num++;
+            }
+        }
+        mutex_unlock(&dfd_ko_file_access_lock);
+    }
+
+    if ((file_access == NULL) || !file_access->persistent) {
+        return NULL;
+    }
+
+    return &file_access->access;
+}
+
+/**
+ * dfd_ko_file_access_exit - Release the file handles of dfd_ko_read_file/dfd_ko_write_file
+ *
+ * @returns: void
+ */
+void dfd_ko_file_access_exit(void)
+{
+    dfd_ko_file_access_t *file_access;
+    struct hlist_node *tmp;
+    int bkt;
+
+    mutex_lock(&dfd_ko_file_access_lock);
+    hash_for_each_safe(dfd_ko_file_access_hash, bkt, tmp, file_access, node) {
+        hash_del_rcu(&file_access->node);
+        wb_reg_access_exit(&file_access->access);
+        kfree(file_access);
+    }
+    dfd_ko_file_access_num = 0;
+    mutex_unlock(&dfd_ko_file_access_lock);
+    return;
+}
+
 /**
  * dfd_ko_read_file - File read operation
  * @fpath: File path
@@ -498,6 +603,7 @@ int32_t dfd_ko_read_file(char *fpath, int32_t addr, uint8_t *val, int32_t read_b
     int32_t ret;
     struct file *filp;
     loff_t pos;
+    wb_reg_access_t *access;
 
     struct kvec iov = {
         .iov_base = val,
@@ -510,6 +616,16 @@ int32_t dfd_ko_read_file(char *fpath, int32_t addr, uint8_t *val, int32_t read_b
         return -DFD_RV_INDEX_INVALID;
     }
 
+    access = dfd_ko_get_file_access(fpath, 0);
+    if (access != NULL) {
+        ret = wb_reg_access_read(access, addr, val, read_bytes);
+        if (ret < 0) {
+            DBG_DEBUG(DBG_ERROR, "read file[%s] failed, addr=%d, size=%d, ret=%d\n", fpath, addr, read_bytes, ret);
+            return -DFD_RV_DEV_FAIL;
+        }
+        return ret;
+    }
+
     /* Open file */
     filp = filp_open(fpath, O_RDONLY, 0);
     if (IS_ERR(filp)) {
@@ -622,6 +738,7 @@ int32_t dfd_ko_write_file(char *fpath, int32_t addr, uint8_t *val, int32_t write
     int32_t ret;
     struct file *filp;
     loff_t pos;
+    wb_reg_access_t *access;
 
     struct kvec iov = {
         .iov_base = val,
@@ -634,6 +751,16 @@ int32_t dfd_ko_write_file(char *fpath, int32_t addr, uint8_t *val, int32_t write
         return -DFD_RV_INDEX_INVALID;
     }
 
+    access = dfd_ko_get_file_access(fpath, 1);
+    if (access != NULL) {
+        ret = wb_reg_access_write(access, addr, val, write_bytes);
+        if (ret < 0) {
+            DBG_DEBUG(DBG_ERROR, "write file[%s] failed, addr=%d, size=%d, ret=%d\n", fpath, addr, write_bytes, ret);
+            return -DFD_RV_DEV_FAIL;
+        }
+        return ret;
+    }
+
      /* Open file */
     filp = filp_open(fpath, O_RDWR, 777);
     if (IS_ERR(filp)) {
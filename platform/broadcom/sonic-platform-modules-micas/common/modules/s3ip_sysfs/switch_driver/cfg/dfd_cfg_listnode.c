@@ -20,9 +20,38 @@
 
 #include <linux/list.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "dfd_cfg_listnode.h"
 
+/* Hash bucket of a key, hash_64 keeps the whole 64-bit key on 32-bit kernels too */
+#define LNODE_BUCKET(root, key) (&(root)->hash[hash_64((key), LNODE_HASH_BITS)])
+
+/**
+ * Find node in the hash bucket of its key
+ * @root: Root node pointer
+ * @key: Node index value
+ * @probes: Number of nodes compared
+ *
+ * @return : Node pointer, NULL failed
+ */
+static lnode_node_t *lnode_lookup(lnode_root_t *root, uint64_t key, long *probes)
+{
+    lnode_node_t *lnode;
+
+    *probes = 0;
+    hlist_for_each_entry(lnode, LNODE_BUCKET(root, key), hnode) {
+        (*probes)++;
+        if (lnode->key == key) {
+            return lnode;
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * Find node
  * @root: Root node pointer
@@ -33,19 +62,21 @@
 void *lnode_find_node(lnode_root_t *root, uint64_t key)
 {
     lnode_node_t *lnode;
+    long probes;
 
     if (root == NULL) {
         return NULL;
     }
 
-    /* Traversal query */
-    list_for_each_entry(lnode, &(root->root), lst) {
-        if (lnode->key == key) {
-            return lnode->data;
-        }
+    lnode = lnode_lookup(root, key, &probes);
+    atomic_long_inc(&root->lookups);
+    atomic_long_add(probes, &root->probes);
+    if (lnode == NULL) {
+        atomic_long_inc(&root->misses);
+        return NULL;
     }
 
-    return NULL;
+    return lnode->data;
 }
 
 /**
@@ -59,15 +90,14 @@ void *lnode_find_node(lnode_root_t *root, uint64_t key)
 int lnode_insert_node(lnode_root_t *root, uint64_t key, void *data)
 {
     lnode_node_t *lnode;
-    void *data_tmp;
+    long probes;
 
     if ((root == NULL) || (data == NULL)) {
         return LNODE_RV_INPUT_ERR;
     }
 
     /* Check whether the node exists */
-    data_tmp = lnode_find_node(root, key);
-    if (data_tmp != NULL) {
+    if (lnode_lookup(root, key, &probes) != NULL) {
         return LNODE_RV_NODE_EXIST;
     }
 
@@ -77,10 +107,12 @@ int lnode_insert_node(lnode_root_t *root, uint64_t key, void *data)
         return LNODE_RV_NOMEM;
     }
 
-    /* Add to list */
+    /* Add to list, in insertion order, and to the hash bucket of the key */
     lnode->key = key;
     lnode->data = data;
     list_add_tail(&(lnode->lst), &(root->root));
+    hlist_add_head(&(lnode->hnode), LNODE_BUCKET(root, key));
+    root->count++;
 
     return LNODE_RV_OK;
 }
@@ -98,6 +130,12 @@ int lnode_init_root(lnode_root_t *root)
     }
 
     INIT_LIST_HEAD(&(root->root));
+    hash_init(root->hash);
+    root->count = 0;
+    atomic_long_set(&root->lookups, 0);
+    atomic_long_set(&root->misses, 0);
+    atomic_long_set(&root->probes, 0);
+    root->stats = NULL;
 
     return LNODE_RV_OK;
 }
@@ -123,11 +161,94 @@ void lnode_free_list(lnode_root_t *root)
             lnode->data = NULL;
             lnode->key = 0;
         }
+        hash_del(&lnode->hnode);
         list_del(&lnode->lst);
         kfree(lnode);
         lnode = NULL;
     }
+    root->count = 0;
 
     return;
 
 }
+
+static int lnode_stats_show(struct seq_file *m, void *v)
+{
+    lnode_root_t *root = m->private;
+    lnode_node_t *lnode;
+    long lookups, probes, chain, max_chain, used;
+    int bkt;
+
+    /* Chain lengths, nodes are only inserted at initialization */
+    max_chain = 0;
+    used = 0;
+    for (bkt = 0; bkt < HASH_SIZE(root->hash); bkt++) {
+        chain = 0;
+        hlist_for_each_entry(lnode, &root->hash[bkt], hnode) {
+            chain++;
+        }
+        if (chain > 0) {
+            used++;
+        }
+        if (chain > max_chain) {
+            max_chain = chain;
+        }
+    }
+
+    lookups = atomic_long_read(&root->lookups);
+    probes = atomic_long_read(&root->probes);
+    seq_printf(m, "nodes: %u\n", root->count);
+    seq_printf(m, "buckets: %lu\n", (unsigned long)HASH_SIZE(root->hash));
+    seq_printf(m, "used_buckets: %ld\n", used);
+    seq_printf(m, "max_chain: %ld\n", max_chain);
+    seq_printf(m, "lookups: %ld\n", lookups);
+    seq_printf(m, "misses: %ld\n", atomic_long_read(&root->misses));
+    seq_printf(m, "probes: %ld\n", probes);
+    seq_printf(m, "avg_probes: %ld.%02ld\n", lookups ? probes / lookups : 0,
+        lookups ? (probes % lookups) * 100 / lookups : 0);
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(lnode_stats);
+
+/**
+ * Create the debugfs statistics file of the root node
+ * @root: Root node pointer
+ * @name: File name
+ *
+ * @return : 0-- success, other failures
+ */
+int lnode_stats_create(lnode_root_t *root, const char *name)
+{
+    struct dentry *stats;
+
+    if ((root == NULL) || (name == NULL)) {
+        return LNODE_RV_INPUT_ERR;
+    }
+
+    stats = debugfs_create_file(name, 0444, NULL, root, &lnode_stats_fops);
+    if (IS_ERR_OR_NULL(stats)) {
+        return LNODE_RV_INPUT_ERR;
+    }
+    root->stats = stats;
+
+    return LNODE_RV_OK;
+}
+
+/**
+ * Remove the debugfs statistics file of the root node
+ * @root: Root node pointer
+ *
+ * @return : void
+ */
+void lnode_stats_remove(lnode_root_t *root)
+{
+    if (root == NULL) {
+        return;
+    }
+
+    debugfs_remove(root->stats);
+    root->stats = NULL;
+
+    return;
+}
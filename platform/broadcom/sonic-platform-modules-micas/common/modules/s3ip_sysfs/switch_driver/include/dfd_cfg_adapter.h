@@ -34,6 +34,9 @@
 #define DFD_KO_OTHER_I2C_GET_INDEX(addr)       ((addr >> 16) & 0xff)
 #define DFD_KO_OTHER_I2C_GET_OFFSET(addr)      (addr & 0xffff)
 #define DFD_SYSFS_PATH_MAX_LEN                 (64)
+#define DFD_KO_FILE_ACCESS_MAX                 (64)  /* Paths kept resolved by dfd_ko_read_file/dfd_ko_write_file */
+#define DFD_KO_FILE_ACCESS_HASH_BITS           (6)
+#define DFD_KO_FILE_PATH_MAX_LEN               (128)
 
 typedef struct dfd_i2c_dev_s {
     int bus;        /* bus number */
@@ -133,4 +136,11 @@ int32_t dfd_ko_write_file(char *fpath, int32_t addr, uint8_t *val, int32_t write
  * @returns: <0 Failed, others succeeded
  */
 int32_t dfd_ko_other_i2c_dev_read(int32_t addr, uint8_t *value, int32_t read_len);
+
+/**
+ * dfd_ko_file_access_exit - Release the file handles of dfd_ko_read_file/dfd_ko_write_file
+ *
+ * @returns: void
+ */
+void dfd_ko_file_access_exit(void);
 #endif /* __DFD_CFG_ADAPTER_H__ */
@@ -22,6 +22,8 @@
 #define __DFD_CFG_LISTNODE_H__
 
 #include <linux/list.h>
+#include <linux/hashtable.h>
+#include <linux/atomic.h>
 
 /* Returned value */
 #define LNODE_RV_OK             (0)
@@ -29,14 +31,23 @@
 #define LNODE_RV_NODE_EXIST     (-2)    /* Node already exists */
 #define LNODE_RV_NOMEM          (-3)    /* Node already exists */
 
+#define LNODE_HASH_BITS         (10)    /* Number of hash buckets, as a power of 2 */
+
 /* Root node public structure */
 typedef struct lnode_root_s {
-    struct list_head root;
+    struct list_head root;                      /* Nodes in insertion order */
+    DECLARE_HASHTABLE(hash, LNODE_HASH_BITS);   /* Nodes indexed by key */
+    uint32_t count;                             /* Number of nodes */
+    atomic_long_t lookups;                      /* Number of lookups */
+    atomic_long_t misses;                       /* Lookups of a missing key */
+    atomic_long_t probes;                       /* Nodes compared by the lookups */
+    struct dentry *stats;                       /* debugfs statistics file */
 } lnode_root_t;
 
 /* Node structure */
 typedef struct lnode_node_s {
     struct list_head lst;
+    struct hlist_node hnode;
 
     uint64_t key;               /* Node search index value */
     void *data;                 /* The actual data pointer */
@@ -77,4 +88,21 @@ int lnode_init_root(lnode_root_t *root);
  */
 void lnode_free_list(lnode_root_t *root);
 
+/**
+ * Create the debugfs statistics file of the root node
+ * @root: Root node pointer
+ * @name: File name
+ *
+ * @return : 0-- success, other failures
+ */
+int lnode_stats_create(lnode_root_t *root, const char *name);
+
+/**
+ * Remove the debugfs statistics file of the root node
+ * @root: Root node pointer
+ *
+ * @return : void
+ */
+void lnode_stats_remove(lnode_root_t *root);
+
 #endif /* __DFD_CFG_LISTNODE_H__ */
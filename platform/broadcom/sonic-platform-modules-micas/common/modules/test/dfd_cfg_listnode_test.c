@@ -0,0 +1,370 @@
+/*
+ * Userspace test and lookup benchmark of the s3ip dfd_cfg_listnode, and of
+ * dfd_cfg loading the configuration files shipped for a board
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <time.h>
+
+#include "../s3ip_sysfs/switch_driver/cfg/dfd_cfg_listnode.c"
+#include "../s3ip_sysfs/switch_driver/cfg/dfd_cfg_file.c"
+#include "../s3ip_sysfs/switch_driver/cfg/dfd_cfg.c"
+
+/* A 128-port board: 8 config items, for 128 index1 and 4 index2 */
+#define TEST_ITEMS          (8)
+#define TEST_INDEX1_NUM     (128)
+#define TEST_INDEX2_NUM     (4)
+#define TEST_NODES          (TEST_ITEMS * TEST_INDEX1_NUM * TEST_INDEX2_NUM)
+#define TEST_ROUNDS         (20)
+
+/*
+ * The s3ip_sysfs_cfg directory of the board, installed as /etc/s3ip_sysfs_cfg,
+ * and its card type as platform_common shows it
+ */
+#ifndef TEST_BOARD_CFG_DIR
+#define TEST_BOARD_CFG_DIR  "../../../m2-w6940-64oc/s3ip_sysfs_cfg/"
+#endif
+#define TEST_BOARD_TYPE     "16599\n"     /* 0x40d7 */
+#define TEST_ETC_CFG_DIR    "/etc/s3ip_sysfs_cfg/"
+
+int g_dfd_dbg_level = 0;
+
+/* dfd_cfg_info.c and dfd_cfg_adapter.c are not built, the member and
+ * enumeration strings dfd_cfg.c parses are theirs
+ */
+char *g_info_ctrl_mem_str[INFO_CTRL_MEM_END] = {
+    ".mode", ".int_cons", ".src", ".frmt", ".pola", ".fpath", ".addr", ".len", ".bit_offset",
+    ".str_cons", ".int_extra1", ".int_extra2", ".int_extra3",
+};
+char *g_info_ctrl_mode_str[INFO_CTRL_MODE_END] = {
+    "none", "config", "constant", "tlv", "str_constant",
+};
+char *g_info_src_str[INFO_SRC_END] = {
+    "none", "cpld", "fpga", "other_i2c", "file",
+};
+char *g_info_frmt_str[INFO_FRMT_END] = {
+    "none", "bit", "byte", "num_bytes", "num_str", "num_buf", "buf",
+};
+char *g_info_pola_str[INFO_POLA_END] = {
+    "none", "positive", "negative",
+};
+char *g_dfd_i2c_dev_mem_str[DFD_I2C_DEV_MEM_END] = {
+    ".bus", ".addr",
+};
+
+void dfd_ko_file_access_exit(void)
+{
+}
+
+/* VFS on the files of the board: filp_open() maps the installed paths */
+static int test_opens;
+
+struct file *filp_open(const char *filename, int flags, umode_t mode)
+{
+    char path[256];
+    struct file *filp;
+    struct stat st;
+    FILE *fp;
+
+    if (strcmp(filename, DFD_PUB_CARDTYPE_FILE) == 0) {
+        fp = fmemopen(TEST_BOARD_TYPE, strlen(TEST_BOARD_TYPE), "r");
+        st.st_size = strlen(TEST_BOARD_TYPE);
+    } else if (strncmp(filename, TEST_ETC_CFG_DIR, strlen(TEST_ETC_CFG_DIR)) == 0) {
+        snprintf(path, sizeof(path), "%s%s", TEST_BOARD_CFG_DIR, filename + strlen(TEST_ETC_CFG_DIR));
+        fp = fopen(path, "r");
+        if ((fp != NULL) && (fstat(fileno(fp), &st) < 0)) {
+            fclose(fp);
+            fp = NULL;
+        }
+    } else {
+        fp = NULL;
+    }
+    if (fp == NULL) {
+        return ERR_PTR(-ENOENT);
+    }
+
+    filp = calloc(1, sizeof(*filp) + sizeof(struct inode));
+    filp->f_inode = (struct inode *)(filp + 1);
+    filp->f_inode->i_mode = S_IFREG | 0444;
+    filp->f_inode->i_size = st.st_size;
+    filp->private_data = fp;
+    test_opens++;
+    return filp;
+}
+
+int filp_close(struct file *filp, void *id)
+{
+    fclose(filp->private_data);
+    free(filp);
+    test_opens--;
+    return 0;
+}
+
+ssize_t kernel_read(struct file *file, void *buf, size_t count, loff_t *pos)
+{
+    size_t len;
+
+    if (fseek(file->private_data, *pos, SEEK_SET) < 0) {
+        return -EIO;
+    }
+    len = fread(buf, 1, count, file->private_data);
+    *pos += len;
+    return len;
+}
+
+/* dfd_cfg.c does not list directories */
+int iterate_dir(struct file *file, struct dir_context *ctx)
+{
+    return -ENOTDIR;
+}
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint64_t test_key(int n)
+{
+    int item, index1, index2;
+
+    index2 = n % TEST_INDEX2_NUM;
+    index1 = (n / TEST_INDEX2_NUM) % TEST_INDEX1_NUM;
+    item = n / (TEST_INDEX2_NUM * TEST_INDEX1_NUM) + 1;
+
+    return DFD_CFG_KEY(item, index1, index2);
+}
+
+static int *test_data(int n)
+{
+    int *data = kmalloc(sizeof(int), GFP_KERNEL);
+
+    *data = n;
+    return data;
+}
+
+static void test_fill(lnode_root_t *root)
+{
+    int n;
+
+    CHECK(lnode_init_root(root) == LNODE_RV_OK);
+    for (n = 0; n < TEST_NODES; n++) {
+        CHECK(lnode_insert_node(root, test_key(n), test_data(n)) == LNODE_RV_OK);
+    }
+    CHECK(root->count == TEST_NODES);
+}
+
+/* The lookup before the hash index: a walk of the list in insertion order */
+static void *test_linear_find(lnode_root_t *root, uint64_t key)
+{
+    lnode_node_t *lnode;
+
+    list_for_each_entry(lnode, &(root->root), lst) {
+        if (lnode->key == key) {
+            return lnode->data;
+        }
+    }
+
+    return NULL;
+}
+
+static long stats_value(const char *stats, const char *name)
+{
+    const char *line = strstr(stats, name);
+
+    return (line != NULL) ? strtol(line + strlen(name), NULL, 10) : -1;
+}
+
+/* Insert, find, duplicates, misses and the debugfs counters */
+static void test_basic(void)
+{
+    lnode_root_t root;
+    lnode_node_t *lnode;
+    char stats[512];
+    int n, *data;
+
+    CHECK(lnode_find_node(NULL, 0) == NULL);
+    CHECK(lnode_insert_node(NULL, 0, &n) == LNODE_RV_INPUT_ERR);
+    CHECK(lnode_init_root(NULL) == LNODE_RV_INPUT_ERR);
+
+    test_fill(&root);
+    CHECK(lnode_insert_node(&root, test_key(0), NULL) == LNODE_RV_INPUT_ERR);
+
+    data = test_data(-1);
+    CHECK(lnode_insert_node(&root, test_key(7), data) == LNODE_RV_NODE_EXIST);
+    kfree(data);
+    CHECK(root.count == TEST_NODES);
+
+    for (n = 0; n < TEST_NODES; n++) {
+        data = lnode_find_node(&root, test_key(n));
+        CHECK((data != NULL) && (*data == n));
+    }
+    CHECK(lnode_find_node(&root, DFD_CFG_KEY(TEST_ITEMS + 1, 0, 0)) == NULL);
+    CHECK(lnode_find_node(&root, test_key(TEST_NODES)) == NULL);
+
+    /* The list keeps the insertion order */
+    n = 0;
+    list_for_each_entry(lnode, &(root.root), lst) {
+        CHECK(lnode->key == test_key(n));
+        n++;
+    }
+    CHECK(n == TEST_NODES);
+
+    CHECK(lnode_stats_create(&root, "test_cfg_stats") == LNODE_RV_OK);
+    kshim_debugfs_read(root.stats, stats, sizeof(stats));
+    CHECK(stats_value(stats, "nodes: ") == TEST_NODES);
+    CHECK(stats_value(stats, "buckets: ") == (1 << LNODE_HASH_BITS));
+    CHECK(stats_value(stats, "lookups: ") == TEST_NODES + 2);
+    CHECK(stats_value(stats, "misses: ") == 2);
+    CHECK(stats_value(stats, "probes: ") == atomic_long_read(&root.probes));
+    CHECK(stats_value(stats, "used_buckets: ") > (1 << LNODE_HASH_BITS) * 9 / 10);
+    lnode_stats_remove(&root);
+    CHECK(root.stats == NULL);
+
+    lnode_free_list(&root);
+    CHECK(root.count == 0);
+    CHECK(list_empty(&root.root));
+    CHECK(lnode_find_node(&root, test_key(0)) == NULL);
+}
+
+static double test_elapsed_ns(const struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/* Loads the board configuration as the driver init does */
+static void test_board_cfg(void)
+{
+    dfd_i2c_dev_t *i2c_dev;
+    info_ctrl_t *info_ctrl;
+    int *value, type, sub_type;
+    char *str;
+    int log_count;
+
+    /* Any parse error of a shipped file is logged */
+    g_dfd_dbg_level = DBG_ERROR;
+    log_count = kshim_log_count;
+    CHECK(dfd_dev_cfg_init() == 0);
+    CHECK(kshim_log_count == log_count);
+    if (kshim_log_count != log_count) {
+        fprintf(stderr, "%s", kshim_log);
+    }
+    g_dfd_dbg_level = 0;
+    CHECK(test_opens == 0);
+    CHECK(dfd_ko_cfg_list_root.count > 1000);
+    CHECK(dfd_ko_cfg_list_root.stats != NULL);
+
+    /* Items of each kind, from the first and the last file of the board */
+    i2c_dev = dfd_ko_cfg_get_item(DFD_CFG_KEY(DFD_CFG_ITEM_CPLD_I2C_DEV, 0, 3));
+    CHECK((i2c_dev != NULL) && (i2c_dev->bus == 99) && (i2c_dev->addr == 0x2d));
+    str = dfd_ko_cfg_get_item(DFD_CFG_KEY(DFD_CFG_ITEM_WATCHDOG_NAME, 0, 2));
+    CHECK((str != NULL) && (strcmp(str, "timeleft") == 0));
+    value = dfd_ko_cfg_get_item(DFD_CFG_KEY(DFD_CFG_ITEM_DEV_NUM, 1, 0));
+    CHECK((value != NULL) && (*value == 4));
+    info_ctrl = dfd_ko_cfg_get_item(DFD_CFG_KEY(DFD_CFG_ITEM_DEV_PRESENT_STATUS, 1, 2));
+    CHECK((info_ctrl != NULL) && (info_ctrl->mode == INFO_CTRL_MODE_CFG) && (info_ctrl->src == INFO_SRC_CPLD)
+        && (info_ctrl->frmt == INFO_FRMT_BIT) && (info_ctrl->pola == INFO_POLA_NEGA)
+        && (info_ctrl->addr == 0x0006005b) && (info_ctrl->len == 1) && (info_ctrl->bit_offset == 1));
+    info_ctrl = dfd_ko_cfg_get_item(DFD_CFG_KEY(DFD_CFG_ITEM_WATCHDOG_DEV, 0, 5));
+    CHECK((info_ctrl != NULL) && (info_ctrl->addr == 0x000100b0));
+    CHECK(dfd_ko_cfg_get_item(DFD_CFG_KEY(DFD_CFG_ITEM_DEV_NUM, 1, 200)) == NULL);
+
+    /* The reverse lookup lists */
+    CHECK((dfd_ko_cfg_get_fan_type_by_name("FAN80-02-F", &type, &sub_type) == 0) && (type == 0)
+        && (sub_type == 1));
+    CHECK((dfd_ko_cfg_get_power_type_by_name("CRPS3000CL", &type) == 0) && (type == 1));
+    CHECK(dfd_ko_cfg_get_power_type_by_name("NO-SUCH-PSU", &type) < 0);
+
+    dfd_dev_cfg_exit();
+    CHECK(dfd_ko_cfg_list_root.count == 0);
+    CHECK(dfd_ko_cfg_list_root.stats == NULL);
+    CHECK(list_empty(&dfd_lib_cfg_power_name_conv_lst));
+}
+
+/* Every key of the board looked up TEST_ROUNDS times, hashed and with a list walk */
+static void test_benchmark(void)
+{
+    lnode_root_t *root = &dfd_ko_cfg_list_root;
+    lnode_node_t *lnode;
+    struct timespec start;
+    double hash_ns, linear_ns;
+    long lookups, hits;
+    uint64_t *keys;
+    int n, nodes, round;
+    char stats[512];
+
+    CHECK(dfd_dev_cfg_init() == 0);
+    nodes = root->count;
+    keys = kmalloc(nodes * sizeof(*keys), GFP_KERNEL);
+    n = 0;
+    list_for_each_entry(lnode, &(root->root), lst) {
+        keys[n++] = lnode->key;
+    }
+    CHECK(n == nodes);
+    lookups = (long)nodes * TEST_ROUNDS;
+
+    hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (round = 0; round < TEST_ROUNDS; round++) {
+        for (n = 0; n < nodes; n++) {
+            hits += (dfd_ko_cfg_get_item(keys[n]) != NULL);
+        }
+    }
+    hash_ns = test_elapsed_ns(&start) / lookups;
+    CHECK(hits == lookups);
+
+    hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (round = 0; round < TEST_ROUNDS; round++) {
+        for (n = 0; n < nodes; n++) {
+            hits += (test_linear_find(root, keys[n]) != NULL);
+        }
+    }
+    linear_ns = test_elapsed_ns(&start) / lookups;
+    CHECK(hits == lookups);
+
+    kshim_debugfs_read(root->stats, stats, sizeof(stats));
+    /* The keys of a real board spread over the buckets too */
+    CHECK(stats_value(stats, "max_chain: ") <= 4 * nodes / (1 << LNODE_HASH_BITS) + 4);
+
+    printf("%s: %d nodes, %ld lookups: hashed %.1f ns/lookup, list walk %.1f ns/lookup (x%.0f)\n",
+        TEST_BOARD_CFG_DIR, nodes, lookups, hash_ns, linear_ns, linear_ns / hash_ns);
+    printf("%s", stats);
+
+    kfree(keys);
+    dfd_dev_cfg_exit();
+}
+
+int main(void)
+{
+    test_basic();
+    test_board_cfg();
+    test_benchmark();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("dfd_cfg_listnode: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,389 @@
+/*
+ * Userspace stand-ins for the kernel API used by the tested drivers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Every <linux/...> header of the shim includes this file. The tests are
+ * single threaded: atomics are plain integers and the allocator is libc.
+ * The VFS calls are provided by the test, printk() keeps the last message.
+ */
+
+#ifndef __WB_KSHIM_H__
+#define __WB_KSHIM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef unsigned short umode_t;
+
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define min_t(type, x, y)       ((type)(x) < (type)(y) ? (type)(x) : (type)(y))
+#define PAGE_SIZE               4096
+
+/* printk, the last message is kept for the test */
+#define KERN_ERR                "<3>"
+#define KERN_INFO               "<6>"
+
+static char kshim_log[512];
+static int kshim_log_count;
+
+static inline int printk(const char *fmt, ...)
+{
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(kshim_log, sizeof(kshim_log), fmt, args);
+    va_end(args);
+    kshim_log_count++;
+    return len;
+}
+
+#define printk_ratelimited(fmt, args...)    printk(fmt, ## args)
+
+static inline int scnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    if (len >= (int)size)
+        len = size - 1;
+    return (len < 0) ? 0 : len;
+}
+
+/* Strings */
+#define simple_strtol(cp, endp, base)   strtol(cp, endp, base)
+#define simple_strtoul(cp, endp, base)  strtoul(cp, endp, base)
+
+static inline size_t strlcpy(char *dest, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+
+    if (size) {
+        size_t copy = (len >= size) ? size - 1 : len;
+
+        memcpy(dest, src, copy);
+        dest[copy] = '\0';
+    }
+    return len;
+}
+
+/* Memory */
+#define GFP_KERNEL              0
+#define kmalloc(size, flags)    malloc(size)
+#define kzalloc(size, flags)    calloc(1, size)
+#define kfree(p)                free((void *)(p))
+
+/* Errors in pointers */
+#define MAX_ERRNO               4095
+#define IS_ERR_VALUE(x)         ((unsigned long)(void *)(x) >= (unsigned long)-MAX_ERRNO)
+
+static inline void *ERR_PTR(long error)
+{
+    return (void *)error;
+}
+
+static inline long PTR_ERR(const void *ptr)
+{
+    return (long)ptr;
+}
+
+static inline int IS_ERR(const void *ptr)
+{
+    return IS_ERR_VALUE(ptr);
+}
+
+static inline int IS_ERR_OR_NULL(const void *ptr)
+{
+    return (ptr == NULL) || IS_ERR_VALUE(ptr);
+}
+
+/* Atomics */
+typedef struct {
+    long counter;
+} atomic_long_t;
+
+#define atomic_long_set(v, i)   ((v)->counter = (i))
+#define atomic_long_read(v)     ((v)->counter)
+#define atomic_long_inc(v)      ((v)->counter++)
+#define atomic_long_add(i, v)   ((v)->counter += (i))
+
+/* Doubly linked lists */
+struct list_head {
+    struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name)    { &(name), &(name) }
+#define LIST_HEAD(name)         struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+    list->next = list;
+    list->prev = list;
+}
+
+static inline void list_add_tail(struct list_head *entry, struct list_head *head)
+{
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+}
+
+static inline void list_del(struct list_head *entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->next = entry->prev = NULL;
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+    return head->next == head;
+}
+
+#define list_entry(ptr, type, member)   container_of(ptr, type, member)
+
+#define list_for_each_entry(pos, head, member) \
+    for (pos = list_entry((head)->next, __typeof__(*pos), member); \
+         &pos->member != (head); \
+         pos = list_entry(pos->member.next, __typeof__(*pos), member))
+
+#define list_for_each_entry_safe(pos, n, head, member) \
+    for (pos = list_entry((head)->next, __typeof__(*pos), member), \
+         n = list_entry(pos->member.next, __typeof__(*pos), member); \
+         &pos->member != (head); \
+         pos = n, n = list_entry(n->member.next, __typeof__(*n), member))
+
+/* Hash lists */
+struct hlist_node {
+    struct hlist_node *next, **pprev;
+};
+
+struct hlist_head {
+    struct hlist_node *first;
+};
+
+static inline void hlist_add_head(struct hlist_node *n, struct hlist_head *h)
+{
+    n->next = h->first;
+    if (h->first)
+        h->first->pprev = &n->next;
+    h->first = n;
+    n->pprev = &h->first;
+}
+
+static inline int hlist_unhashed(const struct hlist_node *n)
+{
+    return n->pprev == NULL;
+}
+
+static inline void hlist_del_init(struct hlist_node *n)
+{
+    if (hlist_unhashed(n))
+        return;
+    *n->pprev = n->next;
+    if (n->next)
+        n->next->pprev = n->pprev;
+    n->next = NULL;
+    n->pprev = NULL;
+}
+
+#define hlist_entry_safe(ptr, type, member) \
+    ({ __typeof__(ptr) ____ptr = (ptr); ____ptr ? container_of(____ptr, type, member) : NULL; })
+
+#define hlist_for_each_entry(pos, head, member) \
+    for (pos = hlist_entry_safe((head)->first, __typeof__(*(pos)), member); \
+         pos; \
+         pos = hlist_entry_safe((pos)->member.next, __typeof__(*(pos)), member))
+
+/* Hash functions, as <linux/hash.h> on 64-bit kernels */
+#define GOLDEN_RATIO_32         0x61C88647
+#define GOLDEN_RATIO_64         0x61C8864680B583EBull
+
+static inline u32 hash_32(u32 val, unsigned int bits)
+{
+    return (val * GOLDEN_RATIO_32) >> (32 - bits);
+}
+
+static inline u32 hash_64(u64 val, unsigned int bits)
+{
+    return (u32)((val * GOLDEN_RATIO_64) >> (64 - bits));
+}
+
+/* Fixed size hash tables */
+#define DECLARE_HASHTABLE(name, bits)   struct hlist_head name[1 << (bits)]
+#define HASH_SIZE(name)                 (sizeof(name) / sizeof((name)[0]))
+
+#define hash_init(table)        memset((table), 0, sizeof(table))
+#define hash_del(node)          hlist_del_init(node)
+
+/* seq_file, the output goes to a buffer of the test */
+struct seq_file {
+    char *buf;
+    size_t size;
+    size_t count;
+    void *private;
+};
+
+static inline void seq_printf(struct seq_file *m, const char *fmt, ...)
+{
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(m->buf + m->count, m->size - m->count, fmt, args);
+    va_end(args);
+    if (len > 0)
+        m->count += ((size_t)len < m->size - m->count) ? (size_t)len : m->size - m->count - 1;
+}
+
+/* Only the show() callback of single_open() files is kept */
+struct file_operations {
+    int (*show)(struct seq_file *m, void *v);
+};
+
+#define DEFINE_SHOW_ATTRIBUTE(__name) \
+    static const struct file_operations __name ## _fops = { .show = __name ## _show }
+
+/* VFS */
+struct inode {
+    umode_t i_mode;
+    loff_t i_size;
+};
+
+/* debugfs files are created in memory, path lookups return the inode */
+struct dentry {
+    char name[64];
+    void *data;
+    const struct file_operations *fops;
+    struct inode *d_inode;
+};
+
+struct path {
+    struct dentry *dentry;
+};
+
+struct file {
+    struct inode *f_inode;
+    void *private_data;
+};
+
+#define MAX_RW_COUNT            (INT32_MAX & ~4095)
+#define LOOKUP_FOLLOW           0x0001
+
+static inline struct inode *d_inode(const struct dentry *dentry)
+{
+    return dentry->d_inode;
+}
+
+static inline struct inode *file_inode(const struct file *f)
+{
+    return f->f_inode;
+}
+
+struct kvec {
+    void *iov_base;
+    size_t iov_len;
+};
+
+#define ITER_SOURCE             1
+#define ITER_DEST               0
+
+struct iov_iter {
+    unsigned int data_source;
+    const struct kvec *kvec;
+    size_t count;
+};
+
+static inline void iov_iter_kvec(struct iov_iter *i, unsigned int direction, const struct kvec *kvec,
+                                 unsigned long nr_segs, size_t count)
+{
+    i->data_source = direction;
+    i->kvec = kvec;
+    i->count = count;
+}
+
+struct file *filp_open(const char *filename, int flags, umode_t mode);
+int filp_close(struct file *filp, void *id);
+int kern_path(const char *name, unsigned int flags, struct path *path);
+void path_put(const struct path *path);
+ssize_t vfs_iter_read(struct file *file, struct iov_iter *iter, loff_t *ppos, int flags);
+ssize_t vfs_iter_write(struct file *file, struct iov_iter *iter, loff_t *ppos, int flags);
+int vfs_fsync(struct file *file, int datasync);
+ssize_t kernel_read(struct file *file, void *buf, size_t count, loff_t *pos);
+
+/* Directory listing */
+struct dir_context;
+typedef bool (*filldir_t)(struct dir_context *ctx, const char *name, int len, loff_t pos, u64 ino,
+                          unsigned int d_type);
+
+struct dir_context {
+    filldir_t actor;
+    loff_t pos;
+};
+
+int iterate_dir(struct file *file, struct dir_context *ctx);
+
+static inline struct dentry *debugfs_create_file(const char *name, unsigned short mode, struct dentry *parent,
+                                                 void *data, const struct file_operations *fops)
+{
+    struct dentry *dentry = calloc(1, sizeof(*dentry));
+
+    if (dentry == NULL)
+        return ERR_PTR(-ENOMEM);
+    snprintf(dentry->name, sizeof(dentry->name), "%s", name);
+    dentry->data = data;
+    dentry->fops = fops;
+    return dentry;
+}
+
+static inline void debugfs_remove(struct dentry *dentry)
+{
+    if (!IS_ERR_OR_NULL(dentry))
+        free(dentry);
+}
+
+/* Reads a debugfs file into buf, returns the length */
+static inline size_t kshim_debugfs_read(struct dentry *dentry, char *buf, size_t size)
+{
+    struct seq_file m = { .buf = buf, .size = size, .count = 0, .private = dentry->data };
+
+    buf[0] = '\0';
+    dentry->fops->show(&m, NULL);
+    return m.count;
+}
+
+#endif /* __WB_KSHIM_H__ */
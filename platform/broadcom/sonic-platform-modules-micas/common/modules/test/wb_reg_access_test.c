@@ -0,0 +1,482 @@
+/*
+ * Userspace test of the wb_reg_access handles, on a mock VFS
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "../wb_reg_access.h"
+
+#define TEST_CHR_PATH       "/dev/fpga0"
+#define TEST_SYSFS_PATH     "/sys/bus/i2c/devices/2-0030/cpld_reg"
+#define TEST_MISSING_PATH   "/dev/cpld9"
+#define TEST_REG_SIZE       (256)
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Mock VFS: a device node and a sysfs file, each a register map */
+typedef struct test_node_s {
+    const char *path;
+    struct inode inode;
+    struct dentry dentry;
+    uint8_t regs[TEST_REG_SIZE];
+    int opens;              /* filp_open() calls */
+    int open_files;         /* files not closed yet */
+    int rdwr_opens;         /* filp_open() with O_RDWR */
+    int fsyncs;
+    int fail;               /* error returned by the next accesses, 0 none */
+} test_node_t;
+
+static test_node_t test_nodes[] = {
+    { .path = TEST_CHR_PATH, .inode = { .i_mode = S_IFCHR | 0600 } },
+    { .path = TEST_SYSFS_PATH, .inode = { .i_mode = S_IFREG | 0644 } },
+};
+
+#define TEST_NODE_NUM   (sizeof(test_nodes) / sizeof(test_nodes[0]))
+
+static test_node_t *test_node_find(const char *path)
+{
+    unsigned int i;
+
+    for (i = 0; i < TEST_NODE_NUM; i++) {
+        if (strcmp(test_nodes[i].path, path) == 0) {
+            return &test_nodes[i];
+        }
+    }
+
+    return NULL;
+}
+
+int kern_path(const char *name, unsigned int flags, struct path *path)
+{
+    test_node_t *node = test_node_find(name);
+
+    if (node == NULL) {
+        return -ENOENT;
+    }
+    node->dentry.d_inode = &node->inode;
+    path->dentry = &node->dentry;
+    return 0;
+}
+
+void path_put(const struct path *path)
+{
+}
+
+struct file *filp_open(const char *filename, int flags, umode_t mode)
+{
+    test_node_t *node = test_node_find(filename);
+    struct file *filp;
+
+    if (node == NULL) {
+        return ERR_PTR(-ENOENT);
+    }
+    node->opens++;
+    if ((flags & O_ACCMODE) == O_RDWR) {
+        node->rdwr_opens++;
+    }
+    filp = calloc(1, sizeof(*filp));
+    filp->f_inode = &node->inode;
+    filp->private_data = node;
+    node->open_files++;
+    return filp;
+}
+
+int filp_close(struct file *filp, void *id)
+{
+    test_node_t *node = filp->private_data;
+
+    node->open_files--;
+    free(filp);
+    return 0;
+}
+
+static ssize_t test_vfs_rw(struct file *file, struct iov_iter *iter, loff_t *ppos, int write)
+{
+    test_node_t *node = file->private_data;
+    size_t count = iter->count;
+
+    CHECK(iter->data_source == (write ? ITER_SOURCE : ITER_DEST));
+    if (node->fail) {
+        return node->fail;
+    }
+    if (*ppos >= TEST_REG_SIZE) {
+        return 0;
+    }
+    count = min_t(size_t, count, TEST_REG_SIZE - *ppos);
+    if (write) {
+        memcpy(&node->regs[*ppos], iter->kvec->iov_base, count);
+    } else {
+        memcpy(iter->kvec->iov_base, &node->regs[*ppos], count);
+    }
+    *ppos += count;
+    return count;
+}
+
+ssize_t vfs_iter_read(struct file *file, struct iov_iter *iter, loff_t *ppos, int flags)
+{
+    return test_vfs_rw(file, iter, ppos, 0);
+}
+
+ssize_t vfs_iter_write(struct file *file, struct iov_iter *iter, loff_t *ppos, int flags)
+{
+    return test_vfs_rw(file, iter, ppos, 1);
+}
+
+int vfs_fsync(struct file *file, int datasync)
+{
+    ((test_node_t *)file->private_data)->fsyncs++;
+    return 0;
+}
+
+/* Mock symbol mode backend, one device probed at TEST_DEV_PATH */
+#define TEST_DEV_PATH       "/dev/fpga1"
+
+static uint8_t test_dev_regs[TEST_REG_SIZE];
+static int test_dev_fail;
+static const char *test_dev_path;
+static int test_dev_probed;         /* the device is in its slot */
+static int test_dev_by_path;        /* accesses by path */
+static int test_dev_by_dev;         /* accesses by resolved device */
+static int test_dev_lookups;
+
+static int test_dev_rw(uint32_t offset, uint8_t *buf, size_t count, int write)
+{
+    if (test_dev_fail) {
+        return test_dev_fail;
+    }
+    if (write) {
+        memcpy(&test_dev_regs[offset], buf, count);
+    } else {
+        memcpy(buf, &test_dev_regs[offset], count);
+    }
+    return count;
+}
+
+static int test_dev_read(const char *path, uint32_t offset, uint8_t *buf, size_t count)
+{
+    test_dev_path = path;
+    test_dev_by_path++;
+    return test_dev_rw(offset, buf, count, 0);
+}
+
+static int test_dev_write(const char *path, uint32_t offset, uint8_t *buf, size_t count)
+{
+    test_dev_path = path;
+    test_dev_by_path++;
+    return test_dev_rw(offset, buf, count, 1);
+}
+
+static int test_dev_lookup(const char *path, wb_reg_access_dev_t *dev)
+{
+    test_dev_lookups++;
+    if (!test_dev_probed || (strcmp(path, TEST_DEV_PATH) != 0)) {
+        return -ENODEV;
+    }
+    dev->dev = test_dev_regs;
+    dev->minor = 3;
+    return 0;
+}
+
+static int test_dev_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    if (!test_dev_probed || (dev->dev != test_dev_regs) || (dev->minor != 3)) {
+        return -ESTALE;
+    }
+    test_dev_by_dev++;
+    return test_dev_rw(offset, buf, count, 0);
+}
+
+static int test_dev_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    if (!test_dev_probed || (dev->dev != test_dev_regs) || (dev->minor != 3)) {
+        return -ESTALE;
+    }
+    test_dev_by_dev++;
+    return test_dev_rw(offset, buf, count, 1);
+}
+
+static const wb_reg_access_ops_t test_dev_ops = {
+    .read = test_dev_read,
+    .write = test_dev_write,
+    .lookup = test_dev_lookup,
+    .read_dev = test_dev_read_dev,
+    .write_dev = test_dev_write_dev,
+};
+
+/* A backend without lookup, accessed by path only */
+static const wb_reg_access_ops_t test_dev_path_ops = {
+    .read = test_dev_read,
+    .write = test_dev_write,
+};
+
+static void test_reset(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < TEST_NODE_NUM; i++) {
+        memset(test_nodes[i].regs, 0, TEST_REG_SIZE);
+        test_nodes[i].opens = test_nodes[i].open_files = test_nodes[i].rdwr_opens = 0;
+        test_nodes[i].fsyncs = test_nodes[i].fail = 0;
+    }
+    memset(test_dev_regs, 0, sizeof(test_dev_regs));
+    test_dev_fail = 0;
+    test_dev_path = NULL;
+    test_dev_probed = 1;
+    test_dev_by_path = test_dev_by_dev = test_dev_lookups = 0;
+    kshim_log[0] = '\0';
+    kshim_log_count = 0;
+}
+
+/* Symbol modes without lookup call the backend with the path, errors are logged */
+static void test_symbol_mode(void)
+{
+    wb_reg_access_t ra;
+    uint8_t val[4] = { 0x11, 0x22, 0x33, 0x44 };
+    wb_reg_access_ops_t no_write = { .read = test_dev_read };
+
+    test_reset();
+    CHECK(wb_reg_access_init(NULL, "/dev/x", WB_REG_ACCESS_PCIE_DEV, &test_dev_ops, 1) == -EINVAL);
+    CHECK(wb_reg_access_init(&ra, "/dev/x", WB_REG_ACCESS_PCIE_DEV, NULL, 1) == -EINVAL);
+    CHECK(wb_reg_access_init(&ra, "/dev/x", WB_REG_ACCESS_PCIE_DEV, &no_write, 1) == -EINVAL);
+    CHECK(wb_reg_access_init(&ra, TEST_DEV_PATH, WB_REG_ACCESS_PCIE_DEV, &test_dev_path_ops, 1) == 0);
+    CHECK(strcmp(wb_reg_access_backend(&ra), "pcie_dev") == 0);
+
+    CHECK(wb_reg_access_write(&ra, 0x10, val, sizeof(val)) == sizeof(val));
+    CHECK(strcmp(test_dev_path, TEST_DEV_PATH) == 0);
+    memset(val, 0, sizeof(val));
+    CHECK(wb_reg_access_read(&ra, 0x11, val, 2) == 2);
+    CHECK((val[0] == 0x22) && (val[1] == 0x33));
+    CHECK(test_dev_by_path == 2);
+    CHECK(kshim_log_count == 0);
+
+    test_dev_fail = -EIO;
+    CHECK(wb_reg_access_read(&ra, 0x20, val, 1) == -EIO);
+    CHECK(kshim_log_count == 1);
+    CHECK(strstr(kshim_log, "pcie_dev read failed, path=" TEST_DEV_PATH ", addr=0x20, size=1, ret=-5") != NULL);
+    CHECK(wb_reg_access_write(&ra, 0x21, val, 1) == -EIO);
+    CHECK(strstr(kshim_log, "pcie_dev write failed, path=" TEST_DEV_PATH ", addr=0x21") != NULL);
+
+    CHECK(atomic_long_read(&ra.reads) == 2);
+    CHECK(atomic_long_read(&ra.writes) == 2);
+    CHECK(atomic_long_read(&ra.errors) == 2);
+    CHECK(atomic_long_read(&ra.opens) == 0);
+    wb_reg_access_exit(&ra);
+}
+
+/* The device is looked up once, at init, then accessed without a path lookup */
+static void test_symbol_resolved(void)
+{
+    wb_reg_access_t ra;
+    uint8_t val[2] = { 0x5a, 0xa5 };
+    int i;
+
+    test_reset();
+    CHECK(wb_reg_access_init(&ra, TEST_DEV_PATH, WB_REG_ACCESS_IO_DEV, &test_dev_ops, 1) == 0);
+    CHECK(test_dev_lookups == 1);
+    CHECK((ra.dev.dev == test_dev_regs) && (ra.dev.minor == 3));
+    CHECK(strcmp(wb_reg_access_backend(&ra), "io_dev(resolved)") == 0);
+
+    for (i = 0; i < 100; i++) {
+        CHECK(wb_reg_access_write(&ra, 0x8, val, sizeof(val)) == sizeof(val));
+        CHECK(wb_reg_access_read(&ra, 0x9, val, 1) == 1);
+    }
+    CHECK(val[0] == 0xa5);
+    CHECK(test_dev_lookups == 1);
+    CHECK((test_dev_by_dev == 200) && (test_dev_by_path == 0));
+
+    /* A backend error is not retried by path */
+    test_dev_fail = -ETIMEDOUT;
+    CHECK(wb_reg_access_write(&ra, 0x8, val, 1) == -ETIMEDOUT);
+    CHECK(test_dev_by_path == 0);
+    CHECK(strstr(kshim_log, "io_dev(resolved) write failed, path=" TEST_DEV_PATH ", addr=0x8") != NULL);
+    test_dev_fail = 0;
+
+    /* The device left its slot, accessed by path, once each */
+    test_dev_probed = 0;
+    CHECK(wb_reg_access_read(&ra, 0x9, val, 1) == 1);
+    CHECK(wb_reg_access_write(&ra, 0x9, val, 1) == 1);
+    CHECK((test_dev_by_dev == 201) && (test_dev_by_path == 2));
+    CHECK(strcmp(test_dev_path, TEST_DEV_PATH) == 0);
+    CHECK(atomic_long_read(&ra.errors) == 1);
+    wb_reg_access_exit(&ra);
+}
+
+/* A device not probed at init is accessed by path */
+static void test_symbol_unresolved(void)
+{
+    wb_reg_access_t ra;
+    uint8_t val = 0;
+
+    test_reset();
+    test_dev_probed = 0;
+    CHECK(wb_reg_access_init(&ra, TEST_DEV_PATH, WB_REG_ACCESS_SPI_DEV, &test_dev_ops, 0) == 0);
+    CHECK(test_dev_lookups == 1);
+    CHECK((ra.dev.dev == NULL) && (ra.dev.minor == -1));
+    CHECK(strcmp(wb_reg_access_backend(&ra), "spi_dev") == 0);
+    CHECK(kshim_log_count == 0);
+
+    CHECK(wb_reg_access_read(&ra, 0x1, &val, 1) == 1);
+    CHECK((test_dev_by_dev == 0) && (test_dev_by_path == 1));
+    wb_reg_access_exit(&ra);
+}
+
+/* A device node used for writes is opened read-write once, at init, and closed at exit */
+static void test_file_persistent(void)
+{
+    test_node_t *node = test_node_find(TEST_CHR_PATH);
+    wb_reg_access_t ra;
+    uint8_t val[2] = { 0xa5, 0x5a }, rd = 0;
+    int i;
+
+    test_reset();
+    CHECK(wb_reg_access_init(&ra, TEST_CHR_PATH, WB_REG_ACCESS_FILE, NULL, 1) == 0);
+    CHECK(ra.filp != NULL);
+    CHECK(strcmp(wb_reg_access_backend(&ra), "file(persistent)") == 0);
+    CHECK((node->opens == 1) && (node->rdwr_opens == 1));
+
+    for (i = 0; i < 100; i++) {
+        CHECK(wb_reg_access_write(&ra, 0x40, val, sizeof(val)) == sizeof(val));
+        CHECK(wb_reg_access_read(&ra, 0x41, &rd, 1) == 1);
+    }
+    CHECK(node->regs[0x40] == 0xa5);
+    CHECK(rd == 0x5a);
+    CHECK(node->opens == 1);
+    CHECK(node->fsyncs == 100);
+    CHECK(atomic_long_read(&ra.opens) == 0);
+
+    /* A failure is logged with the path */
+    node->fail = -ENXIO;
+    CHECK(wb_reg_access_read(&ra, 0x42, val, 1) == -ENXIO);
+    CHECK(strstr(kshim_log, "vfs_iter_read failed, path=" TEST_CHR_PATH ", addr=0x42, size=1, ret=-6") != NULL);
+    CHECK(wb_reg_access_write(&ra, 0x43, val, 1) == -ENXIO);
+    CHECK(strstr(kshim_log, "vfs_iter_write failed, path=" TEST_CHR_PATH ", addr=0x43") != NULL);
+    CHECK(node->fsyncs == 100);
+    CHECK(atomic_long_read(&ra.errors) == 2);
+
+    wb_reg_access_exit(&ra);
+    CHECK(ra.filp == NULL);
+    CHECK(node->open_files == 0);
+}
+
+/* A read-only device node is opened read-only, a write opens it read-write for the access */
+static void test_file_read_only(void)
+{
+    test_node_t *node = test_node_find(TEST_CHR_PATH);
+    wb_reg_access_t ra;
+    uint8_t val = 0x3c;
+    int i;
+
+    test_reset();
+    CHECK(wb_reg_access_init(&ra, TEST_CHR_PATH, WB_REG_ACCESS_FILE, NULL, 0) == 0);
+    CHECK((ra.filp != NULL) && (ra.writable == 0));
+    CHECK(strcmp(wb_reg_access_backend(&ra), "file(persistent, read-only)") == 0);
+    CHECK((node->opens == 1) && (node->rdwr_opens == 0));
+
+    for (i = 0; i < 100; i++) {
+        CHECK(wb_reg_access_read(&ra, 0x10, &val, 1) == 1);
+    }
+    CHECK((node->opens == 1) && (node->rdwr_opens == 0));
+    CHECK(atomic_long_read(&ra.opens) == 0);
+
+    val = 0x3c;
+    CHECK(wb_reg_access_write(&ra, 0x10, &val, 1) == 1);
+    CHECK(node->regs[0x10] == 0x3c);
+    CHECK((node->opens == 2) && (node->rdwr_opens == 1));
+    CHECK(node->open_files == 1);
+    CHECK(atomic_long_read(&ra.opens) == 1);
+
+    wb_reg_access_exit(&ra);
+    CHECK(node->open_files == 0);
+}
+
+/* Sysfs files are not opened at init, then opened on each access */
+static void test_file_per_access(void)
+{
+    test_node_t *node = test_node_find(TEST_SYSFS_PATH);
+    wb_reg_access_t ra;
+    uint8_t val = 0x7e;
+    char stats[PAGE_SIZE];
+
+    test_reset();
+    CHECK(wb_reg_access_init(&ra, TEST_SYSFS_PATH, WB_REG_ACCESS_FILE, NULL, 1) == 0);
+    CHECK(ra.filp == NULL);
+    CHECK(strcmp(wb_reg_access_backend(&ra), "file") == 0);
+    CHECK(node->opens == 0);
+
+    CHECK(wb_reg_access_write(&ra, 0x3, &val, 1) == 1);
+    CHECK((node->opens == 1) && (node->rdwr_opens == 1));
+    val = 0;
+    CHECK(wb_reg_access_read(&ra, 0x3, &val, 1) == 1);
+    CHECK(val == 0x7e);
+    /* Reads open the file read-only */
+    CHECK((node->opens == 2) && (node->rdwr_opens == 1));
+    CHECK(node->open_files == 0);
+    CHECK(atomic_long_read(&ra.opens) == 2);
+
+    node->fail = -EIO;
+    CHECK(wb_reg_access_read(&ra, 0x4, &val, 1) == -EIO);
+    CHECK(strstr(kshim_log, "vfs_iter_read failed, path=" TEST_SYSFS_PATH) != NULL);
+    CHECK(node->open_files == 0);
+
+    wb_reg_access_stats_show(&ra, stats);
+    CHECK(strcmp(stats, "path: " TEST_SYSFS_PATH "\nbackend: file\nreads: 2\nwrites: 1\nerrors: 1\nopens: 3\n") == 0);
+    wb_reg_access_exit(&ra);
+}
+
+/* A path missing at init is opened on each access, open failures are logged */
+static void test_file_missing(void)
+{
+    wb_reg_access_t ra;
+    uint8_t val = 0;
+
+    test_reset();
+    CHECK(wb_reg_access_init(&ra, TEST_MISSING_PATH, WB_REG_ACCESS_FILE, NULL, 1) == 0);
+    CHECK(ra.filp == NULL);
+    CHECK(kshim_log_count == 0);
+
+    CHECK(wb_reg_access_read(&ra, 0, &val, 1) == -ENOENT);
+    CHECK(strstr(kshim_log, "read open " TEST_MISSING_PATH " failed, errno = 2") != NULL);
+    CHECK(wb_reg_access_write(&ra, 0, &val, 1) == -ENOENT);
+    CHECK(strstr(kshim_log, "write open " TEST_MISSING_PATH " failed, errno = 2") != NULL);
+    CHECK(atomic_long_read(&ra.errors) == 2);
+    CHECK(atomic_long_read(&ra.opens) == 0);
+    wb_reg_access_exit(&ra);
+}
+
+int main(void)
+{
+    test_symbol_mode();
+    test_symbol_resolved();
+    test_symbol_unresolved();
+    test_file_persistent();
+    test_file_read_only();
+    test_file_per_access();
+    test_file_missing();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("wb_reg_access: all tests passed\n");
+    return 0;
+}
@@ -52,6 +52,21 @@ extern int spi_device_func_read(const char *path, uint32_t offset, uint8_t *buf,
 extern int spi_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_t count);
 extern int indirect_device_func_write(const char *path, uint32_t pos, uint8_t *val, size_t size);
 extern int indirect_device_func_read(const char *path, uint32_t pos, uint8_t *val, size_t size);
+extern int i2c_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int i2c_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int i2c_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int pcie_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int pcie_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int pcie_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int io_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int io_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int io_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int spi_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int spi_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int spi_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int indirect_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int indirect_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int indirect_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
 
 #define FPGA_I2C_STRETCH_TIMEOUT  (0x01)
 #define FPGA_I2C_DEADLOCK_FAILED  (0x02)
@@ -91,145 +106,96 @@ module_param(g_wb_fpga_i2c_error, int, S_IRUGO | S_IWUSR);
     } \
 } while (0)
 
-static int fpga_file_read(const char *path, uint32_t pos, uint8_t *val, size_t size)
+static int fpga_device_write(fpga_i2c_dev_t *fpga_i2c, uint32_t pos, uint8_t *val, size_t size)
 {
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        FPGA_I2C_ERROR("read open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
-
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_DEST, &iov, 1, iov.iov_len);
-    ret = vfs_iter_read(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        FPGA_I2C_ERROR("vfs_iter_read failed, path=%s, addr=0x%x, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-
-    filp_close(filp, NULL);
-
-    return ret;
-
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
-
-    return -1;
+    return wb_reg_access_write(&fpga_i2c->reg_access, pos, val, size);
 }
 
-static int fpga_file_write(const char *path, uint32_t pos, uint8_t *val, size_t size)
+static int fpga_device_read(fpga_i2c_dev_t *fpga_i2c, uint32_t pos, uint8_t *val, size_t size)
 {
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDWR, 777);
-    if (IS_ERR(filp)) {
-        FPGA_I2C_ERROR("write open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
+    return wb_reg_access_read(&fpga_i2c->reg_access, pos, val, size);
+}
 
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_SOURCE, &iov, 1, iov.iov_len);
-    ret = vfs_iter_write(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        FPGA_I2C_ERROR("vfs_iter_write failed, path=%s, addr=0x%x, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-    vfs_fsync(filp, 1);
-    filp_close(filp, NULL);
+static const wb_reg_access_ops_t fpga_i2c_dev_ops = {
+    .read = i2c_device_func_read,
+    .write = i2c_device_func_write,
+    .lookup = i2c_device_func_lookup,
+    .read_dev = i2c_device_func_read_dev,
+    .write_dev = i2c_device_func_write_dev,
+};
 
-    return ret;
+static const wb_reg_access_ops_t fpga_pcie_dev_ops = {
+    .read = pcie_device_func_read,
+    .write = pcie_device_func_write,
+    .lookup = pcie_device_func_lookup,
+    .read_dev = pcie_device_func_read_dev,
+    .write_dev = pcie_device_func_write_dev,
+};
 
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
+static const wb_reg_access_ops_t fpga_io_dev_ops = {
+    .read = io_device_func_read,
+    .write = io_device_func_write,
+    .lookup = io_device_func_lookup,
+    .read_dev = io_device_func_read_dev,
+    .write_dev = io_device_func_write_dev,
+};
 
-    return -1;
-}
+static const wb_reg_access_ops_t fpga_spi_dev_ops = {
+    .read = spi_device_func_read,
+    .write = spi_device_func_write,
+    .lookup = spi_device_func_lookup,
+    .read_dev = spi_device_func_read_dev,
+    .write_dev = spi_device_func_write_dev,
+};
 
-static int fpga_device_write(fpga_i2c_dev_t *fpga_i2c, uint32_t pos, uint8_t *val, size_t size)
+static const wb_reg_access_ops_t fpga_indirect_dev_ops = {
+    .read = indirect_device_func_read,
+    .write = indirect_device_func_write,
+    .lookup = indirect_device_func_lookup,
+    .read_dev = indirect_device_func_read_dev,
+    .write_dev = indirect_device_func_write_dev,
+};
+
+/* Resolve the register access of the bus once, instead of on each access */
+static int fpga_device_access_init(fpga_i2c_dev_t *fpga_i2c)
 {
-    int ret;
+    const wb_reg_access_ops_t *ops;
 
     switch (fpga_i2c->i2c_func_mode) {
     case SYMBOL_I2C_DEV_MODE:
-        ret = i2c_device_func_write(fpga_i2c->dev_name, pos, val, size);
+        ops = &fpga_i2c_dev_ops;
         break;
     case FILE_MODE:
-        ret = fpga_file_write(fpga_i2c->dev_name, pos, val, size);
+        ops = NULL;
         break;
     case SYMBOL_PCIE_DEV_MODE:
-        ret = pcie_device_func_write(fpga_i2c->dev_name, pos, val, size);
+        ops = &fpga_pcie_dev_ops;
         break;
     case SYMBOL_IO_DEV_MODE:
-        ret = io_device_func_write(fpga_i2c->dev_name, pos, val, size);
+        ops = &fpga_io_dev_ops;
         break;
     case SYMBOL_SPI_DEV_MODE:
-        ret = spi_device_func_write(fpga_i2c->dev_name, pos, val, size);
+        ops = &fpga_spi_dev_ops;
         break;
     case SYMBOL_INDIRECT_DEV_MODE:
-        ret = indirect_device_func_write(fpga_i2c->dev_name, pos, val, size);
+        ops = &fpga_indirect_dev_ops;
         break;
     default:
-        FPGA_I2C_ERROR("err func_mode %d, write failed.\n", fpga_i2c->i2c_func_mode);
+        FPGA_I2C_ERROR("err func_mode %d.\n", fpga_i2c->i2c_func_mode);
         return -EINVAL;
     }
-    return ret;
 
+    /* The bus registers are written */
+    return wb_reg_access_init(&fpga_i2c->reg_access, fpga_i2c->dev_name, fpga_i2c->i2c_func_mode, ops, 1);
 }
 
-static int fpga_device_read(fpga_i2c_dev_t *fpga_i2c, uint32_t pos, uint8_t *val, size_t size)
+static ssize_t show_reg_access_stats(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    int ret;
-
-    switch (fpga_i2c->i2c_func_mode) {
-    case SYMBOL_I2C_DEV_MODE:
-        ret = i2c_device_func_read(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case FILE_MODE:
-        ret = fpga_file_read(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_PCIE_DEV_MODE:
-        ret = pcie_device_func_read(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_IO_DEV_MODE:
-        ret = io_device_func_read(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_SPI_DEV_MODE:
-        ret = spi_device_func_read(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_INDIRECT_DEV_MODE:
-        ret = indirect_device_func_read(fpga_i2c->dev_name, pos, val, size);
-        break;
-    default:
-        FPGA_I2C_ERROR("err func_mode %d, read failed.\n", fpga_i2c->i2c_func_mode);
-        return -EINVAL;
-    }
+    fpga_i2c_dev_t *fpga_i2c = dev_get_drvdata(dev);
 
-    return ret;
+    return wb_reg_access_stats_show(&fpga_i2c->reg_access, buf);
 }
+static DEVICE_ATTR(reg_access_stats, S_IRUGO, show_reg_access_stats, NULL);
 
 static int little_endian_dword_to_buf(uint8_t *buf, int len, uint32_t dword)
 {
@@ -1067,10 +1033,17 @@ static int fpga_i2c_probe(struct platform_device *pdev)
         goto out;
     }
 
+    ret = fpga_device_access_init(fpga_i2c);
+    if (ret != 0) {
+        dev_err(fpga_i2c->dev, "Failed to init register access of %s, mode %d.\n",
+            fpga_i2c->dev_name, fpga_i2c->i2c_func_mode);
+        goto out;
+    }
+
     ret = fpga_i2c_adapter_init(fpga_i2c);
     if (ret !=0) {
         dev_err(fpga_i2c->dev, "Failed to init fpga i2c adapter.\n");
-        goto out;
+        goto fail_access;
     }
 
     if (fpga_i2c->dev->of_node) {
@@ -1104,6 +1077,9 @@ static int fpga_i2c_probe(struct platform_device *pdev)
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,12,0)
     of_i2c_register_devices(&fpga_i2c->adap);
 #endif
+    if (device_create_file(fpga_i2c->dev, &dev_attr_reg_access_stats) != 0) {
+        dev_warn(fpga_i2c->dev, "Failed to create reg_access_stats.\n");
+    }
     dev_info(fpga_i2c->dev, "registered i2c-%d for %s using mode %d with base address:0x%x, data buf len: %d success.\n",
         fpga_i2c->adap.nr, fpga_i2c->dev_name, fpga_i2c->i2c_func_mode, fpga_i2c->reg.i2c_scale,
         fpga_i2c->reg.i2c_data_buf_len);
@@ -1111,6 +1087,8 @@ static int fpga_i2c_probe(struct platform_device *pdev)
 
 fail_add:
     platform_set_drvdata(pdev, NULL);
+fail_access:
+    wb_reg_access_exit(&fpga_i2c->reg_access);
 out:
     return ret;
 };
@@ -1120,7 +1098,9 @@ static int fpga_i2c_remove(struct platform_device *pdev)
     fpga_i2c_dev_t *fpga_i2c;
 
     fpga_i2c = platform_get_drvdata(pdev);
+    device_remove_file(fpga_i2c->dev, &dev_attr_reg_access_stats);
     i2c_del_adapter(&fpga_i2c->adap);
+    wb_reg_access_exit(&fpga_i2c->reg_access);
     platform_set_drvdata(pdev, NULL);
     return 0;
 };
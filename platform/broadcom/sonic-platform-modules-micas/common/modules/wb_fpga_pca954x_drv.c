@@ -33,25 +33,12 @@
 #include <linux/uio.h>
 #include "fpga_i2c.h"
 
-extern int i2c_device_func_write(const char *path, uint32_t pos, uint8_t *val, size_t size);
-extern int pcie_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_t count);
-extern int io_device_func_write(const char *path, uint32_t pos, uint8_t *val, size_t size);
-extern int spi_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_t count);
-extern int indirect_device_func_write(const char *path, uint32_t pos, uint8_t *val, size_t size);
-
 #define PCA954X_MAX_NCHANS           (8)
 #define FPGA_INTERNAL_PCA9548        (1)
 #define FPGA_EXTERNAL_PCA9548        (2)
 #define FPGA_I2C_EXT_9548_EXITS      (0x01 << 0)
 #define FPGA_I2C_9548_NO_RESET       (0x01 << 1)
 
-#define SYMBOL_I2C_DEV_MODE          (1)
-#define FILE_MODE                    (2)
-#define SYMBOL_PCIE_DEV_MODE         (3)
-#define SYMBOL_IO_DEV_MODE           (4)
-#define SYMBOL_SPI_DEV_MODE          (5)
-#define SYMBOL_INDIRECT_DEV_MODE     (6)
-
 int g_fpga_pca954x_debug = 0;
 int g_fpga_pca954x_error = 0;
 
@@ -150,75 +137,10 @@ static const struct i2c_device_id fpga_pca954x_id[] = {
 };
 MODULE_DEVICE_TABLE(i2c, fpga_pca954x_id);
 
-static int fpga_file_write(const char *path, int pos, unsigned char *val, size_t size)
-{
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDWR, 777);
-    if (IS_ERR(filp)) {
-        FPGA_PCA954X_ERROR("write open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
-
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_SOURCE, &iov, 1, iov.iov_len);
-    ret = vfs_iter_write(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        FPGA_PCA954X_ERROR("vfs_iter_write failed, path=%s, addr=%d, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-
-    vfs_fsync(filp, 1);
-    filp_close(filp, NULL);
-
-    return ret;
-
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
-
-    return -1;
-
-}
-
+/* Through the register access handle resolved by the root FPGA i2c bus */
 static int fpga_device_write(fpga_i2c_dev_t *fpga_i2c, int pos, unsigned char *val, size_t size)
 {
-    int ret;
-
-    switch (fpga_i2c->i2c_func_mode) {
-    case SYMBOL_I2C_DEV_MODE:
-        ret = i2c_device_func_write(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case FILE_MODE:
-        ret = fpga_file_write(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_PCIE_DEV_MODE:
-        ret = pcie_device_func_write(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_IO_DEV_MODE:
-        ret = io_device_func_write(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_SPI_DEV_MODE:
-        ret = spi_device_func_write(fpga_i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_INDIRECT_DEV_MODE:
-        ret = indirect_device_func_write(fpga_i2c->dev_name, pos, val, size);
-        break;
-    default:
-        FPGA_PCA954X_ERROR("err func_mode %d, write failed.\n", fpga_i2c->i2c_func_mode);
-        return -EINVAL;
-    }
-    return ret;
+    return wb_reg_access_write(&fpga_i2c->reg_access, pos, val, size);
 }
 
 static int fpga_reg_write(fpga_i2c_dev_t *fpga_i2c, uint32_t addr, uint8_t val)
@@ -32,6 +32,7 @@
 #include <linux/uio.h>
 
 #include "wb_i2c_dev.h"
+#include "wb_reg_access.h"
 
 #define MAX_I2C_DEV_NUM      (256)
 #define FPGA_MAX_LEN         (256)
@@ -741,6 +742,99 @@ int i2c_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_
 }
 EXPORT_SYMBOL(i2c_device_func_write);
 
+/* Resolves a device path once, for i2c_device_func_read_dev/i2c_device_func_write_dev */
+int i2c_device_func_lookup(const char *path, wb_reg_access_dev_t *dev)
+{
+    struct i2c_dev_info *i2c_dev;
+
+    if ((path == NULL) || (dev == NULL)) {
+        I2C_DEV_DEBUG_ERROR("path or dev NULL");
+        return -EINVAL;
+    }
+
+    i2c_dev = dev_match(path);
+    if (i2c_dev == NULL) {
+        return -ENODEV;
+    }
+
+    dev->dev = i2c_dev;
+    dev->minor = i2c_dev->misc.minor;
+    return 0;
+}
+EXPORT_SYMBOL(i2c_device_func_lookup);
+
+/* The resolved device, NULL once it is removed or its slot reused */
+static struct i2c_dev_info *dev_resolved(const wb_reg_access_dev_t *dev)
+{
+    if ((dev == NULL) || (dev->minor < 0) || (dev->minor >= MAX_I2C_DEV_NUM)) {
+        return NULL;
+    }
+
+    return (i2c_dev_arry[dev->minor] == dev->dev) ? dev->dev : NULL;
+}
+
+int i2c_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    struct i2c_dev_info *i2c_dev;
+    int ret;
+
+    if (buf == NULL) {
+        I2C_DEV_DEBUG_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    if (count > FPGA_MAX_LEN) {
+        I2C_DEV_DEBUG_ERROR("read count %lu, beyond max:%d.\n", count, FPGA_MAX_LEN);
+        return -EINVAL;
+    }
+
+    i2c_dev = dev_resolved(dev);
+    if (i2c_dev == NULL) {
+        return -ESTALE;
+    }
+
+    ret = device_read(i2c_dev, offset, buf, count);
+    if (ret < 0) {
+        I2C_DEV_DEBUG_ERROR("i2c dev read failed, dev name:%s, offset:0x%x, len:%lu.\n",
+            i2c_dev->name, offset, count);
+        return -EINVAL;
+    }
+
+    return count;
+}
+EXPORT_SYMBOL(i2c_device_func_read_dev);
+
+int i2c_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    struct i2c_dev_info *i2c_dev;
+    int ret;
+
+    if (buf == NULL) {
+        I2C_DEV_DEBUG_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    if (count > FPGA_MAX_LEN) {
+        I2C_DEV_DEBUG_ERROR("write count %lu, beyond max:%d.\n", count, FPGA_MAX_LEN);
+        return -EINVAL;
+    }
+
+    i2c_dev = dev_resolved(dev);
+    if (i2c_dev == NULL) {
+        return -ESTALE;
+    }
+
+    ret = device_write(i2c_dev, offset, buf, count);
+    if (ret < 0) {
+        I2C_DEV_DEBUG_ERROR("i2c dev write failed, dev name:%s, offset:0x%x, len:%lu.\n",
+            i2c_dev->name, offset, count);
+        return -EINVAL;
+    }
+
+    return count;
+}
+EXPORT_SYMBOL(i2c_device_func_write_dev);
+
 static int i2c_dev_probe(struct i2c_client *client, const struct i2c_device_id *id)
 {
     int ret = 0;
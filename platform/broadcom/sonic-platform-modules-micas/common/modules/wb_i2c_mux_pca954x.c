@@ -54,6 +54,7 @@
 #include <linux/uio.h>
 
 #include "wb_i2c_mux_pca954x.h"
+#include "wb_reg_access.h"
 
 #define PCA954X_MAX_NCHANS 8
 #define PCA954X_IRQ_OFFSET 4
@@ -76,6 +77,7 @@ typedef struct pca9548_cfg_info_s {
         io_attr_t io_attr;
         file_attr_t file_attr;
     } attr;
+    wb_reg_access_t file_access;    /* reset file, opened at probe */
     bool select_chan_check;
     bool close_chan_force_reset;
 } pca9548_cfg_info_t;
@@ -313,85 +315,6 @@ static void pca9548_gpio_free(gpio_attr_t *gpio_attr)
     }
 }
 
-static int pca954x_reset_file_read(const char *path, uint32_t pos, uint8_t *val, size_t size)
-{
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        PCA954X_ERROR("read open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
-
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_DEST, &iov, 1, iov.iov_len);
-    ret = vfs_iter_read(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        PCA954X_ERROR("vfs_iter_read failed, path=%s, addr=0x%x, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-
-    filp_close(filp, NULL);
-
-    return ret;
-
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
-
-    return -1;
-}
-
-static int pca954x_reset_file_write(const char *path, uint32_t pos, uint8_t *val, size_t size)
-{
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDWR, 777);
-    if (IS_ERR(filp)) {
-        PCA954X_ERROR("write open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
-
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_SOURCE, &iov, 1, iov.iov_len);
-    ret = vfs_iter_write(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        PCA954X_ERROR("vfs_iter_write failed, path=%s, addr=0x%x, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-
-    vfs_fsync(filp, 1);
-    filp_close(filp, NULL);
-
-    return ret;
-
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
-
-    return -1;
-}
-
 static int pca954x_reset_i2c_read(uint32_t bus, uint32_t addr, uint32_t offset_addr,
             unsigned char *buf, uint32_t size)
 {
@@ -497,7 +420,7 @@ static int pca954x_do_file_reset(struct i2c_mux_core *muxc)
     mem_clear(read_value, sizeof(read_value));
     mem_clear(write_reset_on_value, sizeof(write_reset_on_value));
     mem_clear(write_reset_off_value, sizeof(write_reset_off_value));
-    err = pca954x_reset_file_read(file_attr->dev_name, file_attr->offset, read_value, file_attr->width);
+    err = wb_reg_access_read(&reset_cfg->file_access, file_attr->offset, read_value, file_attr->width);
     if (err < 0) {
         goto out;
     }
@@ -520,7 +443,7 @@ static int pca954x_do_file_reset(struct i2c_mux_core *muxc)
             write_reset_off_value[0], write_reset_off_value[1], write_reset_off_value[2], write_reset_off_value[3]);
     }
 
-    err = pca954x_reset_file_write(file_attr->dev_name, file_attr->offset, write_reset_on_value, file_attr->width);
+    err = wb_reg_access_write(&reset_cfg->file_access, file_attr->offset, write_reset_on_value, file_attr->width);
     if (err < 0) {
         goto out;
     }
@@ -529,7 +452,7 @@ static int pca954x_do_file_reset(struct i2c_mux_core *muxc)
         usleep_range(reset_cfg->rst_delay, reset_cfg->rst_delay + 1);
     }
 
-    err = pca954x_reset_file_write(file_attr->dev_name, file_attr->offset, write_reset_off_value, file_attr->width);
+    err = wb_reg_access_write(&reset_cfg->file_access, file_attr->offset, write_reset_off_value, file_attr->width);
     if (err < 0) {
         goto out;
     }
@@ -538,7 +461,7 @@ static int pca954x_do_file_reset(struct i2c_mux_core *muxc)
     timeout = reset_cfg->rst_delay_a;
     while (timeout > 0) {
         usleep_range(1, 2);
-        err = pca954x_reset_file_read(file_attr->dev_name, file_attr->offset, read_value, file_attr->width);
+        err = wb_reg_access_read(&reset_cfg->file_access, file_attr->offset, read_value, file_attr->width);
         if (err < 0) {
             goto out;
         }
@@ -1269,6 +1192,16 @@ static int pca954x_probe(struct i2c_client *client,
         return ret;
     }
 
+    if (data->pca9548_cfg_info.pca9548_reset_type == PCA9548_RESET_FILE) {
+        /* The reset bits are written */
+        ret = wb_reg_access_init(&data->pca9548_cfg_info.file_access,
+            data->pca9548_cfg_info.attr.file_attr.dev_name, WB_REG_ACCESS_FILE, NULL, 1);
+        if (ret < 0) {
+            dev_err(&client->dev, "pca954x reset file init err, ret:%d.\n", ret);
+            return ret;
+        }
+    }
+
     if (client->dev.of_node) {
         ret = of_pca954x_irq_setup(muxc);
     } else {
@@ -1331,6 +1264,7 @@ static int pca954x_probe(struct i2c_client *client,
 
 fail_del_adapters:
     i2c_mux_del_adapters(muxc);
+    wb_reg_access_exit(&data->pca9548_cfg_info.file_access);
     return ret;
 }
 
@@ -1349,6 +1283,7 @@ static void pca954x_remove(struct i2c_client *client)
     }
 
     i2c_mux_del_adapters(muxc);
+    wb_reg_access_exit(&data->pca9548_cfg_info.file_access);
     return;
 }
 
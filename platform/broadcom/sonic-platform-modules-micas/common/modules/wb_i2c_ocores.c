@@ -39,6 +39,7 @@
 #include <linux/uio.h>
 
 #include "wb_i2c_ocores.h"
+#include "wb_reg_access.h"
 
 #define OCORES_FLAG_POLL      BIT(0)
 
@@ -118,6 +119,7 @@ struct ocores_i2c {
     u32 (*getreg)(struct ocores_i2c *i2c, int reg);
     const char *dev_name;
     uint32_t reg_access_mode;
+    wb_reg_access_t reg_access;
     uint32_t big_endian;
     uint32_t irq_offset;
     wb_pci_dev_t wb_pci_dev;
@@ -156,6 +158,15 @@ extern int pcie_device_func_read(const char *path, uint32_t offset, uint8_t *buf
 extern int pcie_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_t count);
 extern int io_device_func_read(const char *path, uint32_t offset, uint8_t *buf, size_t count);
 extern int io_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_t count);
+extern int i2c_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int i2c_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int i2c_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int pcie_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int pcie_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int pcie_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int io_device_func_lookup(const char *path, wb_reg_access_dev_t *dev);
+extern int io_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+extern int io_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
 #if 0
 int __attribute__((weak)) i2c_device_func_read(const char *path, uint32_t offset,
                               uint8_t *buf, size_t count)
@@ -199,133 +210,75 @@ int __attribute__((weak)) io_device_func_write(const char *path, uint32_t offset
     return -EINVAL;
 }
 #endif
-static int ocores_i2c_file_read(const char *path, uint32_t pos, uint8_t *val, size_t size)
+static int ocores_i2c_reg_write(struct ocores_i2c *i2c, uint32_t pos, uint8_t *val, size_t size)
 {
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDONLY, 0);
-    if (IS_ERR(filp)) {
-        OCORES_I2C_ERROR("read open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
-
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_DEST, &iov, 1, iov.iov_len);
-    ret = vfs_iter_read(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        OCORES_I2C_ERROR("vfs_iter_read failed, path=%s, addr=%d, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-
-    filp_close(filp, NULL);
-    return ret;
-
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
-
-    return -1;
+    return wb_reg_access_write(&i2c->reg_access, pos, val, size);
 }
 
-static int ocores_i2c_file_write(const char *path, uint32_t pos, uint8_t *val, size_t size)
+static int ocores_i2c_reg_read(struct ocores_i2c *i2c, uint32_t pos, uint8_t *val, size_t size)
 {
+    return wb_reg_access_read(&i2c->reg_access, pos, val, size);
+}
 
-    int ret;
-    struct file *filp;
-    loff_t tmp_pos;
-
-    struct kvec iov = {
-        .iov_base = val,
-        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
-    };
-    struct iov_iter iter;
-
-    filp = filp_open(path, O_RDWR, 777);
-    if (IS_ERR(filp)) {
-        OCORES_I2C_ERROR("write open failed errno = %ld\r\n", -PTR_ERR(filp));
-        filp = NULL;
-        goto exit;
-    }
-
-    tmp_pos = (loff_t)pos;
-    iov_iter_kvec(&iter, ITER_SOURCE, &iov, 1, iov.iov_len);
-    ret = vfs_iter_write(filp, &iter, &tmp_pos, 0);
-    if (ret < 0) {
-        OCORES_I2C_ERROR("vfs_iter_write failed, path=%s, addr=%d, size=%ld, ret=%d\r\n", path, pos, size, ret);
-        goto exit;
-    }
-
-    vfs_fsync(filp, 1);
-    filp_close(filp, NULL);
-    return ret;
+static const wb_reg_access_ops_t ocores_i2c_dev_ops = {
+    .read = i2c_device_func_read,
+    .write = i2c_device_func_write,
+    .lookup = i2c_device_func_lookup,
+    .read_dev = i2c_device_func_read_dev,
+    .write_dev = i2c_device_func_write_dev,
+};
 
-exit:
-    if (filp != NULL) {
-        filp_close(filp, NULL);
-    }
+static const wb_reg_access_ops_t ocores_pcie_dev_ops = {
+    .read = pcie_device_func_read,
+    .write = pcie_device_func_write,
+    .lookup = pcie_device_func_lookup,
+    .read_dev = pcie_device_func_read_dev,
+    .write_dev = pcie_device_func_write_dev,
+};
 
-    return -1;
-}
+static const wb_reg_access_ops_t ocores_io_dev_ops = {
+    .read = io_device_func_read,
+    .write = io_device_func_write,
+    .lookup = io_device_func_lookup,
+    .read_dev = io_device_func_read_dev,
+    .write_dev = io_device_func_write_dev,
+};
 
-static int ocores_i2c_reg_write(struct ocores_i2c *i2c, uint32_t pos, uint8_t *val, size_t size)
+/* Resolve the register access of the bus once, instead of on each access */
+static int ocores_i2c_reg_access_init(struct ocores_i2c *i2c)
 {
-    int ret;
+    const wb_reg_access_ops_t *ops;
 
     switch (i2c->reg_access_mode) {
     case SYMBOL_I2C_DEV_MODE:
-        ret = i2c_device_func_write(i2c->dev_name, pos, val, size);
+        ops = &ocores_i2c_dev_ops;
         break;
     case FILE_MODE:
-        ret = ocores_i2c_file_write(i2c->dev_name, pos, val, size);
+        ops = NULL;
         break;
     case SYMBOL_PCIE_DEV_MODE:
-        ret = pcie_device_func_write(i2c->dev_name, pos, val, size);
+        ops = &ocores_pcie_dev_ops;
         break;
     case SYMBOL_IO_DEV_MODE:
-        ret = io_device_func_write(i2c->dev_name, pos, val, size);
+        ops = &ocores_io_dev_ops;
         break;
     default:
-        OCORES_I2C_ERROR("err func_mode, write failed.\n");
+        OCORES_I2C_ERROR("err func_mode %d.\n", i2c->reg_access_mode);
         return -EINVAL;
     }
 
-    return ret;
+    /* The bus registers are written */
+    return wb_reg_access_init(&i2c->reg_access, i2c->dev_name, i2c->reg_access_mode, ops, 1);
 }
 
-static int ocores_i2c_reg_read(struct ocores_i2c *i2c, uint32_t pos, uint8_t *val, size_t size)
+static ssize_t show_reg_access_stats(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    int ret;
-
-    switch (i2c->reg_access_mode) {
-    case SYMBOL_I2C_DEV_MODE:
-        ret = i2c_device_func_read(i2c->dev_name, pos, val, size);
-        break;
-    case FILE_MODE:
-        ret = ocores_i2c_file_read(i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_PCIE_DEV_MODE:
-        ret = pcie_device_func_read(i2c->dev_name, pos, val, size);
-        break;
-    case SYMBOL_IO_DEV_MODE:
-        ret = io_device_func_read(i2c->dev_name, pos, val, size);
-        break;
-    default:
-        OCORES_I2C_ERROR("err func_mode, read failed.\n");
-        return -EINVAL;
-    }
+    struct ocores_i2c *i2c = dev_get_drvdata(dev);
 
-    return ret;
+    return wb_reg_access_stats_show(&i2c->reg_access, buf);
 }
+static DEVICE_ATTR(reg_access_stats, S_IRUGO, show_reg_access_stats, NULL);
+
 static void oc_setreg_8(struct ocores_i2c *i2c, int reg, u32 value)
 {
     u8 buf_tmp[REG_IO_WIDTH_1];
@@ -1038,6 +991,12 @@ static int ocores_i2c_probe(struct platform_device *pdev)
         goto out;
     }
 
+    ret = ocores_i2c_reg_access_init(i2c);
+    if (ret != 0) {
+        dev_err(i2c->dev, "Failed to init register access of %s, mode %d.\n", i2c->dev_name, i2c->reg_access_mode);
+        goto out;
+    }
+
     if (i2c->dev->of_node) {
         if (of_property_read_u32(i2c->dev->of_node, "big_endian", &i2c->big_endian)) {
 
@@ -1074,7 +1033,7 @@ static int ocores_i2c_probe(struct platform_device *pdev)
             dev_err(i2c->dev, "Unsupported I/O width (%d)\n",
                 i2c->reg_io_width);
             ret = -EINVAL;
-            goto out;
+            goto fail_access;
         }
     }
 
@@ -1091,7 +1050,7 @@ static int ocores_i2c_probe(struct platform_device *pdev)
             if (irq < 0 ) {
                 dev_err(i2c->dev, "Failed to get  ocores i2c irq number, ret: %d.\n", irq);
                 ret = irq;
-                goto out;
+                goto fail_access;
             }
         }
     } else {
@@ -1110,7 +1069,7 @@ static int ocores_i2c_probe(struct platform_device *pdev)
                 if (irq < 0 ) {
                     dev_err(i2c->dev, "Failed to get ocores i2c irq number, ret: %d.\n", irq);
                     ret = irq;
-                    goto out;
+                    goto fail_access;
                 }
             }
         }
@@ -1121,13 +1080,13 @@ static int ocores_i2c_probe(struct platform_device *pdev)
                        pdev->name, i2c);
         if (ret) {
             dev_err(i2c->dev, "Cannot claim IRQ\n");
-            goto out;
+            goto fail_access;
         }
     }
 
     ret = ocores_init(i2c->dev, i2c);
     if (ret) {
-        goto out;
+        goto fail_access;
     }
 
     /* hook up driver to tree */
@@ -1147,12 +1106,18 @@ static int ocores_i2c_probe(struct platform_device *pdev)
     if (ret) {
         goto fail_add;
     }
+
+    if (device_create_file(i2c->dev, &dev_attr_reg_access_stats) != 0) {
+        dev_warn(i2c->dev, "Failed to create reg_access_stats.\n");
+    }
     OCORES_I2C_VERBOSE("Main probe out\n");
     dev_info(i2c->dev, "registered i2c-%d for %s with base address:0x%x success.\n",
         i2c->adap.nr, i2c->dev_name, i2c->base_addr);
     return 0;
 fail_add:
     platform_set_drvdata(pdev, NULL);
+fail_access:
+    wb_reg_access_exit(&i2c->reg_access);
 out:
     return ret;
 }
@@ -1167,7 +1132,9 @@ static int ocores_i2c_remove(struct platform_device *pdev)
     oc_setreg(i2c, OCI2C_CONTROL, ctrl);
 
     /* remove adapter & data */
+    device_remove_file(i2c->dev, &dev_attr_reg_access_stats);
     i2c_del_adapter(&i2c->adap);
+    wb_reg_access_exit(&i2c->reg_access);
     return 0;
 }
 
@@ -38,6 +38,7 @@
 #include <linux/kprobes.h>
 
 #include "wb_indirect_dev.h"
+#include "wb_reg_access.h"
 #define MODULE_NAME "wb-indirect-dev"
 
 #define SYMBOL_I2C_DEV_MODE       (1)
@@ -688,6 +689,83 @@ int indirect_device_func_write(const char *path, uint32_t offset, uint8_t *buf,
 }
 EXPORT_SYMBOL(indirect_device_func_write);
 
+/* Resolves a device path once, for indirect_device_func_read_dev/indirect_device_func_write_dev */
+int indirect_device_func_lookup(const char *path, wb_reg_access_dev_t *dev)
+{
+    struct indirect_dev_info *indirect_dev;
+
+    if ((path == NULL) || (dev == NULL)) {
+        INDIRECT_DEV_ERROR("path or dev NULL");
+        return -EINVAL;
+    }
+
+    indirect_dev = dev_match(path);
+    if (indirect_dev == NULL) {
+        return -ENODEV;
+    }
+
+    dev->dev = indirect_dev;
+    dev->minor = indirect_dev->misc.minor;
+    return 0;
+}
+EXPORT_SYMBOL(indirect_device_func_lookup);
+
+/* The resolved device, NULL once it is removed or its slot reused */
+static struct indirect_dev_info *dev_resolved(const wb_reg_access_dev_t *dev)
+{
+    if ((dev == NULL) || (dev->minor < 0) || (dev->minor >= MAX_INDIRECT_DEV_NUM)) {
+        return NULL;
+    }
+
+    return (indirect_dev_arry[dev->minor] == dev->dev) ? dev->dev : NULL;
+}
+
+int indirect_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    struct indirect_dev_info *indirect_dev;
+    int read_len;
+
+    if (buf == NULL) {
+        INDIRECT_DEV_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    indirect_dev = dev_resolved(dev);
+    if (indirect_dev == NULL) {
+        return -ESTALE;
+    }
+
+    read_len = device_read(indirect_dev, offset, buf, count);
+    if (read_len < 0) {
+        INDIRECT_DEV_ERROR("device_read failed, ret:%d.\n", read_len);
+    }
+    return read_len;
+}
+EXPORT_SYMBOL(indirect_device_func_read_dev);
+
+int indirect_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    struct indirect_dev_info *indirect_dev;
+    int write_len;
+
+    if (buf == NULL) {
+        INDIRECT_DEV_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    indirect_dev = dev_resolved(dev);
+    if (indirect_dev == NULL) {
+        return -ESTALE;
+    }
+
+    write_len = device_write(indirect_dev, offset, buf, count);
+    if (write_len < 0) {
+        INDIRECT_DEV_ERROR("device_write failed, ret:%d.\n", write_len);
+    }
+    return write_len;
+}
+EXPORT_SYMBOL(indirect_device_func_write_dev);
+
 
 static int wb_indirect_dev_probe(struct platform_device *pdev)
 {
@@ -33,6 +33,7 @@
 #include <linux/uio.h>
 
 #include "wb_io_dev.h"
+#include "wb_reg_access.h"
 
 #define PROXY_NAME "wb-io-dev"
 #define MAX_IO_DEV_NUM                     (256)
@@ -541,6 +542,83 @@ int io_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_t
 }
 EXPORT_SYMBOL(io_device_func_write);
 
+/* Resolves a device path once, for io_device_func_read_dev/io_device_func_write_dev */
+int io_device_func_lookup(const char *path, wb_reg_access_dev_t *dev)
+{
+    wb_io_dev_t *wb_io_dev;
+
+    if ((path == NULL) || (dev == NULL)) {
+        IO_DEV_DEBUG_ERROR("path or dev NULL");
+        return -EINVAL;
+    }
+
+    wb_io_dev = dev_match(path);
+    if (wb_io_dev == NULL) {
+        return -ENODEV;
+    }
+
+    dev->dev = wb_io_dev;
+    dev->minor = wb_io_dev->misc.minor;
+    return 0;
+}
+EXPORT_SYMBOL(io_device_func_lookup);
+
+/* The resolved device, NULL once it is removed or its slot reused */
+static wb_io_dev_t *dev_resolved(const wb_reg_access_dev_t *dev)
+{
+    if ((dev == NULL) || (dev->minor < 0) || (dev->minor >= MAX_IO_DEV_NUM)) {
+        return NULL;
+    }
+
+    return (io_dev_arry[dev->minor] == dev->dev) ? dev->dev : NULL;
+}
+
+int io_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    wb_io_dev_t *wb_io_dev;
+    int read_len;
+
+    if (buf == NULL) {
+        IO_DEV_DEBUG_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    wb_io_dev = dev_resolved(dev);
+    if (wb_io_dev == NULL) {
+        return -ESTALE;
+    }
+
+    read_len = io_dev_read_tmp(wb_io_dev, offset, buf, count);
+    if (read_len < 0) {
+        IO_DEV_DEBUG_ERROR("io_dev_read_tmp failed, ret:%d.\n", read_len);
+    }
+    return read_len;
+}
+EXPORT_SYMBOL(io_device_func_read_dev);
+
+int io_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    wb_io_dev_t *wb_io_dev;
+    int write_len;
+
+    if (buf == NULL) {
+        IO_DEV_DEBUG_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    wb_io_dev = dev_resolved(dev);
+    if (wb_io_dev == NULL) {
+        return -ESTALE;
+    }
+
+    write_len = io_dev_write_tmp(wb_io_dev, offset, buf, count);
+    if (write_len < 0) {
+        IO_DEV_DEBUG_ERROR("io_dev_write_tmp failed, ret:%d.\n", write_len);
+    }
+    return write_len;
+}
+EXPORT_SYMBOL(io_device_func_write_dev);
+
 static int io_dev_probe(struct platform_device *pdev)
 {
     int ret;
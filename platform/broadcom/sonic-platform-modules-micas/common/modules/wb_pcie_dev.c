@@ -32,6 +32,7 @@
 #include <linux/uio.h>
 
 #include "wb_pcie_dev.h"
+#include "wb_reg_access.h"
 
 #define PROXY_NAME "wb-pci-dev"
 #define MAX_NAME_SIZE            (20)
@@ -605,6 +606,83 @@ int pcie_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size
 }
 EXPORT_SYMBOL(pcie_device_func_write);
 
+/* Resolves a device path once, for pcie_device_func_read_dev/pcie_device_func_write_dev */
+int pcie_device_func_lookup(const char *path, wb_reg_access_dev_t *dev)
+{
+    wb_pci_dev_t *wb_pci_dev;
+
+    if ((path == NULL) || (dev == NULL)) {
+        PCIE_DEV_DEBUG_ERROR("path or dev NULL");
+        return -EINVAL;
+    }
+
+    wb_pci_dev = dev_match(path);
+    if (wb_pci_dev == NULL) {
+        return -ENODEV;
+    }
+
+    dev->dev = wb_pci_dev;
+    dev->minor = wb_pci_dev->misc.minor;
+    return 0;
+}
+EXPORT_SYMBOL(pcie_device_func_lookup);
+
+/* The resolved device, NULL once it is removed or its slot reused */
+static wb_pci_dev_t *dev_resolved(const wb_reg_access_dev_t *dev)
+{
+    if ((dev == NULL) || (dev->minor < 0) || (dev->minor >= MAX_PCIE_NUM)) {
+        return NULL;
+    }
+
+    return (pcie_dev_arry[dev->minor] == dev->dev) ? dev->dev : NULL;
+}
+
+int pcie_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    wb_pci_dev_t *wb_pci_dev;
+    int read_len;
+
+    if (buf == NULL) {
+        PCIE_DEV_DEBUG_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    wb_pci_dev = dev_resolved(dev);
+    if (wb_pci_dev == NULL) {
+        return -ESTALE;
+    }
+
+    read_len = pci_dev_read_tmp(wb_pci_dev, offset, buf, count);
+    if (read_len < 0) {
+        PCIE_DEV_DEBUG_ERROR("pci_dev_read_tmp failed, ret:%d.\n", read_len);
+    }
+    return read_len;
+}
+EXPORT_SYMBOL(pcie_device_func_read_dev);
+
+int pcie_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    wb_pci_dev_t *wb_pci_dev;
+    int write_len;
+
+    if (buf == NULL) {
+        PCIE_DEV_DEBUG_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    wb_pci_dev = dev_resolved(dev);
+    if (wb_pci_dev == NULL) {
+        return -ESTALE;
+    }
+
+    write_len = pci_dev_write_tmp(wb_pci_dev, offset, buf, count);
+    if (write_len < 0) {
+        PCIE_DEV_DEBUG_ERROR("pci_dev_write_tmp failed, ret:%d.\n", write_len);
+    }
+    return write_len;
+}
+EXPORT_SYMBOL(pcie_device_func_write_dev);
+
 static int pci_setup_bars(wb_pci_dev_t *wb_pci_dev, struct pci_dev *dev)
 {
     int ret;
@@ -0,0 +1,326 @@
+/*
+ * A header definition for register access handles
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __WB_REG_ACCESS_H__
+#define __WB_REG_ACCESS_H__
+
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/namei.h>
+#include <linux/uio.h>
+#include <linux/err.h>
+#include <linux/atomic.h>
+#include <linux/printk.h>
+
+/* Register access modes, as configured in the dts or platform data */
+#define WB_REG_ACCESS_I2C_DEV       (1)
+#define WB_REG_ACCESS_FILE          (2)
+#define WB_REG_ACCESS_PCIE_DEV      (3)
+#define WB_REG_ACCESS_IO_DEV        (4)
+#define WB_REG_ACCESS_SPI_DEV       (5)
+#define WB_REG_ACCESS_INDIRECT_DEV  (6)
+
+/* Access errors, rate limited: a failing device is usually polled */
+#define WB_REG_ACCESS_ERROR(fmt, args...) \
+    printk_ratelimited(KERN_ERR "[WB_REG_ACCESS][ERR][func:%s line:%d]\r\n"fmt, __func__, __LINE__, ## args)
+
+/* Exported register access of the wb_*_dev drivers, by device path */
+typedef int (*wb_reg_access_func)(const char *path, uint32_t offset, uint8_t *buf, size_t count);
+
+/* Device of a wb_*_dev driver, resolved once from the path by its lookup */
+typedef struct wb_reg_access_dev_s {
+    void *dev;                  /* Device, NULL if not resolved */
+    int minor;                  /* Slot of the device in its driver */
+} wb_reg_access_dev_t;
+
+typedef int (*wb_reg_access_lookup_func)(const char *path, wb_reg_access_dev_t *dev);
+
+/* Access by resolved device, -ESTALE once the device left its slot */
+typedef int (*wb_reg_access_dev_func)(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count);
+
+typedef struct wb_reg_access_ops_s {
+    wb_reg_access_func read;
+    wb_reg_access_func write;
+    wb_reg_access_lookup_func lookup;
+    wb_reg_access_dev_func read_dev;
+    wb_reg_access_dev_func write_dev;
+} wb_reg_access_ops_t;
+
+/*
+ * A register access handle is resolved once, at probe time:
+ * - symbol modes look the device up in the backend driver, and the
+ *   accesses go to it directly. A device not probed yet, or probed again
+ *   since, is accessed by path;
+ * - the file mode keeps a device node open, read-write only for a handle
+ *   used for writes, and opens the file on each access when the path is
+ *   not a character device or the open mode does not allow the access.
+ * An open node holds a reference on its backend module. The platform
+ * DRIVERLISTS load the backends first and unload in reverse order, so the
+ * handles are released before their backends are removed.
+ * Failed accesses are counted and logged with the path.
+ */
+typedef struct wb_reg_access_s {
+    const char *path;
+    uint32_t mode;
+    const wb_reg_access_ops_t *ops;     /* Backend of a symbol mode, NULL for the file mode */
+    wb_reg_access_dev_t dev;
+    struct file *filp;          /* Persistent handle of a device node, or NULL */
+    int writable;               /* filp is opened read-write */
+    atomic_long_t reads;
+    atomic_long_t writes;
+    atomic_long_t errors;
+    atomic_long_t opens;        /* filp_open() done by the accesses */
+} wb_reg_access_t;
+
+static inline const char *wb_reg_access_backend(wb_reg_access_t *ra)
+{
+    int resolved = (ra->dev.dev != NULL);
+
+    switch (ra->mode) {
+    case WB_REG_ACCESS_I2C_DEV:
+        return resolved ? "i2c_dev(resolved)" : "i2c_dev";
+    case WB_REG_ACCESS_FILE:
+        if (ra->filp == NULL) {
+            return "file";
+        }
+        return ra->writable ? "file(persistent)" : "file(persistent, read-only)";
+    case WB_REG_ACCESS_PCIE_DEV:
+        return resolved ? "pcie_dev(resolved)" : "pcie_dev";
+    case WB_REG_ACCESS_IO_DEV:
+        return resolved ? "io_dev(resolved)" : "io_dev";
+    case WB_REG_ACCESS_SPI_DEV:
+        return resolved ? "spi_dev(resolved)" : "spi_dev";
+    case WB_REG_ACCESS_INDIRECT_DEV:
+        return resolved ? "indirect_dev(resolved)" : "indirect_dev";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * wb_reg_access_init - Resolve a register access handle
+ * @ra: Handle
+ * @path: Device path, must outlive the handle
+ * @mode: Access mode
+ * @ops: Backend of a symbol mode, NULL for the file mode
+ * @writes: The handle is used for writes
+ *
+ * @returns: <0 Failure, 0 success
+ */
+static inline int wb_reg_access_init(wb_reg_access_t *ra, const char *path, uint32_t mode,
+                    const wb_reg_access_ops_t *ops, int writes)
+{
+    struct file *filp;
+    struct path node;
+    int is_chr;
+
+    if ((ra == NULL) || (path == NULL)) {
+        return -EINVAL;
+    }
+
+    ra->path = path;
+    ra->mode = mode;
+    ra->ops = ops;
+    ra->dev.dev = NULL;
+    ra->dev.minor = -1;
+    ra->filp = NULL;
+    ra->writable = 0;
+    atomic_long_set(&ra->reads, 0);
+    atomic_long_set(&ra->writes, 0);
+    atomic_long_set(&ra->errors, 0);
+    atomic_long_set(&ra->opens, 0);
+
+    if (mode != WB_REG_ACCESS_FILE) {
+        if ((ops == NULL) || (ops->read == NULL) || (ops->write == NULL)) {
+            return -EINVAL;
+        }
+        /* Not probed yet, accessed by path */
+        if ((ops->lookup != NULL) && (ops->lookup(path, &ra->dev) < 0)) {
+            ra->dev.dev = NULL;
+        }
+        return 0;
+    }
+
+    /* The node may not exist yet, the accesses then open the path themselves.
+     * Sysfs and regular files are reopened on each access, as before, so
+     * only a device node is opened here.
+     */
+    if (kern_path(path, LOOKUP_FOLLOW, &node) != 0) {
+        return 0;
+    }
+    is_chr = S_ISCHR(d_inode(node.dentry)->i_mode);
+    path_put(&node);
+    if (!is_chr) {
+        return 0;
+    }
+
+    filp = filp_open(path, writes ? O_RDWR : O_RDONLY, 0);
+    if (IS_ERR(filp)) {
+        WB_REG_ACCESS_ERROR("open %s failed, errno = %ld, opening it on each access\r\n", path, -PTR_ERR(filp));
+        return 0;
+    }
+    ra->filp = filp;
+    ra->writable = writes;
+
+    return 0;
+}
+
+/**
+ * wb_reg_access_exit - Release a register access handle
+ * @ra: Handle
+ *
+ * @returns: void
+ */
+static inline void wb_reg_access_exit(wb_reg_access_t *ra)
+{
+    if ((ra != NULL) && (ra->filp != NULL)) {
+        filp_close(ra->filp, NULL);
+        ra->filp = NULL;
+    }
+
+    return;
+}
+
+static inline int wb_reg_access_file_rw(wb_reg_access_t *ra, uint32_t pos, uint8_t *val,
+                    size_t size, int write)
+{
+    int ret;
+    struct file *filp;
+    loff_t tmp_pos;
+
+    struct kvec iov = {
+        .iov_base = val,
+        .iov_len = min_t(size_t, size, MAX_RW_COUNT),
+    };
+    struct iov_iter iter;
+
+    filp = ra->filp;
+    if ((filp == NULL) || (write && !ra->writable)) {
+        filp = filp_open(ra->path, write ? O_RDWR : O_RDONLY, 0);
+        if (IS_ERR(filp)) {
+            WB_REG_ACCESS_ERROR("%s open %s failed, errno = %ld\r\n", write ? "write" : "read", ra->path,
+                -PTR_ERR(filp));
+            return PTR_ERR(filp);
+        }
+        atomic_long_inc(&ra->opens);
+    }
+
+    tmp_pos = (loff_t)pos;
+    if (write) {
+        iov_iter_kvec(&iter, ITER_SOURCE, &iov, 1, iov.iov_len);
+        ret = vfs_iter_write(filp, &iter, &tmp_pos, 0);
+        if (ret >= 0) {
+            vfs_fsync(filp, 1);
+        }
+    } else {
+        iov_iter_kvec(&iter, ITER_DEST, &iov, 1, iov.iov_len);
+        ret = vfs_iter_read(filp, &iter, &tmp_pos, 0);
+    }
+    if (ret < 0) {
+        WB_REG_ACCESS_ERROR("vfs_iter_%s failed, path=%s, addr=0x%x, size=%zu, ret=%d\r\n", write ? "write" : "read",
+            ra->path, pos, size, ret);
+    }
+
+    if (filp != ra->filp) {
+        filp_close(filp, NULL);
+    }
+
+    return ret;
+}
+
+/**
+ * wb_reg_access_read - Read registers through a handle
+ * @ra: Handle
+ * @pos: Register offset
+ * @val: Data
+ * @size: Length
+ *
+ * @returns: <0 Failure, other the length read
+ */
+static inline int wb_reg_access_read(wb_reg_access_t *ra, uint32_t pos, uint8_t *val, size_t size)
+{
+    int ret;
+
+    atomic_long_inc(&ra->reads);
+    if (ra->ops != NULL) {
+        ret = (ra->dev.dev != NULL) ? ra->ops->read_dev(&ra->dev, pos, val, size) : -ESTALE;
+        if (ret == -ESTALE) {
+            ret = ra->ops->read(ra->path, pos, val, size);
+        }
+        if (ret < 0) {
+            WB_REG_ACCESS_ERROR("%s read failed, path=%s, addr=0x%x, size=%zu, ret=%d\r\n", wb_reg_access_backend(ra),
+                ra->path, pos, size, ret);
+        }
+    } else {
+        ret = wb_reg_access_file_rw(ra, pos, val, size, 0);
+    }
+    if (ret < 0) {
+        atomic_long_inc(&ra->errors);
+    }
+
+    return ret;
+}
+
+/**
+ * wb_reg_access_write - Write registers through a handle
+ * @ra: Handle
+ * @pos: Register offset
+ * @val: Data
+ * @size: Length
+ *
+ * @returns: <0 Failure, other the length written
+ */
+static inline int wb_reg_access_write(wb_reg_access_t *ra, uint32_t pos, uint8_t *val, size_t size)
+{
+    int ret;
+
+    atomic_long_inc(&ra->writes);
+    if (ra->ops != NULL) {
+        ret = (ra->dev.dev != NULL) ? ra->ops->write_dev(&ra->dev, pos, val, size) : -ESTALE;
+        if (ret == -ESTALE) {
+            ret = ra->ops->write(ra->path, pos, val, size);
+        }
+        if (ret < 0) {
+            WB_REG_ACCESS_ERROR("%s write failed, path=%s, addr=0x%x, size=%zu, ret=%d\r\n", wb_reg_access_backend(ra),
+                ra->path, pos, size, ret);
+        }
+    } else {
+        ret = wb_reg_access_file_rw(ra, pos, val, size, 1);
+    }
+    if (ret < 0) {
+        atomic_long_inc(&ra->errors);
+    }
+
+    return ret;
+}
+
+/**
+ * wb_reg_access_stats_show - Format the access counters of a handle
+ * @ra: Handle
+ * @buf: Sysfs buffer
+ *
+ * @returns: Length of the text
+ */
+static inline ssize_t wb_reg_access_stats_show(wb_reg_access_t *ra, char *buf)
+{
+    return scnprintf(buf, PAGE_SIZE, "path: %s\nbackend: %s\nreads: %ld\nwrites: %ld\nerrors: %ld\nopens: %ld\n",
+        ra->path, wb_reg_access_backend(ra), atomic_long_read(&ra->reads), atomic_long_read(&ra->writes),
+        atomic_long_read(&ra->errors), atomic_long_read(&ra->opens));
+}
+
+#endif /* __WB_REG_ACCESS_H__ */
@@ -32,6 +32,7 @@
 #include <linux/uio.h>
 
 #include "wb_spi_dev.h"
+#include "wb_reg_access.h"
 
 #define MAX_SPI_DEV_NUM      (256)
 #define MAX_RW_LEN           (256)
@@ -617,6 +618,99 @@ int spi_device_func_write(const char *path, uint32_t offset, uint8_t *buf, size_
 }
 EXPORT_SYMBOL(spi_device_func_write);
 
+/* Resolves a device path once, for spi_device_func_read_dev/spi_device_func_write_dev */
+int spi_device_func_lookup(const char *path, wb_reg_access_dev_t *dev)
+{
+    struct spi_dev_info *spi_dev;
+
+    if ((path == NULL) || (dev == NULL)) {
+        SPI_DEV_ERROR("path or dev NULL");
+        return -EINVAL;
+    }
+
+    spi_dev = dev_match(path);
+    if (spi_dev == NULL) {
+        return -ENODEV;
+    }
+
+    dev->dev = spi_dev;
+    dev->minor = spi_dev->misc.minor;
+    return 0;
+}
+EXPORT_SYMBOL(spi_device_func_lookup);
+
+/* The resolved device, NULL once it is removed or its slot reused */
+static struct spi_dev_info *dev_resolved(const wb_reg_access_dev_t *dev)
+{
+    if ((dev == NULL) || (dev->minor < 0) || (dev->minor >= MAX_SPI_DEV_NUM)) {
+        return NULL;
+    }
+
+    return (spi_dev_arry[dev->minor] == dev->dev) ? dev->dev : NULL;
+}
+
+int spi_device_func_read_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    struct spi_dev_info *spi_dev;
+    int ret;
+
+    if (buf == NULL) {
+        SPI_DEV_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    if (count > MAX_RW_LEN) {
+        SPI_DEV_ERROR("read count %lu, beyond max:%d.\n", count, MAX_RW_LEN);
+        return -EINVAL;
+    }
+
+    spi_dev = dev_resolved(dev);
+    if (spi_dev == NULL) {
+        return -ESTALE;
+    }
+
+    ret = device_read(spi_dev, offset, buf, count);
+    if (ret < 0) {
+        SPI_DEV_ERROR("spi dev read failed, dev name:%s, offset:0x%x, len:%lu.\n",
+            spi_dev->name, offset, count);
+        return -EINVAL;
+    }
+
+    return count;
+}
+EXPORT_SYMBOL(spi_device_func_read_dev);
+
+int spi_device_func_write_dev(const wb_reg_access_dev_t *dev, uint32_t offset, uint8_t *buf, size_t count)
+{
+    struct spi_dev_info *spi_dev;
+    int ret;
+
+    if (buf == NULL) {
+        SPI_DEV_ERROR("buf NULL");
+        return -EINVAL;
+    }
+
+    if (count > MAX_RW_LEN) {
+        SPI_DEV_ERROR("write count %lu, beyond max:%d.\n", count, MAX_RW_LEN);
+        return -EINVAL;
+    }
+
+    spi_dev = dev_resolved(dev);
+    if (spi_dev == NULL) {
+        return -ESTALE;
+    }
+
+    ret = device_write(spi_dev, offset, buf, count);
+    if (ret < 0) {
+        SPI_DEV_ERROR("spi dev write failed, dev name:%s, offset:0x%x, len:%lu.\n",
+            spi_dev->name, offset, count);
+        return -EINVAL;
+    }
+
+    return count;
+}
+EXPORT_SYMBOL(spi_device_func_write_dev);
+
 static int spi_dev_probe(struct spi_device *spi)
 {
     int ret;
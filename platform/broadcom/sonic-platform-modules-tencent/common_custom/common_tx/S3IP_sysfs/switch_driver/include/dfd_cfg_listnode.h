@@ -2,18 +2,29 @@
 #define __DFD_CFG_LISTNODE_H__
 
 #include <linux/list.h>
+#include <linux/hashtable.h>
+#include <linux/atomic.h>
 
 #define LNODE_RV_OK             (0)
 #define LNODE_RV_INPUT_ERR      (-1)
 #define LNODE_RV_NODE_EXIST     (-2)
 #define LNODE_RV_NOMEM          (-3)
 
+#define LNODE_HASH_BITS         (10)
+
 typedef struct lnode_root_s {
-    struct list_head root;
+    struct list_head root;                      /* nodes in insertion order */
+    DECLARE_HASHTABLE(hash, LNODE_HASH_BITS);   /* nodes indexed by key */
+    uint32_t count;
+    atomic_long_t lookups;
+    atomic_long_t misses;
+    atomic_long_t probes;                       /* nodes compared by the lookups */
+    struct dentry *stats;
 } lnode_root_t;
 
 typedef struct lnode_node_s {
     struct list_head lst;
+    struct hlist_node hnode;
 
     int key;
     void *data;
@@ -27,4 +38,8 @@ int lnode_init_root(lnode_root_t *root);
 
 void lnode_free_list(lnode_root_t *root);
 
+int lnode_stats_create(lnode_root_t *root, const char *name);
+
+void lnode_stats_remove(lnode_root_t *root);
+
 #endif /* __DFD_CFG_LISTNODE_H__ */
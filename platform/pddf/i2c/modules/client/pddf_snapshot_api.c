@@ -0,0 +1,337 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description
+ *  Device register snapshots shared by the PDDF FAN and PSU drivers. All
+ *  the registers of a device are read in one pass when the snapshot of the
+ *  device is older than the refresh period of its class. Registers of a
+ *  register file (e.g. a CPLD) can be fetched with I2C block reads.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/i2c.h>
+#include <linux/mutex.h>
+#include <linux/sysfs.h>
+#include <linux/slab.h>
+#include <linux/bitmap.h>
+#include "pddf_snapshot_defs.h"
+
+static unsigned int fan_refresh_ms = 1500;
+module_param(fan_refresh_ms, uint, 0644);
+MODULE_PARM_DESC(fan_refresh_ms, "Refresh period of the FAN register snapshots, in ms");
+
+static unsigned int psu_refresh_ms = 1500;
+module_param(psu_refresh_ms, uint, 0644);
+MODULE_PARM_DESC(psu_refresh_ms, "Refresh period of the PSU register snapshots, in ms");
+
+static bool burst_read = false;
+module_param(burst_read, bool, 0644);
+MODULE_PARM_DESC(burst_read, "Fetch adjacent registers of a register file with one I2C block read");
+
+
+static unsigned int pddf_snapshot_refresh_ms(int class)
+{
+    switch (class)
+    {
+        case PDDF_SNAPSHOT_FAN:
+            return fan_refresh_ms;
+        case PDDF_SNAPSHOT_PSU:
+            return psu_refresh_ms;
+        default:
+            return 1500;
+    }
+}
+
+int pddf_snapshot_expired(unsigned long last_updated, int class)
+{
+    return time_after(jiffies, last_updated + msecs_to_jiffies(pddf_snapshot_refresh_ms(class)));
+}
+EXPORT_SYMBOL(pddf_snapshot_expired);
+
+/* Block read of the registers sharing the register file of regs[first] and
+ * forming one contiguous range with it. Bytes no attribute declared are
+ * never read: on a CPLD they may be clear-on-read status registers.
+ * The client is looked up by read_block() on each read, so none is held
+ * here across a device removal.
+ * Returns 0 if regs[first] was read, the ones read are marked in done.
+ */
+static int pddf_snapshot_burst(PDDF_SNAPSHOT *snap, int first, unsigned long *done)
+{
+    DECLARE_BITMAP(in, PDDF_SNAPSHOT_MAX_REGS);
+    PDDF_SNAPSHOT_REG *reg = &snap->regs[first], *r;
+    uint8_t buf[I2C_SMBUS_BLOCK_MAX];
+    uint32_t lo = reg->offset, hi = reg->offset + reg->len;
+    int i, num = 1, grown, status;
+
+    bitmap_zero(in, PDDF_SNAPSHOT_MAX_REGS);
+    set_bit(first, in);
+
+    /* Grow the range by the registers adjacent to or overlapping it */
+    do
+    {
+        grown = 0;
+        for (i = first + 1; i < snap->num_regs; i++)
+        {
+            r = &snap->regs[i];
+            if ((r->read_block != reg->read_block) || (r->devaddr != reg->devaddr) || test_bit(i, done) ||
+                test_bit(i, in))
+                continue;
+            if ((r->offset > hi) || (r->offset + r->len < lo))
+                continue;
+            if (max(hi, r->offset + r->len) - min(lo, r->offset) > I2C_SMBUS_BLOCK_MAX)
+                continue;
+            lo = min(lo, r->offset);
+            hi = max(hi, r->offset + r->len);
+            set_bit(i, in);
+            num++;
+            grown = 1;
+        }
+    } while (grown);
+
+    /* Not worth a block read */
+    if ((num == 1) || (hi > 0x100))
+        return -EAGAIN;
+
+    status = (reg->read_block)(reg->devaddr, lo, hi - lo, buf);
+    if (status != (int)(hi - lo))
+        return (status < 0) ? status : -EIO;
+
+    for (i = first; i < snap->num_regs; i++)
+    {
+        if (!test_bit(i, in))
+            continue;
+        r = &snap->regs[i];
+        memcpy(&snap->value[r->pos], &buf[r->offset - lo], r->len);
+        r->status = 0;
+        set_bit(i, done);
+    }
+
+    return 0;
+}
+
+/* Refreshes the snapshot if it is stale, returns its sequence number */
+uint32_t pddf_snapshot_update(PDDF_SNAPSHOT *snap)
+{
+    DECLARE_BITMAP(done, PDDF_SNAPSHOT_MAX_REGS);
+    PDDF_SNAPSHOT_REG *reg;
+    uint32_t seq;
+    int i;
+
+    mutex_lock(&snap->lock);
+
+    if (!snap->valid || pddf_snapshot_expired(snap->last_updated, snap->class))
+    {
+        bitmap_zero(done, PDDF_SNAPSHOT_MAX_REGS);
+        for (i = 0; i < snap->num_regs; i++)
+        {
+            if (test_bit(i, done))
+                continue;
+
+            reg = &snap->regs[i];
+            if (burst_read && reg->read_block && (pddf_snapshot_burst(snap, i, done) == 0))
+                continue;
+
+            reg->status = (reg->read)(reg, &snap->value[reg->pos]);
+            set_bit(i, done);
+        }
+
+        snap->last_updated = jiffies;
+        snap->timestamp = ktime_get_ns();
+        snap->seq++;
+        snap->valid = 1;
+    }
+    seq = snap->seq;
+
+    mutex_unlock(&snap->lock);
+
+    return seq;
+}
+EXPORT_SYMBOL(pddf_snapshot_update);
+
+/* Copies the value of reg to buf, returns its length or the read error */
+int pddf_snapshot_read(PDDF_SNAPSHOT *snap, PDDF_SNAPSHOT_REG *reg, uint8_t *buf)
+{
+    int status;
+
+    mutex_lock(&snap->lock);
+    status = reg->status;
+    if (status >= 0)
+    {
+        memcpy(buf, &snap->value[reg->pos], reg->len);
+        status = reg->len;
+    }
+    mutex_unlock(&snap->lock);
+
+    return status;
+}
+EXPORT_SYMBOL(pddf_snapshot_read);
+
+void pddf_snapshot_invalidate(PDDF_SNAPSHOT *snap)
+{
+    mutex_lock(&snap->lock);
+    snap->valid = 0;
+    mutex_unlock(&snap->lock);
+}
+EXPORT_SYMBOL(pddf_snapshot_invalidate);
+
+PDDF_SNAPSHOT_REG *pddf_snapshot_add_reg(PDDF_SNAPSHOT *snap, void *client, uint32_t devaddr, uint32_t offset,
+        uint32_t len, int (*read_block)(unsigned short devaddr, u8 offset, u8 len, u8 *buf),
+        int (*read)(PDDF_SNAPSHOT_REG *reg, uint8_t *buf), void *data)
+{
+    PDDF_SNAPSHOT_REG *reg = NULL;
+    int i;
+
+    if ((len == 0) || (len > I2C_SMBUS_BLOCK_MAX) || (read == NULL))
+        return NULL;
+
+    mutex_lock(&snap->lock);
+
+    /* Attributes decoding the same register share its value */
+    for (i = 0; i < snap->num_regs; i++)
+    {
+        reg = &snap->regs[i];
+        if ((reg->client == client) && (reg->devaddr == devaddr) && (reg->offset == offset) &&
+            (reg->len == len) && (reg->read == read))
+            goto exit;
+    }
+
+    reg = NULL;
+    if ((snap->num_regs >= PDDF_SNAPSHOT_MAX_REGS) || (snap->size + len > PDDF_SNAPSHOT_SIZE))
+    {
+        printk(KERN_ERR "%s: No room for register 0x%x of 0x%x in the %s snapshot\n", __FUNCTION__, offset, devaddr, snap->name);
+        goto exit;
+    }
+
+    reg = &snap->regs[snap->num_regs++];
+    reg->client = client;
+    reg->devaddr = devaddr;
+    reg->offset = offset;
+    reg->len = len;
+    reg->read_block = read_block;
+    reg->read = read;
+    reg->data = data;
+    reg->pos = snap->size;
+    reg->status = -EAGAIN;
+    snap->size += len;
+    snap->valid = 0;
+
+exit:
+    mutex_unlock(&snap->lock);
+    return reg;
+}
+EXPORT_SYMBOL(pddf_snapshot_add_reg);
+
+static ssize_t pddf_snapshot_bin_read(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+        char *buf, loff_t off, size_t count)
+{
+    PDDF_SNAPSHOT *snap = attr->private;
+    PDDF_SNAPSHOT_HDR *hdr;
+    PDDF_SNAPSHOT_ENTRY *entry;
+    char *image;
+    size_t size;
+    int i;
+
+    /* A read from the start refreshes the snapshot when stale */
+    if (off == 0)
+        pddf_snapshot_update(snap);
+
+    mutex_lock(&snap->lock);
+
+    size = sizeof(*hdr) + snap->num_regs * sizeof(*entry) + snap->size;
+    if (off >= size)
+    {
+        mutex_unlock(&snap->lock);
+        return 0;
+    }
+
+    image = kzalloc(size, GFP_KERNEL);
+    if (!image)
+    {
+        mutex_unlock(&snap->lock);
+        return -ENOMEM;
+    }
+
+    hdr = (PDDF_SNAPSHOT_HDR *)image;
+    hdr->seq = snap->seq;
+    hdr->num_regs = snap->num_regs;
+    hdr->size = snap->size;
+    hdr->refresh_ms = pddf_snapshot_refresh_ms(snap->class);
+    hdr->timestamp = snap->timestamp;
+
+    entry = (PDDF_SNAPSHOT_ENTRY *)(hdr + 1);
+    for (i = 0; i < snap->num_regs; i++)
+    {
+        entry[i].devaddr = snap->regs[i].devaddr;
+        entry[i].offset = snap->regs[i].offset;
+        entry[i].len = snap->regs[i].len;
+        entry[i].pos = snap->regs[i].pos;
+        entry[i].status = snap->regs[i].status;
+    }
+    memcpy(&entry[snap->num_regs], snap->value, snap->size);
+
+    mutex_unlock(&snap->lock);
+
+    count = min_t(size_t, count, size - off);
+    memcpy(buf, image + off, count);
+    kfree(image);
+
+    return count;
+}
+
+int pddf_snapshot_create_file(PDDF_SNAPSHOT *snap, struct kobject *kobj)
+{
+    snap->bin_attr.size = sizeof(PDDF_SNAPSHOT_HDR) + snap->num_regs * sizeof(PDDF_SNAPSHOT_ENTRY) + snap->size;
+
+    return sysfs_create_bin_file(kobj, &snap->bin_attr);
+}
+EXPORT_SYMBOL(pddf_snapshot_create_file);
+
+void pddf_snapshot_remove_file(PDDF_SNAPSHOT *snap, struct kobject *kobj)
+{
+    sysfs_remove_bin_file(kobj, &snap->bin_attr);
+}
+EXPORT_SYMBOL(pddf_snapshot_remove_file);
+
+PDDF_SNAPSHOT *pddf_snapshot_create(const char *name, int class)
+{
+    PDDF_SNAPSHOT *snap;
+
+    snap = kzalloc(sizeof(PDDF_SNAPSHOT), GFP_KERNEL);
+    if (!snap)
+        return NULL;
+
+    strscpy(snap->name, name, PDDF_SNAPSHOT_NAME_LEN);
+    snap->class = class;
+    mutex_init(&snap->lock);
+
+    sysfs_bin_attr_init(&snap->bin_attr);
+    snap->bin_attr.attr.name = "snapshot";
+    snap->bin_attr.attr.mode = S_IRUGO;
+    snap->bin_attr.read = pddf_snapshot_bin_read;
+    snap->bin_attr.private = snap;
+
+    return snap;
+}
+EXPORT_SYMBOL(pddf_snapshot_create);
+
+void pddf_snapshot_destroy(PDDF_SNAPSHOT *snap)
+{
+    kfree(snap);
+}
+EXPORT_SYMBOL(pddf_snapshot_destroy);
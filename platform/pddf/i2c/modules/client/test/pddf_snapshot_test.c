@@ -0,0 +1,398 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Userspace test of the FAN/PSU register snapshots against mock devices:
+ *  refresh period per class, sequence numbers, invalidation on store,
+ *  shared registers and block reads of the register files
+ */
+
+#include "../pddf_snapshot_api.c"
+
+#define CPLD_ADDR       0x60
+#define PSU_ADDR        0x58
+#define CLEAR_ON_READ   0x13
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+unsigned long jiffies = 1000;
+
+/* Mock devices: a CPLD with a clear-on-read status register at
+ * CLEAR_ON_READ, and a PSU read a register at a time. The reads of each
+ * byte are counted.
+ */
+static uint8_t cpld_regs[256], psu_regs[256];
+static int cpld_byte_reads[256], psu_byte_reads[256];
+static int single_reads, block_reads, block_fail;
+static int bin_files;
+
+static uint8_t *dev_regs(uint32_t devaddr, int **reads)
+{
+    *reads = (devaddr == CPLD_ADDR) ? cpld_byte_reads : psu_byte_reads;
+    return (devaddr == CPLD_ADDR) ? cpld_regs : psu_regs;
+}
+
+static void dev_read(uint32_t devaddr, uint32_t offset, uint32_t len, uint8_t *buf)
+{
+    int *reads;
+    uint8_t *regs = dev_regs(devaddr, &reads);
+    uint32_t i;
+
+    for (i = offset; i < offset + len; i++)
+    {
+        buf[i - offset] = regs[i];
+        reads[i]++;
+    }
+}
+
+static int mock_read(PDDF_SNAPSHOT_REG *reg, uint8_t *buf)
+{
+    single_reads++;
+    if (reg->data != NULL)
+        return -EIO;
+    dev_read(reg->devaddr, reg->offset, reg->len, buf);
+    return 0;
+}
+
+static int mock_read_block(unsigned short devaddr, u8 offset, u8 len, u8 *buf)
+{
+    block_reads++;
+    CHECK(len <= I2C_SMBUS_BLOCK_MAX);
+    if (block_fail)
+        return -EIO;
+    dev_read(devaddr, offset, len, buf);
+    return len;
+}
+
+int sysfs_create_bin_file(struct kobject *kobj, const struct bin_attribute *attr)
+{
+    bin_files++;
+    return 0;
+}
+
+void sysfs_remove_bin_file(struct kobject *kobj, const struct bin_attribute *attr)
+{
+    bin_files--;
+}
+
+static void mock_reset(void)
+{
+    int i;
+
+    for (i = 0; i < 256; i++)
+    {
+        cpld_regs[i] = i;
+        psu_regs[i] = 0xff - i;
+    }
+    memset(cpld_byte_reads, 0, sizeof(cpld_byte_reads));
+    memset(psu_byte_reads, 0, sizeof(psu_byte_reads));
+    single_reads = block_reads = block_fail = 0;
+    burst_read = false;
+}
+
+static PDDF_SNAPSHOT_REG *add_cpld(PDDF_SNAPSHOT *snap, void *client, uint32_t offset, uint32_t len)
+{
+    return pddf_snapshot_add_reg(snap, client, CPLD_ADDR, offset, len, mock_read_block, mock_read, NULL);
+}
+
+/* Each class refreshes on its own period */
+static void test_refresh_per_class(void)
+{
+    PDDF_SNAPSHOT *fan, *psu;
+    int client;
+
+    mock_reset();
+    fan_refresh_ms = 1000;
+    psu_refresh_ms = 3000;
+    fan = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    psu = pddf_snapshot_create("psu", PDDF_SNAPSHOT_PSU);
+    CHECK(add_cpld(fan, &client, 0x10, 1) != NULL);
+    CHECK(pddf_snapshot_add_reg(psu, &client, PSU_ADDR, 0x88, 2, NULL, mock_read, NULL) != NULL);
+
+    /* Never read: the first access reads */
+    CHECK(pddf_snapshot_update(fan) == 1);
+    CHECK(pddf_snapshot_update(psu) == 1);
+    CHECK(single_reads == 2);
+
+    /* Within the period, and on its last jiffy */
+    jiffies += 1000;
+    CHECK(pddf_snapshot_update(fan) == 1);
+    CHECK(pddf_snapshot_update(psu) == 1);
+    CHECK(single_reads == 2);
+
+    /* The FAN period is over, not the PSU one */
+    jiffies += 1;
+    CHECK(pddf_snapshot_update(fan) == 2);
+    CHECK(pddf_snapshot_update(psu) == 1);
+    CHECK(single_reads == 3);
+
+    jiffies += 2000;
+    CHECK(pddf_snapshot_update(fan) == 3);
+    CHECK(pddf_snapshot_update(psu) == 2);
+    CHECK(single_reads == 5);
+
+    /* The module parameters apply to the next check */
+    fan_refresh_ms = 10000;
+    jiffies += 5000;
+    CHECK(pddf_snapshot_update(fan) == 3);
+    CHECK(pddf_snapshot_update(psu) == 3);
+
+    pddf_snapshot_destroy(fan);
+    pddf_snapshot_destroy(psu);
+    fan_refresh_ms = psu_refresh_ms = 1500;
+}
+
+/* One sequence number per refresh, the values and errors it carries */
+static void test_sequence(void)
+{
+    PDDF_SNAPSHOT *snap;
+    PDDF_SNAPSHOT_REG *a, *b, *bad;
+    uint8_t buf[4];
+    int client;
+
+    mock_reset();
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    a = add_cpld(snap, &client, 0x20, 1);
+    b = add_cpld(snap, &client, 0x30, 2);
+    bad = pddf_snapshot_add_reg(snap, &client, CPLD_ADDR, 0x40, 1, NULL, mock_read, &client);
+    CHECK(a && b && bad);
+
+    /* No value before the first refresh */
+    CHECK(snap->seq == 0);
+    CHECK(pddf_snapshot_read(snap, a, buf) == -EAGAIN);
+
+    CHECK(pddf_snapshot_update(snap) == 1);
+    CHECK(single_reads == 3);
+    CHECK(pddf_snapshot_read(snap, a, buf) == 1 && buf[0] == 0x20);
+    CHECK(pddf_snapshot_read(snap, b, buf) == 2 && buf[0] == 0x30 && buf[1] == 0x31);
+    CHECK(pddf_snapshot_read(snap, bad, buf) == -EIO);
+
+    /* Readers of the same refresh see the same sequence and values */
+    cpld_regs[0x20] = 0xaa;
+    CHECK(pddf_snapshot_update(snap) == 1);
+    CHECK(single_reads == 3);
+    CHECK(pddf_snapshot_read(snap, a, buf) == 1 && buf[0] == 0x20);
+
+    jiffies += 1501;
+    CHECK(pddf_snapshot_update(snap) == 2);
+    CHECK(single_reads == 6);
+    CHECK(pddf_snapshot_read(snap, a, buf) == 1 && buf[0] == 0xaa);
+
+    /* A register added later makes the next access refresh */
+    CHECK(add_cpld(snap, &client, 0x50, 1) != NULL);
+    CHECK(pddf_snapshot_update(snap) == 3);
+
+    pddf_snapshot_destroy(snap);
+}
+
+/* A store invalidates, the next access reads back the device */
+static void test_invalidate_on_store(void)
+{
+    PDDF_SNAPSHOT *snap;
+    PDDF_SNAPSHOT_REG *pwm;
+    uint8_t buf[1];
+    uint32_t seq;
+    int client;
+
+    mock_reset();
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    pwm = add_cpld(snap, &client, 0x60, 1);
+    seq = pddf_snapshot_update(snap);
+    CHECK(pddf_snapshot_read(snap, pwm, buf) == 1 && buf[0] == 0x60);
+
+    /* fan_store_attr: write the device, then invalidate */
+    cpld_regs[0x60] = 0x33;
+    pddf_snapshot_invalidate(snap);
+    CHECK(!snap->valid);
+    CHECK(pddf_snapshot_update(snap) == seq + 1);
+    CHECK(pddf_snapshot_read(snap, pwm, buf) == 1 && buf[0] == 0x33);
+
+    /* Valid again until the period is over */
+    CHECK(pddf_snapshot_update(snap) == seq + 1);
+    CHECK(single_reads == 2);
+
+    pddf_snapshot_destroy(snap);
+}
+
+/* Attributes decoding the same register share one read */
+static void test_dedup(void)
+{
+    PDDF_SNAPSHOT *snap;
+    PDDF_SNAPSHOT_REG *a, *b;
+    int client, other;
+
+    mock_reset();
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    a = add_cpld(snap, &client, 0x10, 1);
+    CHECK(a != NULL);
+    CHECK(add_cpld(snap, &client, 0x10, 1) == a);
+    CHECK(snap->num_regs == 1 && snap->size == 1);
+
+    /* Another (devaddr, offset), length or client is another register */
+    b = add_cpld(snap, &client, 0x11, 1);
+    CHECK(b != NULL && b != a);
+    CHECK(add_cpld(snap, &client, 0x10, 2) != a);
+    CHECK(pddf_snapshot_add_reg(snap, &client, PSU_ADDR, 0x10, 1, NULL, mock_read, NULL) != a);
+    CHECK(add_cpld(snap, &other, 0x10, 1) != a);
+    CHECK(snap->num_regs == 5);
+
+    /* Each register read once per refresh */
+    CHECK(pddf_snapshot_update(snap) == 1);
+    CHECK(single_reads == 5);
+
+    /* Rejected */
+    CHECK(add_cpld(snap, &client, 0x70, 0) == NULL);
+    CHECK(add_cpld(snap, &client, 0x70, I2C_SMBUS_BLOCK_MAX + 1) == NULL);
+    CHECK(pddf_snapshot_add_reg(snap, &client, CPLD_ADDR, 0x70, 1, NULL, NULL, NULL) == NULL);
+    CHECK(snap->num_regs == 5);
+
+    pddf_snapshot_destroy(snap);
+}
+
+/* Block reads cover contiguous declared registers only */
+static void test_burst(void)
+{
+    PDDF_SNAPSHOT *snap;
+    PDDF_SNAPSHOT_REG *r10, *r11, *r12, *r14, *r15, *word;
+    uint8_t buf[2];
+    int client, i;
+
+    mock_reset();
+    burst_read = true;
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    /* Declared out of order, with the clear-on-read 0x13 in a gap */
+    r12 = add_cpld(snap, &client, 0x12, 1);
+    r10 = add_cpld(snap, &client, 0x10, 1);
+    r14 = add_cpld(snap, &client, 0x14, 1);
+    r11 = add_cpld(snap, &client, 0x11, 1);
+    r15 = add_cpld(snap, &client, 0x15, 1);
+    word = add_cpld(snap, &client, 0x11, 2);
+    CHECK(pddf_snapshot_add_reg(snap, &client, PSU_ADDR, 0x12, 1, NULL, mock_read, NULL) != NULL);
+
+    CHECK(pddf_snapshot_update(snap) == 1);
+    /* 0x10-0x12 and 0x14-0x15 in two block reads, the PSU on its own */
+    CHECK(block_reads == 2);
+    CHECK(single_reads == 1);
+    CHECK(cpld_byte_reads[CLEAR_ON_READ] == 0);
+    for (i = 0x10; i <= 0x15; i++)
+        CHECK(cpld_byte_reads[i] == (i == CLEAR_ON_READ ? 0 : 1));
+    CHECK(pddf_snapshot_read(snap, r10, buf) == 1 && buf[0] == 0x10);
+    CHECK(pddf_snapshot_read(snap, r11, buf) == 1 && buf[0] == 0x11);
+    CHECK(pddf_snapshot_read(snap, r12, buf) == 1 && buf[0] == 0x12);
+    CHECK(pddf_snapshot_read(snap, word, buf) == 2 && buf[0] == 0x11 && buf[1] == 0x12);
+    CHECK(pddf_snapshot_read(snap, r14, buf) == 1 && buf[0] == 0x14);
+    CHECK(pddf_snapshot_read(snap, r15, buf) == 1 && buf[0] == 0x15);
+    pddf_snapshot_destroy(snap);
+
+    /* A lone register is read on its own */
+    mock_reset();
+    burst_read = true;
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    add_cpld(snap, &client, 0x10, 1);
+    add_cpld(snap, &client, 0x12, 1);
+    CHECK(pddf_snapshot_update(snap) == 1);
+    CHECK(block_reads == 0 && single_reads == 2);
+    CHECK(cpld_byte_reads[0x11] == 0);
+    pddf_snapshot_destroy(snap);
+
+    /* No block read longer than I2C_SMBUS_BLOCK_MAX */
+    mock_reset();
+    burst_read = true;
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    for (i = 0; i < 40; i++)
+        add_cpld(snap, &client, 0x80 + i, 1);
+    CHECK(pddf_snapshot_update(snap) == 1);
+    CHECK(block_reads == 2 && single_reads == 0);
+    for (i = 0; i < 40; i++)
+        CHECK(cpld_byte_reads[0x80 + i] == 1);
+
+    /* A failed block read falls back to register reads */
+    jiffies += 1501;
+    block_fail = 1;
+    block_reads = single_reads = 0;
+    CHECK(pddf_snapshot_update(snap) == 2);
+    CHECK(single_reads == 40);
+    pddf_snapshot_destroy(snap);
+
+    /* Off unless asked */
+    mock_reset();
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    add_cpld(snap, &client, 0x10, 1);
+    add_cpld(snap, &client, 0x11, 1);
+    CHECK(pddf_snapshot_update(snap) == 1);
+    CHECK(block_reads == 0 && single_reads == 2);
+    pddf_snapshot_destroy(snap);
+}
+
+/* The 'snapshot' binary attribute: header, entries and values */
+static void test_bin_file(void)
+{
+    PDDF_SNAPSHOT *snap;
+    struct kobject kobj = { "fan" };
+    char buf[256];
+    PDDF_SNAPSHOT_HDR *hdr = (PDDF_SNAPSHOT_HDR *)buf;
+    PDDF_SNAPSHOT_ENTRY *entry = (PDDF_SNAPSHOT_ENTRY *)(hdr + 1);
+    size_t size;
+    int client;
+
+    mock_reset();
+    snap = pddf_snapshot_create("fan", PDDF_SNAPSHOT_FAN);
+    add_cpld(snap, &client, 0x20, 1);
+    add_cpld(snap, &client, 0x30, 2);
+    CHECK(pddf_snapshot_create_file(snap, &kobj) == 0);
+    CHECK(bin_files == 1);
+    size = sizeof(*hdr) + 2 * sizeof(*entry) + 3;
+    CHECK(snap->bin_attr.size == size);
+
+    /* A read from the start refreshes */
+    CHECK(snap->bin_attr.read(NULL, &kobj, &snap->bin_attr, buf, 0, sizeof(buf)) == size);
+    CHECK(hdr->seq == 1 && hdr->num_regs == 2 && hdr->size == 3 && hdr->refresh_ms == 1500);
+    CHECK(entry[1].devaddr == CPLD_ADDR && entry[1].offset == 0x30 && entry[1].len == 2 && entry[1].pos == 1);
+    CHECK(memcmp(&entry[2], "\x20\x30\x31", 3) == 0);
+
+    /* Past the end */
+    CHECK(snap->bin_attr.read(NULL, &kobj, &snap->bin_attr, buf, size, sizeof(buf)) == 0);
+
+    pddf_snapshot_remove_file(snap, &kobj);
+    CHECK(bin_files == 0);
+    pddf_snapshot_destroy(snap);
+}
+
+int main(void)
+{
+    test_refresh_per_class();
+    test_sequence();
+    test_invalidate_on_store();
+    test_dedup();
+    test_burst();
+    test_bin_file();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pddf snapshot: all tests passed\n");
+    return 0;
+}
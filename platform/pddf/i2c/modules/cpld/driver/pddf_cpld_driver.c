@@ -19,119 +19,180 @@
 #include <linux/i2c.h>
 #include <linux/slab.h>
 #include <linux/list.h>
+#include <linux/hashtable.h>
+#include <linux/srcu.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/dmi.h>
 #include "pddf_cpld_defs.h"
 
 extern PDDF_CPLD_DATA pddf_cpld_data;
 
 
-static LIST_HEAD(cpld_client_list);
+/* Clients are hashed by address. Lookups and the bus transactions run
+ * under cpld_client_srcu only, list_lock serializes add and remove.
+ */
+#define CPLD_CLIENT_HASH_BITS 6
+static DEFINE_HASHTABLE(cpld_client_hash, CPLD_CLIENT_HASH_BITS);
+DEFINE_STATIC_SRCU(cpld_client_srcu);
 static struct mutex	 list_lock;
 
+static struct dentry *cpld_debugfs_dir;
+
 struct cpld_client_node {
 	struct i2c_client *client;
 	char name[CPLD_CLIENT_NAME_LEN];
-	struct list_head   list;
+	struct hlist_node  node;
+
+	/* Access statistics, in debugfs */
+	atomic64_t reads;
+	atomic64_t writes;
+	atomic64_t errors;
+	atomic64_t total_ns;
+	atomic64_t max_ns;
 };
 
-int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg)
+/* Match the address, and the name prefix if name is not NULL */
+static struct cpld_client_node *board_i2c_cpld_find(unsigned short cpld_addr, char *name)
 {
-	struct list_head   *list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
-	int ret = -EPERM;
-
-	mutex_lock(&list_lock);
 
-	list_for_each(list_node, &cpld_client_list)
+	hash_for_each_possible_rcu(cpld_client_hash, cpld_node, node, cpld_addr,
+				   srcu_read_lock_held(&cpld_client_srcu))
 	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-
-		if ((cpld_node->client->addr == cpld_addr) && (strncmp(cpld_node->name, name, strlen(name)) == 0)) {
-			ret = i2c_smbus_read_byte_data(cpld_node->client, reg);
-			break;
-		}
+		if ((cpld_node->client->addr == cpld_addr) &&
+		    ((name == NULL) || (strncmp(cpld_node->name, name, strlen(name)) == 0)))
+			return cpld_node;
 	}
 
-	mutex_unlock(&list_lock);
+	return NULL;
+}
 
-	return ret;
+static void board_i2c_cpld_account(struct cpld_client_node *cpld_node, int write, int ret, u64 start)
+{
+	s64 ns = ktime_get_ns() - start;
+	s64 max = atomic64_read(&cpld_node->max_ns);
+	s64 prev;
+
+	atomic64_inc(write ? &cpld_node->writes : &cpld_node->reads);
+	if (ret < 0)
+		atomic64_inc(&cpld_node->errors);
+	atomic64_add(ns, &cpld_node->total_ns);
+
+	while (ns > max) {
+		prev = atomic64_cmpxchg(&cpld_node->max_ns, max, ns);
+		if (prev == max)
+			break;
+		max = prev;
+	}
 }
-EXPORT_SYMBOL(board_i2c_cpld_read_new);
 
-int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value)
+static int board_i2c_cpld_access(unsigned short cpld_addr, char *name, u8 reg, int write, u8 value)
 {
-	struct list_head   *list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
-	int ret = -EIO;
+	int ret = write ? -EIO : -EPERM;
+	int idx;
+	u64 start;
+
+	/* The adapter lock serializes the bus, nothing else is held across
+	 * the transaction
+	 */
+	idx = srcu_read_lock(&cpld_client_srcu);
+
+	cpld_node = board_i2c_cpld_find(cpld_addr, name);
+	if (cpld_node) {
+		start = ktime_get_ns();
+		if (write)
+			ret = i2c_smbus_write_byte_data(cpld_node->client, reg, value);
+		else
+			ret = i2c_smbus_read_byte_data(cpld_node->client, reg);
+		board_i2c_cpld_account(cpld_node, write, ret, start);
+	}
 
-	mutex_lock(&list_lock);
+	srcu_read_unlock(&cpld_client_srcu, idx);
 
-	list_for_each(list_node, &cpld_client_list)
-	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
+	return ret;
+}
 
-		if ((cpld_node->client->addr == cpld_addr) && (strncmp(cpld_node->name, name, strlen(name)) == 0)){
-			ret = i2c_smbus_write_byte_data(cpld_node->client, reg, value);
-			break;
+/* Block read of len registers from reg, returns the number of bytes read */
+int board_i2c_cpld_read_block(unsigned short cpld_addr, u8 reg, u8 len, u8 *values)
+{
+	struct cpld_client_node *cpld_node = NULL;
+	int ret = -EPERM;
+	int idx;
+	u64 start;
+
+	idx = srcu_read_lock(&cpld_client_srcu);
+
+	cpld_node = board_i2c_cpld_find(cpld_addr, NULL);
+	if (cpld_node) {
+		if (i2c_check_functionality(cpld_node->client->adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+			start = ktime_get_ns();
+			ret = i2c_smbus_read_i2c_block_data(cpld_node->client, reg, len, values);
+			board_i2c_cpld_account(cpld_node, 0, ret, start);
+		} else {
+			ret = -EOPNOTSUPP;
 		}
 	}
 
-	mutex_unlock(&list_lock);
+	srcu_read_unlock(&cpld_client_srcu, idx);
 
 	return ret;
 }
+EXPORT_SYMBOL(board_i2c_cpld_read_block);
+
+int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg)
+{
+	return board_i2c_cpld_access(cpld_addr, name, reg, 0, 0);
+}
+EXPORT_SYMBOL(board_i2c_cpld_read_new);
+
+int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value)
+{
+	return board_i2c_cpld_access(cpld_addr, name, reg, 1, value);
+}
 EXPORT_SYMBOL(board_i2c_cpld_write_new);
 
 int board_i2c_cpld_read(unsigned short cpld_addr, u8 reg)
 {
-	struct list_head   *list_node = NULL;
-	struct cpld_client_node *cpld_node = NULL;
-	int ret = -EPERM;
-	
 	//hw_preaccess_func_cpld_mux_default((uint32_t)cpld_addr, NULL);
 
-	mutex_lock(&list_lock);
-
-	list_for_each(list_node, &cpld_client_list)
-	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-		
-		if (cpld_node->client->addr == cpld_addr) {
-			ret = i2c_smbus_read_byte_data(cpld_node->client, reg);
-			break;
-		}
-	}
-	
-	mutex_unlock(&list_lock);
-
-	return ret;
+	return board_i2c_cpld_access(cpld_addr, NULL, reg, 0, 0);
 }
 EXPORT_SYMBOL(board_i2c_cpld_read);
 
 int board_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value)
 {
-	struct list_head   *list_node = NULL;
+	return board_i2c_cpld_access(cpld_addr, NULL, reg, 1, value);
+}
+EXPORT_SYMBOL(board_i2c_cpld_write);
+
+static int cpld_stats_show(struct seq_file *m, void *v)
+{
 	struct cpld_client_node *cpld_node = NULL;
-	int ret = -EIO;
-	
+	s64 count;
+	int bkt;
 
-	mutex_lock(&list_lock);
+	seq_printf(m, "%-16s %-4s %-6s %10s %10s %8s %10s %10s\n",
+		   "name", "bus", "addr", "reads", "writes", "errors", "avg_us", "max_us");
 
-	list_for_each(list_node, &cpld_client_list)
+	mutex_lock(&list_lock);
+	hash_for_each(cpld_client_hash, bkt, cpld_node, node)
 	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-		
-		if (cpld_node->client->addr == cpld_addr) {
-			ret = i2c_smbus_write_byte_data(cpld_node->client, reg, value);
-			break;
-		}
+		count = atomic64_read(&cpld_node->reads) + atomic64_read(&cpld_node->writes);
+		seq_printf(m, "%-16s %-4d 0x%-4x %10lld %10lld %8lld %10lld %10lld\n",
+			   cpld_node->name, cpld_node->client->adapter->nr, cpld_node->client->addr,
+			   atomic64_read(&cpld_node->reads), atomic64_read(&cpld_node->writes),
+			   atomic64_read(&cpld_node->errors),
+			   count ? div64_s64(atomic64_read(&cpld_node->total_ns), count * NSEC_PER_USEC) : 0,
+			   div64_s64(atomic64_read(&cpld_node->max_ns), NSEC_PER_USEC));
 	}
-	
 	mutex_unlock(&list_lock);
 
-	return ret;
+	return 0;
 }
-EXPORT_SYMBOL(board_i2c_cpld_write);
+DEFINE_SHOW_ATTRIBUTE(cpld_stats);
 
 ssize_t regval_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
@@ -181,34 +242,35 @@ static void board_i2c_cpld_add_client(struct i2c_client *client)
 	dev_dbg(&client->dev, "Adding %s to the cpld client list\n", node->name);
 
 	mutex_lock(&list_lock);
-	list_add(&node->list, &cpld_client_list);
+	hash_add_rcu(cpld_client_hash, &node->node, client->addr);
 	mutex_unlock(&list_lock);
 }
 
 static void board_i2c_cpld_remove_client(struct i2c_client *client)
 {
-	struct list_head		*list_node = NULL;
 	struct cpld_client_node *cpld_node = NULL;
 	int found = 0;
 	
 	mutex_lock(&list_lock);
 
-	list_for_each(list_node, &cpld_client_list)
+	hash_for_each_possible(cpld_client_hash, cpld_node, node, client->addr)
 	{
-		cpld_node = list_entry(list_node, struct cpld_client_node, list);
-		
 		if (cpld_node->client == client) {
 			found = 1;
 			break;
 		}
 	}
 	
+	if (found)
+		hash_del_rcu(&cpld_node->node);
+	
+	mutex_unlock(&list_lock);
+
 	if (found) {
-		list_del(list_node);
+		/* Wait for the accesses still using the client */
+		synchronize_srcu(&cpld_client_srcu);
 		kfree(cpld_node);
 	}
-	
-	mutex_unlock(&list_lock);
 }
 
 static int board_i2c_cpld_probe(struct i2c_client *client,
@@ -269,13 +331,24 @@ static struct i2c_driver board_i2c_cpld_driver = {
 
 static int __init board_i2c_cpld_init(void)
 {
+	int ret;
+
 	mutex_init(&list_lock);
-	return i2c_add_driver(&board_i2c_cpld_driver);
+
+	cpld_debugfs_dir = debugfs_create_dir("pddf_cpld", NULL);
+	debugfs_create_file("stats", 0444, cpld_debugfs_dir, NULL, &cpld_stats_fops);
+
+	ret = i2c_add_driver(&board_i2c_cpld_driver);
+	if (ret)
+		debugfs_remove_recursive(cpld_debugfs_dir);
+
+	return ret;
 }
 
 static void __exit board_i2c_cpld_exit(void)
 {
 	i2c_del_driver(&board_i2c_cpld_driver);
+	debugfs_remove_recursive(cpld_debugfs_dir);
 }
 	
 MODULE_AUTHOR("Broadcom");
@@ -30,6 +30,7 @@
 #include <linux/dmi.h>
 #include "pddf_fan_defs.h"
 #include "pddf_fan_driver.h"
+#include "pddf_snapshot_defs.h"
 
 /*#define FAN_DEBUG*/
 #ifdef FAN_DEBUG
@@ -131,6 +132,7 @@ int fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR
 {
 	int status = 0;
     struct i2c_client *client = to_i2c_client(dev);
+    struct fan_data *data = i2c_get_clientdata(client);
 	FAN_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
 
 
@@ -157,6 +159,10 @@ int fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR
 			dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, udata->aname, status);
 	}
 
+    /* Read back the registers on the next access */
+    if (data->snapshot != NULL)
+        pddf_snapshot_invalidate(data->snapshot);
+
     mutex_unlock(&info->update_lock);
 
     return 0;
@@ -164,14 +170,25 @@ int fan_update_hw(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR
 
 int fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATTR *udata)
 {
-	int status = 0;
+	int status = 0, stale;
     struct i2c_client *client = to_i2c_client(dev);
+    struct fan_data *data = i2c_get_clientdata(client);
 	FAN_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
+    uint32_t seq = 0;
 
 
     mutex_lock(&info->update_lock);
 
-    if (time_after(jiffies, info->last_updated + HZ + HZ / 2) || !info->valid) 
+    if (info->snap_reg != NULL)
+    {
+        /* The registers of all the attributes are refreshed together */
+        seq = pddf_snapshot_update(data->snapshot);
+        stale = !info->valid || (info->snap_seq != seq);
+    }
+    else
+        stale = !info->valid || pddf_snapshot_expired(info->last_updated, PDDF_SNAPSHOT_FAN);
+
+    if (stale)
 	{
         dev_dbg(&client->dev, "Starting pddf_fan update\n");
         info->valid = 0;
@@ -198,6 +215,7 @@ int fan_update_attr(struct device *dev, struct fan_attr_info *info, FAN_DATA_ATT
 		}
 
 		
+        info->snap_seq = seq;
         info->last_updated = jiffies;
         info->valid = 1;
     }
@@ -549,6 +567,55 @@ int fan_fpgai2c_client_write(FAN_DATA_ATTR *udata, uint32_t val)
     return status;
 }
 
+/* Raw value of the register of a fan attribute, a byte or a big endian word */
+static int fan_read_hw(void *client, FAN_DATA_ATTR *udata, int word)
+{
+    if (strcmp(udata->devtype, "cpld") == 0)
+        return fan_cpld_client_read(udata);
+    else if (strcmp(udata->devtype, "fpgai2c") == 0)
+        return fan_fpgai2c_client_read(udata);
+    else if (word && (udata->len == 2))
+        return i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
+    else if (!word || (udata->len == 1))
+        return i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
+
+    return 0;
+}
+
+static int fan_read_reg(void *client, FAN_DATA_ATTR *udata, struct fan_attr_info *painfo, int word)
+{
+    struct fan_data *data = i2c_get_clientdata((struct i2c_client *)client);
+    uint8_t buf[2];
+    int status;
+
+    if (painfo->snap_reg == NULL)
+        return fan_read_hw(client, udata, word);
+
+    status = pddf_snapshot_read(data->snapshot, painfo->snap_reg, buf);
+    if (status < 0)
+        return status;
+
+    return (status == 2) ? ((buf[0] << 8) | buf[1]) : buf[0];
+}
+
+/* Fills the fan snapshot, the registers are kept in bus byte order */
+static int fan_snapshot_read(PDDF_SNAPSHOT_REG *reg, uint8_t *buf)
+{
+    int val = fan_read_hw(reg->client, (FAN_DATA_ATTR *)reg->data, (reg->len == 2));
+
+    if (val < 0)
+        return val;
+
+    if (reg->len == 2)
+    {
+        buf[0] = (val >> 8) & 0xff;
+        buf[1] = val & 0xff;
+    }
+    else
+        buf[0] = val & 0xff;
+
+    return 0;
+}
 
 int sonic_i2c_get_fan_present_default(void *client, FAN_DATA_ATTR *udata, void *info)
 {
@@ -556,18 +623,7 @@ int sonic_i2c_get_fan_present_default(void *client, FAN_DATA_ATTR *udata, void *
     int val = 0;
     struct fan_attr_info *painfo = (struct fan_attr_info *)info;
 
-    if (strcmp(udata->devtype, "cpld") == 0)
-    {
-        val = fan_cpld_client_read(udata);
-    }
-    else if (strcmp(udata->devtype, "fpgai2c") == 0)
-    {
-        val = fan_fpgai2c_client_read(udata);
-    }
-    else
-    {
-	    val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
-    }
+    val = fan_read_reg(client, udata, painfo, 0);
 	
 	if (val < 0)
 		status = val;
@@ -584,26 +640,7 @@ int sonic_i2c_get_fan_rpm_default(void *client, FAN_DATA_ATTR *udata, void *info
 	int val = 0;
     struct fan_attr_info *painfo = (struct fan_attr_info *)info;
 
-    if (strcmp(udata->devtype, "cpld") == 0)
-    {
-        val = fan_cpld_client_read(udata);
-    }
-    else if (strcmp(udata->devtype, "fpgai2c") == 0)
-    {
-        val = fan_fpgai2c_client_read(udata);
-    }
-    else
-    {
-        if (udata->len == 1)
-        {
-            val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
-        }
-        else if (udata->len ==2)
-        {
-            val = i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
-            
-        }
-    }
+    val = fan_read_reg(client, udata, painfo, 1);
 
 	if (val < 0)
 		status = val;
@@ -625,18 +662,7 @@ int sonic_i2c_get_fan_direction_default(void *client, FAN_DATA_ATTR *udata, void
 	int val = 0;
     struct fan_attr_info *painfo = (struct fan_attr_info *)info;
 
-    if (strcmp(udata->devtype, "cpld") == 0)
-    {
-        val = fan_cpld_client_read(udata);
-    }
-    else if (strcmp(udata->devtype, "fpgai2c") == 0)
-    {
-        val = fan_fpgai2c_client_read(udata);
-    }
-    else
-    {
-	    val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
-    }
+    val = fan_read_reg(client, udata, painfo, 0);
 
     if (val < 0)
         status = val;
@@ -696,26 +722,7 @@ int sonic_i2c_get_fan_pwm_default(void *client, FAN_DATA_ATTR *udata, void *info
 	int val = 0;
     struct fan_attr_info *painfo = (struct fan_attr_info *)info;
 
-    if (strcmp(udata->devtype, "cpld") == 0)
-    {
-        val = fan_cpld_client_read(udata);
-    }
-    else if (strcmp(udata->devtype, "fpgai2c") == 0)
-    {
-        val = fan_fpgai2c_client_read(udata);
-    }
-    else
-    {
-        if (udata->len == 1)
-        {
-            val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
-        }
-        else if (udata->len ==2)
-        {
-            val = i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
-            
-        }
-    }
+    val = fan_read_reg(client, udata, painfo, 1);
 
 	if (val < 0)
 		status = val;
@@ -734,18 +741,7 @@ int sonic_i2c_get_fan_fault_default(void *client, FAN_DATA_ATTR *udata, void *in
     struct fan_attr_info *painfo = (struct fan_attr_info *)info;
 
 	/*Assuming fan fault to be denoted by 1 byte only*/
-    if (strcmp(udata->devtype, "cpld") == 0)
-    {
-        val = fan_cpld_client_read(udata);
-    }
-    else if (strcmp(udata->devtype, "fpgai2c") == 0)
-    {
-        val = fan_fpgai2c_client_read(udata);
-    }
-    else
-    {
-	    val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
-    }
+    val = fan_read_reg(client, udata, painfo, 0);
 
 	if (val < 0)
 		status = val;
@@ -840,26 +836,7 @@ int sonic_i2c_get_fan_dc_default(void *client, FAN_DATA_ATTR *udata, void *info)
     uint32_t dc = 0;
     struct fan_attr_info *painfo = (struct fan_attr_info *)info;
 
-    if (strcmp(udata->devtype, "cpld") == 0)
-    {
-        val = fan_cpld_client_read(udata);
-    }
-    else if (strcmp(udata->devtype, "fpgai2c") == 0)
-    {
-        val = fan_fpgai2c_client_read(udata);
-    }
-    else
-    {
-        if (udata->len == 1)
-        {
-            val = i2c_smbus_read_byte_data((struct i2c_client *)client, udata->offset);
-        }
-        else if (udata->len ==2)
-        {
-            val = i2c_smbus_read_word_swapped((struct i2c_client *)client, udata->offset);
-
-        }
-    }
+    val = fan_read_reg(client, udata, painfo, 1);
 
 	if (val < 0)
 		status = val;
@@ -969,7 +946,7 @@ ssize_t fan_show_string(struct device *dev, struct device_attribute *da, char *b
 
     mutex_lock(&attr_info->update_lock);
 
-    if (time_after(jiffies, attr_info->last_updated + HZ + HZ / 2) || !attr_info->valid)
+    if (pddf_snapshot_expired(attr_info->last_updated, PDDF_SNAPSHOT_FAN) || !attr_info->valid)
 	{
         attr_info->valid = 0;
 
@@ -1020,6 +997,80 @@ exit:
     return sprintf(buf, "%s\n", attr_info->val.strval);
 }
 
+int fan_snapshot_init(struct i2c_client *client)
+{
+    struct fan_data *data = i2c_get_clientdata(client);
+    FAN_PDATA *pdata = (FAN_PDATA *)(client->dev.platform_data);
+    FAN_DATA_ATTR *udata = NULL;
+    FAN_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
+    int (*read_block)(unsigned short devaddr, u8 offset, u8 len, u8 *buf) = NULL;
+    int i, word, status;
+    uint32_t len;
+
+    data->snapshot = pddf_snapshot_create(client->name, PDDF_SNAPSHOT_FAN);
+    if (data->snapshot == NULL)
+        return -ENOMEM;
+
+    for (i=0;i<data->num_attr;i++)
+    {
+        udata = &pdata->fan_attrs[i];
+        sysfs_attr_data = (FAN_SYSFS_ATTR_DATA *)udata->access_data;
+
+        /* Attributes with a custom access are read directly */
+        if ((sysfs_attr_data == NULL) || (sysfs_attr_data->pre_get != NULL) || (udata->len < 1) || (udata->len > 2))
+            continue;
+
+        if ((sysfs_attr_data->do_get == sonic_i2c_get_fan_present_default) ||
+            (sysfs_attr_data->do_get == sonic_i2c_get_fan_direction_default) ||
+            (sysfs_attr_data->do_get == sonic_i2c_get_fan_fault_default))
+            word = 0;
+        else if ((sysfs_attr_data->do_get == sonic_i2c_get_fan_rpm_default) ||
+                 (sysfs_attr_data->do_get == sonic_i2c_get_fan_pwm_default) ||
+                 (sysfs_attr_data->do_get == sonic_i2c_get_fan_dc_default))
+            word = 1;
+        else
+            continue;
+
+        if ((strcmp(udata->devtype, "cpld") == 0) || (strcmp(udata->devtype, "fpgai2c") == 0))
+        {
+            len = udata->len;
+            /* CPLD registers can be block read, the CPLD driver looks the client up */
+            read_block = (strcmp(udata->devtype, "cpld") == 0) ? board_i2c_cpld_read_block : NULL;
+        }
+        else
+        {
+            len = (word && (udata->len == 2)) ? 2 : 1;
+            read_block = NULL;
+        }
+
+        data->attr_info[i].snap_reg = pddf_snapshot_add_reg(data->snapshot, client, udata->devaddr, udata->offset,
+                len, read_block, fan_snapshot_read, udata);
+    }
+
+    status = pddf_snapshot_create_file(data->snapshot, &client->dev.kobj);
+    if (status != 0)
+        dev_warn(&client->dev, "%s: Unable to create the snapshot attribute. ret %d\n", __FUNCTION__, status);
+
+    return 0;
+}
+
+void fan_snapshot_exit(struct i2c_client *client)
+{
+    struct fan_data *data = i2c_get_clientdata(client);
+    int i;
+
+    if (data->snapshot == NULL)
+        return;
+
+    for (i=0;i<data->num_attr;i++)
+        data->attr_info[i].snap_reg = NULL;
+
+    pddf_snapshot_remove_file(data->snapshot, &client->dev.kobj);
+    pddf_snapshot_destroy(data->snapshot);
+    data->snapshot = NULL;
+}
+
+
 int pddf_fan_post_probe_default(struct i2c_client *client, const struct i2c_device_id *dev_id)
 {
 
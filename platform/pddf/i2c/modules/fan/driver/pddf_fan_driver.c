@@ -516,6 +516,11 @@ static int pddf_fan_probe(struct i2c_client *client,
         goto exit_free;
     }
 
+    /* The registers behind the attributes are read together */
+    if (fan_snapshot_init(client) != 0) {
+        dev_warn(&client->dev, "%s: Registers are read per attribute\n", __FUNCTION__);
+    }
+
     data->hwmon_dev = hwmon_device_register_with_groups(&client->dev, client->name, NULL, NULL);
     if (IS_ERR(data->hwmon_dev)) {
         status = PTR_ERR(data->hwmon_dev);
@@ -536,6 +541,7 @@ static int pddf_fan_probe(struct i2c_client *client,
 	return 0;
 
 exit_remove:
+    fan_snapshot_exit(client);
     sysfs_remove_group(&client->dev.kobj, &data->fan_attribute_group);
 exit_free:
 	/* Free all the allocated attributes */
@@ -566,6 +572,7 @@ static void pddf_fan_remove(struct i2c_client *client)
 	}
 
     hwmon_device_unregister(data->hwmon_dev);
+    fan_snapshot_exit(client);
     sysfs_remove_group(&client->dev.kobj, &data->fan_attribute_group);
     for (i=0; data->fan_attribute_list[i]!=NULL; i++)
     {
@@ -29,10 +29,21 @@
 #include <linux/jiffies.h>
 #include <linux/errno.h>
 #include <linux/i2c.h>
+#include <linux/interrupt.h>
+#include <linux/completion.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "pddf_i2c_algo.h"
 
 #define DEBUG 0
 
+/* Transfer time histogram, bucket i counts the transfers below 64us << i */
+#define FPGAI2C_HIST_BUCKETS    16
+#define FPGAI2C_HIST_MIN_US     64
+
+static struct dentry *fpgai2c_debugfs_dir;
+
 enum {
     STATE_DONE = 0,
     STATE_INIT,
@@ -86,12 +97,25 @@ struct fpgalogic_i2c {
     u8 (*reg_get)(struct fpgalogic_i2c *i2c, int reg);
     u32 timeout;
     struct mutex lock;
+
+    int irq;            /* -1 when polling */
+    int active;         /* a transfer owns msg, under lock */
+    int ret;            /* result of the last state machine step */
+    struct completion done;
+    unsigned int poll_us;   /* one byte at bus_clock_khz */
+
+    struct dentry *debugfs;
+    u64 xfers;
+    u64 errors;
+    u64 timeouts;
+    u64 hist[FPGAI2C_HIST_BUCKETS];
 };
 static struct fpgalogic_i2c fpgalogic_i2c[I2C_PCI_MAX_BUS];
 extern void __iomem * fpga_ctl_addr;
 extern int (*ptr_fpgapci_read)(uint32_t);
 extern int (*ptr_fpgapci_write)(uint32_t, uint32_t);
 extern int (*pddf_i2c_pci_add_numbered_bus)(struct i2c_adapter *, int);
+extern int (*pddf_i2c_pci_del_numbered_bus)(struct i2c_adapter *, int);
 
 void i2c_get_mutex(struct fpgalogic_i2c *i2c)
 {
@@ -235,36 +259,149 @@ static int fpgai2c_poll(struct fpgalogic_i2c *i2c)
     return 0;
 }
 
+/*
+ * Threaded handler: the register accessors delay, and take the mutex. The
+ * vector may be shared by all the channels, only the flagged ones proceed.
+ */
+static irqreturn_t fpgai2c_isr(int irq, void *dev_id)
+{
+    struct fpgalogic_i2c *i2c = dev_id;
+    u8 stat = i2c->reg_get(i2c, FPGAI2C_REG_STATUS);
+    int ret;
+
+    if (!(stat & FPGAI2C_REG_STAT_IF))
+        return IRQ_NONE;
+
+    i2c_get_mutex(i2c);
+    if (!i2c->active) {
+        /* Stop of the previous transfer done */
+        fpgai2c_reg_set(i2c, FPGAI2C_REG_CMD, FPGAI2C_REG_CMD_IACK);
+    } else {
+        ret = fpgai2c_poll(i2c);
+        /*
+         * Moving on to the next message issues no command, hence raises no
+         * interrupt: send its start from here.
+         */
+        if (ret == 0 && i2c->state == STATE_ADDR)
+            ret = fpgai2c_poll(i2c);
+        if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR) {
+            i2c->ret = ret;
+            i2c->active = 0;
+            complete(&i2c->done);
+        }
+    }
+    i2c_release_mutex(i2c);
+
+    return IRQ_HANDLED;
+}
+
+/*
+ * Worst case duration of a transfer: the address and data bytes at the bus
+ * clock plus the register access delays, with some margin.
+ */
+static unsigned long fpgai2c_xfer_timeout(struct fpgalogic_i2c *i2c, struct i2c_msg *msgs, int num)
+{
+    unsigned long bytes = 0;
+    int i;
+
+    for (i = 0; i < num; i++)
+        bytes += msgs[i].len + 1;
+
+    return msecs_to_jiffies(1000) + usecs_to_jiffies(bytes * 4 * (i2c->poll_us + 300));
+}
+
+static void fpgai2c_account(struct fpgalogic_i2c *i2c, ktime_t start, int ret)
+{
+    s64 us = ktime_us_delta(ktime_get(), start);
+    int bucket = 0;
+
+    while ((bucket < FPGAI2C_HIST_BUCKETS - 1) && (us >= ((s64)FPGAI2C_HIST_MIN_US << bucket)))
+        bucket++;
+
+    i2c->xfers++;
+    i2c->hist[bucket]++;
+    if (ret == -ETIMEDOUT)
+        i2c->timeouts++;
+    else if (ret < 0)
+        i2c->errors++;
+}
+
 static int fpgai2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
 {
     struct fpgalogic_i2c *i2c = i2c_get_adapdata(adap);
-    int ret;
-    unsigned long timeout = jiffies + msecs_to_jiffies(1000);
+    int ret = 0, done, started;
+    long left;
+    ktime_t start = ktime_get();
+    unsigned long timeout = jiffies + fpgai2c_xfer_timeout(i2c, msgs, num);
 
+    i2c_get_mutex(i2c);
     i2c->msg = msgs;
     i2c->pos = 0;
     i2c->nmsgs = num;
     i2c->state = STATE_INIT;
+    reinit_completion(&i2c->done);
+    i2c->active = 1;
+    i2c_release_mutex(i2c);
 
      /* Handle the transfer */
      while (time_before(jiffies, timeout)) {
          i2c_get_mutex(i2c);
-         ret = fpgai2c_poll(i2c);
+         if (i2c->active) {
+             ret = fpgai2c_poll(i2c);
+             if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR) {
+                 i2c->ret = ret;
+                 i2c->active = 0;
+             }
+         } else {
+             /* Finished by the interrupt handler */
+             ret = i2c->ret;
+         }
+         done = !i2c->active;
+         started = (i2c->state != STATE_INIT);
          i2c_release_mutex(i2c);
 
-         if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR)
-              return (i2c->state == STATE_DONE) ? num : ret;
+         if (done) {
+              ret = (i2c->state == STATE_DONE) ? num : ret;
+              fpgai2c_account(i2c, start, ret);
+              return ret;
+         }
+
+         if (i2c->irq >= 0 && started) {
+              /* The interrupt handler runs the state machine from here */
+              left = (long)(timeout - jiffies);
+              if (left > 0)
+                  wait_for_completion_timeout(&i2c->done, left);
+              continue;
+         }
 
          if (ret == 0)
               timeout = jiffies + HZ;
 
-         usleep_range(5, 15);
+         usleep_range(i2c->poll_us, 2 * i2c->poll_us);
+     }
+
+     /*
+      * Keep the interrupt handler off the caller's messages, unless it
+      * finished the transfer as the timeout expired
+      */
+     i2c_get_mutex(i2c);
+     if (i2c->active) {
+         /* Release the bus if the transfer got onto it */
+         if (i2c->state != STATE_INIT)
+             fpgai2c_reg_set(i2c, FPGAI2C_REG_CMD, FPGAI2C_REG_CMD_STOP);
+         i2c->state = STATE_ERROR;
+         i2c->active = 0;
+         ret = -ETIMEDOUT;
+     } else {
+         ret = (i2c->state == STATE_DONE) ? num : i2c->ret;
      }
-     printk("[%s] ERROR STATE_ERROR\n", __FUNCTION__);
+     i2c_release_mutex(i2c);
 
-     i2c->state = STATE_ERROR;
+     if (ret == -ETIMEDOUT)
+         printk("[%s] ERROR STATE_ERROR\n", __FUNCTION__);
+     fpgai2c_account(i2c, start, ret);
 
-     return -ETIMEDOUT;
+     return ret;
 
 }
 
@@ -310,15 +447,75 @@ static int fpgai2c_init(struct fpgalogic_i2c *i2c)
     fpgai2c_reg_set(i2c, FPGAI2C_REG_PRELOW, prescale & 0xff);
     fpgai2c_reg_set(i2c, FPGAI2C_REG_PREHIGH, prescale >> 8);
 
+    /* Polling interval, 9 bit clocks per byte */
+    i2c->poll_us = DIV_ROUND_UP(9 * 1000, i2c->bus_clock_khz);
+
     /* Init the device */
     fpgai2c_reg_set(i2c, FPGAI2C_REG_CMD, FPGAI2C_REG_CMD_IACK);
+    /* Interrupt enabled only once the handler is installed */
+    ctrl &= ~FPGAI2C_REG_CTRL_IEN;
     fpgai2c_reg_set(i2c, FPGAI2C_REG_CONTROL, ctrl | FPGAI2C_REG_CTRL_EN);
 
     /* Initialize interrupt handlers if not already done */
     init_waitqueue_head(&i2c->wait);
+    init_completion(&i2c->done);
+    return 0;
+}
+
+static int fpgai2c_request_irq(struct fpgalogic_i2c *i2c, int irq, const char *name)
+{
+    int ret;
+    u8 ctrl;
+
+    ret = request_threaded_irq(irq, NULL, fpgai2c_isr, IRQF_SHARED | IRQF_ONESHOT, name, i2c);
+    if (ret) {
+        printk("[%s] ERROR %s: unable to request irq %d, polling. ret %d\n", __FUNCTION__, name, irq, ret);
+        return ret;
+    }
+
+    i2c_get_mutex(i2c);
+    i2c->irq = irq;
+    ctrl = fpgai2c_reg_get(i2c, FPGAI2C_REG_CONTROL);
+    fpgai2c_reg_set(i2c, FPGAI2C_REG_CONTROL, ctrl | FPGAI2C_REG_CTRL_IEN);
+    i2c_release_mutex(i2c);
+
     return 0;
 }
 
+static void fpgai2c_free_irq(struct fpgalogic_i2c *i2c)
+{
+    int irq = i2c->irq;
+    u8 ctrl;
+
+    if (irq < 0)
+        return;
+
+    i2c_get_mutex(i2c);
+    ctrl = fpgai2c_reg_get(i2c, FPGAI2C_REG_CONTROL);
+    fpgai2c_reg_set(i2c, FPGAI2C_REG_CONTROL, ctrl & ~FPGAI2C_REG_CTRL_IEN);
+    i2c->irq = -1;
+    i2c_release_mutex(i2c);
+
+    free_irq(irq, i2c);
+}
+
+static int fpgai2c_stats_show(struct seq_file *m, void *v)
+{
+    struct fpgalogic_i2c *i2c = m->private;
+    int i;
+
+    seq_printf(m, "mode: %s\n", (i2c->irq >= 0) ? "irq" : "poll");
+    seq_printf(m, "xfers: %llu\n", i2c->xfers);
+    seq_printf(m, "errors: %llu\n", i2c->errors);
+    seq_printf(m, "timeouts: %llu\n", i2c->timeouts);
+    for (i = 0; i < FPGAI2C_HIST_BUCKETS - 1; i++)
+        seq_printf(m, "<%uus: %llu\n", FPGAI2C_HIST_MIN_US << i, i2c->hist[i]);
+    seq_printf(m, ">=%uus: %llu\n", FPGAI2C_HIST_MIN_US << (FPGAI2C_HIST_BUCKETS - 2), i2c->hist[i]);
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fpgai2c_stats);
+
 static int adap_data_init(struct i2c_adapter *adap, int i2c_ch_index)
 {
     struct fpgapci_devdata *pci_privdata = 0;
@@ -353,9 +550,16 @@ static int adap_data_init(struct i2c_adapter *adap, int i2c_ch_index)
     fpgalogic_i2c[i2c_ch_index].bus_clock_khz = 100;
     fpgalogic_i2c[i2c_ch_index].base = pci_privdata->fpga_i2c_ch_base_addr +
                           i2c_ch_index* pci_privdata->fpga_i2c_ch_size;
+    fpgalogic_i2c[i2c_ch_index].irq = -1;
     mutex_init(&fpgalogic_i2c[i2c_ch_index].lock);
     fpgai2c_init(&fpgalogic_i2c[i2c_ch_index]);
 
+    /* Only set with pddf_fpgapci_driver use_irq=1 */
+    if (pci_privdata->irq >= 0)
+        fpgai2c_request_irq(&fpgalogic_i2c[i2c_ch_index], pci_privdata->irq, adap->name);
+
+    fpgalogic_i2c[i2c_ch_index].debugfs = debugfs_create_file(adap->name, 0444, fpgai2c_debugfs_dir,
+            &fpgalogic_i2c[i2c_ch_index], &fpgai2c_stats_fops);
 
     adap->algo_data = &fpgalogic_i2c[i2c_ch_index];
     i2c_set_adapdata(adap, &fpgalogic_i2c[i2c_ch_index]);
@@ -373,6 +577,21 @@ static int pddf_i2c_pci_add_numbered_bus_default (struct i2c_adapter *adap, int
     return ret;
 }
 
+static int pddf_i2c_pci_del_numbered_bus_default (struct i2c_adapter *adap, int i2c_ch_index)
+{
+    struct fpgalogic_i2c *i2c = i2c_get_adapdata(adap);
+
+    i2c_del_adapter(adap);
+
+    if (i2c) {
+        fpgai2c_free_irq(i2c);
+        debugfs_remove(i2c->debugfs);
+        i2c->debugfs = NULL;
+    }
+
+    return 0;
+}
+
 /*
  * FPGAPCI APIs
  */
@@ -394,7 +613,9 @@ int board_i2c_fpgapci_write(uint32_t offset, uint32_t value)
 static int __init pddf_xilinx_device_7021_algo_init(void)
 {
     pddf_dbg(FPGA, KERN_INFO "[%s]\n", __FUNCTION__);
+    fpgai2c_debugfs_dir = debugfs_create_dir("pddf_fpgai2c", NULL);
     pddf_i2c_pci_add_numbered_bus = pddf_i2c_pci_add_numbered_bus_default;
+    pddf_i2c_pci_del_numbered_bus = pddf_i2c_pci_del_numbered_bus_default;
     ptr_fpgapci_read = board_i2c_fpgapci_read;
     ptr_fpgapci_write = board_i2c_fpgapci_write;
     return 0;
@@ -405,8 +626,10 @@ static void __exit pddf_xilinx_device_7021_algo_exit(void)
     pddf_dbg(FPGA, KERN_INFO "[%s]\n", __FUNCTION__);
 
     pddf_i2c_pci_add_numbered_bus = NULL;
+    pddf_i2c_pci_del_numbered_bus = NULL;
     ptr_fpgapci_read = NULL;
     ptr_fpgapci_write = NULL;
+    debugfs_remove_recursive(fpgai2c_debugfs_dir);
     return;
 }
 
@@ -58,9 +58,11 @@
 
 #define DEBUG 0
 int (*pddf_i2c_pci_add_numbered_bus)(struct i2c_adapter *, int) = NULL;
+int (*pddf_i2c_pci_del_numbered_bus)(struct i2c_adapter *, int) = NULL;
 int (*ptr_fpgapci_read)(uint32_t) = NULL;
 int (*ptr_fpgapci_write)(uint32_t, uint32_t) = NULL;
 EXPORT_SYMBOL(pddf_i2c_pci_add_numbered_bus);
+EXPORT_SYMBOL(pddf_i2c_pci_del_numbered_bus);
 EXPORT_SYMBOL(ptr_fpgapci_read);
 EXPORT_SYMBOL(ptr_fpgapci_write);
 
@@ -77,6 +79,15 @@ int FPGAPCI_BAR_INDEX = -1;
 void __iomem * fpga_ctl_addr = NULL;
 EXPORT_SYMBOL(fpga_ctl_addr);
 
+/* Renamed in 6.8, the old name is gone from later kernels */
+#ifndef PCI_IRQ_INTX
+#define PCI_IRQ_INTX PCI_IRQ_LEGACY
+#endif
+
+static bool use_irq = false;
+module_param(use_irq, bool, 0444);
+MODULE_PARM_DESC(use_irq, "Complete the i2c transfers from the FPGA interrupt instead of polling");
+
 static int pddf_fpgapci_probe(struct pci_dev *dev, const struct pci_device_id *id);
 static void pddf_fpgapci_remove(struct pci_dev *dev);
 static int map_bars(struct fpgapci_devdata *pci_privdata, struct pci_dev *dev);
@@ -127,7 +138,11 @@ static void pddf_pci_del_adapter(void)
 {
 	int i;
 	for( i = 0; i < total_i2c_pci_bus; i++ ){
-		i2c_del_adapter(&i2c_pci_adap[i]);
+		/* Let the algorithm layer release what it added with the bus */
+		if (pddf_i2c_pci_del_numbered_bus != NULL)
+			pddf_i2c_pci_del_numbered_bus(&i2c_pci_adap[i], i);
+		else
+			i2c_del_adapter(&i2c_pci_adap[i]);
 	}
 }
 
@@ -245,6 +260,15 @@ static int pddf_fpgapci_probe(struct pci_dev *dev, const struct pci_device_id *i
         pddf_dbg(FPGA, KERN_ERR "error_map_bars\n");
         goto error_map_bars;
     }
+
+    /* One vector, shared by the i2c channels. Polling needs none, leave
+     * MSI off so as not to change the device setup of existing platforms
+     */
+    pci_privdata->irq = -1;
+    if (use_irq && pci_alloc_irq_vectors(dev, 1, 1, PCI_IRQ_MSI | PCI_IRQ_INTX) > 0)
+        pci_privdata->irq = pci_irq_vector(dev, 0);
+    pddf_dbg(FPGA, KERN_INFO "[%s] irq=%d\n", __FUNCTION__, pci_privdata->irq);
+
     pddf_pci_add_adapter(dev);
 	return (0);
 
@@ -274,6 +298,8 @@ static void pddf_fpgapci_remove(struct pci_dev *dev)
 	}
 
 	pddf_pci_del_adapter();
+	if (pci_privdata->irq >= 0)
+		pci_free_irq_vectors(dev);
 	free_bars (pci_privdata, dev);
 	pci_disable_device(dev);
 	pci_release_regions(dev);
@@ -0,0 +1,672 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Userspace test of the FPGAPCI driver and the Xilinx 7021 i2c algorithm
+ *  against a register model of the i2c master channels: probe and remove,
+ *  polled and interrupt driven transfers, shared and spurious interrupts,
+ *  timeouts racing the interrupt handler
+ */
+
+#include "../algos/pddf_xilinx_device_7021_algo.c"
+#include "fpgapci_test.h"
+
+#define TEST_IRQ            77
+#define TEST_SLAVE          0x50
+
+/* Commands and status, as the algorithm writes and reads them */
+#define CMD_STA             0x80
+#define CMD_STO             0x40
+#define CMD_RD              0x20
+#define CMD_WR              0x10
+#define CMD_IACK            0x01
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+unsigned long jiffies = 1000;
+
+/* Register model of one i2c master channel and the slave behind it. A
+ * command completes as soon as it is written: TIP never shows unless the
+ * channel is stuck, and IF rises right away. An IF rising edge with IEN set
+ * is one MSI message, the interrupt does not repeat while IF stays set.
+ */
+struct model_ch {
+    u8 prelow, prehigh, ctrl, data, status;
+    int stuck;          /* commands never complete */
+    int edge;           /* MSI message pending */
+    int cmds, iacks;
+    int addressed, wr_bytes;
+    u8 ptr, mem[256];
+};
+
+static struct model_ch model[NUM_CH];
+static u8 bar[BAR_LEN];
+
+static struct model_ch *model_decode(const void __iomem *addr, int *reg)
+{
+    long off = (const u8 *)addr - bar - I2C_CH_BASE_OFFSET;
+
+    if ((off < 0) || (off >= NUM_CH * I2C_CH_SIZE))
+        return NULL;
+    *reg = off % I2C_CH_SIZE;
+    return &model[off / I2C_CH_SIZE];
+}
+
+static void model_cmd(struct model_ch *ch, u8 cmd)
+{
+    ch->cmds++;
+    if (cmd & CMD_IACK)
+    {
+        ch->status &= ~FPGAI2C_REG_STAT_IF;
+        ch->iacks++;
+    }
+
+    if (!(cmd & (CMD_STA | CMD_STO | CMD_RD | CMD_WR)))
+        return;
+
+    if (ch->stuck)
+    {
+        ch->status |= FPGAI2C_REG_STAT_TIP | FPGAI2C_REG_STAT_BUSY;
+        return;
+    }
+
+    if (cmd & CMD_STA)
+    {
+        /* Start and address byte */
+        ch->status |= FPGAI2C_REG_STAT_BUSY;
+        ch->addressed = ((ch->data >> 1) == TEST_SLAVE);
+        ch->wr_bytes = 0;
+        ch->status = ch->addressed ? (ch->status & ~FPGAI2C_REG_STAT_NACK) : (ch->status | FPGAI2C_REG_STAT_NACK);
+    }
+    else if (cmd & CMD_WR)
+    {
+        /* First byte written sets the pointer */
+        if (ch->wr_bytes++ == 0)
+            ch->ptr = ch->data;
+        else
+            ch->mem[ch->ptr++] = ch->data;
+    }
+    else if (cmd & CMD_RD)
+    {
+        ch->data = ch->mem[ch->ptr++];
+    }
+
+    if (cmd & CMD_STO)
+    {
+        ch->status &= ~FPGAI2C_REG_STAT_BUSY;
+        ch->addressed = 0;
+    }
+
+    if (!(ch->status & FPGAI2C_REG_STAT_IF) && (ch->ctrl & FPGAI2C_REG_CTRL_IEN))
+        ch->edge = 1;
+    ch->status |= FPGAI2C_REG_STAT_IF;
+}
+
+u8 ioread8(const void __iomem *addr)
+{
+    struct model_ch *ch;
+    int reg = -1;
+
+    ch = model_decode(addr, &reg);
+    CHECK(ch != NULL);
+    switch (reg)
+    {
+        case FPGAI2C_REG_PRELOW:
+            return ch->prelow;
+        case FPGAI2C_REG_PREHIGH:
+            return ch->prehigh;
+        case FPGAI2C_REG_CONTROL:
+            return ch->ctrl;
+        case FPGAI2C_REG_DATA:
+            return ch->data;
+        case FPGAI2C_REG_STATUS:
+            return ch->status;
+    }
+    return 0xff;
+}
+
+void iowrite8(u8 value, void __iomem *addr)
+{
+    struct model_ch *ch;
+    int reg = -1;
+
+    ch = model_decode(addr, &reg);
+    CHECK(ch != NULL);
+    switch (reg)
+    {
+        case FPGAI2C_REG_PRELOW:
+            ch->prelow = value;
+            break;
+        case FPGAI2C_REG_PREHIGH:
+            ch->prehigh = value;
+            break;
+        case FPGAI2C_REG_CONTROL:
+            ch->ctrl = value;
+            break;
+        case FPGAI2C_REG_DATA:
+            ch->data = value;
+            break;
+        case FPGAI2C_REG_CMD:
+            model_cmd(ch, value);
+            break;
+    }
+}
+
+u32 ioread32(const void __iomem *addr)
+{
+    return 0;
+}
+
+void iowrite32(u32 value, void __iomem *addr)
+{
+}
+
+/* Mock PCI device, one memory BAR */
+static struct pci_dev pci_dev = { .dev = { .kobj = { "0000:07:00.0" } } };
+static struct pci_driver *pci_driver_registered;
+static int irq_vectors;
+
+int pci_enable_device(struct pci_dev *dev) { return 0; }
+void pci_disable_device(struct pci_dev *dev) { }
+void pci_set_master(struct pci_dev *dev) { }
+int pci_request_regions(struct pci_dev *dev, const char *name) { return 0; }
+void pci_release_regions(struct pci_dev *dev) { }
+
+unsigned long pci_resource_start(struct pci_dev *dev, int bar)
+{
+    return (bar == 0) ? BAR_START : 0;
+}
+
+unsigned long pci_resource_end(struct pci_dev *dev, int bar)
+{
+    return (bar == 0) ? BAR_START + BAR_LEN - 1 : 0;
+}
+
+unsigned long pci_resource_len(struct pci_dev *dev, int bar)
+{
+    return (bar == 0) ? BAR_LEN : 0;
+}
+
+unsigned long pci_resource_flags(struct pci_dev *dev, int bar)
+{
+    return IORESOURCE_MEM;
+}
+
+int pci_read_config_byte(const struct pci_dev *dev, int where, u8 *val)
+{
+    *val = 0;
+    return 0;
+}
+
+int pci_read_config_word(const struct pci_dev *dev, int where, u16 *val)
+{
+    *val = 0;
+    return 0;
+}
+
+int pci_alloc_irq_vectors(struct pci_dev *dev, unsigned int min_vecs, unsigned int max_vecs,
+                          unsigned int flags)
+{
+    CHECK(min_vecs == 1 && max_vecs == 1);
+    CHECK(flags & PCI_IRQ_MSI);
+    irq_vectors = 1;
+    return 1;
+}
+
+int pci_irq_vector(struct pci_dev *dev, unsigned int nr)
+{
+    return TEST_IRQ;
+}
+
+void pci_free_irq_vectors(struct pci_dev *dev)
+{
+    irq_vectors = 0;
+}
+
+int pci_register_driver(struct pci_driver *drv)
+{
+    pci_driver_registered = drv;
+    return 0;
+}
+
+void pci_unregister_driver(struct pci_driver *drv)
+{
+    pci_driver_registered = NULL;
+}
+
+void __iomem *ioremap_cache(unsigned long offset, unsigned long size)
+{
+    CHECK(offset >= BAR_START && offset + size <= BAR_START + BAR_LEN);
+    return bar + (offset - BAR_START);
+}
+
+void pci_iounmap(struct pci_dev *dev, void __iomem *addr)
+{
+}
+
+/* Mock i2c core and debugfs */
+static int adapters, debugfs_files;
+static struct dentry debugfs_dir = { "pddf_fpgai2c" };
+static struct dentry debugfs_file = { "i2c-pci" };
+
+int i2c_add_numbered_adapter(struct i2c_adapter *adap)
+{
+    adapters++;
+    return 0;
+}
+
+void i2c_del_adapter(struct i2c_adapter *adap)
+{
+    adapters--;
+}
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent)
+{
+    return &debugfs_dir;
+}
+
+struct dentry *debugfs_create_file(const char *name, unsigned short mode, struct dentry *parent,
+                                   void *data, const struct file_operations *fops)
+{
+    CHECK(parent == &debugfs_dir);
+    debugfs_files++;
+    return &debugfs_file;
+}
+
+void debugfs_remove(struct dentry *dentry)
+{
+    if (dentry)
+        debugfs_files--;
+}
+
+void debugfs_remove_recursive(struct dentry *dentry)
+{
+}
+
+/* Mock interrupt controller, all the channels share TEST_IRQ */
+static struct {
+    irq_handler_t thread_fn;
+    void *dev_id;
+} irq_actions[NUM_CH];
+static int irq_requested, irq_handled, irq_none;
+
+int request_threaded_irq(unsigned int irq, irq_handler_t handler, irq_handler_t thread_fn,
+                         unsigned long flags, const char *name, void *dev_id)
+{
+    CHECK(irq == TEST_IRQ);
+    CHECK(handler == NULL);
+    CHECK(flags == (IRQF_SHARED | IRQF_ONESHOT));
+    CHECK(irq_requested < NUM_CH);
+    irq_actions[irq_requested].thread_fn = thread_fn;
+    irq_actions[irq_requested].dev_id = dev_id;
+    irq_requested++;
+    return 0;
+}
+
+void free_irq(unsigned int irq, void *dev_id)
+{
+    int i;
+
+    for (i = 0; i < irq_requested; i++)
+    {
+        if (irq_actions[i].dev_id == dev_id)
+        {
+            irq_actions[i] = irq_actions[--irq_requested];
+            return;
+        }
+    }
+    CHECK(0);
+}
+
+/* One interrupt of the shared vector: every handler runs, as the kernel does */
+static void irq_fire(void)
+{
+    struct fpgalogic_i2c *i2c;
+    int i;
+
+    for (i = 0; i < irq_requested; i++)
+    {
+        i2c = irq_actions[i].dev_id;
+        /* The handler must not run while the caller holds the channel */
+        CHECK(i2c->lock.locked == 0);
+        if (irq_actions[i].thread_fn(TEST_IRQ, i2c) == IRQ_HANDLED)
+            irq_handled++;
+        else
+            irq_none++;
+    }
+}
+
+/* Deliver the pending MSI messages until the channels are quiet */
+static void irq_deliver(void)
+{
+    int i, pending;
+
+    do
+    {
+        pending = 0;
+        for (i = 0; i < NUM_CH; i++)
+        {
+            pending |= model[i].edge;
+            model[i].edge = 0;
+        }
+        if (pending)
+            irq_fire();
+    } while (pending);
+}
+
+/* What happens while fpgai2c_xfer sleeps on the completion */
+enum {
+    WAIT_IRQ,       /* the interrupts are delivered */
+    WAIT_TIMEOUT,   /* nothing arrives before the timeout */
+    WAIT_RACE,      /* the handler finishes as the timeout expires */
+};
+
+static int wait_mode;
+static int waits, sleeps;
+static unsigned long sleep_min, sleep_max;
+
+unsigned long wait_for_completion_timeout(struct completion *x, unsigned long timeout)
+{
+    waits++;
+    if (wait_mode != WAIT_TIMEOUT)
+        irq_deliver();
+    if ((wait_mode == WAIT_IRQ) && x->done)
+        return timeout;
+    jiffies += timeout;
+    return 0;
+}
+
+void usleep_range(unsigned long min, unsigned long max)
+{
+    sleeps++;
+    sleep_min = min;
+    sleep_max = max;
+    jiffies += usecs_to_jiffies(min);
+}
+
+/* Devices */
+static void probe(int irq)
+{
+    int i;
+
+    memset(model, 0, sizeof(model));
+    for (i = 0; i < NUM_CH; i++)
+    {
+        model[i].ctrl = FPGAI2C_REG_CTRL_IEN;
+        model[i].mem[0x10] = 0xa0 + i;
+        model[i].mem[0x11] = 0xb0 + i;
+    }
+
+    CHECK(pddf_xilinx_device_7021_algo_init() == 0);
+    CHECK(fpgapci_test_init(irq) == 0);
+    CHECK(pci_driver_registered != NULL);
+    CHECK(pci_driver_registered->probe(&pci_dev, pci_driver_registered->id_table) == 0);
+    CHECK(adapters == NUM_CH);
+    CHECK(debugfs_files == NUM_CH);
+}
+
+static void remove_all(void)
+{
+    pci_driver_registered->remove(&pci_dev);
+    fpgapci_test_exit();
+    pddf_xilinx_device_7021_algo_exit();
+    CHECK(adapters == 0);
+    CHECK(debugfs_files == 0);
+    CHECK(irq_requested == 0);
+    CHECK(irq_vectors == 0);
+}
+
+static void counters_reset(void)
+{
+    int i;
+
+    irq_handled = irq_none = waits = sleeps = 0;
+    for (i = 0; i < NUM_CH; i++)
+        model[i].cmds = model[i].iacks = 0;
+}
+
+/* Register offset write then repeated start read, as an SMBus byte/word read */
+static int read_regs(int ch, u8 offset, u8 *buf, int len)
+{
+    struct i2c_msg msgs[2] = {
+        { .addr = TEST_SLAVE, .flags = 0, .len = 1, .buf = &offset },
+        { .addr = TEST_SLAVE, .flags = I2C_M_RD, .len = len, .buf = buf },
+    };
+
+    struct i2c_adapter *adap = fpgapci_test_adapter(ch);
+
+    return adap->algo->master_xfer(adap, msgs, 2);
+}
+
+static int write_regs(int ch, u16 addr, u8 offset, u8 value)
+{
+    u8 buf[2] = { offset, value };
+    struct i2c_msg msg = { .addr = addr, .flags = 0, .len = 2, .buf = buf };
+
+    struct i2c_adapter *adap = fpgapci_test_adapter(ch);
+
+    return adap->algo->master_xfer(adap, &msg, 1);
+}
+
+static const char *stats(int ch)
+{
+    static struct seq_file m;
+
+    memset(&m, 0, sizeof(m));
+    m.private = &fpgalogic_i2c[ch];
+    fpgai2c_stats_show(&m, NULL);
+    return m.buf;
+}
+
+/* Probe programs the prescaler, leaves the interrupt off unless use_irq */
+static void test_probe_poll(void)
+{
+    int i;
+
+    probe(0);
+    CHECK(irq_vectors == 0);
+    CHECK(irq_requested == 0);
+    for (i = 0; i < NUM_CH; i++)
+    {
+        CHECK(fpgalogic_i2c[i].irq == -1);
+        /* 100MHz / (5 * 100kHz) - 1 */
+        CHECK(model[i].prelow == 199 && model[i].prehigh == 0);
+        CHECK(model[i].ctrl == FPGAI2C_REG_CTRL_EN);
+        CHECK(strstr(stats(i), "mode: poll\n") != NULL);
+    }
+    remove_all();
+}
+
+static void test_probe_irq(void)
+{
+    int i;
+
+    probe(1);
+    CHECK(irq_vectors == 1);
+    CHECK(irq_requested == NUM_CH);
+    for (i = 0; i < NUM_CH; i++)
+    {
+        CHECK(fpgalogic_i2c[i].irq == TEST_IRQ);
+        CHECK(model[i].ctrl == (FPGAI2C_REG_CTRL_EN | FPGAI2C_REG_CTRL_IEN));
+        CHECK(strstr(stats(i), "mode: irq\n") != NULL);
+    }
+    remove_all();
+    for (i = 0; i < NUM_CH; i++)
+        CHECK(model[i].ctrl == FPGAI2C_REG_CTRL_EN);
+}
+
+/* Polling sleeps one byte time of the bus clock between the steps */
+static void test_poll_interval(void)
+{
+    struct fpgalogic_i2c *i2c = &fpgalogic_i2c[0];
+    struct i2c_msg small = { .addr = TEST_SLAVE, .len = 1 };
+    struct i2c_msg large = { .addr = TEST_SLAVE, .len = 255 };
+    u8 buf[2] = { 0 };
+
+    probe(0);
+    counters_reset();
+    CHECK(read_regs(0, 0x10, buf, 2) == 2);
+    CHECK(buf[0] == 0xa0 && buf[1] == 0xb0);
+    CHECK(waits == 0);
+    CHECK(sleeps > 0);
+    /* 9 bit clocks at 100kHz */
+    CHECK(i2c->poll_us == 90);
+    CHECK(sleep_min == 90 && sleep_max == 180);
+
+    /* 400kHz */
+    i2c->bus_clock_khz = 400;
+    CHECK(fpgai2c_init(i2c) == 0);
+    CHECK(model[0].prelow == 49);
+    CHECK(i2c->poll_us == 23);
+    counters_reset();
+    CHECK(read_regs(0, 0x11, buf, 1) == 2);
+    CHECK(buf[0] == 0xb0);
+    CHECK(sleep_min == 23 && sleep_max == 46);
+
+    /* The transfer timeout grows with the bytes to move */
+    CHECK(fpgai2c_xfer_timeout(i2c, &large, 1) > fpgai2c_xfer_timeout(i2c, &small, 1));
+    CHECK(fpgai2c_xfer_timeout(i2c, &small, 1) >= msecs_to_jiffies(1000));
+    remove_all();
+}
+
+/* The handler runs the state machine, the caller only starts it and sleeps */
+static void test_irq_completion(void)
+{
+    u8 buf[2] = { 0 };
+
+    probe(1);
+    wait_mode = WAIT_IRQ;
+    counters_reset();
+    CHECK(read_regs(1, 0x10, buf, 2) == 2);
+    CHECK(buf[0] == 0xa1 && buf[1] == 0xb1);
+    CHECK(sleeps == 0);
+    CHECK(waits == 1);
+    CHECK(irq_handled > 0);
+    /* The stop raised one more interrupt, acknowledged with no transfer */
+    CHECK(!(model[1].status & FPGAI2C_REG_STAT_IF));
+    CHECK(!fpgalogic_i2c[1].active);
+
+    counters_reset();
+    CHECK(write_regs(1, TEST_SLAVE, 0x20, 0x5a) == 1);
+    CHECK(model[1].mem[0x20] == 0x5a);
+    CHECK(waits == 1);
+
+    /* No ack from the address, the transfer fails without a timeout */
+    CHECK(write_regs(1, TEST_SLAVE + 1, 0x20, 0x00) == -ENXIO);
+    CHECK(model[1].mem[0x20] == 0x5a);
+
+    CHECK(strstr(stats(1), "xfers: 3\nerrors: 1\ntimeouts: 0\n") != NULL);
+    CHECK(strstr(stats(0), "xfers: 0\n") != NULL);
+    remove_all();
+}
+
+/* The vector is shared, the channels without IF decline it */
+static void test_irq_shared(void)
+{
+    u8 buf[1] = { 0 };
+
+    probe(1);
+    counters_reset();
+
+    /* Spurious: no channel flagged, nothing touched */
+    irq_fire();
+    CHECK(irq_none == NUM_CH);
+    CHECK(irq_handled == 0);
+    CHECK(model[0].cmds == 0 && model[1].cmds == 0);
+
+    /* Only channel 0 transfers, channel 1 declines every interrupt */
+    wait_mode = WAIT_IRQ;
+    counters_reset();
+    CHECK(read_regs(0, 0x10, buf, 1) == 2);
+    CHECK(buf[0] == 0xa0);
+    CHECK(irq_handled > 0);
+    CHECK(irq_none == irq_handled);
+    CHECK(model[1].cmds == 0);
+
+    /* A stale IF with no transfer is acknowledged only */
+    model[0].status |= FPGAI2C_REG_STAT_IF;
+    counters_reset();
+    irq_fire();
+    CHECK(irq_handled == 1 && irq_none == 1);
+    CHECK(model[0].iacks == 1 && model[0].cmds == 1);
+    CHECK(!(model[0].status & FPGAI2C_REG_STAT_IF));
+    remove_all();
+}
+
+/* Timeouts, and the handler showing up around them */
+static void test_irq_timeout_race(void)
+{
+    u8 buf[2] = { 0x55, 0x55 };
+
+    probe(1);
+
+    /* The interrupts arrive only after the caller gave up: the late
+     * handler must leave the caller's messages alone
+     */
+    wait_mode = WAIT_TIMEOUT;
+    counters_reset();
+    CHECK(read_regs(0, 0x10, buf, 2) == -ETIMEDOUT);
+    CHECK(waits > 0);
+    CHECK(!fpgalogic_i2c[0].active);
+    irq_deliver();
+    CHECK(irq_handled > 0);
+    CHECK(buf[0] == 0x55 && buf[1] == 0x55);
+    CHECK(model[0].iacks > 0);
+    CHECK(strstr(stats(0), "timeouts: 1\n") != NULL);
+
+    /* The handler finishes the transfer as the timeout expires: done */
+    wait_mode = WAIT_RACE;
+    counters_reset();
+    CHECK(read_regs(0, 0x10, buf, 2) == 2);
+    CHECK(buf[0] == 0xa0 && buf[1] == 0xb0);
+    CHECK(strstr(stats(0), "xfers: 2\nerrors: 0\ntimeouts: 1\n") != NULL);
+
+    /* Stuck channel: no interrupt ever, the state machine never finishes */
+    wait_mode = WAIT_IRQ;
+    model[0].stuck = 1;
+    counters_reset();
+    CHECK(read_regs(0, 0x10, buf, 2) == -ETIMEDOUT);
+    CHECK(irq_handled == 0);
+    CHECK(strstr(stats(0), "timeouts: 2\n") != NULL);
+    model[0].stuck = 0;
+    remove_all();
+}
+
+int main(void)
+{
+    test_probe_poll();
+    test_probe_irq();
+    test_poll_interval();
+    test_irq_completion();
+    test_irq_shared();
+    test_irq_timeout_race();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pddf fpgai2c: all tests passed\n");
+    return 0;
+}
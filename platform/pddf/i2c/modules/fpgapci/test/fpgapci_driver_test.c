@@ -0,0 +1,50 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  The FPGAPCI driver in a translation unit of its own, as the module is:
+ *  it and the algorithm both define __STDC_WANT_LIB_EXT1__
+ */
+
+#include "../driver/pddf_fpgapci_driver.c"
+#include "fpgapci_test.h"
+
+static FPGA_OPS_DATA ops = {
+    .vendor_id = 0x10ee,
+    .device_id = 0x7021,
+    .virt_bus = 0x10,
+    .virt_i2c_ch = NUM_CH,
+    .data_base_offset = DATA_BASE_OFFSET,
+    .data_size = DATA_SIZE,
+    .i2c_ch_base_offset = I2C_CH_BASE_OFFSET,
+    .i2c_ch_size = I2C_CH_SIZE,
+};
+
+int fpgapci_test_init(bool irq)
+{
+    use_irq = irq;
+    pddf_fpgapci_driver_init();
+    return pddf_fpgapci_register(&ops);
+}
+
+void fpgapci_test_exit(void)
+{
+    pddf_fpgapci_driver_exit();
+}
+
+struct i2c_adapter *fpgapci_test_adapter(int ch)
+{
+    return &i2c_pci_adap[ch];
+}
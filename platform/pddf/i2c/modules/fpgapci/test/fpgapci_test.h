@@ -0,0 +1,37 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Mock FPGA of the fpgapci tests, and the entry points of the driver
+ *  built in fpgapci_driver_test.c
+ */
+
+#ifndef __FPGAPCI_TEST_H__
+#define __FPGAPCI_TEST_H__
+
+#define NUM_CH              2
+#define BAR_START           0xf0000000UL
+#define BAR_LEN             0x10000
+#define DATA_BASE_OFFSET    0x0
+#define DATA_SIZE           0x1000
+#define I2C_CH_BASE_OFFSET  0x1000
+#define I2C_CH_SIZE         0x100
+
+/* Load the driver with use_irq and register the mock FPGA */
+int fpgapci_test_init(bool irq);
+void fpgapci_test_exit(void);
+struct i2c_adapter *fpgapci_test_adapter(int ch);
+
+#endif
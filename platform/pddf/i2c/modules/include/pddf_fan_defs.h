@@ -93,6 +93,7 @@ struct pddf_fan_ops_t
 };
 
 extern int board_i2c_cpld_read(unsigned short cpld_addr, u8 reg);
+extern int board_i2c_cpld_read_block(unsigned short cpld_addr, u8 reg, u8 len, u8 *values);
 extern int board_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value);
 
 extern int board_i2c_fpga_read(unsigned short cpld_addr, u8 reg);
@@ -129,6 +129,8 @@ struct fan_attr_info {
     struct mutex		update_lock;
     char				valid;           /* != 0 if registers are valid */
     unsigned long		last_updated;    /* In jiffies */
+    struct PDDF_SNAPSHOT_REG	*snap_reg;   /* register in the fan snapshot, NULL if read directly */
+    uint32_t			snap_seq;        /* snapshot the value was decoded from */
 	union {
         char strval[STR_ATTR_SIZE];
         int  intval;
@@ -143,6 +145,7 @@ struct fan_data {
 	struct attribute		*fan_attribute_list[MAX_FAN_ATTRS];
 	struct attribute_group	fan_attribute_group;
 	struct fan_attr_info	attr_info[MAX_FAN_ATTRS];
+	struct PDDF_SNAPSHOT	*snapshot;
 };
 
 #endif
@@ -31,6 +31,9 @@ struct fpgapci_devdata {
   int  max_fpga_i2c_ch;
 
   size_t bar_length;
+
+  /* MSI or legacy interrupt of the device, -1 if none */
+  int irq;
 };
 
 #endif
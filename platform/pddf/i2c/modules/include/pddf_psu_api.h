@@ -28,4 +28,7 @@ extern int sonic_i2c_get_psu_byte_default(void *client, PSU_DATA_ATTR *adata, vo
 extern int sonic_i2c_get_psu_block_default(void *client, PSU_DATA_ATTR *adata, void *data);
 extern int sonic_i2c_get_psu_word_default(void *client, PSU_DATA_ATTR *adata, void *data);
 
+extern int psu_snapshot_init(struct i2c_client *client);
+extern void psu_snapshot_exit(struct i2c_client *client);
+
 #endif
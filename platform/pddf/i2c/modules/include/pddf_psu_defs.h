@@ -85,6 +85,7 @@ typedef struct PSU_PDATA
 }PSU_PDATA;
 
 extern int board_i2c_cpld_read(unsigned short cpld_addr, u8 reg);
+extern int board_i2c_cpld_read_block(unsigned short cpld_addr, u8 reg, u8 len, u8 *values);
 extern int board_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value);
 
 #endif
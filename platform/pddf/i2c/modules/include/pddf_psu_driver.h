@@ -48,6 +48,8 @@ struct psu_attr_info {
 	struct mutex        update_lock;
     char                valid;           /* !=0 if registers are valid */
     unsigned long       last_updated;    /* In jiffies */
+	struct PDDF_SNAPSHOT_REG *snap_reg;  /* register in the psu snapshot, NULL if read directly */
+	uint32_t            snap_seq;        /* snapshot the value was decoded from */
 	u8					status;
 	union {
 		char strval[STR_ATTR_SIZE];
@@ -64,6 +66,7 @@ struct psu_data {
 	struct attribute		*psu_attribute_list[MAX_PSU_ATTRS];
 	struct attribute_group	psu_attribute_group;
 	struct psu_attr_info	attr_info[MAX_PSU_ATTRS];
+	struct PDDF_SNAPSHOT	*snapshot;
 };
 
 
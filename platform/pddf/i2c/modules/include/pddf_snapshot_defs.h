@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Device register snapshot defines/structures header file. A snapshot
+ *  holds the raw values of all the registers behind the attributes of a
+ *  device; they are read together, once per refresh period of the device
+ *  class, and the attributes are decoded from the snapshot.
+ */
+
+#ifndef __PDDF_SNAPSHOT_DEFS_H__
+#define __PDDF_SNAPSHOT_DEFS_H__
+
+#include <linux/i2c.h>
+#include <linux/mutex.h>
+#include <linux/sysfs.h>
+
+#define PDDF_SNAPSHOT_NAME_LEN 32
+#define PDDF_SNAPSHOT_MAX_REGS 128
+#define PDDF_SNAPSHOT_SIZE 1024
+
+enum pddf_snapshot_class {
+    PDDF_SNAPSHOT_FAN,
+    PDDF_SNAPSHOT_PSU,
+    PDDF_SNAPSHOT_CLASS_MAX
+};
+
+typedef struct PDDF_SNAPSHOT_REG
+{
+    void *client;                   // i2c client of the attribute, passed to read()
+    uint32_t devaddr;               // address of the device holding the register
+    uint32_t offset;
+    uint32_t len;                   // no of bytes, as on the wire
+    int (*read_block)(unsigned short devaddr, u8 offset, u8 len, u8 *buf); // block read of the register file at devaddr, or NULL
+    int (*read)(struct PDDF_SNAPSHOT_REG *reg, uint8_t *buf);
+    void *data;                     // attribute data, passed to read()
+    uint32_t pos;                   // of the value in the snapshot
+    int status;                     // of the last read
+}PDDF_SNAPSHOT_REG;
+
+typedef struct PDDF_SNAPSHOT
+{
+    char name[PDDF_SNAPSHOT_NAME_LEN];
+    int class;
+    struct mutex lock;
+    char valid;                     // != 0 if the values are valid
+    unsigned long last_updated;     // In jiffies
+    uint64_t timestamp;             // of the last refresh, in ns
+    uint32_t seq;                   // incremented on each refresh
+    int num_regs;
+    uint32_t size;                  // bytes used in value
+    PDDF_SNAPSHOT_REG regs[PDDF_SNAPSHOT_MAX_REGS];
+    uint8_t value[PDDF_SNAPSHOT_SIZE];
+    struct bin_attribute bin_attr;
+}PDDF_SNAPSHOT;
+
+/* Layout of the 'snapshot' binary attribute: the header, num_regs entries
+ * and then size bytes of register values.
+ */
+typedef struct PDDF_SNAPSHOT_HDR
+{
+    uint32_t seq;
+    uint32_t num_regs;
+    uint32_t size;
+    uint32_t refresh_ms;
+    uint64_t timestamp;
+}PDDF_SNAPSHOT_HDR;
+
+typedef struct PDDF_SNAPSHOT_ENTRY
+{
+    uint32_t devaddr;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t pos;
+    int32_t status;
+}PDDF_SNAPSHOT_ENTRY;
+
+extern PDDF_SNAPSHOT *pddf_snapshot_create(const char *name, int class);
+extern void pddf_snapshot_destroy(PDDF_SNAPSHOT *snap);
+extern PDDF_SNAPSHOT_REG *pddf_snapshot_add_reg(PDDF_SNAPSHOT *snap, void *client, uint32_t devaddr, uint32_t offset,
+        uint32_t len, int (*read_block)(unsigned short devaddr, u8 offset, u8 len, u8 *buf),
+        int (*read)(PDDF_SNAPSHOT_REG *reg, uint8_t *buf), void *data);
+extern uint32_t pddf_snapshot_update(PDDF_SNAPSHOT *snap);
+extern int pddf_snapshot_read(PDDF_SNAPSHOT *snap, PDDF_SNAPSHOT_REG *reg, uint8_t *buf);
+extern void pddf_snapshot_invalidate(PDDF_SNAPSHOT *snap);
+extern int pddf_snapshot_expired(unsigned long last_updated, int class);
+extern int pddf_snapshot_create_file(PDDF_SNAPSHOT *snap, struct kobject *kobj);
+extern void pddf_snapshot_remove_file(PDDF_SNAPSHOT *snap, struct kobject *kobj);
+
+#endif
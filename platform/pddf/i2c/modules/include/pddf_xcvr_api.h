@@ -41,4 +41,19 @@ extern ssize_t get_module_txdisable(struct device *dev, struct device_attribute
 extern ssize_t set_module_txdisable(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
 extern ssize_t get_module_txfault(struct device *dev, struct device_attribute *da, char *buf);
 
+extern int xcvr_attr_resolve(XCVR_ATTR *info);
+extern void xcvr_attr_release(XCVR_ATTR *info);
+extern int xcvr_register_port(struct i2c_client *client);
+extern void xcvr_unregister_port(struct i2c_client *client);
+extern int xcvr_get_port_bitmap(int attr_index, unsigned long *bitmap);
+extern void xcvr_snapshot_invalidate_all(void);
+
+extern int xcvr_event_init(void);
+extern void xcvr_event_exit(void);
+
+extern ssize_t get_module_present_bitmap(struct device_driver *drv, char *buf);
+extern ssize_t get_module_intr_bitmap(struct device_driver *drv, char *buf);
+extern ssize_t get_module_rxlos_bitmap(struct device_driver *drv, char *buf);
+extern ssize_t get_module_txfault_bitmap(struct device_driver *drv, char *buf);
+
 #endif
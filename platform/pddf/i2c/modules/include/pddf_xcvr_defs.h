@@ -20,9 +20,12 @@
 #ifndef __PDDF_XCVR_DEFS_H__
 #define __PDDF_XCVR_DEFS_H__
 
+#include "uapi/pddf_xcvr_event.h"
+
 
 #define MAX_NUM_XCVR 5
 #define MAX_XCVR_ATTRS 20
+#define MAX_XCVR_PORTS 256
 
 
 typedef struct XCVR_ATTR
@@ -40,8 +43,33 @@ typedef struct XCVR_ATTR
     int (*do_access)(void *client, void *data);
     int (*post_access)(void *client, void *data);
 
+    /* Resolved from devtype when the driver binds, NULL for 'eeprom' */
+    int (*read_reg)(struct XCVR_ATTR *info);
+    int (*write_reg)(struct XCVR_ATTR *info, uint32_t val);
+    struct XCVR_REG_SNAPSHOT *snapshot;
+
 }XCVR_ATTR;
 
+/* Last value of a CPLD/FPGA register, shared by all the xcvr attributes
+ * that decode a bit of it
+ */
+typedef struct XCVR_REG_SNAPSHOT
+{
+    struct list_head list;
+    struct mutex lock;
+    int refcnt;
+
+    int (*read_reg)(struct XCVR_ATTR *info);
+    char devname[32];
+    uint32_t devaddr;
+    uint32_t offset;
+    uint32_t len;
+
+    char valid;                 /* !=0 if value is valid */
+    unsigned long last_updated; /* In jiffies */
+    int value;
+}XCVR_REG_SNAPSHOT;
+
 /* XCVR CLIENT DATA - PLATFORM DATA FOR XCVR CLIENT */
 typedef struct XCVR_DATA
 {
@@ -62,6 +90,12 @@ typedef struct XCVR_PDATA
 
 #define BIT_INDEX(i)            (1ULL << (i))
 
+/* 1 if the attribute bit of register value reg matches cmpval */
+static inline uint32_t xcvr_decode_reg_bit(int reg, uint32_t mask, uint32_t cmpval)
+{
+    return ((reg & BIT_INDEX(mask)) == cmpval) ? 1 : 0;
+}
+
 /* List of valid port types */
 typedef enum xcvr_port_type_e {
     PDDF_PORT_TYPE_INVALID,
@@ -73,6 +107,17 @@ typedef enum xcvr_port_type_e {
     PDDF_PORT_TYPE_QSFP28
 } xcvr_port_type_t;
 
+enum xcvr_sysfs_attributes {
+    XCVR_PRESENT,
+    XCVR_RESET,
+    XCVR_INTR_STATUS,
+    XCVR_LPMODE,
+    XCVR_RXLOS,
+    XCVR_TXDISABLE,
+    XCVR_TXFAULT,
+    XCVR_ATTR_MAX
+};
+
 /* Each client has this additional data
  */
 struct xcvr_data {
@@ -89,8 +134,15 @@ struct xcvr_data {
     uint32_t            rxlos;
     uint32_t            txdisable;
     uint32_t            txfault;
+    int                 attr_idx[XCVR_ATTR_MAX]; /* xcvr_attrs index, -1 if absent */
 };
 
+/* Transceiver change event, read from /dev/pddf_xcvr_event
+ */
+#define XCVR_EVENT_RING_SIZE 256
+
+typedef struct pddf_xcvr_event XCVR_EVENT;
+
 typedef struct XCVR_SYSFS_ATTR_OPS
 {
     int index;
@@ -104,17 +156,6 @@ typedef struct XCVR_SYSFS_ATTR_OPS
     int (*post_set)(struct i2c_client *client, XCVR_ATTR *adata, struct xcvr_data *data);
 } XCVR_SYSFS_ATTR_OPS;
 
-enum xcvr_sysfs_attributes {
-    XCVR_PRESENT,
-    XCVR_RESET,
-    XCVR_INTR_STATUS,
-    XCVR_LPMODE,
-    XCVR_RXLOS,
-    XCVR_TXDISABLE,
-    XCVR_TXFAULT,
-    XCVR_ATTR_MAX
-};
-
 extern int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg);
 extern int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value);
 
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * As a userspace API header, it may be included by programs of any
+ * license (Linux-syscall-note).
+ *
+ * Description:
+ *  Userspace ABI of /dev/pddf_xcvr_event, shared by the xcvr driver
+ *  module and its readers. Installed as <pddf/pddf_xcvr_event.h>.
+ */
+
+#ifndef _UAPI_PDDF_XCVR_EVENT_H
+#define _UAPI_PDDF_XCVR_EVENT_H
+
+#include <linux/types.h>
+
+#define PDDF_XCVR_EVENT_DEV         "/dev/pddf_xcvr_event"
+
+/* Event types, the bit of the port that changed */
+#define PDDF_XCVR_EVENT_PRESENT     0   /* module_present_bitmap */
+#define PDDF_XCVR_EVENT_INTR        2   /* module_intr_bitmap */
+
+/* One record per changed port. read() returns whole records only, and
+ * fails with EINVAL if the buffer cannot hold one.
+ */
+struct pddf_xcvr_event {
+    __u64 timestamp;        /* CLOCK_MONOTONIC of the scan, in ns */
+    __u32 port;             /* port index, as in the bitmaps */
+    __u32 type;             /* PDDF_XCVR_EVENT_* */
+    __u32 value;            /* new value of the port bit */
+    __u32 reserved;
+};
+
+#endif /* _UAPI_PDDF_XCVR_EVENT_H */
@@ -31,6 +31,7 @@
 #include <linux/kobject.h>
 #include "pddf_psu_defs.h"
 #include "pddf_psu_driver.h"
+#include "pddf_snapshot_defs.h"
 
 
 /*#define PSU_DEBUG*/
@@ -40,6 +41,8 @@
 #define psu_dbg(...)
 #endif
 
+extern void *get_device_table(char *name);
+
 
 void get_psu_duplicate_sysfs(int idx, char *str)
 {
@@ -79,6 +82,7 @@ int psu_update_hw(struct device *dev, struct psu_attr_info *info, PSU_DATA_ATTR
 {
     int status = 0;
     struct i2c_client *client = to_i2c_client(dev);
+    struct psu_data *dev_data = i2c_get_clientdata(client);
     PSU_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
 
 
@@ -105,6 +109,10 @@ int psu_update_hw(struct device *dev, struct psu_attr_info *info, PSU_DATA_ATTR
             dev_warn(&client->dev, "%s: post_set function fails for %s attribute. ret %d\n", __FUNCTION__, udata->aname, status);
     }
 
+    /* Read back the registers on the next access */
+    if (dev_data->snapshot != NULL)
+        pddf_snapshot_invalidate(dev_data->snapshot);
+
     mutex_unlock(&info->update_lock);
 
     return 0;
@@ -113,13 +121,24 @@ int psu_update_hw(struct device *dev, struct psu_attr_info *info, PSU_DATA_ATTR
 
 int psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATTR *udata)
 {
-    int status = 0;
+    int status = 0, stale;
     struct i2c_client *client = to_i2c_client(dev);
+    struct psu_data *dev_data = i2c_get_clientdata(client);
     PSU_SYSFS_ATTR_DATA *sysfs_attr_data=NULL;
+    uint32_t seq = 0;
 
     mutex_lock(&data->update_lock);
 
-    if (time_after(jiffies, data->last_updated + HZ + HZ / 2) || !data->valid)
+    if (data->snap_reg != NULL)
+    {
+        /* The registers of all the attributes are refreshed together */
+        seq = pddf_snapshot_update(dev_data->snapshot);
+        stale = !data->valid || (data->snap_seq != seq);
+    }
+    else
+        stale = !data->valid || pddf_snapshot_expired(data->last_updated, PDDF_SNAPSHOT_PSU);
+
+    if (stale)
     {
         dev_dbg(&client->dev, "Starting update for %s\n", data->name);
 
@@ -144,6 +163,7 @@ int psu_update_attr(struct device *dev, struct psu_attr_info *data, PSU_DATA_ATT
                 dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, udata->aname, status);
         }
 
+        data->snap_seq = seq;
         data->last_updated = jiffies;
         data->valid = 1;
     }
@@ -298,6 +318,64 @@ exit:
     return count;
 }
 
+/* Reads a pmbus word, retrying while the PSU is busy */
+static int psu_read_word_hw(struct i2c_client *client, uint8_t offset)
+{
+    int status = 0, retry = 10;
+
+    while (retry) {
+        status = i2c_smbus_read_word_data(client, offset);
+        if (unlikely(status < 0)) {
+            msleep(60);
+            retry--;
+            continue;
+        }
+        break;
+    }
+
+    return status;
+}
+
+static int psu_read_reg(void *client, PSU_DATA_ATTR *adata, struct psu_attr_info *padata, int word)
+{
+    struct psu_data *dev_data = i2c_get_clientdata((struct i2c_client *)client);
+    uint8_t buf[2];
+    int status;
+
+    if (padata->snap_reg == NULL)
+    {
+        if (word)
+            return psu_read_word_hw((struct i2c_client *)client, (uint8_t)adata->offset);
+        return board_i2c_cpld_read(adata->devaddr , adata->offset);
+    }
+
+    status = pddf_snapshot_read(dev_data->snapshot, padata->snap_reg, buf);
+    if (status < 0)
+        return status;
+
+    return (status == 2) ? (buf[0] | (buf[1] << 8)) : buf[0];
+}
+
+/* Fills the psu snapshot, the registers are kept in bus byte order */
+static int psu_snapshot_read(PDDF_SNAPSHOT_REG *reg, uint8_t *buf)
+{
+    int val;
+
+    if (reg->len == 2)
+        val = psu_read_word_hw((struct i2c_client *)reg->client, (uint8_t)reg->offset);
+    else
+        val = board_i2c_cpld_read(reg->devaddr, reg->offset);
+
+    if (val < 0)
+        return val;
+
+    buf[0] = val & 0xff;
+    if (reg->len == 2)
+        buf[1] = (val >> 8) & 0xff;
+
+    return 0;
+}
+
 int sonic_i2c_get_psu_byte_default(void *client, PSU_DATA_ATTR *adata, void *data)
 {
     int status = 0;
@@ -307,7 +385,7 @@ int sonic_i2c_get_psu_byte_default(void *client, PSU_DATA_ATTR *adata, void *dat
 
     if (strncmp(adata->devtype, "cpld", strlen("cpld")) == 0)
     {
-        val = board_i2c_cpld_read(adata->devaddr , adata->offset);
+        val = psu_read_reg(client, adata, padata, 0);
         if (val < 0)
             return val;
         padata->val.intval =  ((val & adata->mask) == adata->cmpval);
@@ -359,19 +437,10 @@ int sonic_i2c_get_psu_block_default(void *client, PSU_DATA_ATTR *adata, void *da
 int sonic_i2c_get_psu_word_default(void *client, PSU_DATA_ATTR *adata, void *data)
 {
 
-    int status = 0, retry = 10;
+    int status = 0;
     struct psu_attr_info *padata = (struct psu_attr_info *)data;
-    uint8_t offset = (uint8_t)adata->offset;
 
-    while (retry) {
-        status = i2c_smbus_read_word_data((struct i2c_client *)client, offset);
-        if (unlikely(status < 0)) {
-            msleep(60);
-            retry--;
-            continue;
-        }
-        break;
-    }
+    status = psu_read_reg(client, adata, padata, 1);
 
     if (status < 0)
     {
@@ -386,3 +455,61 @@ int sonic_i2c_get_psu_word_default(void *client, PSU_DATA_ATTR *adata, void *dat
     psu_dbg(KERN_ERR "%s: word value : %d\n", __FUNCTION__, padata->val.shortval);
     return 0;
 }
+
+int psu_snapshot_init(struct i2c_client *client)
+{
+    struct psu_data *data = i2c_get_clientdata(client);
+    PSU_PDATA *pdata = (PSU_PDATA *)(client->dev.platform_data);
+    PSU_DATA_ATTR *adata = NULL;
+    PSU_SYSFS_ATTR_DATA *sysfs_attr_data = NULL;
+    int i, status;
+
+    data->snapshot = pddf_snapshot_create(client->name, PDDF_SNAPSHOT_PSU);
+    if (data->snapshot == NULL)
+        return -ENOMEM;
+
+    for (i=0;i<data->num_attr;i++)
+    {
+        adata = &pdata->psu_attrs[i];
+        sysfs_attr_data = (PSU_SYSFS_ATTR_DATA *)adata->access_data;
+
+        /* Attributes with a custom access, and the eeprom strings, are read directly */
+        if ((sysfs_attr_data == NULL) || (sysfs_attr_data->pre_get != NULL))
+            continue;
+
+        if ((sysfs_attr_data->do_get == sonic_i2c_get_psu_byte_default) &&
+            (strncmp(adata->devtype, "cpld", strlen("cpld")) == 0))
+        {
+            /* CPLD registers can be block read, the CPLD driver looks the client up */
+            data->attr_info[i].snap_reg = pddf_snapshot_add_reg(data->snapshot, client, adata->devaddr, adata->offset, 1,
+                    board_i2c_cpld_read_block, psu_snapshot_read, adata);
+        }
+        else if (sysfs_attr_data->do_get == sonic_i2c_get_psu_word_default)
+        {
+            data->attr_info[i].snap_reg = pddf_snapshot_add_reg(data->snapshot, client, client->addr, adata->offset, 2,
+                    NULL, psu_snapshot_read, adata);
+        }
+    }
+
+    status = pddf_snapshot_create_file(data->snapshot, &client->dev.kobj);
+    if (status != 0)
+        dev_warn(&client->dev, "%s: Unable to create the snapshot attribute. ret %d\n", __FUNCTION__, status);
+
+    return 0;
+}
+
+void psu_snapshot_exit(struct i2c_client *client)
+{
+    struct psu_data *data = i2c_get_clientdata(client);
+    int i;
+
+    if (data->snapshot == NULL)
+        return;
+
+    for (i=0;i<data->num_attr;i++)
+        data->attr_info[i].snap_reg = NULL;
+
+    pddf_snapshot_remove_file(data->snapshot, &client->dev.kobj);
+    pddf_snapshot_destroy(data->snapshot);
+    data->snapshot = NULL;
+}
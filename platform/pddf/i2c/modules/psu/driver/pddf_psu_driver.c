@@ -243,6 +243,11 @@ static int psu_probe(struct i2c_client *client,
         goto exit_free;
     }
 
+    /* The registers behind the attributes are read together */
+    if (psu_snapshot_init(client) != 0) {
+        dev_warn(&client->dev, "%s: Registers are read per attribute\n", __FUNCTION__);
+    }
+
 	data->hwmon_dev = hwmon_device_register_with_groups(&client->dev, client->name, NULL, NULL);
 	if (IS_ERR(data->hwmon_dev)) {
 		status = PTR_ERR(data->hwmon_dev);
@@ -264,6 +269,7 @@ static int psu_probe(struct i2c_client *client,
 
 
 exit_remove:
+    psu_snapshot_exit(client);
     sysfs_remove_group(&client->dev.kobj, &data->psu_attribute_group);
 exit_free:
 	/* Free all the allocated attributes */
@@ -295,6 +301,7 @@ static void psu_remove(struct i2c_client *client)
     }
 
 	hwmon_device_unregister(data->hwmon_dev);
+	psu_snapshot_exit(client);
 	sysfs_remove_group(&client->dev.kobj, &data->psu_attribute_group);
 	for (i=0; data->psu_attribute_list[i]!=NULL; i++)
     {
@@ -29,6 +29,9 @@
 #include <linux/delay.h>
 #include <linux/dmi.h>
 #include <linux/kobject.h>
+#include <linux/list.h>
+#include <linux/bitmap.h>
+#include <linux/moduleparam.h>
 #include "pddf_xcvr_defs.h"
 
 /*#define SFP_DEBUG*/
@@ -43,6 +46,21 @@ extern void *get_device_table(char *name);
 extern int (*ptr_fpgapci_read)(uint32_t);
 extern int (*ptr_fpgapci_write)(uint32_t, uint32_t);
 
+/* Register snapshots are reused for this long, 8 ports typically share
+ * one CPLD register. Off by default, every access reads the device as
+ * before; a platform opts in from modprobe.d, e.g.
+ * "options pddf_xcvr_driver_module snapshot_ms=100".
+ */
+static unsigned int snapshot_ms;
+module_param(snapshot_ms, uint, 0644);
+MODULE_PARM_DESC(snapshot_ms, "Refresh window of the xcvr CPLD/FPGA register snapshots, in ms, 0 (default) disables them");
+
+static LIST_HEAD(xcvr_snapshot_list);
+static DEFINE_MUTEX(xcvr_snapshot_list_lock);
+
+/* Bound xcvr clients by port index, for the bitmap attributes */
+static struct i2c_client *xcvr_port_clients[MAX_XCVR_PORTS];
+static DEFINE_MUTEX(xcvr_port_lock);
 
 
 int get_xcvr_module_attr_data(struct i2c_client *client, struct device *dev,
@@ -293,376 +311,231 @@ int xcvr_fpgapci_write(XCVR_ATTR *info, uint32_t val)
     return status;
 }
 
-int sonic_i2c_get_mod_pres(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+static XCVR_REG_SNAPSHOT *xcvr_snapshot_get(XCVR_ATTR *info)
 {
-    int status = 0;
-    uint32_t modpres = 0;
+    XCVR_REG_SNAPSHOT *snap;
 
-    if ( strcmp(info->devtype, "cpld") == 0)
+    mutex_lock(&xcvr_snapshot_list_lock);
+    list_for_each_entry(snap, &xcvr_snapshot_list, list)
     {
-        status = xcvr_i2c_cpld_read(info);
-
-        if (status < 0)
-            return status;
-        else
+        if ((snap->read_reg == info->read_reg) && (snap->devaddr == info->devaddr) &&
+            (snap->offset == info->offset) && (snap->len == info->len) &&
+            (strcmp(snap->devname, info->devname) == 0))
         {
-            modpres = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod presence :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
+            snap->refcnt++;
+            goto exit;
         }
     }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
 
-        if (status < 0)
-            return status;
-        else
-        {
-            modpres = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod presence :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
+    snap = kzalloc(sizeof(XCVR_REG_SNAPSHOT), GFP_KERNEL);
+    if (snap)
     {
-        status = xcvr_fpgapci_read(info);
-
-        if (status < 0)
-            return status;
-        else
-        {
-            modpres = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod presence :0x%x, status= 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
+        mutex_init(&snap->lock);
+        snap->refcnt = 1;
+        snap->read_reg = info->read_reg;
+        strscpy(snap->devname, info->devname, sizeof(snap->devname));
+        snap->devaddr = info->devaddr;
+        snap->offset = info->offset;
+        snap->len = info->len;
+        list_add_tail(&snap->list, &xcvr_snapshot_list);
     }
 
-    else if(strcmp(info->devtype, "eeprom") == 0)
+exit:
+    mutex_unlock(&xcvr_snapshot_list_lock);
+    return snap;
+}
+
+static void xcvr_snapshot_put(XCVR_REG_SNAPSHOT *snap)
+{
+    mutex_lock(&xcvr_snapshot_list_lock);
+    if (--snap->refcnt == 0)
     {
-        /* get client client for eeprom -  Not Applicable */
+        list_del(&snap->list);
+        kfree(snap);
     }
-    data->modpres = modpres;
-
-    return 0;
+    mutex_unlock(&xcvr_snapshot_list_lock);
 }
 
-int sonic_i2c_get_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+/* Read the register of an attribute, at most once per snapshot_ms for all
+ * the attributes sharing it
+ */
+static int xcvr_snapshot_read(XCVR_ATTR *info)
 {
-    int status = 0;
-    uint32_t modreset=0;
+    XCVR_REG_SNAPSHOT *snap = info->snapshot;
+    int status;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            modreset = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod Reset :0x%x, reg_value = 0x%x\n", modreset, status);
-        }
-    } 
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    if ((snap == NULL) || (snapshot_ms == 0))
+        return info->read_reg(info);
 
-        if (status < 0)
-            return status;
-        else
-        {
-            modreset = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod reset :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
+    mutex_lock(&snap->lock);
+    if (snap->valid && time_before(jiffies, snap->last_updated + msecs_to_jiffies(snapshot_ms)))
     {
-        status = xcvr_fpgapci_read(info);
-        sfp_dbg(KERN_INFO "\n[%s] status=%x\n", __FUNCTION__, status);
-        if (status < 0)
-            return status;
-        else
-        {
-            modreset = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nMod reset :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modreset, status, info->devaddr, info->mask, info->offset);
-        }
+        status = snap->value;
     }
-    else if(strcmp(info->devtype, "eeprom") == 0)
+    else
     {
-        /* get client client for eeprom -  Not Applicable */
+        status = info->read_reg(info);
+        snap->valid = (status >= 0);
+        snap->value = status;
+        snap->last_updated = jiffies;
     }
+    mutex_unlock(&snap->lock);
 
-    data->reset = modreset;
-    return 0;
+    return status;
 }
 
-int sonic_i2c_get_mod_intr_status(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+static void xcvr_snapshot_invalidate(XCVR_ATTR *info)
 {
-    int status = 0;
-    uint32_t mod_intr = 0;
-
-    if (strcmp(info->devtype, "cpld") == 0)
+    if (info->snapshot)
     {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            mod_intr = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Interrupt :0x%x, reg_value = 0x%x\n", mod_intr, status);
-        }
+        mutex_lock(&info->snapshot->lock);
+        info->snapshot->valid = 0;
+        mutex_unlock(&info->snapshot->lock);
     }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+}
 
-        if (status < 0)
-            return status;
-        else
-        {
-            mod_intr = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Interrupt :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_read(info);
-        sfp_dbg(KERN_INFO "\n[%s] status=%x\n", __FUNCTION__, status);
-        if (status < 0)
-            return status;
-        else
-        {
-            mod_intr = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Interrupt :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", mod_intr, status, info->devaddr, info->mask, info->offset);
-        }
-    }
+/* Force the next reads to the devices, after a transceiver interrupt */
+void xcvr_snapshot_invalidate_all(void)
+{
+    XCVR_REG_SNAPSHOT *snap;
 
-    else if(strcmp(info->devtype, "eeprom") == 0)
+    mutex_lock(&xcvr_snapshot_list_lock);
+    list_for_each_entry(snap, &xcvr_snapshot_list, list)
     {
-        /* get client client for eeprom -  Not Applicable */
+        mutex_lock(&snap->lock);
+        snap->valid = 0;
+        mutex_unlock(&snap->lock);
     }
-
-    data->intr_status = mod_intr;
-    return 0;
+    mutex_unlock(&xcvr_snapshot_list_lock);
 }
 
-
-int sonic_i2c_get_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+/* Resolve the devtype of an attribute once, when the driver binds */
+int xcvr_attr_resolve(XCVR_ATTR *info)
 {
-    int status = 0;
-    uint32_t lpmode = 0;
-
     if (strcmp(info->devtype, "cpld") == 0)
     {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            lpmode = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule LPmode :0x%x, reg_value = 0x%x\n", lpmode, status);
-        }
+        info->read_reg = xcvr_i2c_cpld_read;
+        info->write_reg = xcvr_i2c_cpld_write;
     }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
+    else if (strcmp(info->devtype, "fpgai2c") == 0)
     {
-        status = xcvr_i2c_fpga_read(info);
-
-        if (status < 0)
-            return status;
-        else
-        {
-            lpmode = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule LPmode :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
+        info->read_reg = xcvr_i2c_fpga_read;
+        info->write_reg = xcvr_i2c_fpga_write;
     }
-    else if ( strcmp(info->devtype, "fpgapci") == 0)
+    else if (strcmp(info->devtype, "fpgapci") == 0)
     {
-        status = xcvr_fpgapci_read(info);
-        sfp_dbg(KERN_INFO "\n[%s] status=%x\n", __FUNCTION__, status);
-        if (status < 0)
-            return status;
-        else
-        {
-            lpmode = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nlpmode :0x%x, reg_val = 0x%x, op=0x%x, mask=0x%x, offset=0x%x\n", lpmode, status, status & BIT_INDEX(info->mask), info->mask, info->offset);
-        }
+        info->read_reg = xcvr_fpgapci_read;
+        info->write_reg = xcvr_fpgapci_write;
     }
-    else if (strcmp(info->devtype, "eeprom") == 0)
+    else
     {
-        /* get client client for eeprom -  Not Applicable */
+        /* 'eeprom' attributes are not applicable */
+        info->read_reg = NULL;
+        info->write_reg = NULL;
     }
-    
-    data->lpmode = lpmode;
+
+    info->snapshot = NULL;
+    if (info->read_reg)
+    {
+        info->snapshot = xcvr_snapshot_get(info);
+        if (info->snapshot == NULL)
+            return -ENOMEM;
+    }
+
     return 0;
 }
 
-int sonic_i2c_get_mod_rxlos(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+void xcvr_attr_release(XCVR_ATTR *info)
+{
+    if (info->snapshot)
+    {
+        xcvr_snapshot_put(info->snapshot);
+        info->snapshot = NULL;
+    }
+}
+
+static int xcvr_get_attr_bit(XCVR_ATTR *info, uint32_t *val)
 {
     int status = 0;
-    uint32_t rxlos = 0;
 
+    *val = 0;
+    if (info->read_reg == NULL)
+        return 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            rxlos = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule RxLOS :0x%x, reg_value = 0x%x\n", rxlos, status);
-        }
-    } 
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+    status = xcvr_snapshot_read(info);
+    if (status < 0)
+        return status;
 
-        if (status < 0)
-            return status;
-        else
-        {
-            rxlos = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule RxLOS :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    data->rxlos = rxlos;
+    *val = xcvr_decode_reg_bit(status, info->mask, info->cmpval);
+    sfp_dbg(KERN_INFO "\n%s :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", info->aname, *val, status, info->devaddr, info->mask, info->offset);
 
     return 0;
 }
 
-int sonic_i2c_get_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+static int xcvr_set_attr_bit(XCVR_ATTR *info, uint32_t val)
 {
     int status = 0;
-    uint32_t txdis = 0;
 
-    if (strcmp(info->devtype, "cpld") == 0)
+    if (info->write_reg == NULL)
     {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            txdis = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule TxDisable :0x%x, reg_value = 0x%x\n", txdis, status);
-        }
+        printk(KERN_ERR "Error: Invalid device type (%s) to set %s\n", info->devtype, info->aname);
+        return -1;
     }
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
 
-        if (status < 0)
-            return status;
-        else
-        {
-            txdis = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule TxDisable :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    data->txdisable = txdis;
+    status = info->write_reg(info, val);
+    xcvr_snapshot_invalidate(info);
 
-    return 0;
+    return status;
 }
 
-int sonic_i2c_get_mod_txfault(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+int sonic_i2c_get_mod_pres(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
-    int status = 0;
-    uint32_t txflt = 0;
+    return xcvr_get_attr_bit(info, &data->modpres);
+}
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_read(info);
-        if (status < 0)
-            return status;
-        else
-        {
-            txflt = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule TxFault :0x%x, reg_value = 0x%x\n", txflt, status);
-        }
+int sonic_i2c_get_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_get_attr_bit(info, &data->reset);
+}
 
-    } 
-    else if ( strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_read(info);
+int sonic_i2c_get_mod_intr_status(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_get_attr_bit(info, &data->intr_status);
+}
 
-        if (status < 0)
-            return status;
-        else
-        {
-            txflt = ((status & BIT_INDEX(info->mask)) == info->cmpval) ? 1 : 0;
-            sfp_dbg(KERN_INFO "\nModule Txfault :0x%x, reg_value = 0x%x, devaddr=0x%x, mask=0x%x, offset=0x%x\n", modpres, status, info->devaddr, info->mask, info->offset);
-        }
-    }
-    data->txfault = txflt;
+int sonic_i2c_get_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_get_attr_bit(info, &data->lpmode);
+}
 
-    return 0;
+int sonic_i2c_get_mod_rxlos(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_get_attr_bit(info, &data->rxlos);
 }
 
-int sonic_i2c_set_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+int sonic_i2c_get_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
-    int status = 0;
+    return xcvr_get_attr_bit(info, &data->txdisable);
+}
 
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_write(info, data->reset);
-    }
-    else if (strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_write(info, data->reset);
-    }
-    else if (strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_write(info, data->reset);
-    }
-    else
-    {
-        printk(KERN_ERR "Error: Invalid device type (%s) to set xcvr reset\n", info->devtype);
-        status = -1;
-    }
+int sonic_i2c_get_mod_txfault(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_get_attr_bit(info, &data->txfault);
+}
 
-    return status;
+int sonic_i2c_set_mod_reset(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
+{
+    return xcvr_set_attr_bit(info, data->reset);
 }
 
 int sonic_i2c_set_mod_lpmode(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
-    int status = 0;
-
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_write(info, data->lpmode);
-    }
-    else if (strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_write(info, data->lpmode);
-    }
-    else if (strcmp(info->devtype, "fpgapci") == 0)
-    {
-        status = xcvr_fpgapci_write(info, data->lpmode);
-    }
-    else
-    {
-        printk(KERN_ERR "Error: Invalid device type (%s) to set xcvr lpmode\n", info->devtype);
-        status = -1;
-    }
-
-    return status;
+    return xcvr_set_attr_bit(info, data->lpmode);
 }
 
 int sonic_i2c_set_mod_txdisable(struct i2c_client *client, XCVR_ATTR *info, struct xcvr_data *data)
 {
-    int status = 0;
-
-    if (strcmp(info->devtype, "cpld") == 0)
-    {
-        status = xcvr_i2c_cpld_write(info, data->txdisable);
-    }
-    else if (strcmp(info->devtype, "fpgai2c") == 0)
-    {
-        status = xcvr_i2c_fpga_write(info, data->txdisable);
-    }
-    else
-    {
-        printk(KERN_ERR "Error: Invalid device type (%s) to set xcvr txdisable\n", info->devtype);
-        status = -1;
-    }
-
-    return status;
+    return xcvr_set_attr_bit(info, data->txdisable);
 }
 
 ssize_t get_module_presence(struct device *dev, struct device_attribute *da,
@@ -1162,3 +1035,137 @@ ssize_t get_module_txfault(struct device *dev, struct device_attribute *da,
     }
     return sprintf(buf,"%s","");
 }
+
+int xcvr_register_port(struct i2c_client *client)
+{
+    struct xcvr_data *data = i2c_get_clientdata(client);
+
+    if ((data->index < 0) || (data->index >= MAX_XCVR_PORTS))
+    {
+        dev_warn(&client->dev, "%s: port index %d is out of the bitmap range\n", __FUNCTION__, data->index);
+        return 0;
+    }
+
+    mutex_lock(&xcvr_port_lock);
+    xcvr_port_clients[data->index] = client;
+    mutex_unlock(&xcvr_port_lock);
+
+    return 0;
+}
+
+void xcvr_unregister_port(struct i2c_client *client)
+{
+    struct xcvr_data *data = i2c_get_clientdata(client);
+
+    if ((data->index < 0) || (data->index >= MAX_XCVR_PORTS))
+        return;
+
+    mutex_lock(&xcvr_port_lock);
+    if (xcvr_port_clients[data->index] == client)
+        xcvr_port_clients[data->index] = NULL;
+    mutex_unlock(&xcvr_port_lock);
+}
+
+static uint32_t xcvr_port_value(struct xcvr_data *data, int attr_index)
+{
+    switch (attr_index)
+    {
+        case XCVR_PRESENT:
+            return data->modpres;
+        case XCVR_INTR_STATUS:
+            return data->intr_status;
+        case XCVR_RXLOS:
+            return data->rxlos;
+        case XCVR_TXFAULT:
+            return data->txfault;
+        default:
+            return 0;
+    }
+}
+
+/* Set one bit per bound port index, and return the number of port indexes.
+ * Ports sharing a register are decoded from a single device read.
+ */
+int xcvr_get_port_bitmap(int attr_index, unsigned long *bitmap)
+{
+    XCVR_SYSFS_ATTR_OPS *attr_ops = &xcvr_ops[attr_index];
+    struct i2c_client *client;
+    struct xcvr_data *data;
+    XCVR_PDATA *pdata;
+    XCVR_ATTR *attr_data;
+    int port, nports = 0, status = 0;
+
+    bitmap_zero(bitmap, MAX_XCVR_PORTS);
+
+    mutex_lock(&xcvr_port_lock);
+    for (port = 0; port < MAX_XCVR_PORTS; port++)
+    {
+        client = xcvr_port_clients[port];
+        if (client == NULL)
+            continue;
+
+        nports = port + 1;
+        data = i2c_get_clientdata(client);
+        pdata = (XCVR_PDATA *)(client->dev.platform_data);
+        if (data->attr_idx[attr_index] < 0)
+            continue;
+        attr_data = &pdata->xcvr_attrs[data->attr_idx[attr_index]];
+
+        mutex_lock(&data->update_lock);
+        if (attr_ops->pre_get != NULL)
+        {
+            status = (attr_ops->pre_get)(client, attr_data, data);
+            if (status!=0)
+                dev_warn(&client->dev, "%s: pre_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+        }
+        if (attr_ops->do_get != NULL)
+        {
+            status = (attr_ops->do_get)(client, attr_data, data);
+            if (status!=0)
+                dev_warn(&client->dev, "%s: do_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+        }
+        if (attr_ops->post_get != NULL)
+        {
+            status = (attr_ops->post_get)(client, attr_data, data);
+            if (status!=0)
+                dev_warn(&client->dev, "%s: post_get function fails for %s attribute. ret %d\n", __FUNCTION__, attr_data->aname, status);
+        }
+        if (xcvr_port_value(data, attr_index))
+            set_bit(port, bitmap);
+        mutex_unlock(&data->update_lock);
+    }
+    mutex_unlock(&xcvr_port_lock);
+
+    return nports;
+}
+
+/* Same format as the cpumask sysfs files */
+static ssize_t show_port_bitmap(char *buf, int attr_index)
+{
+    DECLARE_BITMAP(bitmap, MAX_XCVR_PORTS);
+    int nports;
+
+    nports = xcvr_get_port_bitmap(attr_index, bitmap);
+
+    return scnprintf(buf, PAGE_SIZE, "%*pb\n", nports, bitmap);
+}
+
+ssize_t get_module_present_bitmap(struct device_driver *drv, char *buf)
+{
+    return show_port_bitmap(buf, XCVR_PRESENT);
+}
+
+ssize_t get_module_intr_bitmap(struct device_driver *drv, char *buf)
+{
+    return show_port_bitmap(buf, XCVR_INTR_STATUS);
+}
+
+ssize_t get_module_rxlos_bitmap(struct device_driver *drv, char *buf)
+{
+    return show_port_bitmap(buf, XCVR_RXLOS);
+}
+
+ssize_t get_module_txfault_bitmap(struct device_driver *drv, char *buf)
+{
+    return show_port_bitmap(buf, XCVR_TXFAULT);
+}
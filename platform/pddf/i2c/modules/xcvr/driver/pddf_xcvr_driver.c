@@ -91,6 +91,22 @@ static const struct attribute_group xcvr_group = {
     .attrs = xcvr_attributes,
 };
 
+/* Bitmaps of all the bound ports, under the driver directory
+ */
+static struct driver_attribute driver_attr_module_present_bitmap = __ATTR(module_present_bitmap, S_IRUGO, get_module_present_bitmap, NULL);
+static struct driver_attribute driver_attr_module_intr_bitmap = __ATTR(module_intr_bitmap, S_IRUGO, get_module_intr_bitmap, NULL);
+static struct driver_attribute driver_attr_module_rxlos_bitmap = __ATTR(module_rxlos_bitmap, S_IRUGO, get_module_rxlos_bitmap, NULL);
+static struct driver_attribute driver_attr_module_txfault_bitmap = __ATTR(module_txfault_bitmap, S_IRUGO, get_module_txfault_bitmap, NULL);
+
+static struct attribute *xcvr_driver_attrs[] = {
+    &driver_attr_module_present_bitmap.attr,
+    &driver_attr_module_intr_bitmap.attr,
+    &driver_attr_module_rxlos_bitmap.attr,
+    &driver_attr_module_txfault_bitmap.attr,
+    NULL
+};
+ATTRIBUTE_GROUPS(xcvr_driver);
+
 static int xcvr_probe(struct i2c_client *client,
             const struct i2c_device_id *dev_id)
 {
@@ -133,12 +149,21 @@ static int xcvr_probe(struct i2c_client *client,
     num = xcvr_platform_data->len;
     data->index = xcvr_platform_data->idx - 1;
     mutex_init(&data->update_lock);
+    for (j=0; j<XCVR_ATTR_MAX; j++)
+        data->attr_idx[j] = -1;
 
     /* Add supported attr in the 'attributes' list */
     for (i=0; i<num; i++)
     {
         struct attribute *aptr = NULL;
         attr_data = xcvr_platform_data->xcvr_attrs + i;
+        status = xcvr_attr_resolve(attr_data);
+        if (status)
+        {
+            num = i + 1;
+            goto exit_release;
+        }
+
         for(j=0;j<XCVR_ATTR_MAX;j++)
         {
             aptr = &xcvr_attr_list[j]->dev_attr.attr;
@@ -148,7 +173,10 @@ static int xcvr_probe(struct i2c_client *client,
         }
         
         if (j<XCVR_ATTR_MAX)
+        {
             xcvr_attributes[i] = &xcvr_attr_list[j]->dev_attr.attr;
+            data->attr_idx[j] = i;
+        }
 
     }
     xcvr_attributes[i] = NULL;
@@ -156,7 +184,7 @@ static int xcvr_probe(struct i2c_client *client,
     /* Register sysfs hooks */
     status = sysfs_create_group(&client->dev.kobj, &xcvr_group);
     if (status) {
-        goto exit_free;
+        goto exit_release;
     }
 
     data->xdev = hwmon_device_register_with_groups(&client->dev, client->name, NULL, NULL);
@@ -173,16 +201,21 @@ static int xcvr_probe(struct i2c_client *client,
     {
         status = (pddf_xcvr_ops.post_probe)(client, dev_id);
         if (status != 0)
-            goto exit_remove;
+            goto exit_unregister;
     }
 
+    xcvr_register_port(client);
 
     return 0;
 
 
+exit_unregister:
+    hwmon_device_unregister(data->xdev);
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &xcvr_group);
-exit_free:
+exit_release:
+    for (i=0; i<num; i++)
+        xcvr_attr_release(xcvr_platform_data->xcvr_attrs + i);
     kfree(data);
 exit:
     
@@ -191,7 +224,7 @@ exit:
 
 static void xcvr_remove(struct i2c_client *client)
 {
-    int ret = 0;
+    int ret = 0, i;
     struct xcvr_data *data = i2c_get_clientdata(client);
     XCVR_PDATA *platdata = (XCVR_PDATA *)client->dev.platform_data;
     XCVR_ATTR *platdata_sub = platdata->xcvr_attrs;
@@ -203,11 +236,15 @@ static void xcvr_remove(struct i2c_client *client)
             printk(KERN_ERR "FAN pre_remove function failed\n");
     }
 
+    xcvr_unregister_port(client);
     hwmon_device_unregister(data->xdev);
     sysfs_remove_group(&client->dev.kobj, &xcvr_group);
     kfree(data);
 
     if (platdata_sub) {
+        for (i=0; i<platdata->len; i++)
+            xcvr_attr_release(platdata_sub + i);
+
         pddf_dbg(XCVR, KERN_DEBUG "%s: Freeing platform subdata\n", __FUNCTION__);
         kfree(platdata_sub);
     }
@@ -241,6 +278,7 @@ static struct i2c_driver xcvr_driver = {
     .driver = {
         .name     = "xcvr",
         .owner    = THIS_MODULE,
+        .groups   = xcvr_driver_groups,
     },
     .probe        = xcvr_probe,
     .remove       = xcvr_remove,
@@ -265,6 +303,13 @@ int xcvr_init(void)
     if (ret!=0)
         return ret;
 
+    ret = xcvr_event_init();
+    if (ret!=0)
+    {
+        i2c_del_driver(&xcvr_driver);
+        return ret;
+    }
+
     if (pddf_xcvr_ops.post_init)
     {
         ret = (pddf_xcvr_ops.post_init)();
@@ -280,6 +325,7 @@ void xcvr_exit(void)
 {
     pddf_dbg(XCVR, "PDDF XCVR DRIVER.. exit\n");
     if (pddf_xcvr_ops.pre_exit) (pddf_xcvr_ops.pre_exit)();
+    xcvr_event_exit();
     i2c_del_driver(&xcvr_driver);
     if (pddf_xcvr_ops.post_exit) (pddf_xcvr_ops.post_exit)();
 
@@ -0,0 +1,308 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description
+ *  Transceiver presence/interrupt change notification. The presence and
+ *  interrupt bitmaps of all the ports are rescanned every scan_ms, and
+ *  right away when the optional CPLD interrupt GPIO fires. Changed ports
+ *  are queued as struct pddf_xcvr_event records (uapi/pddf_xcvr_event.h)
+ *  on /dev/pddf_xcvr_event, and the module_present_change/
+ *  module_intr_change attributes of that device are sysfs_notify()ed.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/i2c.h>
+#include <linux/mutex.h>
+#include <linux/sysfs.h>
+#include <linux/bitmap.h>
+#include <linux/moduleparam.h>
+#include <linux/workqueue.h>
+#include <linux/interrupt.h>
+#include <linux/gpio.h>
+#include <linux/miscdevice.h>
+#include <linux/kfifo.h>
+#include <linux/poll.h>
+#include <linux/fs.h>
+#include <linux/ktime.h>
+#include "pddf_xcvr_defs.h"
+#include "pddf_xcvr_api.h"
+
+static unsigned int scan_ms = 0;
+module_param(scan_ms, uint, 0444);
+MODULE_PARM_DESC(scan_ms, "Period of the xcvr presence/interrupt change scan, in ms. 0 scans on interrupts only");
+
+static int intr_gpio = -1;
+module_param(intr_gpio, int, 0444);
+MODULE_PARM_DESC(intr_gpio, "GPIO of the CPLD xcvr interrupt line, -1 if none");
+
+static char xcvr_event_enabled;
+static int xcvr_event_irq = -1;
+static atomic_t xcvr_event_irq_pending = ATOMIC_INIT(0);
+
+static struct miscdevice xcvr_event_dev;
+static void xcvr_event_scan(struct work_struct *work);
+static DECLARE_DELAYED_WORK(xcvr_event_work, xcvr_event_scan);
+
+/* Protects the ring and the bitmaps below */
+static DEFINE_MUTEX(xcvr_event_lock);
+static DECLARE_KFIFO(xcvr_event_fifo, XCVR_EVENT, XCVR_EVENT_RING_SIZE);
+static DECLARE_WAIT_QUEUE_HEAD(xcvr_event_wait);
+
+static char xcvr_event_valid;   /* !=0 once the first scan is done */
+static int xcvr_event_nports;
+static DECLARE_BITMAP(xcvr_last_present, MAX_XCVR_PORTS);
+static DECLARE_BITMAP(xcvr_last_intr, MAX_XCVR_PORTS);
+static DECLARE_BITMAP(xcvr_present_change, MAX_XCVR_PORTS);
+static DECLARE_BITMAP(xcvr_intr_change, MAX_XCVR_PORTS);
+
+
+static ssize_t show_module_present_change(struct device *dev, struct device_attribute *da, char *buf)
+{
+    ssize_t len;
+
+    mutex_lock(&xcvr_event_lock);
+    len = scnprintf(buf, PAGE_SIZE, "%*pb\n", xcvr_event_nports, xcvr_present_change);
+    mutex_unlock(&xcvr_event_lock);
+
+    return len;
+}
+
+static ssize_t show_module_intr_change(struct device *dev, struct device_attribute *da, char *buf)
+{
+    ssize_t len;
+
+    mutex_lock(&xcvr_event_lock);
+    len = scnprintf(buf, PAGE_SIZE, "%*pb\n", xcvr_event_nports, xcvr_intr_change);
+    mutex_unlock(&xcvr_event_lock);
+
+    return len;
+}
+
+static DEVICE_ATTR(module_present_change, S_IRUGO, show_module_present_change, NULL);
+static DEVICE_ATTR(module_intr_change, S_IRUGO, show_module_intr_change, NULL);
+
+static struct attribute *xcvr_event_attrs[] = {
+    &dev_attr_module_present_change.attr,
+    &dev_attr_module_intr_change.attr,
+    NULL
+};
+ATTRIBUTE_GROUPS(xcvr_event);
+
+/* Queue one event per changed port, the oldest events are dropped when
+ * the ring is full. Called with xcvr_event_lock held.
+ */
+static int xcvr_event_queue(unsigned long *change, unsigned long *bitmap, uint32_t type, uint64_t timestamp)
+{
+    XCVR_EVENT event = {0};
+    int port, count = 0;
+
+    for_each_set_bit(port, change, MAX_XCVR_PORTS)
+    {
+        event.timestamp = timestamp;
+        event.port = port;
+        event.type = type;
+        event.value = test_bit(port, bitmap) ? 1 : 0;
+
+        if (kfifo_is_full(&xcvr_event_fifo))
+            kfifo_skip(&xcvr_event_fifo);
+        kfifo_put(&xcvr_event_fifo, event);
+        count++;
+    }
+
+    return count;
+}
+
+static void xcvr_event_scan(struct work_struct *work)
+{
+    DECLARE_BITMAP(present, MAX_XCVR_PORTS);
+    DECLARE_BITMAP(intr, MAX_XCVR_PORTS);
+    uint64_t timestamp;
+    int nports, present_changed = 0, intr_changed = 0;
+
+    /* The registers changed, the snapshots are stale */
+    if (atomic_xchg(&xcvr_event_irq_pending, 0))
+        xcvr_snapshot_invalidate_all();
+
+    nports = xcvr_get_port_bitmap(XCVR_PRESENT, present);
+    xcvr_get_port_bitmap(XCVR_INTR_STATUS, intr);
+    timestamp = ktime_get_ns();
+
+    mutex_lock(&xcvr_event_lock);
+    if (xcvr_event_valid)
+    {
+        bitmap_xor(xcvr_present_change, present, xcvr_last_present, MAX_XCVR_PORTS);
+        bitmap_xor(xcvr_intr_change, intr, xcvr_last_intr, MAX_XCVR_PORTS);
+        present_changed = xcvr_event_queue(xcvr_present_change, present, PDDF_XCVR_EVENT_PRESENT, timestamp);
+        intr_changed = xcvr_event_queue(xcvr_intr_change, intr, PDDF_XCVR_EVENT_INTR, timestamp);
+    }
+    bitmap_copy(xcvr_last_present, present, MAX_XCVR_PORTS);
+    bitmap_copy(xcvr_last_intr, intr, MAX_XCVR_PORTS);
+    xcvr_event_nports = nports;
+    xcvr_event_valid = 1;
+    mutex_unlock(&xcvr_event_lock);
+
+    if (present_changed)
+        sysfs_notify(&xcvr_event_dev.this_device->kobj, NULL, "module_present_change");
+    if (intr_changed)
+        sysfs_notify(&xcvr_event_dev.this_device->kobj, NULL, "module_intr_change");
+    if (present_changed || intr_changed)
+        wake_up_interruptible(&xcvr_event_wait);
+
+    if (scan_ms)
+        schedule_delayed_work(&xcvr_event_work, msecs_to_jiffies(scan_ms));
+}
+
+/* Threaded handler, the GPIO is usually on an I2C expander whose
+ * interrupt controller can only run nested threaded handlers
+ */
+static irqreturn_t xcvr_event_intr(int irq, void *dev_id)
+{
+    atomic_set(&xcvr_event_irq_pending, 1);
+    mod_delayed_work(system_wq, &xcvr_event_work, 0);
+
+    return IRQ_HANDLED;
+}
+
+static ssize_t xcvr_event_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
+{
+    unsigned int copied = 0;
+    int ret;
+
+    if (count < sizeof(XCVR_EVENT))
+        return -EINVAL;
+
+    while (copied == 0)
+    {
+        if (kfifo_is_empty(&xcvr_event_fifo))
+        {
+            if (file->f_flags & O_NONBLOCK)
+                return -EAGAIN;
+            ret = wait_event_interruptible(xcvr_event_wait, !kfifo_is_empty(&xcvr_event_fifo));
+            if (ret)
+                return ret;
+        }
+
+        mutex_lock(&xcvr_event_lock);
+        ret = kfifo_to_user(&xcvr_event_fifo, buf, count, &copied);
+        mutex_unlock(&xcvr_event_lock);
+        if (ret)
+            return ret;
+    }
+
+    return copied;
+}
+
+static __poll_t xcvr_event_poll(struct file *file, poll_table *wait)
+{
+    poll_wait(file, &xcvr_event_wait, wait);
+
+    return kfifo_is_empty(&xcvr_event_fifo) ? 0 : (EPOLLIN | EPOLLRDNORM);
+}
+
+static const struct file_operations xcvr_event_fops = {
+    .owner      = THIS_MODULE,
+    .read       = xcvr_event_read,
+    .poll       = xcvr_event_poll,
+    .llseek     = noop_llseek,
+};
+
+static struct miscdevice xcvr_event_dev = {
+    .minor      = MISC_DYNAMIC_MINOR,
+    .name       = "pddf_xcvr_event",
+    .fops       = &xcvr_event_fops,
+    .groups     = xcvr_event_groups,
+};
+
+static int xcvr_event_request_intr(void)
+{
+    int ret;
+
+    ret = gpio_request_one(intr_gpio, GPIOF_IN, "pddf_xcvr_intr");
+    if (ret)
+        return ret;
+
+    xcvr_event_irq = gpio_to_irq(intr_gpio);
+    if (xcvr_event_irq < 0)
+    {
+        ret = xcvr_event_irq;
+        goto free_gpio;
+    }
+
+    ret = request_threaded_irq(xcvr_event_irq, NULL, xcvr_event_intr,
+                               IRQF_TRIGGER_FALLING | IRQF_ONESHOT, "pddf_xcvr", NULL);
+    if (ret)
+        goto free_gpio;
+
+    return 0;
+
+free_gpio:
+    xcvr_event_irq = -1;
+    gpio_free(intr_gpio);
+    return ret;
+}
+
+int xcvr_event_init(void)
+{
+    int ret = 0;
+
+    if ((scan_ms == 0) && (intr_gpio < 0))
+        return 0;
+
+    INIT_KFIFO(xcvr_event_fifo);
+    ret = misc_register(&xcvr_event_dev);
+    if (ret)
+    {
+        printk(KERN_ERR "PDDF_XCVR: Unable to register %s, ret %d\n", xcvr_event_dev.name, ret);
+        return ret;
+    }
+
+    if (intr_gpio >= 0)
+    {
+        ret = xcvr_event_request_intr();
+        if (ret)
+        {
+            /* Keep notifying from the periodic scan alone */
+            printk(KERN_ERR "PDDF_XCVR: Unable to use GPIO %d as xcvr interrupt, ret %d\n", intr_gpio, ret);
+            if (scan_ms == 0)
+            {
+                misc_deregister(&xcvr_event_dev);
+                return ret;
+            }
+        }
+    }
+
+    xcvr_event_enabled = 1;
+    /* The first scan only records the initial state */
+    schedule_delayed_work(&xcvr_event_work, 0);
+
+    return 0;
+}
+
+void xcvr_event_exit(void)
+{
+    if (!xcvr_event_enabled)
+        return;
+
+    if (xcvr_event_irq >= 0)
+    {
+        free_irq(xcvr_event_irq, NULL);
+        gpio_free(intr_gpio);
+        xcvr_event_irq = -1;
+    }
+    cancel_delayed_work_sync(&xcvr_event_work);
+    misc_deregister(&xcvr_event_dev);
+    xcvr_event_enabled = 0;
+}
@@ -0,0 +1,636 @@
+/*
+ * Minimal kernel API for building PDDF sources as a userspace test
+ * program. Single threaded: locks are no-ops, jiffies is a plain counter
+ * advanced by the test, delayed works run when the test calls
+ * kshim_run_work(). The device accessors, sysfs_notify(), the sysfs
+ * binary files, the GPIO/IRQ, PCI, I2C adapter and debugfs calls,
+ * usleep_range() and wait_for_completion_timeout() are provided by the test.
+ */
+
+#ifndef __PDDF_KSHIM_H__
+#define __PDDF_KSHIM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>     /* ssize_t, loff_t */
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+/* as the kernel, long long on all architectures */
+typedef unsigned long long u64;
+typedef long long s64;
+
+#define KERN_ERR        ""
+#define KERN_WARNING    ""
+#define KERN_INFO       ""
+#define KERN_DEBUG      ""
+#define KERN_CONT       ""
+#define printk(...)     printf(__VA_ARGS__)
+#define unlikely(x)     (x)
+#define likely(x)       (x)
+#define PAGE_SIZE       4096
+#define GFP_KERNEL      0
+#define S_IRUGO         0444
+#define S_IWUSR         0200
+
+#define __init
+#define __exit
+#define EXPORT_SYMBOL(sym)
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define module_init(fn)
+#define module_exit(fn)
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#define DIV_ROUND_UP(n, d)      (((n) + (d) - 1) / (d))
+#define min(a, b)               ((a) < (b) ? (a) : (b))
+#define max(a, b)               ((a) > (b) ? (a) : (b))
+#define min_t(type, a, b)       min((type)(a), (type)(b))
+#define clamp(val, lo, hi)      ((val) < (lo) ? (lo) : ((val) > (hi) ? (hi) : (val)))
+
+/* Lists */
+struct list_head {
+    struct list_head *next, *prev;
+};
+
+struct hlist_node {
+    struct hlist_node *next, **pprev;
+};
+
+#define LIST_HEAD(name) struct list_head name = { &(name), &(name) }
+
+static inline void list_add_tail(struct list_head *n, struct list_head *head)
+{
+    n->prev = head->prev;
+    n->next = head;
+    head->prev->next = n;
+    head->prev = n;
+}
+
+static inline void list_del(struct list_head *n)
+{
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->next = n->prev = NULL;
+}
+
+static inline int list_empty(const struct list_head *head)
+{
+    return head->next == head;
+}
+
+#define list_for_each_entry(pos, head, member) \
+    for (pos = container_of((head)->next, __typeof__(*pos), member); \
+         &pos->member != (head); \
+         pos = container_of(pos->member.next, __typeof__(*pos), member))
+
+/* Locks */
+struct mutex {
+    int locked;
+};
+
+#define DEFINE_MUTEX(name) struct mutex name = { 0 }
+#define mutex_init(m)      ((m)->locked = 0)
+#define mutex_lock(m)      ((m)->locked++)
+#define mutex_unlock(m)    ((m)->locked--)
+
+/* Time, one jiffy is one millisecond */
+extern unsigned long jiffies;
+#define HZ                      1000
+#define time_before(a, b)       ((long)((a) - (b)) < 0)
+#define time_after(a, b)        time_before(b, a)
+#define msecs_to_jiffies(ms)    ((unsigned long)(ms))
+#define usecs_to_jiffies(us)    DIV_ROUND_UP((unsigned long)(us), 1000)
+#define msleep(ms)              ((void)(ms))
+#define udelay(us)              ((void)(us))
+
+void usleep_range(unsigned long min, unsigned long max);
+
+/* Memory, strings */
+#define kzalloc(size, flags)    calloc(1, size)
+#define kmalloc(size, flags)    malloc(size)
+#define kfree(p)                free((void *)(p))
+
+static inline ssize_t strscpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strnlen(src, size);
+
+    if (len == size)
+    {
+        if (size)
+            dst[size - 1] = '\0';
+        memcpy(dst, src, size ? size - 1 : 0);
+        return -E2BIG;
+    }
+    memcpy(dst, src, len + 1);
+    return len;
+}
+
+static inline int kstrtoint(const char *s, unsigned int base, int *res)
+{
+    char *end;
+    long v = strtol(s, &end, base);
+
+    if ((end == s) || ((*end != '\0') && (*end != '\n')))
+        return -EINVAL;
+    *res = (int)v;
+    return 0;
+}
+
+#define scnprintf snprintf
+
+/* Bitmaps */
+#define BITS_PER_LONG           (8 * sizeof(long))
+#define BITS_TO_LONGS(n)        (((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define DECLARE_BITMAP(name, bits) unsigned long name[BITS_TO_LONGS(bits)]
+
+static inline void bitmap_zero(unsigned long *map, unsigned int bits)
+{
+    memset(map, 0, BITS_TO_LONGS(bits) * sizeof(long));
+}
+
+static inline void set_bit(int nr, unsigned long *map)
+{
+    map[nr / BITS_PER_LONG] |= 1UL << (nr % BITS_PER_LONG);
+}
+
+static inline int test_bit(int nr, const unsigned long *map)
+{
+    return (map[nr / BITS_PER_LONG] >> (nr % BITS_PER_LONG)) & 1;
+}
+
+static inline void bitmap_copy(unsigned long *dst, const unsigned long *src, unsigned int bits)
+{
+    memcpy(dst, src, BITS_TO_LONGS(bits) * sizeof(long));
+}
+
+static inline void bitmap_xor(unsigned long *dst, const unsigned long *a, const unsigned long *b,
+                              unsigned int bits)
+{
+    unsigned int i;
+
+    for (i = 0; i < BITS_TO_LONGS(bits); i++)
+        dst[i] = a[i] ^ b[i];
+}
+
+static inline int kshim_next_bit(const unsigned long *map, int bits, int nr)
+{
+    while ((nr < bits) && !test_bit(nr, map))
+        nr++;
+    return nr;
+}
+
+#define for_each_set_bit(bit, map, bits) \
+    for ((bit) = kshim_next_bit(map, bits, 0); (bit) < (bits); (bit) = kshim_next_bit(map, bits, (bit) + 1))
+
+/* Atomics */
+typedef struct {
+    int counter;
+} atomic_t;
+
+#define ATOMIC_INIT(i)          { (i) }
+#define atomic_set(v, i)        ((v)->counter = (i))
+#define atomic_read(v)          ((v)->counter)
+
+static inline int atomic_xchg(atomic_t *v, int i)
+{
+    int old = v->counter;
+
+    v->counter = i;
+    return old;
+}
+
+static inline u64 ktime_get_ns(void)
+{
+    return (u64)jiffies * 1000000;
+}
+
+typedef s64 ktime_t;
+
+#define ktime_get()                     ((ktime_t)ktime_get_ns())
+#define ktime_us_delta(later, earlier)  (((later) - (earlier)) / 1000)
+
+/* Driver model */
+struct attribute {
+    const char *name;
+    unsigned short mode;
+};
+
+struct attribute_group {
+    struct attribute **attrs;
+};
+
+#define ATTRIBUTE_GROUPS(_name) \
+    static const struct attribute_group _name##_group = { .attrs = _name##_attrs }; \
+    static const struct attribute_group *_name##_groups[] = { &_name##_group, NULL }
+
+struct kobject {
+    const char *name;
+};
+
+static inline const char *kobject_name(const struct kobject *kobj)
+{
+    return kobj->name;
+}
+
+struct device {
+    struct kobject kobj;
+    struct device *parent;
+    void *platform_data;
+    void *driver_data;
+};
+
+static inline void *dev_get_drvdata(const struct device *dev)
+{
+    return dev->driver_data;
+}
+
+static inline void dev_set_drvdata(struct device *dev, void *data)
+{
+    dev->driver_data = data;
+}
+
+struct device_driver {
+    const char *name;
+};
+
+struct device_attribute {
+    struct attribute attr;
+    ssize_t (*show)(struct device *dev, struct device_attribute *da, char *buf);
+    ssize_t (*store)(struct device *dev, struct device_attribute *da, const char *buf, size_t count);
+};
+
+struct sensor_device_attribute {
+    struct device_attribute dev_attr;
+    int index;
+};
+
+#define to_sensor_dev_attr(da) container_of(da, struct sensor_device_attribute, dev_attr)
+
+struct file;
+struct bin_attribute {
+    struct attribute attr;
+    size_t size;
+    void *private;
+    ssize_t (*read)(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+                    char *buf, loff_t off, size_t count);
+};
+
+#define sysfs_bin_attr_init(bin_attr)
+
+int sysfs_create_bin_file(struct kobject *kobj, const struct bin_attribute *attr);
+void sysfs_remove_bin_file(struct kobject *kobj, const struct bin_attribute *attr);
+
+#define DEVICE_ATTR(_name, _mode, _show, _store) \
+    struct device_attribute dev_attr_##_name = { { #_name, _mode }, _show, _store }
+
+void sysfs_notify(struct kobject *kobj, const char *dir, const char *attr);
+
+#define dev_warn(dev, ...)      printf(__VA_ARGS__)
+#define dev_info(dev, ...)      printf(__VA_ARGS__)
+#define dev_err(dev, ...)       printf(__VA_ARGS__)
+
+/* I2C, the test provides the SMBus accessors */
+struct i2c_client {
+    struct device dev;
+    unsigned short addr;
+    char name[32];
+};
+
+struct i2c_device_id {
+    char name[20];
+    unsigned long driver_data;
+};
+
+#define to_i2c_client(d)        container_of(d, struct i2c_client, dev)
+
+static inline void *i2c_get_clientdata(const struct i2c_client *client)
+{
+    return client->dev.driver_data;
+}
+
+static inline void i2c_set_clientdata(struct i2c_client *client, void *data)
+{
+    client->dev.driver_data = data;
+}
+
+int i2c_smbus_read_byte_data(const struct i2c_client *client, u8 command);
+int i2c_smbus_write_byte_data(const struct i2c_client *client, u8 command, u8 value);
+int i2c_smbus_read_word_swapped(const struct i2c_client *client, u8 command);
+int i2c_smbus_write_word_swapped(const struct i2c_client *client, u8 command, u16 value);
+
+/* I2C adapters, the test provides the adapter registration */
+#define I2C_SMBUS_BLOCK_MAX     32
+#define I2C_M_RD                0x0001
+#define I2C_M_TEN               0x0010
+#define I2C_M_NOSTART           0x4000
+#define I2C_FUNC_I2C            0x00000001
+#define I2C_FUNC_SMBUS_EMUL     0x0eff0008
+#define I2C_CLASS_HWMON         (1 << 0)
+#define I2C_CLASS_SPD           (1 << 7)
+
+struct i2c_msg {
+    u16 addr;
+    u16 flags;
+    u16 len;
+    u8 *buf;
+};
+
+struct i2c_adapter;
+
+struct i2c_algorithm {
+    int (*master_xfer)(struct i2c_adapter *adap, struct i2c_msg *msgs, int num);
+    u32 (*functionality)(struct i2c_adapter *adap);
+};
+
+struct i2c_adapter {
+    void *owner;
+    unsigned int class;
+    const struct i2c_algorithm *algo;
+    void *algo_data;
+    struct device dev;
+    int nr;
+    char name[48];
+};
+
+static inline void *i2c_get_adapdata(const struct i2c_adapter *adap)
+{
+    return adap->dev.driver_data;
+}
+
+static inline void i2c_set_adapdata(struct i2c_adapter *adap, void *data)
+{
+    adap->dev.driver_data = data;
+}
+
+int i2c_add_numbered_adapter(struct i2c_adapter *adap);
+void i2c_del_adapter(struct i2c_adapter *adap);
+
+/* Delayed works */
+struct work_struct {
+    void (*func)(struct work_struct *work);
+};
+
+struct delayed_work {
+    struct work_struct work;
+    int pending;
+    unsigned long delay;        /* delay of the last (re)schedule */
+};
+
+#define DECLARE_DELAYED_WORK(n, f)      struct delayed_work n = { .work = { .func = (f) } }
+#define system_wq                       NULL
+
+static inline int schedule_delayed_work(struct delayed_work *dwork, unsigned long delay)
+{
+    if (dwork->pending)
+        return 0;
+    dwork->pending = 1;
+    dwork->delay = delay;
+    return 1;
+}
+
+static inline int mod_delayed_work(void *wq, struct delayed_work *dwork, unsigned long delay)
+{
+    int pending = dwork->pending;
+
+    dwork->pending = 1;
+    dwork->delay = delay;
+    return pending;
+}
+
+static inline int cancel_delayed_work_sync(struct delayed_work *dwork)
+{
+    int pending = dwork->pending;
+
+    dwork->pending = 0;
+    return pending;
+}
+
+/* Run a pending work, as the workqueue would, 0 if none was pending */
+static inline int kshim_run_work(struct delayed_work *dwork)
+{
+    if (!dwork->pending)
+        return 0;
+    dwork->pending = 0;
+    dwork->work.func(&dwork->work);
+    return 1;
+}
+
+/* Wait queues, nothing can sleep in a single threaded test */
+typedef struct {
+    int wakeups;
+} wait_queue_head_t;
+
+#define DECLARE_WAIT_QUEUE_HEAD(n)              wait_queue_head_t n = { 0 }
+#define init_waitqueue_head(wq)                 ((wq)->wakeups = 0)
+#define wake_up_interruptible(wq)               ((wq)->wakeups++)
+#define wait_event_interruptible(wq, cond)      ((cond) ? 0 : -EINTR)
+
+/* Completions, the test decides in wait_for_completion_timeout() what
+ * happens while the caller sleeps
+ */
+struct completion {
+    int done;
+};
+
+#define init_completion(x)      ((x)->done = 0)
+#define reinit_completion(x)    ((x)->done = 0)
+#define complete(x)             ((x)->done++)
+
+unsigned long wait_for_completion_timeout(struct completion *x, unsigned long timeout);
+
+/* kfifo of fixed size records */
+#define DECLARE_KFIFO(fifo, type, size) \
+    struct { unsigned int in, out; type buf[size]; } fifo
+#define INIT_KFIFO(fifo)        ((fifo).in = (fifo).out = 0)
+#define kfifo_size(fifo)        (sizeof((fifo)->buf) / sizeof((fifo)->buf[0]))
+#define kfifo_len(fifo)         ((fifo)->in - (fifo)->out)
+#define kfifo_is_empty(fifo)    (kfifo_len(fifo) == 0)
+#define kfifo_is_full(fifo)     (kfifo_len(fifo) >= kfifo_size(fifo))
+#define kfifo_skip(fifo)        ((fifo)->out++)
+#define kfifo_put(fifo, val) \
+    (kfifo_is_full(fifo) ? 0 : ((fifo)->buf[(fifo)->in++ % kfifo_size(fifo)] = (val), 1))
+#define kfifo_to_user(fifo, to, len, copied) \
+    kshim_kfifo_out((fifo)->buf, sizeof((fifo)->buf[0]), kfifo_size(fifo), \
+                    &(fifo)->in, &(fifo)->out, to, len, copied)
+
+/* Whole records only, as __kfifo_to_user() */
+static inline int kshim_kfifo_out(void *buf, size_t esize, size_t size, unsigned int *in,
+                                  unsigned int *out, void *to, size_t len, unsigned int *copied)
+{
+    size_t n = 0;
+
+    while ((n < len / esize) && (*out != *in))
+    {
+        memcpy((char *)to + n * esize, (char *)buf + (*out % size) * esize, esize);
+        (*out)++;
+        n++;
+    }
+    *copied = n * esize;
+    return 0;
+}
+
+/* Character devices */
+#define __user
+#define THIS_MODULE             NULL
+typedef unsigned int __poll_t;
+typedef struct {
+    int x;
+} poll_table;
+
+#define EPOLLIN                 0x0001
+#define EPOLLRDNORM             0x0040
+#define poll_wait(file, wq, pt) ((void)(wq))
+
+#define O_NONBLOCK              00004000
+
+struct file {
+    unsigned int f_flags;
+};
+
+struct file_operations {
+    void *owner;
+    ssize_t (*read)(struct file *file, char __user *buf, size_t count, loff_t *ppos);
+    __poll_t (*poll)(struct file *file, poll_table *wait);
+    loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+};
+
+static inline loff_t noop_llseek(struct file *file, loff_t offset, int whence)
+{
+    return 0;
+}
+
+#define MISC_DYNAMIC_MINOR      255
+
+struct miscdevice {
+    int minor;
+    const char *name;
+    const struct file_operations *fops;
+    const struct attribute_group **groups;
+    struct device *this_device;
+};
+
+int misc_register(struct miscdevice *misc);
+void misc_deregister(struct miscdevice *misc);
+
+/* Interrupts and GPIOs */
+typedef int irqreturn_t;
+typedef irqreturn_t (*irq_handler_t)(int irq, void *dev_id);
+
+#define IRQ_NONE                0
+#define IRQ_HANDLED             1
+#define IRQF_TRIGGER_RISING     0x00000001
+#define IRQF_TRIGGER_FALLING    0x00000002
+#define IRQF_SHARED             0x00000080
+#define IRQF_ONESHOT            0x00002000
+#define GPIOF_IN                1
+
+int request_threaded_irq(unsigned int irq, irq_handler_t handler, irq_handler_t thread_fn,
+                         unsigned long flags, const char *name, void *dev_id);
+void free_irq(unsigned int irq, void *dev_id);
+int gpio_request_one(unsigned int gpio, unsigned long flags, const char *label);
+void gpio_free(unsigned int gpio);
+int gpio_to_irq(unsigned int gpio);
+
+/* Memory mapped IO, the test provides the register model behind it */
+#define __iomem
+
+u8 ioread8(const void __iomem *addr);
+void iowrite8(u8 value, void __iomem *addr);
+u32 ioread32(const void __iomem *addr);
+void iowrite32(u32 value, void __iomem *addr);
+
+/* PCI, the test provides the device */
+#define IORESOURCE_IO           0x00000100
+#define IORESOURCE_MEM          0x00000200
+#define PCI_ANY_ID              (~0U)
+#define PCI_VENDOR_ID           0x00
+#define PCI_DEVICE_ID           0x02
+#define PCI_REVISION_ID         0x08
+#define PCI_CLASS_PROG          0x09
+#define PCI_CLASS_DEVICE        0x0a
+#define PCI_INTERRUPT_LINE      0x3c
+#define PCI_INTERRUPT_PIN       0x3d
+#define PCI_IRQ_LEGACY          (1 << 0)
+#define PCI_IRQ_MSI             (1 << 1)
+#define PCI_IRQ_MSIX            (1 << 2)
+
+struct pci_dev {
+    struct device dev;
+};
+
+struct pci_device_id {
+    u32 vendor, device;
+    u32 subvendor, subdevice;
+    u32 class, class_mask;
+    unsigned long driver_data;
+};
+
+#define PCI_DEVICE(vend, dev) \
+    .vendor = (vend), .device = (dev), .subvendor = PCI_ANY_ID, .subdevice = PCI_ANY_ID
+
+struct pci_driver {
+    const char *name;
+    const struct pci_device_id *id_table;
+    int (*probe)(struct pci_dev *dev, const struct pci_device_id *id);
+    void (*remove)(struct pci_dev *dev);
+};
+
+static inline const char *pci_name(const struct pci_dev *pdev)
+{
+    return pdev->dev.kobj.name;
+}
+
+int pci_enable_device(struct pci_dev *dev);
+void pci_disable_device(struct pci_dev *dev);
+void pci_set_master(struct pci_dev *dev);
+int pci_request_regions(struct pci_dev *dev, const char *name);
+void pci_release_regions(struct pci_dev *dev);
+unsigned long pci_resource_start(struct pci_dev *dev, int bar);
+unsigned long pci_resource_end(struct pci_dev *dev, int bar);
+unsigned long pci_resource_len(struct pci_dev *dev, int bar);
+unsigned long pci_resource_flags(struct pci_dev *dev, int bar);
+int pci_read_config_byte(const struct pci_dev *dev, int where, u8 *val);
+int pci_read_config_word(const struct pci_dev *dev, int where, u16 *val);
+int pci_alloc_irq_vectors(struct pci_dev *dev, unsigned int min_vecs, unsigned int max_vecs,
+                          unsigned int flags);
+int pci_irq_vector(struct pci_dev *dev, unsigned int nr);
+void pci_free_irq_vectors(struct pci_dev *dev);
+int pci_register_driver(struct pci_driver *drv);
+void pci_unregister_driver(struct pci_driver *drv);
+void __iomem *ioremap_cache(unsigned long offset, unsigned long size);
+void pci_iounmap(struct pci_dev *dev, void __iomem *addr);
+
+/* debugfs, the test provides the entries. seq_file output goes to buf */
+struct dentry {
+    const char *name;
+};
+
+struct seq_file {
+    void *private;
+    char buf[PAGE_SIZE];
+    size_t count;
+};
+
+#define seq_printf(m, ...) \
+    ((m)->count += snprintf((m)->buf + (m)->count, sizeof((m)->buf) - (m)->count, __VA_ARGS__))
+
+#define DEFINE_SHOW_ATTRIBUTE(__name) \
+    static const struct file_operations __name##_fops = { .owner = THIS_MODULE }
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent);
+struct dentry *debugfs_create_file(const char *name, unsigned short mode, struct dentry *parent,
+                                   void *data, const struct file_operations *fops);
+void debugfs_remove(struct dentry *dentry);
+void debugfs_remove_recursive(struct dentry *dentry);
+
+#endif /* __PDDF_KSHIM_H__ */
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Userspace test of the xcvr change notification: scans, interrupt
+ *  setup, event ring and /dev/pddf_xcvr_event reads
+ */
+
+#include "../driver/pddf_xcvr_api.c"
+#include "../driver/pddf_xcvr_event.c"
+#include "xcvr_mock.h"
+
+#define TEST_GPIO       42
+#define TEST_IRQ        142
+
+/* Mock misc device, sysfs and interrupt controller */
+static struct device misc_device;
+static int misc_registered;
+static int notify_present, notify_intr;
+static int gpio_requested, gpio_fail, irq_fail;
+static irq_handler_t irq_handler, irq_thread;
+static unsigned long irq_flags;
+
+int misc_register(struct miscdevice *misc)
+{
+    misc->this_device = &misc_device;
+    misc_registered++;
+    return 0;
+}
+
+void misc_deregister(struct miscdevice *misc)
+{
+    misc->this_device = NULL;
+    misc_registered--;
+}
+
+void sysfs_notify(struct kobject *kobj, const char *dir, const char *attr)
+{
+    CHECK(kobj == &misc_device.kobj);
+    if (strcmp(attr, "module_present_change") == 0)
+        notify_present++;
+    else if (strcmp(attr, "module_intr_change") == 0)
+        notify_intr++;
+    else
+        CHECK(0);
+}
+
+int gpio_request_one(unsigned int gpio, unsigned long flags, const char *label)
+{
+    CHECK(gpio == TEST_GPIO);
+    CHECK(flags == GPIOF_IN);
+    if (gpio_fail)
+        return -EBUSY;
+    gpio_requested++;
+    return 0;
+}
+
+void gpio_free(unsigned int gpio)
+{
+    gpio_requested--;
+}
+
+int gpio_to_irq(unsigned int gpio)
+{
+    return TEST_IRQ;
+}
+
+int request_threaded_irq(unsigned int irq, irq_handler_t handler, irq_handler_t thread_fn,
+                         unsigned long flags, const char *name, void *dev_id)
+{
+    CHECK(irq == TEST_IRQ);
+    if (irq_fail)
+        return -EINVAL;
+    irq_handler = handler;
+    irq_thread = thread_fn;
+    irq_flags = flags;
+    return 0;
+}
+
+void free_irq(unsigned int irq, void *dev_id)
+{
+    CHECK(irq == TEST_IRQ);
+    irq_thread = NULL;
+}
+
+static void event_reset(void)
+{
+    mock_reset();
+    notify_present = notify_intr = 0;
+    gpio_fail = irq_fail = 0;
+    scan_ms = 0;
+    intr_gpio = -1;
+    snapshot_ms = 0;
+    xcvr_event_valid = 0;
+    xcvr_event_wait.wakeups = 0;
+    /* all ports absent, no interrupt */
+    cpld_regs[0x10] = 0xFF;
+    cpld_regs[0x11] = 0xFF;
+    fpga_regs[0x8 / 4] = 0xFFFF;
+}
+
+static ssize_t event_read(struct pddf_xcvr_event *events, size_t count, unsigned int flags)
+{
+    struct file file = { .f_flags = flags };
+
+    return xcvr_event_dev.fops->read(&file, (char *)events, count, NULL);
+}
+
+static __poll_t poll_events(void)
+{
+    struct file file = { 0 };
+
+    return xcvr_event_dev.fops->poll(&file, NULL);
+}
+
+/* Nothing is registered unless a scan period or a GPIO is given */
+static void test_disabled(void)
+{
+    event_reset();
+    ports_bind();
+
+    CHECK(xcvr_event_init() == 0);
+    CHECK(misc_registered == 0);
+    CHECK(!xcvr_event_work.pending);
+    xcvr_event_exit();
+
+    ports_unbind();
+}
+
+/* The GPIO interrupt is threaded, oneshot, and triggers a fresh scan */
+static void test_interrupt(void)
+{
+    struct pddf_xcvr_event events[8];
+    ssize_t len;
+
+    event_reset();
+    ports_bind();
+    intr_gpio = TEST_GPIO;
+    snapshot_ms = 100;
+
+    CHECK(xcvr_event_init() == 0);
+    CHECK(misc_registered == 1);
+    CHECK(gpio_requested == 1);
+    CHECK(irq_handler == NULL);
+    CHECK(irq_thread != NULL);
+    CHECK(irq_flags == (IRQF_TRIGGER_FALLING | IRQF_ONESHOT));
+
+    /* the first scan only records the state */
+    CHECK(kshim_run_work(&xcvr_event_work) == 1);
+    CHECK(!xcvr_event_work.pending);
+    CHECK(poll_events() == 0);
+    CHECK(event_read(events, sizeof(events), O_NONBLOCK) == -EAGAIN);
+
+    /* port 3 inserted and port 9 interrupting, inside the snapshot window */
+    cpld_regs[0x10] = 0xF7;
+    fpga_regs[0x8 / 4] = 0xFDFF;
+    jiffies += 10;
+    CHECK(irq_thread(TEST_IRQ, NULL) == IRQ_HANDLED);
+    CHECK(xcvr_event_work.pending && (xcvr_event_work.delay == 0));
+    CHECK(kshim_run_work(&xcvr_event_work) == 1);
+
+    CHECK(notify_present == 1);
+    CHECK(notify_intr == 1);
+    CHECK(xcvr_event_wait.wakeups == 1);
+    CHECK(poll_events() == (EPOLLIN | EPOLLRDNORM));
+    CHECK(test_bit(3, xcvr_present_change) && test_bit(9, xcvr_intr_change));
+
+    len = event_read(events, sizeof(events), O_NONBLOCK);
+    CHECK(len == 2 * sizeof(struct pddf_xcvr_event));
+    CHECK((events[0].type == PDDF_XCVR_EVENT_PRESENT) && (events[0].port == 3) && (events[0].value == 1));
+    CHECK((events[1].type == PDDF_XCVR_EVENT_INTR) && (events[1].port == 9) && (events[1].value == 1));
+    CHECK(events[0].timestamp == (u64)jiffies * 1000000);
+    CHECK(events[0].reserved == 0);
+
+    /* no interrupt, no scan: only interrupts or scan_ms rescan */
+    cpld_regs[0x10] = 0xFF;
+    CHECK(kshim_run_work(&xcvr_event_work) == 0);
+
+    xcvr_event_exit();
+    CHECK(misc_registered == 0);
+    CHECK(gpio_requested == 0);
+    CHECK(irq_thread == NULL);
+
+    ports_unbind();
+}
+
+/* The periodic scan rearms itself, and reports removals too */
+static void test_periodic_scan(void)
+{
+    struct pddf_xcvr_event events[4];
+
+    event_reset();
+    ports_bind();
+    scan_ms = 500;
+
+    CHECK(xcvr_event_init() == 0);
+    CHECK(kshim_run_work(&xcvr_event_work) == 1);
+    CHECK(xcvr_event_work.pending && (xcvr_event_work.delay == msecs_to_jiffies(500)));
+
+    cpld_regs[0x11] = 0x7F;
+    CHECK(kshim_run_work(&xcvr_event_work) == 1);
+    cpld_regs[0x11] = 0xFF;
+    CHECK(kshim_run_work(&xcvr_event_work) == 1);
+    CHECK(notify_present == 2);
+    CHECK(notify_intr == 0);
+
+    CHECK(event_read(events, sizeof(events), O_NONBLOCK) == 2 * sizeof(struct pddf_xcvr_event));
+    CHECK((events[0].port == 15) && (events[0].value == 1));
+    CHECK((events[1].port == 15) && (events[1].value == 0));
+
+    xcvr_event_exit();
+    CHECK(!xcvr_event_work.pending);
+
+    ports_unbind();
+}
+
+/* A full ring drops the oldest events, reads return whole records */
+static void test_ring(void)
+{
+    struct pddf_xcvr_event events[XCVR_EVENT_RING_SIZE];
+    int i, scans = (XCVR_EVENT_RING_SIZE / NUM_PORTS) + 2;
+    ssize_t len;
+
+    event_reset();
+    ports_bind();
+    scan_ms = 100;
+
+    CHECK(xcvr_event_init() == 0);
+    CHECK(kshim_run_work(&xcvr_event_work) == 1);
+
+    /* every scan flips all the ports */
+    for (i = 0; i < scans; i++)
+    {
+        cpld_regs[0x10] ^= 0xFF;
+        cpld_regs[0x11] ^= 0xFF;
+        jiffies += 1;
+        CHECK(kshim_run_work(&xcvr_event_work) == 1);
+    }
+
+    /* a buffer too small for one record */
+    CHECK(event_read(events, sizeof(struct pddf_xcvr_event) - 1, O_NONBLOCK) == -EINVAL);
+
+    /* a partial record is not returned */
+    len = event_read(events, sizeof(struct pddf_xcvr_event) + 3, O_NONBLOCK);
+    CHECK(len == sizeof(struct pddf_xcvr_event));
+    CHECK((events[0].port == 0) && (events[0].timestamp == (u64)(jiffies - scans + 3) * 1000000));
+
+    len = event_read(events, sizeof(events), O_NONBLOCK);
+    CHECK(len == (XCVR_EVENT_RING_SIZE - 1) * sizeof(struct pddf_xcvr_event));
+    CHECK((events[len / sizeof(events[0]) - 1].port == NUM_PORTS - 1));
+    CHECK(events[len / sizeof(events[0]) - 1].timestamp == (u64)jiffies * 1000000);
+    CHECK(event_read(events, sizeof(events), O_NONBLOCK) == -EAGAIN);
+
+    xcvr_event_exit();
+    ports_unbind();
+}
+
+/* Without a usable interrupt, the periodic scan is kept if configured */
+static void test_interrupt_failure(void)
+{
+    event_reset();
+    intr_gpio = TEST_GPIO;
+    irq_fail = 1;
+    scan_ms = 100;
+
+    CHECK(xcvr_event_init() == 0);
+    CHECK(misc_registered == 1);
+    CHECK(gpio_requested == 0);
+    CHECK(xcvr_event_work.pending);
+    xcvr_event_exit();
+    CHECK(misc_registered == 0);
+
+    event_reset();
+    intr_gpio = TEST_GPIO;
+    gpio_fail = 1;
+
+    CHECK(xcvr_event_init() == -EBUSY);
+    CHECK(misc_registered == 0);
+    CHECK(!xcvr_event_work.pending);
+    xcvr_event_exit();
+}
+
+int main(void)
+{
+    cpld_client.addr = CPLD_ADDR;
+
+    test_disabled();
+    test_interrupt();
+    test_periodic_scan();
+    test_ring();
+    test_interrupt_failure();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pddf xcvr event: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Mock CPLD and FPGA register maps, and 16 xcvr ports bound to them
+ *  as the driver probe does. Included by the tests after the driver
+ *  sources.
+ */
+
+#ifndef __XCVR_MOCK_H__
+#define __XCVR_MOCK_H__
+
+#define NUM_PORTS       16
+#define CPLD_NAME       "CPLD1"
+#define CPLD_ADDR       0x60
+
+/* Mock devices, counting the transactions */
+static uint8_t cpld_regs[256];
+static int cpld_reads, cpld_writes;
+static int cpld_fail;                   /* reads to fail before succeeding */
+static uint32_t fpga_regs[64];
+static int fpga_reads;
+static struct i2c_client cpld_client;
+
+unsigned long jiffies = 1000;
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+void *get_device_table(char *name)
+{
+    return (strcmp(name, CPLD_NAME) == 0) ? &cpld_client : NULL;
+}
+
+int board_i2c_cpld_read_new(unsigned short cpld_addr, char *name, u8 reg)
+{
+    cpld_reads++;
+    if (cpld_fail > 0)
+    {
+        cpld_fail--;
+        return -EIO;
+    }
+    return cpld_regs[reg];
+}
+
+int board_i2c_cpld_write_new(unsigned short cpld_addr, char *name, u8 reg, u8 value)
+{
+    cpld_writes++;
+    cpld_regs[reg] = value;
+    return 0;
+}
+
+int i2c_smbus_read_byte_data(const struct i2c_client *client, u8 command)
+{
+    return -EIO;
+}
+
+int i2c_smbus_write_byte_data(const struct i2c_client *client, u8 command, u8 value)
+{
+    return -EIO;
+}
+
+int i2c_smbus_read_word_swapped(const struct i2c_client *client, u8 command)
+{
+    return -EIO;
+}
+
+int i2c_smbus_write_word_swapped(const struct i2c_client *client, u8 command, u16 value)
+{
+    return -EIO;
+}
+
+static int mock_fpgapci_read(uint32_t offset)
+{
+    fpga_reads++;
+    return fpga_regs[offset / 4];
+}
+
+static int mock_fpgapci_write(uint32_t offset, uint32_t value)
+{
+    fpga_regs[offset / 4] = value;
+    return 0;
+}
+
+int (*ptr_fpgapci_read)(uint32_t) = mock_fpgapci_read;
+int (*ptr_fpgapci_write)(uint32_t, uint32_t) = mock_fpgapci_write;
+
+/* Same table as pddf_xcvr_driver.c, the show/store side is not used */
+XCVR_SYSFS_ATTR_OPS xcvr_ops[XCVR_ATTR_MAX] = {
+    {XCVR_PRESENT, NULL, NULL, sonic_i2c_get_mod_pres, NULL, NULL, NULL, NULL, NULL},
+    {XCVR_RESET, NULL, NULL, sonic_i2c_get_mod_reset, NULL, NULL, NULL, sonic_i2c_set_mod_reset, NULL},
+    {XCVR_INTR_STATUS, NULL, NULL, sonic_i2c_get_mod_intr_status, NULL, NULL, NULL, NULL, NULL},
+    {XCVR_LPMODE, NULL, NULL, sonic_i2c_get_mod_lpmode, NULL, NULL, NULL, sonic_i2c_set_mod_lpmode, NULL},
+    {XCVR_RXLOS, NULL, NULL, sonic_i2c_get_mod_rxlos, NULL, NULL, NULL, NULL, NULL},
+    {XCVR_TXDISABLE, NULL, NULL, sonic_i2c_get_mod_txdisable, NULL, NULL, NULL, sonic_i2c_set_mod_txdisable, NULL},
+    {XCVR_TXFAULT, NULL, NULL, sonic_i2c_get_mod_txfault, NULL, NULL, NULL, NULL, NULL},
+};
+
+/* Ports as bound by the driver probe:
+ * - present, active low, 8 ports per CPLD register at 0x10/0x11
+ * - lpmode, active high, 8 ports per CPLD register at 0x20/0x21
+ * - intr_status, active low, one 32 bit FPGA register at 0x8 for all
+ */
+#define PORT_ATTRS 3
+static struct i2c_client port_clients[NUM_PORTS];
+static struct xcvr_data port_data[NUM_PORTS];
+static XCVR_PDATA port_pdata[NUM_PORTS];
+static XCVR_ATTR port_attrs[NUM_PORTS][PORT_ATTRS];
+
+static void set_attr(XCVR_ATTR *a, const char *aname, const char *devtype, const char *devname,
+                     uint32_t devaddr, uint32_t offset, uint32_t mask, uint32_t cmpval, uint32_t len)
+{
+    memset(a, 0, sizeof(*a));
+    strscpy(a->aname, aname, sizeof(a->aname));
+    strscpy(a->devtype, devtype, sizeof(a->devtype));
+    strscpy(a->devname, devname, sizeof(a->devname));
+    a->devaddr = devaddr;
+    a->offset = offset;
+    a->mask = mask;
+    a->cmpval = cmpval;
+    a->len = len;
+}
+
+static void ports_bind(void)
+{
+    int port, i;
+
+    for (port = 0; port < NUM_PORTS; port++)
+    {
+        XCVR_ATTR *a = port_attrs[port];
+        struct xcvr_data *data = &port_data[port];
+
+        set_attr(&a[0], "xcvr_present", "cpld", CPLD_NAME, CPLD_ADDR, 0x10 + port / 8, port % 8, 0, 1);
+        set_attr(&a[1], "xcvr_lpmode", "cpld", CPLD_NAME, CPLD_ADDR, 0x20 + port / 8, port % 8,
+                 BIT_INDEX(port % 8), 1);
+        set_attr(&a[2], "xcvr_intr_status", "fpgapci", "FPGA", 0x0, 0x8, port, 0, 4);
+
+        memset(data, 0, sizeof(*data));
+        data->index = port;
+        mutex_init(&data->update_lock);
+        for (i = 0; i < XCVR_ATTR_MAX; i++)
+            data->attr_idx[i] = -1;
+        data->attr_idx[XCVR_PRESENT] = 0;
+        data->attr_idx[XCVR_LPMODE] = 1;
+        data->attr_idx[XCVR_INTR_STATUS] = 2;
+
+        port_pdata[port].idx = port + 1;
+        port_pdata[port].len = PORT_ATTRS;
+        port_pdata[port].xcvr_attrs = a;
+        port_clients[port].dev.platform_data = &port_pdata[port];
+        i2c_set_clientdata(&port_clients[port], data);
+
+        for (i = 0; i < PORT_ATTRS; i++)
+            CHECK(xcvr_attr_resolve(&a[i]) == 0);
+        CHECK(xcvr_register_port(&port_clients[port]) == 0);
+    }
+}
+
+static void ports_unbind(void)
+{
+    int port, i;
+
+    for (port = 0; port < NUM_PORTS; port++)
+    {
+        xcvr_unregister_port(&port_clients[port]);
+        for (i = 0; i < PORT_ATTRS; i++)
+            xcvr_attr_release(&port_attrs[port][i]);
+    }
+    CHECK(list_empty(&xcvr_snapshot_list));
+}
+
+static void mock_reset(void)
+{
+    memset(cpld_regs, 0, sizeof(cpld_regs));
+    memset(fpga_regs, 0, sizeof(fpga_regs));
+    cpld_reads = cpld_writes = fpga_reads = cpld_fail = 0;
+}
+
+/* Presence of ports 0-15 from the mock registers, bit set = absent */
+static inline unsigned long expected_present(void)
+{
+    return (unsigned long)(uint8_t)~cpld_regs[0x10] | ((unsigned long)(uint8_t)~cpld_regs[0x11] << 8);
+}
+
+static inline int port_present(int port)
+{
+    sonic_i2c_get_mod_pres(&port_clients[port], &port_attrs[port][0], &port_data[port]);
+    return port_data[port].modpres;
+}
+
+#endif /* __XCVR_MOCK_H__ */
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2019 Broadcom.
+ * The term “Broadcom” refers to Broadcom Inc. and/or its subsidiaries.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ *
+ * Description:
+ *  Userspace test of the xcvr register snapshots and bitmaps, the
+ *  CPLD and the FPGA are replaced by mock register maps
+ */
+
+#include "../driver/pddf_xcvr_api.c"
+#include "xcvr_mock.h"
+
+/* The snapshots are shared per register, and released with the ports */
+static void test_sharing(void)
+{
+    XCVR_REG_SNAPSHOT *snap;
+    int n = 0;
+
+    mock_reset();
+    ports_bind();
+
+    CHECK(port_attrs[0][0].snapshot == port_attrs[7][0].snapshot);
+    CHECK(port_attrs[0][0].snapshot != port_attrs[8][0].snapshot);
+    CHECK(port_attrs[0][0].snapshot != port_attrs[0][1].snapshot);
+    CHECK(port_attrs[0][2].snapshot == port_attrs[15][2].snapshot);
+    CHECK(port_attrs[0][0].snapshot->refcnt == 8);
+    CHECK(port_attrs[0][2].snapshot->refcnt == NUM_PORTS);
+
+    /* present x2, lpmode x2, intr_status x1 */
+    list_for_each_entry(snap, &xcvr_snapshot_list, list)
+        n++;
+    CHECK(n == 5);
+
+    ports_unbind();
+}
+
+/* Default: no caching, every access reads the device */
+static void test_default_uncached(void)
+{
+    DECLARE_BITMAP(bitmap, MAX_XCVR_PORTS);
+    int port;
+
+    mock_reset();
+    ports_bind();
+    CHECK(snapshot_ms == 0);
+
+    cpld_regs[0x10] = 0xA5;
+    cpld_regs[0x11] = 0x0F;
+    CHECK(xcvr_get_port_bitmap(XCVR_PRESENT, bitmap) == NUM_PORTS);
+    CHECK(bitmap[0] == expected_present());
+    CHECK(cpld_reads == NUM_PORTS);
+
+    /* a change is seen right away */
+    cpld_regs[0x10] = 0x00;
+    for (port = 0; port < 8; port++)
+        CHECK(port_present(port) == 1);
+    CHECK(cpld_reads == NUM_PORTS + 8);
+
+    ports_unbind();
+}
+
+/* Opted in: ports sharing a register cost one read per window */
+static void test_snapshot_window(void)
+{
+    DECLARE_BITMAP(bitmap, MAX_XCVR_PORTS);
+
+    mock_reset();
+    ports_bind();
+    snapshot_ms = 100;
+
+    cpld_regs[0x10] = 0xA5;
+    cpld_regs[0x11] = 0x0F;
+    CHECK(xcvr_get_port_bitmap(XCVR_PRESENT, bitmap) == NUM_PORTS);
+    CHECK(bitmap[0] == expected_present());
+    CHECK(cpld_reads == 2);
+
+    /* inside the window, the old value is served */
+    cpld_regs[0x10] = 0xFF;
+    jiffies += 99;
+    CHECK(xcvr_get_port_bitmap(XCVR_PRESENT, bitmap) == NUM_PORTS);
+    CHECK(cpld_reads == 2);
+    CHECK(port_present(0) == 0);
+
+    /* the window is over */
+    jiffies += 1;
+    CHECK(xcvr_get_port_bitmap(XCVR_PRESENT, bitmap) == NUM_PORTS);
+    CHECK(bitmap[0] == expected_present());
+    CHECK(cpld_reads == 4);
+
+    /* the FPGA register is read once for all ports */
+    fpga_regs[0x8 / 4] = 0x7FFF0000 | 0x00F0;
+    CHECK(xcvr_get_port_bitmap(XCVR_INTR_STATUS, bitmap) == NUM_PORTS);
+    CHECK(bitmap[0] == 0xFF0F);
+    CHECK(fpga_reads == 1);
+
+    snapshot_ms = 0;
+    ports_unbind();
+}
+
+/* Errors are not cached, the next access reads again */
+static void test_error_not_cached(void)
+{
+    mock_reset();
+    ports_bind();
+    snapshot_ms = 100;
+
+    cpld_regs[0x10] = 0xFE;
+    /* the CPLD read retries 10 times, all fail */
+    cpld_fail = 10;
+    CHECK(sonic_i2c_get_mod_pres(&port_clients[0], &port_attrs[0][0], &port_data[0]) == -EIO);
+    CHECK(cpld_reads == 10);
+
+    CHECK(port_present(0) == 1);
+    CHECK(cpld_reads == 11);
+    CHECK(port_present(1) == 0);
+    CHECK(cpld_reads == 11);
+
+    snapshot_ms = 0;
+    ports_unbind();
+}
+
+/* A write, or a transceiver event, forces the next read to the device */
+static void test_invalidate(void)
+{
+    mock_reset();
+    ports_bind();
+    snapshot_ms = 100;
+
+    sonic_i2c_get_mod_lpmode(&port_clients[3], &port_attrs[3][1], &port_data[3]);
+    CHECK(port_data[3].lpmode == 0);
+    CHECK(cpld_reads == 1);
+
+    port_data[3].lpmode = 1;
+    CHECK(sonic_i2c_set_mod_lpmode(&port_clients[3], &port_attrs[3][1], &port_data[3]) == 0);
+    CHECK(cpld_regs[0x20] == 0x08);
+    CHECK(cpld_writes == 1);
+
+    /* port 3 and its neighbours see the write, in the same window */
+    sonic_i2c_get_mod_lpmode(&port_clients[3], &port_attrs[3][1], &port_data[3]);
+    CHECK(port_data[3].lpmode == 1);
+    sonic_i2c_get_mod_lpmode(&port_clients[4], &port_attrs[4][1], &port_data[4]);
+    CHECK(port_data[4].lpmode == 0);
+    CHECK(cpld_reads == 3);
+
+    /* changed behind the driver, an interrupt invalidates everything */
+    cpld_regs[0x20] = 0x10;
+    xcvr_snapshot_invalidate_all();
+    sonic_i2c_get_mod_lpmode(&port_clients[4], &port_attrs[4][1], &port_data[4]);
+    CHECK(port_data[4].lpmode == 1);
+    CHECK(cpld_reads == 4);
+
+    snapshot_ms = 0;
+    ports_unbind();
+}
+
+/* Unbound ports are left out of the bitmaps */
+static void test_bitmap_ports(void)
+{
+    DECLARE_BITMAP(bitmap, MAX_XCVR_PORTS);
+
+    mock_reset();
+    ports_bind();
+
+    xcvr_unregister_port(&port_clients[15]);
+    xcvr_unregister_port(&port_clients[2]);
+    CHECK(xcvr_get_port_bitmap(XCVR_PRESENT, bitmap) == NUM_PORTS - 1);
+    CHECK(bitmap[0] == (0x7FFF & ~(1UL << 2)));
+
+    /* no port has an rxlos attribute */
+    CHECK(xcvr_get_port_bitmap(XCVR_RXLOS, bitmap) == NUM_PORTS - 1);
+    CHECK(bitmap[0] == 0);
+
+    ports_unbind();
+}
+
+int main(void)
+{
+    cpld_client.addr = CPLD_ADDR;
+
+    test_sharing();
+    test_default_uncached();
+    test_snapshot_window();
+    test_error_not_cached();
+    test_invalidate();
+    test_bitmap_ports();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pddf xcvr snapshot: all tests passed\n");
+    return 0;
+}
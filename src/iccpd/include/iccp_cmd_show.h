@@ -24,13 +24,40 @@
 #ifndef _ICCP_CMD_SHOW_H
 #define _ICCP_CMD_SHOW_H
 
+#include <stdint.h>
+
 #define ICCP_MAX_PORT_NAME 20
 #define ICCP_MAX_IP_STR_LEN 16
 
 extern int iccp_mclag_config_dump(char * *buf, int *num, int mclag_id);
-extern int iccp_arp_dump(char * *buf, int *num, int mclag_id);
-extern int iccp_ndisc_dump(char * *buf, int *num, int mclag_id);
-extern int iccp_mac_dump(char * *buf, int *num, int mclag_id);
+
+/* Raw copy of the MAC, ARP or ND entries of a dump. The protocol thread
+ * takes it; the reply is formatted from it by the thread serving
+ * mclagdctl, so large dumps are not built on the protocol thread. */
+struct iccp_dump_snapshot
+{
+    int info_type; /* INFO_TYPE_DUMP_MAC, ARP or NDISC */
+    int mclag_id;
+    int exec_result;
+    uint32_t num;
+    char *entries; /* struct MACMsg, ARPMsg or NDISCMsg */
+};
+
+extern int iccp_dump_table_type(int info_type);
+extern int iccp_dump_is_page_type(int info_type);
+extern int iccp_dump_reply_entry_size(int info_type);
+extern int iccp_dump_snapshot_take(struct iccp_dump_snapshot *snap, int info_type, int mclag_id);
+extern void iccp_dump_snapshot_free(struct iccp_dump_snapshot *snap);
+extern void iccp_dump_snapshot_format_entry(struct iccp_dump_snapshot *snap, uint32_t idx, void *reply_entry);
+extern int iccp_dump_snapshot_format(struct iccp_dump_snapshot *snap, char * *buf, int *num);
+
+struct mclagdctl_dump_filter;
+struct mclagdctl_dump_cursor;
+extern struct iccp_dump_snapshot *iccp_dump_snapshot_cache_get(uint32_t id, int info_type, int mclag_id);
+extern uint32_t iccp_dump_snapshot_cache_put(struct iccp_dump_snapshot *snap);
+extern void iccp_dump_snapshot_cache_drop(uint32_t id);
+extern int iccp_dump_snapshot_page(struct iccp_dump_snapshot *snap, struct mclagdctl_dump_filter *filter,
+                                   struct mclagdctl_dump_cursor *cursor, char * *buf, int *num);
 extern int iccp_local_if_dump(char * *buf, int *num, int mclag_id);
 extern int iccp_peer_if_dump(char * *buf, int *num, int mclag_id);
 extern int iccp_cmd_dbg_counter_dump(char * *buf, int *data_len, int mclag_id);
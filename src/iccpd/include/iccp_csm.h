@@ -110,6 +110,8 @@ struct CSM
     time_t connTimePrev;
     time_t heartbeat_send_time;
     time_t heartbeat_update_time;
+    uint64_t heartbeat_send_msec;   /* for heartbeat jitter debug counters */
+    uint64_t heartbeat_update_msec;
     time_t peer_warm_reboot_time;
     time_t warm_reboot_disconn_time;
     char peer_itf_name[IFNAMSIZ];
@@ -0,0 +1,37 @@
+/*
+ * iccp_ctl_worker.h
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#ifndef ICCP_CTL_WORKER_H_
+#define ICCP_CTL_WORKER_H_
+
+#include <stdint.h>
+
+struct System;
+
+/* Max number of mclagdctl requests/replies in flight between the
+ * protocol thread and the mclagdctl worker thread, must be a power of 2 */
+#define ICCP_CTL_RING_SIZE 64
+
+int iccp_ctl_worker_start(struct System *sys);
+void iccp_ctl_worker_stop(struct System *sys);
+int iccp_ctl_worker_running();
+int iccp_ctl_worker_handle_requests(struct System *sys);
+int iccp_ctl_worker_post_reply(int client_fd, char **buf, int len);
+
+#endif /* ICCP_CTL_WORKER_H_ */
@@ -0,0 +1,39 @@
+/*
+ * iccp_ingest.h
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#ifndef ICCP_INGEST_H_
+#define ICCP_INGEST_H_
+
+struct System;
+
+/* Max number of kernel/mclagsyncd messages read ahead of the protocol
+ * thread, must be a power of 2 */
+#define ICCP_INGEST_RING_SIZE 4096
+
+/* Max number of messages applied per protocol thread loop, so that peer
+ * messages and heartbeats are handled in between during bursts */
+#define ICCP_INGEST_BATCH 256
+
+int iccp_ingest_start(struct System *sys);
+void iccp_ingest_stop(struct System *sys);
+int iccp_ingest_running();
+int iccp_ingest_watch_syncd(struct System *sys, int fd);
+int iccp_ingest_handle_msgs(struct System *sys);
+
+#endif /* ICCP_INGEST_H_ */
@@ -44,6 +44,15 @@ struct nd_msg
     __u8 opt[0];
 };
 
+/* Neighbor learnt from an ARP reply or a neighbor advertisement */
+struct iccp_neigh_reply
+{
+    int family;
+    unsigned int ifindex;
+    uint8_t addr[16];
+    uint8_t mac_addr[ETHER_ADDR_LEN];
+};
+
 struct in6_pktinfo
 {
     struct in6_addr ipi6_addr;  /* src/dst IPv6 address */
@@ -57,6 +66,11 @@ int iccp_system_init_netlink_socket();
 void iccp_system_dinit_netlink_socket();
 int iccp_init_netlink_event_fd(struct System *sys);
 int iccp_handle_events(struct System *sys);
+int iccp_recv_arp_reply(struct System *sys, struct iccp_neigh_reply *reply);
+int iccp_recv_ndisc_reply(struct System *sys, struct iccp_neigh_reply *reply);
+void iccp_neigh_reply_apply(struct iccp_neigh_reply *reply);
+int iccp_netlink_dispatch_events(struct System *sys, int protocol, void *buf, int len);
+void iccp_netlink_event_error(struct System *sys, int protocol, int err);
 void update_if_ipmac_on_standby(struct LocalInterface *lif_po, int dir);
 int iccp_sys_local_if_list_get_addr();
 int iccp_netlink_neighbor_request(int family, uint8_t *addr, int add, uint8_t *mac, char *portname, int permanent, int dir);
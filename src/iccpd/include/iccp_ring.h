@@ -0,0 +1,44 @@
+/*
+ * iccp_ring.h
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#ifndef ICCP_RING_H_
+#define ICCP_RING_H_
+
+#include <stdint.h>
+
+/* Single producer / single consumer lock-free ring of pointers, the
+ * threads on both ends are woken up through eventfds */
+struct iccp_ring
+{
+    void **slot;
+    uint32_t size; /* power of 2 */
+    uint32_t head; /* written by the producer only */
+    uint32_t tail; /* written by the consumer only */
+};
+
+int iccp_ring_init(struct iccp_ring *ring, uint32_t size);
+void iccp_ring_free(struct iccp_ring *ring);
+int iccp_ring_push(struct iccp_ring *ring, void *entry);
+void *iccp_ring_pop(struct iccp_ring *ring);
+uint32_t iccp_ring_count(struct iccp_ring *ring);
+
+void iccp_efd_signal(int efd);
+void iccp_efd_drain(int efd);
+
+#endif /* ICCP_RING_H_ */
@@ -61,6 +61,13 @@ uint8_t set_mac_local_age_flag(struct CSM *csm, struct MACMsg* mac_msg, uint8_t
 extern int mclagd_ctl_sock_create();
 extern int mclagd_ctl_sock_accept(int fd);
 extern int mclagd_ctl_interactive_process(int client_fd);
+struct mclagdctl_req_hdr;
+extern int mclagd_ctl_dispatch_req(int client_fd, struct mclagdctl_req_hdr *req);
+struct iccp_dump_snapshot;
+extern int mclagd_ctl_build_snapshot_reply(struct iccp_dump_snapshot *snap, char **reply);
+extern int mclagd_ctl_build_page_reply(struct mclagdctl_req_hdr *req, struct iccp_dump_snapshot *snap, char **reply);
+extern int mclagd_ctl_sock_read(int fd, char *r_buf, int total_len);
+extern int mclagd_ctl_sock_write(int fd, char *w_buf, int total_len);
 extern int parseMacString(const char *str_mac, uint8_t *bin_mac);
 
 char *show_ip_str(uint32_t ipv4_addr);
@@ -83,6 +90,9 @@ void mlacp_mlag_intf_detach_handler(struct CSM* csm, struct LocalInterface* loca
 void mlacp_peer_mlag_intf_delete_handler(struct CSM* csm, char *mlag_if_name);
 
 int iccp_mclagsyncd_msg_handler(struct System *sys);
+int iccp_mclagsyncd_recv(struct System *sys, int fd, char *msg_buf,
+                         void (*msg_cb)(struct System *sys, char *msg));
+void iccp_mclagsyncd_dispatch_msg(struct System *sys, char *msg);
 int syn_local_neigh_mac_info_to_peer(struct LocalInterface *local_if, int sync_add,
         int is_v4, int is_v6, int sync_mac, int ack, int is_ipv6_ll, int dir);
 int syn_local_mac_info_to_peer(struct CSM* csm, struct LocalInterface *local_if, int sync_add, int is_sag);
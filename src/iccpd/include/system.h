@@ -118,6 +118,9 @@ enum SYNCD_RX_DBG_CNTR_MSG_e
     SYNCD_RX_DBG_CNTR_MSG_MAX
 };
 
+/* The socket read error counters are also updated by the ingestion
+ * thread, see iccp_ingest.c */
+
 /* Count messages ICCP daemon sent to MclagSyncd */
 #define SYSTEM_SET_SYNCD_TX_DBG_COUNTER(sys, syncd_msg_type, status)\
 do{\
@@ -164,23 +167,23 @@ do{\
 
 #define SYSTEM_INCR_RX_READ_SOCK_ZERO_COUNTER(sys)\
    if (sys)\
-       ++sys->dbg_counters.rx_read_sock_zero_len_counter;
+       __atomic_fetch_add(&sys->dbg_counters.rx_read_sock_zero_len_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_HDR_READ_SOCK_ERR_COUNTER(sys)\
     if (sys)\
-        ++sys->dbg_counters.rx_peer_hdr_read_sock_err_counter;
+        __atomic_fetch_add(&sys->dbg_counters.rx_peer_hdr_read_sock_err_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_HDR_READ_SOCK_ZERO_LEN_COUNTER(sys)\
     if (sys)\
-        ++sys->dbg_counters.rx_peer_hdr_read_sock_zero_len_counter;
+        __atomic_fetch_add(&sys->dbg_counters.rx_peer_hdr_read_sock_zero_len_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_TLV_READ_SOCK_ERR_COUNTER(sys)\
     if (sys)\
-        ++sys->dbg_counters.rx_peer_tlv_read_sock_err_counter;
+        __atomic_fetch_add(&sys->dbg_counters.rx_peer_tlv_read_sock_err_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_TLV_READ_SOCK_ZERO_LEN_COUNTER(sys)\
     if (sys)\
-        ++sys->dbg_counters.rx_peer_tlv_read_sock_zero_len_counter;
+        __atomic_fetch_add(&sys->dbg_counters.rx_peer_tlv_read_sock_zero_len_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_SOCKET_CLOSE_ERR_COUNTER(sys)\
     if (sys)\
@@ -192,7 +195,7 @@ do{\
 
 #define SYSTEM_INCR_RX_RETRY_FAIL_COUNTER(sys)\
     if (sys)\
-        ++sys->dbg_counters.rx_retry_fail_counter;
+        __atomic_fetch_add(&sys->dbg_counters.rx_retry_fail_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_MAC_ENTRY_ALLOC_COUNTER(sys)\
     if (sys)\
@@ -204,7 +207,7 @@ do{\
 
 #define SYSTEM_INCR_RX_READ_SOCK_ZERO_COUNTER(sys)\
     if (sys)\
-        ++sys->dbg_counters.rx_read_sock_zero_len_counter;
+        __atomic_fetch_add(&sys->dbg_counters.rx_read_sock_zero_len_counter, 1, __ATOMIC_RELAXED);
 
 #define SYSTEM_INCR_RX_READ_SOCK_ERR_COUNTER(sys)\
     if (sys)\
@@ -288,6 +291,15 @@ typedef struct system_dbg_counter_info
     uint32_t mac_entry_alloc_counter;
     uint32_t mac_entry_free_counter;
 
+    uint32_t hb_tx_interval_max_msec; //max interval between two heartbeats sent to peer
+    uint32_t hb_tx_late_counter; //heartbeats sent more than keepalive interval + 2s after the previous one
+    uint32_t hb_rx_interval_max_msec; //max interval between two heartbeats received from peer
+    uint32_t ctl_req_counter; //mclagdctl requests served by the worker thread
+    uint32_t ctl_req_drop_counter; //mclagdctl requests dropped, too many pending
+    uint32_t ingest_msg_counter; //kernel/mclagsyncd messages applied from the ingestion thread
+    uint32_t ingest_backlog_max; //max messages waiting for the protocol thread
+    uint32_t ingest_stall_counter; //ingestion thread waited for the protocol thread to catch up
+
     uint64_t syncd_tx_counters[SYNCD_TX_DBG_CNTR_MSG_MAX][SYNCD_DBG_CNTR_STS_MAX];
     uint64_t syncd_rx_counters[SYNCD_RX_DBG_CNTR_MSG_MAX][SYNCD_DBG_CNTR_STS_MAX];
 }system_dbg_counter_info_t;
@@ -297,6 +309,8 @@ struct System
     int server_fd;/* Peer-Link Socket*/
     int sync_fd;
     int sync_ctrl_fd;
+    int ctl_req_fd; /* mclagdctl worker thread request eventfd */
+    int ingest_fd; /* ingestion thread message eventfd */
     int arp_receive_fd;
     int ndisc_receive_fd;
     int epoll_fd;
@@ -350,6 +364,7 @@ SYNCD_TX_DBG_CNTR_MSG_e system_syncdtx_to_dbg_msg_type(uint32_t msg_type);
 SYNCD_RX_DBG_CNTR_MSG_e system_syncdrx_to_dbg_msg_type(uint32_t msg_type);
 
 char *mac_addr_to_str(uint8_t mac_addr[ETHER_ADDR_LEN]);
+uint64_t system_get_monotonic_msec();
 void system_update_netlink_counters(uint16_t netlink_msg_type, struct nlmsghdr *nlh);
 
 #endif /* SYSTEM_H_ */
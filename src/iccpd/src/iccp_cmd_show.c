@@ -150,26 +150,127 @@ int iccp_mclag_config_dump(char * *buf,  int *num, int mclag_id)
     return EXEC_TYPE_SUCCESS;
 }
 
-int iccp_arp_dump(char * *buf, int *num, int mclag_id)
+/*****************************************
+* MAC/ARP/ND dump snapshots
+*
+* ***************************************/
+/* Table dumped by a MAC/ARP/ND dump request, whole or paged, or 0 */
+int iccp_dump_table_type(int info_type)
+{
+    switch (info_type)
+    {
+        case INFO_TYPE_DUMP_MAC:
+        case INFO_TYPE_DUMP_MAC_PAGE:
+            return INFO_TYPE_DUMP_MAC;
+
+        case INFO_TYPE_DUMP_ARP:
+        case INFO_TYPE_DUMP_ARP_PAGE:
+            return INFO_TYPE_DUMP_ARP;
+
+        case INFO_TYPE_DUMP_NDISC:
+        case INFO_TYPE_DUMP_NDISC_PAGE:
+            return INFO_TYPE_DUMP_NDISC;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+int iccp_dump_is_page_type(int info_type)
+{
+    return iccp_dump_table_type(info_type) != 0 && iccp_dump_table_type(info_type) != info_type;
+}
+
+static int iccp_dump_snapshot_entry_size(int info_type)
+{
+    switch (info_type)
+    {
+        case INFO_TYPE_DUMP_MAC:
+            return sizeof(struct MACMsg);
+
+        case INFO_TYPE_DUMP_ARP:
+            return sizeof(struct ARPMsg);
+
+        case INFO_TYPE_DUMP_NDISC:
+            return sizeof(struct NDISCMsg);
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+int iccp_dump_reply_entry_size(int info_type)
+{
+    switch (info_type)
+    {
+        case INFO_TYPE_DUMP_MAC:
+            return sizeof(struct mclagd_mac_msg);
+
+        case INFO_TYPE_DUMP_ARP:
+            return sizeof(struct mclagd_arp_msg);
+
+        case INFO_TYPE_DUMP_NDISC:
+            return sizeof(struct mclagd_ndisc_msg);
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+static int iccp_dump_snapshot_add(struct iccp_dump_snapshot *snap, uint32_t *size, void *entry, int entry_size)
+{
+    char *entries = NULL;
+    uint32_t new_size;
+
+    if (snap->num == *size)
+    {
+        new_size = (*size) ? (*size) * 2 : 256;
+        entries = (char*)realloc(snap->entries, new_size * entry_size);
+        if (!entries)
+            return MCLAG_ERROR;
+        snap->entries = entries;
+        *size = new_size;
+    }
+
+    memcpy(snap->entries + snap->num * entry_size, entry, entry_size);
+    snap->num++;
+
+    return 0;
+}
+
+/* Copy the raw MAC, ARP or ND entries of one or all mclag ids, info_type
+ * is a whole or paged dump request type. Called by
+ * the protocol thread, which owns the tables; nothing is formatted here.
+ * Returns the exec result, also kept in the snapshot. */
+int iccp_dump_snapshot_take(struct iccp_dump_snapshot *snap, int info_type, int mclag_id)
 {
     struct System *sys = NULL;
     struct CSM *csm = NULL;
     struct Msg *msg = NULL;
-    struct ARPMsg *iccpd_arp = NULL;
-    struct mclagd_arp_msg mclagd_arp;
-    int arp_num = 0;
+    struct MACMsg *iccpd_mac = NULL;
+    int entry_size = 0;
+    uint32_t size = 0;
     int id_exist = 0;
-    char * arp_buf = NULL;
-    int arp_buf_size = MCLAGDCTL_CMD_SIZE;
+    int ret = 0;
+
+    info_type = iccp_dump_table_type(info_type);
+    entry_size = iccp_dump_snapshot_entry_size(info_type);
+
+    memset(snap, 0, sizeof(struct iccp_dump_snapshot));
+    snap->info_type = info_type;
+    snap->mclag_id = mclag_id;
 
     if (!(sys = system_get_instance()))
-    {
-        return EXEC_TYPE_NO_EXIST_SYS;
-    }
+        return snap->exec_result = EXEC_TYPE_NO_EXIST_SYS;
 
-    arp_buf = (char*)malloc(arp_buf_size);
-    if (!arp_buf)
-        return EXEC_TYPE_FAILED;
+    if (entry_size == 0)
+        return snap->exec_result = EXEC_TYPE_FAILED;
 
     LIST_FOREACH(csm, &(sys->csm_list), next)
     {
@@ -181,169 +282,318 @@ int iccp_arp_dump(char * *buf, int *num, int mclag_id)
                 continue;
         }
 
-        TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+        if (info_type == INFO_TYPE_DUMP_MAC)
         {
-            memset(&mclagd_arp, 0, sizeof(struct mclagd_arp_msg));
-            iccpd_arp = (struct ARPMsg*)msg->buf;
-
-            mclagd_arp.op_type = iccpd_arp->op_type;
-            mclagd_arp.learn_flag = iccpd_arp->learn_flag;
-            memcpy(mclagd_arp.ifname, iccpd_arp->ifname, strlen(iccpd_arp->ifname));
-            memcpy(mclagd_arp.ipv4_addr, show_ip_str(iccpd_arp->ipv4_addr), 16);
-            memcpy(mclagd_arp.mac_addr, iccpd_arp->mac_addr, 6);
-
-            memcpy(arp_buf + MCLAGD_REPLY_INFO_HDR + arp_num * sizeof(struct mclagd_arp_msg),
-                   &mclagd_arp, sizeof(struct mclagd_arp_msg));
-
-            arp_num++;
-
-            if ((arp_num + 1) * sizeof(struct mclagd_arp_msg) > (arp_buf_size - MCLAGD_REPLY_INFO_HDR))
+            RB_FOREACH (iccpd_mac, mac_rb_tree, &MLACP(csm).mac_rb)
             {
-                arp_buf_size += MCLAGDCTL_CMD_SIZE;
-                arp_buf = (char*)realloc(arp_buf, arp_buf_size);
-                if (!arp_buf)
-                    return EXEC_TYPE_FAILED;
+                if ((ret = iccp_dump_snapshot_add(snap, &size, iccpd_mac, entry_size)) < 0)
+                    break;
+            }
+        }
+        else if (info_type == INFO_TYPE_DUMP_ARP)
+        {
+            TAILQ_FOREACH(msg, &MLACP(csm).arp_list, tail)
+            {
+                if ((ret = iccp_dump_snapshot_add(snap, &size, msg->buf, entry_size)) < 0)
+                    break;
+            }
+        }
+        else
+        {
+            TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+            {
+                if ((ret = iccp_dump_snapshot_add(snap, &size, msg->buf, entry_size)) < 0)
+                    break;
             }
         }
-    }
 
-    *buf = arp_buf;
-    *num = arp_num;
+        if (ret < 0)
+        {
+            iccp_dump_snapshot_free(snap);
+            return snap->exec_result = EXEC_TYPE_FAILED;
+        }
+    }
 
     if (mclag_id > 0 && !id_exist)
-        return EXEC_TYPE_NO_EXIST_MCLAGID;
+        snap->exec_result = EXEC_TYPE_NO_EXIST_MCLAGID;
+    else
+        snap->exec_result = EXEC_TYPE_SUCCESS;
 
-    return EXEC_TYPE_SUCCESS;
+    return snap->exec_result;
 }
 
-int iccp_ndisc_dump(char * *buf, int *num, int mclag_id)
+void iccp_dump_snapshot_free(struct iccp_dump_snapshot *snap)
 {
-    struct System *sys = NULL;
-    struct CSM *csm = NULL;
-    struct Msg *msg = NULL;
+    if (snap->entries)
+        free(snap->entries);
+    snap->entries = NULL;
+    snap->num = 0;
+}
+
+/* Format snapshot entry idx into its mclagdctl reply entry. Only uses the
+ * snapshot and inet_ntop, so it is safe off the protocol thread; the
+ * show_ip_str() helpers share a static buffer and are not. */
+void iccp_dump_snapshot_format_entry(struct iccp_dump_snapshot *snap, uint32_t idx, void *reply_entry)
+{
+    void *entry = snap->entries + idx * iccp_dump_snapshot_entry_size(snap->info_type);
+    struct MACMsg *iccpd_mac = NULL;
+    struct ARPMsg *iccpd_arp = NULL;
     struct NDISCMsg *iccpd_ndisc = NULL;
-    struct mclagd_ndisc_msg mclagd_ndisc;
-    int ndisc_num = 0;
-    int id_exist = 0;
-    char *ndisc_buf = NULL;
-    int ndisc_buf_size = MCLAGDCTL_CMD_SIZE;
+    struct mclagd_mac_msg *mclagd_mac = NULL;
+    struct mclagd_arp_msg *mclagd_arp = NULL;
+    struct mclagd_ndisc_msg *mclagd_ndisc = NULL;
+    struct in_addr in_addr;
 
-    if (!(sys = system_get_instance()))
+    memset(reply_entry, 0, iccp_dump_reply_entry_size(snap->info_type));
+
+    if (snap->info_type == INFO_TYPE_DUMP_MAC)
     {
-        return EXEC_TYPE_NO_EXIST_SYS;
+        iccpd_mac = (struct MACMsg *)entry;
+        mclagd_mac = (struct mclagd_mac_msg *)reply_entry;
+        mclagd_mac->op_type = iccpd_mac->op_type;
+        mclagd_mac->fdb_type = iccpd_mac->fdb_type;
+        memcpy(mclagd_mac->mac_addr, iccpd_mac->mac_addr, ETHER_ADDR_LEN);
+        mclagd_mac->vid = iccpd_mac->vid;
+        memcpy(mclagd_mac->ifname, iccpd_mac->ifname, strlen(iccpd_mac->ifname));
+        memcpy(mclagd_mac->origin_ifname, iccpd_mac->origin_ifname, strlen(iccpd_mac->origin_ifname));
+        mclagd_mac->age_flag = iccpd_mac->age_flag;
+    }
+    else if (snap->info_type == INFO_TYPE_DUMP_ARP)
+    {
+        iccpd_arp = (struct ARPMsg *)entry;
+        mclagd_arp = (struct mclagd_arp_msg *)reply_entry;
+        mclagd_arp->op_type = iccpd_arp->op_type;
+        mclagd_arp->learn_flag = iccpd_arp->learn_flag;
+        memcpy(mclagd_arp->ifname, iccpd_arp->ifname, strlen(iccpd_arp->ifname));
+        in_addr.s_addr = iccpd_arp->ipv4_addr;
+        inet_ntop(AF_INET, &in_addr, mclagd_arp->ipv4_addr, INET_ADDRSTRLEN);
+        memcpy(mclagd_arp->mac_addr, iccpd_arp->mac_addr, 6);
+    }
+    else
+    {
+        iccpd_ndisc = (struct NDISCMsg *)entry;
+        mclagd_ndisc = (struct mclagd_ndisc_msg *)reply_entry;
+        mclagd_ndisc->op_type = iccpd_ndisc->op_type;
+        mclagd_ndisc->learn_flag = iccpd_ndisc->learn_flag;
+        memcpy(mclagd_ndisc->ifname, iccpd_ndisc->ifname, strlen(iccpd_ndisc->ifname));
+        inet_ntop(AF_INET6, iccpd_ndisc->ipv6_addr, mclagd_ndisc->ipv6_addr, INET6_ADDRSTRLEN);
+        memcpy(mclagd_ndisc->mac_addr, iccpd_ndisc->mac_addr, 6);
     }
+}
+
+/* Build the whole table reply of a snapshot: reply header, then entries */
+int iccp_dump_snapshot_format(struct iccp_dump_snapshot *snap, char * *buf, int *num)
+{
+    int reply_size = iccp_dump_reply_entry_size(snap->info_type);
+    char *reply_buf = NULL;
+    uint32_t i;
+
+    if (snap->exec_result != EXEC_TYPE_SUCCESS)
+        return snap->exec_result;
 
-    ndisc_buf = (char *)malloc(ndisc_buf_size);
-    if (!ndisc_buf)
+    reply_buf = (char*)malloc(MCLAGD_REPLY_INFO_HDR + snap->num * reply_size);
+    if (!reply_buf)
         return EXEC_TYPE_FAILED;
 
-    LIST_FOREACH(csm, &(sys->csm_list), next)
+    for (i = 0; i < snap->num; i++)
+        iccp_dump_snapshot_format_entry(snap, i, reply_buf + MCLAGD_REPLY_INFO_HDR + i * reply_size);
+
+    *buf = reply_buf;
+    *num = snap->num;
+
+    return EXEC_TYPE_SUCCESS;
+}
+
+/*****************************************
+* Paged MAC/ARP/ND dump
+*
+* ***************************************/
+/* Snapshots of the paged dumps in progress, all the pages of a dump are
+ * read from the snapshot taken for its first page. Only used by the
+ * thread serving mclagdctl: the worker thread, or the protocol thread
+ * when requests are served inline. */
+#define ICCP_DUMP_CACHE_SIZE      4
+#define ICCP_DUMP_CACHE_AGE_MSEC  (60 * 1000)
+
+struct iccp_dump_cache_entry
+{
+    uint32_t id;
+    uint64_t last_used_msec;
+    struct iccp_dump_snapshot snap;
+};
+
+static struct iccp_dump_cache_entry g_dump_cache[ICCP_DUMP_CACHE_SIZE];
+static uint32_t g_dump_cache_next_id = 1;
+
+static void iccp_dump_cache_release(struct iccp_dump_cache_entry *entry)
+{
+    iccp_dump_snapshot_free(&entry->snap);
+    entry->id = 0;
+}
+
+/* Find the snapshot of a paged dump, expired snapshots are released */
+struct iccp_dump_snapshot *iccp_dump_snapshot_cache_get(uint32_t id, int info_type, int mclag_id)
+{
+    struct iccp_dump_cache_entry *entry = NULL;
+    struct iccp_dump_snapshot *snap = NULL;
+    uint64_t now_msec = system_get_monotonic_msec();
+    int i;
+
+    for (i = 0; i < ICCP_DUMP_CACHE_SIZE; i++)
     {
-        if (mclag_id > 0)
+        entry = &g_dump_cache[i];
+        if (entry->id == 0)
+            continue;
+
+        if (now_msec - entry->last_used_msec > ICCP_DUMP_CACHE_AGE_MSEC)
         {
-            if (csm->mlag_id == mclag_id)
-                id_exist = 1;
-            else
-                continue;
+            iccp_dump_cache_release(entry);
+            continue;
         }
 
-        TAILQ_FOREACH(msg, &MLACP(csm).ndisc_list, tail)
+        if (entry->id == id && entry->snap.info_type == iccp_dump_table_type(info_type)
+            && entry->snap.mclag_id == mclag_id)
         {
-            memset(&mclagd_ndisc, 0, sizeof(struct mclagd_ndisc_msg));
-            iccpd_ndisc = (struct NDISCMsg *)msg->buf;
-
-            mclagd_ndisc.op_type = iccpd_ndisc->op_type;
-            mclagd_ndisc.learn_flag = iccpd_ndisc->learn_flag;
-            memcpy(mclagd_ndisc.ifname, iccpd_ndisc->ifname, strlen(iccpd_ndisc->ifname));
-            memcpy(mclagd_ndisc.ipv6_addr, show_ipv6_str((char *)iccpd_ndisc->ipv6_addr), 46);
-            memcpy(mclagd_ndisc.mac_addr, iccpd_ndisc->mac_addr, 6);
+            entry->last_used_msec = now_msec;
+            snap = &entry->snap;
+        }
+    }
 
-            memcpy(ndisc_buf + MCLAGD_REPLY_INFO_HDR + ndisc_num * sizeof(struct mclagd_ndisc_msg), &mclagd_ndisc, sizeof(struct mclagd_ndisc_msg));
+    return snap;
+}
 
-            ndisc_num++;
+/* Move a snapshot into the cache, replacing the least recently used one
+ * if it is full. Returns the id of the cached snapshot. */
+uint32_t iccp_dump_snapshot_cache_put(struct iccp_dump_snapshot *snap)
+{
+    struct iccp_dump_cache_entry *entry = &g_dump_cache[0];
+    int i;
 
-            if ((ndisc_num + 1) * sizeof(struct mclagd_ndisc_msg) > (ndisc_buf_size - MCLAGD_REPLY_INFO_HDR))
-            {
-                ndisc_buf_size += MCLAGDCTL_CMD_SIZE;
-                ndisc_buf = (char *)realloc(ndisc_buf, ndisc_buf_size);
-                if (!ndisc_buf)
-                    return EXEC_TYPE_FAILED;
-            }
+    for (i = 0; i < ICCP_DUMP_CACHE_SIZE; i++)
+    {
+        if (g_dump_cache[i].id == 0)
+        {
+            entry = &g_dump_cache[i];
+            break;
         }
+        if (g_dump_cache[i].last_used_msec < entry->last_used_msec)
+            entry = &g_dump_cache[i];
     }
 
-    *buf = ndisc_buf;
-    *num = ndisc_num;
+    iccp_dump_cache_release(entry);
 
-    if (mclag_id > 0 && !id_exist)
-        return EXEC_TYPE_NO_EXIST_MCLAGID;
+    entry->snap = *snap;
+    snap->entries = NULL;
+    snap->num = 0;
+    entry->last_used_msec = system_get_monotonic_msec();
+    entry->id = g_dump_cache_next_id++;
+    if (g_dump_cache_next_id == 0)
+        g_dump_cache_next_id = 1;
 
-    return EXEC_TYPE_SUCCESS;
+    return entry->id;
 }
 
-int iccp_mac_dump(char * *buf, int *num, int mclag_id)
+void iccp_dump_snapshot_cache_drop(uint32_t id)
 {
-    struct System *sys = NULL;
-    struct CSM *csm = NULL;
-    struct Msg *msg = NULL;
-    struct MACMsg *iccpd_mac = NULL;
-    struct mclagd_mac_msg mclagd_mac;
-    int mac_num = 0;
-    int id_exist = 0;
-    char * mac_buf = NULL;
-    int mac_buf_size = MCLAGDCTL_CMD_SIZE;
+    int i;
 
-    if (!(sys = system_get_instance()))
+    for (i = 0; i < ICCP_DUMP_CACHE_SIZE; i++)
     {
-        return EXEC_TYPE_NO_EXIST_SYS;
+        if (g_dump_cache[i].id == id)
+            iccp_dump_cache_release(&g_dump_cache[i]);
     }
+}
 
-    mac_buf = (char*)malloc(mac_buf_size);
-    if (!mac_buf)
-        return EXEC_TYPE_FAILED;
+static int iccp_dump_filter_match(struct mclagdctl_dump_filter *filter, int vid,
+                                  uint8_t *mac_addr, const char *ifname, const char *origin_ifname)
+{
+    int if_vid = 0;
 
-    LIST_FOREACH(csm, &(sys->csm_list), next)
+    if (filter->vid)
     {
-        if (mclag_id > 0)
-        {
-            if (csm->mlag_id == mclag_id)
-                id_exist = 1;
-            else
-                continue;
-        }
+        /* Neighbor entries carry the VLAN in their L3 interface name */
+        if (vid == 0 && ifname && sscanf(ifname, "Vlan%d", &if_vid) == 1)
+            vid = if_vid;
+        if (vid != filter->vid)
+            return 0;
+    }
 
-        RB_FOREACH (iccpd_mac, mac_rb_tree, &MLACP(csm).mac_rb)
-        {
-            memset(&mclagd_mac, 0, sizeof(struct mclagd_mac_msg));
+    if (filter->mac_prefix_len
+        && memcmp(mac_addr, filter->mac_prefix, filter->mac_prefix_len) != 0)
+        return 0;
 
-            mclagd_mac.op_type = iccpd_mac->op_type;
-            mclagd_mac.fdb_type = iccpd_mac->fdb_type;
-            memcpy(mclagd_mac.mac_addr, iccpd_mac->mac_addr, ETHER_ADDR_LEN);
-            mclagd_mac.vid = iccpd_mac->vid;
-            memcpy(mclagd_mac.ifname, iccpd_mac->ifname, strlen(iccpd_mac->ifname));
-            memcpy(mclagd_mac.origin_ifname, iccpd_mac->origin_ifname, strlen(iccpd_mac->origin_ifname));
-            mclagd_mac.age_flag = iccpd_mac->age_flag;
+    if (filter->ifname[0])
+    {
+        if (strncmp(ifname, filter->ifname, MCLAGDCTL_DUMP_IFNAME_LEN) != 0
+            && !(origin_ifname && strncmp(origin_ifname, filter->ifname, MCLAGDCTL_DUMP_IFNAME_LEN) == 0))
+            return 0;
+    }
 
-            memcpy(mac_buf + MCLAGD_REPLY_INFO_HDR + mac_num * sizeof(struct mclagd_mac_msg),
-                   &mclagd_mac, sizeof(struct mclagd_mac_msg));
+    return 1;
+}
 
-            mac_num++;
+static int iccp_dump_snapshot_match(struct iccp_dump_snapshot *snap, uint32_t idx,
+                                    struct mclagdctl_dump_filter *filter)
+{
+    void *entry = snap->entries + idx * iccp_dump_snapshot_entry_size(snap->info_type);
+    struct MACMsg *iccpd_mac = NULL;
+    struct ARPMsg *iccpd_arp = NULL;
+    struct NDISCMsg *iccpd_ndisc = NULL;
 
-            if ((mac_num + 1) * sizeof(struct mclagd_mac_msg) > (mac_buf_size - MCLAGD_REPLY_INFO_HDR))
-            {
-                mac_buf_size += MCLAGDCTL_CMD_SIZE;
-                mac_buf = (char*)realloc(mac_buf, mac_buf_size);
-                if (!mac_buf)
-                    return EXEC_TYPE_FAILED;
-            }
-        }
-        }
+    if (snap->info_type == INFO_TYPE_DUMP_MAC)
+    {
+        iccpd_mac = (struct MACMsg *)entry;
+        return iccp_dump_filter_match(filter, iccpd_mac->vid, iccpd_mac->mac_addr,
+                                      iccpd_mac->ifname, iccpd_mac->origin_ifname);
+    }
 
-    *buf = mac_buf;
-    *num = mac_num;
+    if (snap->info_type == INFO_TYPE_DUMP_ARP)
+    {
+        iccpd_arp = (struct ARPMsg *)entry;
+        return iccp_dump_filter_match(filter, 0, iccpd_arp->mac_addr, iccpd_arp->ifname, NULL);
+    }
 
-    if (mclag_id > 0 && !id_exist)
-        return EXEC_TYPE_NO_EXIST_MCLAGID;
+    iccpd_ndisc = (struct NDISCMsg *)entry;
+    return iccp_dump_filter_match(filter, 0, iccpd_ndisc->mac_addr, iccpd_ndisc->ifname, NULL);
+}
+
+/* Build one page from a snapshot: reply header, cursor, then entries.
+ * A page resumes at the cursor offset, so a full dump is linear in the
+ * table size. */
+int iccp_dump_snapshot_page(struct iccp_dump_snapshot *snap, struct mclagdctl_dump_filter *filter,
+                            struct mclagdctl_dump_cursor *cursor, char * *buf, int *num)
+{
+    int reply_size = iccp_dump_reply_entry_size(snap->info_type);
+    char *page_buf = NULL;
+    uint32_t page_num = 0;
+    uint32_t scan_end;
+    uint32_t pos;
+
+    if (cursor->page_size == 0 || cursor->page_size > MCLAGDCTL_DUMP_PAGE_SIZE_MAX)
+        cursor->page_size = MCLAGDCTL_DUMP_PAGE_SIZE;
+
+    page_buf = (char*)calloc(1, MCLAGD_REPLY_INFO_HDR + sizeof(struct mclagdctl_dump_cursor)
+                             + cursor->page_size * reply_size);
+    if (!page_buf)
+        return EXEC_TYPE_FAILED;
+
+    scan_end = cursor->offset + cursor->page_size * MCLAGDCTL_DUMP_SCAN_FACTOR;
+
+    for (pos = cursor->offset; pos < snap->num && pos < scan_end && page_num < cursor->page_size; pos++)
+    {
+        if (!iccp_dump_snapshot_match(snap, pos, filter))
+            continue;
+
+        iccp_dump_snapshot_format_entry(snap, pos, page_buf + MCLAGD_REPLY_INFO_HDR
+                                        + sizeof(struct mclagdctl_dump_cursor) + page_num * reply_size);
+        page_num++;
+    }
+
+    cursor->offset = pos;
+    cursor->started = 1;
+    cursor->more = (pos < snap->num);
+    *buf = page_buf;
+    *num = page_num;
 
     return EXEC_TYPE_SUCCESS;
 }
@@ -142,6 +142,8 @@ void iccp_csm_status_reset(struct CSM* csm, int all)
     csm->connTimePrev = 0;
     csm->heartbeat_send_time = 0;
     csm->heartbeat_update_time = 0;
+    csm->heartbeat_send_msec = 0;
+    csm->heartbeat_update_msec = 0;
     csm->peer_warm_reboot_time = 0;
     csm->warm_reboot_disconn_time = 0;
     csm->peer_link_learning_retry_time = 0;
@@ -0,0 +1,352 @@
+/*
+ * iccp_ctl_worker.c
+ *
+ * mclagdctl socket I/O thread. Accepting clients, reading requests and
+ * writing the (possibly large) dump replies is done here, so that a slow
+ * or large "mclagdctl dump" never stalls peer session handling. For the
+ * MAC/ARP/ND dumps the protocol thread, which owns all tables, only takes
+ * a raw snapshot of the entries; the reply is formatted here from it.
+ * The later pages of a paged dump are served here from the cached
+ * snapshot, without involving the protocol thread at all.
+ * The other, small, replies are built by the protocol thread and handed
+ * over. Jobs travel between the threads through lock-free rings.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "../include/system.h"
+#include "../include/logger.h"
+#include "../include/mlacp_link_handler.h"
+#include "../include/iccp_cmd_show.h"
+#include "../include/iccp_ring.h"
+#include "../include/iccp_ctl_worker.h"
+#include "mclagdctl/mclagdctl.h"
+
+struct iccp_ctl_job
+{
+    int client_fd;
+    struct mclagdctl_req_hdr req;
+    char *reply;
+    int reply_len;
+    int replied;
+    int has_snap; /* reply is formatted from snap by the worker */
+    struct iccp_dump_snapshot snap;
+};
+
+struct iccp_ctl_worker
+{
+    pthread_t thread;
+    int running;
+    int stop;
+    int listen_fd;
+    int req_efd;   /* worker -> protocol thread */
+    int reply_efd; /* protocol thread -> worker */
+    uint32_t inflight;
+    struct iccp_ring req_ring;
+    struct iccp_ring reply_ring;
+};
+
+static struct iccp_ctl_worker g_ctl_worker = { .listen_fd = -1, .req_efd = -1, .reply_efd = -1 };
+
+/* Job being dispatched by the protocol thread, see iccp_ctl_worker_post_reply */
+static struct iccp_ctl_job *g_ctl_cur_job = NULL;
+
+static void iccp_ctl_job_free(struct iccp_ctl_job *job)
+{
+    if (job->client_fd >= 0)
+        close(job->client_fd);
+    if (job->reply)
+        free(job->reply);
+    iccp_dump_snapshot_free(&job->snap);
+    free(job);
+    __atomic_fetch_sub(&g_ctl_worker.inflight, 1, __ATOMIC_RELAXED);
+}
+
+/*****************************************
+* Worker thread
+*
+* ***************************************/
+static void iccp_ctl_worker_accept(struct iccp_ctl_worker *worker)
+{
+    struct System *sys = system_get_instance();
+    struct iccp_ctl_job *job = NULL;
+    int client_fd;
+
+    client_fd = mclagd_ctl_sock_accept(worker->listen_fd);
+    if (client_fd < 0)
+        return;
+
+    if (__atomic_load_n(&worker->inflight, __ATOMIC_RELAXED) >= ICCP_CTL_RING_SIZE
+        || (job = (struct iccp_ctl_job *)calloc(1, sizeof(struct iccp_ctl_job))) == NULL)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Too many mclagdctl requests pending, drop client");
+        if (sys)
+            __atomic_fetch_add(&sys->dbg_counters.ctl_req_drop_counter, 1, __ATOMIC_RELAXED);
+        close(client_fd);
+        return;
+    }
+
+    __atomic_fetch_add(&worker->inflight, 1, __ATOMIC_RELAXED);
+    job->client_fd = client_fd;
+
+    /* Blocking read with timeout, only this thread waits for a slow client */
+    if (mclagd_ctl_sock_read(client_fd, (char *)&job->req, sizeof(struct mclagdctl_req_hdr)) < 0)
+    {
+        iccp_ctl_job_free(job);
+        return;
+    }
+
+    /* Pages after the first one are read from the cached snapshot */
+    if (iccp_dump_is_page_type(job->req.info_type)
+        && (job->reply_len = mclagd_ctl_build_page_reply(&job->req, NULL, &job->reply)) != 0)
+    {
+        if (sys)
+            __atomic_fetch_add(&sys->dbg_counters.ctl_req_counter, 1, __ATOMIC_RELAXED);
+        if (job->reply_len > 0)
+            mclagd_ctl_sock_write(job->client_fd, job->reply, job->reply_len);
+        iccp_ctl_job_free(job);
+        return;
+    }
+
+    /* Cannot fail, inflight is bounded by the ring size */
+    iccp_ring_push(&worker->req_ring, job);
+    iccp_efd_signal(worker->req_efd);
+}
+
+static void iccp_ctl_worker_send_replies(struct iccp_ctl_worker *worker)
+{
+    struct iccp_ctl_job *job = NULL;
+
+    while ((job = (struct iccp_ctl_job *)iccp_ring_pop(&worker->reply_ring)) != NULL)
+    {
+        if (job->has_snap)
+        {
+            if (iccp_dump_is_page_type(job->req.info_type))
+                job->reply_len = mclagd_ctl_build_page_reply(&job->req, &job->snap, &job->reply);
+            else
+                job->reply_len = mclagd_ctl_build_snapshot_reply(&job->snap, &job->reply);
+            iccp_dump_snapshot_free(&job->snap);
+        }
+        if (job->reply_len > 0)
+            mclagd_ctl_sock_write(job->client_fd, job->reply, job->reply_len);
+        iccp_ctl_job_free(job);
+    }
+}
+
+static void *iccp_ctl_worker_main(void *arg)
+{
+    struct iccp_ctl_worker *worker = (struct iccp_ctl_worker *)arg;
+    struct pollfd fds[2];
+
+    fds[0].fd = worker->listen_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = worker->reply_efd;
+    fds[1].events = POLLIN;
+
+    while (!__atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE))
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ICCPD_LOG_ERR(__FUNCTION__, "mclagdctl worker poll error: %s", strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            iccp_efd_drain(worker->reply_efd);
+            iccp_ctl_worker_send_replies(worker);
+        }
+
+        if (fds[0].revents & POLLIN)
+            iccp_ctl_worker_accept(worker);
+    }
+
+    return NULL;
+}
+
+/*****************************************
+* Protocol thread side
+*
+* ***************************************/
+int iccp_ctl_worker_running()
+{
+    return g_ctl_worker.running;
+}
+
+/* Called from the mclagdctl reply path while a job is being dispatched.
+ * The job takes the malloc'ed reply over, *buf is cleared. */
+int iccp_ctl_worker_post_reply(int client_fd, char **buf, int len)
+{
+    struct iccp_ctl_job *job = g_ctl_cur_job;
+
+    if (job == NULL || job->client_fd != client_fd || job->replied)
+        return MCLAG_ERROR;
+
+    job->reply = *buf;
+    job->reply_len = len;
+    job->replied = 1;
+    *buf = NULL;
+
+    return len;
+}
+
+/* MAC/ARP/ND dumps, whole or paged, only need a snapshot from the protocol thread */
+static int iccp_ctl_job_snapshot_only(struct iccp_ctl_job *job)
+{
+    return iccp_dump_table_type(job->req.info_type) != 0;
+}
+
+int iccp_ctl_worker_handle_requests(struct System *sys)
+{
+    struct iccp_ctl_job *job = NULL;
+
+    iccp_efd_drain(g_ctl_worker.req_efd);
+
+    while ((job = (struct iccp_ctl_job *)iccp_ring_pop(&g_ctl_worker.req_ring)) != NULL)
+    {
+        __atomic_fetch_add(&sys->dbg_counters.ctl_req_counter, 1, __ATOMIC_RELAXED);
+
+        if (iccp_ctl_job_snapshot_only(job))
+        {
+            iccp_dump_snapshot_take(&job->snap, job->req.info_type, job->req.mclag_id);
+            job->has_snap = 1;
+        }
+        else
+        {
+            g_ctl_cur_job = job;
+            mclagd_ctl_dispatch_req(job->client_fd, &job->req);
+            g_ctl_cur_job = NULL;
+        }
+
+        /* Unanswered requests are handed back too, the worker closes them */
+        iccp_ring_push(&g_ctl_worker.reply_ring, job);
+    }
+
+    iccp_efd_signal(g_ctl_worker.reply_efd);
+
+    return 0;
+}
+
+/* Move the mclagdctl listening socket from the main epoll loop to the
+ * worker thread. On failure the socket stays served inline. */
+int iccp_ctl_worker_start(struct System *sys)
+{
+    struct iccp_ctl_worker *worker = &g_ctl_worker;
+    struct epoll_event event;
+
+    if (sys == NULL || sys->sync_ctrl_fd <= 0 || worker->running)
+        return MCLAG_ERROR;
+
+    if (iccp_ring_init(&worker->req_ring, ICCP_CTL_RING_SIZE) < 0
+        || iccp_ring_init(&worker->reply_ring, ICCP_CTL_RING_SIZE) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to allocate mclagdctl worker rings");
+        goto err;
+    }
+
+    worker->req_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    worker->reply_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (worker->req_efd < 0 || worker->reply_efd < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to create mclagdctl worker eventfd: %s", strerror(errno));
+        goto err;
+    }
+
+    worker->listen_fd = sys->sync_ctrl_fd;
+    worker->stop = 0;
+
+    event.data.fd = worker->req_efd;
+    event.events = EPOLLIN;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, worker->req_efd, &event) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to add mclagdctl worker eventfd to epoll: %s", strerror(errno));
+        goto err;
+    }
+
+    if (pthread_create(&worker->thread, NULL, iccp_ctl_worker_main, worker) != 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to create mclagdctl worker thread");
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, worker->req_efd, NULL);
+        goto err;
+    }
+
+    epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, sys->sync_ctrl_fd, NULL);
+    FD_CLR(sys->sync_ctrl_fd, &(sys->readfd));
+    FD_SET(worker->req_efd, &(sys->readfd));
+    sys->ctl_req_fd = worker->req_efd;
+    worker->running = 1;
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "mclagdctl requests served by worker thread");
+
+    return 0;
+
+err:
+    if (worker->req_efd >= 0)
+        close(worker->req_efd);
+    if (worker->reply_efd >= 0)
+        close(worker->reply_efd);
+    worker->req_efd = worker->reply_efd = -1;
+    worker->listen_fd = -1;
+    iccp_ring_free(&worker->req_ring);
+    iccp_ring_free(&worker->reply_ring);
+
+    return MCLAG_ERROR;
+}
+
+void iccp_ctl_worker_stop(struct System *sys)
+{
+    struct iccp_ctl_worker *worker = &g_ctl_worker;
+    struct iccp_ctl_job *job = NULL;
+
+    if (!worker->running)
+        return;
+
+    __atomic_store_n(&worker->stop, 1, __ATOMIC_RELEASE);
+    iccp_efd_signal(worker->reply_efd);
+    pthread_join(worker->thread, NULL);
+    worker->running = 0;
+
+    while ((job = (struct iccp_ctl_job *)iccp_ring_pop(&worker->req_ring)) != NULL)
+        iccp_ctl_job_free(job);
+    while ((job = (struct iccp_ctl_job *)iccp_ring_pop(&worker->reply_ring)) != NULL)
+        iccp_ctl_job_free(job);
+
+    if (sys)
+    {
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, worker->req_efd, NULL);
+        FD_CLR(worker->req_efd, &(sys->readfd));
+        sys->ctl_req_fd = -1;
+    }
+
+    close(worker->req_efd);
+    close(worker->reply_efd);
+    worker->req_efd = worker->reply_efd = -1;
+    worker->listen_fd = -1;
+    iccp_ring_free(&worker->req_ring);
+    iccp_ring_free(&worker->reply_ring);
+}
@@ -0,0 +1,553 @@
+/*
+ * iccp_ingest.c
+ *
+ * Kernel and mclagsyncd ingestion thread. Reading the netlink event
+ * sockets, the ARP/ND packet sockets and the mclagsyncd socket is done
+ * here, including the mclagsyncd message framing and its receive retries.
+ * The interface, MAC and neighbor tables are owned by the protocol
+ * thread, so the messages are applied there: they are handed over through
+ * a lock-free ring and applied in bounded batches, between the peer
+ * session events. When the ring is full this thread stops reading until
+ * the protocol thread caught up, nothing is dropped: the socket buffers
+ * absorb the burst as they did before.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netlink/netlink.h>
+#include <netlink/socket.h>
+
+#include "../include/system.h"
+#include "../include/logger.h"
+#include "../include/msg_format.h"
+#include "../include/mlacp_link_handler.h"
+#include "../include/iccp_netlink.h"
+#include "../include/iccp_ring.h"
+#include "../include/iccp_ingest.h"
+
+#define ICCP_INGEST_MAX_EVENTS  16
+/* Re-check for ring space and stop requests while waiting, in case a
+ * wakeup is missed */
+#define ICCP_INGEST_WAIT_MSEC   100
+
+/* Sources in the ingestion epoll set, the mclagsyncd fd is kept in the
+ * upper 32 bits of the epoll data */
+enum iccp_ingest_src
+{
+    ICCP_INGEST_SRC_WAKEUP,
+    ICCP_INGEST_SRC_ROUTE,
+    ICCP_INGEST_SRC_GENL,
+    ICCP_INGEST_SRC_ARP,
+    ICCP_INGEST_SRC_NDISC,
+    ICCP_INGEST_SRC_SYNCD
+};
+
+enum iccp_ingest_msg_type
+{
+    ICCP_INGEST_MSG_NETLINK,      /* buf: netlink messages of protocol */
+    ICCP_INGEST_MSG_NETLINK_ERR,  /* val: read error on the protocol event socket */
+    ICCP_INGEST_MSG_NEIGH,        /* neigh: ARP reply or neighbor advertisement */
+    ICCP_INGEST_MSG_SYNCD,        /* buf: one mclagsyncd message */
+    ICCP_INGEST_MSG_SYNCD_CLOSED  /* val: fd closed by mclagsyncd */
+};
+
+struct iccp_ingest_msg
+{
+    int type;
+    int protocol;
+    int val; /* buf length, error or fd */
+    char *buf;
+    struct iccp_neigh_reply neigh;
+};
+
+struct iccp_ingest
+{
+    pthread_t thread;
+    int running;
+    int stop;
+    int epoll_fd;
+    int msg_efd;   /* ingestion -> protocol thread, messages posted */
+    int space_efd; /* protocol thread -> ingestion, ring drained or stop */
+    int waiting;   /* the ingestion thread waits for ring space */
+    int posted;    /* messages posted since msg_efd was last signalled */
+    char *syncd_buf;
+    struct iccp_ring ring;
+};
+
+static struct iccp_ingest g_ingest = { .epoll_fd = -1, .msg_efd = -1, .space_efd = -1 };
+
+static struct iccp_ingest_msg *iccp_ingest_msg_new(int type)
+{
+    struct iccp_ingest_msg *msg = NULL;
+
+    msg = (struct iccp_ingest_msg *)calloc(1, sizeof(struct iccp_ingest_msg));
+    if (msg == NULL)
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to allocate ingestion message type %d", type);
+    else
+        msg->type = type;
+
+    return msg;
+}
+
+static void iccp_ingest_msg_free(struct iccp_ingest_msg *msg)
+{
+    if (msg->buf)
+        free(msg->buf);
+    free(msg);
+}
+
+/*****************************************
+* Ingestion thread
+*
+* ***************************************/
+static void iccp_ingest_post(struct iccp_ingest *ing, struct iccp_ingest_msg *msg)
+{
+    struct System *sys = system_get_instance();
+    struct pollfd pfd;
+
+    if (iccp_ring_push(&ing->ring, msg) == 0)
+    {
+        ing->posted++;
+        return;
+    }
+
+    /* The protocol thread is behind: stop reading until it drained the
+     * ring, the sockets buffer the new events meanwhile */
+    if (sys)
+        __atomic_fetch_add(&sys->dbg_counters.ingest_stall_counter, 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&ing->waiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    iccp_efd_signal(ing->msg_efd);
+    ing->posted = 0;
+
+    pfd.fd = ing->space_efd;
+    pfd.events = POLLIN;
+    while (iccp_ring_push(&ing->ring, msg) < 0)
+    {
+        if (__atomic_load_n(&ing->stop, __ATOMIC_ACQUIRE))
+        {
+            iccp_ingest_msg_free(msg);
+            msg = NULL;
+            break;
+        }
+        if (poll(&pfd, 1, ICCP_INGEST_WAIT_MSEC) > 0)
+            iccp_efd_drain(ing->space_efd);
+    }
+
+    __atomic_store_n(&ing->waiting, 0, __ATOMIC_SEQ_CST);
+    if (msg)
+        ing->posted++;
+}
+
+static void iccp_ingest_read_netlink(struct iccp_ingest *ing, struct nl_sock *sk, int protocol)
+{
+    struct iccp_ingest_msg *msg = NULL;
+    struct sockaddr_nl nla;
+    unsigned char *buf = NULL;
+    int len;
+
+    len = nl_recv(sk, &nla, &buf, NULL);
+    if (len == 0)
+        return;
+
+    msg = iccp_ingest_msg_new(len > 0 ? ICCP_INGEST_MSG_NETLINK : ICCP_INGEST_MSG_NETLINK_ERR);
+    if (msg == NULL)
+    {
+        free(buf);
+        return;
+    }
+
+    msg->protocol = protocol;
+    msg->val = len;
+    msg->buf = (char *)buf;
+    iccp_ingest_post(ing, msg);
+}
+
+static void iccp_ingest_read_neigh(struct iccp_ingest *ing, struct System *sys, int src)
+{
+    struct iccp_ingest_msg *msg = NULL;
+    struct iccp_neigh_reply reply;
+    int ret;
+
+    if (src == ICCP_INGEST_SRC_ARP)
+        ret = iccp_recv_arp_reply(sys, &reply);
+    else
+        ret = iccp_recv_ndisc_reply(sys, &reply);
+    if (ret <= 0)
+        return;
+
+    if ((msg = iccp_ingest_msg_new(ICCP_INGEST_MSG_NEIGH)) == NULL)
+        return;
+
+    memcpy(&msg->neigh, &reply, sizeof(struct iccp_neigh_reply));
+    iccp_ingest_post(ing, msg);
+}
+
+/* Called by iccp_mclagsyncd_recv() for each complete message */
+static void iccp_ingest_syncd_msg(struct System *sys, char *msg_buf)
+{
+    struct IccpSyncdHDr *msg_hdr = (struct IccpSyncdHDr *)msg_buf;
+    struct iccp_ingest_msg *msg = NULL;
+
+    if ((msg = iccp_ingest_msg_new(ICCP_INGEST_MSG_SYNCD)) == NULL)
+        return;
+
+    msg->buf = (char *)malloc(msg_hdr->len);
+    if (msg->buf == NULL)
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "Failed to allocate mclagsyncd msg type %d len %d", msg_hdr->type, msg_hdr->len);
+        free(msg);
+        return;
+    }
+
+    memcpy(msg->buf, msg_buf, msg_hdr->len);
+    msg->val = msg_hdr->len;
+    iccp_ingest_post(&g_ingest, msg);
+}
+
+static void iccp_ingest_read_syncd(struct iccp_ingest *ing, struct System *sys, int fd)
+{
+    struct iccp_ingest_msg *msg = NULL;
+    char byte;
+    int len;
+
+    if (iccp_mclagsyncd_recv(sys, fd, ing->syncd_buf, iccp_ingest_syncd_msg) == 0)
+        return;
+
+    len = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (len > 0 || (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)))
+        return;
+
+    /* Connection closed: stop watching it, the protocol thread owns the fd
+     * and reconnects */
+    epoll_ctl(ing->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+
+    if ((msg = iccp_ingest_msg_new(ICCP_INGEST_MSG_SYNCD_CLOSED)) == NULL)
+        return;
+
+    msg->val = fd;
+    iccp_ingest_post(ing, msg);
+}
+
+static void *iccp_ingest_main(void *arg)
+{
+    struct iccp_ingest *ing = (struct iccp_ingest *)arg;
+    struct System *sys = system_get_instance();
+    struct epoll_event events[ICCP_INGEST_MAX_EVENTS];
+    int nfds;
+    int i;
+
+    while (!__atomic_load_n(&ing->stop, __ATOMIC_ACQUIRE))
+    {
+        nfds = epoll_wait(ing->epoll_fd, events, ICCP_INGEST_MAX_EVENTS, -1);
+        if (nfds < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            ICCPD_LOG_ERR(__FUNCTION__, "Ingestion thread epoll error: %s", strerror(errno));
+            break;
+        }
+
+        for (i = 0; i < nfds; i++)
+        {
+            switch ((uint32_t)events[i].data.u64)
+            {
+                case ICCP_INGEST_SRC_WAKEUP:
+                    iccp_efd_drain(ing->space_efd);
+                    break;
+
+                case ICCP_INGEST_SRC_ROUTE:
+                    iccp_ingest_read_netlink(ing, sys->route_event_sock, NETLINK_ROUTE);
+                    break;
+
+                case ICCP_INGEST_SRC_GENL:
+                    iccp_ingest_read_netlink(ing, sys->genric_event_sock, NETLINK_GENERIC);
+                    break;
+
+                case ICCP_INGEST_SRC_ARP:
+                case ICCP_INGEST_SRC_NDISC:
+                    iccp_ingest_read_neigh(ing, sys, (uint32_t)events[i].data.u64);
+                    break;
+
+                case ICCP_INGEST_SRC_SYNCD:
+                    iccp_ingest_read_syncd(ing, sys, (int)(events[i].data.u64 >> 32));
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        if (ing->posted)
+        {
+            ing->posted = 0;
+            iccp_efd_signal(ing->msg_efd);
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************
+* Protocol thread side
+*
+* ***************************************/
+int iccp_ingest_running()
+{
+    return g_ingest.running;
+}
+
+static int iccp_ingest_add_src(int epoll_fd, int fd, uint32_t src)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = ((uint64_t)(uint32_t)fd << 32) | src;
+
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+/* Read a new mclagsyncd connection on the ingestion thread */
+int iccp_ingest_watch_syncd(struct System *sys, int fd)
+{
+    if (!g_ingest.running || fd < 0)
+        return MCLAG_ERROR;
+
+    if (iccp_ingest_add_src(g_ingest.epoll_fd, fd, ICCP_INGEST_SRC_SYNCD) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to watch mclagsyncd fd %d: %s", fd, strerror(errno));
+        return MCLAG_ERROR;
+    }
+
+    return 0;
+}
+
+static void iccp_ingest_apply(struct System *sys, struct iccp_ingest_msg *msg)
+{
+    switch (msg->type)
+    {
+        case ICCP_INGEST_MSG_NETLINK:
+            iccp_netlink_dispatch_events(sys, msg->protocol, msg->buf, msg->val);
+            break;
+
+        case ICCP_INGEST_MSG_NETLINK_ERR:
+            iccp_netlink_event_error(sys, msg->protocol, msg->val);
+            break;
+
+        case ICCP_INGEST_MSG_NEIGH:
+            iccp_neigh_reply_apply(&msg->neigh);
+            break;
+
+        case ICCP_INGEST_MSG_SYNCD:
+            iccp_mclagsyncd_dispatch_msg(sys, msg->buf);
+            break;
+
+        case ICCP_INGEST_MSG_SYNCD_CLOSED:
+            if (sys->sync_fd == msg->val)
+            {
+                ICCPD_LOG_WARN(__FUNCTION__, "Mclagsyncd closed the connection, reconnecting");
+                syncd_info_close();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Apply up to ICCP_INGEST_BATCH messages, the rest on the next loop */
+int iccp_ingest_handle_msgs(struct System *sys)
+{
+    struct iccp_ingest *ing = &g_ingest;
+    struct iccp_ingest_msg *msg = NULL;
+    uint32_t backlog;
+    int n;
+
+    iccp_efd_drain(ing->msg_efd);
+
+    backlog = iccp_ring_count(&ing->ring);
+    if (backlog > sys->dbg_counters.ingest_backlog_max)
+        sys->dbg_counters.ingest_backlog_max = backlog;
+
+    for (n = 0; n < ICCP_INGEST_BATCH; n++)
+    {
+        if ((msg = (struct iccp_ingest_msg *)iccp_ring_pop(&ing->ring)) == NULL)
+            break;
+        iccp_ingest_apply(sys, msg);
+        iccp_ingest_msg_free(msg);
+    }
+    sys->dbg_counters.ingest_msg_counter += n;
+
+    /* Come back after the peer session and the state machines had a turn */
+    if (iccp_ring_count(&ing->ring) > 0)
+        iccp_efd_signal(ing->msg_efd);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (n > 0 && __atomic_load_n(&ing->waiting, __ATOMIC_SEQ_CST))
+        iccp_efd_signal(ing->space_efd);
+
+    return 0;
+}
+
+/* Move the kernel and mclagsyncd sockets from the main epoll loop to the
+ * ingestion thread. On failure they stay served inline. */
+int iccp_ingest_start(struct System *sys)
+{
+    struct iccp_ingest *ing = &g_ingest;
+    struct epoll_event event;
+    struct
+    {
+        int fd;
+        uint32_t src;
+    } srcs[5];
+    int num_srcs = 0;
+    int i;
+
+    if (sys == NULL || ing->running || sys->epoll_fd < 0
+        || sys->route_event_sock == NULL || sys->genric_event_sock == NULL
+        || sys->arp_receive_fd < 0 || sys->ndisc_receive_fd < 0)
+        return MCLAG_ERROR;
+
+    srcs[num_srcs].fd = nl_socket_get_fd(sys->route_event_sock);
+    srcs[num_srcs++].src = ICCP_INGEST_SRC_ROUTE;
+    srcs[num_srcs].fd = nl_socket_get_fd(sys->genric_event_sock);
+    srcs[num_srcs++].src = ICCP_INGEST_SRC_GENL;
+    srcs[num_srcs].fd = sys->arp_receive_fd;
+    srcs[num_srcs++].src = ICCP_INGEST_SRC_ARP;
+    srcs[num_srcs].fd = sys->ndisc_receive_fd;
+    srcs[num_srcs++].src = ICCP_INGEST_SRC_NDISC;
+    if (sys->sync_fd > 0)
+    {
+        srcs[num_srcs].fd = sys->sync_fd;
+        srcs[num_srcs++].src = ICCP_INGEST_SRC_SYNCD;
+    }
+
+    if (iccp_ring_init(&ing->ring, ICCP_INGEST_RING_SIZE) < 0
+        || (ing->syncd_buf = (char *)malloc(ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE)) == NULL)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to allocate ingestion buffers");
+        goto err;
+    }
+
+    ing->msg_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ing->space_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ing->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ing->msg_efd < 0 || ing->space_efd < 0 || ing->epoll_fd < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to create ingestion eventfd/epoll: %s", strerror(errno));
+        goto err;
+    }
+
+    if (iccp_ingest_add_src(ing->epoll_fd, ing->space_efd, ICCP_INGEST_SRC_WAKEUP) < 0)
+        goto err_src;
+    for (i = 0; i < num_srcs; i++)
+    {
+        if (iccp_ingest_add_src(ing->epoll_fd, srcs[i].fd, srcs[i].src) < 0)
+            goto err_src;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.data.fd = ing->msg_efd;
+    event.events = EPOLLIN;
+    if (epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, ing->msg_efd, &event) < 0)
+        goto err_src;
+
+    for (i = 0; i < num_srcs; i++)
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, srcs[i].fd, NULL);
+
+    ing->stop = 0;
+    ing->running = 1;
+    if (pthread_create(&ing->thread, NULL, iccp_ingest_main, ing) != 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to create ingestion thread");
+        ing->running = 0;
+        for (i = 0; i < num_srcs; i++)
+        {
+            memset(&event, 0, sizeof(event));
+            event.data.fd = srcs[i].fd;
+            event.events = EPOLLIN;
+            epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, srcs[i].fd, &event);
+        }
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, ing->msg_efd, NULL);
+        goto err;
+    }
+
+    sys->ingest_fd = ing->msg_efd;
+
+    ICCPD_LOG_NOTICE(__FUNCTION__, "Kernel and mclagsyncd events read by the ingestion thread");
+
+    return 0;
+
+err_src:
+    ICCPD_LOG_WARN(__FUNCTION__, "Failed to set up ingestion epoll: %s", strerror(errno));
+err:
+    if (ing->epoll_fd >= 0)
+        close(ing->epoll_fd);
+    if (ing->msg_efd >= 0)
+        close(ing->msg_efd);
+    if (ing->space_efd >= 0)
+        close(ing->space_efd);
+    ing->epoll_fd = ing->msg_efd = ing->space_efd = -1;
+    free(ing->syncd_buf);
+    ing->syncd_buf = NULL;
+    iccp_ring_free(&ing->ring);
+
+    return MCLAG_ERROR;
+}
+
+/* Only called on exit, the sources are not handed back to the main loop */
+void iccp_ingest_stop(struct System *sys)
+{
+    struct iccp_ingest *ing = &g_ingest;
+    struct iccp_ingest_msg *msg = NULL;
+
+    if (!ing->running)
+        return;
+
+    __atomic_store_n(&ing->stop, 1, __ATOMIC_RELEASE);
+    iccp_efd_signal(ing->space_efd);
+    pthread_join(ing->thread, NULL);
+    ing->running = 0;
+
+    while ((msg = (struct iccp_ingest_msg *)iccp_ring_pop(&ing->ring)) != NULL)
+        iccp_ingest_msg_free(msg);
+
+    if (sys)
+    {
+        epoll_ctl(sys->epoll_fd, EPOLL_CTL_DEL, ing->msg_efd, NULL);
+        sys->ingest_fd = -1;
+    }
+
+    close(ing->epoll_fd);
+    close(ing->msg_efd);
+    close(ing->space_efd);
+    ing->epoll_fd = ing->msg_efd = ing->space_efd = -1;
+    free(ing->syncd_buf);
+    ing->syncd_buf = NULL;
+    iccp_ring_free(&ing->ring);
+}
@@ -58,6 +58,8 @@
 #include "../include/iccp_netlink.h"
 #include "../include/mlacp_sync_update.h"
 #include "../include/mlacp_tlv.h"
+#include "../include/iccp_ctl_worker.h"
+#include "../include/iccp_ingest.h"
 
 /**
  * SECTION: Netlink helpers
@@ -1885,17 +1887,14 @@ static int iccp_get_receive_ndisc_packet_sock_fd(struct System *sys)
     return sys->ndisc_receive_fd;
 }
 
-static int iccp_receive_arp_packet_handler(struct System *sys)
+/* Read one ARP packet, returns 1 and fills reply for an ARP reply */
+int iccp_recv_arp_reply(struct System *sys, struct iccp_neigh_reply *reply)
 {
     unsigned char buf[1024];
     struct sockaddr_ll sll;
     socklen_t sll_len = sizeof(sll);
     struct arphdr *a = (struct arphdr*)buf;
     int n;
-    unsigned int ifindex;
-    unsigned int addr;
-    uint8_t mac_addr[ETHER_ADDR_LEN];
-    struct CSM* csm = NULL;
 
     n = recvfrom(sys->arp_receive_fd, buf, sizeof(buf), MSG_DONTWAIT,
                  (struct sockaddr*)&sll, &sll_len);
@@ -1915,21 +1914,48 @@ static int iccp_receive_arp_packet_handler(struct System *sys)
         sizeof(*a) + 2 * 4 + 2 * a->ar_hln > n)
         return 0;
 
+    reply->family = AF_INET;
+    reply->ifindex = sll.sll_ifindex;
+    memcpy(reply->mac_addr,  (char*)(a + 1), ETHER_ADDR_LEN);
+    memcpy(reply->addr, (char*)(a + 1) + a->ar_hln, 4);
+
+    return 1;
+}
+
+/* Learn the neighbor of an ARP reply or a neighbor advertisement */
+void iccp_neigh_reply_apply(struct iccp_neigh_reply *reply)
+{
+    unsigned int addr;
+
     /*Check if mclag configured*/
-    csm = system_get_first_csm();
-    if (!csm)
-        return 0;
+    if (!system_get_first_csm())
+        return;
+
+    if (reply->family == AF_INET)
+    {
+        memcpy(&addr, reply->addr, 4);
+        do_arp_update_from_reply_packet(reply->ifindex, addr, reply->mac_addr);
+    }
+    else
+    {
+        do_ndisc_update_from_reply_packet(reply->ifindex, (char *)reply->addr, reply->mac_addr);
+    }
+}
 
-    ifindex = sll.sll_ifindex;
-    memcpy(mac_addr,  (char*)(a + 1), ETHER_ADDR_LEN);
-    memcpy(&addr, (char*)(a + 1) + a->ar_hln, 4);
+static int iccp_receive_arp_packet_handler(struct System *sys)
+{
+    struct iccp_neigh_reply reply;
+    int ret;
 
-    do_arp_update_from_reply_packet(ifindex, addr, mac_addr);
+    ret = iccp_recv_arp_reply(sys, &reply);
+    if (ret > 0)
+        iccp_neigh_reply_apply(&reply);
 
-    return 0;
+    return ret < 0 ? ret : 0;
 }
 
-int iccp_receive_ndisc_packet_handler(struct System *sys)
+/* Read one ICMPv6 packet, returns 1 and fills reply for a neighbor advertisement */
+int iccp_recv_ndisc_reply(struct System *sys, struct iccp_neigh_reply *reply)
 {
     uint8_t buf[4096];
     uint8_t adata[1024];
@@ -1945,7 +1971,6 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
     int8_t *opt = NULL;
     int opt_len = 0, l = 0;
     int len;
-    struct CSM* csm = NULL;
 
     /* Fill in message and iovec. */
     msg.msg_name = (void *)(&from);
@@ -1980,11 +2005,6 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
 
     ndmsg = (struct nd_msg *)buf;
 
-    /*Check if mclag configured*/
-    csm = system_get_first_csm();
-    if (!csm)
-        return 0;
-
     if (ndmsg->icmph.icmp6_type != NDISC_NEIGHBOUR_ADVERTISEMENT)
         return 0;
 
@@ -2019,9 +2039,24 @@ int iccp_receive_ndisc_packet_handler(struct System *sys)
         }
     }
 
-    do_ndisc_update_from_reply_packet(ifindex, (char *)&target, mac_addr);
+    reply->family = AF_INET6;
+    reply->ifindex = ifindex;
+    memcpy(reply->addr, &target, sizeof(struct in6_addr));
+    memcpy(reply->mac_addr, mac_addr, ETHER_ADDR_LEN);
 
-    return 0;
+    return 1;
+}
+
+int iccp_receive_ndisc_packet_handler(struct System *sys)
+{
+    struct iccp_neigh_reply reply;
+    int ret;
+
+    ret = iccp_recv_ndisc_reply(sys, &reply);
+    if (ret > 0)
+        iccp_neigh_reply_apply(&reply);
+
+    return ret < 0 ? ret : 0;
 }
 
 void iccp_netlink_sync_again()
@@ -2077,6 +2112,64 @@ static int iccp_netlink_route_sock_event_handler(struct System *sys)
     return ret;
 }
 
+/* Apply the messages of a buffer read from a netlink event socket by the
+ * ingestion thread, with the handlers and the stop semantics that
+ * nl_recvmsgs_default() uses inline */
+int iccp_netlink_dispatch_events(struct System *sys, int protocol, void *buf, int len)
+{
+    struct nlmsghdr *hdr = (struct nlmsghdr *)buf;
+    struct nl_msg *msg = NULL;
+    int err = NL_OK;
+
+    while (nlmsg_ok(hdr, len) && err != NL_STOP)
+    {
+        if (hdr->nlmsg_type == NLMSG_OVERRUN)
+        {
+            iccp_netlink_event_error(sys, protocol, -NLE_MSG_OVERFLOW);
+            return -NLE_MSG_OVERFLOW;
+        }
+
+        if (hdr->nlmsg_type != NLMSG_DONE && hdr->nlmsg_type != NLMSG_ERROR
+            && hdr->nlmsg_type != NLMSG_NOOP)
+        {
+            msg = nlmsg_convert(hdr);
+            if (msg == NULL)
+                return -NLE_NOMEM;
+            nlmsg_set_proto(msg, protocol);
+
+            if (protocol == NETLINK_ROUTE)
+                err = iccp_route_event_handler(msg, sys);
+            else
+                err = iccp_genric_event_handler(msg, sys);
+            nlmsg_free(msg);
+        }
+
+        hdr = nlmsg_next(hdr, &len);
+    }
+
+    /*get netlink info again when error happens */
+    if (protocol == NETLINK_ROUTE && sys->need_sync_netlink_again == 1)
+        iccp_netlink_sync_again();
+
+    return 0;
+}
+
+/* A read on a netlink event socket failed, events may have been lost */
+void iccp_netlink_event_error(struct System *sys, int protocol, int err)
+{
+    if (protocol == NETLINK_ROUTE)
+    {
+        sys->need_sync_netlink_again = 1;
+        ICCPD_LOG_NOTICE(__FUNCTION__, "route event sock recvmsg error ret = %d", err);
+        SYSTEM_INCR_NETLINK_RX_ERROR();
+    }
+    else
+    {
+        sys->need_sync_team_again = 1;
+        ICCPD_LOG_DEBUG(__FUNCTION__, "genric event sock recvmsg error ret = %d", err);
+    }
+}
+
 extern int iccp_get_receive_fdb_sock_fd(struct System *sys);
 
 /* cond HIDDEN_SYMBOLS */
@@ -2209,6 +2302,18 @@ int iccp_handle_events(struct System * sys)
             continue;
         }
 
+        if (events[i].data.fd == sys->ctl_req_fd)
+        {
+            iccp_ctl_worker_handle_requests(sys);
+            continue;
+        }
+
+        if (events[i].data.fd == sys->ingest_fd)
+        {
+            iccp_ingest_handle_msgs(sys);
+            continue;
+        }
+
         if (events[i].data.fd == sys->sync_fd)
         {
             iccp_mclagsyncd_msg_handler(sys);
@@ -0,0 +1,101 @@
+/*
+ * iccp_ring.c
+ *
+ * Lock-free rings used to pass work between the iccpd threads.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * The full GNU General Public License is included in this distribution in
+ * the file called "COPYING".
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "../include/system.h"
+#include "../include/logger.h"
+#include "../include/iccp_ring.h"
+
+int iccp_ring_init(struct iccp_ring *ring, uint32_t size)
+{
+    memset(ring, 0, sizeof(struct iccp_ring));
+
+    if (size == 0 || (size & (size - 1)) != 0)
+        return MCLAG_ERROR;
+
+    ring->slot = (void **)calloc(size, sizeof(void *));
+    if (ring->slot == NULL)
+        return MCLAG_ERROR;
+    ring->size = size;
+
+    return 0;
+}
+
+void iccp_ring_free(struct iccp_ring *ring)
+{
+    free(ring->slot);
+    memset(ring, 0, sizeof(struct iccp_ring));
+}
+
+int iccp_ring_push(struct iccp_ring *ring, void *entry)
+{
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= ring->size)
+        return MCLAG_ERROR;
+
+    ring->slot[head & (ring->size - 1)] = entry;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+void *iccp_ring_pop(struct iccp_ring *ring)
+{
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    void *entry;
+
+    if (tail == head)
+        return NULL;
+
+    entry = ring->slot[tail & (ring->size - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return entry;
+}
+
+/* Entries in the ring, exact on the consumer side */
+uint32_t iccp_ring_count(struct iccp_ring *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+void iccp_efd_signal(int efd)
+{
+    uint64_t one = 1;
+
+    if (write(efd, &one, sizeof(one)) != sizeof(one))
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to signal eventfd %d: %s", efd, strerror(errno));
+}
+
+void iccp_efd_drain(int efd)
+{
+    uint64_t cnt;
+
+    if (read(efd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN)
+        ICCPD_LOG_WARN(__FUNCTION__, "Failed to read eventfd %d: %s", efd, strerror(errno));
+}
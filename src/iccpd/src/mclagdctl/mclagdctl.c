@@ -84,6 +84,9 @@ static struct command_type command_types[] =
         .name = "arp",
         .enca_msg = mclagdctl_enca_dump_arp,
         .parse_msg = mclagdctl_parse_dump_arp,
+        .page_info_type = INFO_TYPE_DUMP_ARP_PAGE,
+        .print_hdr = mclagdctl_print_dump_arp_hdr,
+        .parse_page = mclagdctl_parse_dump_arp_page,
     },
     {
          .id = ID_CMDTYPE_D_A,
@@ -92,6 +95,9 @@ static struct command_type command_types[] =
          .name = "nd",
          .enca_msg = mclagdctl_enca_dump_ndisc,
          .parse_msg = mclagdctl_parse_dump_ndisc,
+         .page_info_type = INFO_TYPE_DUMP_NDISC_PAGE,
+         .print_hdr = mclagdctl_print_dump_ndisc_hdr,
+         .parse_page = mclagdctl_parse_dump_ndisc_page,
      },
     {
         .id = ID_CMDTYPE_D_A,
@@ -100,6 +106,9 @@ static struct command_type command_types[] =
         .name = "mac",
         .enca_msg = mclagdctl_enca_dump_mac,
         .parse_msg = mclagdctl_parse_dump_mac,
+        .page_info_type = INFO_TYPE_DUMP_MAC_PAGE,
+        .print_hdr = mclagdctl_print_dump_mac_hdr,
+        .parse_page = mclagdctl_parse_dump_mac_page,
     },
     {
         .id = ID_CMDTYPE_D_A,
@@ -369,18 +378,21 @@ int mclagdctl_enca_dump_ndisc(char *msg, int mclag_id, int argc, char **argv)
     return 1;
 }
 
-int mclagdctl_parse_dump_arp(char *msg, int data_len)
+void mclagdctl_print_dump_arp_hdr(void)
 {
-    struct mclagd_arp_msg * arp_info = NULL;
-    int len = 0;
-    int count = 0;
-
     fprintf(stdout, "%-6s", "No.");
     fprintf(stdout, "%-20s", "IP");
     fprintf(stdout, "%-20s", "MAC");
     fprintf(stdout, "%-20s", "DEV");
     fprintf(stdout, "%s", "Flag");
     fprintf(stdout, "\n");
+}
+
+int mclagdctl_parse_dump_arp_page(char *msg, int data_len, int start)
+{
+    struct mclagd_arp_msg * arp_info = NULL;
+    int len = 0;
+    int count = 0;
 
     len = sizeof(struct mclagd_arp_msg);
 
@@ -388,7 +400,7 @@ int mclagdctl_parse_dump_arp(char *msg, int data_len)
     {
         arp_info = (struct mclagd_arp_msg*)(msg + len * count);
 
-        fprintf(stdout, "%-6d", count + 1);
+        fprintf(stdout, "%-6d", start + count + 1);
         fprintf(stdout, "%-20s", arp_info->ipv4_addr);
         fprintf(stdout, "%02x:%02x:%02x:%02x:%02x:%02x",
                 arp_info->mac_addr[0], arp_info->mac_addr[1],
@@ -406,21 +418,32 @@ int mclagdctl_parse_dump_arp(char *msg, int data_len)
         fprintf(stdout, "\n");
     }
 
-    return 0;
+    return count;
 }
 
-int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
+int mclagdctl_parse_dump_arp(char *msg, int data_len)
 {
-    struct mclagd_ndisc_msg *ndisc_info = NULL;
-    int len = 0;
-    int count = 0;
+    mclagdctl_print_dump_arp_hdr();
+    mclagdctl_parse_dump_arp_page(msg, data_len, 0);
 
+    return 0;
+}
+
+void mclagdctl_print_dump_ndisc_hdr(void)
+{
     fprintf(stdout, "%-6s", "No.");
     fprintf(stdout, "%-52s", "IPv6");
     fprintf(stdout, "%-20s", "MAC");
     fprintf(stdout, "%-20s", "DEV");
     fprintf(stdout, "%s", "Flag");
     fprintf(stdout, "\n");
+}
+
+int mclagdctl_parse_dump_ndisc_page(char *msg, int data_len, int start)
+{
+    struct mclagd_ndisc_msg *ndisc_info = NULL;
+    int len = 0;
+    int count = 0;
 
     len = sizeof(struct mclagd_ndisc_msg);
 
@@ -428,7 +451,7 @@ int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
     {
         ndisc_info = (struct mclagd_ndisc_msg *)(msg + len * count);
 
-        fprintf(stdout, "%-6d", count + 1);
+        fprintf(stdout, "%-6d", start + count + 1);
         fprintf(stdout, "%-52s", ndisc_info->ipv6_addr);
         fprintf(stdout, "%02x:%02x:%02x:%02x:%02x:%02x",
                 ndisc_info->mac_addr[0], ndisc_info->mac_addr[1],
@@ -445,6 +468,14 @@ int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
         fprintf(stdout, "\n");
     }
 
+    return count;
+}
+
+int mclagdctl_parse_dump_ndisc(char *msg, int data_len)
+{
+    mclagdctl_print_dump_ndisc_hdr();
+    mclagdctl_parse_dump_ndisc_page(msg, data_len, 0);
+
     return 0;
 }
 
@@ -466,12 +497,8 @@ int mclagdctl_enca_dump_mac(char *msg, int mclag_id, int argc, char **argv)
     return 1;
 }
 
-int mclagdctl_parse_dump_mac(char *msg, int data_len)
+void mclagdctl_print_dump_mac_hdr(void)
 {
-    struct mclagd_mac_msg * mac_info = NULL;
-    int len = 0;
-    int count = 0;
-
     fprintf(stdout, "%-60s\n", "TYPE: S-STATIC, D-DYNAMIC; AGE: L-Local age, P-Peer age");
 
     fprintf(stdout, "%-6s", "No.");
@@ -482,6 +509,13 @@ int mclagdctl_parse_dump_mac(char *msg, int data_len)
     fprintf(stdout, "%-20s", "ORIGIN-DEV");
     fprintf(stdout, "%-5s", "AGE");
     fprintf(stdout, "\n");
+}
+
+int mclagdctl_parse_dump_mac_page(char *msg, int data_len, int start)
+{
+    struct mclagd_mac_msg * mac_info = NULL;
+    int len = 0;
+    int count = 0;
 
     len = sizeof(struct mclagd_mac_msg);
 
@@ -489,7 +523,7 @@ int mclagdctl_parse_dump_mac(char *msg, int data_len)
     {
         mac_info = (struct mclagd_mac_msg*)(msg + len * count);
 
-        fprintf(stdout, "%-6d", count + 1);
+        fprintf(stdout, "%-6d", start + count + 1);
 
         if (mac_info->fdb_type == MAC_TYPE_STATIC_CTL)
             fprintf(stdout, "%-5s", "S");
@@ -513,6 +547,14 @@ int mclagdctl_parse_dump_mac(char *msg, int data_len)
         fprintf(stdout, "\n");
     }
 
+    return count;
+}
+
+int mclagdctl_parse_dump_mac(char *msg, int data_len)
+{
+    mclagdctl_print_dump_mac_hdr();
+    mclagdctl_parse_dump_mac_page(msg, data_len, 0);
+
     return 0;
 }
 
@@ -861,6 +903,22 @@ int mclagdctl_parse_dump_dbg_counters(char *msg, int data_len)
     fprintf(stdout, "%-20s%u\n", "Socket cleanup:",
         sys_counter_p->socket_cleanup_counter);
 
+    fprintf(stdout, "%-20s%u\n", "HB tx max(ms):",
+        sys_counter_p->hb_tx_interval_max_msec);
+    fprintf(stdout, "%-20s%u\n", "HB tx late:",
+        sys_counter_p->hb_tx_late_counter);
+    fprintf(stdout, "%-20s%u\n", "HB rx max(ms):",
+        sys_counter_p->hb_rx_interval_max_msec);
+    fprintf(stdout, "%-20s%u\n", "Ctl requests:",
+        sys_counter_p->ctl_req_counter);
+    fprintf(stdout, "%-20s%u\n", "Ctl req dropped:",
+        sys_counter_p->ctl_req_drop_counter);
+    fprintf(stdout, "%-20s%u\n", "Ingest msgs:",
+        sys_counter_p->ingest_msg_counter);
+    fprintf(stdout, "%-20s%u\n", "Ingest backlog max:",
+        sys_counter_p->ingest_backlog_max);
+    fprintf(stdout, "%-20s%u\n", "Ingest stalls:",
+        sys_counter_p->ingest_stall_counter);
     fprintf(stdout, "\n");
     fprintf(stdout, "%-20s%u\n\n", "Warmboot:", sys_counter_p->warmboot_counter);
 
@@ -1066,7 +1124,11 @@ static void mclagdctl_print_help(const char *argv0)
     fprintf(stdout, "%s [options] command [command args]\n"
             "    -h --help                Show this help\n"
             "    -i --mclag-id            Specify one mclag id\n"
-            "    -l --level               Specify log level     critical,err,warn,notice,info,debug\n",
+            "    -l --level               Specify log level     critical,err,warn,notice,info,debug\n"
+            "    -v --vlan                Only dump mac/arp/nd entries of this VLAN\n"
+            "    -p --port                Only dump mac/arp/nd entries of this interface\n"
+            "    -m --mac                 Only dump mac/arp/nd entries matching this MAC prefix\n"
+            "    -s --page-size           Entries per mac/arp/nd dump page, 0 for a single reply\n",
             argv0);
     fprintf(stdout, "Commands:\n");
 
@@ -1085,6 +1147,185 @@ static void mclagdctl_print_help(const char *argv0)
     }
 }
 
+/* Parse a MAC prefix such as "00:11:22" into bytes, returns the prefix length */
+static int mclagdctl_parse_mac_prefix(const char *str, uint8_t *prefix)
+{
+    unsigned int byte;
+    int len = 0;
+    int n = 0;
+
+    while (*str && len < MCLAGDCTL_ETHER_ADDR_LEN)
+    {
+        if (sscanf(str, "%2x%n", &byte, &n) != 1)
+            return MCLAG_ERROR;
+        prefix[len++] = byte;
+        str += n;
+        if (*str == ':' || *str == '-')
+            str++;
+        else if (*str)
+            return MCLAG_ERROR;
+    }
+
+    return (*str) ? MCLAG_ERROR : len;
+}
+
+/* Returned by mclagdctl_request when iccpd closed the connection without
+ * a reply, which older iccpd do for request types they do not know */
+#define MCLAGDCTL_NO_REPLY (-2)
+
+/* Send one request and read its reply, one connection per request */
+static int mclagdctl_request(int info_type, char *req_buf, int mclag_id,
+                             char **rcv_buf, int *rcv_len, int quiet_no_reply)
+{
+    char buf[sizeof(int)] = { 0 };
+    struct mclagd_reply_hdr *reply;
+    int len = 0;
+    int ret;
+
+    *rcv_buf = NULL;
+
+    if (mclagdctl_sock_fd <= 0)
+    {
+        ret = mclagdctl_sock_connect();
+        if (ret < 0)
+            return MCLAG_ERROR;
+    }
+
+    ret = mclagdctl_sock_write(mclagdctl_sock_fd, req_buf, sizeof(struct mclagdctl_req_hdr));
+
+    if (ret <= 0)
+    {
+        fprintf(stderr, "Failed to send command to mclagd\n");
+        goto request_err;
+    }
+
+    /*read data length*/
+    ret = mclagdctl_sock_read(mclagdctl_sock_fd, buf, sizeof(int));
+    if (ret <= 0)
+    {
+        if (quiet_no_reply)
+        {
+            mclagdctl_sock_close();
+            return MCLAGDCTL_NO_REPLY;
+        }
+        fprintf(stderr, "Failed to read data length from mclagd\n");
+        goto request_err;
+    }
+
+    /*cont length*/
+    len = *((int*)buf);
+    if (len <= 0)
+    {
+        fprintf(stderr, "pkt len = %d, error\n", len);
+        goto request_err;
+    }
+
+    *rcv_buf = (char *)malloc(len);
+    if (!*rcv_buf)
+    {
+        fprintf(stderr, "Failed to malloc rcv_buf for mclagdctl\n");
+        goto request_err;
+    }
+
+    /*read data*/
+    ret = mclagdctl_sock_read(mclagdctl_sock_fd, *rcv_buf, len);
+    if (ret <= 0)
+    {
+        fprintf(stderr, "Failed to read data from mclagd\n");
+        goto request_err;
+    }
+
+    reply = (struct mclagd_reply_hdr *)*rcv_buf;
+    if (reply->info_type != info_type)
+    {
+        fprintf(stderr, "Reply info type from mclagd error\n");
+        goto request_err;
+    }
+
+    if (reply->exec_result == EXEC_TYPE_NO_EXIST_SYS)
+    {
+        fprintf(stderr, "No exist sys in iccpd!\n");
+        goto request_err;
+    }
+
+    if (reply->exec_result == EXEC_TYPE_NO_EXIST_MCLAGID)
+    {
+        fprintf(stderr, "Mclag-id %d hasn't been configured in iccpd!\n", mclag_id);
+        goto request_err;
+    }
+
+    if (reply->exec_result == EXEC_TYPE_FAILED)
+    {
+        fprintf(stderr, "exec error in iccpd!\n");
+        goto request_err;
+    }
+
+    mclagdctl_sock_close();
+    *rcv_len = len;
+
+    return 0;
+
+ request_err:
+    mclagdctl_sock_close();
+
+    if (*rcv_buf)
+        free(*rcv_buf);
+    *rcv_buf = NULL;
+
+    return MCLAG_ERROR;
+}
+
+/* Fetch and print a MAC/ARP/ND dump page by page. Returns
+ * MCLAGDCTL_NO_REPLY if iccpd does not support paged dumps. */
+static int mclagdctl_request_paged(struct command_type *cmd_type, char *req_buf, int mclag_id,
+                                   struct mclagdctl_dump_filter *filter, uint32_t page_size)
+{
+    struct mclagdctl_req_hdr *req = (struct mclagdctl_req_hdr *)req_buf;
+    struct mclagdctl_dump_cursor cursor;
+    struct mclagd_reply_hdr *reply;
+    char *rcv_buf = NULL;
+    int len = 0;
+    int count = 0;
+    int data_len;
+    int ret;
+
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.page_size = page_size;
+    req->info_type = cmd_type->page_info_type;
+    memcpy(req->para1, filter, sizeof(struct mclagdctl_dump_filter));
+
+    do
+    {
+        memcpy(req->para2, &cursor, sizeof(cursor));
+
+        ret = mclagdctl_request(cmd_type->page_info_type, req_buf, mclag_id, &rcv_buf, &len, !cursor.started);
+        if (ret < 0)
+            return ret;
+
+        if (!cursor.started)
+            cmd_type->print_hdr();
+
+        reply = (struct mclagd_reply_hdr *)rcv_buf;
+        data_len = reply->data_len;
+        if (data_len < (int)sizeof(cursor) || data_len > len - (int)sizeof(struct mclagd_reply_hdr))
+        {
+            fprintf(stderr, "Invalid dump page from mclagd\n");
+            free(rcv_buf);
+            return MCLAG_ERROR;
+        }
+
+        memcpy(&cursor, rcv_buf + sizeof(struct mclagd_reply_hdr), sizeof(cursor));
+        count += cmd_type->parse_page(rcv_buf + sizeof(struct mclagd_reply_hdr) + sizeof(cursor),
+                                      data_len - sizeof(cursor), count);
+        fflush(stdout);
+
+        free(rcv_buf);
+        rcv_buf = NULL;
+    } while (cursor.more);
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     char buf[MCLAGDCTL_CMD_SIZE] = { 0 };
@@ -1095,6 +1336,10 @@ int main(int argc, char **argv)
         { "help",      no_argument,             NULL,        'h' },
         { "mclag id",  required_argument,       NULL,        'i' },
         { "log level", required_argument,       NULL,        'l' },
+        { "vlan",      required_argument,       NULL,        'v' },
+        { "port",      required_argument,       NULL,        'p' },
+        { "mac",       required_argument,       NULL,        'm' },
+        { "page-size", required_argument,       NULL,        's' },
         { NULL,        0,                       NULL,        0   }
     };
     int opt;
@@ -1102,12 +1347,16 @@ int main(int argc, char **argv)
     struct command_type *cmd_type;
     int ret;
     unsigned para_int = 0;
+    struct mclagdctl_dump_filter filter;
+    int page_size = MCLAGDCTL_DUMP_PAGE_SIZE;
+    int prefix_len;
+    int filter_set;
 
     int len = 0;
-    char *data;
-    struct mclagd_reply_hdr *reply;
 
-    while ((opt = getopt_long(argc, argv, "hi:l:", long_options, NULL)) >= 0)
+    memset(&filter, 0, sizeof(filter));
+
+    while ((opt = getopt_long(argc, argv, "hi:l:v:p:m:s:", long_options, NULL)) >= 0)
     {
         switch (opt)
         {
@@ -1118,7 +1367,6 @@ int main(int argc, char **argv)
         case 'i':
             para_int = atoi(optarg);
             break;
-
         case 'l':
             switch (tolower(optarg[0]))
             {
@@ -1153,6 +1401,33 @@ int main(int argc, char **argv)
             }
             break;
 
+        case 'v':
+            filter.vid = atoi(optarg);
+            break;
+
+        case 'p':
+            snprintf(filter.ifname, sizeof(filter.ifname), "%s", optarg);
+            break;
+
+        case 'm':
+            prefix_len = mclagdctl_parse_mac_prefix(optarg, filter.mac_prefix);
+            if (prefix_len < 0)
+            {
+                fprintf(stderr, "invalid MAC prefix \"%s\".\n", optarg);
+                return EXIT_FAILURE;
+            }
+            filter.mac_prefix_len = prefix_len;
+            break;
+
+        case 's':
+            page_size = atoi(optarg);
+            if (page_size < 0 || page_size > MCLAGDCTL_DUMP_PAGE_SIZE_MAX)
+            {
+                fprintf(stderr, "page size must be 0..%d.\n", MCLAGDCTL_DUMP_PAGE_SIZE_MAX);
+                return EXIT_FAILURE;
+            }
+            break;
+
             case '?':
                 fprintf(stderr, "unknown option.\n");
                 mclagdctl_print_help(argv0);
@@ -1182,101 +1457,40 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    if (mclagdctl_sock_fd <= 0)
+    filter_set = (filter.vid || filter.mac_prefix_len || filter.ifname[0]);
+    if (filter_set && (!cmd_type->parse_page || page_size == 0))
     {
-        ret = mclagdctl_sock_connect();
-        if (ret < 0)
-            return EXIT_FAILURE;
+        fprintf(stderr, "--vlan/--port/--mac only apply to mac/arp/nd dumps with a non-zero page size.\n");
+        return EXIT_FAILURE;
     }
 
     if (cmd_type->enca_msg(buf, para_int, argc, argv) < 0)
-    {
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
-
-    ret = mclagdctl_sock_write(mclagdctl_sock_fd, buf, sizeof(struct mclagdctl_req_hdr));
-
-    if (ret <= 0)
-    {
-        fprintf(stderr, "Failed to send command to mclagd\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
-
-    /*read data length*/
-    memset(buf, 0, MCLAGDCTL_CMD_SIZE);
-    ret = mclagdctl_sock_read(mclagdctl_sock_fd, buf, sizeof(int));
-    if (ret <= 0)
-    {
-        fprintf(stderr, "Failed to read data length from mclagd\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
-
-    /*cont length*/
-    len = *((int*)buf);
-    if (len <= 0)
-    {
-        ret = EXIT_FAILURE;
-        fprintf(stderr, "pkt len = %d, error\n", len);
-        goto mclagdctl_disconnect;
-    }
-
-    rcv_buf = (char *)malloc(len);
-    if (!rcv_buf)
-    {
-        fprintf(stderr, "Failed to malloc rcv_buf for mclagdctl\n");
-        goto mclagdctl_disconnect;
-    }
-
-    /*read data*/
-    ret = mclagdctl_sock_read(mclagdctl_sock_fd, rcv_buf, len);
-    if (ret <= 0)
-    {
-        fprintf(stderr, "Failed to read data from mclagd\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        return EXIT_FAILURE;
 
-    reply = (struct mclagd_reply_hdr *)rcv_buf;
-    if (reply->info_type != cmd_type->info_type)
+    if (cmd_type->parse_page && page_size > 0)
     {
-        fprintf(stderr, "Reply info type from mclagd error\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        ret = mclagdctl_request_paged(cmd_type, buf, para_int, &filter, page_size);
+        if (ret != MCLAGDCTL_NO_REPLY)
+            return (ret < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
 
-    if (reply->exec_result == EXEC_TYPE_NO_EXIST_SYS)
-    {
-        fprintf(stderr, "No exist sys in iccpd!\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+        if (filter_set)
+        {
+            fprintf(stderr, "iccpd does not support paged dumps, cannot filter.\n");
+            return EXIT_FAILURE;
+        }
 
-    if (reply->exec_result == EXEC_TYPE_NO_EXIST_MCLAGID)
-    {
-        fprintf(stderr, "Mclag-id %d hasn't been configured in iccpd!\n", para_int);
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
+        /* Older iccpd, fall back to the whole table reply */
+        memset(buf, 0, sizeof(buf));
+        if (cmd_type->enca_msg(buf, para_int, argc, argv) < 0)
+            return EXIT_FAILURE;
     }
 
-    if (reply->exec_result == EXEC_TYPE_FAILED)
-    {
-        fprintf(stderr, "exec error in iccpd!\n");
-        ret = EXIT_FAILURE;
-        goto mclagdctl_disconnect;
-    }
+    if (mclagdctl_request(cmd_type->info_type, buf, para_int, &rcv_buf, &len, 0) < 0)
+        return EXIT_FAILURE;
 
     cmd_type->parse_msg((char *)(rcv_buf + sizeof(struct mclagd_reply_hdr)), len - sizeof(struct mclagd_reply_hdr));
 
-    ret = EXIT_SUCCESS;
-
- mclagdctl_disconnect:
-    mclagdctl_sock_close();
-
-    if (rcv_buf)
-        free(rcv_buf);
+    free(rcv_buf);
 
-    return ret;
+    return EXIT_SUCCESS;
 }
@@ -36,6 +36,8 @@
 
 typedef int (*call_enca_msg_fun)(char *msg, int mclag_id,  int argc, char **argv);
 typedef int (*call_parse_msg_fun)(char *msg, int data_len);
+typedef void (*call_print_hdr_fun)(void);
+typedef int (*call_parse_page_fun)(char *msg, int data_len, int start);
 
 enum MAC_TYPE_CTL
 {
@@ -79,6 +81,10 @@ enum mclagdctl_notify_peer_type
     INFO_TYPE_CONFIG_LOGLEVEL,
     INFO_TYPE_CONFIG_DOWN,
     INFO_TYPE_FINISH,
+    /* Paged dumps, added last to keep the values above unchanged */
+    INFO_TYPE_DUMP_ARP_PAGE,
+    INFO_TYPE_DUMP_NDISC_PAGE,
+    INFO_TYPE_DUMP_MAC_PAGE,
 };
 
 enum log_level_type
@@ -116,6 +122,38 @@ struct mclagd_reply_hdr
 
 #define MCLAGD_REPLY_INFO_HDR (sizeof(struct mclagd_reply_hdr) + sizeof(int))
 
+/* Paged dump of the MAC/ARP/ND tables, requested with the *_PAGE info
+ * types; older iccpd close the connection without a reply to those. The
+ * request carries a filter in para1 and a cursor in para2. The reply
+ * starts with the cursor to send back for the next page, followed by up
+ * to page_size entries. iccpd reads all the pages of a dump from one
+ * snapshot of the table, taken for the first page. */
+#define MCLAGDCTL_DUMP_PAGE_SIZE      256
+#define MCLAGDCTL_DUMP_PAGE_SIZE_MAX  4096
+/* Max entries examined per page, bounds the work done for sparse filters */
+#define MCLAGDCTL_DUMP_SCAN_FACTOR    16
+#define MCLAGDCTL_DUMP_IFNAME_LEN     16
+
+struct mclagdctl_dump_filter
+{
+    uint16_t vid;            /* 0: any VLAN */
+    uint8_t  mac_prefix_len; /* bytes of mac_prefix to match, 0: any MAC */
+    uint8_t  mac_prefix[MCLAGDCTL_ETHER_ADDR_LEN];
+    char     ifname[MCLAGDCTL_DUMP_IFNAME_LEN]; /* empty: any interface */
+};
+
+struct mclagdctl_dump_cursor
+{
+    uint32_t page_size;
+    uint32_t snap_id;  /* iccpd snapshot the pages are read from */
+    uint32_t offset;   /* snapshot entries already examined */
+    uint8_t  started;
+    uint8_t  more;     /* set in the reply if the table was not exhausted */
+};
+
+_Static_assert(sizeof(struct mclagdctl_dump_filter) <= MCLAGDCTL_PARA2_LEN, "dump filter must fit in para1");
+_Static_assert(sizeof(struct mclagdctl_dump_cursor) <= MCLAGDCTL_PARA2_LEN, "dump cursor must fit in para2");
+
 #define MCLAGDCTL_COMMAND_PARAM_MAX_CNT 8
 struct command_type
 {
@@ -126,6 +164,10 @@ struct command_type
     char *params[MCLAGDCTL_COMMAND_PARAM_MAX_CNT];
     call_enca_msg_fun enca_msg;
     call_parse_msg_fun parse_msg;
+    /* Set for dumps that support paging */
+    enum mclagdctl_notify_peer_type page_info_type;
+    call_print_hdr_fun print_hdr;
+    call_parse_page_fun parse_page;
 };
 
 struct mclagd_state
@@ -231,9 +273,15 @@ extern int mclagdctl_parse_dump_state(char *msg, int data_len);
 extern int mclagdctl_enca_dump_arp(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_enca_dump_ndisc(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_parse_dump_arp(char *msg, int data_len);
+extern void mclagdctl_print_dump_arp_hdr(void);
+extern int mclagdctl_parse_dump_arp_page(char *msg, int data_len, int start);
 extern int mclagdctl_parse_dump_ndisc(char *msg, int data_len);
+extern void mclagdctl_print_dump_ndisc_hdr(void);
+extern int mclagdctl_parse_dump_ndisc_page(char *msg, int data_len, int start);
 extern int mclagdctl_enca_dump_mac(char *msg, int mclag_id, int argc, char **argv);
 extern int mclagdctl_parse_dump_mac(char *msg, int data_len);
+extern void mclagdctl_print_dump_mac_hdr(void);
+extern int mclagdctl_parse_dump_mac_page(char *msg, int data_len, int start);
 extern int mclagdctl_enca_dump_local_portlist(char *msg, int mclag_id,  int argc, char **argv);
 extern int mclagdctl_parse_dump_local_portlist(char *msg, int data_len);
 extern int mclagdctl_enca_dump_peer_portlist(char *msg, int mclag_id,  int argc, char **argv);
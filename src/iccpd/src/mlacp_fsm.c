@@ -27,6 +27,8 @@
 #include <time.h>
 
 #include <sys/queue.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -148,8 +150,8 @@ static void mlacp_resync_ndisc(struct CSM *csm);
 static void mlacp_sync_send_sysConf(struct CSM* csm);
 static void mlacp_sync_send_aggConf(struct CSM* csm);
 static void mlacp_sync_send_aggState(struct CSM* csm);
-static void mlacp_sync_send_syncArpInfo(struct CSM* csm);
-static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm);
+static void mlacp_sync_send_syncArpInfo(struct CSM* csm, int bounded);
+static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm, int bounded);
 static void mlacp_sync_send_heartbeat(struct CSM* csm);
 static void mlacp_sync_send_syncDoneData(struct CSM* csm);
 /* Sync Reciever APIs*/
@@ -257,15 +259,49 @@ static void mlacp_sync_send_aggState(struct CSM* csm)
 }
 #define MAX_MAC_ENTRY_NUM 30
 #define MAX_NEIGH_ENTRY_NUM 40
+
+/* Bulk MAC/ARP/ND sync pacing: one call sends for at most
+ * MLACP_SYNC_SLICE_USEC, and stops early once the peer socket holds more
+ * than MLACP_SYNC_NOTSENT_LOWAT unsent bytes. The rest of the queue is
+ * sent on the next scheduler pass, so heartbeats keep flowing. */
+#define MLACP_SYNC_SLICE_USEC     20000
+#define MLACP_SYNC_NOTSENT_LOWAT  (256 * 1024)
+
+static uint64_t mlacp_sync_now_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int mlacp_sync_slice_expired(struct CSM* csm, uint64_t start_usec)
+{
+    int unsent = 0;
+
+    if (mlacp_sync_now_usec() - start_usec >= MLACP_SYNC_SLICE_USEC)
+        return 1;
+
+    /* Bytes queued in the socket but not yet sent to the peer */
+    if (ioctl(csm->sock_fd, SIOCOUTQNSD, &unsent) == 0 && unsent > MLACP_SYNC_NOTSENT_LOWAT)
+        return 1;
+
+    return 0;
+}
+
 static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
 {
     int msg_len = 0;
     struct MACMsg* mac_msg = NULL;
     struct MACMsg mac_find;
     int count = 0;
+    uint64_t start_usec;
+
+    if (TAILQ_EMPTY(&(MLACP(csm).mac_msg_list)))
+        return;
 
-    memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
     memset(&mac_find, 0, sizeof(struct MACMsg));
+    start_usec = mlacp_sync_now_usec();
 
     while (!TAILQ_EMPTY(&(MLACP(csm).mac_msg_list)))
     {
@@ -293,7 +329,10 @@ static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
             count = 0;
-            memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+            /* g_csm_buf is free between two messages */
+            mlacp_sync_send_heartbeat(csm);
+            if (mlacp_sync_slice_expired(csm, start_usec))
+                break;
         }
         /*ICCPD_LOG_DEBUG("mlacp_fsm", "  [SYNC_Send] MacInfo,len=[%d]", msg_len);*/
     }
@@ -304,13 +343,19 @@ static void mlacp_sync_send_syncMacInfo(struct CSM* csm)
     return;
 }
 
-static void mlacp_sync_send_syncArpInfo(struct CSM* csm)
+/* When bounded is 0 the whole queue is drained, as required while replying
+ * to a peer sync request; heartbeats are still interleaved between messages. */
+static void mlacp_sync_send_syncArpInfo(struct CSM* csm, int bounded)
 {
     int msg_len = 0;
     struct Msg* msg = NULL;
     int count = 0;
+    uint64_t start_usec;
 
-    memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+    if (TAILQ_EMPTY(&(MLACP(csm).arp_msg_list)))
+        return;
+
+    start_usec = mlacp_sync_now_usec();
 
     while (!TAILQ_EMPTY(&(MLACP(csm).arp_msg_list)))
     {
@@ -325,7 +370,10 @@ static void mlacp_sync_send_syncArpInfo(struct CSM* csm)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
             count = 0;
-            memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+            /* g_csm_buf is free between two messages */
+            mlacp_sync_send_heartbeat(csm);
+            if (bounded && mlacp_sync_slice_expired(csm, start_usec))
+                break;
         }
         /*ICCPD_LOG_DEBUG("mlacp_fsm", "  [SYNC_Send] ArpInfo,len=[%d]", msg_len);*/
     }
@@ -336,13 +384,17 @@ static void mlacp_sync_send_syncArpInfo(struct CSM* csm)
     return;
 }
 
-static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm)
+static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm, int bounded)
 {
     int msg_len = 0;
     struct Msg *msg = NULL;
     int count = 0;
+    uint64_t start_usec;
 
-    memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+    if (TAILQ_EMPTY(&(MLACP(csm).ndisc_msg_list)))
+        return;
+
+    start_usec = mlacp_sync_now_usec();
 
     while (!TAILQ_EMPTY(&(MLACP(csm).ndisc_msg_list)))
     {
@@ -357,7 +409,10 @@ static void mlacp_sync_send_syncNdiscInfo(struct CSM *csm)
         {
             iccp_csm_send(csm, g_csm_buf, msg_len);
             count = 0;
-            memset(g_csm_buf, 0, CSM_BUFFER_SIZE);
+            /* g_csm_buf is free between two messages */
+            mlacp_sync_send_heartbeat(csm);
+            if (bounded && mlacp_sync_slice_expired(csm, start_usec))
+                break;
         }
         /* ICCPD_LOG_DEBUG("mlacp_fsm", " [SYNC_Send] NDInfo,len=[%d]", msg_len); */
     }
@@ -413,6 +468,8 @@ static void mlacp_sync_send_syncPeerLinkInfo(struct CSM* csm)
 static void mlacp_sync_send_heartbeat(struct CSM* csm)
 {
     int msg_len = 0;
+    struct System* sys = NULL;
+    uint64_t now_msec, interval_msec;
 
     if ((csm->heartbeat_send_time == 0) ||
         ((time(NULL) - csm->heartbeat_send_time) > csm->keepalive_time))
@@ -421,6 +478,20 @@ static void mlacp_sync_send_heartbeat(struct CSM* csm)
         msg_len = mlacp_prepare_for_heartbeat(csm, g_csm_buf, CSM_BUFFER_SIZE);
         iccp_csm_send(csm, g_csm_buf, msg_len);
         time(&csm->heartbeat_send_time);
+
+        /* Track heartbeat send jitter */
+        now_msec = system_get_monotonic_msec();
+        if (csm->heartbeat_send_msec != 0 && (sys = system_get_instance()) != NULL)
+        {
+            interval_msec = now_msec - csm->heartbeat_send_msec;
+            if (interval_msec > sys->dbg_counters.hb_tx_interval_max_msec)
+                sys->dbg_counters.hb_tx_interval_max_msec = interval_msec;
+            /* The send check above uses whole seconds, so an on-time
+             * heartbeat can be up to keepalive + 2s after the previous one */
+            if (interval_msec > (uint64_t)(csm->keepalive_time + 2) * 1000)
+                ++sys->dbg_counters.hb_tx_late_counter;
+        }
+        csm->heartbeat_send_msec = now_msec;
     }
 
     return;
@@ -1329,11 +1400,11 @@ static void mlacp_sync_sender_handler(struct CSM* csm)
             break;
 
         case MLACP_SYNC_ARP_INFO:
-            mlacp_sync_send_syncArpInfo(csm);
+            mlacp_sync_send_syncArpInfo(csm, 0);
             break;
 
         case MLACP_SYNC_NDISC_INFO:
-            mlacp_sync_send_syncNdiscInfo(csm);
+            mlacp_sync_send_syncNdiscInfo(csm, 0);
             break;
 
         case MLACP_SYNC_DONE:
@@ -1562,10 +1633,10 @@ static void mlacp_exchange_handler(struct CSM* csm, struct Msg* msg)
     mlacp_sync_send_syncMacInfo(csm);
 
     /* Send ARP info if any*/
-    mlacp_sync_send_syncArpInfo(csm);
+    mlacp_sync_send_syncArpInfo(csm, 1);
 
     /* Send Ndisc info if any */
-    mlacp_sync_send_syncNdiscInfo(csm);
+    mlacp_sync_send_syncNdiscInfo(csm, 1);
 
     /*If peer is warm reboot*/
     if (csm->peer_warm_reboot_time != 0)
@@ -47,6 +47,8 @@
 #include "../include/iccp_netlink.h"
 #include "../include/scheduler.h"
 #include "../include/iccp_ifm.h"
+#include "../include/iccp_ctl_worker.h"
+#include "../include/iccp_ingest.h"
 
 /*****************************************
 * Enum
@@ -2610,9 +2612,12 @@ int iccp_connect_syncd()
     ICCPD_LOG_NOTICE(__FUNCTION__, "Success to link syncd");
     sys->sync_fd = fd;
 
-    event.data.fd = fd;
-    event.events = EPOLLIN;
-    ret = epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    if (!iccp_ingest_running() || iccp_ingest_watch_syncd(sys, fd) < 0)
+    {
+        event.data.fd = fd;
+        event.events = EPOLLIN;
+        ret = epoll_ctl(sys->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
 
     count = 0;
     return 0;
@@ -3347,23 +3352,67 @@ int iccp_receive_fdb_handler_from_syncd(struct System *sys, char *msg_buf)
     return 0;
 }
 
+/* Apply one message received from mclagsyncd */
+void iccp_mclagsyncd_dispatch_msg(struct System *sys, char *msg)
+{
+    struct IccpSyncdHDr *msg_hdr = (struct IccpSyncdHDr *)msg;
+
+    if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_FDB_OPERATION)
+    {
+        iccp_receive_fdb_handler_from_syncd(sys, msg);
+    }
+    else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_DOMAIN)
+    {
+        iccp_mclagsyncd_mclag_domain_cfg_handler(sys, msg);
+    }
+    else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_IFACE)
+    {
+        iccp_mclagsyncd_mclag_iface_cfg_handler(sys, msg);
+    }
+    else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_UNIQUE_IP)
+    {
+        iccp_mclagsyncd_mclag_unique_ip_cfg_handler(sys, msg);
+    }
+    else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_VLAN_MBR_UPDATES)
+    {
+        iccp_mclagsyncd_vlan_mbr_update_handler(sys, msg);
+    }
+    else
+    {
+        ICCPD_LOG_ERR(__FUNCTION__, "recv unknown msg type %d ", msg_hdr->type);
+        return;
+    }
+    SYSTEM_SET_SYNCD_RX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
+}
+
 int iccp_mclagsyncd_msg_handler(struct System *sys)
+{
+    if (sys == NULL)
+        return MCLAG_ERROR;
+
+    return iccp_mclagsyncd_recv(sys, sys->sync_fd, g_iccp_mlagsyncd_recv_buf, iccp_mclagsyncd_dispatch_msg);
+}
+
+/* Read the pending mclagsyncd messages from fd into msg_buf, of
+ * ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE bytes, and pass each complete one
+ * to msg_cb. Used inline and by the ingestion thread. */
+int iccp_mclagsyncd_recv(struct System *sys, int fd, char *msg_buf,
+                         void (*msg_cb)(struct System *sys, char *msg))
 {
     int num_bytes_rxed = 0;
-    char *msg_buf = g_iccp_mlagsyncd_recv_buf;
     struct IccpSyncdHDr * msg_hdr;
     int pos = 0;
     int recv_len = 0;
     int num_retry = 0;
     errno = 0;
 
-    if (sys == NULL)
+    if (sys == NULL || fd < 0)
         return MCLAG_ERROR;
     memset(msg_buf, 0, ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE);
 
     /* read (max_size - msg_size) so that we have space to
        accomodate anything remaining in the last message */
-    num_bytes_rxed = recv(sys->sync_fd, msg_buf,
+    num_bytes_rxed = recv(fd, msg_buf,
             ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE - MCLAG_MAX_MSG_LEN, MSG_DONTWAIT );
 
     if (num_bytes_rxed <= 0)
@@ -3378,7 +3427,7 @@ int iccp_mclagsyncd_msg_handler(struct System *sys)
 
         while( num_bytes_rxed < 0 )
         {
-            recv_len = recv(sys->sync_fd, msg_buf,
+            recv_len = recv(fd, msg_buf,
                         ICCP_MLAGSYNCD_RECV_MSG_BUFFER_SIZE - MCLAG_MAX_MSG_LEN, MSG_DONTWAIT );
 
             if (recv_len == -1)
@@ -3433,7 +3482,7 @@ int iccp_mclagsyncd_msg_handler(struct System *sys)
             while (recv_len < pending_len)
             {
                 int remaining_len = pending_len-recv_len;
-                len = recv(sys->sync_fd, msg_buf+num_bytes_rxed+recv_len, remaining_len, MSG_DONTWAIT);
+                len = recv(fd, msg_buf+num_bytes_rxed+recv_len, remaining_len, MSG_DONTWAIT);
                 if (len <= 0)
                 {
                     if (len == 0)
@@ -3504,7 +3553,7 @@ int iccp_mclagsyncd_msg_handler(struct System *sys)
             while (recv_len < pending_len)
             {
                 int remaining_len = pending_len-recv_len;
-                len = recv(sys->sync_fd, msg_buf+num_bytes_rxed+recv_len, remaining_len, MSG_DONTWAIT);
+                len = recv(fd, msg_buf+num_bytes_rxed+recv_len, remaining_len, MSG_DONTWAIT);
                 if (len <= 0)
                 {
                     if (len == 0)
@@ -3549,34 +3598,8 @@ int iccp_mclagsyncd_msg_handler(struct System *sys)
             }
         }
 
-        if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_FDB_OPERATION)
-        {
-            iccp_receive_fdb_handler_from_syncd(sys, &msg_buf[pos]);
-        }
-        else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_DOMAIN)
-        {
-            iccp_mclagsyncd_mclag_domain_cfg_handler(sys, &msg_buf[pos]);
-        }
-        else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_IFACE)
-        {
-            iccp_mclagsyncd_mclag_iface_cfg_handler(sys, &msg_buf[pos]);
-        }
-        else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_CFG_MCLAG_UNIQUE_IP)
-        {
-            iccp_mclagsyncd_mclag_unique_ip_cfg_handler(sys, &msg_buf[pos]);
-        }
-        else if (msg_hdr->type == MCLAG_SYNCD_MSG_TYPE_VLAN_MBR_UPDATES)
-        {
-            iccp_mclagsyncd_vlan_mbr_update_handler(sys, &msg_buf[pos]);
-        }
-        else
-        {
-            ICCPD_LOG_ERR(__FUNCTION__, "recv unknown msg type %d ", msg_hdr->type);
-            pos += msg_hdr->len;
-            continue;
-        }
+        msg_cb(sys, &msg_buf[pos]);
         pos += msg_hdr->len;
-        SYSTEM_SET_SYNCD_RX_DBG_COUNTER(sys, msg_hdr->type, ICCP_DBG_CNTR_STS_OK);
     }
     return 0;
 }
@@ -3653,6 +3676,15 @@ char * mclagd_ctl_cmd_str(int req_type)
         case INFO_TYPE_DUMP_MAC:
             return "dump mac";
 
+        case INFO_TYPE_DUMP_ARP_PAGE:
+            return "dump arp page";
+
+        case INFO_TYPE_DUMP_NDISC_PAGE:
+            return "dump nd page";
+
+        case INFO_TYPE_DUMP_MAC_PAGE:
+            return "dump mac page";
+
         case INFO_TYPE_DUMP_LOCAL_PORTLIST:
             return "dump local portlist";
 
@@ -3801,6 +3833,38 @@ int mclagd_ctl_sock_write(int fd, char *w_buf, int total_len)
     return write_len;
 }
 
+/* Send a malloc'ed reply to mclagdctl. If the worker thread is running it
+ * takes the buffer over and *w_buf is cleared, else the reply is written
+ * here and the caller still frees it. */
+static int mclagd_ctl_reply_buf(int client_fd, char **w_buf, int total_len)
+{
+    if (iccp_ctl_worker_running())
+        return iccp_ctl_worker_post_reply(client_fd, w_buf, total_len);
+
+    return mclagd_ctl_sock_write(client_fd, *w_buf, total_len);
+}
+
+/* Send a short reply from a caller buffer to mclagdctl */
+static int mclagd_ctl_reply(int client_fd, char *w_buf, int total_len)
+{
+    char *reply = NULL;
+    int ret;
+
+    if (!iccp_ctl_worker_running())
+        return mclagd_ctl_sock_write(client_fd, w_buf, total_len);
+
+    reply = (char*)malloc(total_len);
+    if (!reply)
+        return MCLAG_ERROR;
+
+    memcpy(reply, w_buf, total_len);
+    ret = iccp_ctl_worker_post_reply(client_fd, &reply, total_len);
+    if (reply)
+        free(reply);
+
+    return ret;
+}
+
 void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
 {
     char * Pbuf = NULL;
@@ -3819,7 +3883,7 @@ void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
         hd->exec_result = ret;
         hd->info_type = INFO_TYPE_DUMP_STATE;
         hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        mclagd_ctl_reply(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
 
         if (Pbuf)
             free(Pbuf);
@@ -3833,7 +3897,7 @@ void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
 
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    mclagd_ctl_reply_buf(client_fd, &Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     if (Pbuf)
         free(Pbuf);
@@ -3841,79 +3905,53 @@ void mclagd_ctl_handle_dump_state(int client_fd, int mclag_id)
     return;
 }
 
-void mclagd_ctl_handle_dump_arp(int client_fd, int mclag_id)
+/* Build the reply of a MAC/ARP/ND dump from its snapshot, returns the
+ * reply length. Only touches the snapshot, so the mclagdctl worker thread
+ * calls it as well. */
+int mclagd_ctl_build_snapshot_reply(struct iccp_dump_snapshot *snap, char **reply)
 {
     char * Pbuf = NULL;
-    char buf[512] = { 0 };
-    int arp_num = 0;
+    int num = 0;
     int ret = 0;
     struct mclagd_reply_hdr *hd = NULL;
     int len_tmp = 0;
 
-    ret = iccp_arp_dump(&Pbuf, &arp_num, mclag_id);
+    ret = iccp_dump_snapshot_format(snap, &Pbuf, &num);
     if (ret != EXEC_TYPE_SUCCESS)
     {
-        len_tmp = sizeof(struct mclagd_reply_hdr);
-        memcpy(buf, &len_tmp, sizeof(int));
-        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
-        hd->exec_result = ret;
-        hd->info_type = INFO_TYPE_DUMP_ARP;
-        hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
-
         if (Pbuf)
             free(Pbuf);
 
-        return;
+        Pbuf = (char*)calloc(1, MCLAGD_REPLY_INFO_HDR);
+        if (!Pbuf)
+            return MCLAG_ERROR;
+        num = 0;
     }
 
     hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
-    hd->exec_result = EXEC_TYPE_SUCCESS;
-    hd->info_type = INFO_TYPE_DUMP_ARP;
-    hd->data_len = arp_num * sizeof(struct mclagd_arp_msg);
+    hd->exec_result = ret;
+    hd->info_type = snap->info_type;
+    hd->data_len = num * iccp_dump_reply_entry_size(snap->info_type);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
-    if (Pbuf)
-        free(Pbuf);
+    *reply = Pbuf;
 
-    return;
+    return MCLAGD_REPLY_INFO_HDR + hd->data_len;
 }
 
-void mclagd_ctl_handle_dump_ndisc(int client_fd, int mclag_id)
+void mclagd_ctl_handle_dump_snapshot(int client_fd, int info_type, int mclag_id)
 {
-    char *Pbuf = NULL;
-    char buf[512] = { 0 };
-    int ndisc_num = 0;
-    int ret = 0;
-    struct mclagd_reply_hdr *hd = NULL;
-    int len_tmp = 0;
-
-    ret = iccp_ndisc_dump(&Pbuf, &ndisc_num, mclag_id);
-    if (ret != EXEC_TYPE_SUCCESS)
-    {
-        len_tmp = sizeof(struct mclagd_reply_hdr);
-        memcpy(buf, &len_tmp, sizeof(int));
-        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
-        hd->exec_result = ret;
-        hd->info_type = INFO_TYPE_DUMP_NDISC;
-        hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+    struct iccp_dump_snapshot snap;
+    char * Pbuf = NULL;
+    int len = 0;
 
-        if (Pbuf)
-            free(Pbuf);
+    iccp_dump_snapshot_take(&snap, info_type, mclag_id);
+    len = mclagd_ctl_build_snapshot_reply(&snap, &Pbuf);
+    iccp_dump_snapshot_free(&snap);
 
-        return;
-    }
-
-    hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
-    hd->exec_result = EXEC_TYPE_SUCCESS;
-    hd->info_type = INFO_TYPE_DUMP_NDISC;
-    hd->data_len = ndisc_num * sizeof(struct mclagd_ndisc_msg);
-    len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
-    memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    if (len > 0)
+        mclagd_ctl_reply_buf(client_fd, &Pbuf, len);
 
     if (Pbuf)
         free(Pbuf);
@@ -3921,41 +3959,95 @@ void mclagd_ctl_handle_dump_ndisc(int client_fd, int mclag_id)
     return;
 }
 
-void mclagd_ctl_handle_dump_mac(int client_fd, int mclag_id)
+/* Build one page of a paged MAC/ARP/ND dump, the reply data starts with
+ * the cursor for the next page. Pages are read from the cached snapshot
+ * of the dump; snap is a new snapshot, for the first page or when the
+ * cached one is gone, in which case the dump goes on at the same offset.
+ * Returns the reply length, 0 if a new snapshot is needed or MCLAG_ERROR.
+ * Called by the thread serving mclagdctl. */
+int mclagd_ctl_build_page_reply(struct mclagdctl_req_hdr *req, struct iccp_dump_snapshot *snap, char **reply)
 {
+    struct iccp_dump_snapshot *cached = NULL;
     char * Pbuf = NULL;
-    char buf[512] = { 0 };
-    int mac_num = 0;
-    int ret = 0;
+    int num = 0;
+    int ret = EXEC_TYPE_FAILED;
     struct mclagd_reply_hdr *hd = NULL;
+    struct mclagdctl_dump_filter filter;
+    struct mclagdctl_dump_cursor cursor;
     int len_tmp = 0;
 
-    ret = iccp_mac_dump(&Pbuf, &mac_num, mclag_id);
+    memcpy(&filter, req->para1, sizeof(filter));
+    memcpy(&cursor, req->para2, sizeof(cursor));
+    filter.ifname[MCLAGDCTL_DUMP_IFNAME_LEN - 1] = '\0';
+    if (filter.mac_prefix_len > ETHER_ADDR_LEN)
+        filter.mac_prefix_len = ETHER_ADDR_LEN;
+    cursor.more = 0;
+
+    if (snap == NULL)
+    {
+        if (!cursor.started)
+            return 0;
+        cached = iccp_dump_snapshot_cache_get(cursor.snap_id, req->info_type, req->mclag_id);
+        if (!cached)
+            return 0;
+    }
+    else if ((ret = snap->exec_result) == EXEC_TYPE_SUCCESS)
+    {
+        if (!cursor.started)
+            cursor.offset = 0;
+        cursor.snap_id = iccp_dump_snapshot_cache_put(snap);
+        cached = iccp_dump_snapshot_cache_get(cursor.snap_id, req->info_type, req->mclag_id);
+    }
+
+    if (cached)
+        ret = iccp_dump_snapshot_page(cached, &filter, &cursor, &Pbuf, &num);
+
     if (ret != EXEC_TYPE_SUCCESS)
     {
-        len_tmp = sizeof(struct mclagd_reply_hdr);
-        memcpy(buf, &len_tmp, sizeof(int));
-        hd = (struct mclagd_reply_hdr *)(buf + sizeof(int));
+        Pbuf = (char*)calloc(1, MCLAGD_REPLY_INFO_HDR);
+        if (!Pbuf)
+            return MCLAG_ERROR;
+
+        hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
         hd->exec_result = ret;
-        hd->info_type = INFO_TYPE_DUMP_MAC;
+        hd->info_type = req->info_type;
         hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
-
-        if (Pbuf)
-            free(Pbuf);
-
-        return;
     }
+    else
+    {
+        if (!cursor.more)
+            iccp_dump_snapshot_cache_drop(cursor.snap_id);
 
-    hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
-    hd->exec_result = EXEC_TYPE_SUCCESS;
-    hd->info_type = INFO_TYPE_DUMP_MAC;
-    hd->data_len = mac_num * sizeof(struct mclagd_mac_msg);
+        hd = (struct mclagd_reply_hdr *)(Pbuf + sizeof(int));
+        hd->exec_result = EXEC_TYPE_SUCCESS;
+        hd->info_type = req->info_type;
+        hd->data_len = sizeof(struct mclagdctl_dump_cursor) + num * iccp_dump_reply_entry_size(cached->info_type);
+        memcpy(Pbuf + MCLAGD_REPLY_INFO_HDR, &cursor, sizeof(cursor));
+    }
 
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
+    *reply = Pbuf;
 
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    return MCLAGD_REPLY_INFO_HDR + hd->data_len;
+}
+
+static void mclagd_ctl_handle_dump_page(int client_fd, struct mclagdctl_req_hdr *req)
+{
+    struct iccp_dump_snapshot snap;
+    char * Pbuf = NULL;
+    int len = 0;
+
+    len = mclagd_ctl_build_page_reply(req, NULL, &Pbuf);
+    if (len == 0)
+    {
+        iccp_dump_snapshot_take(&snap, req->info_type, req->mclag_id);
+        len = mclagd_ctl_build_page_reply(req, &snap, &Pbuf);
+        iccp_dump_snapshot_free(&snap);
+    }
+
+    if (len > 0)
+        mclagd_ctl_reply_buf(client_fd, &Pbuf, len);
 
     if (Pbuf)
         free(Pbuf);
@@ -3981,7 +4073,7 @@ void mclagd_ctl_handle_dump_local_portlist(int client_fd, int mclag_id)
         hd->exec_result = ret;
         hd->info_type = INFO_TYPE_DUMP_LOCAL_PORTLIST;
         hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        mclagd_ctl_reply(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
 
         if (Pbuf)
             free(Pbuf);
@@ -3995,7 +4087,7 @@ void mclagd_ctl_handle_dump_local_portlist(int client_fd, int mclag_id)
     hd->data_len = lif_num * sizeof(struct mclagd_local_if);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    mclagd_ctl_reply_buf(client_fd, &Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     if (Pbuf)
         free(Pbuf);
@@ -4021,7 +4113,7 @@ void mclagd_ctl_handle_dump_peer_portlist(int client_fd, int mclag_id)
         hd->exec_result = ret;
         hd->info_type = INFO_TYPE_DUMP_PEER_PORTLIST;
         hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        mclagd_ctl_reply(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
 
         if (Pbuf)
             free(Pbuf);
@@ -4035,7 +4127,7 @@ void mclagd_ctl_handle_dump_peer_portlist(int client_fd, int mclag_id)
     hd->data_len = pif_num * sizeof(struct mclagd_peer_if);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    mclagd_ctl_reply_buf(client_fd, &Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     if (Pbuf)
         free(Pbuf);
@@ -4061,7 +4153,7 @@ void mclagd_ctl_handle_dump_dbg_counters(int client_fd, int mclag_id)
         hd->exec_result = ret;
         hd->info_type = INFO_TYPE_DUMP_DBG_COUNTERS;
         hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        mclagd_ctl_reply(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
 
         if (Pbuf)
             free(Pbuf);
@@ -4074,7 +4166,7 @@ void mclagd_ctl_handle_dump_dbg_counters(int client_fd, int mclag_id)
     hd->data_len = data_len;
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    mclagd_ctl_reply_buf(client_fd, &Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     if (Pbuf)
        free(Pbuf);
@@ -4098,7 +4190,7 @@ void mclagd_ctl_handle_dump_unique_ip(int client_fd, int mclag_id)
         hd->exec_result = ret;
         hd->info_type = INFO_TYPE_DUMP_LOCAL_PORTLIST;
         hd->data_len = 0;
-        mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+        mclagd_ctl_reply(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
 
         if (Pbuf)
             free(Pbuf);
@@ -4112,7 +4204,7 @@ void mclagd_ctl_handle_dump_unique_ip(int client_fd, int mclag_id)
     hd->data_len = lif_num * sizeof(struct mclagd_unique_ip_if);
     len_tmp = (hd->data_len + sizeof(struct mclagd_reply_hdr));
     memcpy(Pbuf, &len_tmp, sizeof(int));
-    mclagd_ctl_sock_write(client_fd, Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
+    mclagd_ctl_reply_buf(client_fd, &Pbuf, MCLAGD_REPLY_INFO_HDR + hd->data_len);
 
     if (Pbuf)
         free(Pbuf);
@@ -4134,28 +4226,13 @@ void mclagd_ctl_handle_config_loglevel(int client_fd, int log_level)
     hd->exec_result = EXEC_TYPE_SUCCESS;
     hd->info_type = INFO_TYPE_CONFIG_LOGLEVEL;
     hd->data_len = 0;
-    mclagd_ctl_sock_write(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
+    mclagd_ctl_reply(client_fd, buf, MCLAGD_REPLY_INFO_HDR);
 
     return;
 }
 
-int mclagd_ctl_interactive_process(int client_fd)
+int mclagd_ctl_dispatch_req(int client_fd, struct mclagdctl_req_hdr *req)
 {
-    char buf[512] = { 0 };
-    int ret = 0;
-
-    struct mclagdctl_req_hdr* req = NULL;
-
-    if (client_fd < 0)
-        return MCLAG_ERROR;
-
-    ret = mclagd_ctl_sock_read(client_fd, buf, sizeof(struct mclagdctl_req_hdr));
-
-    if (ret < 0)
-        return MCLAG_ERROR;
-
-    req = (struct mclagdctl_req_hdr*)buf;
-
     ICCPD_LOG_DEBUG(__FUNCTION__, "Receive request %s from mclagdctl", mclagd_ctl_cmd_str(req->info_type));
 
     switch (req->info_type)
@@ -4165,15 +4242,27 @@ int mclagd_ctl_interactive_process(int client_fd)
             break;
 
         case INFO_TYPE_DUMP_ARP:
-            mclagd_ctl_handle_dump_arp(client_fd, req->mclag_id);
+            mclagd_ctl_handle_dump_snapshot(client_fd, req->info_type, req->mclag_id);
+            break;
+
+        case INFO_TYPE_DUMP_ARP_PAGE:
+            mclagd_ctl_handle_dump_page(client_fd, req);
             break;
 
         case INFO_TYPE_DUMP_NDISC:
-            mclagd_ctl_handle_dump_ndisc(client_fd, req->mclag_id);
+            mclagd_ctl_handle_dump_snapshot(client_fd, req->info_type, req->mclag_id);
+            break;
+
+        case INFO_TYPE_DUMP_NDISC_PAGE:
+            mclagd_ctl_handle_dump_page(client_fd, req);
             break;
 
         case INFO_TYPE_DUMP_MAC:
-            mclagd_ctl_handle_dump_mac(client_fd, req->mclag_id);
+            mclagd_ctl_handle_dump_snapshot(client_fd, req->info_type, req->mclag_id);
+            break;
+
+        case INFO_TYPE_DUMP_MAC_PAGE:
+            mclagd_ctl_handle_dump_page(client_fd, req);
             break;
 
         case INFO_TYPE_DUMP_LOCAL_PORTLIST:
@@ -4203,6 +4292,22 @@ int mclagd_ctl_interactive_process(int client_fd)
     return 0;
 }
 
+int mclagd_ctl_interactive_process(int client_fd)
+{
+    char buf[512] = { 0 };
+    int ret = 0;
+
+    if (client_fd < 0)
+        return MCLAG_ERROR;
+
+    ret = mclagd_ctl_sock_read(client_fd, buf, sizeof(struct mclagdctl_req_hdr));
+
+    if (ret < 0)
+        return MCLAG_ERROR;
+
+    return mclagd_ctl_dispatch_req(client_fd, (struct mclagdctl_req_hdr*)buf);
+}
+
 int syn_local_mac_info_to_peer(struct CSM* csm, struct LocalInterface *local_if, int sync_add, int is_sag)
 {
     struct MACMsg mac_msg = {0};
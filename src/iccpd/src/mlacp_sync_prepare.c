@@ -318,6 +318,11 @@ int mlacp_prepare_for_mac_info_to_peer(struct CSM* csm, char* buf, size_t max_bu
     if ((msg_len = sizeof(ICCHdr) + tlv_len) > max_buf_size)
         return MCLAG_ERROR;
 
+    /* Only the header and the entry being added are cleared, the caller
+     * does not need to wipe the whole buffer between messages */
+    if (count == 0)
+        memset(buf, 0, sizeof(ICCHdr) + sizeof(struct mLACPMACInfoTLV));
+
     /* ICC header */
     icc_hdr = (ICCHdr*)buf;
     mlacp_fill_icc_header(csm, icc_hdr, msg_len);
@@ -334,6 +339,7 @@ int mlacp_prepare_for_mac_info_to_peer(struct CSM* csm, char* buf, size_t max_bu
     }
 
     MacData = (struct mLACPMACData *)&buf[sizeof(ICCHdr) + sizeof(struct mLACPMACInfoTLV) + sizeof(struct mLACPMACData) * count];
+    memset(MacData, 0, sizeof(struct mLACPMACData));
     MacData->type = mac_msg->op_type;
     MacData->mac_type = mac_msg->fdb_type;
     memcpy(MacData->mac_addr, mac_msg->mac_addr,ETHER_ADDR_LEN);
@@ -368,6 +374,9 @@ int mlacp_prepare_for_arp_info(struct CSM* csm, char* buf, size_t max_buf_size,
     if ((msg_len = sizeof(ICCHdr) + tlv_len) > max_buf_size)
         return MCLAG_ERROR;
 
+    if (count == 0)
+        memset(buf, 0, sizeof(ICCHdr) + sizeof(struct mLACPARPInfoTLV));
+
     /* ICC header */
     icc_hdr = (ICCHdr*)buf;
     mlacp_fill_icc_header(csm, icc_hdr, msg_len);
@@ -385,6 +394,7 @@ int mlacp_prepare_for_arp_info(struct CSM* csm, char* buf, size_t max_buf_size,
     }
 
     ArpData = (struct ARPMsg *)&buf[sizeof(ICCHdr) + sizeof(struct mLACPARPInfoTLV) + sizeof(struct ARPMsg) * count];
+    memset(ArpData, 0, sizeof(struct ARPMsg));
 
     ArpData->op_type = arp_msg->op_type;
     ArpData->flag = arp_msg->flag;
@@ -421,6 +431,9 @@ int mlacp_prepare_for_ndisc_info(struct CSM *csm, char *buf, size_t max_buf_size
     if ((msg_len = sizeof(ICCHdr) + tlv_len) > max_buf_size)
         return -1;
 
+    if (count == 0)
+        memset(buf, 0, sizeof(ICCHdr) + sizeof(struct mLACPNDISCInfoTLV));
+
     /* ICC header */
     icc_hdr = (ICCHdr *)buf;
     mlacp_fill_icc_header(csm, icc_hdr, msg_len);
@@ -438,6 +451,7 @@ int mlacp_prepare_for_ndisc_info(struct CSM *csm, char *buf, size_t max_buf_size
     }
 
     NdiscData = (struct NDISCMsg *)&buf[sizeof(ICCHdr) + sizeof(struct mLACPNDISCInfoTLV) + sizeof(struct NDISCMsg) * count];
+    memset(NdiscData, 0, sizeof(struct NDISCMsg));
 
     NdiscData->op_type = ndisc_msg->op_type;
     NdiscData->flag = ndisc_msg->flag;
@@ -1316,11 +1316,20 @@ int mlacp_fsm_update_peerlink_info(struct CSM* csm,
 *****************************************/
 int mlacp_fsm_update_heartbeat(struct CSM* csm, struct mLACPHeartbeatTLV* tlv)
 {
+    struct System* sys = NULL;
+    uint64_t now_msec;
+
     if (!csm || !tlv)
         return MCLAG_ERROR;
 
     time(&csm->heartbeat_update_time);
 
+    now_msec = system_get_monotonic_msec();
+    if (csm->heartbeat_update_msec != 0 && (sys = system_get_instance()) != NULL
+        && now_msec - csm->heartbeat_update_msec > sys->dbg_counters.hb_rx_interval_max_msec)
+        sys->dbg_counters.hb_rx_interval_max_msec = now_msec - csm->heartbeat_update_msec;
+    csm->heartbeat_update_msec = now_msec;
+
     return 0;
 }
 
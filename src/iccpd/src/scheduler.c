@@ -41,6 +41,8 @@
 #include "../include/iccp_cmd.h"
 #include "../include/mlacp_link_handler.h"
 #include "../include/iccp_netlink.h"
+#include "../include/iccp_ctl_worker.h"
+#include "../include/iccp_ingest.h"
 
 /******************************************************
 *
@@ -401,10 +403,19 @@ void scheduler_init()
         ICCPD_LOG_DEBUG(__FUNCTION__, "Syncd info socket connect success");
     }
 
+    if (iccp_ingest_start(sys) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Ingestion thread start fail, read kernel and syncd events inline");
+    }
+
     if (mclagd_ctl_sock_create() < 0)
     {
         ICCPD_LOG_WARN(__FUNCTION__, "Mclagd ctl info socket connect fail");
     }
+    else if (iccp_ctl_worker_start(sys) < 0)
+    {
+        ICCPD_LOG_WARN(__FUNCTION__, "Mclagd ctl worker start fail, serve requests inline");
+    }
 
     return;
 }
@@ -22,6 +22,7 @@
  */
 
 #include <stdio.h>
+#include <time.h>
 #include <netlink/msg.h>
 
 #include "../include/iccp_csm.h"
@@ -30,6 +31,8 @@
 #include "../include/scheduler.h"
 #include "../include/mlacp_link_handler.h"
 #include "../include/iccp_ifm.h"
+#include "../include/iccp_ctl_worker.h"
+#include "../include/iccp_ingest.h"
 
 #define ETHER_ADDR_LEN 6
 char mac_print_str[ETHER_ADDR_STR_LEN];
@@ -63,6 +66,8 @@ void system_init(struct System* sys)
     sys->server_fd = -1;
     sys->sync_fd = -1;
     sys->sync_ctrl_fd = -1;
+    sys->ctl_req_fd = -1;
+    sys->ingest_fd = -1;
     sys->arp_receive_fd = -1;
     sys->ndisc_receive_fd = -1;
     sys->epoll_fd = -1;
@@ -106,6 +111,8 @@ void system_finalize()
         "System resource pool is destructing. Warmboot exit (%d)",
         sys->warmboot_exit);
 
+    iccp_ingest_stop(sys);
+
     while (!LIST_EMPTY(&(sys->csm_list)))
     {
         csm = LIST_FIRST(&(sys->csm_list));
@@ -154,6 +161,7 @@ void system_finalize()
         close(sys->server_fd);
     if (sys->sync_fd > 0)
         close(sys->sync_fd);
+    iccp_ctl_worker_stop(sys);
     if (sys->sync_ctrl_fd > 0)
         close(sys->sync_ctrl_fd);
     if (sys->arp_receive_fd > 0)
@@ -353,6 +361,14 @@ char *mac_addr_to_str(uint8_t mac_addr[ETHER_ADDR_LEN])
     return mac_print_str;
 }
 
+uint64_t system_get_monotonic_msec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 void system_update_netlink_counters(
     uint16_t netlink_msg_type,
     struct nlmsghdr *nlh)
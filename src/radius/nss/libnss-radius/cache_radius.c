@@ -98,7 +98,6 @@ int main(int ac, char * av[]) {
     char file_buf[RADIUS_MAX_NSS_CONF_SZ];
     int ncfd = -1;
     int no_clear_unconfirmed = 0;
-    int clear_unconfirmed_limit = 0;
     int refresh_user = 0;
     char buf[BUFLEN];
     struct passwd pw, *result = NULL;
@@ -155,6 +154,7 @@ int main(int ac, char * av[]) {
                  != 0)) {
 
         radius_update_cache( conf->prog, user, mpl);
+        radius_update_index_user( conf->prog, user);
         refresh_user = 1;
 
     }
@@ -184,14 +184,9 @@ int main(int ac, char * av[]) {
     }
 
     if (!no_clear_unconfirmed && (conf->many_to_one == 0)) {
-        clear_unconfirmed_limit = conf->unconfirmed_clear_limit;
-        while(radius_clear_unconfirmed_users(conf) == 0) {
-            if (clear_unconfirmed_limit-- <= 0) {
-                syslog(LOG_INFO, "%s: Clear unconfirmed limit %d reached:",
-                    conf->prog, conf->unconfirmed_clear_limit);
-                break;
-            }
-        }
+        /* Deletes up to unconfirmed_clear_limit users, in one batch.
+         */
+        radius_clear_unconfirmed_users(conf);
     }
 
     exit(main_cleanup(0, conf, &ncfd));
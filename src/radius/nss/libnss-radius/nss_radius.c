@@ -19,9 +19,8 @@ enum nss_status _nss_radius_getpwnam_r( const char * nam, struct passwd * pwd,
     enum nss_status status = NSS_STATUS_NOTFOUND;
     int mpl = 1;
     int ncfd = -1;
-    RADIUS_NSS_CONF_B radius_nss_conf, * conf = &(radius_nss_conf);
+    RADIUS_NSS_CONF_B * conf;
     RADIUS_NSS_MPL * rnm;
-    char file_buf[RADIUS_MAX_NSS_CONF_SZ];
     char buffer[BUFLEN];
     struct passwd pw, *res = NULL;
     char * prog = "nss";
@@ -31,7 +30,10 @@ enum nss_status _nss_radius_getpwnam_r( const char * nam, struct passwd * pwd,
     if (!nam || !strcmp(nam, "*") || !pwd || !buf || (buflen == 0))
         return NSS_STATUS_NOTFOUND;
 
-    parse_nss_config(conf, prog, file_buf, sizeof(file_buf), errnop, &ncfd);
+    /* Parsed once per process, the lock file is only taken before
+     * creating a user.
+     */
+    conf = get_nss_config_cache(prog, errnop);
 
     if (radius_lookup_cache(prog, nam, &mpl) == 0) {
 
@@ -45,12 +47,14 @@ enum nss_status _nss_radius_getpwnam_r( const char * nam, struct passwd * pwd,
         if (conf->many_to_one) {
             radius_getpwnam_r(prog, rnm->gecos, &pw, buffer, sizeof(buffer),
                 &res);
-        } else if (conf->allow_anonymous) {
+        } else if (conf->allow_anonymous
+                && (lock_nss_config_cache(conf, &ncfd) == 0)) {
             radius_create_user(conf, nam, mpl, RADIUS_CONFIRMED);
             radius_getpwnam_r(prog, nam, &pw, buffer, sizeof(buffer), &res);
         }
 
-    } else if (conf->allow_anonymous && is_sshd_lookup(conf, nam)) {
+    } else if (conf->allow_anonymous && is_sshd_lookup(conf, nam)
+            && (lock_nss_config_cache(conf, &ncfd) == 0)) {
 
         /* Could be an sshd doing a getpwnam() before pam_authenticate().
          */
@@ -78,6 +82,7 @@ enum nss_status _nss_radius_getpwnam_r( const char * nam, struct passwd * pwd,
     }
 
     unparse_nss_config(conf, errnop, &ncfd);
+    put_nss_config_cache(conf);
 
     return status;
 }
@@ -25,9 +25,14 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #include <sys/file.h>
 #include <regex.h>
 #include <time.h>
-#include <sys/wait.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <dirent.h>
+#include <sys/mman.h>
 
 #include "nss_radius_common.h"
+#include "radius_pwdb.h"
 
 static void dump_rnm(int mpl, RADIUS_NSS_MPL * rnm, char * msg) {
 
@@ -168,126 +173,58 @@ static void init_rnm(RADIUS_NSS_CONF_B * conf) {
 
 }
 
-static int user_add(const char* name, char* gid, char* sec_grp, char* gecos, 
+static int user_add(char* prog, const char* name, gid_t gid, char* sec_grp, char* gecos,
                         char* home, char* shell, const char* unconfirmed_user, int many_to_one) {
-    pid_t pid, w;
-    int status = 0;
-    int wstatus;
-    char cmd[64];
-
-    snprintf(cmd, 63, "%s", USERADD);
-
-    pid = fork();
-
-    if(pid > 0) {
-        do {
-            w = waitpid(pid, &wstatus, WUNTRACED | WCONTINUED);
-            if (w == -1)
-                return -1;
-        } while (!WIFEXITED(wstatus) && !WIFSIGNALED(wstatus));
-        if WIFEXITED(wstatus)
-            return WEXITSTATUS(wstatus);
-        else
-            return -1;
+    RADIUS_PWDB db;
+    int status;
 
-    // Child
+    radius_pwdb_init(&db, prog, RADIUS_PWDB_ROOT);
 
-    } else if(pid == 0) {
+    if (many_to_one)
+        status = radius_pwdb_add_user(&db, name, gid, sec_grp, gecos, NULL,
+            shell);
+    else
+        status = radius_pwdb_add_user(&db, name, RADIUS_PWDB_USER_GROUP,
+            sec_grp, unconfirmed_user, home, shell);
 
-        if (many_to_one)
-          execl(cmd, cmd, "-g", gid, "-G", sec_grp, "-c", gecos, "-m", "-s", shell, name, NULL);
-        else
-          execl(cmd, cmd, "-U", "-G", sec_grp, "-c", unconfirmed_user, "-d", home, "-m", "-s", shell, name, NULL);
-        syslog(LOG_ERR, "exec of %s failed with errno=%d", cmd, errno);
-        return -1;
+    if (status == 0)
+        status = radius_pwdb_commit(&db);
 
-    // Error
-    } else {
-        fprintf(stderr, "error forking the child\n");
-        return -1;
-    }
+    radius_pwdb_free(&db);
 
     return status;
 }
 
-static int user_del(const char* name) {
-    pid_t pid, w;
-    int status = 0;
-    int wstatus;
-    char cmd[64];
-
-    snprintf(cmd, 63, "%s", USERDEL);
-
-    pid = fork();
-
-    if(pid > 0) {
-        do {
-            w = waitpid(pid, &wstatus, WUNTRACED | WCONTINUED);
-            if (w == -1)
-                return -1;
-        } while (!WIFEXITED(wstatus) && !WIFSIGNALED(wstatus));
-        if WIFEXITED(wstatus)
-            return WEXITSTATUS(wstatus);
-        else
-            return -1;
+static int user_del(char* prog, const char* name) {
+    RADIUS_PWDB db;
+    int status;
 
-    // Child
+    radius_pwdb_init(&db, prog, RADIUS_PWDB_ROOT);
 
-    } else if(pid == 0) {
+    if ((status = radius_pwdb_del_user(&db, name)) == 0)
+        status = radius_pwdb_commit(&db);
 
-        execl(cmd, cmd, "-r", name, NULL);
-        syslog(LOG_ERR, "exec of %s failed with errno=%d", cmd, errno);
-        return -1;
-
-    // Error
-    } else {
-        fprintf(stderr, "error forking the child\n");
-        return -1;
-    }
+    radius_pwdb_free(&db);
 
     return status;
 }
 
-static int user_mod(const char* name, char* sec_grp) {
-    pid_t pid, w;
-    int status = 0;
-    int wstatus;
-    char cmd[64];
-
-    snprintf(cmd, 63, "%s", USERMOD);
-
-    pid = fork();
-
-    if(pid > 0) {
-        do {
-            w = waitpid(pid, &wstatus, WUNTRACED | WCONTINUED);
-            if (w == -1)
-                return -1;
-        } while (!WIFEXITED(wstatus) && !WIFSIGNALED(wstatus));
-        if WIFEXITED(wstatus)
-            return WEXITSTATUS(wstatus);
-        else
-            return -1;
-
-    // Child
+static int user_mod(char* prog, const char* name, char* sec_grp) {
+    RADIUS_PWDB db;
+    int status;
 
-    } else if(pid == 0) {
+    radius_pwdb_init(&db, prog, RADIUS_PWDB_ROOT);
 
-        execl(cmd, cmd, "-G", sec_grp, "-c", name, name, NULL);
-        syslog(LOG_ERR, "exec of %s failed with errno=%d", cmd, errno);
-        return -1;
+    if ((status = radius_pwdb_mod_user(&db, name, sec_grp, name)) == 0)
+        status = radius_pwdb_commit(&db);
 
-    // Error
-    } else {
-        fprintf(stderr, "error forking the child\n");
-        return -1;
-    }
+    radius_pwdb_free(&db);
 
     return status;
 }
 
-int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
-    char * file_buf, int file_buf_sz, int * errnop, int * plockfd) {
+static int read_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
+    char * file_buf, int file_buf_sz, int * errnop, int * pncfd) {
 
       /* Slurp the whole file.
        */
@@ -439,18 +376,50 @@ int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
 
 parse_nss_config_exit:
 
+    *pncfd = ncfd;
+
+      /* Fix up rnm.
+       */
+
+    if (use_default_rnm || bad_rnm)
+        init_rnm(conf);
+
+    for ( i = 1; i < RADIUS_MAX_MPL; i++) {
+        if ((conf->rnm)[i].gecos == NULL) {
+            (conf->rnm)[i] = (conf->rnm)[i-1];
+        }
+    }
+
+    return ret;
+}
+
+static int lock_nss_config(RADIUS_NSS_CONF_B * conf, int ncfd) {
+
+    if (flock(ncfd, LOCK_EX|LOCK_NB) == 0) {
+        if (conf->debug)
+            syslog( LOG_DEBUG, "%s: %d: Unconfirmed: lock success",
+                conf->prog, (int) getpid());
+        return 0;
+    }
+
+    if (conf->debug)
+        syslog( LOG_DEBUG, "%s: %d: Unconfirmed: locked out",
+            conf->prog, (int) getpid());
+    return 1;
+}
+
+int parse_nss_config(RADIUS_NSS_CONF_B * conf, char * prog,
+    char * file_buf, int file_buf_sz, int * errnop, int * plockfd) {
+
+    int ncfd = -1;
+    int ret;
+
+    ret = read_nss_config(conf, prog, file_buf, file_buf_sz, errnop, &ncfd);
+
     if (ncfd != -1) {
 
-        if (flock(ncfd, LOCK_EX|LOCK_NB) == 0) {
-            if (conf->debug)
-                syslog( LOG_DEBUG, "%s: %d: Unconfirmed: lock success",
-                    prog, (int) getpid());
-        } else {
+        if (lock_nss_config(conf, ncfd))
             conf->allow_anonymous = 0;
-            if (conf->debug)
-                syslog( LOG_DEBUG, "%s: %d: Unconfirmed: locked out",
-                    prog, (int) getpid());
-        }
 
         if (plockfd) {
             *plockfd = ncfd;
@@ -459,20 +428,134 @@ parse_nss_config_exit:
         }
     }
 
+    return ret;
+}
 
-      /* Fix up rnm.
-       */
+/* Parsed RADIUS_NSS_CONF, kept for the life of the process and revalidated
+ * by stat() on every lookup. Re-read only when the file changes.
+ */
+static struct {
+    pthread_rwlock_t rwlock;
+    int valid;
+    struct stat sb;
+    RADIUS_NSS_CONF_B conf;
+    regex_t unconfirmed_re;
+    char file_buf[RADIUS_MAX_NSS_CONF_SZ];
+} radius_nss_conf_cache = { .rwlock = PTHREAD_RWLOCK_INITIALIZER };
+
+static int nss_config_changed(struct stat * cached, struct stat * sb) {
+    return (cached->st_dev != sb->st_dev)
+        || (cached->st_ino != sb->st_ino)
+        || (cached->st_size != sb->st_size)
+        || (cached->st_mtim.tv_sec != sb->st_mtim.tv_sec)
+        || (cached->st_mtim.tv_nsec != sb->st_mtim.tv_nsec);
+}
 
-    if (use_default_rnm || bad_rnm)
-        init_rnm(conf);
+static void reload_nss_config(char * prog, struct stat * sb, int * errnop) {
+
+    RADIUS_NSS_CONF_B * conf = &(radius_nss_conf_cache.conf);
+    int ncfd = -1;
+    int reg_ret;
+    char errbuf[128];
+
+    if (conf->unconfirmed_re)
+        regfree(conf->unconfirmed_re);
+
+    read_nss_config(conf, prog, radius_nss_conf_cache.file_buf,
+        sizeof(radius_nss_conf_cache.file_buf), errnop, &ncfd);
+
+    if (ncfd != -1)
+        close(ncfd);
+
+    if (conf->unconfirmed_regexp) {
+
+        if ((reg_ret = regcomp(&(radius_nss_conf_cache.unconfirmed_re),
+                conf->unconfirmed_regexp, REG_EXTENDED|REG_NOSUB))) {
+
+            errbuf[0] = 0;
+            regerror(reg_ret, &(radius_nss_conf_cache.unconfirmed_re),
+                errbuf, sizeof(errbuf));
+            syslog( LOG_ERR, "%s: %s: regcomp() failed: %s", prog,
+                conf->unconfirmed_regexp, errbuf);
+
+              /* Same as a failed regcomp() in is_sshd_lookup().
+               */
+            conf->unconfirmed_regexp = NULL;
+
+        } else {
+
+            conf->unconfirmed_re = &(radius_nss_conf_cache.unconfirmed_re);
 
-    for ( i = 1; i < RADIUS_MAX_MPL; i++) {
-        if ((conf->rnm)[i].gecos == NULL) {
-            (conf->rnm)[i] = (conf->rnm)[i-1];
         }
     }
 
-    return ret;
+    if (conf->debug)
+        syslog( LOG_DEBUG, "%s: %d: %s reloaded", prog, (int) getpid(),
+            RADIUS_NSS_CONF);
+
+    radius_nss_conf_cache.sb = *sb;
+    radius_nss_conf_cache.valid = 1;
+}
+
+/* Returns the cached configuration, re-read if RADIUS_NSS_CONF changed.
+ * No lock file is taken, see lock_nss_config_cache().
+ * Must be released with put_nss_config_cache().
+ */
+RADIUS_NSS_CONF_B * get_nss_config_cache(char * prog, int * errnop) {
+
+    struct stat sb;
+
+      /* A missing file is cached too, as the default configuration.
+       */
+    if (stat(RADIUS_NSS_CONF, &sb) == -1)
+        memset((char *) &sb, 0, sizeof(sb));
+
+    pthread_rwlock_rdlock(&(radius_nss_conf_cache.rwlock));
+
+    if (   radius_nss_conf_cache.valid
+        && !nss_config_changed(&(radius_nss_conf_cache.sb), &sb))
+        return &(radius_nss_conf_cache.conf);
+
+    pthread_rwlock_unlock(&(radius_nss_conf_cache.rwlock));
+    pthread_rwlock_wrlock(&(radius_nss_conf_cache.rwlock));
+
+    if (   !radius_nss_conf_cache.valid
+        || nss_config_changed(&(radius_nss_conf_cache.sb), &sb))
+        reload_nss_config(prog, &sb, errnop);
+
+    pthread_rwlock_unlock(&(radius_nss_conf_cache.rwlock));
+    pthread_rwlock_rdlock(&(radius_nss_conf_cache.rwlock));
+
+    return &(radius_nss_conf_cache.conf);
+}
+
+void put_nss_config_cache(RADIUS_NSS_CONF_B * conf) {
+
+    pthread_rwlock_unlock(&(radius_nss_conf_cache.rwlock));
+}
+
+/* Takes the lock file serializing creation of users, as done by
+ * parse_nss_config(). Only needed before radius_create_user().
+ * Returns 0 with *plockfd set when locked, release by unparse_nss_config().
+ */
+int lock_nss_config_cache(RADIUS_NSS_CONF_B * conf, int * plockfd) {
+
+    int ncfd;
+
+    if ((ncfd = open(RADIUS_NSS_CONF, O_RDONLY)) == -1) {
+        if (conf->debug)
+            syslog( LOG_DEBUG, "%s: %d: Unconfirmed: open failed: errno %d",
+                conf->prog, (int) getpid(), errno);
+        return 1;
+    }
+
+    if (lock_nss_config(conf, ncfd)) {
+        close(ncfd);
+        return 1;
+    }
+
+    *plockfd = ncfd;
+    return 0;
 }
 
 /* Releases any memory.
@@ -567,10 +650,11 @@ int radius_update_user(RADIUS_NSS_CONF_B * conf, const char * user, int mpl) {
     if (conf->trace)
         dump_rnm(mpl, rnm, "update");
 
-    if(0 != user_mod(user, rnm->groups)) {
-      syslog(LOG_ERR, "%s: %s %s failed", conf->prog, USERMOD, user);
+    if(0 != user_mod(conf->prog, user, rnm->groups)) {
+      syslog(LOG_ERR, "%s: usermod %s failed", conf->prog, user);
         return -1;
     }
+    radius_update_index_user(conf->prog, user);
     return 0;
 }
 
@@ -590,29 +674,29 @@ int radius_create_user(RADIUS_NSS_CONF_B * conf, const char * user, int mpl,
 
     syslog(LOG_INFO, "%s: Creating user \"%s\"", conf->prog, user);
 
-    char sgid[10] = {0};
     char home[64] = {0};
-    snprintf(sgid, 10, "%d", rnm->gid);
     snprintf(home, 63, "/home/%s", user);
 
     snprintf(buf, sizeof(buf), "Unconfirmed-%ld", time(NULL));
 
-    if(0 != user_add(user, sgid, rnm->groups, rnm->gecos, home, rnm->shell, unconfirmed ? buf : user, conf->many_to_one)) {
-      syslog(LOG_ERR, "%s: %s %s failed", conf->prog, USERADD, user);
+    if(0 != user_add(conf->prog, user, rnm->gid, rnm->groups, rnm->gecos, home, rnm->shell, unconfirmed ? buf : user, conf->many_to_one)) {
+      syslog(LOG_ERR, "%s: useradd %s failed", conf->prog, user);
 
         return -1;
     }
+    radius_update_index_user(conf->prog, user);
     return 0;
 }
 
 int radius_delete_user(RADIUS_NSS_CONF_B * conf, const char * user) {
 
     syslog(LOG_INFO, "%s: Deleting user \"%s\"", conf->prog, user);
-    if(0 != user_del(user)) {
-      syslog(LOG_ERR, "%s: %s %s failed", conf->prog, USERDEL, user);
+    if(0 != user_del(conf->prog, user)) {
+      syslog(LOG_ERR, "%s: userdel %s failed", conf->prog, user);
 
         return -1;
     }
+    radius_update_index_user(conf->prog, user);
     return 0;
 }
 
@@ -629,27 +713,53 @@ int radius_clear_unconfirmed_users(RADIUS_NSS_CONF_B * conf)
     time_t ts, curr = time(NULL);
     struct passwd pw, * pwd = & pw, * result = NULL;
     char buf[BUFLEN];
+    RADIUS_PWDB db;
+    int limit = (conf->unconfirmed_clear_limit > 0) ?
+                    conf->unconfirmed_clear_limit : 1;
 
     if ((fp = fopen(ETC_PASSWD, "r")) == NULL) {
         syslog(LOG_ERR, "%s: fopen(\"/etc/passwd\") failed\n", conf->prog);
         return radius_clear_unconfirmed_users_cleanup(STATUS_ENOENT, fp);
     }
 
+    /* Aged unconfirmed users are deleted in one batch.
+     */
+    radius_pwdb_init(&db, conf->prog, RADIUS_PWDB_ROOT);
+
     while((status = fgetpwent_r(fp, pwd, buf, sizeof(buf), &result)) == 0) {
         if (   (result)
             && (strncmp((result)->pw_gecos, "Unconfirmed-", 12) == 0)
             && (ts = atoi(&(((result)->pw_gecos)[12])))
             && ((curr - ts) >= conf->unconfirmed_ageout)) {
 
+            if (db.count >= limit) {
+                syslog(LOG_INFO, "%s: Clear unconfirmed limit %d reached:",
+                    conf->prog, limit);
+                break;
+            }
+
             syslog(LOG_INFO, "%s: Deleting unconfirmed user \"%s\"",
                 conf->prog, (result)->pw_name);
 
-            return radius_clear_unconfirmed_users_cleanup(
-                       radius_delete_user(conf, (result)->pw_name), fp);
+            radius_pwdb_del_user(&db, (result)->pw_name);
         }
     }
 
-    return radius_clear_unconfirmed_users_cleanup(STATUS_ESRCH, fp);
+    if (db.count == 0) {
+        radius_pwdb_free(&db);
+        return radius_clear_unconfirmed_users_cleanup(STATUS_ESRCH, fp);
+    }
+
+    fclose(fp);
+
+    if ((status = radius_pwdb_commit(&db)) != 0)
+        syslog(LOG_ERR, "%s: userdel of unconfirmed users failed",
+            conf->prog);
+
+    radius_pwdb_free(&db);
+    radius_update_index(conf->prog);
+
+    return status;
 }
 
 
@@ -659,7 +769,8 @@ int radius_lookup_cache_cleanup( int status, int rafd) {
     return status;
 }
 
-int radius_lookup_cache( char * prog, const char * nam, int * pmpl) {
+static int radius_lookup_cache_file( char * prog, const char * nam,
+    int * pmpl) {
     int rafd = -1;
     int i;
     char cache_filename[PATH_MAX];
@@ -712,6 +823,475 @@ int radius_lookup_cache( char * prog, const char * nam, int * pmpl) {
     return radius_lookup_cache_cleanup(0, rafd);
 }
 
+static uint32_t radius_index_csum(const void * data, size_t len) {
+    const unsigned char * p = data;
+    uint32_t csum = 2166136261U;
+
+    while (len--) {
+        csum ^= *p++;
+        csum *= 16777619U;
+    }
+
+    return csum;
+}
+
+static uint32_t radius_index_hdr_csum(const RADIUS_INDEX_HDR * hdr) {
+    return radius_index_csum(hdr, offsetof(RADIUS_INDEX_HDR, csum));
+}
+
+static uint32_t radius_index_entry_csum(const RADIUS_INDEX_ENTRY * entry) {
+    return radius_index_csum(entry, offsetof(RADIUS_INDEX_ENTRY, csum));
+}
+
+/* Read side mapping, set up once per process. A mapping is never unmapped
+ * since other threads may be reading it, if the file is replaced the old
+ * mapping is leaked.
+ */
+static struct {
+    pthread_mutex_t mutex;
+    const RADIUS_INDEX_HDR * hdr;
+    dev_t dev;
+    ino_t ino;
+} radius_index_map = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+static const RADIUS_INDEX_HDR * radius_index_get_map(char * prog) {
+
+    struct stat sb;
+    const RADIUS_INDEX_HDR * hdr = NULL;
+    void * map;
+    int fd;
+
+    if (   (stat(RADIUS_INDEX_FILE, &sb) == -1)
+        || (sb.st_size != RADIUS_INDEX_FILE_SZ))
+        return NULL;
+
+    pthread_mutex_lock(&(radius_index_map.mutex));
+
+    if (   radius_index_map.hdr
+        && (radius_index_map.dev == sb.st_dev)
+        && (radius_index_map.ino == sb.st_ino)) {
+        hdr = radius_index_map.hdr;
+        goto radius_index_get_map_exit;
+    }
+
+    if ((fd = open(RADIUS_INDEX_FILE, O_RDONLY)) == -1)
+        goto radius_index_get_map_exit;
+
+    map = mmap(NULL, RADIUS_INDEX_FILE_SZ, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        syslog( LOG_WARNING, "%s: mmap(%s) failed: errno %d", prog,
+            RADIUS_INDEX_FILE, errno);
+        goto radius_index_get_map_exit;
+    }
+
+    hdr = radius_index_map.hdr = map;
+    radius_index_map.dev = sb.st_dev;
+    radius_index_map.ino = sb.st_ino;
+
+radius_index_get_map_exit:
+
+    pthread_mutex_unlock(&(radius_index_map.mutex));
+
+    return hdr;
+}
+
+/* Look up nam in the index, without any lock.
+ * Returns 0 if found, STATUS_ENOENT if not in a valid index, STATUS_EIO if
+ * the index is missing, corrupted, or kept busy by the writer.
+ */
+int radius_lookup_index( char * prog, const char * nam,
+    RADIUS_INDEX_ENTRY * pentry) {
+
+    const RADIUS_INDEX_HDR * hdr;
+    const RADIUS_INDEX_ENTRY * entries;
+    RADIUS_INDEX_HDR h;
+    uint32_t gen;
+    int retries, lo, hi, mid, cmp, found;
+
+    if ((hdr = radius_index_get_map(prog)) == NULL)
+        return STATUS_EIO;
+
+    entries = (const RADIUS_INDEX_ENTRY *) (hdr + 1);
+
+    for (retries = 0; retries < RADIUS_INDEX_READ_RETRIES; retries++) {
+
+        if ((gen = __atomic_load_n(&(hdr->gen), __ATOMIC_ACQUIRE)) & 1) {
+            sched_yield();
+            continue;
+        }
+
+        memcpy(&h, hdr, sizeof(h));
+
+        found = 0;
+        if (   (h.magic == RADIUS_INDEX_MAGIC)
+            && (h.version == RADIUS_INDEX_VERSION)
+            && (h.entry_sz == sizeof(RADIUS_INDEX_ENTRY))
+            && (h.max_users == RADIUS_INDEX_MAX_USERS)
+            && (h.count <= RADIUS_INDEX_MAX_USERS)
+            && (h.csum == radius_index_hdr_csum(&h))) {
+
+            lo = 0;
+            hi = (int) h.count - 1;
+            while (lo <= hi) {
+                mid = lo + (hi - lo) / 2;
+                cmp = strncmp(nam, entries[mid].name, RADIUS_INDEX_NAME_SZ);
+                if (cmp == 0) {
+                    memcpy(pentry, &(entries[mid]), sizeof(*pentry));
+                    found = 1;
+                    break;
+                }
+                if (cmp < 0)
+                    hi = mid - 1;
+                else
+                    lo = mid + 1;
+            }
+        } else {
+            h.magic = 0;
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&(hdr->gen), __ATOMIC_RELAXED) != gen)
+            continue;
+
+          /* Consistent snapshot, now check it is sane.
+           */
+        if (h.magic != RADIUS_INDEX_MAGIC) {
+            syslog( LOG_WARNING, "%s: %s: bad header. Ignoring", prog,
+                RADIUS_INDEX_FILE);
+            return STATUS_EIO;
+        }
+
+        if (!found)
+            return STATUS_ENOENT;
+
+        if (   (pentry->csum != radius_index_entry_csum(pentry))
+            || (pentry->name[RADIUS_INDEX_NAME_SZ-1] != 0)
+            || (pentry->gecos[RADIUS_INDEX_GECOS_SZ-1] != 0)
+            || (pentry->mpl < RADIUS_MIN_MPL)
+            || (pentry->mpl > RADIUS_MAX_MPL)) {
+            syslog( LOG_WARNING, "%s: %s: bad entry for \"%s\". Ignoring",
+                prog, RADIUS_INDEX_FILE, nam);
+            return STATUS_EIO;
+        }
+
+        return 0;
+    }
+
+    syslog( LOG_INFO, "%s: %s: busy. Ignoring", prog, RADIUS_INDEX_FILE);
+    return STATUS_EIO;
+}
+
+static int radius_write_index_cleanup(int status, int fd, void * map) {
+    if (map != MAP_FAILED)
+        munmap(map, RADIUS_INDEX_FILE_SZ);
+    if (fd != -1)
+        close(fd); /* Releases the lock */
+    return status;
+}
+
+static int radius_index_entry_cmp(const void * a, const void * b) {
+    return strncmp(((const RADIUS_INDEX_ENTRY *) a)->name,
+        ((const RADIUS_INDEX_ENTRY *) b)->name, RADIUS_INDEX_NAME_SZ);
+}
+
+/* Open, lock and map the index for writing. Writers are serialized by
+ * flock() on the index file, the lock is held until the fd is closed.
+ */
+static int radius_index_open_write( char * prog, int * pfd, void ** pmap) {
+
+    struct stat sb;
+
+    *pfd = -1;
+    *pmap = MAP_FAILED;
+
+    if (   ((*pfd = open(RADIUS_INDEX_FILE, O_RDWR|O_CREAT, 0644)) == -1)
+        || (flock(*pfd, LOCK_EX) == -1)
+        || (fstat(*pfd, &sb) == -1)
+        || (   (sb.st_size != RADIUS_INDEX_FILE_SZ)
+            && (ftruncate(*pfd, RADIUS_INDEX_FILE_SZ) == -1))
+        || ((*pmap = mmap(NULL, RADIUS_INDEX_FILE_SZ, PROT_READ|PROT_WRITE,
+                MAP_SHARED, *pfd, 0)) == MAP_FAILED)) {
+        syslog( LOG_WARNING, "%s: %s: update failed: errno %d", prog,
+            RADIUS_INDEX_FILE, errno);
+        return STATUS_EIO;
+    }
+
+    return 0;
+}
+
+/* Replace the index content with count sorted entries, in one sequence
+ * lock write section. Called with the index locked.
+ */
+static void radius_index_publish( char * prog, RADIUS_INDEX_HDR * hdr,
+    RADIUS_INDEX_ENTRY * entries, int count) {
+
+    RADIUS_INDEX_ENTRY * dst = (RADIUS_INDEX_ENTRY *) (hdr + 1);
+    RADIUS_INDEX_HDR h;
+    uint32_t gen;
+    int i;
+
+    memset((char *) &h, 0, sizeof(h));
+    if (count <= RADIUS_INDEX_MAX_USERS) {
+        h.magic = RADIUS_INDEX_MAGIC;
+        h.count = count;
+    } else {
+        /* Readers fall back to the per-user files.
+         */
+        syslog( LOG_WARNING, "%s: %s: %d users, more than %d. Disabled",
+            prog, RADIUS_INDEX_FILE, count, RADIUS_INDEX_MAX_USERS);
+        count = 0;
+    }
+    h.version = RADIUS_INDEX_VERSION;
+    h.entry_sz = sizeof(RADIUS_INDEX_ENTRY);
+    h.max_users = RADIUS_INDEX_MAX_USERS;
+    h.csum = radius_index_hdr_csum(&h);
+
+    for (i = 0; i < count; i++)
+        entries[i].csum = radius_index_entry_csum(&(entries[i]));
+
+      /* Odd gen while writing. A writer which died mid-update leaves it
+       * odd, and readers fall back until the next update.
+       */
+    gen = __atomic_load_n(&(hdr->gen), __ATOMIC_RELAXED) | 1;
+    __atomic_store_n(&(hdr->gen), gen, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(hdr, &h, offsetof(RADIUS_INDEX_HDR, gen));
+    memcpy(dst, entries, count * sizeof(*entries));
+
+    __atomic_store_n(&(hdr->gen), gen + 1, __ATOMIC_RELEASE);
+}
+
+/* Replace the whole index content with entries.
+ */
+int radius_write_index( char * prog, RADIUS_INDEX_ENTRY * entries,
+    int count) {
+
+    int fd;
+    void * map;
+
+    if (radius_index_open_write(prog, &fd, &map) != 0)
+        return radius_write_index_cleanup(STATUS_EIO, fd, map);
+
+    if (count <= RADIUS_INDEX_MAX_USERS)
+        qsort(entries, count, sizeof(*entries), radius_index_entry_cmp);
+
+    radius_index_publish(prog, map, entries, count);
+
+    return radius_write_index_cleanup(0, fd, map);
+}
+
+/* Index entry of the cached user nam, from its per-user file. The passwd
+ * fields are left unset. Returns 0 if nam is cached.
+ */
+static int radius_index_entry_init( char * prog, const char * nam,
+    RADIUS_INDEX_ENTRY * entry) {
+
+    int mpl;
+
+    if (   (strlen(nam) >= RADIUS_INDEX_NAME_SZ)
+        || (radius_lookup_cache_file(prog, nam, &mpl) != 0))
+        return STATUS_ENOENT;
+
+    memset((char *) entry, 0, sizeof(*entry));
+    snprintf(entry->name, sizeof(entry->name), "%s", nam);
+    entry->mpl = mpl;
+    entry->uid = entry->gid = (uint32_t) -1;
+
+    return 0;
+}
+
+static void radius_index_entry_set_pw( RADIUS_INDEX_ENTRY * entry,
+    const struct passwd * pwd) {
+
+    entry->uid = pwd->pw_uid;
+    entry->gid = pwd->pw_gid;
+    snprintf(entry->gecos, sizeof(entry->gecos), "%s",
+        pwd->pw_gecos ? pwd->pw_gecos : "");
+}
+
+static int radius_update_index_cleanup(int status, DIR * dir, FILE * fp,
+    RADIUS_INDEX_ENTRY * entries) {
+    if (dir)
+        closedir(dir);
+    if (fp)
+        fclose(fp);
+    if (entries)
+        free(entries);
+    return status;
+}
+
+/* Rebuild the index from RADIUS_ATTRIBUTE_CACHE_DIR and /etc/passwd.
+ * The passwd data of all the cached users is filled in one pass over
+ * /etc/passwd.
+ */
+int radius_update_index( char * prog) {
+
+    DIR * dir = NULL;
+    FILE * fp = NULL;
+    struct dirent * de;
+    RADIUS_INDEX_ENTRY * entries = NULL, * entry, key;
+    int count = 0;
+    char buf[BUFLEN];
+    struct passwd pw, *result = NULL;
+
+    if ((entries = calloc(RADIUS_INDEX_MAX_USERS + 1,
+            sizeof(*entries))) == NULL) {
+        return radius_update_index_cleanup(STATUS_EIO, dir, fp, entries);
+    }
+
+    if ((dir = opendir(RADIUS_ATTRIBUTE_CACHE_DIR)) == NULL) {
+        if (errno != ENOENT) {
+            syslog( LOG_WARNING, "%s: opendir(%s) failed: errno %d", prog,
+                RADIUS_ATTRIBUTE_CACHE_DIR, errno);
+            return radius_update_index_cleanup(STATUS_EIO, dir, fp, entries);
+        }
+    }
+
+    while (dir && ((de = readdir(dir)) != NULL)) {
+
+        if (de->d_name[0] == '.')
+            continue;
+
+        if (count > RADIUS_INDEX_MAX_USERS) {
+            /* Too many, radius_index_publish() disables the index.
+             */
+            break;
+        }
+
+        if (radius_index_entry_init(prog, de->d_name, &(entries[count])) == 0)
+            count++;
+    }
+
+    if (count > RADIUS_INDEX_MAX_USERS)
+        return radius_update_index_cleanup(
+            radius_write_index(prog, entries, count), dir, fp, entries);
+
+    qsort(entries, count, sizeof(*entries), radius_index_entry_cmp);
+
+    if ((count > 0) && ((fp = fopen(ETC_PASSWD, "r")) != NULL)) {
+        while (fgetpwent_r(fp, &pw, buf, sizeof(buf), &result) == 0) {
+            if (   (result == NULL)
+                || (result->pw_name == NULL)
+                || (strlen(result->pw_name) >= RADIUS_INDEX_NAME_SZ))
+                continue;
+
+            snprintf(key.name, sizeof(key.name), "%s", result->pw_name);
+            if ((entry = bsearch(&key, entries, count, sizeof(*entries),
+                    radius_index_entry_cmp)) == NULL)
+                continue;
+
+            radius_index_entry_set_pw(entry, result);
+        }
+    }
+
+    return radius_update_index_cleanup(
+        radius_write_index(prog, entries, count), dir, fp, entries);
+}
+
+/* Refresh the index entry of nam only: re-read its per-user file and its
+ * /etc/passwd entry, then add, replace or remove it. An index which is not
+ * valid is rebuilt.
+ */
+int radius_update_index_user( char * prog, const char * nam) {
+
+    int fd, status, lo, hi, mid, cmp, found = 0, count, i;
+    void * map;
+    RADIUS_INDEX_HDR * hdr;
+    RADIUS_INDEX_ENTRY * cur, * entries = NULL, entry;
+    char buf[BUFLEN];
+    struct passwd pw, *result = NULL;
+
+    if (radius_index_open_write(prog, &fd, &map) != 0)
+        return radius_write_index_cleanup(STATUS_EIO, fd, map);
+
+    hdr = map;
+    cur = (RADIUS_INDEX_ENTRY *) (hdr + 1);
+    count = hdr->count;
+
+      /* Only writers change the index, and we hold the lock.
+       */
+    status = (   (hdr->gen & 1)
+              || (hdr->magic != RADIUS_INDEX_MAGIC)
+              || (hdr->version != RADIUS_INDEX_VERSION)
+              || (hdr->entry_sz != sizeof(RADIUS_INDEX_ENTRY))
+              || (hdr->max_users != RADIUS_INDEX_MAX_USERS)
+              || (hdr->count > RADIUS_INDEX_MAX_USERS)
+              || (hdr->csum != radius_index_hdr_csum(hdr))) ? STATUS_EIO : 0;
+
+    for (i = 0; (status == 0) && (i < count); i++)
+        if (cur[i].csum != radius_index_entry_csum(&(cur[i])))
+            status = STATUS_EIO;
+
+    if (   (status == 0)
+        && ((entries = calloc(count + 1, sizeof(*entries))) == NULL))
+        status = STATUS_EIO;
+
+    if (status != 0) {
+        free(entries);
+        radius_write_index_cleanup(status, fd, map);
+        return radius_update_index(prog);
+    }
+
+    memcpy(entries, cur, count * sizeof(*entries));
+
+    lo = 0;
+    hi = count - 1;
+    while (lo <= hi) {
+        mid = lo + (hi - lo) / 2;
+        cmp = strncmp(nam, entries[mid].name, RADIUS_INDEX_NAME_SZ);
+        if (cmp == 0) {
+            found = 1;
+            lo = mid;
+            break;
+        }
+        if (cmp < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+
+    if (radius_index_entry_init(prog, nam, &entry) == 0) {
+        if (   (radius_getpwnam_r(prog, nam, &pw, buf, sizeof(buf),
+                    &result) == 0)
+            && result)
+            radius_index_entry_set_pw(&entry, result);
+
+        if (!found) {
+            memmove(&(entries[lo + 1]), &(entries[lo]),
+                (count - lo) * sizeof(*entries));
+            count++;
+        }
+        entries[lo] = entry;
+    } else if (found) {
+        memmove(&(entries[lo]), &(entries[lo + 1]),
+            (count - lo - 1) * sizeof(*entries));
+        count--;
+    }
+
+    radius_index_publish(prog, hdr, entries, count);
+    free(entries);
+
+    return radius_write_index_cleanup(0, fd, map);
+}
+
+/* MPL of nam from the index. Users missing from the index (e.g. a failed
+ * index update) or an unusable index fall back to the per-user file.
+ */
+int radius_lookup_cache( char * prog, const char * nam, int * pmpl) {
+
+    RADIUS_INDEX_ENTRY entry;
+
+    if (radius_lookup_index(prog, nam, &entry) == 0) {
+        *pmpl = entry.mpl;
+        return 0;
+    }
+
+    return radius_lookup_cache_file(prog, nam, pmpl);
+}
+
 int radius_copy_pw( RADIUS_NSS_CONF_B * conf, struct passwd * res,
     const char * nam, struct passwd * pwd,
     char * buffer, size_t buflen, int * errnop) {
@@ -777,7 +1357,7 @@ static int is_sshd_lookup_exit(int status, int fd, regex_t * re) {
 int is_sshd_lookup(RADIUS_NSS_CONF_B * conf, const char * name) {
     pid_t pid = getpid();
     int fd, i;
-    regex_t regex, * re = NULL;
+    regex_t regex, * re = NULL, * match_re = NULL;
     int reg_ret;
 
 
@@ -807,7 +1387,13 @@ int is_sshd_lookup(RADIUS_NSS_CONF_B * conf, const char * name) {
         return is_sshd_lookup_exit(0, fd, re);
     }
 
-    if (conf->unconfirmed_regexp) {
+    if (conf->unconfirmed_re) {
+
+          /* Already compiled by get_nss_config_cache().
+           */
+        match_re = conf->unconfirmed_re;
+
+    } else if (conf->unconfirmed_regexp) {
 
         if ((reg_ret = regcomp(&regex, conf->unconfirmed_regexp,
                 REG_EXTENDED|REG_NOSUB))) {
@@ -819,14 +1405,14 @@ int is_sshd_lookup(RADIUS_NSS_CONF_B * conf, const char * name) {
 
         } else {
 
-            re = &regex;
+            match_re = re = &regex;
 
         }
     }
 
-    if (re) {
+    if (match_re) {
 
-        if (!(reg_ret = regexec(re, cmdline, 0, NULL, 0))) {
+        if (!(reg_ret = regexec(match_re, cmdline, 0, NULL, 0))) {
             syslog( LOG_INFO, "%s: %s: Lookup %s", conf->prog, cmdline, name);
             return is_sshd_lookup_exit(1, fd, re);
         }
@@ -25,6 +25,8 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #include <ctype.h>
 #include <netdb.h>
 #include <nss.h>
+#include <regex.h>
+#include <stdint.h>
 
 #define RADIUS_MAX_MPL (15)
 #define RADIUS_MIN_MPL (1)
@@ -36,11 +38,9 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #define RADIUS_CACHE_DIR "/var/cache/radius"
 #define RADIUS_ATTR_MPL "Management-Privilege-Level"
 
-#define ETC_PASSWD "/etc/passwd"
+#define RADIUS_INDEX_FILE "/var/cache/radius/user_index"
 
-#define USERADD "/usr/sbin/useradd"
-#define USERMOD "/usr/sbin/usermod"
-#define USERDEL "/usr/sbin/userdel"
+#define ETC_PASSWD "/etc/passwd"
 
 #define BUFLEN 4096
 
@@ -61,16 +61,12 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #undef RADIUS_ATTRIBUTE_CACHE_DIR
 #define RADIUS_ATTRIBUTE_CACHE_DIR "user"
 
+#undef RADIUS_INDEX_FILE
+#define RADIUS_INDEX_FILE "user_index"
 
-#undef ETC_PASSWD
-#define ETC_PASSWD "passwd"
 
-#undef USERADD
-#define USERADD "/bin/echo"
-#undef USERMOD
-#define USERMOD "/bin/echo"
-#undef USERDEL
-#define USERDEL "/bin/echo"
+#undef ETC_PASSWD
+#define ETC_PASSWD "./etc/passwd"
 
 #define syslog(priority,format,...) fprintf(stderr,format"\n",__VA_ARGS__)
 
@@ -87,6 +83,42 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 
 
 
+/* User index: RADIUS_ATTRIBUTE_CACHE_DIR and /etc/passwd data of all cached
+ * users in one file, mmap()ed by every NSS client. Updated in place by the
+ * writer under flock(), read lock-free using gen as a sequence lock (odd
+ * while an update is in progress). Any inconsistency sends the reader back
+ * to the per-user files.
+ */
+#define RADIUS_INDEX_MAGIC          0x52444958 /* "RDIX" */
+#define RADIUS_INDEX_VERSION        1
+#define RADIUS_INDEX_MAX_USERS      1024
+#define RADIUS_INDEX_NAME_SZ        40
+#define RADIUS_INDEX_GECOS_SZ       64
+#define RADIUS_INDEX_READ_RETRIES   64
+
+typedef struct _radius_index_entry {
+    char        name[RADIUS_INDEX_NAME_SZ];
+    char        gecos[RADIUS_INDEX_GECOS_SZ];
+    int32_t     mpl;
+    uint32_t    uid;
+    uint32_t    gid;
+    uint32_t    csum;       /* Of all the fields above */
+} RADIUS_INDEX_ENTRY;
+
+typedef struct _radius_index_hdr {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    entry_sz;
+    uint32_t    max_users;
+    uint32_t    count;      /* Entries, sorted by name */
+    uint32_t    csum;       /* Of all the fields above */
+    uint32_t    gen;        /* Sequence lock */
+    uint32_t    pad;
+} RADIUS_INDEX_HDR;
+
+#define RADIUS_INDEX_FILE_SZ \
+    (sizeof(RADIUS_INDEX_HDR) + RADIUS_INDEX_MAX_USERS * sizeof(RADIUS_INDEX_ENTRY))
+
 typedef struct _radius_nss_mpl {
     gid_t       gid;
     char        * groups;    /* Supplementary groups */
@@ -101,6 +133,7 @@ typedef struct _radius_nss_conf {
     int many_to_one;
     int allow_anonymous;
     char * unconfirmed_regexp;
+    regex_t * unconfirmed_re;     /* Compiled unconfirmed_regexp, if cached */
     int unconfirmed_ageout;
     int unconfirmed_clear_limit;
     RADIUS_NSS_MPL rnm[RADIUS_MAX_MPL];
@@ -111,8 +144,23 @@ int parse_nss_config( RADIUS_NSS_CONF_B * conf, char * prog,
 
 int unparse_nss_config( RADIUS_NSS_CONF_B * conf, int * errnop, int * plockfd);
 
+RADIUS_NSS_CONF_B * get_nss_config_cache( char * prog, int * errnop);
+
+void put_nss_config_cache( RADIUS_NSS_CONF_B * conf);
+
+int lock_nss_config_cache( RADIUS_NSS_CONF_B * conf, int * plockfd);
+
 int radius_lookup_cache( char * prog, const char * nam, int * pmpl);
 
+int radius_lookup_index( char * prog, const char * nam,
+    RADIUS_INDEX_ENTRY * pentry);
+
+int radius_write_index( char * prog, RADIUS_INDEX_ENTRY * entries, int count);
+
+int radius_update_index( char * prog);
+
+int radius_update_index_user( char * prog, const char * nam);
+
 int radius_fill_pw( RADIUS_NSS_CONF_B * conf, int mpl,
     const char * nam, struct passwd * pwd,
     char * buffer, size_t buflen, int * errnop);
@@ -0,0 +1,1097 @@
+/*
+Copyright 2020 Broadcom. All rights reserved.
+The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
+*/
+
+/*
+ * In-process passwd/shadow/group/gshadow editing for RADIUS users.
+ * Does what "useradd [-U|-g gid] -G -c -d -m -s", "usermod -G -c" and
+ * "userdel -r" do for the users created by this package.
+ */
+
+#define _GNU_SOURCE     /* asprintf() */
+#include <stdio.h>
+#include <stdarg.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <syslog.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <shadow.h>
+
+#include "nss_radius_common.h"
+#include "radius_pwdb.h"
+
+#define PWDB_FILE_GROUP     0
+#define PWDB_FILE_GSHADOW   1
+#define PWDB_FILE_PASSWD    2
+#define PWDB_FILE_SHADOW    3
+#define PWDB_FILE_MAX       4
+
+#define PWDB_ID_MIN_DEFAULT 1000
+#define PWDB_ID_MAX_DEFAULT 60000
+
+#define PWDB_SKEL_MAX_DEPTH 8
+
+  /* Size of a buffer for db->root followed by the fixed path rel.
+   */
+#define PWDB_ROOT_PATH_SZ(rel)  (PATH_MAX + sizeof(rel))
+
+typedef struct _radius_pwdb_file {
+    const char  * rel;
+    int         required;
+    char        path[PATH_MAX];
+    char        tmp[PATH_MAX + 1];  /* "<path>+", written before rename() */
+    char        ** lines;
+    int         count;
+    int         size;
+    int         exists;
+    int         dirty;
+    int         written;            /* tmp holds the new content */
+    struct stat sb;
+} RADIUS_PWDB_FILE;
+
+typedef struct _radius_pwdb_ctx {
+    RADIUS_PWDB * db;
+    RADIUS_PWDB_FILE files[PWDB_FILE_MAX];
+    long        uid_min, uid_max;
+    long        gid_min, gid_max;
+    int         lockfd;
+} RADIUS_PWDB_CTX;
+
+  /* Renamed in this order: groups first, so that a crash in the middle
+   * never leaves a user whose primary group does not exist.
+   */
+static const struct {
+    const char * rel;
+    int required;
+} pwdb_files[PWDB_FILE_MAX] = {
+    { "/etc/group",   1 },
+    { "/etc/gshadow", 0 },
+    { "/etc/passwd",  1 },
+    { "/etc/shadow",  1 },
+};
+
+static int pwdb_valid_field(const char * s) {
+    return s && !strpbrk(s, ":\n");
+}
+
+  /* New line, or NULL if out of memory.
+   */
+static char * pwdb_line(const char * fmt, ...) {
+    va_list ap;
+    char * line;
+    int n;
+
+    va_start(ap, fmt);
+    n = vasprintf(&line, fmt, ap);
+    va_end(ap);
+
+    return (n == -1) ? NULL : line;
+}
+
+void radius_pwdb_init( RADIUS_PWDB * db, char * prog, const char * root) {
+
+    memset((char *) db, 0, sizeof(*db));
+    db->prog = prog;
+    snprintf(db->root, sizeof(db->root), "%s", root ? root : "");
+}
+
+void radius_pwdb_free( RADIUS_PWDB * db) {
+
+    int i;
+
+    for (i = 0; i < db->count; i++) {
+        free(db->ops[i].name);
+        free(db->ops[i].groups);
+        free(db->ops[i].gecos);
+        free(db->ops[i].home);
+        free(db->ops[i].shell);
+    }
+
+    free(db->ops);
+    db->ops = NULL;
+    db->count = db->size = 0;
+}
+
+static RADIUS_PWDB_OP * pwdb_op_new(RADIUS_PWDB * db, int op,
+    const char * name) {
+
+    RADIUS_PWDB_OP * ops;
+
+    if (   !pwdb_valid_field(name) || (name[0] == 0) || (name[0] == '-')
+        || (strlen(name) > 32) || strchr(name, '/') || strchr(name, ',')) {
+        syslog(LOG_ERR, "%s: Invalid user name \"%s\"", db->prog,
+            name ? name : "");
+        return NULL;
+    }
+
+    if (db->count == db->size) {
+        if ((ops = realloc(db->ops, (db->size + 8) * sizeof(*ops))) == NULL)
+            return NULL;
+        db->ops = ops;
+        db->size += 8;
+    }
+
+    ops = &(db->ops[db->count++]);
+    memset((char *) ops, 0, sizeof(*ops));
+    ops->op = op;
+    ops->name = strdup(name);
+
+    return ops;
+}
+
+int radius_pwdb_add_user( RADIUS_PWDB * db, const char * name, gid_t gid,
+    const char * groups, const char * gecos, const char * home,
+    const char * shell) {
+
+    RADIUS_PWDB_OP * op;
+    char def_home[PATH_MAX];
+
+    if (   !pwdb_valid_field(groups) || !pwdb_valid_field(gecos)
+        || (home && !pwdb_valid_field(home)) || !pwdb_valid_field(shell)
+        || ((op = pwdb_op_new(db, RADIUS_PWDB_OP_ADD, name)) == NULL))
+        return STATUS_EINVAL;
+
+    snprintf(def_home, sizeof(def_home), "/home/%s", name);
+
+    op->gid = gid;
+    op->groups = strdup(groups);
+    op->gecos = strdup(gecos);
+    op->home = strdup(home ? home : def_home);
+    op->shell = strdup(shell);
+
+    return 0;
+}
+
+int radius_pwdb_mod_user( RADIUS_PWDB * db, const char * name,
+    const char * groups, const char * gecos) {
+
+    RADIUS_PWDB_OP * op;
+
+    if (   !pwdb_valid_field(groups) || (gecos && !pwdb_valid_field(gecos))
+        || ((op = pwdb_op_new(db, RADIUS_PWDB_OP_MOD, name)) == NULL))
+        return STATUS_EINVAL;
+
+    op->groups = strdup(groups);
+    op->gecos = gecos ? strdup(gecos) : NULL;
+
+    return 0;
+}
+
+int radius_pwdb_del_user( RADIUS_PWDB * db, const char * name) {
+
+    if (pwdb_op_new(db, RADIUS_PWDB_OP_DEL, name) == NULL)
+        return STATUS_EINVAL;
+
+    return 0;
+}
+
+/*
+ * Files.
+ */
+
+static void pwdb_file_free(RADIUS_PWDB_FILE * f) {
+    int i;
+
+    for (i = 0; i < f->count; i++)
+        free(f->lines[i]);
+    free(f->lines);
+    f->lines = NULL;
+    f->count = f->size = 0;
+}
+
+static int pwdb_file_append(RADIUS_PWDB_FILE * f, char * line) {
+    char ** lines;
+
+    if (line == NULL)
+        return STATUS_EIO;
+
+    if (f->count == f->size) {
+        if ((lines = realloc(f->lines, (f->size + 64) * sizeof(*lines)))
+                == NULL) {
+            free(line);
+            return STATUS_EIO;
+        }
+        f->lines = lines;
+        f->size += 64;
+    }
+
+    f->lines[f->count++] = line;
+    f->dirty = 1;
+
+    return 0;
+}
+
+static int pwdb_file_replace(RADIUS_PWDB_FILE * f, int idx, char * line) {
+    if (line == NULL)
+        return STATUS_EIO;
+    free(f->lines[idx]);
+    f->lines[idx] = line;
+    f->dirty = 1;
+
+    return 0;
+}
+
+static void pwdb_file_remove(RADIUS_PWDB_FILE * f, int idx) {
+    free(f->lines[idx]);
+    memmove(&(f->lines[idx]), &(f->lines[idx+1]),
+        (f->count - idx - 1) * sizeof(*(f->lines)));
+    f->count--;
+    f->dirty = 1;
+}
+
+static int pwdb_file_load(RADIUS_PWDB_CTX * ctx, RADIUS_PWDB_FILE * f) {
+
+    FILE * fp;
+    char * line = NULL;
+    size_t len = 0;
+    ssize_t n;
+    int status = 0;
+
+    if (snprintf(f->path, sizeof(f->path), "%s%s", ctx->db->root, f->rel)
+            >= (int) sizeof(f->path)) {
+        syslog(LOG_ERR, "%s: \"%s%s\": path too long", ctx->db->prog,
+            ctx->db->root, f->rel);
+        return STATUS_E2BIG;
+    }
+
+    if ((fp = fopen(f->path, "r")) == NULL) {
+        if ((errno == ENOENT) && !f->required)
+            return 0;
+        syslog(LOG_ERR, "%s: fopen(\"%s\") failed: errno %d", ctx->db->prog,
+            f->path, errno);
+        return STATUS_ENOENT;
+    }
+
+    if (fstat(fileno(fp), &(f->sb)) == -1) {
+        syslog(LOG_ERR, "%s: fstat(\"%s\") failed: errno %d", ctx->db->prog,
+            f->path, errno);
+        fclose(fp);
+        return STATUS_EIO;
+    }
+    f->exists = 1;
+
+    while ((n = getline(&line, &len, fp)) != -1) {
+        if ((n > 0) && (line[n-1] == '\n'))
+            line[n-1] = 0;
+        if ((status = pwdb_file_append(f, strdup(line))) != 0)
+            break;
+    }
+
+    free(line);
+    fclose(fp);
+    f->dirty = 0;
+
+    return status;
+}
+
+  /* Write the new content of f to "<file>+". It only replaces the file
+   * once every modified file is written, see pwdb_file_rename().
+   */
+static int pwdb_file_write(RADIUS_PWDB_CTX * ctx, RADIUS_PWDB_FILE * f) {
+
+    FILE * fp = NULL;
+    int fd, i;
+
+    snprintf(f->tmp, sizeof(f->tmp), "%s+", f->path);
+    unlink(f->tmp);
+
+    if ((fd = open(f->tmp, O_WRONLY|O_CREAT|O_EXCL, f->sb.st_mode & 07777))
+            == -1)
+        goto pwdb_file_write_fail;
+    f->written = 1;
+
+    if (   (fchown(fd, f->sb.st_uid, f->sb.st_gid) == -1)
+        || (fchmod(fd, f->sb.st_mode & 07777) == -1)) {
+        syslog(LOG_WARNING, "%s: \"%s\": owner/mode not preserved: errno %d",
+            ctx->db->prog, f->tmp, errno);
+    }
+
+    if ((fp = fdopen(fd, "w")) == NULL) {
+        close(fd);
+        goto pwdb_file_write_fail;
+    }
+
+    for (i = 0; i < f->count; i++) {
+        if (fprintf(fp, "%s\n", f->lines[i]) < 0)
+            goto pwdb_file_write_fail;
+    }
+
+    if ((fflush(fp) != 0) || (fsync(fileno(fp)) != 0))
+        goto pwdb_file_write_fail;
+
+    if (fclose(fp) != 0) {
+        fp = NULL;
+        goto pwdb_file_write_fail;
+    }
+
+    return 0;
+
+pwdb_file_write_fail:
+
+    syslog(LOG_ERR, "%s: \"%s\": update failed: errno %d", ctx->db->prog,
+        f->path, errno);
+    if (fp)
+        fclose(fp);
+
+    return STATUS_EIO;
+}
+
+  /* Replace the file with its written "<file>+", or drop the "<file>+" if
+   * the commit failed.
+   */
+static int pwdb_file_rename(RADIUS_PWDB_CTX * ctx, RADIUS_PWDB_FILE * f,
+    int status) {
+
+    if (!f->written)
+        return status;
+    f->written = 0;
+
+    if (status == 0) {
+        if (rename(f->tmp, f->path) == 0) {
+            f->dirty = 0;
+            return 0;
+        }
+        syslog(LOG_ERR, "%s: \"%s\": update failed: errno %d", ctx->db->prog,
+            f->path, errno);
+        status = STATUS_EIO;
+    }
+
+    unlink(f->tmp);
+
+    return status;
+}
+
+/*
+ * Lines and fields.
+ */
+
+static int pwdb_find(RADIUS_PWDB_FILE * f, const char * name) {
+    size_t len = strlen(name);
+    int i;
+
+    for (i = 0; i < f->count; i++) {
+        if ((strncmp(f->lines[i], name, len) == 0) && (f->lines[i][len] == ':'))
+            return i;
+    }
+
+    return -1;
+}
+
+static int pwdb_field(const char * line, int n, char * buf, size_t len) {
+    const char * end;
+
+    for ( ; n > 0; n--) {
+        if ((line = strchr(line, ':')) == NULL)
+            return STATUS_ENOENT;
+        line++;
+    }
+
+    if ((end = strchr(line, ':')) == NULL)
+        end = line + strlen(line);
+
+    snprintf(buf, len, "%.*s", (int) (end - line), line);
+
+    return 0;
+}
+
+  /* Field n of line in a new string, not truncated.
+   */
+static int pwdb_field_dup(const char * line, int n, char ** res) {
+    const char * end;
+
+    for ( ; n > 0; n--) {
+        if ((line = strchr(line, ':')) == NULL)
+            return STATUS_ENOENT;
+        line++;
+    }
+
+    if ((end = strchr(line, ':')) == NULL)
+        end = line + strlen(line);
+
+    if ((*res = strndup(line, end - line)) == NULL)
+        return STATUS_EIO;
+
+    return 0;
+}
+
+static long pwdb_field_id(const char * line, int n) {
+    char buf[32];
+    char * end;
+    long id;
+
+    if (pwdb_field(line, n, buf, sizeof(buf)) != 0)
+        return -1;
+
+    id = strtol(buf, &end, 10);
+    if ((buf[0] == 0) || (*end != 0))
+        return -1;
+
+    return id;
+}
+
+static char * pwdb_set_field(const char * line, int n, const char * value) {
+    const char * start = line, * end;
+    char * res;
+
+    for ( ; n > 0; n--) {
+        if ((start = strchr(start, ':')) == NULL)
+            return NULL;
+        start++;
+    }
+
+    if ((end = strchr(start, ':')) == NULL)
+        end = start + strlen(start);
+
+    if (asprintf(&res, "%.*s%s%s", (int) (start - line), line, value, end)
+            == -1)
+        return NULL;
+
+    return res;
+}
+
+static int pwdb_in_list(const char * list, const char * name) {
+    size_t len = strlen(name);
+
+    while (list && *list) {
+        if ((strncmp(list, name, len) == 0)
+            && ((list[len] == ',') || (list[len] == 0)))
+            return 1;
+        if ((list = strchr(list, ',')) != NULL)
+            list++;
+    }
+
+    return 0;
+}
+
+  /* Add or remove user in the member list (field 3) of group and gshadow
+   * line idx. Lines without a member list are left alone.
+   */
+static int pwdb_set_member(RADIUS_PWDB_FILE * f, int idx,
+    const char * user, int member) {
+
+    char * members = NULL, * updated = NULL;
+    char * tok, * save = NULL;
+    size_t len = 0, tok_len;
+    int status;
+
+    if (idx < 0)
+        return 0;
+
+    if ((status = pwdb_field_dup(f->lines[idx], 3, &members)) != 0)
+        return (status == STATUS_ENOENT) ? 0 : status;
+
+    if (pwdb_in_list(members, user) == member) {
+        free(members);
+        return 0;
+    }
+
+      /* The list only grows by ",user".
+       */
+    if ((updated = malloc(strlen(members) + strlen(user) + 2)) == NULL) {
+        free(members);
+        return STATUS_EIO;
+    }
+
+    for (tok = strtok_r(members, ",", &save); tok;
+            tok = strtok_r(NULL, ",", &save)) {
+        if (strcmp(tok, user) == 0)
+            continue;
+        if (len)
+            updated[len++] = ',';
+        tok_len = strlen(tok);
+        memcpy(updated + len, tok, tok_len);
+        len += tok_len;
+    }
+
+    if (member) {
+        if (len)
+            updated[len++] = ',';
+        tok_len = strlen(user);
+        memcpy(updated + len, user, tok_len);
+        len += tok_len;
+    }
+    updated[len] = 0;
+
+    status = pwdb_file_replace(f, idx, pwdb_set_field(f->lines[idx], 3,
+        updated));
+
+    free(members);
+    free(updated);
+
+    return status;
+}
+
+static int pwdb_id_used(RADIUS_PWDB_FILE * f, long id) {
+    int i;
+
+    for (i = 0; i < f->count; i++) {
+        if (pwdb_field_id(f->lines[i], 2) == id)
+            return 1;
+    }
+
+    return 0;
+}
+
+  /* As useradd: the highest id in [min, max] plus one.
+   */
+static long pwdb_next_id(RADIUS_PWDB_FILE * f, long min, long max) {
+    long id, next = min;
+    int i;
+
+    for (i = 0; i < f->count; i++) {
+        id = pwdb_field_id(f->lines[i], 2);
+        if ((id >= min) && (id <= max) && (id >= next))
+            next = id + 1;
+    }
+
+    return (next <= max) ? next : -1;
+}
+
+static void pwdb_login_defs(RADIUS_PWDB_CTX * ctx) {
+
+    char path[PWDB_ROOT_PATH_SZ("/etc/login.defs")];
+    char key[32];
+    char * line = NULL;
+    size_t len = 0;
+    long value;
+    FILE * fp;
+
+    ctx->uid_min = ctx->gid_min = PWDB_ID_MIN_DEFAULT;
+    ctx->uid_max = ctx->gid_max = PWDB_ID_MAX_DEFAULT;
+
+    snprintf(path, sizeof(path), "%s/etc/login.defs", ctx->db->root);
+    if ((fp = fopen(path, "r")) == NULL)
+        return;
+
+    while (getline(&line, &len, fp) != -1) {
+        if (sscanf(line, " %31s %ld", key, &value) != 2)
+            continue;
+        if (strcmp(key, "UID_MIN") == 0)
+            ctx->uid_min = value;
+        else if (strcmp(key, "UID_MAX") == 0)
+            ctx->uid_max = value;
+        else if (strcmp(key, "GID_MIN") == 0)
+            ctx->gid_min = value;
+        else if (strcmp(key, "GID_MAX") == 0)
+            ctx->gid_max = value;
+    }
+
+    free(line);
+    fclose(fp);
+}
+
+/*
+ * Operations, applied to the files in memory.
+ */
+
+  /* Check every group of the comma separated list exists.
+   */
+static int pwdb_groups_exist(RADIUS_PWDB_CTX * ctx, const char * groups) {
+
+    RADIUS_PWDB_FILE * group = &(ctx->files[PWDB_FILE_GROUP]);
+    char * list, * tok, * save = NULL;
+    int status = 0;
+
+    if ((list = strdup(groups)) == NULL)
+        return STATUS_EIO;
+
+    for (tok = strtok_r(list, ",", &save); tok && (status == 0);
+            tok = strtok_r(NULL, ",", &save)) {
+        if (pwdb_find(group, tok) < 0) {
+            syslog(LOG_ERR, "%s: group \"%s\" does not exist", ctx->db->prog,
+                tok);
+            status = STATUS_ENOENT;
+        }
+    }
+
+    free(list);
+
+    return status;
+}
+
+static int pwdb_apply_add(RADIUS_PWDB_CTX * ctx, RADIUS_PWDB_OP * op) {
+
+    RADIUS_PWDB_FILE * passwd = &(ctx->files[PWDB_FILE_PASSWD]);
+    RADIUS_PWDB_FILE * shadow = &(ctx->files[PWDB_FILE_SHADOW]);
+    RADIUS_PWDB_FILE * group = &(ctx->files[PWDB_FILE_GROUP]);
+    RADIUS_PWDB_FILE * gshadow = &(ctx->files[PWDB_FILE_GSHADOW]);
+    char * list, * tok, * save = NULL;
+    long uid, gid;
+    int status;
+
+    if (pwdb_find(passwd, op->name) >= 0) {
+        syslog(LOG_ERR, "%s: user \"%s\" already exists", ctx->db->prog,
+            op->name);
+        return STATUS_EPERM;
+    }
+
+    if ((status = pwdb_groups_exist(ctx, op->groups)) != 0)
+        return status;
+
+    if (op->gid == RADIUS_PWDB_USER_GROUP) {
+        if (pwdb_find(group, op->name) >= 0) {
+            syslog(LOG_ERR, "%s: group \"%s\" already exists", ctx->db->prog,
+                op->name);
+            return STATUS_EPERM;
+        }
+    } else if (!pwdb_id_used(group, op->gid)) {
+        syslog(LOG_ERR, "%s: group %d does not exist", ctx->db->prog,
+            (int) op->gid);
+        return STATUS_ENOENT;
+    }
+
+    if ((uid = pwdb_next_id(passwd, ctx->uid_min, ctx->uid_max)) < 0) {
+        syslog(LOG_ERR, "%s: no free uid for \"%s\"", ctx->db->prog, op->name);
+        return STATUS_E2BIG;
+    }
+
+    gid = op->gid;
+    if (op->gid == RADIUS_PWDB_USER_GROUP) {
+
+          /* As useradd -U, the same id as the user if free.
+           */
+        if (   (uid >= ctx->gid_min) && (uid <= ctx->gid_max)
+            && !pwdb_id_used(group, uid)) {
+            gid = uid;
+        } else if ((gid = pwdb_next_id(group, ctx->gid_min, ctx->gid_max))
+                < 0) {
+            syslog(LOG_ERR, "%s: no free gid for \"%s\"", ctx->db->prog,
+                op->name);
+            return STATUS_E2BIG;
+        }
+    }
+
+    if ((list = strdup(op->groups)) == NULL)
+        return STATUS_EIO;
+
+      /* From here on a failure leaves the files in memory half updated,
+       * radius_pwdb_commit() then writes none of them.
+       */
+    if (op->gid == RADIUS_PWDB_USER_GROUP) {
+        if ((status = pwdb_file_append(group,
+                pwdb_line("%s:x:%ld:", op->name, gid))) != 0)
+            goto pwdb_apply_add_exit;
+
+        if (   gshadow->exists
+            && ((status = pwdb_file_append(gshadow,
+                    pwdb_line("%s:!::", op->name))) != 0))
+            goto pwdb_apply_add_exit;
+    }
+
+    if ((status = pwdb_file_append(passwd, pwdb_line("%s:x:%ld:%ld:%s:%s:%s",
+            op->name, uid, gid, op->gecos, op->home, op->shell))) != 0)
+        goto pwdb_apply_add_exit;
+
+    if ((status = pwdb_file_append(shadow, pwdb_line("%s:!:%ld:0:99999:7:::",
+            op->name, (long) (time(NULL) / (24 * 60 * 60))))) != 0)
+        goto pwdb_apply_add_exit;
+
+    for (tok = strtok_r(list, ",", &save); tok && (status == 0);
+            tok = strtok_r(NULL, ",", &save)) {
+        status = pwdb_set_member(group, pwdb_find(group, tok), op->name, 1);
+        if ((status == 0) && gshadow->exists)
+            status = pwdb_set_member(gshadow, pwdb_find(gshadow, tok),
+                op->name, 1);
+    }
+
+    op->uid = uid;
+    op->gid = gid;
+
+pwdb_apply_add_exit:
+
+    free(list);
+
+    return status;
+}
+
+static int pwdb_apply_mod(RADIUS_PWDB_CTX * ctx, RADIUS_PWDB_OP * op) {
+
+    RADIUS_PWDB_FILE * passwd = &(ctx->files[PWDB_FILE_PASSWD]);
+    RADIUS_PWDB_FILE * group = &(ctx->files[PWDB_FILE_GROUP]);
+    RADIUS_PWDB_FILE * gshadow = &(ctx->files[PWDB_FILE_GSHADOW]);
+    char name[BUFLEN];
+    int idx, i, status;
+
+    if ((idx = pwdb_find(passwd, op->name)) < 0) {
+        syslog(LOG_ERR, "%s: user \"%s\" does not exist", ctx->db->prog,
+            op->name);
+        return STATUS_ENOENT;
+    }
+
+    if ((status = pwdb_groups_exist(ctx, op->groups)) != 0)
+        return status;
+
+      /* As usermod -G, the user is a member of exactly these groups.
+       */
+    for (i = 0; (i < group->count) && (status == 0); i++) {
+        if (pwdb_field(group->lines[i], 0, name, sizeof(name)) != 0)
+            continue;
+        status = pwdb_set_member(group, i, op->name,
+            pwdb_in_list(op->groups, name));
+    }
+
+    for (i = 0; gshadow->exists && (i < gshadow->count) && (status == 0);
+            i++) {
+        if (pwdb_field(gshadow->lines[i], 0, name, sizeof(name)) != 0)
+            continue;
+        status = pwdb_set_member(gshadow, i, op->name,
+            pwdb_in_list(op->groups, name));
+    }
+
+    if ((status == 0) && op->gecos)
+        status = pwdb_file_replace(passwd, idx,
+            pwdb_set_field(passwd->lines[idx], 4, op->gecos));
+
+    return status;
+}
+
+static int pwdb_apply_del(RADIUS_PWDB_CTX * ctx, RADIUS_PWDB_OP * op) {
+
+    RADIUS_PWDB_FILE * passwd = &(ctx->files[PWDB_FILE_PASSWD]);
+    RADIUS_PWDB_FILE * shadow = &(ctx->files[PWDB_FILE_SHADOW]);
+    RADIUS_PWDB_FILE * group = &(ctx->files[PWDB_FILE_GROUP]);
+    RADIUS_PWDB_FILE * gshadow = &(ctx->files[PWDB_FILE_GSHADOW]);
+    char * home;
+    long gid;
+    int idx, i, status = 0;
+
+    if ((idx = pwdb_find(passwd, op->name)) < 0) {
+        syslog(LOG_ERR, "%s: user \"%s\" does not exist", ctx->db->prog,
+            op->name);
+        return STATUS_ENOENT;
+    }
+
+    op->uid = pwdb_field_id(passwd->lines[idx], 2);
+    gid = pwdb_field_id(passwd->lines[idx], 3);
+    if ((status = pwdb_field_dup(passwd->lines[idx], 5, &home)) == 0) {
+        free(op->home);
+        op->home = home;
+    } else if (status == STATUS_EIO) {
+        return status;
+    }
+    status = 0;
+
+    pwdb_file_remove(passwd, idx);
+    if ((idx = pwdb_find(shadow, op->name)) >= 0)
+        pwdb_file_remove(shadow, idx);
+
+    for (i = 0; (i < group->count) && (status == 0); i++)
+        status = pwdb_set_member(group, i, op->name, 0);
+    for (i = 0; gshadow->exists && (i < gshadow->count) && (status == 0); i++)
+        status = pwdb_set_member(gshadow, i, op->name, 0);
+
+    if (status != 0)
+        return status;
+
+      /* As userdel, remove the user's own group.
+       */
+    if (   ((idx = pwdb_find(group, op->name)) >= 0)
+        && (pwdb_field_id(group->lines[idx], 2) == gid)) {
+        pwdb_file_remove(group, idx);
+        if (gshadow->exists && ((idx = pwdb_find(gshadow, op->name)) >= 0))
+            pwdb_file_remove(gshadow, idx);
+    }
+
+    return 0;
+}
+
+/*
+ * Home directories, done after the files are committed and unlocked.
+ */
+
+static void pwdb_copy_tree(RADIUS_PWDB * db, const char * src,
+    const char * dst, uid_t uid, gid_t gid, int depth) {
+
+    DIR * dir;
+    struct dirent * de;
+    struct stat sb;
+    char s[PATH_MAX], d[PATH_MAX], buf[BUFLEN];
+    int sfd, dfd;
+    ssize_t n;
+
+    if ((depth > PWDB_SKEL_MAX_DEPTH) || ((dir = opendir(src)) == NULL))
+        return;
+
+    while ((de = readdir(dir)) != NULL) {
+
+        if ((strcmp(de->d_name, ".") == 0) || (strcmp(de->d_name, "..") == 0))
+            continue;
+
+        if (   (snprintf(s, sizeof(s), "%s/%s", src, de->d_name)
+                >= (int) sizeof(s))
+            || (snprintf(d, sizeof(d), "%s/%s", dst, de->d_name)
+                >= (int) sizeof(d))
+            || (lstat(s, &sb) == -1))
+            continue;
+
+        if (S_ISDIR(sb.st_mode)) {
+            if (mkdir(d, sb.st_mode & 07777) == 0) {
+                if (lchown(d, uid, gid) == -1)
+                    syslog(LOG_WARNING, "%s: chown(\"%s\") failed: errno %d",
+                        db->prog, d, errno);
+                pwdb_copy_tree(db, s, d, uid, gid, depth + 1);
+            }
+        } else if (S_ISLNK(sb.st_mode)) {
+            if ((n = readlink(s, buf, sizeof(buf) - 1)) > 0) {
+                buf[n] = 0;
+                if ((symlink(buf, d) == 0) && (lchown(d, uid, gid) == -1))
+                    syslog(LOG_WARNING, "%s: chown(\"%s\") failed: errno %d",
+                        db->prog, d, errno);
+            }
+        } else if (S_ISREG(sb.st_mode)) {
+            if ((sfd = open(s, O_RDONLY)) == -1)
+                continue;
+            if ((dfd = open(d, O_WRONLY|O_CREAT|O_EXCL, sb.st_mode & 07777))
+                    != -1) {
+                while ((n = read(sfd, buf, sizeof(buf))) > 0) {
+                    if (write(dfd, buf, n) != n)
+                        break;
+                }
+                if (fchown(dfd, uid, gid) == -1)
+                    syslog(LOG_WARNING, "%s: chown(\"%s\") failed: errno %d",
+                        db->prog, d, errno);
+                close(dfd);
+            }
+            close(sfd);
+        }
+    }
+
+    closedir(dir);
+}
+
+static void pwdb_create_home(RADIUS_PWDB * db, RADIUS_PWDB_OP * op) {
+
+    char home[PATH_MAX], skel[PWDB_ROOT_PATH_SZ("/etc/skel")];
+    mode_t mask;
+
+    if (snprintf(home, sizeof(home), "%s%s", db->root, op->home)
+            >= (int) sizeof(home)) {
+        syslog(LOG_WARNING, "%s: home directory \"%s%s\" not created: "
+            "path too long", db->prog, db->root, op->home);
+        return;
+    }
+    snprintf(skel, sizeof(skel), "%s/etc/skel", db->root);
+
+    mask = umask(022);
+
+    if (mkdir(home, 0755) == -1) {
+        syslog(LOG_WARNING, "%s: home directory \"%s\" not created: errno %d",
+            db->prog, home, errno);
+    } else {
+        if (chown(home, op->uid, op->gid) == -1)
+            syslog(LOG_WARNING, "%s: chown(\"%s\") failed: errno %d",
+                db->prog, home, errno);
+        pwdb_copy_tree(db, skel, home, op->uid, op->gid, 0);
+    }
+
+    umask(mask);
+}
+
+static void pwdb_remove_tree(const char * path, int depth) {
+
+    DIR * dir;
+    struct dirent * de;
+    struct stat sb;
+    char p[PATH_MAX];
+
+    if ((depth <= PWDB_SKEL_MAX_DEPTH * 4) && ((dir = opendir(path)) != NULL)) {
+        while ((de = readdir(dir)) != NULL) {
+            if (   (strcmp(de->d_name, ".") == 0)
+                || (strcmp(de->d_name, "..") == 0))
+                continue;
+            if (snprintf(p, sizeof(p), "%s/%s", path, de->d_name)
+                    >= (int) sizeof(p))
+                continue;
+            if ((lstat(p, &sb) == 0) && S_ISDIR(sb.st_mode))
+                pwdb_remove_tree(p, depth + 1);
+            else
+                unlink(p);
+        }
+        closedir(dir);
+    }
+
+    rmdir(path);
+}
+
+static void pwdb_remove_home(RADIUS_PWDB * db, RADIUS_PWDB_OP * op) {
+
+    char path[PATH_MAX];
+    struct stat sb;
+
+    if (snprintf(path, sizeof(path), "%s/var/mail/%s", db->root, op->name)
+            < (int) sizeof(path))
+        unlink(path);
+
+    if ((op->home == NULL) || (strcmp(op->home, "/") == 0))
+        return;
+
+    if (snprintf(path, sizeof(path), "%s%s", db->root, op->home)
+            >= (int) sizeof(path)) {
+        syslog(LOG_WARNING, "%s: home directory \"%s%s\" not removed: "
+            "path too long", db->prog, db->root, op->home);
+        return;
+    }
+
+      /* As userdel -r, but never remove a directory the user doesn't own.
+       */
+    if (   (lstat(path, &sb) == -1) || !S_ISDIR(sb.st_mode)
+        || (sb.st_uid != op->uid)) {
+        syslog(LOG_WARNING, "%s: home directory \"%s\" not removed",
+            db->prog, path);
+        return;
+    }
+
+    pwdb_remove_tree(path, 0);
+}
+
+/*
+ * Commit.
+ */
+
+static int pwdb_lock(RADIUS_PWDB_CTX * ctx) {
+
+    char path[PWDB_ROOT_PATH_SZ("/etc/.pwd.lock")];
+    struct flock fl;
+
+    ctx->lockfd = -1;
+
+    if (ctx->db->root[0] == 0) {
+        if (lckpwdf() == -1) {
+            syslog(LOG_ERR, "%s: lckpwdf() failed: errno %d", ctx->db->prog,
+                errno);
+            return STATUS_EIO;
+        }
+        return 0;
+    }
+
+      /* Dry run, same as lckpwdf() below the root.
+       */
+    snprintf(path, sizeof(path), "%s/etc/.pwd.lock", ctx->db->root);
+    if ((ctx->lockfd = open(path, O_WRONLY|O_CREAT|O_CLOEXEC, 0600)) == -1)
+        return STATUS_EIO;
+
+    memset((char *) &fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    if (fcntl(ctx->lockfd, F_SETLKW, &fl) == -1) {
+        close(ctx->lockfd);
+        ctx->lockfd = -1;
+        return STATUS_EIO;
+    }
+
+    return 0;
+}
+
+static void pwdb_unlock(RADIUS_PWDB_CTX * ctx) {
+
+    if (ctx->db->root[0] == 0)
+        ulckpwdf();
+    else if (ctx->lockfd != -1)
+        close(ctx->lockfd);
+}
+
+  /* Apply all queued operations, in order, under one lock and with one
+   * rewrite per modified file. A failed operation is skipped, its status
+   * recorded, the others still applied. Running out of memory, or failing
+   * to write any file, fails the whole batch and changes no file.
+   * Returns 0, or the status of the first failure.
+   */
+int radius_pwdb_commit( RADIUS_PWDB * db) {
+
+    RADIUS_PWDB_CTX ctx;
+    RADIUS_PWDB_OP * op;
+    int status = 0, i;
+
+    if (db->count == 0)
+        return 0;
+
+    memset((char *) &ctx, 0, sizeof(ctx));
+    ctx.db = db;
+
+    for (i = 0; i < PWDB_FILE_MAX; i++) {
+        ctx.files[i].rel = pwdb_files[i].rel;
+        ctx.files[i].required = pwdb_files[i].required;
+    }
+
+    pwdb_login_defs(&ctx);
+
+    if ((status = pwdb_lock(&ctx)) != 0) {
+        for (i = 0; i < db->count; i++)
+            db->ops[i].status = status;
+        return status;
+    }
+
+    for (i = 0; (i < PWDB_FILE_MAX) && (status == 0); i++)
+        status = pwdb_file_load(&ctx, &(ctx.files[i]));
+
+    for (i = 0; i < db->count; i++) {
+        op = &(db->ops[i]);
+        if (status != 0) {
+            op->status = status;
+            continue;
+        }
+        switch (op->op) {
+            case RADIUS_PWDB_OP_ADD:
+                op->status = pwdb_apply_add(&ctx, op);
+                break;
+            case RADIUS_PWDB_OP_MOD:
+                op->status = pwdb_apply_mod(&ctx, op);
+                break;
+            case RADIUS_PWDB_OP_DEL:
+                op->status = pwdb_apply_del(&ctx, op);
+                break;
+            default:
+                op->status = STATUS_EINVAL;
+                break;
+        }
+
+          /* Out of memory part way through an operation, the files in
+           * memory may hold half of it.
+           */
+        if (op->status == STATUS_EIO)
+            status = STATUS_EIO;
+    }
+
+      /* Every modified file is written before any is renamed, so a failed
+       * write leaves all of them unchanged.
+       */
+    for (i = 0; (i < PWDB_FILE_MAX) && (status == 0); i++) {
+        if (ctx.files[i].dirty)
+            status = pwdb_file_write(&ctx, &(ctx.files[i]));
+    }
+
+    for (i = 0; i < PWDB_FILE_MAX; i++)
+        status = pwdb_file_rename(&ctx, &(ctx.files[i]), status);
+
+    pwdb_unlock(&ctx);
+
+    for (i = 0; i < PWDB_FILE_MAX; i++)
+        pwdb_file_free(&(ctx.files[i]));
+
+    for (i = 0; i < db->count; i++) {
+        op = &(db->ops[i]);
+        if (status != 0) {
+            op->status = status;
+            continue;
+        }
+        if (op->status != 0)
+            continue;
+        if (op->op == RADIUS_PWDB_OP_ADD)
+            pwdb_create_home(db, op);
+        else if (op->op == RADIUS_PWDB_OP_DEL)
+            pwdb_remove_home(db, op);
+    }
+
+    for (i = 0; (i < db->count) && (status == 0); i++)
+        status = db->ops[i].status;
+
+    return status;
+}
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 Broadcom. All rights reserved.
+The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
+*/
+
+/*
+ * radius_pwdb.h
+ *
+ * In-process passwd/shadow/group/gshadow editing for RADIUS users, used
+ * instead of fork()/exec() of useradd, usermod and userdel.
+ *
+ * Changes are queued, then applied in one batch by radius_pwdb_commit()
+ * while holding lckpwdf(): every modified file is first written to
+ * "<file>+", and only once all of them are written are they rename()d
+ * over the originals.
+ *
+ * All files are looked up under a root directory, "" for the host. Any
+ * other root is a dry run, which only touches files below that directory.
+ */
+
+#ifndef _RADIUS_PWDB_H_
+#define _RADIUS_PWDB_H_
+
+#include <sys/types.h>
+#include <limits.h>
+
+#define RADIUS_PWDB_ROOT ""
+
+#if defined(TEST_RADIUS_NSS)
+
+#undef RADIUS_PWDB_ROOT
+#define RADIUS_PWDB_ROOT "."
+
+#endif
+
+#define RADIUS_PWDB_USER_GROUP  ((gid_t) -1)
+
+#define RADIUS_PWDB_OP_ADD      1
+#define RADIUS_PWDB_OP_MOD      2
+#define RADIUS_PWDB_OP_DEL      3
+
+typedef struct _radius_pwdb_op {
+    int         op;
+    char        * name;
+    gid_t       gid;        /* ADD: RADIUS_PWDB_USER_GROUP as useradd -U */
+    char        * groups;   /* ADD, MOD: Supplementary groups, as -G */
+    char        * gecos;    /* ADD, MOD */
+    char        * home;     /* ADD */
+    char        * shell;    /* ADD */
+    uid_t       uid;        /* ADD, DEL: Set by radius_pwdb_commit() */
+    int         status;     /* Result, after radius_pwdb_commit() */
+} RADIUS_PWDB_OP;
+
+typedef struct _radius_pwdb {
+    char        * prog;
+    char        root[PATH_MAX];
+    int         count;
+    int         size;
+    RADIUS_PWDB_OP * ops;
+} RADIUS_PWDB;
+
+void radius_pwdb_init( RADIUS_PWDB * db, char * prog, const char * root);
+
+void radius_pwdb_free( RADIUS_PWDB * db);
+
+int radius_pwdb_add_user( RADIUS_PWDB * db, const char * name, gid_t gid,
+    const char * groups, const char * gecos, const char * home,
+    const char * shell);
+
+int radius_pwdb_mod_user( RADIUS_PWDB * db, const char * name,
+    const char * groups, const char * gecos);
+
+int radius_pwdb_del_user( RADIUS_PWDB * db, const char * name);
+
+int radius_pwdb_commit( RADIUS_PWDB * db);
+
+#endif /* _RADIUS_PWDB_H_ */
@@ -21,6 +21,39 @@ The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
 #include <ctype.h>
 #include <netdb.h>
 #include <nss.h>
+#include <time.h>
+
+/*
+ * Benchmark: test_nss_radius -b <count> [user]
+ * Looks up user (default "unknown") count times through the module,
+ * using the test config path (./radius_nss.conf).
+ */
+static int benchmark(int count, char * user) {
+
+    enum nss_status status = NSS_STATUS_NOTFOUND;
+    struct passwd pw;
+    char buf[256];
+    int err;
+    int i;
+    struct timespec start, end;
+    double elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for ( i = 0 ; i < count ; i++) {
+        status = _nss_radius_getpwnam_r( user, &pw, buf, sizeof(buf), &err);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+        + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+
+    printf("%s: status:%d, %d lookups in %.3f sec, %.0f getpwnam/sec\n",
+        user, status, count, elapsed, elapsed > 0 ? count / elapsed : 0);
+
+    return 0;
+}
 
 int main(int ac, char * av[]) {
 
@@ -33,6 +66,9 @@ int main(int ac, char * av[]) {
     char * users[] = { "admin", "user", "netops", "operator", "unknown", 0 };
     char ** u;
 
+    if ((ac >= 3) && (strcmp(av[1], "-b") == 0))
+        return benchmark(atoi(av[2]), (ac >= 4) ? av[3] : "unknown");
+
     printf("buf: %p, len: %lx\n", buf, sizeof(buf));
 
     for ( u = users ; *u ; u++) {
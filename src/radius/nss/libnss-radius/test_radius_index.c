@@ -0,0 +1,367 @@
+/*
+Copyright 2020 Broadcom. All rights reserved.
+The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
+*/
+
+/*
+ * Test code for the RADIUS user index: lookup, torn write detection,
+ * single user updates, concurrent writer/reader stress and lookup latency.
+ *
+ * Built with TEST_RADIUS_NSS, runs in the current directory.
+ */
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "nss_radius_common.h"
+
+#define TEST_USERS          64
+#define STRESS_ROUNDS       20000
+#define STRESS_READERS      4
+#define BENCH_LOOKUPS       200000
+
+static int failures;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            failures++;                                         \
+            printf("FAIL %s:%d: ", __FUNCTION__, __LINE__);     \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+        }                                                       \
+    } while (0)
+
+static char * prog = "test_radius_index";
+
+static void test_user_name(char * buf, size_t len, int i) {
+    snprintf(buf, len, "radius_user%03d", i);
+}
+
+static void write_user_cache(int i, int mpl) {
+    char path[PATH_MAX];
+    char name[RADIUS_INDEX_NAME_SZ];
+    FILE * fp;
+
+    test_user_name(name, sizeof(name), i);
+
+    mkdir(RADIUS_ATTRIBUTE_CACHE_DIR, 0755);
+    snprintf(path, sizeof(path), "%s/%s", RADIUS_ATTRIBUTE_CACHE_DIR, name);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s/%s", RADIUS_ATTRIBUTE_CACHE_DIR, name,
+        RADIUS_ATTR_MPL);
+
+    if ((fp = fopen(path, "w")) != NULL) {
+        fprintf(fp, "%d\n", mpl);
+        fclose(fp);
+    }
+}
+
+static void fill_entries(RADIUS_INDEX_ENTRY * entries, int count, int round) {
+    int i;
+
+    memset((char *) entries, 0, count * sizeof(*entries));
+    for (i = 0; i < count; i++) {
+        test_user_name(entries[i].name, sizeof(entries[i].name), i);
+        entries[i].mpl = (round % RADIUS_MAX_MPL) + 1;
+        entries[i].gid = entries[i].mpl;
+        entries[i].uid = round;
+    }
+}
+
+static double elapsed_nsec(struct timespec * start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+static void test_lookup(void) {
+    RADIUS_INDEX_ENTRY entry;
+    char name[RADIUS_INDEX_NAME_SZ];
+    int i, mpl;
+
+    for (i = 0; i < TEST_USERS; i++)
+        write_user_cache(i, (i % RADIUS_MAX_MPL) + 1);
+
+    CHECK(radius_update_index(prog) == 0, "update index");
+
+    for (i = 0; i < TEST_USERS; i++) {
+        test_user_name(name, sizeof(name), i);
+        CHECK(radius_lookup_index(prog, name, &entry) == 0, "lookup %s", name);
+        CHECK(entry.mpl == (i % RADIUS_MAX_MPL) + 1, "%s mpl %d", name,
+            entry.mpl);
+        CHECK(radius_lookup_cache(prog, name, &mpl) == 0, "cache %s", name);
+        CHECK(mpl == (i % RADIUS_MAX_MPL) + 1, "%s cache mpl %d", name, mpl);
+    }
+
+    CHECK(radius_lookup_index(prog, "unknown", &entry) == STATUS_ENOENT,
+        "lookup unknown");
+    CHECK(radius_lookup_cache(prog, "unknown", &mpl) != 0, "cache unknown");
+}
+
+static void test_torn_write(void) {
+    RADIUS_INDEX_ENTRY entry;
+    RADIUS_INDEX_HDR * hdr;
+    RADIUS_INDEX_ENTRY * entries;
+    char name[RADIUS_INDEX_NAME_SZ];
+    int fd, mpl;
+    uint32_t gen;
+
+    CHECK(radius_update_index(prog) == 0, "update index");
+    test_user_name(name, sizeof(name), 1);
+
+    fd = open(RADIUS_INDEX_FILE, O_RDWR);
+    hdr = mmap(NULL, RADIUS_INDEX_FILE_SZ, PROT_READ|PROT_WRITE, MAP_SHARED,
+        fd, 0);
+    close(fd);
+    CHECK(hdr != MAP_FAILED, "mmap");
+    if (hdr == MAP_FAILED)
+        return;
+    entries = (RADIUS_INDEX_ENTRY *) (hdr + 1);
+
+    /* Writer died in the middle of an update.
+     */
+    gen = hdr->gen;
+    hdr->gen = gen | 1;
+    memset((char *) entries, 0xff, sizeof(*entries) * TEST_USERS / 2);
+
+    CHECK(radius_lookup_index(prog, name, &entry) == STATUS_EIO,
+        "odd gen not detected");
+    CHECK(radius_lookup_cache(prog, name, &mpl) == 0 && mpl == 2,
+        "no fallback on odd gen, mpl %d", mpl);
+
+    /* Content corrupted without the writer protocol.
+     */
+    CHECK(radius_update_index(prog) == 0, "update index");
+    entries[1].mpl = 7;
+
+    CHECK(radius_lookup_index(prog, name, &entry) == STATUS_EIO,
+        "bad entry checksum not detected");
+    CHECK(radius_lookup_cache(prog, name, &mpl) == 0 && mpl == 2,
+        "no fallback on bad entry, mpl %d", mpl);
+
+    hdr->count = RADIUS_INDEX_MAX_USERS + 1;
+    CHECK(radius_lookup_index(prog, name, &entry) == STATUS_EIO,
+        "bad header not detected");
+
+    /* Next update repairs the index.
+     */
+    CHECK(radius_update_index(prog) == 0, "update index");
+    CHECK(radius_lookup_index(prog, name, &entry) == 0 && entry.mpl == 2,
+        "not repaired");
+
+    munmap(hdr, RADIUS_INDEX_FILE_SZ);
+}
+
+static void remove_user_cache(int i) {
+    char path[PATH_MAX];
+    char name[RADIUS_INDEX_NAME_SZ];
+
+    test_user_name(name, sizeof(name), i);
+
+    snprintf(path, sizeof(path), "%s/%s/%s", RADIUS_ATTRIBUTE_CACHE_DIR, name,
+        RADIUS_ATTR_MPL);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s", RADIUS_ATTRIBUTE_CACHE_DIR, name);
+    rmdir(path);
+}
+
+static void test_update_user(void) {
+    RADIUS_INDEX_ENTRY entry;
+    RADIUS_INDEX_HDR * hdr;
+    char name[RADIUS_INDEX_NAME_SZ];
+    char new_name[RADIUS_INDEX_NAME_SZ];
+    FILE * fp;
+    int fd, i;
+
+    mkdir("etc", 0755);
+    if ((fp = fopen(ETC_PASSWD, "w")) == NULL) {
+        CHECK(0, "fopen(%s)", ETC_PASSWD);
+        return;
+    }
+    for (i = 0; i <= TEST_USERS; i += 2) {
+        test_user_name(name, sizeof(name), i);
+        fprintf(fp, "%s:x:%d:%d:User %d:/home/%s:/bin/bash\n", name,
+            2000 + i, 100 + i, i, name);
+    }
+    fclose(fp);
+
+    /* Full rebuild, passwd fields filled in one pass.
+     */
+    CHECK(radius_update_index(prog) == 0, "update index");
+    test_user_name(name, sizeof(name), 4);
+    CHECK(   (radius_lookup_index(prog, name, &entry) == 0)
+          && (entry.uid == 2004) && (entry.gid == 104)
+          && (strcmp(entry.gecos, "User 4") == 0),
+        "%s passwd fields uid %u gecos \"%s\"", name, entry.uid, entry.gecos);
+    test_user_name(name, sizeof(name), 5);
+    CHECK(   (radius_lookup_index(prog, name, &entry) == 0)
+          && (entry.uid == (uint32_t) -1),
+        "%s not in passwd, uid %u", name, entry.uid);
+
+    /* Add, change and remove one user.
+     */
+    test_user_name(new_name, sizeof(new_name), TEST_USERS);
+    write_user_cache(TEST_USERS, 3);
+    CHECK(radius_update_index_user(prog, new_name) == 0, "add %s", new_name);
+    CHECK(   (radius_lookup_index(prog, new_name, &entry) == 0)
+          && (entry.mpl == 3) && (entry.uid == 2000 + TEST_USERS),
+        "%s not added", new_name);
+
+    test_user_name(name, sizeof(name), 4);
+    write_user_cache(4, 9);
+    CHECK(radius_update_index_user(prog, name) == 0, "change %s", name);
+    CHECK(   (radius_lookup_index(prog, name, &entry) == 0)
+          && (entry.mpl == 9) && (entry.uid == 2004),
+        "%s not changed, mpl %d", name, entry.mpl);
+
+    remove_user_cache(TEST_USERS);
+    CHECK(radius_update_index_user(prog, new_name) == 0, "remove %s",
+        new_name);
+    CHECK(radius_lookup_index(prog, new_name, &entry) == STATUS_ENOENT,
+        "%s not removed", new_name);
+
+    for (i = 0; i < TEST_USERS; i++) {
+        test_user_name(name, sizeof(name), i);
+        CHECK(radius_lookup_index(prog, name, &entry) == 0, "lost %s", name);
+    }
+
+    /* An invalid index is rebuilt rather than patched.
+     */
+    fd = open(RADIUS_INDEX_FILE, O_RDWR);
+    hdr = mmap(NULL, RADIUS_INDEX_FILE_SZ, PROT_READ|PROT_WRITE, MAP_SHARED,
+        fd, 0);
+    close(fd);
+    CHECK(hdr != MAP_FAILED, "mmap");
+    if (hdr != MAP_FAILED) {
+        hdr->count = RADIUS_INDEX_MAX_USERS + 1;
+        munmap(hdr, RADIUS_INDEX_FILE_SZ);
+    }
+
+    write_user_cache(4, 5);
+    test_user_name(name, sizeof(name), 4);
+    CHECK(radius_update_index_user(prog, name) == 0, "update %s", name);
+    CHECK(   (radius_lookup_index(prog, name, &entry) == 0)
+          && (entry.mpl == 5),
+        "%s not rebuilt, mpl %d", name, entry.mpl);
+    test_user_name(name, sizeof(name), 1);
+    CHECK(radius_lookup_index(prog, name, &entry) == 0, "lost %s", name);
+
+    unlink(ETC_PASSWD);
+    rmdir("etc");
+}
+
+struct stress_result {
+    long ok;
+    long fallback;
+    long mismatch;
+};
+
+static void * stress_reader(void * arg) {
+    struct stress_result * res = arg;
+    RADIUS_INDEX_ENTRY entry;
+    char name[RADIUS_INDEX_NAME_SZ];
+    int i;
+
+    for (i = 0; i < STRESS_ROUNDS * 4; i++) {
+        test_user_name(name, sizeof(name), i % TEST_USERS);
+        if (radius_lookup_index(prog, name, &entry) != 0) {
+            res->fallback++;
+        } else if (   ((uint32_t) entry.mpl != entry.gid)
+                   || (strcmp(entry.name, name) != 0)) {
+            res->mismatch++;
+        } else {
+            res->ok++;
+        }
+    }
+
+    return NULL;
+}
+
+static void test_stress(void) {
+    RADIUS_INDEX_ENTRY entries[TEST_USERS];
+    struct stress_result res[STRESS_READERS];
+    pthread_t readers[STRESS_READERS];
+    pid_t pid;
+    int i, wstatus;
+    long ok = 0, fallback = 0, mismatch = 0;
+
+    fill_entries(entries, TEST_USERS, 0);
+    CHECK(radius_write_index(prog, entries, TEST_USERS) == 0, "write index");
+
+    if ((pid = fork()) == 0) {
+        for (i = 1; i <= STRESS_ROUNDS; i++) {
+            fill_entries(entries, TEST_USERS, i);
+            radius_write_index(prog, entries, TEST_USERS);
+        }
+        exit(0);
+    }
+
+    memset((char *) res, 0, sizeof(res));
+    for (i = 0; i < STRESS_READERS; i++)
+        pthread_create(&(readers[i]), NULL, stress_reader, &(res[i]));
+
+    for (i = 0; i < STRESS_READERS; i++) {
+        pthread_join(readers[i], NULL);
+        ok += res[i].ok;
+        fallback += res[i].fallback;
+        mismatch += res[i].mismatch;
+    }
+
+    waitpid(pid, &wstatus, 0);
+
+    printf("stress: %d writes, %ld consistent reads, %ld fallbacks, "
+        "%ld torn reads\n", STRESS_ROUNDS, ok, fallback, mismatch);
+
+    CHECK(mismatch == 0, "%ld torn reads", mismatch);
+    CHECK(ok > 0, "no successful reads");
+}
+
+static void test_benchmark(void) {
+    struct timespec start;
+    char name[RADIUS_INDEX_NAME_SZ];
+    double index_nsec, file_nsec;
+    int i, mpl;
+
+    CHECK(radius_update_index(prog) == 0, "update index");
+    test_user_name(name, sizeof(name), TEST_USERS / 2);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_LOOKUPS; i++)
+        radius_lookup_cache(prog, name, &mpl);
+    index_nsec = elapsed_nsec(&start) / BENCH_LOOKUPS;
+
+    /* Without the index, per-user files are used.
+     */
+    unlink(RADIUS_INDEX_FILE);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_LOOKUPS; i++)
+        radius_lookup_cache(prog, name, &mpl);
+    file_nsec = elapsed_nsec(&start) / BENCH_LOOKUPS;
+
+    printf("benchmark: %d users, index %.0f ns/lookup, "
+        "per-user file %.0f ns/lookup\n", TEST_USERS, index_nsec, file_nsec);
+}
+
+int main(int ac, char * av[]) {
+
+    /* Per-user file fallbacks are logged on every lookup.
+     */
+    if (freopen("/dev/null", "w", stderr) == NULL)
+        perror("freopen");
+
+    unlink(RADIUS_INDEX_FILE);
+
+    test_lookup();
+    test_torn_write();
+    test_update_user();
+    test_stress();
+    test_benchmark();
+
+    printf("%s: %s\n", prog, failures ? "FAILED" : "PASSED");
+
+    return failures ? 1 : 0;
+}
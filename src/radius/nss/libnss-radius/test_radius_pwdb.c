@@ -0,0 +1,330 @@
+/*
+Copyright 2020 Broadcom. All rights reserved.
+The term "Broadcom" refers to Broadcom Inc. and/or its subsidiaries.
+*/
+
+/*
+ * Test code for radius_pwdb: passwd/shadow/group/gshadow editing in a dry
+ * run root directory, never touching the host files.
+ */
+
+#include <time.h>
+
+#include "nss_radius_common.h"
+#include "radius_pwdb.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            failures++;                                         \
+            printf("FAIL %s:%d: ", __FUNCTION__, __LINE__);     \
+            printf(__VA_ARGS__);                                \
+            printf("\n");                                       \
+        }                                                       \
+    } while (0)
+
+static char * prog = "test_radius_pwdb";
+static char root[PATH_MAX];
+
+static void write_file_mode(const char * rel, const char * content,
+    const char * mode) {
+    char path[PATH_MAX];
+    FILE * fp;
+
+    snprintf(path, sizeof(path), "%s%s", root, rel);
+    if ((fp = fopen(path, mode)) != NULL) {
+        fputs(content, fp);
+        fclose(fp);
+    }
+}
+
+static void write_file(const char * rel, const char * content) {
+    write_file_mode(rel, content, "w");
+}
+
+static void append_file(const char * rel, const char * content) {
+    write_file_mode(rel, content, "a");
+}
+
+  /* 1 if rel has a line starting with prefix, of any length.
+   */
+static int has_line(const char * rel, const char * prefix) {
+    char path[PATH_MAX];
+    char * line = NULL;
+    size_t len = 0;
+    FILE * fp;
+    int found = 0;
+
+    snprintf(path, sizeof(path), "%s%s", root, rel);
+    if ((fp = fopen(path, "r")) == NULL)
+        return 0;
+
+    while (!found && (getline(&line, &len, fp) != -1))
+        found = (strncmp(line, prefix, strlen(prefix)) == 0);
+
+    free(line);
+    fclose(fp);
+
+    return found;
+}
+
+static int exists(const char * rel) {
+    char path[PATH_MAX];
+    struct stat sb;
+
+    snprintf(path, sizeof(path), "%s%s", root, rel);
+    return stat(path, &sb) == 0;
+}
+
+static void setup_root(void) {
+    char path[PATH_MAX + 16];
+
+    snprintf(root, sizeof(root), "/tmp/test_radius_pwdb.XXXXXX");
+    if (mkdtemp(root) == NULL) {
+        perror("mkdtemp");
+        exit(1);
+    }
+
+    snprintf(path, sizeof(path), "%s/etc", root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/etc/skel", root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/home", root);
+    mkdir(path, 0755);
+
+    write_file("/etc/passwd",
+        "root:x:0:0:root:/root:/bin/bash\n"
+        "admin:x:1000:1000:root&:/home/admin:/bin/bash\n");
+    write_file("/etc/shadow",
+        "root:*:18000:0:99999:7:::\n"
+        "admin:*:18000:0:99999:7:::\n");
+    write_file("/etc/group",
+        "root:x:0:\n"
+        "sudo:x:27:admin\n"
+        "docker:x:999:admin\n"
+        "admin:x:1000:\n");
+    write_file("/etc/gshadow",
+        "root:*::\n"
+        "sudo:*::admin\n"
+        "docker:!::admin\n"
+        "admin:!::\n");
+    write_file("/etc/login.defs",
+        "# test\n"
+        "UID_MIN 1000\n"
+        "UID_MAX 60000\n"
+        "GID_MIN 1000\n"
+        "GID_MAX 60000\n");
+    write_file("/etc/skel/.bashrc", "# bashrc\n");
+}
+
+static void test_add(void) {
+    RADIUS_PWDB db;
+
+    radius_pwdb_init(&db, prog, root);
+
+    /* Unconfirmed user, as useradd -U, and many_to_one user, as
+     * useradd -g, applied in one batch.
+     */
+    CHECK(radius_pwdb_add_user(&db, "alice", RADIUS_PWDB_USER_GROUP,
+        "docker", "Unconfirmed-1", "/home/alice", "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_add_user(&db, "remote_user_su", 1000, "admin,sudo",
+        "remote_user_su", NULL, "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_commit(&db) == 0, "commit");
+
+    CHECK(has_line("/etc/passwd", "alice:x:1001:1001:Unconfirmed-1:"
+        "/home/alice:/bin/bash"), "alice passwd");
+    CHECK(has_line("/etc/group", "alice:x:1001:"), "alice group");
+    CHECK(has_line("/etc/gshadow", "alice:!::"), "alice gshadow");
+    CHECK(has_line("/etc/shadow", "alice:!:"), "alice shadow");
+    CHECK(has_line("/etc/group", "docker:x:999:admin,alice"), "docker member");
+    CHECK(has_line("/etc/gshadow", "docker:!::admin,alice"),
+        "docker gshadow member");
+    CHECK(exists("/home/alice/.bashrc"), "alice skel");
+
+    CHECK(has_line("/etc/passwd", "remote_user_su:x:1002:1000:remote_user_su:"
+        "/home/remote_user_su:/bin/bash"), "remote_user_su passwd");
+    CHECK(!has_line("/etc/group", "remote_user_su:"), "no user group");
+    CHECK(has_line("/etc/group", "sudo:x:27:admin,remote_user_su"),
+        "sudo member");
+    CHECK(has_line("/etc/group", "admin:x:1000:remote_user_su"),
+        "admin member");
+
+    radius_pwdb_free(&db);
+}
+
+static void test_mod(void) {
+    RADIUS_PWDB db;
+
+    radius_pwdb_init(&db, prog, root);
+
+    /* Confirm alice, as usermod -G sudo -c alice alice.
+     */
+    CHECK(radius_pwdb_mod_user(&db, "alice", "sudo", "alice") == 0, "queue");
+    CHECK(radius_pwdb_commit(&db) == 0, "commit");
+
+    CHECK(has_line("/etc/passwd", "alice:x:1001:1001:alice:"), "alice gecos");
+    CHECK(has_line("/etc/group", "docker:x:999:admin\n"), "docker removed");
+    CHECK(has_line("/etc/group", "sudo:x:27:admin,remote_user_su,alice"),
+        "sudo added");
+    CHECK(has_line("/etc/gshadow", "sudo:*::admin,remote_user_su,alice"),
+        "sudo gshadow added");
+
+    radius_pwdb_free(&db);
+}
+
+static void test_errors(void) {
+    RADIUS_PWDB db;
+
+    radius_pwdb_init(&db, prog, root);
+
+    CHECK(radius_pwdb_add_user(&db, "bad:name", RADIUS_PWDB_USER_GROUP,
+        "", "", NULL, "/bin/bash") != 0, "bad name queued");
+    CHECK(radius_pwdb_add_user(&db, "alice", RADIUS_PWDB_USER_GROUP,
+        "", "", NULL, "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_add_user(&db, "bob", RADIUS_PWDB_USER_GROUP,
+        "nosuchgroup", "", NULL, "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_add_user(&db, "carol", RADIUS_PWDB_USER_GROUP,
+        "docker", "Unconfirmed-1", NULL, "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_mod_user(&db, "nobody", "", NULL) == 0, "queue");
+
+    /* Failed operations are skipped, the others applied.
+     */
+    CHECK(radius_pwdb_commit(&db) == STATUS_EPERM, "commit status");
+    CHECK(db.ops[0].status == STATUS_EPERM, "alice exists");
+    CHECK(db.ops[1].status == STATUS_ENOENT, "bob group");
+    CHECK(db.ops[2].status == 0, "carol");
+    CHECK(db.ops[3].status == STATUS_ENOENT, "nobody");
+
+    CHECK(!has_line("/etc/passwd", "bob:"), "bob added");
+    CHECK(has_line("/etc/passwd", "carol:x:1003:1003:"), "carol not added");
+
+    radius_pwdb_free(&db);
+}
+
+static void test_del(void) {
+    RADIUS_PWDB db;
+
+    radius_pwdb_init(&db, prog, root);
+
+    /* As userdel -r, in one batch.
+     */
+    CHECK(radius_pwdb_del_user(&db, "alice") == 0, "queue");
+    CHECK(radius_pwdb_del_user(&db, "carol") == 0, "queue");
+    CHECK(radius_pwdb_commit(&db) == 0, "commit");
+
+    CHECK(!has_line("/etc/passwd", "alice:"), "alice passwd");
+    CHECK(!has_line("/etc/shadow", "alice:"), "alice shadow");
+    CHECK(!has_line("/etc/group", "alice:"), "alice group");
+    CHECK(!has_line("/etc/gshadow", "alice:"), "alice gshadow");
+    CHECK(has_line("/etc/group", "sudo:x:27:admin,remote_user_su\n"),
+        "alice member");
+    CHECK(!exists("/home/alice"), "alice home");
+    CHECK(!has_line("/etc/passwd", "carol:"), "carol passwd");
+    CHECK(has_line("/etc/group", "docker:x:999:admin\n"), "carol member");
+    CHECK(has_line("/etc/passwd", "admin:x:1000:1000:"), "admin removed");
+    CHECK(!exists("/etc/passwd+"), "temporary file left");
+
+    radius_pwdb_free(&db);
+}
+
+static void test_long_members(void) {
+    RADIUS_PWDB db;
+    char * line, * expected;
+    size_t len = 0;
+    int i;
+
+    /* A member list longer than BUFLEN is updated, not truncated.
+     */
+    line = malloc(BUFLEN * 2);
+    expected = malloc(BUFLEN * 2 + 16);
+    if (!line || !expected) {
+        CHECK(0, "malloc");
+        free(line);
+        free(expected);
+        return;
+    }
+
+    len = snprintf(line, BUFLEN * 2, "biggroup:x:2000:");
+    for (i = 0; i < 400; i++)
+        len += snprintf(line + len, BUFLEN * 2 - len, "%slongmember%03d",
+            i ? "," : "", i);
+    CHECK(len > BUFLEN, "member list only %zu bytes", len);
+    snprintf(line + len, BUFLEN * 2 - len, "\n");
+    append_file("/etc/group", line);
+    line[len] = 0;
+
+    radius_pwdb_init(&db, prog, root);
+    CHECK(radius_pwdb_add_user(&db, "dave", RADIUS_PWDB_USER_GROUP,
+        "biggroup", "dave", NULL, "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_commit(&db) == 0, "commit");
+    radius_pwdb_free(&db);
+
+    snprintf(expected, BUFLEN * 2 + 16, "%s,dave\n", line);
+    CHECK(has_line("/etc/group", expected), "dave not appended");
+
+    radius_pwdb_init(&db, prog, root);
+    CHECK(radius_pwdb_del_user(&db, "dave") == 0, "queue");
+    CHECK(radius_pwdb_commit(&db) == 0, "commit");
+    radius_pwdb_free(&db);
+
+    snprintf(expected, BUFLEN * 2 + 16, "%s\n", line);
+    CHECK(has_line("/etc/group", expected), "dave not removed");
+
+    free(line);
+    free(expected);
+}
+
+static void test_write_failure(void) {
+    RADIUS_PWDB db;
+    char path[PATH_MAX + 16];
+
+    /* passwd+ can't be created: the group written before it must not
+     * be renamed either.
+     */
+    snprintf(path, sizeof(path), "%s/etc/passwd+", root);
+    mkdir(path, 0755);
+
+    radius_pwdb_init(&db, prog, root);
+    CHECK(radius_pwdb_add_user(&db, "erin", RADIUS_PWDB_USER_GROUP,
+        "sudo", "erin", NULL, "/bin/bash") == 0, "queue");
+    CHECK(radius_pwdb_commit(&db) == STATUS_EIO, "commit status");
+    CHECK(db.ops[0].status == STATUS_EIO, "erin status");
+    radius_pwdb_free(&db);
+
+    CHECK(!has_line("/etc/group", "erin:"), "erin group committed");
+    CHECK(has_line("/etc/group", "sudo:x:27:admin,remote_user_su\n"),
+        "erin member committed");
+    CHECK(!has_line("/etc/passwd", "erin:"), "erin passwd");
+    CHECK(!exists("/etc/group+"), "temporary file left");
+    CHECK(!exists("/home/erin"), "erin home");
+
+    rmdir(path);
+}
+
+int main(int ac, char * av[]) {
+    struct stat before, after;
+    char cmd[PATH_MAX + 16];
+
+    stat("/etc/passwd", &before);
+
+    setup_root();
+
+    test_add();
+    test_mod();
+    test_errors();
+    test_del();
+    test_long_members();
+    test_write_failure();
+
+    stat("/etc/passwd", &after);
+    CHECK(before.st_mtime == after.st_mtime, "host /etc/passwd modified");
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+    if (system(cmd) != 0)
+        printf("%s not removed\n", root);
+
+    printf("%s: %s\n", prog, failures ? "FAILED" : "PASSED");
+
+    return failures ? 1 : 0;
+}
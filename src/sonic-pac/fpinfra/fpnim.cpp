@@ -227,20 +227,28 @@ void* fpinfraTask(void * nimPtr) {
         //register for the table events
         NetLink netlink;
         netlink.registerGroup(RTNLGRP_LINK);
-        netlink.dumpRequest(RTM_GETLINK);
         cout << "Listen to Netlink messages..." << endl;
         NetDispatcher::getInstance().registerMessageHandler(RTM_NEWLINK, (swss::NetMsg*)&sync);
         NetDispatcher::getInstance().registerMessageHandler(RTM_DELLINK, (swss::NetMsg*)&sync);
 
+        /* Changes racing with the bulk dump are queued on the group
+         * socket and applied afterwards.
+         */
+        if (!sync.bulkSync())
+        {
+            netlink.dumpRequest(RTM_GETLINK);
+        }
+
         swss::Select s;
         s.addSelectable(&netlink);
 
         //wait for the events and process them
         while (true)
         {
-            SWSS_LOG_NOTICE("Waiting for Netlink Events");
+            SWSS_LOG_INFO("Waiting for Netlink Events");
             swss::Selectable *sel = NULL;
-            s.select(&sel);
+            s.select(&sel, sync.getFlushTimeout());
+            sync.flushPending();
         }
     } catch (const exception &e) {
         SWSS_LOG_ERROR("Run-Time error: %s", e.what());
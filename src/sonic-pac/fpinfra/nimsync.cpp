@@ -26,6 +26,7 @@
 #include <swss/dbconnector.h>
 #include <swss/producerstatetable.h>
 #include <netlink/route/link.h>
+#include <netlink/cache.h>
 #include <swss/netmsg.h>
 
 extern "C" {
@@ -40,6 +41,9 @@ using namespace swss;
 
 #define TEAM_DRV_NAME   "team"
 
+/* Attempts of the initial link dump when interrupted by link changes */
+#define NIM_DUMP_RETRIES    3
+
 static int hex2num(char c)
 {
 	if (c >= '0' && c <= '9')
@@ -78,16 +82,29 @@ int macstr_to_mac(const char *macstr, unsigned char *addr)
 NimPort::NimPort(){
     m_adminState = 0;
     m_operState = 0;
+    m_ifIndex = 0;
+    m_intIfNum = 0;
+    m_port = 0;
+    m_reportedOperState = 0;
+    m_operPending = false;
 }
 
 NimPort::NimPort(const int &admin, const int &oper) :
 m_adminState(admin),
-m_operState(oper){ }
+m_operState(oper),
+m_ifIndex(0),
+m_intIfNum(0),
+m_port(0),
+m_reportedOperState(oper),
+m_operPending(false){ }
 
 
 
 
-NimSync::NimSync() {}
+NimSync::NimSync(unsigned int flapWindowMsec) :
+m_flapWindowMsec(flapWindowMsec),
+m_pendingCount(0),
+m_bulkSync(false){ }
 
 NimPort& NimSync::getPort(const string & alias)
 {
@@ -101,7 +118,202 @@ void NimSync::setPort(const string & alias, const NimPort& port)
 
 void NimSync::delPort(const string & alias)
 {
-    m_portList.erase(alias);
+    auto it = m_portList.find(alias);
+    if (it == m_portList.end())
+    {
+        return;
+    }
+
+    if (it->second.m_operPending)
+    {
+        m_pendingCount--;
+    }
+    if (getPortByIfIndex(it->second.m_ifIndex) == &it->second)
+    {
+        m_ifIndexList[it->second.m_ifIndex] = NULL;
+    }
+    m_portList.erase(it);
+}
+
+NimPort *NimSync::getPortByIfIndex(unsigned int ifindex)
+{
+    if ((ifindex == 0) || (ifindex >= m_ifIndexList.size()))
+    {
+        return NULL;
+    }
+    return m_ifIndexList[ifindex];
+}
+
+void NimSync::setIfIndex(unsigned int ifindex, NimPort *port)
+{
+    if ((ifindex == 0) || (ifindex >= NIM_MAX_IFINDEX))
+    {
+        return;
+    }
+
+    /* A new ifindex may be reused from a port deleted behind our back */
+    if (getPortByIfIndex(port->m_ifIndex) == port)
+    {
+        m_ifIndexList[port->m_ifIndex] = NULL;
+    }
+    if (ifindex >= m_ifIndexList.size())
+    {
+        m_ifIndexList.resize(ifindex + 1, NULL);
+    }
+    m_ifIndexList[ifindex] = port;
+    port->m_ifIndex = ifindex;
+}
+
+void NimSync::notifyOperState(const string & alias, NimPort & port)
+{
+    nimUSP_t usp;
+    usp.unit = 1;
+    usp.slot = 0;
+    usp.port = port.m_port;
+
+    SWSS_LOG_INFO("Notify %s oper state %s", alias.c_str(), port.m_operState? "up": "down");
+    port.m_reportedOperState = port.m_operState;
+    nimDtlIntfChangeCallback(&usp, port.m_operState? UP: DOWN, NULL);
+}
+
+void NimSync::updatePort(const string & alias, NimPort & port, int admin, int oper)
+{
+    /* Set the admin state first*/
+    if (admin != port.m_adminState)
+    {
+        port.m_adminState = admin;
+        nimSetIntfAdminState(port.m_intIfNum, admin? ENABLE: DISABLE);
+    }
+
+    /* followed by the oper state */
+    if (oper == port.m_operState)
+    {
+        return;
+    }
+    port.m_operState = oper;
+
+    if (m_bulkSync || (m_flapWindowMsec == 0))
+    {
+        notifyOperState(alias, port);
+    }
+    else if (!port.m_operPending)
+    {
+        /* Notified from flushPending() with the state at the end of the window */
+        port.m_operPending = true;
+        port.m_operDeadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(m_flapWindowMsec);
+        m_pendingCount++;
+    }
+}
+
+void NimSync::flushPending()
+{
+    if (m_pendingCount == 0)
+    {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto &it : m_portList)
+    {
+        NimPort &port = it.second;
+        if (!port.m_operPending || (port.m_operDeadline > now))
+        {
+            continue;
+        }
+
+        port.m_operPending = false;
+        m_pendingCount--;
+        if (port.m_operState != port.m_reportedOperState)
+        {
+            notifyOperState(it.first, port);
+        }
+        else
+        {
+            SWSS_LOG_NOTICE("Coalesced oper state flap on %s", it.first.c_str());
+        }
+    }
+}
+
+int NimSync::getFlushTimeout()
+{
+    if (m_pendingCount == 0)
+    {
+        return -1;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+    for (auto &it : m_portList)
+    {
+        if (it.second.m_operPending && (it.second.m_operDeadline < next))
+        {
+            next = it.second.m_operDeadline;
+        }
+    }
+
+    if (next <= now)
+    {
+        return 0;
+    }
+    /* Round up so the window has expired when select() times out */
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                 next - now + std::chrono::microseconds(999)).count();
+}
+
+bool NimSync::bulkSync()
+{
+    struct nl_sock *sock;
+    struct nl_cache *cache = NULL;
+    struct nl_object *obj;
+    int err = 0;
+
+    sock = nl_socket_alloc();
+    if (sock == NULL)
+    {
+        SWSS_LOG_ERROR("Failed to allocate netlink socket for link dump");
+        return false;
+    }
+
+    if ((err = nl_connect(sock, NETLINK_ROUTE)) < 0)
+    {
+        SWSS_LOG_ERROR("Failed to connect netlink socket for link dump: %s", nl_geterror(err));
+        nl_socket_free(sock);
+        return false;
+    }
+
+    for (int retry = 0; retry < NIM_DUMP_RETRIES; retry++)
+    {
+        err = rtnl_link_alloc_cache(sock, AF_UNSPEC, &cache);
+        if (err != -NLE_DUMP_INTR)
+        {
+            break;
+        }
+        SWSS_LOG_NOTICE("Netlink dump failed with NLE_DUMP_INTR, resending dump request");
+    }
+
+    if (err < 0)
+    {
+        SWSS_LOG_ERROR("Failed to dump links: %s", nl_geterror(err));
+        nl_socket_free(sock);
+        return false;
+    }
+
+    /* All ports are created and their states notified without waiting for
+     * the coalescing window, so applications see the full port set at once.
+     */
+    m_bulkSync = true;
+    for (obj = nl_cache_get_first(cache); obj != NULL; obj = nl_cache_get_next(obj))
+    {
+        onMsg(RTM_NEWLINK, obj);
+    }
+    m_bulkSync = false;
+
+    SWSS_LOG_NOTICE("Bulk sync of %d links done", nl_cache_nitems(cache));
+
+    nl_cache_free(cache);
+    nl_socket_free(sock);
+    return true;
 }
 
 void NimSync::onMsg(int nlmsg_type, struct nl_object *obj)
@@ -162,6 +374,17 @@ void NimSync::onMsg(int nlmsg_type, struct nl_object *obj)
         return;
     }
 
+    /* Known port, no need to resolve the alias and intIfNum again. The
+     * ifindex may have been reused by another netdev whose delete was missed.
+     */
+    NimPort *known = getPortByIfIndex(ifindex);
+    if ((nlmsg_type == RTM_NEWLINK) && (known != NULL) && (known->m_ifName == key))
+    {
+        updatePort(key, *known, admin, oper);
+        return;
+    }
+    string ifName = key;
+
     uint32 intIfNum;
     NIM_HANDLE_t handle;
 
@@ -201,6 +424,13 @@ void NimSync::onMsg(int nlmsg_type, struct nl_object *obj)
     /* New interface handling */
     if (m_portList.find(key) == m_portList.end())
     {
+        /* Delete of a port never created, do not create it just to delete it */
+        if (nlmsg_type == RTM_DELLINK)
+        {
+            SWSS_LOG_NOTICE("Unknown interface %s for Delete event ", key.c_str());
+            return;
+        }
+
         int port = 0;
         SYSAPI_HPC_PORT_DESCRIPTOR_t portData =
         {
@@ -262,12 +492,6 @@ void NimSync::onMsg(int nlmsg_type, struct nl_object *obj)
     /* Interface delete handling */
     if (nlmsg_type == RTM_DELLINK)
     {
-        if (m_portList.find(key) == m_portList.end())
-        {
-            SWSS_LOG_NOTICE("Unknown interface %s for Delete event ", key.c_str());
-            return;
-        }
-
         /* Generate Detach followed by Delete */
         eventInfo.event =  DETACH;
         eventInfo.intIfNum = intIfNum;
@@ -287,19 +511,13 @@ void NimSync::onMsg(int nlmsg_type, struct nl_object *obj)
         return;
     }
 
-    /* Set the admin state first*/
-    if (admin != m_portList[key].m_adminState)
-    {
-        m_portList[key].m_adminState = admin;
-        nimSetIntfAdminState(intIfNum, admin? ENABLE: DISABLE);
-    }
+    NimPort &port = m_portList[key];
+    port.m_ifName = ifName;
+    port.m_intIfNum = intIfNum;
+    port.m_port = usp.port;
+    setIfIndex(ifindex, &port);
 
-   /* followed by the oper state */
-   if ( oper != m_portList[key].m_operState)
-    {
-        m_portList[key].m_operState = oper;
-        nimDtlIntfChangeCallback(&usp, oper? UP: DOWN, NULL);
-    }
+    updatePort(key, port, admin, oper);
 }
 
 string NimSync::getStdIfFormat(string key)
@@ -18,6 +18,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <chrono>
 #include "dbconnector.h"
 #include "netmsg.h"
 #include "table.h"
@@ -28,6 +30,15 @@ const std::string MGMT_PREFIX = "eth";
 const std::string INTFS_PREFIX = "E";
 const std::string LAG_PREFIX = "PortChannel";
 
+/* Oper state changes of a port within this window are coalesced into one
+ * notification, a flap that returns to the reported state is not notified.
+ * 0 notifies every change immediately.
+ */
+#define NIM_FLAP_WINDOW_MSEC   100
+
+/* Kernel ifindex above which ports are only looked up by alias */
+#define NIM_MAX_IFINDEX        4096
+
 
 int macstr_to_mac(const char *macstr, unsigned char *addr);
 
@@ -37,20 +48,51 @@ public:
     NimPort(const int &admin, const int &oper);
     int m_adminState;
     int m_operState;
+
+    /* Resolved on first netlink message for the port */
+    std::string m_ifName;
+    unsigned int m_ifIndex;
+    unsigned int m_intIfNum;
+    int m_port;
+
+    /* Oper state last notified to NIM, and end of the coalescing window */
+    int m_reportedOperState;
+    bool m_operPending;
+    std::chrono::steady_clock::time_point m_operDeadline;
 };
 
 
 class NimSync : public NetMsg {
 public:
     enum { MAX_ADDR_SIZE = 64 };
-    NimSync();
+    NimSync(unsigned int flapWindowMsec = NIM_FLAP_WINDOW_MSEC);
     virtual void onMsg(int nlmsg_type, struct nl_object *obj);
     NimPort & getPort(const std::string & alias);
     void setPort(const std::string & alias, const NimPort & port);
     void delPort(const std::string & alias);
     std::string getStdIfFormat(std::string key);
+
+    /* Dump all links with one RTM_GETLINK request and apply them in one batch */
+    bool bulkSync();
+
+    /* Notify oper state changes whose coalescing window expired */
+    void flushPending();
+
+    /* Milliseconds until the next coalescing window expires, -1 if none */
+    int getFlushTimeout();
 private:
+    unsigned int m_flapWindowMsec;
+    unsigned int m_pendingCount;
+    bool m_bulkSync;
     std::map<std::string, NimPort> m_portList;
+
+    /* Ports indexed by kernel ifindex, entries point into m_portList */
+    std::vector<NimPort *> m_ifIndexList;
+
+    NimPort *getPortByIfIndex(unsigned int ifindex);
+    void setIfIndex(unsigned int ifindex, NimPort *port);
+    void updatePort(const std::string & alias, NimPort & port, int admin, int oper);
+    void notifyOperState(const std::string & alias, NimPort & port);
 };
 
 #endif
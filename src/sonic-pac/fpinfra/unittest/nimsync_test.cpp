@@ -0,0 +1,423 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* NimSync replay UT, netlink link messages are replayed into NimSync and
+ * the NIM calls they generate are recorded by stubs
+ */
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/if.h>
+#include <linux/rtnetlink.h>
+#include <netlink/cache.h>
+#include "nimsync.h"
+
+extern "C" {
+#include "pacinfra_common.h"
+#include "nim_events.h"
+#include "nimapi.h"
+}
+
+using namespace std;
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EVENTS(expected) \
+    do { \
+        string got = takeEvents(); \
+        if (got != (expected)) \
+        { \
+            fprintf(stderr, "%s:%d: events \"%s\", expected \"%s\"\n", __FUNCTION__, __LINE__, \
+                    got.c_str(), (expected)); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Coalescing window of the tests, long enough that a replay never crosses it by accident */
+#define TEST_FLAP_WINDOW_MSEC   50
+
+/* Recorded link, the layout libnl hides behind struct nl_object */
+struct nl_addr {
+    string mac;
+};
+
+struct nl_object {
+    string name;
+    unsigned int flags;
+    int ifindex;
+    nl_addr addr;
+    const char *type;
+    struct nl_cache *cache;
+    size_t pos;
+};
+
+struct rtnl_link {
+    nl_object obj;
+};
+
+struct nl_cache {
+    vector<rtnl_link> links;
+};
+
+/* NIM calls recorded by the stubs */
+static vector<string> events;
+
+/* intIfNum of created ports by USP port, intIfNum is port + 100 */
+static map<uint32, uint32> createdPorts;
+
+/* Link dump returned by the rtnl_link_alloc_cache stub */
+static nl_cache dumpCache;
+static int dumpIntrCount;
+
+static string takeEvents()
+{
+    string joined;
+    for (auto &e : events)
+    {
+        joined += (joined.empty() ? "" : ", ") + e;
+    }
+    events.clear();
+    return joined;
+}
+
+static rtnl_link makeLink(const string &name, int ifindex, bool admin, bool oper)
+{
+    rtnl_link link;
+    link.obj.name = name;
+    link.obj.flags = (admin ? IFF_UP : 0) | (oper ? IFF_LOWER_UP : 0);
+    link.obj.ifindex = ifindex;
+    link.obj.addr.mac = "00:11:22:33:44:55";
+    link.obj.type = NULL;
+    link.obj.cache = NULL;
+    link.obj.pos = 0;
+    return link;
+}
+
+static void replay(NimSync &sync, int nlmsgType, const string &name, int ifindex, bool admin, bool oper)
+{
+    rtnl_link link = makeLink(name, ifindex, admin, oper);
+    sync.onMsg(nlmsgType, &link.obj);
+}
+
+static void waitFlapWindow()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(TEST_FLAP_WINDOW_MSEC + 10));
+}
+
+static void reset()
+{
+    events.clear();
+    createdPorts.clear();
+    dumpCache.links.clear();
+    dumpIntrCount = 0;
+}
+
+/* libnl stubs */
+char *rtnl_link_get_name(struct rtnl_link *link) { return (char *)link->obj.name.c_str(); }
+unsigned int rtnl_link_get_flags(struct rtnl_link *link) { return link->obj.flags; }
+struct nl_addr *rtnl_link_get_addr(struct rtnl_link *link) { return &link->obj.addr; }
+int rtnl_link_get_ifindex(struct rtnl_link *link) { return link->obj.ifindex; }
+int rtnl_link_get_master(struct rtnl_link *link) { return 0; }
+char *rtnl_link_get_type(struct rtnl_link *link) { return (char *)link->obj.type; }
+
+char *nl_addr2str(const struct nl_addr *addr, char *buf, size_t size)
+{
+    snprintf(buf, size, "%s", addr->mac.c_str());
+    return buf;
+}
+
+struct nl_sock *nl_socket_alloc(void) { return (struct nl_sock *)&dumpCache; }
+void nl_socket_free(struct nl_sock *sk) { }
+int nl_connect(struct nl_sock *sk, int protocol) { return 0; }
+const char *nl_geterror(int error) { return "stub error"; }
+
+int rtnl_link_alloc_cache(struct nl_sock *sk, int family, struct nl_cache **result)
+{
+    if (dumpIntrCount > 0)
+    {
+        dumpIntrCount--;
+        return -NLE_DUMP_INTR;
+    }
+
+    for (size_t i = 0; i < dumpCache.links.size(); i++)
+    {
+        dumpCache.links[i].obj.cache = &dumpCache;
+        dumpCache.links[i].obj.pos = i;
+    }
+    *result = &dumpCache;
+    return 0;
+}
+
+struct nl_object *nl_cache_get_first(struct nl_cache *cache)
+{
+    return cache->links.empty() ? NULL : &cache->links[0].obj;
+}
+
+struct nl_object *nl_cache_get_next(struct nl_object *obj)
+{
+    size_t next = obj->pos + 1;
+    return next < obj->cache->links.size() ? &obj->cache->links[next].obj : NULL;
+}
+
+int nl_cache_nitems(struct nl_cache *cache) { return (int)cache->links.size(); }
+void nl_cache_free(struct nl_cache *cache) { }
+
+/* NIM stubs */
+extern "C" RC_t nimCmgrNewIntfChangeCallback(uint32 unit, uint32 slot, uint32 port, uint32 cardType,
+                                             PORT_EVENTS_t event, SYSAPI_HPC_PORT_DESCRIPTOR_t *portData,
+                                             enetMacAddr_t *macAddr)
+{
+    events.push_back("create " + to_string(port));
+    createdPorts[port] = port + 100;
+    return SUCCESS;
+}
+
+extern "C" RC_t nimGetIntIfNumFromUSP(nimUSP_t *usp, uint32 *intIfNum)
+{
+    auto it = createdPorts.find(usp->port);
+    if (it == createdPorts.end())
+    {
+        return FAILURE;
+    }
+    *intIfNum = it->second;
+    return SUCCESS;
+}
+
+extern "C" RC_t nimSetIntfifAlias(uint32 intIfNum, uchar8 *ifAlias)
+{
+    return SUCCESS;
+}
+
+extern "C" RC_t nimEventIntfNotify(NIM_EVENT_NOTIFY_INFO_t eventInfo, NIM_HANDLE_t *pHandle)
+{
+    const char *name = (eventInfo.event == ATTACH) ? "attach" :
+                       (eventInfo.event == DETACH) ? "detach" :
+                       (eventInfo.event == DELETE) ? "delete" : "unknown";
+    events.push_back(string(name) + " " + to_string(eventInfo.intIfNum));
+    if (eventInfo.event == DELETE)
+    {
+        createdPorts.erase(eventInfo.intIfNum - 100);
+    }
+    return SUCCESS;
+}
+
+extern "C" RC_t nimSetIntfAdminState(uint32 intIfNum, uint32 adminState)
+{
+    events.push_back("admin " + to_string(intIfNum) + (adminState == ENABLE ? " enable" : " disable"));
+    return SUCCESS;
+}
+
+extern "C" void nimDtlIntfChangeCallback(nimUSP_t *usp, uint32 event, void *dapiIntmgmt)
+{
+    events.push_back("oper " + to_string(usp->port) + (event == UP ? " up" : " down"));
+}
+
+/* Oper state changes within the window are notified once with the final state */
+static void testFlapCoalescing()
+{
+    NimSync sync(TEST_FLAP_WINDOW_MSEC);
+    reset();
+
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, false);
+    CHECK_EVENTS("create 1, attach 101, admin 101 enable");
+    CHECK(sync.getFlushTimeout() == -1);
+
+    /* up, down, up within the window: one up after it expires */
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, false);
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    CHECK_EVENTS("");
+    int timeout = sync.getFlushTimeout();
+    CHECK(timeout > 0 && timeout <= TEST_FLAP_WINDOW_MSEC);
+    sync.flushPending();
+    CHECK_EVENTS("");
+
+    waitFlapWindow();
+    CHECK(sync.getFlushTimeout() == 0);
+    sync.flushPending();
+    CHECK_EVENTS("oper 1 up");
+    CHECK(sync.getFlushTimeout() == -1);
+
+    /* down and back up within the window: flap never notified */
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, false);
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    waitFlapWindow();
+    sync.flushPending();
+    CHECK_EVENTS("");
+    CHECK(sync.getFlushTimeout() == -1);
+
+    /* admin state is not coalesced, and windows of ports are independent */
+    replay(sync, RTM_NEWLINK, "Ethernet4", 11, false, false);
+    CHECK_EVENTS("create 5, attach 105");
+    replay(sync, RTM_NEWLINK, "Ethernet4", 11, true, true);
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, false);
+    CHECK_EVENTS("admin 105 enable");
+    waitFlapWindow();
+    sync.flushPending();
+    CHECK_EVENTS("oper 1 down, oper 5 up");
+
+    /* window 0 notifies every change */
+    NimSync immediate(0);
+    reset();
+    replay(immediate, RTM_NEWLINK, "Ethernet8", 12, true, true);
+    replay(immediate, RTM_NEWLINK, "Ethernet8", 12, true, false);
+    CHECK_EVENTS("create 9, attach 109, admin 109 enable, oper 9 up, oper 9 down");
+    CHECK(immediate.getFlushTimeout() == -1);
+}
+
+/* An ifindex reused by a new netdev after a missed delete is not taken for the old port */
+static void testIfIndexReuse()
+{
+    NimSync sync(0);
+    reset();
+
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    CHECK_EVENTS("create 1, attach 101, admin 101 enable, oper 1 up");
+
+    /* Ethernet0 deleted, its DELLINK missed, Ethernet8 created with its ifindex */
+    replay(sync, RTM_NEWLINK, "Ethernet8", 10, true, false);
+    CHECK_EVENTS("create 9, attach 109, admin 109 enable");
+
+    /* ifindex 10 now resolves to Ethernet8 through the fast path */
+    replay(sync, RTM_NEWLINK, "Ethernet8", 10, true, true);
+    CHECK_EVENTS("oper 9 up");
+
+    /* late DELLINK of Ethernet0 leaves the ifindex of Ethernet8 alone */
+    replay(sync, RTM_DELLINK, "Ethernet0", 10, false, false);
+    CHECK_EVENTS("detach 101, delete 101");
+    replay(sync, RTM_NEWLINK, "Ethernet8", 10, true, false);
+    CHECK_EVENTS("oper 9 down");
+
+    /* a port moving to a new ifindex releases the old one */
+    replay(sync, RTM_NEWLINK, "Ethernet8", 20, true, true);
+    CHECK_EVENTS("oper 9 up");
+    replay(sync, RTM_NEWLINK, "Ethernet12", 10, true, false);
+    CHECK_EVENTS("create 13, attach 113, admin 113 enable");
+    replay(sync, RTM_NEWLINK, "Ethernet8", 20, true, false);
+    CHECK_EVENTS("oper 9 down");
+
+    /* ifindex beyond the table is served by alias lookup */
+    replay(sync, RTM_NEWLINK, "Ethernet16", NIM_MAX_IFINDEX + 1, true, true);
+    CHECK_EVENTS("create 17, attach 117, admin 117 enable, oper 17 up");
+    replay(sync, RTM_NEWLINK, "Ethernet16", NIM_MAX_IFINDEX + 1, true, false);
+    CHECK_EVENTS("oper 17 down");
+}
+
+/* DELLINK drops the port and its pending oper state, a re-create starts from scratch */
+static void testDelLinkRecreate()
+{
+    NimSync sync(TEST_FLAP_WINDOW_MSEC);
+    reset();
+
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, false);
+    CHECK_EVENTS("create 1, attach 101, admin 101 enable");
+
+    /* oper change pending when the port goes away */
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    CHECK(sync.getFlushTimeout() > 0);
+    replay(sync, RTM_DELLINK, "Ethernet0", 10, false, false);
+    CHECK_EVENTS("detach 101, delete 101");
+    CHECK(sync.getFlushTimeout() == -1);
+    waitFlapWindow();
+    sync.flushPending();
+    CHECK_EVENTS("");
+
+    /* DELLINK of an unknown or already deleted port generates nothing */
+    replay(sync, RTM_DELLINK, "Ethernet4", 11, false, false);
+    CHECK_EVENTS("");
+    replay(sync, RTM_NEWLINK, "Ethernet4", 11, false, false);
+    CHECK_EVENTS("create 5, attach 105");
+    replay(sync, RTM_DELLINK, "Ethernet4", 11, false, false);
+    CHECK_EVENTS("detach 105, delete 105");
+    replay(sync, RTM_DELLINK, "Ethernet4", 11, false, false);
+    CHECK_EVENTS("");
+
+    /* re-created with a new ifindex, the old one no longer points at the deleted port */
+    replay(sync, RTM_NEWLINK, "Ethernet0", 30, true, false);
+    CHECK_EVENTS("create 1, attach 101, admin 101 enable");
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    waitFlapWindow();
+    sync.flushPending();
+    CHECK_EVENTS("oper 1 up");
+
+    /* re-created with the same ifindex */
+    replay(sync, RTM_DELLINK, "Ethernet0", 10, false, false);
+    CHECK_EVENTS("detach 101, delete 101");
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, true);
+    CHECK_EVENTS("create 1, attach 101, admin 101 enable");
+    waitFlapWindow();
+    sync.flushPending();
+    CHECK_EVENTS("oper 1 up");
+}
+
+/* Bulk sync applies the dump without coalescing and retries an interrupted dump */
+static void testBulkSync()
+{
+    NimSync sync(TEST_FLAP_WINDOW_MSEC);
+    reset();
+
+    dumpCache.links.push_back(makeLink("eth0", 2, true, true));
+    dumpCache.links.push_back(makeLink("Ethernet0", 10, true, true));
+    dumpCache.links.push_back(makeLink("Ethernet4", 11, false, false));
+    dumpCache.links.push_back(makeLink("PortChannel1", 12, true, true));
+    dumpCache.links.back().obj.type = "team";
+    dumpCache.links.push_back(makeLink("Ethernet8", 13, true, true));
+    dumpIntrCount = 2;
+
+    CHECK(sync.bulkSync());
+    CHECK_EVENTS("create 1, attach 101, admin 101 enable, oper 1 up, "
+                 "create 5, attach 105, "
+                 "create 9, attach 109, admin 109 enable, oper 9 up");
+    CHECK(sync.getFlushTimeout() == -1);
+
+    /* changes after the bulk sync are coalesced again */
+    replay(sync, RTM_NEWLINK, "Ethernet0", 10, true, false);
+    CHECK_EVENTS("");
+    CHECK(sync.getFlushTimeout() > 0);
+
+    /* dump interrupted on every attempt */
+    dumpIntrCount = 3;
+    CHECK(!sync.bulkSync());
+    CHECK_EVENTS("");
+}
+
+int main()
+{
+    testFlapCoalescing();
+    testIfIndexReuse();
+    testDelLinkRecreate();
+    testBulkSync();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("nimsync_test: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for libnl cache and socket calls used by NimSync::bulkSync,
+ * implemented by the test which replays a recorded link dump.
+ */
+
+#ifndef SHIM_NETLINK_CACHE_H
+#define SHIM_NETLINK_CACHE_H
+
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#define NLE_DUMP_INTR   33
+
+struct nl_object;
+struct nl_sock;
+struct nl_cache;
+
+struct nl_sock *nl_socket_alloc(void);
+void nl_socket_free(struct nl_sock *sk);
+int nl_connect(struct nl_sock *sk, int protocol);
+const char *nl_geterror(int error);
+
+struct nl_object *nl_cache_get_first(struct nl_cache *cache);
+struct nl_object *nl_cache_get_next(struct nl_object *obj);
+int nl_cache_nitems(struct nl_cache *cache);
+void nl_cache_free(struct nl_cache *cache);
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for libnl rtnl_link accessors used by NimSync::onMsg,
+ * implemented by the test on recorded link objects.
+ */
+
+#ifndef SHIM_NETLINK_ROUTE_LINK_H
+#define SHIM_NETLINK_ROUTE_LINK_H
+
+#include <stddef.h>
+#include "netlink/cache.h"
+
+struct rtnl_link;
+struct nl_addr;
+
+char *rtnl_link_get_name(struct rtnl_link *link);
+unsigned int rtnl_link_get_flags(struct rtnl_link *link);
+struct nl_addr *rtnl_link_get_addr(struct rtnl_link *link);
+int rtnl_link_get_ifindex(struct rtnl_link *link);
+int rtnl_link_get_master(struct rtnl_link *link);
+char *rtnl_link_get_type(struct rtnl_link *link);
+char *nl_addr2str(const struct nl_addr *addr, char *buf, size_t size);
+int rtnl_link_alloc_cache(struct nl_sock *sk, int family, struct nl_cache **result);
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for nim_events.h, only the events NimSync generates */
+
+#ifndef SHIM_NIM_EVENTS_H
+#define SHIM_NIM_EVENTS_H
+
+typedef enum
+{
+  UP = 1,
+  DOWN,
+  CREATE,
+  ATTACH,
+  DETACH,
+  DELETE
+} PORT_EVENTS_t;
+
+typedef uint32 NIM_HANDLE_t;
+
+typedef struct
+{
+  uint32 component;
+  PORT_EVENTS_t event;
+  uint32 intIfNum;
+  void (*pCbFunc)(void);
+} NIM_EVENT_NOTIFY_INFO_t;
+
+#endif
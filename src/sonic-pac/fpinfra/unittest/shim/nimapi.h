@@ -0,0 +1,31 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for nimapi.h, implemented by the test which records the calls */
+
+#ifndef SHIM_NIMAPI_H
+#define SHIM_NIMAPI_H
+
+RC_t nimCmgrNewIntfChangeCallback(uint32 unit, uint32 slot, uint32 port, uint32 cardType,
+                                  PORT_EVENTS_t event, SYSAPI_HPC_PORT_DESCRIPTOR_t *portData,
+                                  enetMacAddr_t *macAddr);
+RC_t nimGetIntIfNumFromUSP(nimUSP_t *usp, uint32 *intIfNum);
+RC_t nimSetIntfifAlias(uint32 intIfNum, uchar8 *ifAlias);
+RC_t nimEventIntfNotify(NIM_EVENT_NOTIFY_INFO_t eventInfo, NIM_HANDLE_t *pHandle);
+RC_t nimSetIntfAdminState(uint32 intIfNum, uint32 adminState);
+void nimDtlIntfChangeCallback(nimUSP_t *usp, uint32 event, void *dapiIntmgmt);
+
+#endif
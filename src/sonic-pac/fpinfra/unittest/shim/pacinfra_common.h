@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for pacinfra_common.h, only the types and values nimsync.cpp uses */
+
+#ifndef SHIM_PACINFRA_COMMON_H
+#define SHIM_PACINFRA_COMMON_H
+
+typedef unsigned char uchar8;
+typedef unsigned int uint32;
+typedef unsigned long long uint64;
+
+typedef enum
+{
+  SUCCESS = 0,
+  FAILURE
+} RC_t;
+
+#define ENABLE   1
+#define DISABLE  0
+
+#define MAC_ADDR_LEN  6
+
+typedef struct
+{
+  uchar8 addr[MAC_ADDR_LEN];
+} enetMacAddr_t;
+
+typedef struct
+{
+  uint32 unit;
+  uint32 slot;
+  uint32 port;
+} nimUSP_t;
+
+#define IANA_GIGABIT_ETHERNET          6
+#define PORTCTRL_PORTSPEED_FULL_10GSX  1
+#define PHY_CAP_PORTSPEED_ALL          0xffff
+#define PORT_FEC_DISABLE               0
+#define CAP_FEC_NONE                   0
+
+typedef struct
+{
+  uint32 type;
+  uint32 defaultSpeed;
+  uint64 phyCapabilities;
+  uint32 defaultFEC;
+  uint32 fecCapabilities;
+} SYSAPI_HPC_PORT_DESCRIPTOR_t;
+
+#endif
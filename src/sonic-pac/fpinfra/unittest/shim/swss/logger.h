@@ -0,0 +1,27 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for swss/logger.h, NimSync logs are dropped */
+
+#ifndef SHIM_SWSS_LOGGER_H
+#define SHIM_SWSS_LOGGER_H
+
+#define SWSS_LOG_ENTER()
+#define SWSS_LOG_ERROR(...)
+#define SWSS_LOG_NOTICE(...)
+#define SWSS_LOG_INFO(...)
+
+#endif
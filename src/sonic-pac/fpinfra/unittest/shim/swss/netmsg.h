@@ -0,0 +1,34 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for swss/netmsg.h, only the NetMsg interface NimSync implements */
+
+#ifndef SHIM_SWSS_NETMSG_H
+#define SHIM_SWSS_NETMSG_H
+
+struct nl_object;
+
+namespace swss {
+
+class NetMsg {
+public:
+    virtual ~NetMsg() {}
+    virtual void onMsg(int nlmsg_type, struct nl_object *obj) = 0;
+};
+
+}
+
+#endif
@@ -61,6 +61,7 @@ typedef struct mabBlock_s
   /* App timer related data */
    APP_TMR_CTRL_BLK_t   mabTimerCB;
   uint32              mabAppTimerBufferPoolId;
+  mabTimerWheel_t     mabTimerWheel;
 
    BOOL warmRestart;
    BOOL mabSwitchoverInProgress;
@@ -76,7 +77,10 @@ typedef struct mabBlock_s
    mabLogicalPortInfo_t   *mabLogicalPortDataHeap;
 
    uint32     mabMacAddrBufferPoolId;
-    sll_t      mabMacAddrSLL;
+   void       **mabMacAddrHashTbl;   /* supplicant mac address hash buckets */
+   uint32     mabMacAddrHashBits;
+   uint32     mabMacAddrHashMask;
+   uint32     mabMacAddrCount;
    osapiRWLock_t mabMacAddrDBRWLock;
 
    osapiRWLock_t       mabRWLock;
@@ -28,6 +28,7 @@
 #include "mab_vlan.h"
 #include "auth_mgr_exports.h"
 #include "mab_radius.h"
+#include "mab_timer_wheel.h"
 #include "mab_exports.h"
 #include "mab_util.h"
 #include "avl_api.h"
@@ -127,10 +128,23 @@ typedef struct mabTimerContext_s
 }mabTimerContext_t;
 
 
+typedef struct mabTimerNode_s
+{
+  mabTimerWheelNode_t    link;     /* first, wheel nodes are cast back to timer nodes */
+  mabTimerContext_t      cxt;
+}mabTimerNode_t;
+
+typedef struct mabTimerWheel_s
+{
+  mabTimerWheelBase_t    base;
+  mabTimerNode_t        *freeList;
+  APP_TMR_HNDL_t         tickTimer;     /* single app timer driving the wheel */
+  uint32                 jitterState;   /* xorshift32 state of the timer jitter */
+}mabTimerWheel_t;
+
 typedef struct mabTimerHandle_s
 {
-   APP_TMR_HNDL_t         timer;
- /* void                     *timerHandle; */
+   mabTimerNode_t         *timer;
 }mabTimerHandle_t;
 
 
@@ -187,6 +201,7 @@ typedef struct mabTimerMap_s
 {
   mabTimerType_t  type;
   mabCtrlTimerExpiryFn_t  expiryFn;
+  uint32          jitter;  /* percent of the timeout added at random */
 }mabTimerMap_t;
 
 
@@ -23,6 +23,7 @@ extern "C" {
 #endif
 
 #include "radius_attr_parse.h"
+#include "mab_radius_window.h"
 
 extern RC_t mabRadiusResponseCallback(void *msg, uint32 correlator);
 extern RC_t mabRadiusResponseProcess(unsigned int lIntIfNum, void *resp);
@@ -34,6 +35,10 @@ extern RC_t mabRadiusChallengeProcess(uint32 intIfNum, void *radiusPayload);
 extern RC_t mabRadiusAccessRequestSend(uint32 intIfNum,  uchar8 *suppEapData);
 extern RC_t mabRadiusSuppResponseProcess(uint32 intIfNum,  netBufHandle bufHandle);
 extern  void mabRadiusClearRadiusMsgsSend( enetMacAddr_t suppMacAddr);
+extern void mabRadiusInflightRelease(uint32 lIntIfNum,  enetMacAddr_t *suppMacAddr);
+extern RC_t mabRadiusInflightWindowSet(uint32 window);
+extern RC_t mabRadiusInflightWindowGet(uint32 *window);
+extern RC_t mabDebugRadiusWindowShow(void);
 
 extern int radius_mab_client_register(void *data);
 
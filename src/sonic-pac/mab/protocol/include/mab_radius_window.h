@@ -0,0 +1,190 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_MAB_RADIUS_WINDOW_H
+#define INCLUDE_MAB_RADIUS_WINDOW_H
+
+/* USE C Declarations */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Access-request throttle towards the RADIUS client.
+   Up to window requests are outstanding at a time, further requests
+   wait in arrival order and are released as responses come back, the
+   client's server awhile timer expires or an inflight slot passes its
+   deadline.
+   Scope: this is one window for the whole RADIUS client context, not a
+   per-server engine. Server selection, RADIUS identifier allocation and
+   retransmission stay with the RADIUS client, which keeps a single
+   identifier space for all servers; the window never exceeds that 8 bit
+   space, so an identifier is never reused while a request is pending.
+   The throttle has no dependency on the rest of MAB, so it can be
+   driven by a virtual clock. */
+
+/* Number of access-requests outstanding towards the RADIUS client,
+ * bounded by the 8 bit RADIUS identifier space */
+#define MAB_RADIUS_INFLIGHT_WINDOW_DEF   64
+#define MAB_RADIUS_INFLIGHT_WINDOW_MAX   256
+
+/* Extra seconds past the server awhile timeout before an unanswered
+ * inflight slot is reclaimed */
+#define MAB_RADIUS_INFLIGHT_SLACK        5
+
+#define MAB_RADIUS_WINDOW_MAC_LEN        6
+
+typedef struct mabRadiusInflight_s
+{
+  uint32_t  key;          /* logical interface, 0 when the slot is free */
+  uint8_t   mac[MAB_RADIUS_WINDOW_MAC_LEN];
+  uint32_t  deadline;     /* uptime in seconds */
+}mabRadiusInflight_t;
+
+/* Queued request, embedded first in the owner's request */
+typedef struct mabRadiusWindowReq_s
+{
+  struct mabRadiusWindowReq_s *next;
+  uint32_t  key;
+  uint8_t   mac[MAB_RADIUS_WINDOW_MAC_LEN];
+}mabRadiusWindowReq_t;
+
+typedef struct mabRadiusWindow_s
+{
+  uint32_t               window;
+  uint32_t               inflightCount;
+  mabRadiusInflight_t    inflight[MAB_RADIUS_INFLIGHT_WINDOW_MAX];
+  mabRadiusWindowReq_t  *pendHead;
+  mabRadiusWindowReq_t  *pendTail;
+  uint32_t               pendCount;
+
+  /* statistics */
+  uint32_t               sentCount;
+  uint32_t               queuedCount;
+  uint32_t               expiredCount;
+  uint32_t               pendCountMax;
+}mabRadiusWindow_t;
+
+/* Called for each queued request dropped by a release */
+typedef void (*mabRadiusWindowFreeFn_t)(mabRadiusWindowReq_t *req);
+
+/*************************************************************************
+ * @purpose  Set the number of access-requests outstanding at a time
+ *
+ * @param    win     @b{(input)}  Throttle
+ * @param    window  @b{(input)}  Inflight window, 0 restores the default
+ *
+ * @returns  0 on success, -1 if window is above the identifier space
+ *
+ * @comments Shrinking the window does not drop outstanding requests,
+ *           new ones are held back until the count falls below it.
+ *
+ * @end
+ *************************************************************************/
+int mabRadiusWindowSet(mabRadiusWindow_t *win, uint32_t window);
+
+/*************************************************************************
+ * @purpose  Check whether a new request may be sent right away
+ *
+ * @param    win  @b{(input)}  Throttle
+ *
+ * @returns  1 if there is window space and nothing is queued, else 0
+ *
+ * @end
+ *************************************************************************/
+int mabRadiusWindowOpen(mabRadiusWindow_t *win);
+
+/*************************************************************************
+ * @purpose  Account a sent access-request as outstanding
+ *
+ * @param    win       @b{(input)}  Throttle
+ * @param    key       @b{(input)}  Logical interface, not 0
+ * @param    mac       @b{(input)}  Supplicant MAC address
+ * @param    deadline  @b{(input)}  Uptime at which the slot is reclaimed
+ *
+ * @returns  void
+ *
+ * @comments A request re-sent for the same key reuses its slot.
+ *
+ * @end
+ *************************************************************************/
+void mabRadiusWindowInflightAdd(mabRadiusWindow_t *win, uint32_t key,
+                                const uint8_t *mac, uint32_t deadline);
+
+/*************************************************************************
+ * @purpose  Reclaim inflight slots whose response never arrived
+ *
+ * @param    win  @b{(input)}  Throttle
+ * @param    now  @b{(input)}  Uptime in seconds
+ *
+ * @returns  number of slots reclaimed
+ *
+ * @comments Safety net for clients removed without a response or a
+ *           server awhile expiry, e.g. on port deletion. The uptime
+ *           may wrap.
+ *
+ * @end
+ *************************************************************************/
+uint32_t mabRadiusWindowExpire(mabRadiusWindow_t *win, uint32_t now);
+
+/*************************************************************************
+ * @purpose  Queue a request at the tail
+ *
+ * @param    win  @b{(input)}  Throttle
+ * @param    req  @b{(input)}  Request, key and mac filled in
+ *
+ * @returns  void
+ *
+ * @end
+ *************************************************************************/
+void mabRadiusWindowEnqueue(mabRadiusWindow_t *win, mabRadiusWindowReq_t *req);
+
+/*************************************************************************
+ * @purpose  Take the oldest queued request if the window has space
+ *
+ * @param    win  @b{(input)}  Throttle
+ *
+ * @returns  the request, now owned by the caller, or NULL
+ *
+ * @comments The caller accounts the request with
+ *           mabRadiusWindowInflightAdd once it is sent.
+ *
+ * @end
+ *************************************************************************/
+mabRadiusWindowReq_t *mabRadiusWindowDequeue(mabRadiusWindow_t *win);
+
+/*************************************************************************
+ * @purpose  Release the inflight slot and queued requests of a client
+ *
+ * @param    win     @b{(input)}  Throttle
+ * @param    key     @b{(input)}  Logical interface, 0 to match on mac only
+ * @param    mac     @b{(input)}  Supplicant MAC address, or NULL
+ * @param    freeFn  @b{(input)}  Called for each queued request dropped
+ *
+ * @returns  void
+ *
+ * @end
+ *************************************************************************/
+void mabRadiusWindowRelease(mabRadiusWindow_t *win, uint32_t key,
+                            const uint8_t *mac, mabRadiusWindowFreeFn_t freeFn);
+
+/* USE C Declarations */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_MAB_RADIUS_WINDOW_H */
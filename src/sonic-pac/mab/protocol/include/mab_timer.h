@@ -95,6 +95,19 @@ void mabTimerExpiryAction(void *param);
   *************************************************************************/
 RC_t mabTimerHandlerInfoGet(mabTimerType_t type, mabTimerMap_t *handler);
 
+/*************************************************************************
+ * @purpose  Process the timer wheel tick
+ *
+ * @param    param  @b{(input)}  unused
+ *
+ * @returns  void
+ *
+ * @comments none
+ *
+ * @end
+ *************************************************************************/
+void mabTimerWheelTickAction(void *param);
+
 /*************************************************************************
  * @purpose  function to process on expiry of server awhile timer 
  *
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_MAB_TIMER_WHEEL_H
+#define INCLUDE_MAB_TIMER_WHEEL_H
+
+/* USE C Declarations */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Hierarchical timer wheel, one tick is one second.
+   Each level has MAB_TIMER_WHEEL_SLOTS slots, a slot of level n
+   covers MAB_TIMER_WHEEL_SLOTS^n ticks.
+   The wheel has no dependency on the rest of MAB, so it can be driven
+   by a virtual clock. */
+#define MAB_TIMER_WHEEL_BITS      6
+#define MAB_TIMER_WHEEL_SLOTS     (1 << MAB_TIMER_WHEEL_BITS)
+#define MAB_TIMER_WHEEL_MASK      (MAB_TIMER_WHEEL_SLOTS - 1)
+#define MAB_TIMER_WHEEL_LEVELS    4
+
+/* Longest timeout, longer ones are clamped */
+#define MAB_TIMER_WHEEL_MAX_TICKS \
+  ((1U << (MAB_TIMER_WHEEL_LEVELS * MAB_TIMER_WHEEL_BITS)) - 1)
+
+typedef struct mabTimerWheelNode_s
+{
+  struct mabTimerWheelNode_s  *next;
+  struct mabTimerWheelNode_s **pprev;   /* link pointing to this node, NULL if unlinked */
+  uint32_t                     expiry;  /* tick at which the timer fires */
+}mabTimerWheelNode_t;
+
+typedef struct mabTimerWheelBase_s
+{
+  int                   started;
+  uint32_t              now;           /* next tick to be processed */
+  uint32_t              count;         /* running timers */
+  mabTimerWheelNode_t  *slots[MAB_TIMER_WHEEL_LEVELS][MAB_TIMER_WHEEL_SLOTS];
+  mabTimerWheelNode_t  *expired;       /* batch being delivered */
+}mabTimerWheelBase_t;
+
+/* Called for each expired node, already off the wheel */
+typedef void (*mabTimerWheelExpiryFn_t)(mabTimerWheelNode_t *node);
+
+/*************************************************************************
+ * @purpose  Start a timer on the wheel
+ *
+ * @param    wheel    @b{(input)}  Timer wheel
+ * @param    node     @b{(input)}  Unlinked timer node
+ * @param    timeout  @b{(input)}  Timeout in ticks
+ *
+ * @returns  void
+ *
+ * @comments The timer fires when the wheel is advanced past
+ *           timeout ticks after the last processed tick, never earlier.
+ *
+ * @end
+ *************************************************************************/
+void mabTimerWheelAdd(mabTimerWheelBase_t *wheel, mabTimerWheelNode_t *node,
+                      uint32_t timeout);
+
+/*************************************************************************
+ * @purpose  Stop a timer
+ *
+ * @param    wheel  @b{(input)}  Timer wheel
+ * @param    node   @b{(input)}  Timer node
+ *
+ * @returns  void
+ *
+ * @comments O(1). A timer already delivered, or never started, is left
+ *           alone; one waiting in the batch being delivered is dropped.
+ *
+ * @end
+ *************************************************************************/
+void mabTimerWheelRemove(mabTimerWheelBase_t *wheel, mabTimerWheelNode_t *node);
+
+/*************************************************************************
+ * @purpose  Turn the timer wheel up to the given time
+ *
+ * @param    wheel     @b{(input)}  Timer wheel
+ * @param    now       @b{(input)}  Current time in ticks
+ * @param    expiryFn  @b{(input)}  Called for each expired timer
+ *
+ * @returns  void
+ *
+ * @comments All timers expiring up to now are collected first, then
+ *           delivered in one batch. A timer stopped by an earlier expiry
+ *           of the same batch is not delivered.
+ *
+ * @end
+ *************************************************************************/
+void mabTimerWheelAdvance(mabTimerWheelBase_t *wheel, uint32_t now,
+                          mabTimerWheelExpiryFn_t expiryFn);
+
+/* USE C Declarations */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_MAB_TIMER_WHEEL_H */
@@ -18,6 +18,7 @@
 #include "mab_include.h"
 #include "mab_util.h"
 #include "mab_struct.h"
+#include "mab_timer.h"
 #include "osapi_sem.h"
 
 extern mabBlock_t *mabBlock;
@@ -242,6 +243,8 @@ RC_t mabLogicalPortInfoDeAlloc(mabLogicalPortInfo_t *node)
 
     if (AUTHMGR_LOGICAL == type)
     {
+    /* The timer node is owned by the wheel, not by the tree entry */
+    mabTimerDestroy(mabBlock->mabTimerCB, node);
     osapiSemaTake(mabBlock->mabLogicalPortTreeDb.semId,  WAIT_FOREVER);
     avlDeleteEntry(&mabBlock->mabLogicalPortTreeDb,node);
     osapiSemaGive(mabBlock->mabLogicalPortTreeDb.semId);
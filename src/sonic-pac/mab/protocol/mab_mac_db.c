@@ -23,20 +23,80 @@ extern mabBlock_t *mabBlock;
 
 /* Global parameters */
 typedef struct mabMacAddrInfo_s{
-     sll_member_t          *next;
+    struct mabMacAddrInfo_s *next;   /* hash bucket chain */
      enetMacAddr_t         suppMacAddr;
     uint32                lIntIfNum;
 }mabMacAddrInfo_t;
 
+/*************************************************************************
+* @purpose  Hash a supplicant mac address into a bucket index
+*
+* @param    mac_addr  @b{(input)}  supplicant mac address
+*
+* @returns  bucket index
+*
+* @comments The NIC specific low order bytes carry most of the entropy,
+*           fold the OUI in and spread with a multiplicative hash.
+*
+* @end
+*************************************************************************/
+static uint32 mabMacAddrHash( enetMacAddr_t *mac_addr)
+{
+  uint32 key;
+
+  key = ((uint32)mac_addr->addr[2] << 24) | ((uint32)mac_addr->addr[3] << 16) |
+        ((uint32)mac_addr->addr[4] << 8) | (uint32)mac_addr->addr[5];
+  key ^= ((uint32)mac_addr->addr[0] << 16) | ((uint32)mac_addr->addr[1] << 8);
+  key *= 2654435761U;
+
+  return (key >> (32 - mabBlock->mabMacAddrHashBits)) & mabBlock->mabMacAddrHashMask;
+}
+
+/*************************************************************************
+* @purpose  Look up a node in the Mac Addr hash table
+*
+* @param    mac_addr  @b{(input)}  supplicant mac address
+* @param    prev      @b{(output)} previous node in the bucket chain,
+*                                  NULL if the node is the bucket head
+*
+* @returns  pointer to the node or  NULLPTR
+*
+* @comments Caller must hold mabMacAddrDBRWLock
+*
+* @end
+*************************************************************************/
+static mabMacAddrInfo_t *mabMacAddrHashLookup( enetMacAddr_t *mac_addr,
+                                              mabMacAddrInfo_t **prev)
+{
+  mabMacAddrInfo_t *pMacAddrInfo, *pPrev =  NULLPTR;
+
+  pMacAddrInfo = (mabMacAddrInfo_t *)mabBlock->mabMacAddrHashTbl[mabMacAddrHash(mac_addr)];
+  while (pMacAddrInfo !=  NULLPTR)
+  {
+    if (memcmp(pMacAddrInfo->suppMacAddr.addr, mac_addr->addr, ENET_MAC_ADDR_LEN) == 0)
+    {
+      break;
+    }
+    pPrev = pMacAddrInfo;
+    pMacAddrInfo = pMacAddrInfo->next;
+  }
+
+  if (prev !=  NULLPTR)
+  {
+    *prev = pPrev;
+  }
+  return pMacAddrInfo;
+}
+
 /*************************************************************************
 * @purpose  API to destroy the Mac Addr Info data node
 *
-* @param    ll_member  @b{(input)}  Linked list node containing the
+* @param    ll_member  @b{(input)}  node containing the
 *                                   Mac Addr Info to be destroyed
 *
 * @returns   SUCCESS
 *
-* @comments This is called by SLL library when a node is being deleted
+* @comments The node must already be unlinked from its hash bucket
 *
 * @end
 *************************************************************************/
@@ -63,7 +123,7 @@ RC_t mabMacAddrDataDestroy ( sll_member_t *ll_member)
 * @returns  -1   p < q
 * @returns  +1   p > q
 *
-* @comments This is called by SLL library when a nodes are compared
+* @comments Used to keep mabMacAddrInfoFindNext in ascending mac order
 *
 * @end
 *************************************************************************/
@@ -88,12 +148,16 @@ RC_t mabMacAddrDataDestroy ( sll_member_t *ll_member)
 *
 * @returns   SUCCESS or  FAILURE
 *
-* @comments none
+* @comments The database is a chained hash table keyed by mac address
+*           with at least as many buckets as nodes, so that add, find
+*           and remove stay constant time with thousands of supplicants.
 *
 * @end
 *********************************************************************/
 RC_t mabMacAddrInfoDBInit(uint32 nodeCount)
 {
+  uint32 bits = 4;
+
   /* Allocate the buffer pool */
   if (bufferPoolInit( MAB_COMPONENT_ID, nodeCount, sizeof(mabMacAddrInfo_t), 
                      "MAB Mac Addr Bufs",
@@ -101,22 +165,30 @@ RC_t mabMacAddrInfoDBInit(uint32 nodeCount)
   {
      LOGF(  LOG_SEVERITY_NOTICE,
         "\n%s: Error allocating buffers for supplicant mac address database."
-        " Could not allocate buffer pool for Mac address link list. Insufficient memory."
+        " Could not allocate buffer pool for Mac address hash table. Insufficient memory."
         ,__FUNCTION__);
     MAB_EVENT_TRACE("%s: Error allocating buffers for supplicant mac address database\n",__FUNCTION__);
     return  FAILURE;
   }
 
-  /* Create the SLL*/
-  if (SLLCreate( MAB_COMPONENT_ID,  SLL_ASCEND_ORDER,
-               sizeof( enetMacAddr_t),mabMacAddrDataCmp ,mabMacAddrDataDestroy ,
-               &mabBlock->mabMacAddrSLL) !=  SUCCESS)
+  /* Create the hash table, power of 2 buckets, load factor <= 1 */
+  while ((bits < 24) && ((1U << bits) < nodeCount))
+  {
+    bits++;
+  }
+  mabBlock->mabMacAddrHashBits = bits;
+  mabBlock->mabMacAddrHashMask = (1U << bits) - 1;
+  mabBlock->mabMacAddrHashTbl = (void **)osapiMalloc( MAB_COMPONENT_ID,
+      (1U << bits) * sizeof(void *));
+  if (mabBlock->mabMacAddrHashTbl ==  NULLPTR)
   {
      LOGF( LOG_SEVERITY_INFO,
-            "\n%s: Failed to create supplicant mac address linked list \n",__FUNCTION__);
-    MAB_EVENT_TRACE("%s: Failed to create supplicant mac address linked list \n",__FUNCTION__);
+            "\n%s: Failed to create supplicant mac address hash table \n",__FUNCTION__);
+    MAB_EVENT_TRACE("%s: Failed to create supplicant mac address hash table \n",__FUNCTION__);
     return  FAILURE;
   }
+  memset(mabBlock->mabMacAddrHashTbl, 0, (1U << bits) * sizeof(void *));
+  mabBlock->mabMacAddrCount = 0;
 
   /* Create Mac Address DB Semaphore*/
   /* Read write lock for controlling Mac Addr Info additions and Deletions */
@@ -145,13 +217,26 @@ RC_t mabMacAddrInfoDBInit(uint32 nodeCount)
 *********************************************************************/
 RC_t mabMacAddrInfoDBDeInit(void)
 {
-  /* Destroy the SLL */
-  if (SLLDestroy( MAB_COMPONENT_ID, &mabBlock->mabMacAddrSLL)!=  SUCCESS)
+  mabMacAddrInfo_t *pMacAddrInfo, *pNext;
+  uint32 i;
+
+  /* Destroy the hash table */
+  if (mabBlock->mabMacAddrHashTbl !=  NULLPTR)
   {
-     LOGF( LOG_SEVERITY_INFO,
-            "\n%s: Failed to destroy the supplicant mac address linked list \n",__FUNCTION__);
-    MAB_EVENT_TRACE("\n%s: Failed to destroy the supplicant mac address linked list \n",__FUNCTION__);
+    for (i = 0; i <= mabBlock->mabMacAddrHashMask; i++)
+    {
+      pMacAddrInfo = (mabMacAddrInfo_t *)mabBlock->mabMacAddrHashTbl[i];
+      while (pMacAddrInfo !=  NULLPTR)
+      {
+        pNext = pMacAddrInfo->next;
+        (void)mabMacAddrDataDestroy(( sll_member_t *)pMacAddrInfo);
+        pMacAddrInfo = pNext;
+      }
+    }
+    osapiFree( MAB_COMPONENT_ID, mabBlock->mabMacAddrHashTbl);
+    mabBlock->mabMacAddrHashTbl =  NULLPTR;
   }
+  mabBlock->mabMacAddrCount = 0;
 
   /* Deallocate the buffer pool */
 
@@ -182,9 +267,9 @@ RC_t mabMacAddrInfoDBDeInit(void)
 *********************************************************************/
 RC_t mabMacAddrInfoAdd( enetMacAddr_t *mac_addr,uint32 lIntIfNum)
 {
-   mabMacAddrInfo_t *pMacAddrInfo,*pMacAddrFind,macAddrInfo;
+   mabMacAddrInfo_t *pMacAddrInfo,*pMacAddrFind;
     enetMacAddr_t    nullMacAddr;
-   uint32 physPort = 0;
+   uint32 physPort = 0, bucket;
 
    memset(&(nullMacAddr.addr),0, ENET_MAC_ADDR_LEN);
 
@@ -205,12 +290,10 @@ RC_t mabMacAddrInfoAdd( enetMacAddr_t *mac_addr,uint32 lIntIfNum)
    }
 
    /* In order to handle client roaming , check if the mac address already exists*/
-   /* copy info to node*/
-    memcpy(macAddrInfo.suppMacAddr.addr,mac_addr->addr, ENET_MAC_ADDR_LEN);
    /* take Mac address DB semaphore*/
    (void)osapiWriteLockTake(mabBlock->mabMacAddrDBRWLock,  WAIT_FOREVER);
 
-   if ((pMacAddrFind=(mabMacAddrInfo_t *)SLLFind(&mabBlock->mabMacAddrSLL,( sll_member_t *)&macAddrInfo)) !=  NULLPTR)
+   if ((pMacAddrFind = mabMacAddrHashLookup(mac_addr,  NULLPTR)) !=  NULLPTR)
    {
        pMacAddrFind->lIntIfNum = lIntIfNum;
       (void) osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
@@ -241,19 +324,11 @@ RC_t mabMacAddrInfoAdd( enetMacAddr_t *mac_addr,uint32 lIntIfNum)
    memcpy(pMacAddrInfo->suppMacAddr.addr,mac_addr->addr, ENET_MAC_ADDR_LEN);
    pMacAddrInfo->lIntIfNum = lIntIfNum;
 
-
-   /* Add node to the SLL*/
-   if (SLLAdd(&mabBlock->mabMacAddrSLL, ( sll_member_t *)pMacAddrInfo)
-         !=  SUCCESS)
-   {
-       MAB_EVENT_TRACE("\n%s: Could not add supplicant mac address(%2.2x:%2.2x:%2.2x:%2.2x:%2.2x:%2.2x) logical Interface: %d . \n",
-               __FUNCTION__, mac_addr->addr[0],mac_addr->addr[1],mac_addr->addr[2],mac_addr->addr[3],mac_addr->addr[4],mac_addr->addr[5],lIntIfNum);
-       /* Free the previously allocated bufferpool */
-       bufferPoolFree(mabBlock->mabMacAddrBufferPoolId, ( uchar8 *)pMacAddrInfo);
-       /* release semaphore*/
-       (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
-       return  FAILURE;
-   }
+   /* Add node at the head of its bucket */
+   bucket = mabMacAddrHash(mac_addr);
+   pMacAddrInfo->next = (mabMacAddrInfo_t *)mabBlock->mabMacAddrHashTbl[bucket];
+   mabBlock->mabMacAddrHashTbl[bucket] = pMacAddrInfo;
+   mabBlock->mabMacAddrCount++;
 
     /* release semaphore*/
     (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
@@ -273,7 +348,7 @@ RC_t mabMacAddrInfoAdd( enetMacAddr_t *mac_addr,uint32 lIntIfNum)
 *********************************************************************/
 RC_t mabMacAddrInfoRemove( enetMacAddr_t *mac_addr)
 {
-   mabMacAddrInfo_t macAddrInfo;
+   mabMacAddrInfo_t *pMacAddrInfo, *pPrev;
     enetMacAddr_t    nullMacAddr;
 
    memset(&nullMacAddr.addr,0, ENET_MAC_ADDR_LEN);
@@ -283,25 +358,32 @@ RC_t mabMacAddrInfoRemove( enetMacAddr_t *mac_addr)
    {
        return  FAILURE;
    }
-   /* copy info to node*/
-   memcpy(macAddrInfo.suppMacAddr.addr,mac_addr->addr, ENET_MAC_ADDR_LEN);
-   macAddrInfo.lIntIfNum = 0;
 
    /* take Mac address DB semaphore*/
    (void)osapiWriteLockTake(mabBlock->mabMacAddrDBRWLock,  WAIT_FOREVER);
 
-    /* delete from SLL*/
-    if (SLLDelete(&mabBlock->mabMacAddrSLL, ( sll_member_t *)&macAddrInfo)
-                  !=  SUCCESS)
+    /* unlink from the hash bucket */
+    if ((pMacAddrInfo = mabMacAddrHashLookup(mac_addr, &pPrev)) ==  NULLPTR)
     {
         /* release semaphore*/
        (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
 
-        MAB_EVENT_TRACE("\n%s: Could not delete supplicant mac address(%2.2x:%2.2x:%2.2x:%2.2x:%2.2x:%2.2x) from the SLL . \n",
+        MAB_EVENT_TRACE("\n%s: Could not delete supplicant mac address(%2.2x:%2.2x:%2.2x:%2.2x:%2.2x:%2.2x) from the hash table . \n",
                __FUNCTION__, mac_addr->addr[0],mac_addr->addr[1],mac_addr->addr[2],mac_addr->addr[3],mac_addr->addr[4],mac_addr->addr[5]);
        return  FAILURE;
     }
 
+    if (pPrev ==  NULLPTR)
+    {
+      mabBlock->mabMacAddrHashTbl[mabMacAddrHash(mac_addr)] = pMacAddrInfo->next;
+    }
+    else
+    {
+      pPrev->next = pMacAddrInfo->next;
+    }
+    mabBlock->mabMacAddrCount--;
+    (void)mabMacAddrDataDestroy(( sll_member_t *)pMacAddrInfo);
+
   /* release semaphore*/
   (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
   return  SUCCESS;
@@ -322,7 +404,7 @@ RC_t mabMacAddrInfoRemove( enetMacAddr_t *mac_addr)
 *********************************************************************/
 RC_t mabMacAddrInfoFind( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
 {
-  mabMacAddrInfo_t macAddrInfo,*pMacAddrInfo;
+  mabMacAddrInfo_t *pMacAddrInfo;
    enetMacAddr_t    nullMacAddr;
 
   memset(&nullMacAddr.addr,0, ENET_MAC_ADDR_LEN);
@@ -332,16 +414,14 @@ RC_t mabMacAddrInfoFind( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
   {
       return  FAILURE;
   }
-  /* copy info to node*/
-  memcpy(macAddrInfo.suppMacAddr.addr,mac_addr->addr, ENET_MAC_ADDR_LEN);
 
-  /* take Mac address DB semaphore*/
-   (void)osapiWriteLockTake(mabBlock->mabMacAddrDBRWLock,  WAIT_FOREVER);
+  /* take Mac address DB semaphore, lookups do not modify the table */
+   (void)osapiReadLockTake(mabBlock->mabMacAddrDBRWLock,  WAIT_FOREVER);
 
-  if ((pMacAddrInfo=(mabMacAddrInfo_t *)SLLFind(&mabBlock->mabMacAddrSLL,( sll_member_t *)&macAddrInfo)) ==  NULLPTR)
+  if ((pMacAddrInfo = mabMacAddrHashLookup(mac_addr,  NULLPTR)) ==  NULLPTR)
   {
       /* release semaphore*/
-     (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
+     (void)osapiReadLockGive(mabBlock->mabMacAddrDBRWLock);
       MAB_EVENT_TRACE("\n%s: Could not find supplicant mac address(%2.2x:%2.2x:%2.2x:%2.2x:%2.2x:%2.2x). \n",
                __FUNCTION__, mac_addr->addr[0],mac_addr->addr[1],mac_addr->addr[2],mac_addr->addr[3],mac_addr->addr[4],mac_addr->addr[5]);
       *lIntIfNum = MAB_LOGICAL_PORT_ITERATE;
@@ -349,7 +429,7 @@ RC_t mabMacAddrInfoFind( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
   }
   *lIntIfNum = pMacAddrInfo->lIntIfNum;
   /* release semaphore*/
-  (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
+  (void)osapiReadLockGive(mabBlock->mabMacAddrDBRWLock);
   return  SUCCESS;
 }
 
@@ -361,13 +441,17 @@ RC_t mabMacAddrInfoFind( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
 *
 * @returns   SUCCESS or  FAILURE
 *
-* @comments none
+* @comments Returns the smallest mac address greater than mac_addr.
+*           The hash table is unordered, so this walks all nodes; it is
+*           only used by show and debug iteration, not on the
+*           authentication path.
 *
 * @end
 *********************************************************************/
 RC_t mabMacAddrInfoFindNext( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
 {
-  mabMacAddrInfo_t macAddrInfo,*pMacAddrInfo;
+  mabMacAddrInfo_t macAddrInfo,*pMacAddrInfo,*pBest =  NULLPTR;
+  uint32 i;
 
   /*input check*/
   if (mac_addr ==  NULLPTR)
@@ -379,12 +463,25 @@ RC_t mabMacAddrInfoFindNext( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
   memcpy(macAddrInfo.suppMacAddr.addr,mac_addr->addr, ENET_MAC_ADDR_LEN);
 
    /* take Mac address DB semaphore*/
-   (void)osapiWriteLockTake(mabBlock->mabMacAddrDBRWLock,  WAIT_FOREVER);
+   (void)osapiReadLockTake(mabBlock->mabMacAddrDBRWLock,  WAIT_FOREVER);
 
-  if ((pMacAddrInfo=(mabMacAddrInfo_t *)SLLFindNext(&mabBlock->mabMacAddrSLL,( sll_member_t *)&macAddrInfo)) ==  NULLPTR)
+  for (i = 0; i <= mabBlock->mabMacAddrHashMask; i++)
+  {
+    for (pMacAddrInfo = (mabMacAddrInfo_t *)mabBlock->mabMacAddrHashTbl[i];
+         pMacAddrInfo !=  NULLPTR; pMacAddrInfo = pMacAddrInfo->next)
+    {
+      if ((mabMacAddrDataCmp(pMacAddrInfo, &macAddrInfo, 0) > 0) &&
+          ((pBest ==  NULLPTR) || (mabMacAddrDataCmp(pMacAddrInfo, pBest, 0) < 0)))
+      {
+        pBest = pMacAddrInfo;
+      }
+    }
+  }
+
+  if ((pMacAddrInfo = pBest) ==  NULLPTR)
   {
       /* release semaphore*/
-      (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
+      (void)osapiReadLockGive(mabBlock->mabMacAddrDBRWLock);
 
       MAB_EVENT_TRACE("\n%s: Could not find next node for supplicant mac address(%2.2x:%2.2x:%2.2x:%2.2x:%2.2x:%2.2x). \n",
                __FUNCTION__, mac_addr->addr[0],mac_addr->addr[1],mac_addr->addr[2],mac_addr->addr[3],mac_addr->addr[4],mac_addr->addr[5]);
@@ -395,7 +492,7 @@ RC_t mabMacAddrInfoFindNext( enetMacAddr_t *mac_addr,uint32 *lIntIfNum)
   *lIntIfNum = pMacAddrInfo->lIntIfNum;
 
   /* release semaphore*/
-  (void)osapiWriteLockGive(mabBlock->mabMacAddrDBRWLock);
+  (void)osapiReadLockGive(mabBlock->mabMacAddrDBRWLock);
 
   return  SUCCESS;
 }
@@ -121,6 +121,10 @@ RC_t mabRadiusResponseProcess(unsigned int lIntIfNum, void *resp)
 
   if (!(MAB_IS_READY))
     return  SUCCESS;
+
+  /* any response frees up a slot in the inflight window */
+  mabRadiusInflightRelease(lIntIfNum,  NULLPTR);
+
   logicalPortInfo = mabLogicalPortInfoGet(lIntIfNum);
   if (logicalPortInfo ==  NULLPTR)
   {
@@ -399,11 +403,11 @@ RC_t mabRadiusChallengeProcess(uint32 lIntIfNum, void *resp)
  * @returns    SUCCESS
  * @returns    FAILURE
  *
- * @comments
+ * @comments  Bypasses the inflight window, see mabRadiusAccessRequestSend
  *
  * @end
  *************************************************************************/
-RC_t mabRadiusAccessRequestSend(uint32 lIntIfNum,  uchar8 *suppEapData)
+static RC_t mabRadiusAccessRequestTransmit(uint32 lIntIfNum,  uchar8 *suppEapData)
 {
    authmgrEapPacket_t *eapPkt =  NULLPTR;
   RC_t rc;
@@ -471,7 +475,11 @@ RC_t mabRadiusAccessRequestSend(uint32 lIntIfNum,  uchar8 *suppEapData)
   }
 
   req = (access_req_info_t *)malloc(sizeof(access_req_info_t)); 
-  memset(req, 0, sizeof(req));
+  if (req ==  NULLPTR)
+  {
+    return  FAILURE;
+  }
+  memset(req, 0, sizeof(access_req_info_t));
 
   /* pack the reqired info to sent the access-req */
   req->user_name = logicalPortInfo->client.mabUserName;
@@ -572,6 +580,277 @@ req->correlator = lIntIfNum;
 }
 
 
+/* Access-requests towards the RADIUS client go through the throttle in
+ * mab_radius_window.c. A queued client has no server awhile timer
+ * running, the timer is started when its request is actually handed to
+ * the RADIUS client.
+ * All entry points run in the MAB task context.
+ */
+typedef struct mabRadiusPending_s
+{
+  mabRadiusWindowReq_t  req;          /* first */
+  uchar8               *suppEapData;  /* private copy, NULL if none */
+} mabRadiusPending_t;
+
+static mabRadiusWindow_t mabRadiusWindow = { .window = MAB_RADIUS_INFLIGHT_WINDOW_DEF };
+
+/**************************************************************************
+ * @purpose   Set the number of access-requests outstanding at a time
+ *
+ * @param     window  @b{(input)} inflight window, 0 restores the default
+ *
+ * @returns    SUCCESS
+ * @returns    FAILURE
+ *
+ * @comments  Shrinking the window does not drop outstanding requests,
+ *            new ones are held back until the count falls below it.
+ *
+ * @end
+ *************************************************************************/
+RC_t mabRadiusInflightWindowSet(uint32 window)
+{
+  if (mabRadiusWindowSet(&mabRadiusWindow, window) != 0)
+  {
+    return  FAILURE;
+  }
+  return  SUCCESS;
+}
+
+/**************************************************************************
+ * @purpose   Get the number of access-requests outstanding at a time
+ *
+ * @param     window  @b{(output)} inflight window
+ *
+ * @returns    SUCCESS
+ *
+ * @end
+ *************************************************************************/
+RC_t mabRadiusInflightWindowGet(uint32 *window)
+{
+  *window = mabRadiusWindow.window;
+  return  SUCCESS;
+}
+
+/**************************************************************************
+ * @purpose   Account an access-request as outstanding
+ *
+ * @param     lIntIfNum    @b{(input)} Logical internal interface number
+ * @param     suppMacAddr  @b{(input)} Supplicant MAC address
+ *
+ * @returns   none
+ *
+ * @comments  The slot is reclaimed if neither a response nor the server
+ *            awhile expiry releases it in time.
+ *
+ * @end
+ *************************************************************************/
+static void mabRadiusInflightAdd(uint32 lIntIfNum,  enetMacAddr_t *suppMacAddr)
+{
+  mabRadiusWindowInflightAdd(&mabRadiusWindow, lIntIfNum, suppMacAddr->addr,
+                             osapiUpTimeRaw() + (2 * FD_MAB_PORT_SERVER_TIMEOUT) +
+                             MAB_RADIUS_INFLIGHT_SLACK);
+}
+
+/**************************************************************************
+ * @purpose   Free a pending access-request
+ *
+ * @param     req  @b{(input)} pending request
+ *
+ * @returns   none
+ *
+ * @end
+ *************************************************************************/
+static void mabRadiusPendingFree(mabRadiusWindowReq_t *req)
+{
+  mabRadiusPending_t *node = (mabRadiusPending_t *)req;
+
+  if (node->suppEapData !=  NULLPTR)
+  {
+    free(node->suppEapData);
+  }
+  free(node);
+}
+
+/**************************************************************************
+ * @purpose   Send queued access-requests while the window allows
+ *
+ * @param     none
+ *
+ * @returns   none
+ *
+ * @comments  Requests of clients that went away or are no longer
+ *            authenticating while queued are dropped. The server awhile
+ *            timer of a client starts when its request is sent, so the
+ *            time spent queued is not charged to the server timeout.
+ *
+ * @end
+ *************************************************************************/
+static void mabRadiusPendingDispatch(void)
+{
+  mabRadiusPending_t *node;
+  mabLogicalPortInfo_t *logicalPortInfo;
+  uint32 expired;
+
+  expired = mabRadiusWindowExpire(&mabRadiusWindow, osapiUpTimeRaw());
+  if (expired != 0)
+  {
+    MAB_EVENT_TRACE("%s: reclaimed %u expired inflight access-reqs\n",
+                    __FUNCTION__, expired);
+  }
+
+  while ((node = (mabRadiusPending_t *)mabRadiusWindowDequeue(&mabRadiusWindow)) !=  NULLPTR)
+  {
+    logicalPortInfo = mabLogicalPortInfoGet(node->req.key);
+    if ((logicalPortInfo !=  NULLPTR) &&
+        (logicalPortInfo->protocol.mabAuthState == MAB_AUTHENTICATING) &&
+        (memcmp(logicalPortInfo->client.suppMacAddr.addr, node->req.mac,  ENET_MAC_ADDR_LEN) == 0))
+    {
+      if ((mabTimerStart(logicalPortInfo, MAB_SERVER_AWHILE) ==  SUCCESS) &&
+          (mabRadiusAccessRequestTransmit(node->req.key, node->suppEapData) ==  SUCCESS))
+      {
+        mabRadiusInflightAdd(node->req.key, &logicalPortInfo->client.suppMacAddr);
+      }
+      else
+      {
+        mabTimerDestroy(mabBlock->mabTimerCB, logicalPortInfo);
+        logicalPortInfo->protocol.authFail =  TRUE;
+        mabUnAuthenticatedAction(logicalPortInfo);
+      }
+    }
+
+    mabRadiusPendingFree(&node->req);
+  }
+}
+
+/**************************************************************************
+ * @purpose   Release the inflight slot and any queued request of a client
+ *
+ * @param     lIntIfNum    @b{(input)} Logical internal interface number,
+ *                                     0 to match on mac address only
+ * @param     suppMacAddr  @b{(input)} Supplicant MAC address, or NULL
+ *
+ * @returns   none
+ *
+ * @comments  Called when a response arrives, the server awhile timer
+ *            expires or the client is cleared. Frees up window space
+ *            and sends the next queued requests.
+ *
+ * @end
+ *************************************************************************/
+void mabRadiusInflightRelease(uint32 lIntIfNum,  enetMacAddr_t *suppMacAddr)
+{
+  mabRadiusWindowRelease(&mabRadiusWindow, lIntIfNum,
+                         (suppMacAddr !=  NULLPTR) ? suppMacAddr->addr :  NULLPTR,
+                         mabRadiusPendingFree);
+
+  mabRadiusPendingDispatch();
+}
+
+/**************************************************************************
+ * @purpose   Send or queue an Access Request to RADIUS client
+ *
+ * @param     lIntIfNum       @b{(input)} Logical interface number of port being authenticated
+ * @param     *suppEapData  @b{(input)} EAP info received from supplicant
+ *
+ * @returns    SUCCESS
+ * @returns    FAILURE
+ *
+ * @comments  When the inflight window is full the request is queued,
+ *            with a copy of the EAP data as the caller frees its buffer,
+ *            and the server awhile timer started by the caller is
+ *            stopped until the request is sent.
+ *
+ * @end
+ *************************************************************************/
+RC_t mabRadiusAccessRequestSend(uint32 lIntIfNum,  uchar8 *suppEapData)
+{
+  mabLogicalPortInfo_t *logicalPortInfo;
+  mabRadiusPending_t *node;
+  uint32 eapLen;
+
+  logicalPortInfo = mabLogicalPortInfoGet(lIntIfNum);
+  if (logicalPortInfo ==  NULLPTR)
+  {
+    return  FAILURE;
+  }
+
+  /* a new request supersedes whatever this client still had outstanding */
+  mabRadiusInflightRelease(lIntIfNum,  NULLPTR);
+
+  mabRadiusPendingDispatch();
+
+  if (mabRadiusWindowOpen(&mabRadiusWindow))
+  {
+    if (mabRadiusAccessRequestTransmit(lIntIfNum, suppEapData) !=  SUCCESS)
+    {
+      return  FAILURE;
+    }
+    mabRadiusInflightAdd(lIntIfNum, &logicalPortInfo->client.suppMacAddr);
+    return  SUCCESS;
+  }
+
+  node = (mabRadiusPending_t *)malloc(sizeof(mabRadiusPending_t));
+  if (node ==  NULLPTR)
+  {
+    return  FAILURE;
+  }
+
+  memset(node, 0, sizeof(mabRadiusPending_t));
+  node->req.key = lIntIfNum;
+  memcpy(node->req.mac, logicalPortInfo->client.suppMacAddr.addr,  ENET_MAC_ADDR_LEN);
+
+  if (suppEapData !=  NULLPTR)
+  {
+    eapLen = osapiNtohs((( authmgrEapPacket_t *)suppEapData)->length);
+    if (eapLen < sizeof( authmgrEapPacket_t))
+    {
+      eapLen = sizeof( authmgrEapPacket_t);
+    }
+    node->suppEapData = ( uchar8 *)malloc(eapLen);
+    if (node->suppEapData ==  NULLPTR)
+    {
+      free(node);
+      return  FAILURE;
+    }
+    memcpy(node->suppEapData, suppEapData, eapLen);
+  }
+
+  /* the server timeout only runs once the request is sent */
+  if ((logicalPortInfo->mabTimer.handle.timer !=  NULLPTR) &&
+      (logicalPortInfo->mabTimer.cxt.type == MAB_SERVER_AWHILE))
+  {
+    mabTimerDestroy(mabBlock->mabTimerCB, logicalPortInfo);
+  }
+
+  mabRadiusWindowEnqueue(&mabRadiusWindow, &node->req);
+
+  MAB_EVENT_TRACE("%s: inflight window full (%d), queued access-req for logical port %d\n",
+                  __FUNCTION__, mabRadiusWindow.window, lIntIfNum);
+  return  SUCCESS;
+}
+
+/*********************************************************************
+* @purpose  Print the RADIUS access-request throttle state
+*
+* @param
+*
+* @returns   SUCCESS
+*
+* @comments none
+*
+* @end
+*********************************************************************/
+RC_t mabDebugRadiusWindowShow(void)
+{
+  SYSAPI_PRINTF("\n Inflight window     : %u", mabRadiusWindow.window);
+  SYSAPI_PRINTF("\n Inflight requests   : %u", mabRadiusWindow.inflightCount);
+  SYSAPI_PRINTF("\n Queued requests     : %u (max %u)", mabRadiusWindow.pendCount, mabRadiusWindow.pendCountMax);
+  SYSAPI_PRINTF("\n Sent                : %u", mabRadiusWindow.sentCount);
+  SYSAPI_PRINTF("\n Queued total        : %u", mabRadiusWindow.queuedCount);
+  SYSAPI_PRINTF("\n Expired             : %u\n", mabRadiusWindow.expiredCount);
+  return  SUCCESS;
+}
+
 /**************************************************************************
  * @purpose   After client disconnected send clear RADIUS messages Request
  *            to RADIUS client
@@ -586,6 +865,8 @@ void mabRadiusClearRadiusMsgsSend( enetMacAddr_t suppMacAddr)
 {
   mab_radius_cmd_msg_t cmd_req;
 
+  mabRadiusInflightRelease(0, &suppMacAddr);
+
   memset(&cmd_req, 0, sizeof(cmd_req));
 
   strncpy(cmd_req.cmd, "clear-radius-msgs", strlen("clear-radius-msgs")+1);
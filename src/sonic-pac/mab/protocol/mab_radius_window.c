@@ -0,0 +1,194 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "mab_radius_window.h"
+
+/*************************************************************************
+ * @purpose  Check whether an entry belongs to a client
+ *
+ * @param    entKey  @b{(input)}  Key of the entry
+ * @param    entMac  @b{(input)}  MAC address of the entry
+ * @param    key     @b{(input)}  Logical interface, 0 to match on mac only
+ * @param    mac     @b{(input)}  Supplicant MAC address, or NULL
+ *
+ * @returns  1 on a match, else 0
+ *
+ * @end
+ *************************************************************************/
+static int mabRadiusWindowMatch(uint32_t entKey, const uint8_t *entMac,
+                                uint32_t key, const uint8_t *mac)
+{
+  if ((0 != key) && (entKey == key))
+  {
+    return 1;
+  }
+  if ((NULL != mac) && (0 == memcmp(entMac, mac, MAB_RADIUS_WINDOW_MAC_LEN)))
+  {
+    return 1;
+  }
+  return 0;
+}
+
+int mabRadiusWindowSet(mabRadiusWindow_t *win, uint32_t window)
+{
+  if (window > MAB_RADIUS_INFLIGHT_WINDOW_MAX)
+  {
+    return -1;
+  }
+
+  win->window = (0 == window) ? MAB_RADIUS_INFLIGHT_WINDOW_DEF : window;
+  return 0;
+}
+
+int mabRadiusWindowOpen(mabRadiusWindow_t *win)
+{
+  return ((win->inflightCount < win->window) && (NULL == win->pendHead));
+}
+
+void mabRadiusWindowInflightAdd(mabRadiusWindow_t *win, uint32_t key,
+                                const uint8_t *mac, uint32_t deadline)
+{
+  uint32_t i, freeIdx = MAB_RADIUS_INFLIGHT_WINDOW_MAX;
+
+  for (i = 0; i < MAB_RADIUS_INFLIGHT_WINDOW_MAX; i++)
+  {
+    if (win->inflight[i].key == key)
+    {
+      /* re-sent for the same client, e.g. EAP-MD5 after a challenge */
+      freeIdx = i;
+      break;
+    }
+    if ((0 == win->inflight[i].key) &&
+        (MAB_RADIUS_INFLIGHT_WINDOW_MAX == freeIdx))
+    {
+      freeIdx = i;
+    }
+  }
+
+  if (MAB_RADIUS_INFLIGHT_WINDOW_MAX == freeIdx)
+  {
+    return;
+  }
+
+  if (0 == win->inflight[freeIdx].key)
+  {
+    win->inflightCount++;
+  }
+  win->inflight[freeIdx].key = key;
+  memcpy(win->inflight[freeIdx].mac, mac, MAB_RADIUS_WINDOW_MAC_LEN);
+  win->inflight[freeIdx].deadline = deadline;
+  win->sentCount++;
+}
+
+uint32_t mabRadiusWindowExpire(mabRadiusWindow_t *win, uint32_t now)
+{
+  uint32_t i, expired = 0;
+
+  for (i = 0; i < MAB_RADIUS_INFLIGHT_WINDOW_MAX; i++)
+  {
+    if ((0 != win->inflight[i].key) &&
+        ((int32_t)(now - win->inflight[i].deadline) >= 0))
+    {
+      memset(&win->inflight[i], 0, sizeof(mabRadiusInflight_t));
+      win->inflightCount--;
+      expired++;
+    }
+  }
+  win->expiredCount += expired;
+  return expired;
+}
+
+void mabRadiusWindowEnqueue(mabRadiusWindow_t *win, mabRadiusWindowReq_t *req)
+{
+  req->next = NULL;
+  if (NULL == win->pendTail)
+  {
+    win->pendHead = req;
+  }
+  else
+  {
+    win->pendTail->next = req;
+  }
+  win->pendTail = req;
+  win->pendCount++;
+  win->queuedCount++;
+  if (win->pendCount > win->pendCountMax)
+  {
+    win->pendCountMax = win->pendCount;
+  }
+}
+
+mabRadiusWindowReq_t *mabRadiusWindowDequeue(mabRadiusWindow_t *win)
+{
+  mabRadiusWindowReq_t *req = win->pendHead;
+
+  if ((NULL == req) || (win->inflightCount >= win->window))
+  {
+    return NULL;
+  }
+
+  win->pendHead = req->next;
+  if (NULL == win->pendHead)
+  {
+    win->pendTail = NULL;
+  }
+  win->pendCount--;
+  req->next = NULL;
+  return req;
+}
+
+void mabRadiusWindowRelease(mabRadiusWindow_t *win, uint32_t key,
+                            const uint8_t *mac, mabRadiusWindowFreeFn_t freeFn)
+{
+  mabRadiusWindowReq_t *req, *prev = NULL, *next;
+  uint32_t i;
+
+  for (i = 0; i < MAB_RADIUS_INFLIGHT_WINDOW_MAX; i++)
+  {
+    if ((0 != win->inflight[i].key) &&
+        mabRadiusWindowMatch(win->inflight[i].key, win->inflight[i].mac, key, mac))
+    {
+      memset(&win->inflight[i], 0, sizeof(mabRadiusInflight_t));
+      win->inflightCount--;
+    }
+  }
+
+  for (req = win->pendHead; NULL != req; req = next)
+  {
+    next = req->next;
+    if (mabRadiusWindowMatch(req->key, req->mac, key, mac))
+    {
+      if (NULL == prev)
+      {
+        win->pendHead = next;
+      }
+      else
+      {
+        prev->next = next;
+      }
+      if (win->pendTail == req)
+      {
+        win->pendTail = prev;
+      }
+      win->pendCount--;
+      freeFn(req);
+      continue;
+    }
+    prev = req;
+  }
+}
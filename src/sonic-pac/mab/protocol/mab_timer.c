@@ -14,13 +14,20 @@
  * limitations under the License.
  */
 
+#include <time.h>
+#include <unistd.h>
 #include "mab_include.h"
 #include "mab_db.h"
 #include "mab_debug.h"
 #include "mab_struct.h"
+#include "mab_timer.h"
 
 extern mabBlock_t *mabBlock;
 
+/* Percentage of the server awhile timeout added at random, so clients
+   starting authentication together do not time out together */
+#define MAB_SERVER_AWHILE_JITTER   10
+
 /*************************************************************************
  * @purpose  function to process on expiry of server awhile timer 
  *
@@ -40,6 +47,7 @@ RC_t  mabServerAwhileExpiryAction(mabLogicalPortInfo_t *logicalPortInfo)
   MAB_IF_NULLPTR_RETURN_LOG(logicalPortInfo);
 
   /* Supp AWhile Timer has expired. */
+  mabRadiusInflightRelease(logicalPortInfo->key.keyNum,  NULLPTR);
   logicalPortInfo->protocol.authFail =  TRUE;
   mabUnAuthenticatedAction(logicalPortInfo);
   return  SUCCESS;
@@ -63,7 +71,7 @@ RC_t mabTimerHandlerInfoGet(mabTimerType_t type, mabTimerMap_t *elem)
   uint32 i = 0;
   static mabTimerMap_t mabTimerHandlerTable[] =
   { 
-    {MAB_SERVER_AWHILE, mabServerAwhileExpiryAction},
+    {MAB_SERVER_AWHILE, mabServerAwhileExpiryAction, MAB_SERVER_AWHILE_JITTER},
   };
 
 
@@ -132,9 +140,8 @@ void mabTimerExpiryAction(void *param)
       "MAB timer %s expired on logical port %d \r\n",
       mabTimerTypeStringGet(pNode->type), logicalPortInfo->key.keyNum);
 
-  /* Delete the apptimer node */
-  (void)appTimerDelete(mabBlock->mabTimerCB, logicalPortInfo->mabTimer.handle.timer);
-  /* Null out the timer Details */
+  /* The wheel has already unlinked the timer node, it is freed
+     once all expired timers are delivered */
   logicalPortInfo->mabTimer.handle.timer =  NULL;
 
   /* pass the event accoring to the timer type */
@@ -156,6 +163,165 @@ void mabTimerExpiryAction(void *param)
   return;
 }
 
+/*************************************************************************
+ * @purpose  Get a timer node, from the free list when available
+ *
+ * @returns  Timer node, NULLPTR on allocation failure
+ *
+ * @comments none
+ *
+ * @end
+ *************************************************************************/
+static mabTimerNode_t *mabTimerNodeAlloc(void)
+{
+  mabTimerWheel_t *wheel = &mabBlock->mabTimerWheel;
+  mabTimerNode_t *node = wheel->freeList;
+
+  if ( NULLPTR != node)
+  {
+    wheel->freeList = (mabTimerNode_t *)node->link.next;
+  }
+  else
+  {
+    node = (mabTimerNode_t *)osapiMalloc( MAB_COMPONENT_ID, sizeof(mabTimerNode_t));
+    if ( NULLPTR == node)
+    {
+      return  NULLPTR;
+    }
+  }
+
+  memset(node, 0, sizeof(mabTimerNode_t));
+  return node;
+}
+
+/*************************************************************************
+ * @purpose  Return a timer node to the free list
+ *
+ * @param    node  @b{(input)}  Timer node
+ *
+ * @returns  void
+ *
+ * @comments none
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerNodeFree(mabTimerNode_t *node)
+{
+  mabTimerWheel_t *wheel = &mabBlock->mabTimerWheel;
+
+  mabTimerWheelRemove(&wheel->base, &node->link);
+  node->link.next = (mabTimerWheelNode_t *)wheel->freeList;
+  wheel->freeList = node;
+}
+
+/*************************************************************************
+ * @purpose  Deliver an expired timer of the wheel
+ *
+ * @param    link  @b{(input)}  Wheel node of the timer
+ *
+ * @returns  void
+ *
+ * @comments none
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerNodeExpire(mabTimerWheelNode_t *link)
+{
+  mabTimerNode_t *node = (mabTimerNode_t *)link;
+
+  mabTimerExpiryAction(&node->cxt);
+  mabTimerNodeFree(node);
+}
+
+/*************************************************************************
+ * @purpose  Random part of a timeout
+ *
+ * @param    range  @b{(input)}  Upper bound, excluded
+ *
+ * @returns  Value in [0, range)
+ *
+ * @comments xorshift32 private to MAB, seeded on first use. rand() is
+ *           never seeded for it, and is reseeded elsewhere with the time.
+ *
+ * @end
+ *************************************************************************/
+static uint32 mabTimerJitterGet(uint32 range)
+{
+  mabTimerWheel_t *wheel = &mabBlock->mabTimerWheel;
+  uint32 x = wheel->jitterState;
+
+  if (x == 0)
+  {
+    x = (uint32)time(NULL) ^ ((uint32)getpid() << 16) ^ osapiUpTimeRaw();
+    if (x == 0)
+    {
+      x = 1;
+    }
+  }
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  wheel->jitterState = x;
+
+  return x % range;
+}
+
+/*************************************************************************
+ * @purpose  Arm the app timer driving the wheel
+ *
+ * @returns  void
+ *
+ * @comments Only one app timer is running, whatever the number of
+ *           client timers on the wheel.
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerWheelTickStart(void)
+{
+  mabTimerWheel_t *wheel = &mabBlock->mabTimerWheel;
+
+  if ( NULLPTR != wheel->tickTimer)
+  {
+    return;
+  }
+
+  wheel->tickTimer = appTimerAdd(mabBlock->mabTimerCB, mabTimerWheelTickAction,
+                                  NULLPTR, 1, "MabTimerWheel");
+  if ( NULLPTR == wheel->tickTimer)
+  {
+     LOGF( LOG_SEVERITY_WARNING,
+        "mabTimerWheelTickStart: Could not start the timer wheel tick.");
+  }
+}
+
+/*************************************************************************
+ * @purpose  Process the timer wheel tick
+ *
+ * @param    param  @b{(input)}  unused
+ *
+ * @returns  void
+ *
+ * @comments Runs on the app timer expiry, rearmed while any client timer
+ *           is running.
+ *
+ * @end
+ *************************************************************************/
+void mabTimerWheelTickAction(void *param)
+{
+  mabTimerWheel_t *wheel = &mabBlock->mabTimerWheel;
+
+  (void)appTimerDelete(mabBlock->mabTimerCB, wheel->tickTimer);
+  wheel->tickTimer =  NULLPTR;
+
+  mabTimerWheelAdvance(&wheel->base, osapiUpTimeRaw(), mabTimerNodeExpire);
+
+  if (wheel->base.count != 0)
+  {
+    mabTimerWheelTickStart();
+  }
+}
+
 /*************************************************************************
  * @purpose  Starts the specified timer
  *
@@ -173,6 +339,8 @@ RC_t mabTimerStart(mabLogicalPortInfo_t *logicalPortInfo, mabTimerType_t timerTy
 {
   uint32 physPort = 0, lPort = 0, type = 0, val = 0;
   mabTimerMap_t entry;
+  mabTimerWheel_t *wheel;
+  mabTimerNode_t *node;
 
   memset(&entry, 0, sizeof(mabTimerMap_t));
 
@@ -208,14 +376,24 @@ RC_t mabTimerStart(mabLogicalPortInfo_t *logicalPortInfo, mabTimerType_t timerTy
 
   /* Timer value should be multipled by 2 to match the retries in hostapd. */
   val = (2 * FD_MAB_PORT_SERVER_TIMEOUT);
+  if (entry.jitter != 0)
+  {
+    val += mabTimerJitterGet((val * entry.jitter / 100) + 1);
+  }
 
   /* fill the timer context */
   logicalPortInfo->mabTimer.cxt.type = timerType;
   logicalPortInfo->mabTimer.cxt.keyNum = logicalPortInfo->key.keyNum;
 
+  wheel = &mabBlock->mabTimerWheel;
+  if (wheel->base.count == 0)
+  {
+    /* Idle wheel, catch up with the current time */
+    mabTimerWheelAdvance(&wheel->base, osapiUpTimeRaw(), mabTimerNodeExpire);
+  }
+
  /* Start the timer */
-  logicalPortInfo->mabTimer.handle.timer = appTimerAdd(mabBlock->mabTimerCB, mabTimerExpiryAction,
-      (void *)&logicalPortInfo->mabTimer.cxt, val, mabTimerTypeStringGet(timerType));
+  logicalPortInfo->mabTimer.handle.timer = mabTimerNodeAlloc();
 
   if(logicalPortInfo->mabTimer.handle.timer ==  NULLPTR)
   {
@@ -227,6 +405,12 @@ RC_t mabTimerStart(mabLogicalPortInfo_t *logicalPortInfo, mabTimerType_t timerTy
     return  FAILURE;
   }
 
+  node = logicalPortInfo->mabTimer.handle.timer;
+  node->cxt = logicalPortInfo->mabTimer.cxt;
+  mabTimerWheelAdd(&wheel->base, &node->link, val);
+
+  mabTimerWheelTickStart();
+
   return  SUCCESS;
 }
 
@@ -252,10 +436,10 @@ RC_t  mabTimerDestroy( APP_TMR_CTRL_BLK_t timerCB,
 
   MAB_LPORT_KEY_UNPACK(physPort, lPort, type, logicalPortInfo->key.keyNum);
 
-  /* Delete the apptimer node */
+  /* Take the timer node off the wheel */
   if ( NULL != logicalPortInfo->mabTimer.handle.timer)
   {
-    (void)appTimerDelete(timerCB, logicalPortInfo->mabTimer.handle.timer);
+    mabTimerNodeFree(logicalPortInfo->mabTimer.handle.timer);
     logicalPortInfo->mabTimer.handle.timer =  NULL;
 
     MAB_EVENT_TRACE( "deleted the timer type %s"
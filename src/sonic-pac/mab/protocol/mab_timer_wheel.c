@@ -0,0 +1,200 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include "mab_timer_wheel.h"
+
+/*************************************************************************
+ * @purpose  Link a timer node at the head of a wheel list
+ *
+ * @param    head  @b{(input)}  List head
+ * @param    node  @b{(input)}  Timer node
+ *
+ * @returns  void
+ *
+ * @comments none
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerWheelNodeLink(mabTimerWheelNode_t **head, mabTimerWheelNode_t *node)
+{
+  node->next = *head;
+  if (NULL != node->next)
+  {
+    node->next->pprev = &node->next;
+  }
+  node->pprev = head;
+  *head = node;
+}
+
+/*************************************************************************
+ * @purpose  Unlink a timer node from the wheel list it is on
+ *
+ * @param    node  @b{(input)}  Timer node
+ *
+ * @returns  void
+ *
+ * @comments O(1), the node may be on a wheel slot or on the expired list
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerWheelNodeUnlink(mabTimerWheelNode_t *node)
+{
+  if (NULL == node->pprev)
+  {
+    return;
+  }
+
+  *node->pprev = node->next;
+  if (NULL != node->next)
+  {
+    node->next->pprev = node->pprev;
+  }
+  node->next = NULL;
+  node->pprev = NULL;
+}
+
+/*************************************************************************
+ * @purpose  Place a timer node in the wheel slot for its expiry
+ *
+ * @param    wheel  @b{(input)}  Timer wheel
+ * @param    node   @b{(input)}  Timer node
+ *
+ * @returns  void
+ *
+ * @comments Level n holds the timers expiring within
+ *           MAB_TIMER_WHEEL_SLOTS^(n+1) ticks, they are cascaded to the
+ *           lower levels as the wheel turns.
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerWheelInsert(mabTimerWheelBase_t *wheel, mabTimerWheelNode_t *node)
+{
+  uint32_t delta, level, slot;
+
+  if ((int32_t)(node->expiry - wheel->now) < 0)
+  {
+    node->expiry = wheel->now;
+  }
+  delta = node->expiry - wheel->now;
+
+  for (level = 0; level < (MAB_TIMER_WHEEL_LEVELS - 1); level++)
+  {
+    if (delta < (1U << ((level + 1) * MAB_TIMER_WHEEL_BITS)))
+    {
+      break;
+    }
+  }
+
+  slot = (node->expiry >> (level * MAB_TIMER_WHEEL_BITS)) & MAB_TIMER_WHEEL_MASK;
+  mabTimerWheelNodeLink(&wheel->slots[level][slot], node);
+}
+
+/*************************************************************************
+ * @purpose  Move the timers of a wheel slot down to the lower levels
+ *
+ * @param    wheel  @b{(input)}  Timer wheel
+ * @param    level  @b{(input)}  Level of the slot
+ * @param    slot   @b{(input)}  Slot index
+ *
+ * @returns  void
+ *
+ * @comments none
+ *
+ * @end
+ *************************************************************************/
+static void mabTimerWheelCascade(mabTimerWheelBase_t *wheel, uint32_t level, uint32_t slot)
+{
+  mabTimerWheelNode_t *node;
+
+  while (NULL != (node = wheel->slots[level][slot]))
+  {
+    mabTimerWheelNodeUnlink(node);
+    mabTimerWheelInsert(wheel, node);
+  }
+}
+
+void mabTimerWheelAdd(mabTimerWheelBase_t *wheel, mabTimerWheelNode_t *node,
+                      uint32_t timeout)
+{
+  /* Clamp before adding, a huge timeout would otherwise wrap into the past */
+  if (timeout > MAB_TIMER_WHEEL_MAX_TICKS)
+  {
+    timeout = MAB_TIMER_WHEEL_MAX_TICKS;
+  }
+
+  /* wheel->now is the next tick to process, so the timer never fires early */
+  node->expiry = wheel->now + timeout;
+  mabTimerWheelInsert(wheel, node);
+  wheel->count++;
+}
+
+void mabTimerWheelRemove(mabTimerWheelBase_t *wheel, mabTimerWheelNode_t *node)
+{
+  if (NULL == node->pprev)
+  {
+    return;
+  }
+
+  mabTimerWheelNodeUnlink(node);
+  wheel->count--;
+}
+
+void mabTimerWheelAdvance(mabTimerWheelBase_t *wheel, uint32_t now,
+                          mabTimerWheelExpiryFn_t expiryFn)
+{
+  mabTimerWheelNode_t *node;
+  uint32_t slot, level;
+
+  if ((wheel->count == 0) || !wheel->started)
+  {
+    wheel->now = now + 1;
+    wheel->started = 1;
+    return;
+  }
+
+  while ((int32_t)(now - wheel->now) >= 0)
+  {
+    slot = wheel->now & MAB_TIMER_WHEEL_MASK;
+    if (slot == 0)
+    {
+      for (level = 1; level < MAB_TIMER_WHEEL_LEVELS; level++)
+      {
+        slot = (wheel->now >> (level * MAB_TIMER_WHEEL_BITS)) & MAB_TIMER_WHEEL_MASK;
+        mabTimerWheelCascade(wheel, level, slot);
+        if (slot != 0)
+        {
+          break;
+        }
+      }
+      slot = 0;
+    }
+
+    while (NULL != (node = wheel->slots[0][slot]))
+    {
+      mabTimerWheelNodeUnlink(node);
+      mabTimerWheelNodeLink(&wheel->expired, node);
+    }
+    wheel->now++;
+  }
+
+  while (NULL != (node = wheel->expired))
+  {
+    mabTimerWheelNodeUnlink(node);
+    wheel->count--;
+    expiryFn(node);
+  }
+}
@@ -0,0 +1,339 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Supplicant MAC database UT, 10K clients through the mab_mac_db API */
+
+#include <stdlib.h>
+#include "mab_include.h"
+#include "mab_struct.h"
+
+#define TEST_MACS   10000
+
+static mabBlock_t block;
+mabBlock_t *mabBlock = &block;
+
+static enetMacAddr_t macs[TEST_MACS];
+static uint32 ports[TEST_MACS];
+static int failures;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+/* Buffer pool, a bounded malloc so exhaustion is observable */
+static uint32 poolSize, poolBufs, poolUsed;
+
+RC_t bufferPoolInit(uint32 compId, uint32 num_bufs, uint32 buf_size,
+                    char *descr, uint32 *buffer_pool_id)
+{
+  poolSize = buf_size;
+  poolBufs = num_bufs;
+  poolUsed = 0;
+  *buffer_pool_id = 1;
+  return SUCCESS;
+}
+
+RC_t bufferPoolAllocate(uint32 buffer_pool_id, uchar8 **buffer_addr)
+{
+  if ((1 != buffer_pool_id) || (poolUsed >= poolBufs))
+  {
+    return FAILURE;
+  }
+  *buffer_addr = malloc(poolSize);
+  poolUsed++;
+  return SUCCESS;
+}
+
+void bufferPoolFree(uint32 buffer_pool_id, uchar8 *buffer_addr)
+{
+  CHECK(poolUsed > 0);
+  poolUsed--;
+  free(buffer_addr);
+}
+
+RC_t bufferPoolDelete(uint32 buffer_pool_id)
+{
+  CHECK(0 == poolUsed);
+  poolBufs = 0;
+  return SUCCESS;
+}
+
+void *osapiMalloc(uint32 compId, uint32 size)
+{
+  return malloc(size);
+}
+
+void osapiFree(uint32 compId, void *ptr)
+{
+  free(ptr);
+}
+
+/* Locks, single threaded, only check that every take is given back */
+static int readers, writers;
+
+RC_t osapiRWLockCreate(osapiRWLock_t *rwlock, int options)
+{
+  *rwlock = &block;
+  return SUCCESS;
+}
+
+RC_t osapiRWLockDelete(osapiRWLock_t rwlock)
+{
+  return SUCCESS;
+}
+
+RC_t osapiReadLockTake(osapiRWLock_t rwlock, int32 timeout)
+{
+  CHECK(0 == writers);
+  readers++;
+  return SUCCESS;
+}
+
+RC_t osapiReadLockGive(osapiRWLock_t rwlock)
+{
+  readers--;
+  return SUCCESS;
+}
+
+RC_t osapiWriteLockTake(osapiRWLock_t rwlock, int32 timeout)
+{
+  CHECK((0 == writers) && (0 == readers));
+  writers++;
+  return SUCCESS;
+}
+
+RC_t osapiWriteLockGive(osapiRWLock_t rwlock)
+{
+  writers--;
+  return SUCCESS;
+}
+
+static uint32 testRand(void)
+{
+  static uint32 seed = 12345;
+
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static uint32 testPort(uint32 phys, uint32 lport)
+{
+  return (phys << 16) | (lport << 4);
+}
+
+/* Distinct macs, the index sits in the low bytes and the rest is random,
+ * a share of them in one OUI like a rack of the same vendor's NICs.
+ */
+static void testMacsInit(void)
+{
+  uint32 i, r;
+
+  for (i = 0; i < TEST_MACS; i++)
+  {
+    r = testRand();
+    macs[i].addr[0] = (i % 4) ? 0x00 : (uchar8)(r & 0xfe);
+    macs[i].addr[1] = (i % 4) ? 0x1b : (uchar8)(r >> 8);
+    macs[i].addr[2] = (i % 4) ? 0x21 : (uchar8)(r >> 16);
+    macs[i].addr[3] = (uchar8)testRand();
+    macs[i].addr[4] = (uchar8)(i >> 8);
+    macs[i].addr[5] = (uchar8)i;
+    ports[i] = testPort(1 + (i % 48), i % 64);
+  }
+}
+
+static int testMacCmp(const enetMacAddr_t *a, const enetMacAddr_t *b)
+{
+  return memcmp(a->addr, b->addr, ENET_MAC_ADDR_LEN);
+}
+
+/* Walk with FindNext from the null mac, every step must ascend and
+ * return the port the table holds for that mac.
+ */
+static uint32 testWalk(const char *present)
+{
+  enetMacAddr_t mac, prev;
+  uint32 lIntIfNum, port, seen = 0;
+  int i;
+
+  memset(&mac, 0, sizeof(mac));
+  while (SUCCESS == mabMacAddrInfoFindNext(&mac, &lIntIfNum))
+  {
+    if (seen)
+    {
+      CHECK(testMacCmp(&prev, &mac) < 0);
+    }
+    CHECK(SUCCESS == mabMacAddrInfoFind(&mac, &port));
+    CHECK(port == lIntIfNum);
+    prev = mac;
+    seen++;
+  }
+  CHECK(MAB_LOGICAL_PORT_ITERATE == lIntIfNum);
+
+  for (i = 0, port = 0; i < TEST_MACS; i++)
+  {
+    port += present[i] ? 1 : 0;
+  }
+  CHECK(seen == port);
+  CHECK(0 == readers);
+  return seen;
+}
+
+static void testInsertFind(char *present)
+{
+  enetMacAddr_t extra;
+  uint32 lIntIfNum;
+  int i;
+
+  CHECK(SUCCESS == mabMacAddrInfoDBInit(TEST_MACS));
+  CHECK(mabBlock->mabMacAddrHashMask + 1 >= TEST_MACS);
+  CHECK(0 == mabBlock->mabMacAddrCount);
+
+  for (i = 0; i < TEST_MACS; i++)
+  {
+    CHECK(SUCCESS == mabMacAddrInfoAdd(&macs[i], ports[i]));
+    present[i] = 1;
+  }
+  CHECK(TEST_MACS == mabBlock->mabMacAddrCount);
+  CHECK(TEST_MACS == poolUsed);
+
+  for (i = 0; i < TEST_MACS; i++)
+  {
+    CHECK(SUCCESS == mabMacAddrInfoFind(&macs[i], &lIntIfNum));
+    CHECK(ports[i] == lIntIfNum);
+  }
+
+  /* The pool is sized for nodeCount, one more new mac does not fit */
+  memset(&extra, 0, sizeof(extra));
+  extra.addr[0] = 0x02;
+  extra.addr[5] = 0x01;
+  CHECK(FAILURE == mabMacAddrInfoAdd(&extra, ports[0]));
+  CHECK(FAILURE == mabMacAddrInfoFind(&extra, &lIntIfNum));
+  CHECK(MAB_LOGICAL_PORT_ITERATE == lIntIfNum);
+  CHECK(TEST_MACS == mabBlock->mabMacAddrCount);
+
+  /* Null mac and the iterate port are rejected */
+  memset(&extra, 0, sizeof(extra));
+  CHECK(FAILURE == mabMacAddrInfoAdd(&extra, ports[0]));
+  CHECK(FAILURE == mabMacAddrInfoAdd(&macs[0], MAB_LOGICAL_PORT_ITERATE));
+  CHECK(FAILURE == mabMacAddrInfoFind(&extra, &lIntIfNum));
+  CHECK(FAILURE == mabMacAddrInfoRemove(&extra));
+  CHECK(FAILURE == mabMacAddrInfoRemove(NULLPTR));
+  CHECK((0 == writers) && (0 == readers));
+}
+
+/* A roaming client is added again on its new port, the node moves */
+static void testMove(void)
+{
+  uint32 lIntIfNum;
+  int i;
+
+  for (i = 0; i < TEST_MACS; i += 3)
+  {
+    ports[i] = testPort(49 + (i % 4), i % 64);
+    CHECK(SUCCESS == mabMacAddrInfoAdd(&macs[i], ports[i]));
+  }
+  CHECK(TEST_MACS == mabBlock->mabMacAddrCount);
+  CHECK(TEST_MACS == poolUsed);
+
+  for (i = 0; i < TEST_MACS; i++)
+  {
+    CHECK(SUCCESS == mabMacAddrInfoFind(&macs[i], &lIntIfNum));
+    CHECK(ports[i] == lIntIfNum);
+  }
+}
+
+static void testDelete(char *present)
+{
+  uint32 lIntIfNum, count = TEST_MACS;
+  int i;
+
+  for (i = 1; i < TEST_MACS; i += 2)
+  {
+    CHECK(SUCCESS == mabMacAddrInfoRemove(&macs[i]));
+    CHECK(FAILURE == mabMacAddrInfoRemove(&macs[i]));
+    present[i] = 0;
+    count--;
+  }
+  CHECK(count == mabBlock->mabMacAddrCount);
+  CHECK(count == poolUsed);
+
+  for (i = 0; i < TEST_MACS; i++)
+  {
+    if (present[i])
+    {
+      CHECK(SUCCESS == mabMacAddrInfoFind(&macs[i], &lIntIfNum));
+      CHECK(ports[i] == lIntIfNum);
+    }
+    else
+    {
+      CHECK(FAILURE == mabMacAddrInfoFind(&macs[i], &lIntIfNum));
+    }
+  }
+  CHECK(count == testWalk(present));
+
+  /* Freed nodes are reusable, deleted macs come back */
+  for (i = 1; i < TEST_MACS; i += 4)
+  {
+    CHECK(SUCCESS == mabMacAddrInfoAdd(&macs[i], ports[i]));
+    present[i] = 1;
+    count++;
+  }
+  CHECK(count == mabBlock->mabMacAddrCount);
+  CHECK(count == testWalk(present));
+
+  for (i = 0; i < TEST_MACS; i++)
+  {
+    if (present[i])
+    {
+      CHECK(SUCCESS == mabMacAddrInfoRemove(&macs[i]));
+      present[i] = 0;
+    }
+  }
+  CHECK(0 == mabBlock->mabMacAddrCount);
+  CHECK(0 == poolUsed);
+  CHECK(0 == testWalk(present));
+}
+
+int main(void)
+{
+  static char present[TEST_MACS];
+
+  testMacsInit();
+  testInsertFind(present);
+  CHECK(TEST_MACS == testWalk(present));
+  testMove();
+  CHECK(TEST_MACS == testWalk(present));
+  testDelete(present);
+
+  /* DeInit releases what is still in the table */
+  CHECK(SUCCESS == mabMacAddrInfoAdd(&macs[0], ports[0]));
+  CHECK(SUCCESS == mabMacAddrInfoDBDeInit());
+  CHECK(0 == poolUsed);
+  CHECK(NULLPTR == mabBlock->mabMacAddrHashTbl);
+
+  if (failures)
+  {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("mab mac db: all tests passed\n");
+  return 0;
+}
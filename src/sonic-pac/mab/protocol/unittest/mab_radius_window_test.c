@@ -0,0 +1,419 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* RADIUS access-request throttle UT, window, queue and slot expiry,
+ * driven by a virtual clock */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mab_radius_window.h"
+
+#define TEST_CLIENTS  1024
+#define TEST_TIMEOUT  35    /* 2 * server timeout + slack */
+
+typedef struct testReq_s
+{
+  mabRadiusWindowReq_t req;       /* first */
+  int                  seq;
+}testReq_t;
+
+static mabRadiusWindow_t win;
+static int freed;
+static int failures;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static void testFree(mabRadiusWindowReq_t *req)
+{
+  freed++;
+  free(req);
+}
+
+static void testMac(uint32_t key, uint8_t *mac)
+{
+  mac[0] = 0x00;
+  mac[1] = 0x1b;
+  mac[2] = 0x21;
+  mac[3] = (uint8_t)(key >> 16);
+  mac[4] = (uint8_t)(key >> 8);
+  mac[5] = (uint8_t)key;
+}
+
+static void testAdd(uint32_t key, uint32_t deadline)
+{
+  uint8_t mac[MAB_RADIUS_WINDOW_MAC_LEN];
+
+  testMac(key, mac);
+  mabRadiusWindowInflightAdd(&win, key, mac, deadline);
+}
+
+static testReq_t *testQueue(uint32_t key, int seq)
+{
+  testReq_t *t = calloc(1, sizeof(*t));
+
+  t->req.key = key;
+  testMac(key, t->req.mac);
+  t->seq = seq;
+  mabRadiusWindowEnqueue(&win, &t->req);
+  return t;
+}
+
+/* Counters must agree with the slots and the queue */
+static void testConsistent(void)
+{
+  mabRadiusWindowReq_t *req, *last = NULL;
+  uint32_t i, used = 0, queued = 0;
+
+  for (i = 0; i < MAB_RADIUS_INFLIGHT_WINDOW_MAX; i++)
+  {
+    used += (0 != win.inflight[i].key) ? 1 : 0;
+  }
+  for (req = win.pendHead; NULL != req; req = req->next)
+  {
+    queued++;
+    last = req;
+  }
+  CHECK(used == win.inflightCount);
+  CHECK(queued == win.pendCount);
+  CHECK(last == win.pendTail);
+  CHECK(win.pendCount <= win.pendCountMax);
+}
+
+static void testReset(uint32_t window)
+{
+  memset(&win, 0, sizeof(win));
+  CHECK(0 == mabRadiusWindowSet(&win, window));
+  freed = 0;
+}
+
+static void testWindowSet(void)
+{
+  testReset(0);
+  CHECK(MAB_RADIUS_INFLIGHT_WINDOW_DEF == win.window);
+  CHECK(0 == mabRadiusWindowSet(&win, MAB_RADIUS_INFLIGHT_WINDOW_MAX));
+  CHECK(MAB_RADIUS_INFLIGHT_WINDOW_MAX == win.window);
+  CHECK(-1 == mabRadiusWindowSet(&win, MAB_RADIUS_INFLIGHT_WINDOW_MAX + 1));
+  CHECK(MAB_RADIUS_INFLIGHT_WINDOW_MAX == win.window);
+}
+
+/* Requests beyond the window wait in arrival order */
+static void testQueueOrder(void)
+{
+  mabRadiusWindowReq_t *req;
+  uint32_t key;
+  int seq;
+
+  testReset(4);
+  for (key = 1; key <= 4; key++)
+  {
+    CHECK(mabRadiusWindowOpen(&win));
+    testAdd(key, 100);
+  }
+  CHECK(!mabRadiusWindowOpen(&win));
+  CHECK(4 == win.sentCount);
+
+  for (key = 5; key <= 14; key++)
+  {
+    testQueue(key, key);
+  }
+  CHECK(10 == win.pendCount);
+  CHECK(NULL == mabRadiusWindowDequeue(&win));
+  testConsistent();
+
+  /* each response lets exactly one queued request through, oldest first */
+  for (key = 1, seq = 5; seq <= 14; key++, seq++)
+  {
+    mabRadiusWindowRelease(&win, key, NULL, testFree);
+    req = mabRadiusWindowDequeue(&win);
+    CHECK((NULL != req) && (seq == ((testReq_t *)req)->seq));
+    if (NULL != req)
+    {
+      mabRadiusWindowInflightAdd(&win, req->key, req->mac, 100);
+      free(req);
+    }
+    CHECK(NULL == mabRadiusWindowDequeue(&win));
+    testConsistent();
+  }
+  CHECK(0 == win.pendCount);
+  CHECK(4 == win.inflightCount);
+  CHECK(10 == win.queuedCount);
+  CHECK(10 == win.pendCountMax);
+  CHECK(0 == freed);
+
+  /* the queue is empty but the window is full */
+  CHECK(!mabRadiusWindowOpen(&win));
+  mabRadiusWindowRelease(&win, 14, NULL, testFree);
+  CHECK(mabRadiusWindowOpen(&win));
+}
+
+/* Release by key or by mac, from the window and from the queue */
+static void testRelease(void)
+{
+  uint8_t mac[MAB_RADIUS_WINDOW_MAC_LEN];
+  testReq_t *t;
+
+  testReset(2);
+  testAdd(1, 100);
+  testAdd(2, 100);
+  testQueue(3, 3);
+  testQueue(4, 4);
+  testQueue(5, 5);
+
+  /* a cleared client goes by mac only */
+  testMac(2, mac);
+  mabRadiusWindowRelease(&win, 0, mac, testFree);
+  CHECK(1 == win.inflightCount);
+  CHECK(0 == freed);
+
+  /* the tail leaves the queue, the next enqueue still links behind */
+  testMac(5, mac);
+  mabRadiusWindowRelease(&win, 0, mac, testFree);
+  CHECK(1 == freed);
+  CHECK(2 == win.pendCount);
+  testConsistent();
+  t = testQueue(6, 6);
+  CHECK(&t->req == win.pendTail);
+  testConsistent();
+
+  /* the head leaves the queue */
+  mabRadiusWindowRelease(&win, 3, NULL, testFree);
+  CHECK(2 == freed);
+  CHECK(4 == ((testReq_t *)win.pendHead)->seq);
+  testConsistent();
+
+  /* key 0 with no mac matches nothing */
+  mabRadiusWindowRelease(&win, 0, NULL, testFree);
+  CHECK(2 == freed);
+  CHECK(1 == win.inflightCount);
+  CHECK(2 == win.pendCount);
+
+  mabRadiusWindowRelease(&win, 4, NULL, testFree);
+  mabRadiusWindowRelease(&win, 6, NULL, testFree);
+  mabRadiusWindowRelease(&win, 1, NULL, testFree);
+  CHECK(4 == freed);
+  CHECK(0 == win.inflightCount);
+  CHECK((NULL == win.pendHead) && (NULL == win.pendTail));
+}
+
+/* A request re-sent for the same client keeps one slot */
+static void testResend(void)
+{
+  uint32_t i;
+
+  testReset(2);
+  testAdd(7, 100);
+  testAdd(7, 200);
+  CHECK(1 == win.inflightCount);
+  CHECK(2 == win.sentCount);
+  for (i = 0; i < MAB_RADIUS_INFLIGHT_WINDOW_MAX; i++)
+  {
+    if (7 == win.inflight[i].key)
+    {
+      CHECK(200 == win.inflight[i].deadline);
+    }
+  }
+  CHECK(0 == mabRadiusWindowExpire(&win, 199));
+  CHECK(1 == mabRadiusWindowExpire(&win, 200));
+  CHECK(0 == win.inflightCount);
+}
+
+/* Unanswered slots are reclaimed at their deadline, across the wrap */
+static void testExpire(uint32_t start)
+{
+  uint32_t key;
+
+  testReset(8);
+  for (key = 1; key <= 8; key++)
+  {
+    testAdd(key, start + TEST_TIMEOUT + key);
+  }
+  CHECK(!mabRadiusWindowOpen(&win));
+
+  CHECK(0 == mabRadiusWindowExpire(&win, start));
+  CHECK(0 == mabRadiusWindowExpire(&win, start + TEST_TIMEOUT));
+  CHECK(1 == mabRadiusWindowExpire(&win, start + TEST_TIMEOUT + 1));
+  CHECK(mabRadiusWindowOpen(&win));
+  CHECK(3 == mabRadiusWindowExpire(&win, start + TEST_TIMEOUT + 4));
+  CHECK(4 == win.inflightCount);
+  /* a clock jump reclaims everything that is due, once */
+  CHECK(4 == mabRadiusWindowExpire(&win, start + 10 * TEST_TIMEOUT));
+  CHECK(0 == mabRadiusWindowExpire(&win, start + 10 * TEST_TIMEOUT));
+  CHECK(8 == win.expiredCount);
+  testConsistent();
+}
+
+/* Shrinking the window keeps outstanding requests */
+static void testShrink(void)
+{
+  mabRadiusWindowReq_t *req;
+  uint32_t key;
+
+  testReset(8);
+  for (key = 1; key <= 8; key++)
+  {
+    testAdd(key, 100);
+  }
+  testQueue(9, 9);
+  CHECK(0 == mabRadiusWindowSet(&win, 4));
+  CHECK(8 == win.inflightCount);
+
+  for (key = 1; key <= 4; key++)
+  {
+    CHECK(NULL == mabRadiusWindowDequeue(&win));
+    mabRadiusWindowRelease(&win, key, NULL, testFree);
+  }
+  CHECK(4 == win.inflightCount);
+  CHECK(NULL == mabRadiusWindowDequeue(&win));
+  mabRadiusWindowRelease(&win, 5, NULL, testFree);
+  req = mabRadiusWindowDequeue(&win);
+  CHECK((NULL != req) && (9 == req->key));
+  CHECK(0 == win.pendCount);
+  free(req);
+}
+
+/* The window never goes past the identifier space */
+static void testIdSpace(void)
+{
+  uint32_t key;
+
+  testReset(MAB_RADIUS_INFLIGHT_WINDOW_MAX);
+  for (key = 1; key <= MAB_RADIUS_INFLIGHT_WINDOW_MAX; key++)
+  {
+    CHECK(mabRadiusWindowOpen(&win));
+    testAdd(key, 100);
+  }
+  CHECK(!mabRadiusWindowOpen(&win));
+  testAdd(MAB_RADIUS_INFLIGHT_WINDOW_MAX + 1, 100);
+  CHECK(MAB_RADIUS_INFLIGHT_WINDOW_MAX == win.inflightCount);
+  CHECK(MAB_RADIUS_INFLIGHT_WINDOW_MAX == win.sentCount);
+  testConsistent();
+}
+
+/* Random arrivals, responses, clears and timeouts on a virtual clock.
+ * Requests must leave the queue in arrival order, never more than the
+ * window may be outstanding, and every request ends up sent or freed.
+ */
+static void testRandom(uint32_t seed, uint32_t start)
+{
+  static uint32_t state[TEST_CLIENTS]; /* 0 idle, 1 queued, 2 inflight */
+  mabRadiusWindowReq_t *req;
+  uint8_t mac[MAB_RADIUS_WINDOW_MAC_LEN];
+  uint32_t now = start, key, i, queued = 0, sent = 0, dequeued = 0;
+  int seq = 0, lastSeq = 0;
+
+  testReset(16);
+  memset(state, 0, sizeof(state));
+  srand(seed);
+
+  for (i = 0; i < 200000; i++)
+  {
+    key = 1 + rand() % (TEST_CLIENTS - 1);
+    switch (rand() % 4)
+    {
+      case 0:  /* new request, supersedes what the client had */
+      case 1:
+        mabRadiusWindowRelease(&win, key, NULL, testFree);
+        if (mabRadiusWindowOpen(&win))
+        {
+          testAdd(key, now + TEST_TIMEOUT);
+          state[key] = 2;
+          sent++;
+        }
+        else
+        {
+          testQueue(key, ++seq);
+          state[key] = 1;
+          queued++;
+        }
+        break;
+      case 2:  /* response or server awhile expiry */
+        mabRadiusWindowRelease(&win, key, NULL, testFree);
+        state[key] = 0;
+        break;
+      default: /* client cleared */
+        testMac(key, mac);
+        mabRadiusWindowRelease(&win, 0, mac, testFree);
+        state[key] = 0;
+        break;
+    }
+
+    if (0 == (rand() % 64))
+    {
+      now += 1 + rand() % 8;
+    }
+    mabRadiusWindowExpire(&win, now);
+
+    while (NULL != (req = mabRadiusWindowDequeue(&win)))
+    {
+      CHECK(((testReq_t *)req)->seq > lastSeq);
+      lastSeq = ((testReq_t *)req)->seq;
+      CHECK(1 == state[req->key]);
+      mabRadiusWindowInflightAdd(&win, req->key, req->mac, now + TEST_TIMEOUT);
+      state[req->key] = 2;
+      free(req);
+      dequeued++;
+    }
+    CHECK(win.inflightCount <= win.window);
+    if (0 == (i % 1024))
+    {
+      testConsistent();
+    }
+  }
+
+  testConsistent();
+  /* every queued request was either sent from the queue or freed */
+  CHECK(queued == dequeued + freed + win.pendCount);
+  CHECK(win.sentCount == sent + dequeued);
+  CHECK(win.pendCountMax > 0);
+
+  mabRadiusWindowExpire(&win, now + TEST_TIMEOUT);
+  CHECK(0 == win.inflightCount);
+  while (NULL != (req = mabRadiusWindowDequeue(&win)))
+  {
+    free(req);
+  }
+}
+
+int main(void)
+{
+  testWindowSet();
+  testQueueOrder();
+  testRelease();
+  testResend();
+  testExpire(1000);
+  /* the uptime wraps while slots are outstanding */
+  testExpire(0xFFFFFFF0U);
+  testShrink();
+  testIdSpace();
+  testRandom(1, 0);
+  testRandom(42, 0xFFFFFF00U);
+
+  if (failures)
+  {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("mab radius window: all tests passed\n");
+  return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Timer wheel UT, the wheel is driven by a virtual clock */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "mab_timer_wheel.h"
+
+#define TEST_TIMERS   512
+
+typedef struct testTimer_s
+{
+  mabTimerWheelNode_t link;       /* first */
+  int                 running;
+  uint32_t            due;        /* expected expiry tick */
+  uint32_t            fired;      /* tick it was delivered at */
+  int                 fireCount;
+  struct testTimer_s *victim;     /* stopped from the expiry callback */
+}testTimer_t;
+
+static mabTimerWheelBase_t wheel;
+static testTimer_t timers[TEST_TIMERS];
+static uint32_t clockNow;
+static int failures;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) \
+    { \
+      fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+static void testExpire(mabTimerWheelNode_t *link)
+{
+  testTimer_t *t = (testTimer_t *)link;
+
+  CHECK(t->running);
+  CHECK(NULL == link->pprev);
+  t->running = 0;
+  t->fired = clockNow;
+  t->fireCount++;
+
+  if ((NULL != t->victim) && t->victim->running)
+  {
+    mabTimerWheelRemove(&wheel, &t->victim->link);
+    t->victim->running = 0;
+  }
+}
+
+static void testReset(uint32_t start)
+{
+  memset(&wheel, 0, sizeof(wheel));
+  memset(timers, 0, sizeof(timers));
+  clockNow = start;
+  /* the first turn of an idle wheel only latches the clock */
+  mabTimerWheelAdvance(&wheel, clockNow, testExpire);
+}
+
+static void testStart(testTimer_t *t, uint32_t timeout)
+{
+  mabTimerWheelAdd(&wheel, &t->link, timeout);
+  t->running = 1;
+  t->fireCount = 0;
+  /* a timer started between ticks fires at the tick after its timeout */
+  t->due = clockNow + 1 + timeout;
+}
+
+static void testStop(testTimer_t *t)
+{
+  mabTimerWheelRemove(&wheel, &t->link);
+  t->running = 0;
+}
+
+static void testTick(void)
+{
+  clockNow++;
+  mabTimerWheelAdvance(&wheel, clockNow, testExpire);
+}
+
+static uint32_t testRunning(void)
+{
+  uint32_t i, n = 0;
+
+  for (i = 0; i < TEST_TIMERS; i++)
+  {
+    n += timers[i].running;
+  }
+  return n;
+}
+
+/* Each timer fires exactly at its tick, on every level of the wheel */
+static void testExactExpiry(uint32_t start)
+{
+  static const uint32_t timeouts[] =
+  {
+    0, 1, 5, 63, 64, 65, 127, 4095, 4096, 4097, 262143, 262144, 300000
+  };
+  uint32_t n = sizeof(timeouts) / sizeof(timeouts[0]);
+  uint32_t i, last = 0;
+
+  testReset(start);
+  for (i = 0; i < n; i++)
+  {
+    testStart(&timers[i], timeouts[i]);
+    if (timers[i].due - start > last)
+    {
+      last = timers[i].due - start;
+    }
+  }
+  CHECK(wheel.count == n);
+
+  while (clockNow - start <= last)
+  {
+    testTick();
+    for (i = 0; i < n; i++)
+    {
+      if (clockNow == timers[i].due)
+      {
+        CHECK(1 == timers[i].fireCount);
+      }
+      else if ((int32_t)(clockNow - timers[i].due) < 0)
+      {
+        CHECK(0 == timers[i].fireCount);
+      }
+    }
+  }
+
+  for (i = 0; i < n; i++)
+  {
+    CHECK(1 == timers[i].fireCount);
+    CHECK(timers[i].due == timers[i].fired);
+  }
+  CHECK(0 == wheel.count);
+}
+
+/* A long stall of the tick timer delivers everything due in one batch */
+static void testClockJump(void)
+{
+  uint32_t i;
+
+  testReset(1000);
+  for (i = 0; i < 100; i++)
+  {
+    testStart(&timers[i], i * 97);
+  }
+
+  clockNow += 100 * 97;
+  mabTimerWheelAdvance(&wheel, clockNow, testExpire);
+  for (i = 0; i < 100; i++)
+  {
+    CHECK(1 == timers[i].fireCount);
+  }
+  CHECK(0 == wheel.count);
+}
+
+/* Timers stopped on any level never fire and leave the other ones alone */
+static void testRemove(void)
+{
+  uint32_t i;
+
+  testReset(77);
+  for (i = 0; i < 64; i++)
+  {
+    testStart(&timers[i], i * 311);
+  }
+  for (i = 0; i < 64; i += 2)
+  {
+    testStop(&timers[i]);
+  }
+  CHECK(32 == wheel.count);
+
+  /* stopping twice is harmless */
+  testStop(&timers[0]);
+  CHECK(32 == wheel.count);
+
+  for (i = 0; i < 64 * 311 + 2; i++)
+  {
+    testTick();
+  }
+  for (i = 0; i < 64; i++)
+  {
+    CHECK(((i & 1) ? 1 : 0) == timers[i].fireCount);
+    if (i & 1)
+    {
+      CHECK(timers[i].due == timers[i].fired);
+    }
+  }
+  CHECK(0 == wheel.count);
+}
+
+/* A timer of the batch being delivered can be stopped by an earlier one */
+static void testRemoveInBatch(void)
+{
+  testReset(500);
+  testStart(&timers[0], 10);
+  testStart(&timers[1], 10);
+  timers[0].victim = &timers[1];
+  timers[1].victim = &timers[0];
+
+  clockNow += 20;
+  mabTimerWheelAdvance(&wheel, clockNow, testExpire);
+  CHECK(1 == (timers[0].fireCount + timers[1].fireCount));
+  CHECK(0 == wheel.count);
+  CHECK(NULL == wheel.expired);
+}
+
+/* A node is reusable once delivered */
+static void testRestart(void)
+{
+  uint32_t i;
+
+  testReset(0);
+  testStart(&timers[0], 3);
+  for (i = 0; i < 4; i++)
+  {
+    testTick();
+  }
+  CHECK(1 == timers[0].fireCount);
+  testStart(&timers[0], 70);
+  for (i = 0; i < 71; i++)
+  {
+    testTick();
+  }
+  CHECK(1 == timers[0].fireCount);
+  CHECK(timers[0].due == timers[0].fired);
+}
+
+/* Timeouts beyond the wheel span are clamped, not wrapped to early expiry */
+static void testClamp(void)
+{
+  testReset(0x7FFFFFF0U);
+  testStart(&timers[0], 0xFFFFFFF0U);
+  timers[0].due = clockNow + 1 + MAB_TIMER_WHEEL_MAX_TICKS;
+
+  clockNow += MAB_TIMER_WHEEL_MAX_TICKS;
+  mabTimerWheelAdvance(&wheel, clockNow, testExpire);
+  CHECK(0 == timers[0].fireCount);
+  testTick();
+  CHECK(1 == timers[0].fireCount);
+  CHECK(timers[0].due == timers[0].fired);
+}
+
+/* Random starts and stops, checked against the expected expiry ticks */
+static void testRandom(uint32_t seed)
+{
+  uint32_t i, step, idx;
+  uint32_t start = seed * 2654435761U;
+
+  srand(seed);
+  testReset(start);
+
+  for (step = 0; step < 20000; step++)
+  {
+    for (i = 0; i < 4; i++)
+    {
+      idx = rand() % TEST_TIMERS;
+      if (timers[idx].running)
+      {
+        testStop(&timers[idx]);
+      }
+      else if (rand() & 1)
+      {
+        testStart(&timers[idx], rand() % ((rand() & 3) ? 200 : 70000));
+      }
+    }
+
+    testTick();
+    for (i = 0; i < TEST_TIMERS; i++)
+    {
+      if (timers[i].running)
+      {
+        CHECK((int32_t)(timers[i].due - clockNow) > 0);
+      }
+      else if (timers[i].fireCount)
+      {
+        CHECK(1 == timers[i].fireCount);
+        CHECK(timers[i].due == timers[i].fired);
+        timers[i].fireCount = 0;
+      }
+    }
+    CHECK(wheel.count == testRunning());
+  }
+}
+
+int main(void)
+{
+  testExactExpiry(0);
+  testExactExpiry(12345);
+  /* the clock wraps while timers are pending */
+  testExactExpiry(0xFFFFFF00U);
+  testExactExpiry(0xFFFFFFFFU - 4096);
+  testClockJump();
+  testRemove();
+  testRemoveInBatch();
+  testRestart();
+  testClamp();
+  testRandom(1);
+  testRandom(42);
+  testRandom(0xFFFFFFF0U);
+
+  if (failures)
+  {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("mab timer wheel: all tests passed\n");
+  return 0;
+}
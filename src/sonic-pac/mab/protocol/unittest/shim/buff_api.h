@@ -0,0 +1,28 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for buff_api.h */
+
+#ifndef INCLUDE_BUFF_API_H
+#define INCLUDE_BUFF_API_H
+
+RC_t bufferPoolInit(uint32 compId, uint32 num_bufs, uint32 buf_size,
+                    char *descr, uint32 *buffer_pool_id);
+RC_t bufferPoolAllocate(uint32 buffer_pool_id, uchar8 **buffer_addr);
+void bufferPoolFree(uint32 buffer_pool_id, uchar8 *buffer_addr);
+RC_t bufferPoolDelete(uint32 buffer_pool_id);
+
+#endif /* INCLUDE_BUFF_API_H */
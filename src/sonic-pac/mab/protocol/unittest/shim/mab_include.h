@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for the MAB include set, just enough of the PAC
+ * infrastructure types and services to build mab_mac_db.c on its own.
+ * The buffer pool and lock services are implemented by the test.
+ */
+
+#ifndef INCLUDE_MAB_INCLUDE_H
+#define INCLUDE_MAB_INCLUDE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef uint32_t      uint32;
+typedef int32_t       int32;
+typedef unsigned char uchar8;
+
+typedef enum
+{
+  SUCCESS = 0,
+  FAILURE
+} RC_t;
+
+#define NULLPTR  NULL
+
+#define ENET_MAC_ADDR_LEN  6
+
+typedef struct
+{
+  uchar8 addr[ENET_MAC_ADDR_LEN];
+} enetMacAddr_t;
+
+#define MAB_COMPONENT_ID            1
+#define MAB_LOGICAL_PORT_ITERATE    0xFFFFFFFF
+#define MAB_PORT_GET(_x, _val) \
+  _x = (_val & 0XFFFF0000)>>16;
+
+#define LOG_SEVERITY_NOTICE  5
+#define LOG_SEVERITY_INFO    6
+#define LOGF(_sev, _fmt, ...)          do { } while (0)
+#define MAB_EVENT_TRACE(_fmt, ...)     do { } while (0)
+#define SYSAPI_PRINTF                  printf
+
+typedef void *osapiRWLock_t;
+#define OSAPI_RWLOCK_Q_PRIORITY  1
+#define WAIT_FOREVER             (-1)
+
+void *osapiMalloc(uint32 compId, uint32 size);
+void osapiFree(uint32 compId, void *ptr);
+RC_t osapiRWLockCreate(osapiRWLock_t *rwlock, int options);
+RC_t osapiRWLockDelete(osapiRWLock_t rwlock);
+RC_t osapiReadLockTake(osapiRWLock_t rwlock, int32 timeout);
+RC_t osapiReadLockGive(osapiRWLock_t rwlock);
+RC_t osapiWriteLockTake(osapiRWLock_t rwlock, int32 timeout);
+RC_t osapiWriteLockGive(osapiRWLock_t rwlock);
+
+#include "mab_mac_db.h"
+
+#endif /* INCLUDE_MAB_INCLUDE_H */
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for mab_struct.h, only the MAC database state */
+
+#ifndef INCLUDE_MAB_STRUCT_H
+#define INCLUDE_MAB_STRUCT_H
+
+typedef struct mabBlock_s
+{
+   uint32     mabMacAddrBufferPoolId;
+   void       **mabMacAddrHashTbl;   /* supplicant mac address hash buckets */
+   uint32     mabMacAddrHashBits;
+   uint32     mabMacAddrHashMask;
+   uint32     mabMacAddrCount;
+   osapiRWLock_t mabMacAddrDBRWLock;
+}mabBlock_t;
+
+#endif /* INCLUDE_MAB_STRUCT_H */
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2024 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Userspace stand-in for sll_api.h, mab_mac_db.c only uses the member type */
+
+#ifndef INCLUDE_SLL_API_H
+#define INCLUDE_SLL_API_H
+
+typedef struct sll_member_s
+{
+  struct sll_member_s *next;
+} sll_member_t;
+
+#endif /* INCLUDE_SLL_API_H */
@@ -52,7 +52,7 @@ extern "C" {
     RC_t pacCfgPortPVIDGet(char *interface, int *pvid)
     {
         string port(interface);
-        RC_t rc =  FAILURE;
+        RC_t rc =  SUCCESS;
         
         if (pvid ==  NULL)
         {
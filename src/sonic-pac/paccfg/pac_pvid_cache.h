@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PAC_PVID_CACHE_H
+#define _PAC_PVID_CACHE_H
+
+#include <string>
+#include <functional>
+#include <unordered_map>
+
+/*
+ * Port name -> port OID -> PVID cache.
+ * The owner feeds it the ASIC_DB port notifications and supplies the
+ * Redis reads done on a miss, so it has no dependency on swss-common.
+ */
+class PacPvidCache {
+    public:
+        /* Read the OID of a port, false if the port is unknown */
+        typedef std::function<bool(const std::string &port, std::string &oid)> OidFetch;
+        /* Read the PVID of a port OID */
+        typedef std::function<int(const std::string &oid)> PvidFetch;
+
+        /* ASIC_DB SET of a port object */
+        void portSet(const std::string &oid, int pvid)
+        {
+            m_oidPvid[oid] = pvid;
+        }
+
+        /* ASIC_DB DEL of a port object, the port name may come back with a new OID */
+        void portDel(const std::string &oid)
+        {
+            m_oidPvid.erase(oid);
+            for (auto it = m_portOid.begin(); it != m_portOid.end(); )
+            {
+                it = (it->second == oid) ? m_portOid.erase(it) : std::next(it);
+            }
+        }
+
+        /* Get the PVID of a port, reading Redis only on a miss */
+        bool pvidGet(const std::string &port, int *pvid,
+                     const OidFetch &oidFetch, const PvidFetch &pvidFetch)
+        {
+            std::string oid;
+
+            auto oidIt = m_portOid.find(port);
+            if (oidIt != m_portOid.end())
+            {
+                oid = oidIt->second;
+            }
+            else if (oidFetch(port, oid) == true)
+            {
+                m_portOid[port] = oid;
+            }
+            else
+            {
+                return false;
+            }
+
+            auto pvidIt = m_oidPvid.find(oid);
+            if (pvidIt == m_oidPvid.end())
+            {
+                pvidIt = m_oidPvid.emplace(oid, pvidFetch(oid)).first;
+            }
+            *pvid = pvidIt->second;
+
+            return true;
+        }
+
+    private:
+        std::unordered_map<std::string, std::string> m_portOid;
+        std::unordered_map<std::string, int> m_oidPvid;
+};
+
+#endif /* _PAC_PVID_CACHE_H */
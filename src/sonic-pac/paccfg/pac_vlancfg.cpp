@@ -22,6 +22,9 @@
 using namespace std;
 using namespace swss;
 
+#define ASIC_PORT_TABLE       "ASIC_STATE:SAI_OBJECT_TYPE_PORT"
+#define ASIC_PORT_VLAN_ID     "SAI_PORT_ATTR_PORT_VLAN_ID"
+
 // PAC SONIC config engine 
 PacCfgVlan::PacCfgVlan(DBConnector *db, DBConnector *cfgDb, DBConnector *stateDb,
                        DBConnector *asicDb, DBConnector *countersDb) :
@@ -42,6 +45,15 @@ PacCfgVlan::PacCfgVlan(DBConnector *db, DBConnector *cfgDb, DBConnector *stateDb
     m_cfgDb  = cfgDb;
     m_asicDb = asicDb;
 
+    /* Subscribe before anything is cached, so no PVID change is missed. */
+    m_asicPortSubscriber = std::make_shared<swss::SubscriberStateTable>(asicDb, ASIC_PORT_TABLE);
+    m_asicPortSelect.addSelectable(m_asicPortSubscriber.get());
+
+    /* vlanMemberClean() writes through these in one round trip */
+    m_statePipeline = std::make_shared<swss::RedisPipeline>(stateDb);
+    m_stateOperPortBatchTable = std::make_shared<Table>(m_statePipeline.get(), STATE_OPER_PORT_TABLE_NAME, true);
+    m_stateOperVlanMemberBatchTable = std::make_shared<Table>(m_statePipeline.get(), STATE_OPER_VLAN_MEMBER_TABLE_NAME, true);
+
     /* Setup notification producer for VLAN notifications. */
     m_vlanCfgNotificationProducer = std::make_shared<swss::NotificationProducer>(stateDb, "VLANCFG");
 }
@@ -86,13 +98,16 @@ bool PacCfgVlan::vlanMemberClean(int vlan)
       if((VLAN_PREFIX + to_string(vlan)) == vlanStr)
       {
          // Remove port from VLAN after setting PVID back to zero.
-         m_stateOperVlanMemberTable.del(key);
-         m_stateOperPortTable.hdel(intfStr ,"pvid");
-         m_stateOperPortTable.hdel(intfStr ,"acquired");
-         m_stateOperPortTable.set(intfStr, fvVector);
+         m_stateOperVlanMemberBatchTable->del(key);
+         m_stateOperPortBatchTable->hdel(intfStr ,"pvid");
+         m_stateOperPortBatchTable->hdel(intfStr ,"acquired");
+         m_stateOperPortBatchTable->set(intfStr, fvVector);
       }
    }
 
+   /* All the members of the VLAN in one round trip */
+   m_statePipeline->flush();
+
    return true;
 }
 
@@ -108,42 +123,75 @@ bool PacCfgVlan::portPVIDset(string port, int pvid)
    return true;
 }
 
-bool PacCfgVlan::portPVIDGet(string port, int *pvid)
+static int pvidParse(const string &value)
 {
-    string portOid;
-    std::unordered_map<string, string>::iterator it;
-
-    if (pvid == NULL)
+    try
     {
-        return false;
+        return stoi(value);
     }
-
-    *pvid = 0;
-  
-    /* Get the port OID for COUNTERS_DB. */
-    if (m_countersPortNameMapTable.hget("", port, portOid) != true)
+    catch (...)
     {
-        return false;
+        SWSS_LOG_WARN("Invalid value:%s for SAI_PORT_ATTR_PORT_VLAN_ID", value.c_str());
     }
+    return 0;
+}
+
+void PacCfgVlan::pvidCacheUpdate()
+{
+    Selectable *sel;
 
-    /* Port PVID from ASIC_DB */
-    auto fieldValues = m_asicDb->hgetall("ASIC_STATE:SAI_OBJECT_TYPE_PORT:"+portOid);
-    for (it = fieldValues.begin(); it != fieldValues.end(); it++)
+    /* Apply pending ASIC_DB port changes without blocking */
+    while (m_asicPortSelect.select(&sel, 0) == Select::OBJECT)
     {
-        if ((it->first) == "SAI_PORT_ATTR_PORT_VLAN_ID")
+        std::deque<KeyOpFieldsValuesTuple> entries;
+        m_asicPortSubscriber->pops(entries);
+
+        for (const auto &entry: entries)
         {
-            try
+            const string &oid = kfvKey(entry);
+
+            if (kfvOp(entry) == DEL_COMMAND)
             {
-                *pvid = stoi(it->second);
+                m_pvidCache.portDel(oid);
+                continue;
             }
-            catch (...)
+
+            int pvid = 0;
+            for (const auto &fv: kfvFieldsValues(entry))
             {
-                SWSS_LOG_WARN("Invalid value:%s for SAI_PORT_ATTR_PORT_VLAN_ID", (it->second).c_str());
+                if (fvField(fv) == ASIC_PORT_VLAN_ID)
+                {
+                    pvid = pvidParse(fvValue(fv));
+                }
             }
+            m_pvidCache.portSet(oid, pvid);
         }
     }
+}
 
-    return true;
+bool PacCfgVlan::portPVIDGet(string port, int *pvid)
+{
+    if (pvid == NULL)
+    {
+        return false;
+    }
+
+    *pvid = 0;
+
+    pvidCacheUpdate();
+
+    return m_pvidCache.pvidGet(port, pvid,
+        [this](const string &name, string &oid)
+        {
+            /* Get the port OID for COUNTERS_DB. */
+            return m_countersPortNameMapTable.hget("", name, oid);
+        },
+        [this](const string &oid)
+        {
+            /* Port PVID from ASIC_DB */
+            auto value = m_asicDb->hget(string(ASIC_PORT_TABLE) + ":" + oid, ASIC_PORT_VLAN_ID);
+            return value ? pvidParse(*value) : 0;
+        });
 }
 
 bool PacCfgVlan::sendVlanNotification(string op, string port, vector<string> keys)
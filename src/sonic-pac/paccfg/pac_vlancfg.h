@@ -18,6 +18,7 @@
 #define _PAC_VLAN_CFG_H
 
 #include <string>
+#include <memory>
 #include <swss/dbconnector.h>
 #include <swss/schema.h>
 #include <swss/table.h>
@@ -25,9 +26,11 @@
 #include <swss/notificationproducer.h>
 #include <swss/subscriberstatetable.h>
 #include <swss/producerstatetable.h>
+#include <swss/redispipeline.h>
 #include <swss/table.h>
 #include <swss/select.h>
 #include <swss/timestamp.h>
+#include "pac_pvid_cache.h"
 
 using namespace std;
 
@@ -82,6 +85,18 @@ namespace swss {
         DBConnector *m_cfgDb;
         DBConnector *m_asicDb;
 
+        /* Port OID and PVID cache, kept current by ASIC_DB keyspace notifications */
+        PacPvidCache m_pvidCache;
+        std::shared_ptr<swss::SubscriberStateTable> m_asicPortSubscriber;
+        Select m_asicPortSelect;
+
+        /* Buffered tables, written in one round trip by m_statePipeline->flush() */
+        std::shared_ptr<swss::RedisPipeline> m_statePipeline;
+        std::shared_ptr<Table> m_stateOperPortBatchTable;
+        std::shared_ptr<Table> m_stateOperVlanMemberBatchTable;
+
+        void pvidCacheUpdate();
+
     };
 }
 
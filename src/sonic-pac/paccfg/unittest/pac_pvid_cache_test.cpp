@@ -0,0 +1,209 @@
+/*
+ * Copyright 2019 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* PVID cache UT, COUNTERS_DB and ASIC_DB are replaced by maps */
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include "pac_pvid_cache.h"
+
+using namespace std;
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Fake Redis, counting the reads done by the cache */
+struct FakeDb {
+    map<string, string> portNameMap;    /* COUNTERS_PORT_NAME_MAP */
+    map<string, int> asicPortPvid;      /* ASIC_STATE:SAI_OBJECT_TYPE_PORT */
+    int oidReads = 0;
+    int pvidReads = 0;
+
+    PacPvidCache::OidFetch oidFetch()
+    {
+        return [this](const string &port, string &oid)
+        {
+            oidReads++;
+            auto it = portNameMap.find(port);
+            if (it == portNameMap.end())
+            {
+                return false;
+            }
+            oid = it->second;
+            return true;
+        };
+    }
+
+    PacPvidCache::PvidFetch pvidFetch()
+    {
+        return [this](const string &oid)
+        {
+            pvidReads++;
+            auto it = asicPortPvid.find(oid);
+            return (it == asicPortPvid.end()) ? 0 : it->second;
+        };
+    }
+};
+
+static bool get(PacPvidCache &cache, FakeDb &db, const string &port, int *pvid)
+{
+    *pvid = -1;
+    return cache.pvidGet(port, pvid, db.oidFetch(), db.pvidFetch());
+}
+
+/* A miss reads Redis once, later lookups are served from the cache */
+static void testMissThenHit()
+{
+    PacPvidCache cache;
+    FakeDb db;
+    int pvid;
+
+    db.portNameMap["Ethernet0"] = "oid:0x1";
+    db.asicPortPvid["oid:0x1"] = 10;
+
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 10));
+    CHECK((db.oidReads == 1) && (db.pvidReads == 1));
+
+    for (int i = 0; i < 100; i++)
+    {
+        CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 10));
+    }
+    CHECK((db.oidReads == 1) && (db.pvidReads == 1));
+}
+
+/* A port object with no PVID attribute reads as 0 and is cached too */
+static void testNoPvid()
+{
+    PacPvidCache cache;
+    FakeDb db;
+    int pvid;
+
+    db.portNameMap["Ethernet4"] = "oid:0x4";
+
+    CHECK(get(cache, db, "Ethernet4", &pvid) && (pvid == 0));
+    CHECK(get(cache, db, "Ethernet4", &pvid) && (pvid == 0));
+    CHECK(db.pvidReads == 1);
+}
+
+/* An unknown port fails, and is looked up again next time */
+static void testUnknownPort()
+{
+    PacPvidCache cache;
+    FakeDb db;
+    int pvid;
+
+    CHECK(!get(cache, db, "Ethernet8", &pvid));
+    CHECK(db.pvidReads == 0);
+
+    db.portNameMap["Ethernet8"] = "oid:0x8";
+    db.asicPortPvid["oid:0x8"] = 30;
+    CHECK(get(cache, db, "Ethernet8", &pvid) && (pvid == 30));
+    CHECK(db.oidReads == 2);
+}
+
+/* ASIC_DB notifications update a cached PVID without any read */
+static void testNotificationUpdate()
+{
+    PacPvidCache cache;
+    FakeDb db;
+    int pvid;
+
+    db.portNameMap["Ethernet0"] = "oid:0x1";
+    db.asicPortPvid["oid:0x1"] = 10;
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 10));
+
+    db.asicPortPvid["oid:0x1"] = 20;
+    cache.portSet("oid:0x1", 20);
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 20));
+
+    /* a SET without the attribute, the PVID was removed */
+    cache.portSet("oid:0x1", 0);
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 0));
+    CHECK((db.oidReads == 1) && (db.pvidReads == 1));
+}
+
+/* The initial scan of the subscriber seeds the cache before any lookup */
+static void testSeeded()
+{
+    PacPvidCache cache;
+    FakeDb db;
+    int pvid;
+
+    db.portNameMap["Ethernet0"] = "oid:0x1";
+    cache.portSet("oid:0x1", 42);
+
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 42));
+    CHECK((db.oidReads == 1) && (db.pvidReads == 0));
+}
+
+/* A deleted port drops its PVID and its name, a new OID is picked up */
+static void testPortDel()
+{
+    PacPvidCache cache;
+    FakeDb db;
+    int pvid;
+
+    db.portNameMap["Ethernet0"] = "oid:0x1";
+    db.portNameMap["Ethernet4"] = "oid:0x4";
+    db.asicPortPvid["oid:0x1"] = 10;
+    db.asicPortPvid["oid:0x4"] = 40;
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 10));
+    CHECK(get(cache, db, "Ethernet4", &pvid) && (pvid == 40));
+
+    /* port breakout, Ethernet0 is recreated with another OID */
+    cache.portDel("oid:0x1");
+    db.asicPortPvid.erase("oid:0x1");
+    db.portNameMap["Ethernet0"] = "oid:0x2";
+    db.asicPortPvid["oid:0x2"] = 1;
+
+    CHECK(get(cache, db, "Ethernet0", &pvid) && (pvid == 1));
+    CHECK((db.oidReads == 3) && (db.pvidReads == 3));
+
+    /* the other port is untouched */
+    CHECK(get(cache, db, "Ethernet4", &pvid) && (pvid == 40));
+    CHECK((db.oidReads == 3) && (db.pvidReads == 3));
+
+    /* a DEL of an unknown OID is harmless */
+    cache.portDel("oid:0x99");
+    CHECK(get(cache, db, "Ethernet4", &pvid) && (pvid == 40));
+}
+
+int main()
+{
+    testMissThenHit();
+    testNoPvid();
+    testUnknownPort();
+    testNotificationUpdate();
+    testSeeded();
+    testPortDel();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pac pvid cache: all tests passed\n");
+    return 0;
+}
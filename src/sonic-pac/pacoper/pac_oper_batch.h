@@ -0,0 +1,134 @@
+/*
+ * Copyright 2021 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PAC_OPER_BATCH_H
+#define PAC_OPER_BATCH_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+/*
+ * Pending oper-state writes of one table, coalesced per key.
+ * A Table set is a field merge (HSET) and a del drops the whole key, so
+ * coalescing must not change what the key ends up holding:
+ *  - set after set merges the fields, later values win;
+ *  - del drops whatever was pending for the key;
+ *  - set after del keeps the del, apply() issues it before the set.
+ * The table type is a template parameter, so it has no dependency on
+ * swss-common.
+ */
+class PacOperBatch {
+    public:
+        /* Same layout as swss::FieldValueTuple */
+        typedef std::pair<std::string, std::string> Fv;
+
+        struct Op {
+            bool del = false;           /* del the key first */
+            bool set = false;           /* then set fvs */
+            std::vector<Fv> fvs;
+        };
+
+        /* Queue a set, the fvs are consumed. True if the key is new */
+        bool set(const std::string &key, std::vector<Fv> &fvs)
+        {
+            auto res = m_ops.emplace(key, Op());
+            Op &op = res.first->second;
+
+            if (!op.set)
+            {
+                op.set = true;
+                op.fvs.swap(fvs);
+            }
+            else
+            {
+                merge(op.fvs, fvs);
+            }
+            fvs.clear();
+            return res.second;
+        }
+
+        /* Queue a del. True if the key is new */
+        bool del(const std::string &key)
+        {
+            auto res = m_ops.emplace(key, Op());
+            Op &op = res.first->second;
+
+            op.del = true;
+            op.set = false;
+            op.fvs.clear();
+            return res.second;
+        }
+
+        /* Write the batch, del before set for each key */
+        template <class TableT>
+        void apply(TableT &tbl) const
+        {
+            for (auto &entry : m_ops)
+            {
+                if (entry.second.del)
+                {
+                    tbl.del(entry.first);
+                }
+                if (entry.second.set)
+                {
+                    tbl.set(entry.first, entry.second.fvs);
+                }
+            }
+        }
+
+        size_t size() const
+        {
+            return m_ops.size();
+        }
+
+        void swap(PacOperBatch &other)
+        {
+            m_ops.swap(other.m_ops);
+        }
+
+        void clear()
+        {
+            m_ops.clear();
+        }
+
+    private:
+        static void merge(std::vector<Fv> &to, std::vector<Fv> &from)
+        {
+            /* the last occurrence of a field is the one that sticks */
+            for (auto &fv : from)
+            {
+                auto it = to.rbegin();
+                while ((it != to.rend()) && (it->first != fv.first))
+                {
+                    ++it;
+                }
+                if (it == to.rend())
+                {
+                    to.push_back(std::move(fv));
+                }
+                else
+                {
+                    it->second = std::move(fv.second);
+                }
+            }
+        }
+
+        std::unordered_map<std::string, Op> m_ops;
+};
+
+#endif /* PAC_OPER_BATCH_H */
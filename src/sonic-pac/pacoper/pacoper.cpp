@@ -42,6 +42,155 @@ DBConnector *stateDb = new DBConnector("STATE_DB", 0);
 DBConnector *configDb = new DBConnector("CONFIG_DB", 0);
 DBConnector *appDb = new DBConnector("APPL_DB", 0);
 FpDbAdapter * Fp = new FpDbAdapter(stateDb, configDb, appDb);
+static PacOperWriter operWriter;
+
+PacOperWriter::~PacOperWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_one();
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+}
+
+/* fvs is NULL for a del */
+void PacOperWriter::enqueue(PacOperTblId tbl, const string &key, vector<FieldValueTuple> *fvs)
+{
+  bool wake, added;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    /* started under the lock, drain() checks m_started the same way */
+    if (!m_started)
+    {
+      m_thread = std::thread(&PacOperWriter::run, this);
+      m_started = true;
+    }
+    added = (fvs == nullptr) ? m_pending[tbl].del(key) : m_pending[tbl].set(key, *fvs);
+    if (added)
+    {
+      m_pendingCount++;
+    }
+    /* wake the writer on the first entry and when a pipeline is full */
+    wake = (m_pendingCount == 1) || (m_pendingCount >= PAC_OPER_PIPELINE_SIZE);
+  }
+
+  if (wake)
+  {
+    m_cv.notify_one();
+  }
+}
+
+void PacOperWriter::set(PacOperTblId tbl, const string &key, vector<FieldValueTuple> &fvs)
+{
+  enqueue(tbl, key, &fvs);
+}
+
+void PacOperWriter::del(PacOperTblId tbl, const string &key)
+{
+  enqueue(tbl, key, nullptr);
+}
+
+void PacOperWriter::drain()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if (!m_started)
+  {
+    return;
+  }
+
+  m_drainReq = true;
+  m_cv.notify_one();
+  m_drainCv.wait(lock, [this] { return (m_pendingCount == 0) && !m_busy; });
+  m_drainReq = false;
+}
+
+void PacOperWriter::run()
+{
+  /* redis connections are not thread safe, the writer has its own */
+  DBConnector db("STATE_DB", 0);
+  RedisPipeline pipeline(&db, PAC_OPER_PIPELINE_SIZE);
+  Table globalTbl(&pipeline, STATE_PAC_GLOBAL_OPER_TABLE, true);
+  Table portTbl(&pipeline, STATE_PAC_PORT_OPER_TABLE, true);
+  Table clientTbl(&pipeline, STATE_PAC_AUTHENTICATED_CLIENT_OPER_TABLE, true);
+  Table *tables[PAC_OPER_TBL_MAX] = { &globalTbl, &portTbl, &clientTbl };
+  PacOperBatch batch[PAC_OPER_TBL_MAX];
+  std::unique_lock<std::mutex> lock(m_mutex);
+  int tbl;
+
+  while (true)
+  {
+    m_cv.wait(lock, [this] { return m_stop || (m_pendingCount != 0); });
+
+    if (m_pendingCount == 0)
+    {
+      break;
+    }
+
+    /* give a burst of state changes the chance to coalesce */
+    m_cv.wait_for(lock, std::chrono::milliseconds(PAC_OPER_FLUSH_MSEC),
+                  [this] { return m_stop || m_drainReq ||
+                                  (m_pendingCount >= PAC_OPER_PIPELINE_SIZE); });
+
+    for (tbl = 0; tbl < PAC_OPER_TBL_MAX; tbl++)
+    {
+      batch[tbl].swap(m_pending[tbl]);
+    }
+    m_pendingCount = 0;
+    m_busy = true;
+    lock.unlock();
+
+    try
+    {
+      for (tbl = 0; tbl < PAC_OPER_TBL_MAX; tbl++)
+      {
+        batch[tbl].apply(*tables[tbl]);
+      }
+      pipeline.flush();
+    }
+    catch (const std::exception &e)
+    {
+      SWSS_LOG_ERROR("Failed to write PAC oper state to STATE_DB: %s", e.what());
+    }
+
+    for (tbl = 0; tbl < PAC_OPER_TBL_MAX; tbl++)
+    {
+      batch[tbl].clear();
+    }
+
+    lock.lock();
+    m_busy = false;
+    if (m_pendingCount == 0)
+    {
+      m_drainCv.notify_all();
+    }
+  }
+}
+
+static string pacOperHexEncode(const  uchar8 *buf, uint32 len, uint32 maxLen)
+{
+  static const char hexDigits[] = "0123456789ABCDEF";
+  string out;
+  uint32 i;
+
+  if (len > maxLen)
+  {
+    len = maxLen;
+  }
+
+  out.resize(len * 2);
+  for (i = 0; i < len; i++)
+  {
+    out[2 * i] = hexDigits[buf[i] >> 4];
+    out[2 * i + 1] = hexDigits[buf[i] & 0x0F];
+  }
+  return out;
+}
 
 
 string fetch_interface_name(int intIfNum)
@@ -63,12 +212,9 @@ void PacAuthClientOperTblSet(uint32 intIfNum,  enetMacAddr_t macAddr,
 {
   vector<FieldValueTuple> fvs;
   char c[18];
-  unsigned int i;
-  string serverState("");
-  string serverClass("");
    enetMacAddr_t zeroMac;
 
-  SWSS_LOG_NOTICE("----- PacAuthClientOperTbl func called from AuthMgr -----");
+  SWSS_LOG_DEBUG("----- PacAuthClientOperTbl func called from AuthMgr -----");
 
   memset (&zeroMac, 0, sizeof ( enetMacAddr_t));
   if (0 == memcmp (zeroMac.addr, macAddr.addr,  ENET_MAC_ADDR_LEN))
@@ -103,24 +249,14 @@ void PacAuthClientOperTblSet(uint32 intIfNum,  enetMacAddr_t macAddr,
   fvs.emplace_back("auth_status", authMgrPortStatus[client_info->auth_status]);
   fvs.emplace_back("authenticated_method", authMgrMethod[client_info->authenticatedMethod]);
 
-  for (i = 0; i < client_info->serverStateLen; i++) 
-  {
-    memset(c, 0, sizeof(c));
-    sprintf(c, "%02X", client_info->serverState[i]);
-    serverState += c;
-  }
-
-  fvs.emplace_back("server_state", serverState);
+  fvs.emplace_back("server_state",
+                   pacOperHexEncode(client_info->serverState, client_info->serverStateLen,
+                                    sizeof(client_info->serverState)));
   fvs.emplace_back("server_state_len", to_string(client_info->serverStateLen));
 
-  for (i = 0; i < client_info->serverClassLen; i++) 
-  {
-    memset(c, 0, sizeof(c));
-    sprintf(c, "%02X", client_info->serverClass[i]);
-    serverState += c;
-  }
-
-  fvs.emplace_back("server_class", serverClass);
+  fvs.emplace_back("server_class",
+                   pacOperHexEncode(client_info->serverClass, client_info->serverClassLen,
+                                    sizeof(client_info->serverClass)));
   fvs.emplace_back("server_class_len", to_string(client_info->serverClassLen));
 
   fvs.emplace_back("session_timeout_RADIUS", to_string(client_info->sessionTimeoutRcvdFromRadius));
@@ -134,7 +270,7 @@ void PacAuthClientOperTblSet(uint32 intIfNum,  enetMacAddr_t macAddr,
   fvs.emplace_back("session_time", to_string(client_info->sessionTime));
   fvs.emplace_back("termination_action_time_left", to_string(client_info->lastAuthTime));
 
-  Fp->m_PacAuthClientOperTbl.set(key, fvs);
+  operWriter.set(PAC_OPER_AUTH_CLIENT_TBL, key, fvs);
 
  }
 
@@ -153,7 +289,7 @@ void PacAuthClientOperTblDel(uint32 intIfNum,  enetMacAddr_t macAddr)
   string key = interfaceName + "|";
   key += macAddress;
 
-  Fp->m_PacAuthClientOperTbl.del(key);
+  operWriter.del(PAC_OPER_AUTH_CLIENT_TBL, key);
 
 }
 
@@ -176,7 +312,7 @@ void PacGlobalOperTblSet(pac_global_oper_table_t *info)
   fvs.emplace_back("num_clients_authenticated", to_string(info->authCount));
   fvs.emplace_back("num_clients_authenticated_monitor", to_string(info->authCountMonMode));
 
-  Fp->m_PacGlobalOperTbl.set("GLOBAL", fvs);
+  operWriter.set(PAC_OPER_GLOBAL_TBL, "GLOBAL", fvs);
 }
 
 void PacGlobalOperTblCleanup(void)
@@ -251,7 +387,7 @@ void PacPortOperTblSet(uint32 intIfNum,  AUTHMGR_METHOD_t *enabledMethods,
   fvs.emplace_back("enabled_method_list@", methods);
   fvs.emplace_back("enabled_priority_list@", priorities);
   
-  Fp->m_PacPortOperTbl.set(key, fvs);
+  operWriter.set(PAC_OPER_PORT_TBL, key, fvs);
 }
 
 void PacPortOperTblCleanup(void)
@@ -267,6 +403,8 @@ void PacPortOperTblCleanup(void)
 
 void PacOperTblCleanup(void)
 {
+   /* let queued writes land first so they are not resurrected later */
+   operWriter.drain();
    PacAuthClientOperTblCleanup();
    PacGlobalOperTblCleanup();
 }
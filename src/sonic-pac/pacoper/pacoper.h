@@ -17,6 +17,11 @@
 #define PACOPER_H
 
 #include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <swss/dbconnector.h>
 #include <swss/schema.h>
 #include <swss/table.h>
@@ -26,13 +31,20 @@
 #include <swss/select.h>
 #include <swss/timestamp.h>
 #include <swss/redisapi.h>
+#include <swss/redispipeline.h>
 #include <swss/tokenize.h>
+#include "pac_oper_batch.h"
 
 using namespace swss;
 using namespace std;
 
 #define AUTHMGR_MAX_HISTENT_PER_INTERFACE   48
 
+/* Oper-state writes are flushed to STATE_DB in one redis pipeline
+ * once this many are pending, or after PAC_OPER_FLUSH_MSEC. */
+#define PAC_OPER_PIPELINE_SIZE              128
+#define PAC_OPER_FLUSH_MSEC                 10
+
 class FpDbAdapter {
 public:
     FpDbAdapter(DBConnector *stateDb, DBConnector *configDb, DBConnector *appDb);
@@ -43,6 +55,41 @@ public:
 private:
 };
 
+typedef enum
+{
+  PAC_OPER_GLOBAL_TBL = 0,
+  PAC_OPER_PORT_TBL,
+  PAC_OPER_AUTH_CLIENT_TBL,
+  PAC_OPER_TBL_MAX
+} PacOperTblId;
+
+/* Writes PAC oper tables to STATE_DB from a background thread so that
+ * authmgr never blocks on redis. Pending writes are coalesced per key
+ * by PacOperBatch. */
+class PacOperWriter {
+public:
+    ~PacOperWriter();
+    void set(PacOperTblId tbl, const string &key, vector<FieldValueTuple> &fvs);
+    void del(PacOperTblId tbl, const string &key);
+    /* Block until everything queued so far is written */
+    void drain();
+
+private:
+    void enqueue(PacOperTblId tbl, const string &key, vector<FieldValueTuple> *fvs);
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_drainCv;
+    PacOperBatch m_pending[PAC_OPER_TBL_MAX];
+    size_t m_pendingCount = 0;
+    bool m_busy = false;
+    bool m_drainReq = false;
+    bool m_stop = false;
+    bool m_started = false;
+    std::thread m_thread;
+};
+
 string fetch_interface_name(int);
 
 #endif /* PACOPER_H */
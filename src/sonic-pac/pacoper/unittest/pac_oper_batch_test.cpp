@@ -0,0 +1,224 @@
+/*
+ * Copyright 2021 Broadcom Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Oper-state write coalescing UT, the STATE_DB table is a stub */
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+#include "pac_oper_batch.h"
+
+using namespace std;
+
+typedef PacOperBatch::Fv Fv;
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FUNCTION__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Stub Table with Redis hash semantics, set merges fields, del drops the key */
+struct StubTable {
+    map<string, map<string, string>> keys;
+    vector<string> log;
+
+    void set(const string &key, const vector<Fv> &fvs)
+    {
+        for (auto &fv : fvs)
+        {
+            keys[key][fv.first] = fv.second;
+        }
+        log.push_back("set " + key);
+    }
+
+    void del(const string &key)
+    {
+        keys.erase(key);
+        log.push_back("del " + key);
+    }
+};
+
+static vector<Fv> fvs(std::initializer_list<Fv> l)
+{
+    return vector<Fv>(l);
+}
+
+/* A client re-authenticates with fewer attributes, the stale ones must go */
+static void testDelThenSet()
+{
+    PacOperBatch batch;
+    StubTable tbl;
+    auto v = fvs({{"vlan", "10"}, {"session_timeout", "3600"}});
+
+    tbl.keys["Ethernet0|00:11:22:33:44:55"] = {{"vlan", "20"}, {"filter_id", "acl1"}};
+
+    CHECK(batch.del("Ethernet0|00:11:22:33:44:55"));
+    CHECK(!batch.set("Ethernet0|00:11:22:33:44:55", v));
+    CHECK(v.empty());
+    CHECK(batch.size() == 1);
+    batch.apply(tbl);
+
+    CHECK(tbl.log.size() == 2);
+    CHECK(tbl.log[0] == "del Ethernet0|00:11:22:33:44:55");
+    CHECK(tbl.log[1] == "set Ethernet0|00:11:22:33:44:55");
+    auto &k = tbl.keys["Ethernet0|00:11:22:33:44:55"];
+    CHECK(k.size() == 2);
+    CHECK(k.count("filter_id") == 0);
+    CHECK(k["vlan"] == "10");
+}
+
+static void testSetThenDel()
+{
+    PacOperBatch batch;
+    StubTable tbl;
+    auto v = fvs({{"vlan", "10"}});
+
+    tbl.keys["Ethernet4|aa"] = {{"vlan", "1"}};
+    CHECK(batch.set("Ethernet4|aa", v));
+    CHECK(!batch.del("Ethernet4|aa"));
+    batch.apply(tbl);
+
+    CHECK(tbl.log.size() == 1);
+    CHECK(tbl.log[0] == "del Ethernet4|aa");
+    CHECK(tbl.keys.count("Ethernet4|aa") == 0);
+}
+
+/* Partial updates of the same key merge, later values win */
+static void testSetMerge()
+{
+    PacOperBatch batch;
+    StubTable tbl;
+    auto a = fvs({{"status", "authorized"}, {"vlan", "10"}});
+    auto b = fvs({{"vlan", "20"}, {"method", "mab"}});
+
+    CHECK(batch.set("Ethernet8", a));
+    CHECK(!batch.set("Ethernet8", b));
+    batch.apply(tbl);
+
+    CHECK(tbl.log.size() == 1);
+    auto &k = tbl.keys["Ethernet8"];
+    CHECK(k.size() == 3);
+    CHECK(k["status"] == "authorized");
+    CHECK(k["vlan"] == "20");
+    CHECK(k["method"] == "mab");
+}
+
+/* set, del, set keeps only the del and the last set */
+static void testSetDelSet()
+{
+    PacOperBatch batch;
+    StubTable tbl;
+    auto a = fvs({{"status", "authorized"}, {"vlan", "10"}});
+    auto b = fvs({{"status", "unauthorized"}});
+    auto c = fvs({{"vlan", "30"}});
+
+    batch.set("k", a);
+    batch.del("k");
+    batch.set("k", b);
+    batch.set("k", c);
+    batch.del("other");
+    batch.del("other");
+    CHECK(batch.size() == 2);
+    batch.apply(tbl);
+
+    CHECK(tbl.log.size() == 3);
+    auto &k = tbl.keys["k"];
+    CHECK(k.size() == 2);
+    CHECK(k["status"] == "unauthorized");
+    CHECK(k["vlan"] == "30");
+
+    PacOperBatch other;
+    other.swap(batch);
+    CHECK(batch.size() == 0);
+    CHECK(other.size() == 2);
+    other.clear();
+    CHECK(other.size() == 0);
+}
+
+/* Random op streams, flushed at random points, must leave the table
+ * exactly as writing every op one by one does.
+ */
+static void testRandom(unsigned seed)
+{
+    static const char *fields[] = {"status", "vlan", "method", "filter_id", "timeout"};
+    PacOperBatch batch;
+    StubTable direct, coalesced;
+    size_t writes = 0, ops = 0;
+    int i, n, f;
+
+    srand(seed);
+    for (i = 0; i < 100000; i++)
+    {
+        string key = "Ethernet" + to_string(rand() % 64);
+
+        if ((rand() % 4) == 0)
+        {
+            direct.del(key);
+            batch.del(key);
+        }
+        else
+        {
+            vector<Fv> v;
+            for (n = 1 + rand() % 3; n > 0; n--)
+            {
+                f = rand() % 5;
+                v.push_back(Fv(fields[f], to_string(rand() % 100)));
+            }
+            direct.set(key, v);
+            batch.set(key, v);
+        }
+        ops++;
+
+        if ((rand() % 256) == 0)
+        {
+            batch.apply(coalesced);
+            batch.clear();
+            CHECK(coalesced.keys == direct.keys);
+        }
+    }
+    batch.apply(coalesced);
+    CHECK(coalesced.keys == direct.keys);
+
+    /* and it has to save writes to be worth it */
+    writes = coalesced.log.size();
+    CHECK(writes < ops / 2);
+}
+
+int main()
+{
+    testDelThenSet();
+    testSetThenDel();
+    testSetMerge();
+    testSetDelSet();
+    testRandom(1);
+    testRandom(7);
+
+    if (failures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pac oper batch: all tests passed\n");
+    return 0;
+}
@@ -6,7 +6,10 @@
  * Copyright (c) 2021 by Cisco Systems, Inc.
  *------------------------------------------------------------------
  */
+#include <chrono>
+#include <fstream>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <sys/stat.h>
 #include <linux/limits.h>
@@ -21,7 +24,6 @@ namespace fs = boost::filesystem;
 namespace SSGTest {
 #define IS_MULTI_ASIC(x)  ((x) > 1)
 #define IS_SINGLE_ASIC(x) ((x) <= 1)
-#define NUM_UNIT_FILES 9
 
 /*
  * This test class uses following directory hierarchy for input and output
@@ -91,6 +93,7 @@ class SystemdSonicGeneratorFixture : public testing::Test {
         machine_config_file_ = g_machine_config_file;
         asic_conf_format_ = g_asic_conf_format;
         platform_conf_format_ = g_platform_conf_format;
+        num_threads_ = g_ssg_num_threads;
     }
 
     /* Restore global vars */
@@ -100,6 +103,7 @@ class SystemdSonicGeneratorFixture : public testing::Test {
         g_machine_config_file = machine_config_file_;
         g_asic_conf_format = asic_conf_format_;
         g_platform_conf_format = platform_conf_format_;
+        g_ssg_num_threads = num_threads_;
 
         g_ssg_test_mutex.unlock();
     }
@@ -110,6 +114,7 @@ class SystemdSonicGeneratorFixture : public testing::Test {
     const char* machine_config_file_;
     const char* asic_conf_format_;
     const char* platform_conf_format_;
+    int num_threads_;
 };
 
 /*
@@ -154,10 +159,14 @@ class SsgFunctionTest : public SystemdSonicGeneratorFixture {
 
     /* Save global variables before running tests */
     virtual void SetUp() {
-        FILE* fp;
         SystemdSonicGeneratorFixture::SetUp();
+        create_test_tree();
+    }
+
+    /* Setup Input and Output directories and files */
+    void create_test_tree() {
+        FILE* fp;
 
-        /* Setup Input and Output directories and files */
         fs::path path{TEST_UNIT_FILE_PREFIX.c_str()};
         fs::create_directories(path);
         path = fs::path(TEST_OUTPUT_DIR.c_str());
@@ -391,10 +400,23 @@ class SsgMainTest : public SsgFunctionTest {
         }
     }
 
-    /* ssg_main test routine.
-     * input: num_asics    number of asics
-     */
-    void ssg_main_test(const SsgMainConfig &cfg) {
+    /* Read a unit file from the test unit file directory */
+    std::string read_unit_file(const std::string &file_name) {
+        std::ifstream file(TEST_UNIT_FILE_PREFIX + file_name);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    /* Compare a generated unit file with its expected content */
+    void validate_golden_output(const std::string &file_name,
+                                const std::string &expected) {
+        EXPECT_EQ(read_unit_file(file_name), expected)
+            << "Unexpected content in " + file_name;
+    }
+
+    /* Setup the test platform as per cfg and run ssg_main */
+    int run_ssg_main(const SsgMainConfig &cfg) {
         FILE* fp;
         std::vector<char*> argv_;
         std::vector<std::string> arguments = {
@@ -403,21 +425,24 @@ class SsgMainTest : public SsgFunctionTest {
                 };
         std::string num_asic_str = "NUM_ASIC=" + std::to_string(cfg.num_asics);
 
-        std::string unit_file_path = fs::current_path().string() + "/" +TEST_UNIT_FILE_PREFIX;
-        g_unit_file_prefix = unit_file_path.c_str();
+        unit_file_path_ = fs::current_path().string() + "/" +TEST_UNIT_FILE_PREFIX;
+        g_unit_file_prefix = unit_file_path_.c_str();
         g_config_file = TEST_CONFIG_FILE.c_str();
         g_machine_config_file = TEST_MACHINE_CONF.c_str();
         g_asic_conf_format = TEST_ASIC_CONF_FORMAT.c_str();
         g_platform_file_format = TEST_PLATFORM_FILE_FORMAT.c_str();
-        std::string lib_systemd = fs::current_path().string() + "/" + TEST_UNIT_FILE_PREFIX;
-        g_lib_systemd = lib_systemd.c_str();
-        std::string etc_systemd = fs::current_path().string() + "/" + TEST_OUTPUT_DIR;
-        g_etc_systemd = etc_systemd.c_str();
+        lib_systemd_ = fs::current_path().string() + "/" + TEST_UNIT_FILE_PREFIX;
+        g_lib_systemd = lib_systemd_.c_str();
+        etc_systemd_ = fs::current_path().string() + "/" + TEST_OUTPUT_DIR;
+        g_etc_systemd = etc_systemd_.c_str();
 
 
         /* Set NUM_ASIC value in asic.conf */
         fp = fopen(TEST_ASIC_CONF.c_str(), "w");
-        ASSERT_NE(fp, nullptr);
+        EXPECT_NE(fp, nullptr);
+        if (fp == nullptr) {
+            return -1;
+        }
         fputs(num_asic_str.c_str(), fp);
         fclose(fp);
 
@@ -425,13 +450,13 @@ class SsgMainTest : public SsgFunctionTest {
         if (cfg.is_smart_switch_dpu || cfg.is_smart_switch_npu) {
             nlohmann::json platform_config;
             if (cfg.is_smart_switch_dpu) {
-                ASSERT_EQ(cfg.num_dpus, 0);
-                ASSERT_EQ(cfg.is_smart_switch_npu, false);
+                EXPECT_EQ(cfg.num_dpus, 0);
+                EXPECT_EQ(cfg.is_smart_switch_npu, false);
 
                 platform_config["DPU"] = nlohmann::json::object();
             }
             else if (cfg.is_smart_switch_npu) {
-                ASSERT_EQ(cfg.is_smart_switch_dpu, false);
+                EXPECT_EQ(cfg.is_smart_switch_dpu, false);
                 nlohmann::json dpus;
                 for (int i = 0; i < cfg.num_dpus; i++) {
                     dpus["dpu" + std::to_string(i)] = nlohmann::json::object();
@@ -439,7 +464,10 @@ class SsgMainTest : public SsgFunctionTest {
                 platform_config["DPUS"] = dpus;
             }
             fp = fopen(TEST_PLATFORM_CONF.c_str(), "w");
-            ASSERT_NE(fp, nullptr);
+            EXPECT_NE(fp, nullptr);
+            if (fp == nullptr) {
+                return -1;
+            }
             fputs(platform_config.dump().c_str(), fp);
             fclose(fp);
         }
@@ -451,7 +479,14 @@ class SsgMainTest : public SsgFunctionTest {
         argv_.push_back(nullptr);
 
         /* Call ssg_main */
-        EXPECT_EQ(ssg_main(argv_.size(), argv_.data()), 0);
+        return ssg_main(argv_.size(), argv_.data());
+    }
+
+    /* ssg_main test routine.
+     * input: num_asics    number of asics
+     */
+    void ssg_main_test(const SsgMainConfig &cfg) {
+        EXPECT_EQ(run_ssg_main(cfg), 0);
 
         /* Validate systemd service template creation. */
         validate_service_file_generated_list(cfg);
@@ -463,9 +498,49 @@ class SsgMainTest : public SsgFunctionTest {
         validate_environment_variable(cfg);
     }
 
+    /* Recreate the test directory, as done before each test */
+    void reset_test_tree() {
+        fs::remove_all(fs::path(TEST_ROOT_DIR.c_str()));
+        create_test_tree();
+        create_disabled_service_links();
+    }
+
+    /* Returns the content of the test directory: directories, symlinks
+     * with their target and files with their content, in path order.
+     */
+    std::string snapshot_test_tree() {
+        std::vector<std::string> entries;
+        for (fs::recursive_directory_iterator it(TEST_ROOT_DIR), end; it != end; ++it) {
+            fs::path path = it->path();
+            std::string entry = path.string();
+            if (fs::is_symlink(fs::symlink_status(path))) {
+                entry += " -> " + fs::read_symlink(path).string();
+            } else if (fs::is_directory(path)) {
+                entry += "/";
+            } else {
+                std::ifstream file(path.string());
+                std::stringstream ss;
+                ss << file.rdbuf();
+                entry += "\n" + ss.str();
+            }
+            entries.push_back(entry);
+        }
+        std::sort(entries.begin(), entries.end());
+
+        std::string snapshot;
+        for (const auto& entry : entries) {
+            snapshot += entry + "\n";
+        }
+        return snapshot;
+    }
+
     /* Save global variables before running tests */
     virtual void SetUp() {
         SsgFunctionTest::SetUp();
+        create_disabled_service_links();
+    }
+
+    void create_disabled_service_links() {
         // Create /dev/null symlink for simulation disabled service
         std::vector<std::string> disabled_service;
         disabled_service.insert(disabled_service.end(), npu_network_service_list.begin(), npu_network_service_list.end());
@@ -482,6 +557,10 @@ class SsgMainTest : public SsgFunctionTest {
     }
 
 
+    std::string unit_file_path_;
+    std::string lib_systemd_;
+    std::string etc_systemd_;
+
   private:
     static const std::vector<std::string> single_asic_service_list;
     static const std::vector<std::string> multi_asic_service_list;
@@ -496,6 +575,13 @@ class SsgMainTest : public SsgFunctionTest {
     static const std::vector<std::string> multi_asic_dependency_list;
     static const std::vector<std::string> npu_dependency_list;
     static const std::vector<std::string> common_dependency_list;
+
+  protected:
+    static const std::string golden_single_npu_test_service;
+    static const std::string golden_2_npu_test_service;
+    static const std::string golden_2_npu_test_timer;
+    static const std::string golden_smart_switch_npu_test_service;
+    static const std::string golden_smart_switch_npu_midplane_network_service;
 };
 
 /*
@@ -612,6 +698,101 @@ SsgMainTest::npu_dependency_list = {
     "Before=database@dpu%1%.service",
 };
 
+/*
+ * The following strings define the expected content of unit files after
+ * systemd sonic generator rewrites them.
+ */
+const std::string
+SsgMainTest::golden_single_npu_test_service =
+    "[Unit]\n"
+    "Description=Multi ASIC Test service\n"
+    "After=multi_inst_a.service multi_inst_b.service\n"
+    "Before=single_inst.service\n"
+    "[Service]\n"
+    "Environment=\"NUM_DPU=0\"\n"
+    "Environment=\"IS_DPU_DEVICE=false\"\n"
+    "Type=oneshot\n"
+    "RemainAfterExit=yes\n"
+    "ExecStart=/usr/bin/test.sh start\n"
+    "[Install]\n"
+    "Alias=test.service\n"
+    "WantedBy=multi-user.target\n";
+
+const std::string
+SsgMainTest::golden_2_npu_test_service =
+    "[Unit]\n"
+    "Description=Multi ASIC Test service\n"
+    "After=multi_inst_a@0.service\n"
+    "After=multi_inst_a@1.service\n"
+    "After=multi_inst_b@0.service\n"
+    "After=multi_inst_b@1.service\n"
+    "Before=single_inst.service\n"
+    "[Service]\n"
+    "Environment=\"NUM_DPU=0\"\n"
+    "Environment=\"IS_DPU_DEVICE=false\"\n"
+    "Type=oneshot\n"
+    "RemainAfterExit=yes\n"
+    "ExecStart=/usr/bin/test.sh start\n"
+    "[Install]\n"
+    "Alias=test.service\n"
+    "WantedBy=multi-user.target\n";
+
+const std::string
+SsgMainTest::golden_2_npu_test_timer =
+    "[Unit]\n"
+    "Description=Test Timer service\n"
+    "After=multi_inst_b@0.service\n"
+    "After=multi_inst_b@1.service\n"
+    "[Timer]\n"
+    "OnUnitActiveSec=0 sec\n"
+    "OnBootSec=3min 30 sec\n"
+    "Unit=snmp.service\n"
+    "[Install]\n"
+    "WantedBy=timers.target\n"
+    "WantedBy=multi_inst_b@0.service\n"
+    "WantedBy=multi_inst_b@1.service\n"
+    "[Service]\n"
+    "Environment=\"NUM_DPU=0\"\n"
+    "Environment=\"IS_DPU_DEVICE=false\"\n";
+
+const std::string
+SsgMainTest::golden_smart_switch_npu_test_service =
+    "[Unit]\n"
+    "Description=Multi ASIC Test service\n"
+    "After=multi_inst_a.service\n"
+    "After=multi_inst_b.service\n"
+    "Before=single_inst.service\n"
+    "[Service]\n"
+    "Environment=\"NUM_DPU=2\"\n"
+    "Environment=\"IS_DPU_DEVICE=false\"\n"
+    "Type=oneshot\n"
+    "RemainAfterExit=yes\n"
+    "ExecStart=/usr/bin/test.sh start\n"
+    "[Install]\n"
+    "Alias=test.service\n"
+    "WantedBy=multi-user.target\n";
+
+const std::string
+SsgMainTest::golden_smart_switch_npu_midplane_network_service =
+    "# Oneshot midplane network service\n"
+    "\n"
+    "[Unit]\n"
+    "Before=database@dpu0.service\n"
+    "Before=database@dpu1.service\n"
+    "Description=Midplane network service\n"
+    "Requires=systemd-networkd.service\n"
+    "After=systemd-networkd.service\n"
+    "\n"
+    "[Service]\n"
+    "Environment=\"NUM_DPU=2\"\n"
+    "Environment=\"IS_DPU_DEVICE=false\"\n"
+    "Type=oneshot\n"
+    "User=root\n"
+    "ExecStart=/usr/lib/systemd/systemd-networkd-wait-online -i bridge-midplane\n"
+    "\n"
+    "[Install]\n"
+    "WantedBy=multi-user.target\n";
+
 /* Test get functions for global vasr*/
 TEST_F(SystemdSonicGeneratorFixture, get_global_vars) {
     EXPECT_EQ(g_unit_file_prefix, nullptr);
@@ -702,8 +883,8 @@ TEST_F(SsgFunctionTest, get_unit_files) {
     g_lib_systemd = TEST_UNIT_FILE_PREFIX.c_str();
     g_etc_systemd = TEST_OUTPUT_DIR.c_str();
     g_config_file = TEST_CONFIG_FILE.c_str();
-    char* unit_files[NUM_UNIT_FILES] = { NULL };
-    int num_unit_files = get_unit_files(g_config_file, unit_files, NUM_UNIT_FILES);
+    std::vector<std::string> unit_files;
+    int num_unit_files = get_unit_files(g_config_file, unit_files);
     // Exclude the midplane-network-{npu/dpu}.service which is only used for smart switch
     auto non_smart_switch_generated_services = generated_services;
     non_smart_switch_generated_services.erase(
@@ -717,12 +898,10 @@ TEST_F(SsgFunctionTest, get_unit_files) {
                     "midplane-network-dpu.service"),
         non_smart_switch_generated_services.end());
     EXPECT_EQ(num_unit_files, non_smart_switch_generated_services.size());
+    EXPECT_EQ(unit_files.size(), non_smart_switch_generated_services.size());
     for (std::string service : non_smart_switch_generated_services) {
         bool found = false;
         for (auto& unit_file : unit_files) {
-            if (unit_file == NULL) {
-                continue;
-            }
             if(unit_file == service) {
                 found = true;
                 break;
@@ -737,10 +916,74 @@ TEST_F(SsgFunctionTest, get_platform_unit_files) {
     g_unit_file_prefix = TEST_UNIT_FILE_PREFIX.c_str();
     g_config_file = TEST_CONFIG_FILE.c_str();
     g_platform_conf_format = TEST_PLATFORM_CONF_FORMAT.c_str();
-    char* unit_files[NUM_UNIT_FILES];
-    int num_unit_files = get_platform_unit_files(unit_files, NUM_UNIT_FILES);
+    std::vector<std::string> unit_files;
+    int num_unit_files = get_platform_unit_files(unit_files);
     EXPECT_EQ(num_unit_files, 1);
-    EXPECT_EQ(std::string(unit_files[0]), "platform_specific.service");
+    ASSERT_EQ(unit_files.size(), 1);
+    EXPECT_EQ(unit_files[0], "platform_specific.service");
+}
+
+/* TEST get_unit_files() with more units than the former fixed tables */
+TEST_F(SsgFunctionTest, get_unit_files_many_units) {
+    const int num_units = 1000;
+    const std::string config_file = TEST_ROOT_DIR + "many_services.conf";
+    std::ofstream config(config_file);
+    for (int i = 0; i < num_units; i++) {
+        config << "many_" << i << (i % 2 ? "@" : "") << ".service\n";
+    }
+    config.close();
+
+    std::vector<std::string> unit_files;
+    EXPECT_EQ(get_unit_files(config_file.c_str(), unit_files), num_units);
+    ASSERT_EQ(unit_files.size(), num_units);
+    EXPECT_EQ(unit_files[0], "many_0.service");
+    EXPECT_EQ(unit_files[num_units - 1], "many_999@.service");
+}
+
+/* TEST validate_install_graph() problem detection */
+TEST_F(SsgFunctionTest, validate_install_graph) {
+    g_unit_file_prefix = TEST_UNIT_FILE_PREFIX.c_str();
+
+    auto add_unit = [](ssg_install_graph& graph, const std::string& name,
+                       const std::vector<std::string>& targets) {
+        ssg_install_unit unit;
+        unit.name = name;
+        unit.targets = targets;
+        for (const auto& target : targets) {
+            ssg_install_link link;
+            link.target = target;
+            link.instance = name;
+            unit.links.push_back(link);
+        }
+        graph.index[name] = graph.units.size();
+        graph.units.push_back(unit);
+    };
+
+    /* Valid graph, targets are systemd targets, unit files or instances */
+    ssg_install_graph graph;
+    std::vector<std::string> problems;
+    add_unit(graph, "test.service", {"multi-user.target.wants"});
+    add_unit(graph, "test.timer", {"timers.target.wants", "single_inst.service.wants"});
+    add_unit(graph, "other.timer", {"test.service.wants", "multi_inst_b@3.service.requires"});
+    EXPECT_EQ(validate_install_graph(graph, problems), 0);
+    EXPECT_TRUE(problems.empty());
+
+    /* Duplicate and missing targets */
+    add_unit(graph, "dup.service", {"multi-user.target.wants", "multi-user.target.wants"});
+    add_unit(graph, "orphan.service", {"nosuch.service.wants"});
+    EXPECT_EQ(validate_install_graph(graph, problems), 2);
+    ASSERT_EQ(problems.size(), 2);
+    EXPECT_EQ(problems[0], "dup.service: duplicate install target multi-user.target.wants");
+    EXPECT_EQ(problems[1], "orphan.service: missing target unit nosuch.service");
+
+    /* Cycle between two units */
+    ssg_install_graph cycle_graph;
+    problems.clear();
+    add_unit(cycle_graph, "a.service", {"b.service.wants"});
+    add_unit(cycle_graph, "b.service", {"a.service.requires"});
+    EXPECT_EQ(validate_install_graph(cycle_graph, problems), 1);
+    ASSERT_EQ(problems.size(), 1);
+    EXPECT_EQ(problems[0], "dependency cycle b.service -> a.service -> b.service");
 }
 
 /* TEST ssg_main() argv error */
@@ -803,6 +1046,223 @@ TEST_F(SsgMainTest, ssg_main_smart_switch_double_execution) {
     ssg_main_test(cfg);
 }
 
+/* TEST load_unit_file()/save_unit_file() write back unit files unchanged */
+TEST_F(SsgFunctionTest, unit_file_round_trip) {
+    for (std::string service : generated_services) {
+        std::string path = TEST_UNIT_FILE_PREFIX + service;
+        std::ifstream file(path);
+        std::stringstream expected;
+        expected << file.rdbuf();
+
+        ssg_unit unit;
+        ASSERT_TRUE(load_unit_file(path, unit)) << "Failed to load " + path;
+        EXPECT_FALSE(unit.modified);
+        ASSERT_TRUE(save_unit_file(path, unit)) << "Failed to save " + path;
+
+        std::ifstream saved(path);
+        std::stringstream actual;
+        actual << saved.rdbuf();
+        EXPECT_EQ(actual.str(), expected.str()) << "Round trip changed " + path;
+    }
+    ssg_unit unit;
+    EXPECT_FALSE(load_unit_file(TEST_UNIT_FILE_PREFIX + "missing.service", unit));
+}
+
+/* TEST ssg_main() generated unit files, single asic */
+TEST_F(SsgMainTest, ssg_main_golden_single_npu) {
+    SsgMainConfig cfg;
+    cfg.num_asics = 1;
+    ssg_main_test(cfg);
+    validate_golden_output("test.service", golden_single_npu_test_service);
+}
+
+/* TEST ssg_main() generated unit files, multi(2) asic */
+TEST_F(SsgMainTest, ssg_main_golden_2_npu) {
+    SsgMainConfig cfg;
+    cfg.num_asics = 2;
+    ssg_main_test(cfg);
+    validate_golden_output("test.service", golden_2_npu_test_service);
+    validate_golden_output("test.timer", golden_2_npu_test_timer);
+}
+
+/* TEST ssg_main() generated unit files for smart switch NPU, the unit
+ * files are unchanged when the generator runs again.
+ */
+TEST_F(SsgMainTest, ssg_main_golden_smart_switch_npu) {
+    SsgMainConfig cfg;
+    cfg.num_asics = 1;
+    cfg.is_smart_switch_npu = true;
+    cfg.num_dpus = 2;
+    for (int i = 0; i < 2; i++) {
+        ssg_main_test(cfg);
+        validate_golden_output("test.service", golden_smart_switch_npu_test_service);
+        validate_golden_output("midplane-network-npu.service",
+            golden_smart_switch_npu_midplane_network_service);
+    }
+}
+
+/* TEST ssg_main() wall time on a synthetic 64 asic tree */
+TEST_F(SsgMainTest, ssg_main_64_npu_benchmark) {
+    const int num_bench_units = 200;
+    const std::vector<std::string> bench_dependency_list = {
+        "Requires=multi_inst_a@%1%.service",
+        "After=multi_inst_a@%1%.service",
+        "After=multi_inst_b@%1%.service",
+        "Before=single_inst.service",
+    };
+    SsgMainConfig cfg;
+    cfg.num_asics = 64;
+
+    FILE* fp = fopen(TEST_CONFIG_FILE.c_str(), "a");
+    ASSERT_NE(fp, nullptr);
+    for (int i = 0; i < num_bench_units; i++) {
+        std::string unit_name = (boost::format{"bench_%03d.service"} % i).str();
+        std::ofstream unit(TEST_UNIT_FILE_PREFIX + unit_name);
+        unit << "[Unit]\n"
+             << "Description=Benchmark service " << i << "\n"
+             << "Requires=multi_inst_a.service\n"
+             << "After=multi_inst_a.service multi_inst_b.service\n"
+             << "Before=single_inst.service\n"
+             << "[Service]\n"
+             << "ExecStart=/usr/bin/bench.sh start\n"
+             << "[Install]\n"
+             << "WantedBy=multi-user.target\n";
+        fputs((unit_name + "\n").c_str(), fp);
+    }
+    fclose(fp);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(run_ssg_main(cfg), 0);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::cout << "benchmark: " << cfg.num_asics << " asics, "
+              << num_bench_units + generated_services.size() << " units, "
+              << elapsed.count() / 1000.0 << " ms" << std::endl;
+
+    validate_service_file_generated_list(cfg);
+    validate_depedency_in_unit_file(cfg);
+    validate_environment_variable(cfg);
+    for (int i = 0; i < num_bench_units; i++) {
+        std::string unit_name = (boost::format{"bench_%03d.service"} % i).str();
+        validate_output_dependency_list(bench_dependency_list,
+            unit_name, true, cfg.num_asics);
+        EXPECT_FALSE(fs::exists(TEST_UNIT_FILE_PREFIX + unit_name + ".tmp"));
+    }
+
+    /* test.timer is wanted by every multi_inst_b instance */
+    validate_output_unit_files({"test.timer"}, "timers.target.wants", true, 1);
+    for (int i = 0; i < cfg.num_asics; i++) {
+        validate_output_unit_files({"test.timer"},
+            "multi_inst_b@" + std::to_string(i) + ".service.wants", true, 1);
+    }
+
+    std::vector<std::string> problems;
+    EXPECT_EQ(validate_install_graph(get_install_graph(), problems), 0);
+    for (const auto& problem : problems) {
+        ADD_FAILURE() << problem;
+    }
+}
+
+/* TEST ssg_main() output is the same whatever the number of install threads */
+TEST_F(SsgMainTest, ssg_main_install_threads) {
+    SsgMainConfig multi_asic_cfg;
+    multi_asic_cfg.num_asics = 16;
+    SsgMainConfig smart_switch_cfg;
+    smart_switch_cfg.num_asics = 1;
+    smart_switch_cfg.is_smart_switch_npu = true;
+    smart_switch_cfg.num_dpus = 8;
+
+    for (const auto& cfg : {multi_asic_cfg, smart_switch_cfg}) {
+        std::string expected;
+        for (int num_threads : {1, 2, 3, 8, 32}) {
+            reset_test_tree();
+            g_ssg_num_threads = num_threads;
+            ssg_main_test(cfg);
+            std::string snapshot = snapshot_test_tree();
+            if (expected.empty()) {
+                expected = snapshot;
+            } else {
+                EXPECT_EQ(snapshot, expected) << "Output differs with "
+                    << num_threads << " threads";
+            }
+        }
+    }
+}
+
+/* TEST ssg_main() install errors are reported in the same order whatever
+ * the number of install threads.
+ */
+TEST_F(SsgMainTest, ssg_main_install_errors) {
+    SsgMainConfig cfg;
+    cfg.num_asics = 8;
+    std::string expected;
+
+    for (int num_threads : {1, 4, 16}) {
+        reset_test_tree();
+        g_ssg_num_threads = num_threads;
+
+        /* A dangling symlink in place of a target directory */
+        fs::create_symlink("/nonexistent", TEST_OUTPUT_DIR + "multi-user.target.wants");
+
+        testing::internal::CaptureStderr();
+        EXPECT_EQ(run_ssg_main(cfg), 0);
+        std::string errors = testing::internal::GetCapturedStderr();
+
+        EXPECT_NE(errors.find("Unable to create target directory"), std::string::npos);
+        EXPECT_NE(errors.find("Error installing multi_inst_a@.service for target multi-user.target.wants"),
+                  std::string::npos);
+        validate_output_unit_files({"test.timer"}, "timers.target.wants", true, 1);
+        if (expected.empty()) {
+            expected = errors;
+        } else {
+            EXPECT_EQ(errors, expected) << "Errors differ with "
+                << num_threads << " threads";
+        }
+    }
+}
+
+/* TEST ssg_main() with a unit installed in many targets */
+TEST_F(SsgMainTest, ssg_main_many_install_targets) {
+    const int num_targets = 200;
+    SsgMainConfig cfg;
+    cfg.num_asics = 1;
+
+    std::ofstream unit(TEST_UNIT_FILE_PREFIX + "wide.service");
+    unit << "[Unit]\n"
+         << "Description=Service installed in many targets\n"
+         << "[Service]\n"
+         << "ExecStart=/usr/bin/wide.sh\n"
+         << "[Install]\n";
+    for (int i = 0; i < num_targets; i++) {
+        unit << (i % 2 ? "RequiredBy=" : "WantedBy=") << "wide_" << i << ".target\n";
+    }
+    unit.close();
+
+    std::ofstream config(TEST_CONFIG_FILE, std::ios::app);
+    config << "wide.service\n";
+    config.close();
+
+    EXPECT_EQ(run_ssg_main(cfg), 0);
+
+    for (int i = 0; i < num_targets; i++) {
+        std::string target = "wide_" + std::to_string(i) + (i % 2 ? ".target.requires" : ".target.wants");
+        validate_output_unit_files({"wide.service"}, target, true, 1);
+    }
+
+    const ssg_install_graph& graph = get_install_graph();
+    ASSERT_EQ(graph.index.count("wide.service"), 1);
+    const ssg_install_unit& wide = graph.units[graph.index.at("wide.service")];
+    EXPECT_EQ(wide.targets.size(), num_targets);
+    EXPECT_EQ(wide.links.size(), num_targets);
+
+    std::vector<std::string> problems;
+    EXPECT_EQ(validate_install_graph(graph, problems), 0);
+    for (const auto& problem : problems) {
+        ADD_FAILURE() << problem;
+    }
+}
+
 }
 
 int main(int argc, char** argv) {
@@ -13,13 +13,17 @@
 #include <unordered_set>
 #include <fstream>
 #include <unordered_map>
+#include <vector>
 #include <regex>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <system_error>
+#include <fcntl.h>
+#include "systemd-sonic-generator.h"
 
-#define MAX_NUM_TARGETS 48
-#define MAX_NUM_INSTALL_LINES 48
-#define MAX_NUM_UNITS 128
-#define MAX_BUF_SIZE 512
 #define MAX_PLATFORM_NAME_LEN 64
+#define SSG_MAX_THREADS 8
 
 
 
@@ -74,17 +78,20 @@ const char* get_platform_conf_format() {
     return (g_platform_conf_format) ? g_platform_conf_format : PLATFORM_CONF_FORMAT;
 }
 
+int g_ssg_num_threads = 0;
+
 const char* get_platform();
 
 static int num_asics;
-static char** multi_instance_services;
-static int num_multi_inst;
+static std::unordered_set<std::string> multi_instance_services;
 static bool smart_switch_npu;
 static bool smart_switch_dpu;
 static bool smart_switch;
 static int num_dpus;
 static char* platform = NULL;
 static struct json_object *platform_info = NULL;
+static std::unordered_map<std::string, ssg_unit> unit_cache;
+static ssg_install_graph install_graph;
 
 
 #ifdef _SSG_UNITTEST
@@ -169,62 +176,181 @@ static bool is_devnull(const char* path)
 }
 
 
-static int get_target_lines(const char* unit_file, char* target_lines[]) {
+static std::string trim(const std::string& str) {
     /***
-    Gets installation information for a given unit file
-
-    Returns lines in the [Install] section of a unit file
+    Strips leading and trailing whitespace from a string
     ***/
-    FILE *fp;
-    char *line = NULL;
-    size_t len = 0;
-    ssize_t nread;
-    bool found_install;
-    int num_target_lines;
+    const char* whitespace = " \t\r\n";
+    size_t start = str.find_first_not_of(whitespace);
 
+    if (start == std::string::npos) {
+        return "";
+    }
+    return str.substr(start, str.find_last_not_of(whitespace) - start + 1);
+}
 
-    fp = fopen(unit_file, "r");
 
-    if (fp == NULL) {
-        fprintf(stderr, "Failed to open file %s\n", unit_file);
-        return -1;
+static ssg_unit_line make_unit_line(const std::string& key, const std::string& value) {
+    ssg_unit_line line;
+
+    line.key = key;
+    line.value = value;
+    return line;
+}
+
+
+/**
+ * Parses a unit file into its in-memory representation.
+ *
+ * @param path The path of the unit file.
+ * @param unit The unit to fill in.
+ * @return true if the unit file was read, false otherwise.
+ */
+bool load_unit_file(const std::string& path, ssg_unit& unit) {
+    std::ifstream src_file(path);
+    std::string line;
+
+    if (!src_file.is_open()) {
+        return false;
     }
 
-    found_install = false;
-    num_target_lines = 0;
+    unit.sections.assign(1, ssg_unit_section());
+    unit.deps_rewritten = false;
+    unit.modified = false;
+
+    while (std::getline(src_file, line)) {
+        std::string trimmed = trim(line);
 
-    while ((nread = getline(&line, &len, fp)) != -1 ) {
-        // Assumes that [Install] is the last section of the unit file
-        if (strstr(line, "[Install]") != NULL) {
-             found_install = true;
+        if (trimmed.size() >= 2 && trimmed.front() == '[' && trimmed.back() == ']') {
+            ssg_unit_section section;
+            section.name = trimmed.substr(1, trimmed.size() - 2);
+            unit.sections.push_back(section);
+            continue;
         }
-        else if (found_install) {
-            if (num_target_lines >= MAX_NUM_INSTALL_LINES) {
-                fprintf(stderr, "Number of lines in [Install] section of %s exceeds MAX_NUM_INSTALL_LINES\n", unit_file);
-                fputs("Extra [Install] lines will be ignored\n", stderr);
-                break;
+
+        ssg_unit_line unit_line;
+        unit_line.text = line;
+        if (!trimmed.empty() && trimmed[0] != '#' && trimmed[0] != ';') {
+            size_t pos = trimmed.find('=');
+            if (pos != std::string::npos) {
+                unit_line.key = trim(trimmed.substr(0, pos));
+                unit_line.value = trim(trimmed.substr(pos + 1));
             }
-            target_lines[num_target_lines] = strdup(line);
-            num_target_lines++;
         }
+        unit.sections.back().lines.push_back(unit_line);
     }
 
-    free(line);
+    return true;
+}
 
-    fclose(fp);
 
-    return num_target_lines;
+/**
+ * Writes a unit back to disk.
+ *
+ * The unit is written to a temporary file which is then renamed over
+ * the original one. Lines read from the original file are written
+ * as they were, generated lines as "key=value".
+ *
+ * @param path The path of the unit file.
+ * @param unit The unit to write.
+ * @param error Set to the failure message on failure.
+ * @return true if the unit file was written, false otherwise.
+ */
+static bool write_unit_file(const std::string& path, const ssg_unit& unit, std::string& error) {
+    std::string tmp_path = path + ".tmp";
+    std::ofstream tmp_file(tmp_path);
+
+    if (!tmp_file.is_open()) {
+        error = "Failed to open " + tmp_path;
+        return false;
+    }
+
+    for (const auto& section : unit.sections) {
+        if (!section.name.empty()) {
+            tmp_file << "[" << section.name << "]\n";
+        }
+        for (const auto& line : section.lines) {
+            if (!line.key.empty() && line.text.empty()) {
+                tmp_file << line.key << "=" << line.value << "\n";
+            } else {
+                tmp_file << line.text << "\n";
+            }
+        }
+    }
+
+    tmp_file.close();
+    if (tmp_file.fail()) {
+        error = "Failed to write " + tmp_path;
+        remove(tmp_path.c_str());
+        return false;
+    }
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        error = "Failed to rename " + tmp_path;
+        remove(tmp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+bool save_unit_file(const std::string& path, const ssg_unit& unit) {
+    std::string error;
+
+    if (!write_unit_file(path, unit, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+static ssg_unit_section* find_unit_section(ssg_unit& unit, const std::string& name) {
+    for (auto& section : unit.sections) {
+        if (section.name == name) {
+            return &section;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * Returns the in-memory unit for a unit file, loading it on first use.
+ *
+ * Units stay cached until the end of the generator run, so that all
+ * transformations are applied to a single copy of each unit file,
+ * which is then written once.
+ *
+ * @param path The path of the unit file.
+ * @return The unit, or NULL if the unit file can't be read.
+ */
+static ssg_unit* get_unit(const std::string& path) {
+    auto it = unit_cache.find(path);
+    if (it != unit_cache.end()) {
+        return &it->second;
+    }
+
+    ssg_unit unit;
+    if (!load_unit_file(path, unit)) {
+        fprintf(stderr, "Failed to open file %s\n", path.c_str());
+        return NULL;
+    }
+    return &unit_cache.emplace(path, std::move(unit)).first->second;
 }
 
-static bool is_multi_instance_service(std::string service_file, std::unordered_set<std::string> service_list=std::unordered_set<std::string>()){
+
+static bool is_multi_instance_service(const std::string& service_file,
+                                      const std::unordered_set<std::string>& service_list = multi_instance_services) {
     /*
         * The service name may contain @.service or .service. Remove these
         * postfixes and extract service name. Compare service name for absolute
-        * match in multi_instance_services[].
+        * match in service_list, multi_instance_services by default.
         * This is to prevent services like database-chassis and systemd-timesyncd marked
         * as multi instance services as they contain strings 'database' and 'syncd' respectively
-        * which are multi instance services in multi_instance_services[].
-        */    
+        * which are multi instance services in multi_instance_services.
+        */
     std::string delimiter;
     if (service_file.find("@") != std::string::npos) {
         delimiter = "@";
@@ -233,20 +359,7 @@ static bool is_multi_instance_service(std::string service_file, std::unordered_s
     }
     std::string service_name = service_file.substr(0, service_file.find(delimiter));
 
-    if (service_list.empty()) {
-        for(int i=0; i < num_multi_inst; i++){
-
-            if (service_name == multi_instance_services[i]) {
-                return true;
-            }
-        }
-    } else {
-        if (service_list.count(service_name) > 0) {
-            return true;
-        }
-    }
-    return false;
-
+    return service_list.count(service_name) > 0;
 }
 
 
@@ -261,17 +374,17 @@ static bool is_multi_instance_service_for_dpu(const std::string& service_name) {
         return false;
     }
 
-    std::unordered_set<std::string> multi_instance_services_for_dpu = {"database"};
+    static const std::unordered_set<std::string> multi_instance_services_for_dpu = {"database"};
     return is_multi_instance_service(service_name, multi_instance_services_for_dpu);
 }
 
 
-static int get_install_targets_from_line(std::string target_string, std::string install_type, char* targets[], int existing_targets) {
+static int get_install_targets_from_line(const std::string& target_string, const std::string& install_type, std::vector<std::string>& targets) {
     /***
     Helper fuction for get_install_targets
 
     Given a space delimited string of target directories and a suffix,
-    puts each target directory plus the suffix into the targets array
+    appends each target directory plus the suffix to targets
     ***/
     std::string target;
     int num_targets = 0;
@@ -284,224 +397,176 @@ static int get_install_targets_from_line(std::string target_string, std::string
     std::stringstream ss(target_string);
 
     while (ss >> target) {
-        if (num_targets + existing_targets >= MAX_NUM_TARGETS) {
-            fprintf(stderr, "Number of targets exceeds MAX_NUM_TARGETS\n");
-            fputs("Additional targets will be ignored\n", stderr);
-            break;
-        }
         // handle install targets using the '%i' systemd specifier
         if (target.find("%") != std::string::npos) {
             target = target.substr(0, target.find("%")) + target.substr(target.find("."));
         }
         strip_trailing_newline(target);
-        target += install_type;
-        targets[num_targets + existing_targets] = (char*) calloc(target.length() + 1, sizeof(char));
-        snprintf(targets[num_targets + existing_targets], PATH_MAX, "%s", target.c_str());
+        targets.push_back(target + install_type);
         num_targets++;
     }
     return num_targets;
 }
 
-static void replace_multi_inst_dep(const char *src) {
-    FILE *fp_src;
-    FILE *fp_tmp;
-    char buf[MAX_BUF_SIZE];
-    char* line = NULL;
-    int i;
-    size_t len;
-    char *token;
-    char *word;
-    char *line_copy;
-    char *service_name;
-    char *type;
-    char *save_ptr1 = NULL;
-    char *save_ptr2 = NULL;
-    ssize_t nread;
-    bool section_done = false;
-    char tmp_file_path[PATH_MAX];
-
-    /* Assumes that the service files has 3 sections,
-     * in the order: Unit, Service and Install.
-     * Assumes that the timer file has 3 sections,
-     * in the order: Unit, Timer and Install.
-     * Read service dependency from Unit and Install
+static void replace_multi_inst_dep(ssg_unit& unit) {
+    /* Read service dependency from Unit and Install
      * sections, replace if dependent on multi instance
-     * service.
+     * service. Each dependency is put on a line of its own.
      */
-    fp_src = fopen(src, "r");
-    snprintf(tmp_file_path, PATH_MAX, "%s.tmp", src);
-    fp_tmp = fopen(tmp_file_path, "w");
-
-    while ((nread = getline(&line, &len, fp_src)) != -1 ) {
-        if ((strstr(line, "[Service]") != NULL) ||
-            (strstr(line, "[Timer]") != NULL)) {
-            section_done = true;
-            fputs(line,fp_tmp);
-        } else if (strstr(line, "[Install]") != NULL) {
-            section_done = false;
-            fputs(line,fp_tmp);
-        } else if ((strstr(line, "[Unit]") != NULL) ||
-           (strstr(line, "Description") != NULL) ||
-           (section_done == true)) {
-            fputs(line,fp_tmp);
-        } else {
-            line_copy = strdup(line);
-            token = strtok_r(line_copy, "=", &save_ptr1);
-            while ((word = strtok_r(NULL, " ", &save_ptr1))) {
-                if((strchr(word, '.') == NULL) ||
-                   (strchr(word, '@') != NULL)) {
-                    snprintf(buf, MAX_BUF_SIZE,"%s=%s\n",token, word);
-                    fputs(buf,fp_tmp);
-                } else {
-                    service_name = strdup(word);
-                    service_name = strtok_r(service_name, ".", &save_ptr2);
-                    type = strtok_r(NULL, "\n", &save_ptr2);
-                    if (num_asics > 1 &&  is_multi_instance_service(word)) {
-                        for(i = 0; i < num_asics; i++) {
-                            snprintf(buf, MAX_BUF_SIZE, "%s=%s@%d.%s\n",
-                                    token, service_name, i, type);
-                            fputs(buf,fp_tmp);
-                        }
-                    } else if (smart_switch_npu && is_multi_instance_service_for_dpu(word)) {
-                        for(i = 0; i < num_dpus; i++) {
-                            snprintf(buf, MAX_BUF_SIZE, "%s=%s@%s%d.%s\n",
-                                    token, service_name, DPU_PREFIX, i, type);
-                            fputs(buf,fp_tmp);
-                        }
-                    } else {
-                        snprintf(buf, MAX_BUF_SIZE,"%s=%s.%s\n",token, service_name, type);
-                        fputs(buf, fp_tmp);
+    if (unit.deps_rewritten) {
+        return;
+    }
+
+    for (auto& section : unit.sections) {
+        if (section.name != "Unit" && section.name != "Install") {
+            continue;
+        }
+
+        std::vector<ssg_unit_line> lines;
+        for (const auto& line : section.lines) {
+            if (line.key.empty() || line.key == "Description" || line.value.empty()) {
+                lines.push_back(line);
+                continue;
+            }
+
+            std::stringstream ss(line.value);
+            std::string word;
+            while (ss >> word) {
+                if ((word.find('.') == std::string::npos) ||
+                    (word.find('@') != std::string::npos)) {
+                    lines.push_back(make_unit_line(line.key, word));
+                    continue;
+                }
+
+                std::string service_name = word.substr(0, word.find('.'));
+                std::string type = word.substr(word.find('.') + 1);
+                if (num_asics > 1 && is_multi_instance_service(word)) {
+                    for (int i = 0; i < num_asics; i++) {
+                        lines.push_back(make_unit_line(line.key,
+                            service_name + "@" + std::to_string(i) + "." + type));
                     }
-                    free(service_name);
+                } else if (smart_switch_npu && is_multi_instance_service_for_dpu(word)) {
+                    for (int i = 0; i < num_dpus; i++) {
+                        lines.push_back(make_unit_line(line.key,
+                            service_name + "@" + DPU_PREFIX + std::to_string(i) + "." + type));
+                    }
+                } else {
+                    lines.push_back(make_unit_line(line.key, word));
                 }
             }
-            free(line_copy);
         }
+        section.lines.swap(lines);
     }
-    fclose(fp_src);
-    fclose(fp_tmp);
-    free(line);
-    /* remove the .service file, rename the .service.tmp file
-     * as .service.
-     */
-    remove(src);
-    rename(tmp_file_path, src);
+
+    unit.deps_rewritten = true;
+    unit.modified = true;
 }
 
-static void update_environment(const std::string &src)
+static void update_environment(ssg_unit& unit)
 {
-    std::ifstream src_file(src);
-    std::ofstream tmp_file(src + ".tmp");
-    bool has_service_section = false;
-    std::string line;
+    const static std::regex env_var_regex("^\"?(\\w+)");
+    const std::vector<std::pair<std::string, std::string>> env_vars = {
+        {"NUM_DPU", std::to_string(num_dpus)},
+        {"IS_DPU_DEVICE", (smart_switch_dpu ? "true" : "false")},
+    };
 
     // locate the [Service] section
-    while (std::getline(src_file, line)) {
-        tmp_file << line << std::endl;
-        if (line.find("[Service]") != std::string::npos) {
-            has_service_section = true;
-            break;
+    ssg_unit_section* service = find_unit_section(unit, "Service");
+    if (service == NULL) {
+        ssg_unit_section section;
+        section.name = "Service";
+        unit.sections.push_back(section);
+        service = &unit.sections.back();
+    }
+
+    std::vector<ssg_unit_line> lines;
+    for (const auto& env_var : env_vars) {
+        lines.push_back(make_unit_line("Environment",
+            "\"" + env_var.first + "=" + env_var.second + "\""));
+    }
+
+    for (const auto& line : service->lines) {
+        // skip the existing environment variables
+        std::smatch match;
+        if (line.key == "Environment" && std::regex_search(line.value, match, env_var_regex)) {
+            bool injected = false;
+            for (const auto& env_var : env_vars) {
+                injected = injected || (match[1] == env_var.first);
+            }
+            if (injected) {
+                continue;
+            }
         }
+        lines.push_back(line);
     }
+    service->lines.swap(lines);
 
-    if (!has_service_section) {
-        tmp_file << "[Service]" << std::endl;
-    }
+    unit.modified = true;
+}
 
-    std::unordered_map<std::string, std::string> env_vars;
-    env_vars["IS_DPU_DEVICE"] = (smart_switch_dpu ? "true" : "false");
-    env_vars["NUM_DPU"] = std::to_string(num_dpus);
+static int get_unit_install_targets(ssg_unit& unit, std::vector<std::string>& targets) {
+    /***
+    Returns install targets for an in-memory unit
 
-    for (const auto& [key, value] : env_vars) {
-        tmp_file << "Environment=\"" << key << "=" << value << "\"" << std::endl;
+    Parses the information in the [Install] section of the
+    unit to determine which directories to install the unit in
+    ***/
+    int num_targets = 0;
+    std::string target_suffix;
+    ssg_unit_section* install = find_unit_section(unit, "Install");
+
+    if (install == NULL) {
+        return 0;
     }
 
-    // copy the rest of the file
-    if (has_service_section) {
-        const static std::regex env_var_regex("Environment=\"?(\\w+)");
-        while (std::getline(src_file, line)) {
-            // skip the existing environment variables
-            std::smatch match;
-            if (std::regex_search(line, match, env_var_regex)) {
-                if (env_vars.find(match[1]) != env_vars.end()) {
-                    continue;
-                }
-            }
-            tmp_file << line << std::endl;
+    for (const auto& line : install->lines) {
+        if (line.key.find("RequiredBy") != std::string::npos) {
+            target_suffix = ".requires";
+        } else if (line.key.find("WantedBy") != std::string::npos) {
+            target_suffix = ".wants";
+        } else {
+            continue;
         }
-    }
 
-    src_file.close();
-    tmp_file.close();
-    // remove the original file and rename the temporary file
-    remove(src.c_str());
-    rename((src + ".tmp").c_str(), src.c_str());
+        if (!line.value.empty()) {
+            num_targets += get_install_targets_from_line(line.value, target_suffix, targets);
+        }
+    }
+    return num_targets;
 }
 
-int get_install_targets(std::string unit_file, char* targets[]) {
+int get_install_targets(const std::string& unit_file, std::vector<std::string>& targets) {
     /***
     Returns install targets for a unit file
 
-    Parses the information in the [Install] section of a given
-    unit file to determine which directories to install the unit in
+    Loads the unit file, rewrites its multi instance dependencies
+    if needed, and appends the targets of its [Install] section.
+    Changes to the unit are written back by run_install_plan().
     ***/
     std::string file_path;
-    char *target_lines[MAX_NUM_INSTALL_LINES];
-    int num_target_lines;
-    int num_targets;
-    int found_targets;
-    char* token;
-    char* line = NULL;
-    bool first;
-    std::string target_suffix;
     std::string instance_name;
+    ssg_unit* unit;
 
     file_path = get_unit_file_prefix() + unit_file;
 
-    instance_name = unit_file.substr(0, unit_file.find('.'));
-
-    if(((num_asics > 1) && (!is_multi_instance_service(instance_name)))
-        || ((num_dpus > 0) && (!is_multi_instance_service_for_dpu(instance_name)))) {
-        replace_multi_inst_dep(file_path.c_str());
-    }
-
-    num_target_lines = get_target_lines(file_path.c_str(), target_lines);
-    if (num_target_lines < 0) {
+    unit = get_unit(file_path);
+    if (unit == NULL) {
         fprintf(stderr, "Error parsing targets for %s\n", unit_file.c_str());
         return -1;
     }
 
-    num_targets = 0;
-
-    for (int i = 0; i < num_target_lines; i++) {
-        line = target_lines[i];
-        first = true;
-
-        while ((token = strtok_r(line, "=", &line))) {
-            if (first) {
-                first = false;
+    instance_name = unit_file.substr(0, unit_file.find('.'));
 
-                if (strstr(token, "RequiredBy") != NULL) {
-                    target_suffix = ".requires";
-                }
-                else if (strstr(token, "WantedBy") != NULL) {
-                    target_suffix = ".wants";
-                } else {
-                    break;
-                }
-            }
-            else {
-                found_targets = get_install_targets_from_line(token, target_suffix, targets, num_targets);
-                num_targets += found_targets;
-            }
-        }
-        free(target_lines[i]);
+    if(((num_asics > 1) && (!is_multi_instance_service(instance_name)))
+        || ((num_dpus > 0) && (!is_multi_instance_service_for_dpu(instance_name)))) {
+        replace_multi_inst_dep(*unit);
     }
-    return num_targets;
+
+    return get_unit_install_targets(*unit, targets);
 }
 
 
-int get_unit_files(const char* config_file, char* unit_files[], int unit_files_size) {
+int get_unit_files(const char* config_file, std::vector<std::string>& unit_files) {
     /***
     Reads a list of unit files to be installed from config_file
     ***/
@@ -520,24 +585,13 @@ int get_unit_files(const char* config_file, char* unit_files[], int unit_files_s
 
     int num_unit_files = 0;
 
-    if (!multi_instance_services) {
-        num_multi_inst = 0;
-        multi_instance_services = (char**) calloc(MAX_NUM_UNITS, sizeof(char *));
-    }
-
     while ((read = getline(&line, &len, fp)) != -1) {
-        if (num_unit_files >= unit_files_size) {
-            fprintf(stderr, "Maximum number of units exceeded, ignoring extras\n");
-            break;
-        }
         strip_trailing_newline(line);
 
         /* Get the multi-instance services */
         pos = strchr(line, '@');
         if (pos != NULL) {
-            multi_instance_services[num_multi_inst] = (char*) calloc(pos-line+1, sizeof(char));
-            snprintf(multi_instance_services[num_multi_inst], pos-line+1, "%s", line);
-            num_multi_inst++;
+            multi_instance_services.insert(std::string(line, pos - line));
         }
 
         /* topology service to be started only for multiasic VS platform */
@@ -552,7 +606,7 @@ int get_unit_files(const char* config_file, char* unit_files[], int unit_files_s
             continue;
         }
 
-        unit_files[num_unit_files] = strdup(line);
+        unit_files.push_back(line);
         num_unit_files++;
     }
 
@@ -563,7 +617,7 @@ int get_unit_files(const char* config_file, char* unit_files[], int unit_files_s
     return num_unit_files;
 }
 
-int get_platform_unit_files(char* unit_files[], int unit_files_size)
+int get_platform_unit_files(std::vector<std::string>& unit_files)
 {
     const char* platform = get_platform();
     if (!platform) {
@@ -577,7 +631,7 @@ int get_platform_unit_files(char* unit_files[], int unit_files_size)
         return 0;
     }
 
-    return get_unit_files(config_file, unit_files, unit_files_size);
+    return get_unit_files(config_file, unit_files);
 }
 
 
@@ -598,84 +652,568 @@ std::string insert_instance_number(const std::string& unit_file, int instance, c
 }
 
 
-static int create_symlink(const std::string& unit, const std::string& target, const std::string& install_dir, int instance,  const std::string& instance_prefix) {
+/**
+ * Records the install targets of a unit in the install graph.
+ *
+ * A unit installed again in the same run keeps the targets it was
+ * first recorded with.
+ *
+ * @param unit The unit file name.
+ * @param targets The install targets of the unit.
+ */
+static void add_install_unit(const std::string& unit, const std::vector<std::string>& targets) {
+    if (install_graph.index.count(unit) > 0) {
+        return;
+    }
+
+    ssg_install_unit install_unit;
+    install_unit.name = unit;
+    install_unit.targets = targets;
+    install_graph.index[unit] = install_graph.units.size();
+    install_graph.units.push_back(install_unit);
+}
+
+
+/**
+ * Records a unit instance installed in a target directory.
+ *
+ * @param unit The unit file name.
+ * @param target The target directory, e.g. multi-user.target.wants.
+ * @param instance The unit instance linked in the target directory.
+ */
+static void add_install_link(const std::string& unit, const std::string& target, const std::string& instance) {
+    if (!install_graph.links.insert(unit + " " + target + "/" + instance).second) {
+        return;
+    }
+
+    add_install_unit(unit, std::vector<std::string>());
+
+    ssg_install_link link;
+    link.target = target;
+    link.instance = instance;
+    install_graph.units[install_graph.index[unit]].links.push_back(link);
+}
+
+
+const ssg_install_graph& get_install_graph() {
+    return install_graph;
+}
+
+
+/**
+ * Returns the unit a target directory belongs to,
+ * e.g. multi-user.target for multi-user.target.wants.
+ */
+static std::string get_target_unit(const std::string& target) {
+    for (const char* suffix : {".wants", ".requires"}) {
+        size_t len = strlen(suffix);
+        if (target.size() > len && target.compare(target.size() - len, len, suffix) == 0) {
+            return target.substr(0, target.size() - len);
+        }
+    }
+    return target;
+}
+
+
+/**
+ * Checks if a unit file, or the template of a unit instance, exists.
+ */
+static bool unit_file_exists(const std::string& unit) {
     struct stat st;
-    std::string src_path;
-    std::string dest_path;
-    std::string final_install_dir;
-    std::string unit_instance;
-    int r;
 
-    src_path = get_unit_file_prefix() + unit;
+    if (stat((get_unit_file_prefix() + unit).c_str(), &st) == 0) {
+        return true;
+    }
 
-    if (instance < 0) {
-        unit_instance = unit;
+    size_t at_pos = unit.find("@");
+    size_t dot_pos = unit.rfind(".");
+    if (at_pos == std::string::npos || dot_pos == std::string::npos || dot_pos < at_pos) {
+        return false;
     }
-    else {
-        unit_instance = insert_instance_number(unit, instance, instance_prefix);
+    std::string unit_template = unit.substr(0, at_pos + 1) + unit.substr(dot_pos);
+    return stat((get_unit_file_prefix() + unit_template).c_str(), &st) == 0;
+}
+
+
+static void find_install_cycles(const std::string& node,
+                                const std::unordered_map<std::string, std::vector<std::string>>& edges,
+                                std::unordered_map<std::string, int>& state,
+                                std::vector<std::string>& path,
+                                std::vector<std::string>& problems) {
+    /***
+    Depth first search from node, state is 1 while a node is on the
+    current path and 2 once all its descendants were visited
+    ***/
+    state[node] = 1;
+    path.push_back(node);
+
+    auto it = edges.find(node);
+    if (it != edges.end()) {
+        for (const auto& next : it->second) {
+            int next_state = state[next];
+            if (next_state == 1) {
+                std::string cycle;
+                auto start = std::find(path.begin(), path.end(), next);
+                for (; start != path.end(); ++start) {
+                    cycle += *start + " -> ";
+                }
+                problems.push_back("dependency cycle " + cycle + next);
+            } else if (next_state == 0) {
+                find_install_cycles(next, edges, state, path, problems);
+            }
+        }
+    }
+
+    path.pop_back();
+    state[node] = 2;
+}
+
+
+/**
+ * Validates the install graph.
+ *
+ * Reports units listing the same install target more than once, target
+ * units which are neither generated instances nor unit files (systemd
+ * .target units are assumed to exist), and cycles between targets and
+ * the unit instances installed in them. Problems are reported in graph
+ * order.
+ *
+ * @param graph The install graph.
+ * @param problems Appended with a description of each problem found.
+ * @return The number of problems found.
+ */
+int validate_install_graph(const ssg_install_graph& graph, std::vector<std::string>& problems) {
+    size_t num_problems = problems.size();
+    std::unordered_map<std::string, std::vector<std::string>> edges;
+    std::unordered_set<std::string> instances;
+    std::unordered_set<std::string> checked;
+    std::vector<std::string> roots;
+
+    for (const auto& unit : graph.units) {
+        std::unordered_set<std::string> seen;
+        for (const auto& target : unit.targets) {
+            if (!seen.insert(target).second) {
+                problems.push_back(unit.name + ": duplicate install target " + target);
+            }
+        }
+        for (const auto& link : unit.links) {
+            std::string target_unit = get_target_unit(link.target);
+            instances.insert(link.instance);
+            edges[target_unit].push_back(link.instance);
+            roots.push_back(target_unit);
+        }
+    }
+
+    for (const auto& unit : graph.units) {
+        for (const auto& link : unit.links) {
+            std::string target_unit = get_target_unit(link.target);
+            if (!checked.insert(target_unit).second) {
+                continue;
+            }
+            if (target_unit.size() > strlen(".target") &&
+                target_unit.compare(target_unit.size() - strlen(".target"), std::string::npos, ".target") == 0) {
+                continue;
+            }
+            if (instances.count(target_unit) == 0 && !unit_file_exists(target_unit)) {
+                problems.push_back(unit.name + ": missing target unit " + target_unit);
+            }
+        }
+    }
+
+    std::unordered_map<std::string, int> state;
+    std::vector<std::string> path;
+    for (const auto& root : roots) {
+        if (state[root] == 0) {
+            find_install_cycles(root, edges, state, path, problems);
+        }
+    }
+
+    return problems.size() - num_problems;
+}
+
+
+/**
+ * Dumps the install graph as unit -> target -> instance.
+ *
+ * @param graph The install graph.
+ * @param fp The stream to dump the graph to.
+ */
+void dump_install_graph(const ssg_install_graph& graph, FILE* fp) {
+    for (const auto& unit : graph.units) {
+        fprintf(fp, "unit %s\n", unit.name.c_str());
+        for (const auto& target : unit.targets) {
+            fprintf(fp, "  target %s\n", target.c_str());
+        }
+        for (const auto& link : unit.links) {
+            fprintf(fp, "  link %s/%s\n", link.target.c_str(), link.instance.c_str());
+        }
+    }
+}
+
+
+/*
+ * Symlinks and unit files are not created while units are parsed. The
+ * generator first plans every filesystem operation, then performs them
+ * with a bounded pool of threads, relative to pre-opened directories.
+ * Target directories are prepared before any symlink is created in them.
+ * Errors are reported in plan order, whatever the number of threads.
+ */
+enum ssg_install_op_type {
+    SSG_OP_MKDIR,           /* Create or fix up a target directory */
+    SSG_OP_LINK,            /* Create a symlink, unless it already exists */
+    SSG_OP_RELINK,          /* Replace an existing file by a symlink */
+    SSG_OP_WRITE_UNIT,      /* Write back a modified unit file */
+};
+
+struct ssg_install_op {
+    ssg_install_op_type type;
+    int dir_fd;             /* Directory path is relative to */
+    std::string dir;        /* Name of dir_fd, for messages */
+    std::string path;
+    std::string src;        /* Symlink source */
+    const ssg_unit* unit;   /* Unit to write */
+    std::string unit_name;  /* Installed unit and target, for messages */
+    std::string target;
+    int mkdir_op;           /* Target directory op, -1 if none */
+    bool fatal;             /* A failure fails the generator */
+    bool failed;            /* Set by the executor */
+    int err;                /* errno of the failure, 0 if not relevant */
+    std::string error;      /* Failure message */
+};
+
+struct ssg_install_plan {
+    int install_fd = -1;
+    std::string install_dir;
+    int network_fd = -1;
+    std::string network_dir;
+    std::vector<ssg_install_op> dirs;
+    std::vector<ssg_install_op> ops;
+    std::unordered_map<std::string, size_t> dir_index;
+    std::unordered_set<std::string> paths;
+};
+
+static ssg_install_plan install_plan;
+
+
+static ssg_install_op make_install_op(ssg_install_op_type type, int dir_fd, const std::string& dir, const std::string& path) {
+    ssg_install_op op;
+
+    op.type = type;
+    op.dir_fd = dir_fd;
+    op.dir = dir;
+    op.path = path;
+    op.unit = NULL;
+    op.mkdir_op = -1;
+    op.fatal = false;
+    op.failed = false;
+    op.err = 0;
+    return op;
+}
+
+
+/**
+ * Plans the creation of a target directory, once per directory.
+ *
+ * @return The index of the directory op in the plan.
+ */
+static int plan_target_dir(const std::string& target) {
+    auto it = install_plan.dir_index.find(target);
+    if (it != install_plan.dir_index.end()) {
+        return it->second;
+    }
+
+    install_plan.dirs.push_back(make_install_op(SSG_OP_MKDIR, install_plan.install_fd, install_plan.install_dir, target));
+    install_plan.dir_index[target] = install_plan.dirs.size() - 1;
+    return install_plan.dirs.size() - 1;
+}
+
+
+/**
+ * Plans a symlink, once per symlink path.
+ */
+static void plan_symlink(ssg_install_op op) {
+    if (!install_plan.paths.insert(op.dir + op.path).second) {
+        return;
+    }
+    install_plan.ops.push_back(op);
+}
+
+
+/**
+ * Plans the write of every modified unit, in path order.
+ */
+static void plan_unit_writes() {
+    std::vector<std::string> paths;
+
+    for (const auto& entry : unit_cache) {
+        if (entry.second.modified) {
+            paths.push_back(entry.first);
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const auto& path : paths) {
+        ssg_install_op op = make_install_op(SSG_OP_WRITE_UNIT, AT_FDCWD, "", path);
+        op.unit = &unit_cache[path];
+        install_plan.ops.push_back(op);
     }
+}
+
+
+/**
+ * Checks if a path relative to dir_fd resolves to /dev/null.
+ */
+static bool is_devnull_at(int dir_fd, const std::string& path) {
+    static struct stat devnull_st;
+    static bool has_devnull = (stat("/dev/null", &devnull_st) == 0);
+    struct stat st;
+
+    if (!has_devnull || fstatat(dir_fd, path.c_str(), &st, 0) != 0) {
+        return false;
+    }
+    return st.st_dev == devnull_st.st_dev && st.st_ino == devnull_st.st_ino;
+}
 
-    final_install_dir = install_dir + std::string(target);
-    dest_path = final_install_dir + "/" + unit_instance;
 
-    if (stat(final_install_dir.c_str(), &st) == -1) {
+static void set_install_op_error(ssg_install_op& op, const std::string& error, int err) {
+    op.failed = true;
+    op.error = error;
+    op.err = err;
+}
+
+
+static void perform_mkdir_op(ssg_install_op& op) {
+    struct stat st;
+    std::string dir_path = op.dir + op.path;
+    const char* path = op.path.c_str();
+
+    if (fstatat(op.dir_fd, path, &st, 0) == -1) {
         // If doesn't exist, create
-        r = mkdir(final_install_dir.c_str(), 0755);
-        if (r == -1) {
-            fprintf(stderr, "Unable to create target directory %s\n", final_install_dir.c_str());
-            return -1;
+        if (mkdirat(op.dir_fd, path, 0755) == -1) {
+            set_install_op_error(op, "Unable to create target directory " + dir_path, errno);
         }
     }
     else if (S_ISREG(st.st_mode)) {
         // If is regular file, remove and create
-        r = remove(final_install_dir.c_str());
-        if (r == -1) {
-            fprintf(stderr, "Unable to remove file with same name as target directory %s\n", final_install_dir.c_str());
-            return -1;
-        }
-
-        r = mkdir(final_install_dir.c_str(), 0755);
-        if (r == -1) {
-            fprintf(stderr, "Unable to create target directory %s\n", final_install_dir.c_str());
-            return -1;
+        if (unlinkat(op.dir_fd, path, 0) == -1) {
+            set_install_op_error(op, "Unable to remove file with same name as target directory " + dir_path, errno);
+        } else if (mkdirat(op.dir_fd, path, 0755) == -1) {
+            set_install_op_error(op, "Unable to create target directory " + dir_path, errno);
         }
     }
     else if (S_ISDIR(st.st_mode)) {
         // If directory, verify correct permissions
-        r = chmod(final_install_dir.c_str(), 0755);
-        if (r == -1) {
-            fprintf(stderr, "Unable to change permissions of existing target directory %s\n", final_install_dir.c_str());
-            return -1;
+        if (fchmodat(op.dir_fd, path, 0755, 0) == -1) {
+            set_install_op_error(op, "Unable to change permissions of existing target directory " + dir_path, errno);
         }
     }
+}
 
-    if (is_devnull(dest_path.c_str())) {
-        if (remove(dest_path.c_str()) != 0) {
-            fprintf(stderr, "Unable to remove existing symlink %s\n", dest_path.c_str());
-            return -1;
+
+static void perform_link_op(ssg_install_op& op) {
+    struct stat st;
+    std::string dest_path = op.dir + op.path;
+    const char* path = op.path.c_str();
+
+    if (op.type == SSG_OP_RELINK && fstatat(op.dir_fd, path, &st, 0) == 0) {
+        // If the file already exists, remove it
+        if (S_ISDIR(st.st_mode)) {
+            set_install_op_error(op, "Error: " + dest_path + " is a directory", 0);
+            return;
+        }
+        if (unlinkat(op.dir_fd, path, 0) != 0) {
+            set_install_op_error(op, "Error removing existing file " + dest_path, errno);
+            return;
         }
     }
 
-    r = symlink(src_path.c_str(), dest_path.c_str());
+    if (is_devnull_at(op.dir_fd, op.path)) {
+        if (unlinkat(op.dir_fd, path, 0) != 0) {
+            set_install_op_error(op, "Unable to remove existing symlink " + dest_path, errno);
+            return;
+        }
+    }
 
-    if (r < 0) {
-        if (errno == EEXIST)
-            return 0;
-        fprintf(stderr, "Error creating symlink %s from source %s\n", dest_path.c_str(), src_path.c_str());
-        return -1;
+    if (symlinkat(op.src.c_str(), op.dir_fd, path) != 0 && errno != EEXIST) {
+        set_install_op_error(op, "Error creating symlink " + dest_path + " from source " + op.src, errno);
     }
+}
 
-    return 0;
 
+static void perform_install_op(ssg_install_op& op) {
+    std::string error;
+
+    switch (op.type) {
+    case SSG_OP_MKDIR:
+        perform_mkdir_op(op);
+        break;
+    case SSG_OP_LINK:
+    case SSG_OP_RELINK:
+        perform_link_op(op);
+        break;
+    case SSG_OP_WRITE_UNIT:
+        if (!write_unit_file(op.path, *op.unit, error)) {
+            set_install_op_error(op, error, 0);
+        }
+        break;
+    }
+}
+
+
+static unsigned get_num_install_threads(size_t num_ops) {
+    unsigned num_threads = g_ssg_num_threads;
+
+    if (num_threads == 0) {
+        num_threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), (unsigned) SSG_MAX_THREADS);
+    }
+    return std::max((size_t) 1, std::min((size_t) num_threads, num_ops));
+}
+
+
+/**
+ * Performs a list of independent install ops with a bounded thread pool.
+ * Each worker takes the next op of the list until all are done.
+ */
+static void run_install_ops(std::vector<ssg_install_op>& ops) {
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    unsigned num_threads = get_num_install_threads(ops.size());
+
+    auto worker = [&ops, &next]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < ops.size()) {
+            perform_install_op(ops[i]);
+        }
+    };
+
+    for (unsigned i = 1; i < num_threads; i++) {
+        try {
+            threads.emplace_back(worker);
+        } catch (const std::system_error&) {
+            break;
+        }
+    }
+    worker();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+
+static void report_install_op_error(const ssg_install_op& op) {
+    if (!op.error.empty()) {
+        if (op.err != 0) {
+            fprintf(stderr, "%s (%s)\n", op.error.c_str(), strerror(op.err));
+        } else {
+            fprintf(stderr, "%s\n", op.error.c_str());
+        }
+    }
+    if (op.type == SSG_OP_LINK) {
+        fprintf(stderr, "Error installing %s for target %s\n", op.unit_name.c_str(), op.target.c_str());
+    }
+}
+
+
+/**
+ * Performs the install plan: target directories first, then symlinks
+ * and unit files. Symlinks in a directory that could not be prepared
+ * are skipped. Errors are reported in plan order.
+ *
+ * @return 0 on success, -1 if an op required by the generator failed.
+ */
+static int run_install_plan() {
+    int rc = 0;
+
+    run_install_ops(install_plan.dirs);
+
+    std::vector<ssg_install_op> ops;
+    std::vector<size_t> op_index;
+    for (size_t i = 0; i < install_plan.ops.size(); i++) {
+        ssg_install_op& op = install_plan.ops[i];
+        if (op.mkdir_op >= 0 && install_plan.dirs[op.mkdir_op].failed) {
+            op.failed = true;
+        } else {
+            op_index.push_back(i);
+        }
+    }
+    for (size_t i : op_index) {
+        ops.push_back(install_plan.ops[i]);
+    }
+    run_install_ops(ops);
+    for (size_t i = 0; i < op_index.size(); i++) {
+        install_plan.ops[op_index[i]] = ops[i];
+    }
+
+    for (const auto& op : install_plan.dirs) {
+        if (op.failed) {
+            report_install_op_error(op);
+        }
+    }
+    for (const auto& op : install_plan.ops) {
+        if (op.failed) {
+            report_install_op_error(op);
+            if (op.fatal) {
+                rc = -1;
+            }
+        }
+    }
+
+    return rc;
+}
+
+
+static void close_install_plan() {
+    if (install_plan.install_fd >= 0) {
+        close(install_plan.install_fd);
+    }
+    if (install_plan.network_fd >= 0) {
+        close(install_plan.network_fd);
+    }
+    install_plan = ssg_install_plan();
+}
+
+
+static int create_symlink(const std::string& unit, const std::string& target, int instance,  const std::string& instance_prefix) {
+    /***
+    Plans the symlink installing a unit instance in a target directory
+
+    The target directory and the symlink are created by run_install_plan()
+    ***/
+    std::string src_path;
+    std::string unit_instance;
+
+    src_path = get_unit_file_prefix() + unit;
+
+    if (instance < 0) {
+        unit_instance = unit;
+    }
+    else {
+        unit_instance = insert_instance_number(unit, instance, instance_prefix);
+        if (unit_instance.empty()) {
+            return -1;
+        }
+    }
+
+    add_install_link(unit, target, unit_instance);
+
+    ssg_install_op op = make_install_op(SSG_OP_LINK, install_plan.install_fd, install_plan.install_dir, target + "/" + unit_instance);
+    op.src = src_path;
+    op.unit_name = unit;
+    op.target = target;
+    op.mkdir_op = plan_target_dir(target);
+    plan_symlink(op);
+
+    return 0;
 }
 
 
-static int install_unit_file(std::string unit_file, std::string target, std::string install_dir) {
+static int install_unit_file(std::string unit_file, std::string target) {
     /***
-    Creates a symlink for a unit file installation
+    Plans the symlinks for a unit file installation
 
     For a given unit file and target directory,
-    create the appropriate symlink in the target directory
+    plan the appropriate symlink in the target directory
     to enable the unit and have it started by Systemd
 
     If a multi ASIC platform is detected, enables multi-instance
@@ -684,8 +1222,8 @@ static int install_unit_file(std::string unit_file, std::string target, std::str
     std::string target_instance;
     int r;
 
-    if (unit_file.empty() || target.empty() || install_dir.empty()){
-        fprintf(stderr, "Invalid unit file, target or install directory\n");
+    if (unit_file.empty() || target.empty()){
+        fprintf(stderr, "Invalid unit file or target\n");
         exit(EXIT_FAILURE);
     }
 
@@ -700,7 +1238,7 @@ static int install_unit_file(std::string unit_file, std::string target, std::str
                 target_instance = target;
             }
 
-            r = create_symlink(unit_file, target_instance, install_dir, i, "");
+            r = create_symlink(unit_file, target_instance, i, "");
             if (r < 0)
                 fprintf(stderr, "Error installing %s for target %s\n", unit_file.c_str(), target_instance.c_str());
         }
@@ -710,12 +1248,12 @@ static int install_unit_file(std::string unit_file, std::string target, std::str
         // E.g. install database@dpu0.service, database@dpu1.service to multi-user.target.wants
         // We don't have case like to install xxx@dpu0.service to swss@dpu0.service.wants
         for (int i = 0; i < num_dpus; i++) {
-            r = create_symlink(unit_file, target, install_dir, i, DPU_PREFIX);
+            r = create_symlink(unit_file, target, i, DPU_PREFIX);
             if (r < 0)
                 fprintf(stderr, "Error installing %s for target %s\n", unit_file.c_str(), target.c_str());
         }
     } else {
-        r = create_symlink(unit_file, target, install_dir, -1, "");
+        r = create_symlink(unit_file, target, -1, "");
         if (r < 0)
             fprintf(stderr, "Error installing %s for target %s\n", unit_file.c_str(), target.c_str());
     }
@@ -945,11 +1483,11 @@ static int get_num_of_dpu() {
 /**
  * Installs the network service.
  * 
- * This function installs the network service by creating a symlink
- * to the network service file in the appropriate directory.
+ * This function plans the symlink to the network service file in the
+ * appropriate directory, replacing any existing file.
  * 
  * @param unit_name The name of the network unit to install.
- * @return 0 if the network unit is installed successfully, or -1 if an error occurs.
+ * @return 0 if the network unit is planned successfully, or -1 if an error occurs.
  */
 static int install_network_unit(std::string unit_name) {
     if (unit_name.empty()) {
@@ -963,7 +1501,6 @@ static int install_network_unit(std::string unit_name) {
         return -1;
     }
 
-    std::string install_path;
     std::string original_path;
     std::string subdir = "/network/";
     if (unit_type != "netdev" && unit_type != "network") {
@@ -971,36 +1508,12 @@ static int install_network_unit(std::string unit_name) {
         return -1;
     }
 
-    install_path = get_etc_systemd() + subdir + unit_name;
     original_path = get_lib_systemd() + subdir + unit_name;
 
-    struct stat st;
-
-    if (stat(install_path.c_str(), &st) == 0) {
-        // If the file already exists, remove it
-        if (S_ISDIR(st.st_mode)) {
-            fprintf(stderr, "Error: %s is a directory\n", install_path.c_str());
-            return -1;
-        }
-        if (remove(install_path.c_str()) != 0) {
-            fprintf(stderr, "Error removing existing file %s\n", install_path.c_str());
-            return -1;
-        }
-    }
-
-    if (is_devnull(install_path.c_str())) {
-        if (remove(install_path.c_str()) != 0) {
-            fprintf(stderr, "Unable to remove existing symlink %s\n", install_path.c_str());
-            return -1;
-        }
-    }
-
-    if (symlink(original_path.c_str(), install_path.c_str()) != 0) {
-        if (errno == EEXIST)
-            return 0;
-        fprintf(stderr, "Error creating symlink %s -> %s (%s)\n", install_path.c_str(), original_path.c_str(), strerror(errno));
-        return -1;
-    }
+    ssg_install_op op = make_install_op(SSG_OP_RELINK, install_plan.network_fd, install_plan.network_dir, unit_name);
+    op.src = original_path;
+    op.fatal = true;
+    plan_symlink(op);
 
     return 0;
 }
@@ -1017,80 +1530,35 @@ static int render_network_service_for_smart_switch() {
     }
 
     std::stringstream ss;
-    ss << "\nBefore=";
     for (int i = 0; i < num_dpus; i++) {
         ss << "database@dpu" << i << ".service";
         if (i != num_dpus - 1) {
             ss << " ";
         }
     }
-    std::string buffer_instruction = ss.str();
-    std::string unit_path = std::string(get_unit_file_prefix()) + "/midplane-network-npu.service";
+    std::string unit_path = std::string(get_unit_file_prefix()) + "midplane-network-npu.service";
 
-    FILE *fp = fopen(unit_path.c_str(), "r");
-    if (fp == NULL) {
-        fprintf(stderr, "Failed to open %s\n", unit_path.c_str());
+    ssg_unit* unit = get_unit(unit_path);
+    if (unit == NULL) {
         return -1;
     }
-    fseek(fp, 0, SEEK_END);
-    size_t file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    size_t len = file_size + buffer_instruction.length() + 1;
-    char *unit_content = (char*) calloc(len, sizeof(unit_content));
-    if (unit_content == NULL) {
-        fprintf(stderr, "Failed to allocate memory for %s\n", unit_path.c_str());
-        fclose(fp);
-        exit(EXIT_FAILURE);
-    }
-    if (fread(unit_content, file_size, 1, fp) != 1) {
-        fprintf(stderr, "Failed to read %s\n", unit_path.c_str());
-        free(unit_content);
-        fclose(fp);
-        exit(EXIT_FAILURE);
+    ssg_unit_section* section = find_unit_section(*unit, "Unit");
+    if (section == NULL) {
+        fprintf(stderr, "No [Unit] section in %s\n", unit_path.c_str());
+        return -1;
     }
-    fclose(fp);
 
-    // Find insert point for Before instruction
-    char *insert_point = strstr(unit_content, "[Unit]");
-    insert_point += strlen("[Unit]");
-    // Move the rest of the file to make room for the Before instruction
-    memmove(insert_point + buffer_instruction.length(), insert_point, file_size - (insert_point - unit_content));
-    // Insert the Before instruction
-    memcpy(insert_point, buffer_instruction.c_str(), buffer_instruction.length());
-    // Remove original Before instruction
-    insert_point += buffer_instruction.length();
-    char *before_start = strstr(insert_point, "Before=");
-    while (before_start != NULL) {
-        char *before_end = strchr(before_start, '\n');
-        if (before_end == NULL) {
-            before_end = before_start + strlen(before_start);
-        } else {
-            // Include newline character
-            before_end += 1;
-        }
-        const char *target_service = strstr(before_start, "database@dpu");
-        if (target_service != NULL && target_service < before_end) {
-            memmove(before_start, before_end, strlen(before_end) + 1);
-        } else {
-            before_start = before_end;
+    // Insert the Before instruction first, remove the original one
+    std::vector<ssg_unit_line> lines;
+    lines.push_back(make_unit_line("Before", ss.str()));
+    for (const auto& line : section->lines) {
+        if (line.key == "Before" && line.value.find("database@dpu") != std::string::npos) {
+            continue;
         }
-        before_start = strstr(before_start, "Before=");
-    }
-    // Write the modified unit file
-    fp = fopen(unit_path.c_str(), "w");
-    if (fp == NULL) {
-        fprintf(stderr, "Failed to open %s\n", unit_path.c_str());
-        free(unit_content);
-        exit(EXIT_FAILURE);
-    }
-    if (fwrite(unit_content, strlen(unit_content), 1, fp) != 1) {
-        fprintf(stderr, "Failed to write %s\n", unit_path.c_str());
-        free(unit_content);
-        fclose(fp);
-        exit(EXIT_FAILURE);
+        lines.push_back(line);
     }
-    fclose(fp);
-    free(unit_content);
+    section->lines.swap(lines);
+    unit->modified = true;
 
     return 0;
 }
@@ -1143,18 +1611,23 @@ static int install_network_service_for_smart_switch() {
 
 
 int ssg_main(int argc, char **argv) {
-    char* unit_files[MAX_NUM_UNITS];
+    std::vector<std::string> unit_files;
     std::string install_dir;
-    char* targets[MAX_NUM_TARGETS];
+    std::vector<std::string> targets;
+    std::vector<std::string> problems;
     std::string unit_instance;
     std::string prefix;
     std::string suffix;
-    int num_unit_files;
     int num_targets;
+    int rc;
 
 #ifdef _SSG_UNITTEST
     clean_up_cache();
 #endif
+    unit_cache.clear();
+    multi_instance_services.clear();
+    install_graph = ssg_install_graph();
+    close_install_plan();
 
     if (argc <= 1) {
         fputs("Installation directory required as argument\n", stderr);
@@ -1168,23 +1641,35 @@ int ssg_main(int argc, char **argv) {
     num_dpus = get_num_of_dpu();
 
     install_dir = std::string(argv[1]) + "/";
+    install_plan.install_dir = install_dir;
+    install_plan.install_fd = open(install_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (install_plan.install_fd < 0) {
+        fprintf(stderr, "Failed to open %s (%s)\n", install_dir.c_str(), strerror(errno));
+        return -1;
+    }
     const char* config_file = get_config_file();
-    num_unit_files = get_unit_files(config_file, unit_files, MAX_NUM_UNITS);
-    num_unit_files += get_platform_unit_files(&unit_files[num_unit_files], MAX_NUM_UNITS - num_unit_files);
+    get_unit_files(config_file, unit_files);
+    get_platform_unit_files(unit_files);
 
     // Install and render midplane network service for smart switch
     if (smart_switch) {
-        if (render_network_service_for_smart_switch() != 0) {
-            return -1;
+        install_plan.network_dir = get_etc_systemd() + std::string("/network/");
+        install_plan.network_fd = open(install_plan.network_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (install_plan.network_fd < 0) {
+            fprintf(stderr, "Failed to open %s (%s)\n", install_plan.network_dir.c_str(), strerror(errno));
         }
-        if (install_network_service_for_smart_switch() != 0) {
+        if ((install_plan.network_fd < 0) ||
+            (render_network_service_for_smart_switch() != 0) ||
+            (install_network_service_for_smart_switch() != 0)) {
+            unit_cache.clear();
+            close_install_plan();
             return -1;
         }
     }
 
     // For each unit file, get the installation targets and install the unit
-    for (int i = 0; i < num_unit_files; i++) {
-        unit_instance = unit_files[i];
+    for (const auto& unit_file : unit_files) {
+        unit_instance = unit_file;
         if ((num_asics == 1 &&
              !is_multi_instance_service_for_dpu(unit_instance)) &&
             unit_instance.find("@") != std::string::npos) {
@@ -1194,37 +1679,45 @@ int ssg_main(int argc, char **argv) {
             unit_instance = prefix + suffix;
         }
 
+        targets.clear();
         num_targets = get_install_targets(unit_instance, targets);
         if (num_targets < 0) {
             fprintf(stderr, "Error parsing %s\n", unit_instance.c_str());
-            free(unit_files[i]);
             continue;
         }
 
-        for (int j = 0; j < num_targets; j++) {
-            if (install_unit_file(unit_instance, targets[j], install_dir) != 0)
-                fprintf(stderr, "Error installing %s to target directory %s\n", unit_instance.c_str(), targets[j]);
-
-            free(targets[j]);
+        add_install_unit(unit_instance, targets);
+        for (const auto& target : targets) {
+            if (install_unit_file(unit_instance, target) != 0)
+                fprintf(stderr, "Error installing %s to target directory %s\n", unit_instance.c_str(), target.c_str());
         }
 
-        update_environment(get_unit_file_prefix() + unit_instance);
-
-        free(unit_files[i]);
+        update_environment(*get_unit(get_unit_file_prefix() + unit_instance));
     }
 
-    for (int i = 0; i < num_multi_inst; i++) {
-        free(multi_instance_services[i]);
+    // Create all symlinks and write each unit file once, after all transformations
+    plan_unit_writes();
+    rc = run_install_plan();
+    unit_cache.clear();
+    close_install_plan();
+
+    // Report inconsistent install targets, dump the graph on request
+    if (validate_install_graph(install_graph, problems) != 0) {
+        for (const auto& problem : problems) {
+            fprintf(stderr, "Install graph: %s\n", problem.c_str());
+        }
     }
-    free(multi_instance_services);
-    multi_instance_services = NULL;
-    num_multi_inst = 0;
+    if (getenv("SSG_DUMP_INSTALL_GRAPH") != NULL) {
+        dump_install_graph(install_graph, stderr);
+    }
+
+    multi_instance_services.clear();
 
     if (is_valid_pointer(platform_info)) {
         json_object_put(platform_info);
     }
 
-    return 0;
+    return rc;
 }
 
 
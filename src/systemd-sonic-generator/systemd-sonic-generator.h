@@ -11,6 +11,9 @@
 // #endif
 #include <string>
 #include <unordered_set>
+#include <unordered_map>
+#include <cstdio>
+#include <vector>
 
 /* expose global vars for testing purpose */
 extern const char* UNIT_FILE_PREFIX;
@@ -27,6 +30,50 @@ extern const char* g_machine_config_file;
 extern const char* g_asic_conf_format;
 extern const char* g_platform_file_format;
 extern const char* g_platform_conf_format;
+extern int g_ssg_num_threads;           /* Install threads, 0 for default */
+
+/*
+ * In-memory unit file. Sections are kept in file order, each holding its
+ * lines in order. A line has a key and value when it is a "key=value"
+ * assignment; comments, blank lines and unparsed lines only keep their text.
+ */
+struct ssg_unit_line {
+    std::string key;
+    std::string value;
+    std::string text;       /* Original line, empty for generated lines */
+};
+
+struct ssg_unit_section {
+    std::string name;       /* Empty for lines before the first section */
+    std::vector<ssg_unit_line> lines;
+};
+
+struct ssg_unit {
+    std::vector<ssg_unit_section> sections;
+    bool deps_rewritten;    /* Multi instance dependencies already replaced */
+    bool modified;          /* Needs to be written back */
+};
+
+/*
+ * Install graph: for each unit, its install targets and the unit
+ * instances linked in each target directory.
+ */
+struct ssg_install_link {
+    std::string target;     /* Target directory, e.g. multi-user.target.wants */
+    std::string instance;   /* Unit instance linked in the target directory */
+};
+
+struct ssg_install_unit {
+    std::string name;
+    std::vector<std::string> targets;
+    std::vector<ssg_install_link> links;
+};
+
+struct ssg_install_graph {
+    std::vector<ssg_install_unit> units;                /* In install order */
+    std::unordered_map<std::string, size_t> index;      /* Unit name to units[] position */
+    std::unordered_set<std::string> links;              /* Recorded links */
+};
 
 /* C-functions under test */
 extern const char* get_unit_file_prefix();
@@ -37,9 +84,14 @@ extern const char* get_platform_conf_format();
 extern std::string insert_instance_number(const std::string& unit_file, int instance, const std::string& instance_prefix);
 extern int ssg_main(int argc, char** argv);
 extern int get_num_of_asic();
-extern int get_install_targets(std::string unit_file, char* targets[]);
-extern int get_unit_files(const char* config_file, char* unit_files[], int unit_files_size);
-extern int get_platform_unit_files(char* unit_files[], int unit_files_size);
+extern int get_install_targets(const std::string& unit_file, std::vector<std::string>& targets);
+extern int get_unit_files(const char* config_file, std::vector<std::string>& unit_files);
+extern int get_platform_unit_files(std::vector<std::string>& unit_files);
+extern const ssg_install_graph& get_install_graph();
+extern int validate_install_graph(const ssg_install_graph& graph, std::vector<std::string>& problems);
+extern void dump_install_graph(const ssg_install_graph& graph, FILE* fp);
+extern bool load_unit_file(const std::string& path, ssg_unit& unit);
+extern bool save_unit_file(const std::string& path, const ssg_unit& unit);
 // #ifdef __cplusplus
 // }
 // #endif
@@ -0,0 +1,1141 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pwd.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syslog.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Remote user gecos prefix, which been assigned by nss_tacplus */
+#define REMOTE_USER_GECOS_PREFIX      "remote_user"
+
+/* Default value for getpwnam */
+#define DEFAULT_GETPWNAM_SIZE_MAX     4096
+
+/* Local user classification cache entry count */
+#define LOCAL_USER_CACHE_SIZE         16
+
+/* Return value for is_local_user method */
+#define IS_LOCAL_USER              0
+#define IS_REMOTE_USER             1
+#define ERROR_CHECK_LOCAL_USER     2
+
+/* Tacacs+ lib */
+#include <libtac/libtac.h>
+
+/* Tacacs+ support lib */
+#include <libtac/support.h>
+
+/* Output syslog to mock method when build with UT */
+#if defined (BASH_PLUGIN_UT)
+#define syslog mock_syslog
+#define getpwnam_r mock_getpwnam_r
+#define time mock_time
+#define socket mock_socket
+#define connect mock_connect
+#endif
+
+/* Tacacs+ log format */
+#define  TACACS_LOG_FORMAT "TACACS+: %s"
+
+/* Tacacs+ config file timestamp string format */
+#define  CONFIG_FILE_TIME_STAMP_FORMAT "%d.%m.%Y %H:%M:%S"
+
+/* Tacacs+ config file timestamp string length */
+#define  CONFIG_FILE_TIME_STAMP_LEN  100
+
+/* Seconds a server is skipped for after a failed connect */
+#define  SERVER_HOLD_DOWN_SECONDS    30
+
+/* Milliseconds to wait for a server before also connecting to the next one */
+#define  SERVER_CONNECT_STAGGER_MS   200
+
+/* Authorization cache default and max entry count, power of 2 */
+#define  AUTHORIZATION_CACHE_SIZE_DEFAULT    64
+#define  AUTHORIZATION_CACHE_SIZE_MAX        1024
+
+/* Authorization cache slots checked from the hash slot of a command */
+#define  AUTHORIZATION_CACHE_PROBE           8
+
+/*
+    Convert log to a string because va args resoursive issue:
+    http://www.c-faq.com/varargs/handoff.html
+*/
+#define GENERATE_LOG_FROM_VA(logBufferName)                 \
+    char logBufferName[512];                                \
+    va_list args;                                           \
+    va_start(args, format);                                 \
+    vsnprintf(logBufferName, sizeof(logBufferName), format, args);  \
+    va_end(args);
+
+/* Config file path */
+const char *tacacs_config_file = "/etc/tacplus_nss.conf";
+
+/* Unknown user name */
+const char *unknown_username = "UNKNOWN";
+
+
+/* Config file attribute */
+struct stat config_file_attr;
+
+/* Tacacs server config data */
+typedef struct {
+    struct addrinfo *address;
+    const char *key;
+} tacacs_server_t;
+
+/* Tacacs control flag */
+int tacacs_ctrl;
+
+/* Tacacs connection of current shell, kept open between commands */
+typedef struct {
+    int fd;
+    int server_idx;
+    pid_t owner;
+} tacacs_session_t;
+
+tacacs_session_t tacacs_session = { -1, -1, 0 };
+
+/* Server skipped until this time after a failed connect */
+time_t server_hold_down[TAC_PLUS_MAXSERVERS];
+
+/* Authorization cache entry, only commands authorized by server are cached */
+typedef struct {
+    char *user;
+    char *tty;
+    char *cmd;
+    char *args;
+    size_t args_len;
+    uint64_t hash;
+    time_t expire;
+} authorization_cache_entry_t;
+
+/* Authorization cache of current shell, open addressing hash table */
+authorization_cache_entry_t authorization_cache[AUTHORIZATION_CACHE_SIZE_MAX];
+
+/* Authorization cache TTL in seconds and table size, from config file */
+int authorization_cache_ttl;
+int authorization_cache_size = AUTHORIZATION_CACHE_SIZE_DEFAULT;
+
+/* Authorization cache statistics */
+unsigned long authorization_cache_hits;
+unsigned long authorization_cache_misses;
+
+/* Passwd file, user classification cache invalidated when it changed */
+const char *passwd_file = "/etc/passwd";
+
+/* Local user classification cache entry */
+typedef struct {
+    char *user;
+    int result;
+} local_user_cache_entry_t;
+
+/* Local user classification cache of current shell */
+local_user_cache_entry_t local_user_cache[LOCAL_USER_CACHE_SIZE];
+
+/* Next cache entry to replace when cache is full */
+int local_user_cache_next;
+
+/* Passwd file attribute when cache populated */
+struct stat passwd_file_attr;
+
+/*
+ * Output error message.
+ */
+void output_error(const char *format, ...)
+{
+    GENERATE_LOG_FROM_VA(logBuffer);
+
+    if (tacacs_ctrl & PAM_TAC_DEBUG) {
+        fprintf(stderr, TACACS_LOG_FORMAT, logBuffer);
+    }
+
+    syslog(LOG_ERR, TACACS_LOG_FORMAT, logBuffer);
+}
+
+/*
+ * Output info message.
+ */
+void output_info(const char *format, ...)
+{
+    GENERATE_LOG_FROM_VA(logBuffer);
+
+    if (tacacs_ctrl & PAM_TAC_DEBUG) {
+        fprintf(stderr, TACACS_LOG_FORMAT, logBuffer);
+    }
+
+    syslog(LOG_INFO, TACACS_LOG_FORMAT, logBuffer);
+}
+
+/*
+ * Output debug message.
+ */
+void output_debug(const char *format, ...)
+{
+    if ((tacacs_ctrl & PAM_TAC_DEBUG) == 0) {
+        return;
+    }
+
+    GENERATE_LOG_FROM_VA(logBuffer);
+    fprintf(stderr, TACACS_LOG_FORMAT, logBuffer);
+    syslog(LOG_DEBUG, TACACS_LOG_FORMAT, logBuffer);
+}
+
+
+/*
+ * Send authorization message.
+ * This method based on send_auth_msg in https://github.com/daveolson53/tacplus-auth/blob/master/tacplus-auth.c
+ */
+int send_authorization_message(
+    int tac_fd,
+    const char *user,
+    const char *tty,
+    const char *host,
+    uint16_t taskid,
+    const char *cmd,
+    char **args,
+    int argc)
+{
+    char buf[128];
+    struct tac_attrib *attr;
+    int retval;
+    struct areply re;
+    int i;
+
+    attr=(struct tac_attrib *)xcalloc(1, sizeof(struct tac_attrib));
+
+    snprintf(buf, sizeof buf, "%hu", taskid);
+    tac_add_attrib(&attr, "task_id", buf);
+    tac_add_attrib(&attr, "protocol", "ssh");
+    tac_add_attrib(&attr, "service", "shell");
+
+    tac_add_attrib(&attr, "cmd", (char*)cmd);
+
+    for(i=1; i<argc; i++) {
+        // TACACS protocol allow max 255 bytes per argument. 'cmd-arg' will take 7 bytes.
+        char tbuf[248];
+        const char *arg;
+        if(strlen(args[i]) >= sizeof(tbuf)) {
+            snprintf(tbuf, sizeof tbuf, "%s", args[i]);
+            arg = tbuf;
+        }
+        else {
+            arg = args[i];
+        }
+
+        tac_add_attrib(&attr, "cmd-arg", (char *)arg);
+    }
+
+    re.msg = NULL;
+    output_debug("send authorizatiom message with user: %s, tty: %s, host: %s\n", user, tty, host);
+    retval = tac_author_send(tac_fd, (char *)user, (char *)tty, (char *)host, attr);
+    output_debug("authorization result: %d\n", retval);
+
+    if(retval < 0) {
+        output_error("send of authorization message failed: %s\n", strerror(errno));
+    }
+    else {
+        retval = tac_author_read(tac_fd, &re);
+        if (retval < 0) {
+            output_debug("authorization response failed: %d\n", retval);
+        }
+        else if(re.status == AUTHOR_STATUS_PASS_ADD ||
+                    re.status == AUTHOR_STATUS_PASS_REPL) {
+            retval = 0;
+        }
+        else  {
+            output_debug("command not authorized (%d)\n", re.status);
+            retval = 1;
+        }
+    }
+
+    tac_free_attrib(&attr);
+    if(re.msg != NULL) {
+        free(re.msg);
+    }
+
+    return retval;
+}
+
+/*
+ * Close tacacs connection of current shell.
+ */
+void tacacs_session_close()
+{
+    if (tacacs_session.fd >= 0) {
+        close(tacacs_session.fd);
+    }
+
+    tacacs_session.fd = -1;
+    tacacs_session.server_idx = -1;
+}
+
+/*
+ * Check if the kept connection can be reused, server will close it when not support single-connection.
+ */
+int tacacs_session_alive()
+{
+    struct pollfd pfd;
+
+    pfd.fd = tacacs_session.fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    // nothing to read and no hangup: connection still open, any pending data or EOF means it's not usable
+    return poll(&pfd, 1, 0) == 0;
+}
+
+/*
+ * Get milliseconds from a monotonic clock, for connect timeout.
+ */
+long tacacs_monotonic_ms()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/*
+ * Start non-blocking connect to tacacs server, same socket setup as tac_connect_single.
+ */
+int tacacs_connect_start(int server_idx)
+{
+    struct addrinfo *address = tac_srv[server_idx].addr;
+    int fd, flags, error;
+
+    fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // kept connection must not leak into the commands executed by shell
+    flags = fcntl(fd, F_GETFL);
+    if (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0 || flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        goto failed;
+    }
+
+    if (__vrfname != NULL && setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, __vrfname, strlen(__vrfname) + 1) < 0) {
+        output_debug("Failed to bind connection to %s to VRF %s: %s\n", tac_ntop(address->ai_addr), __vrfname, strerror(errno));
+    }
+
+    if (tac_source_addr != NULL && bind(fd, tac_source_addr->ai_addr, tac_source_addr->ai_addrlen) < 0) {
+        goto failed;
+    }
+
+    if (connect(fd, address->ai_addr, address->ai_addrlen) < 0 && errno != EINPROGRESS) {
+        goto failed;
+    }
+
+    return fd;
+
+failed:
+    error = errno;
+    close(fd);
+    errno = error;
+    return -1;
+}
+
+/*
+ * Log a failed connect and skip the server for a while, so following commands not wait on it again.
+ */
+void tacacs_connect_failed(int server_idx, const char *cmd, int error)
+{
+    output_error("Failed to connecting to %s to request authorization for %s: %s\n", tac_ntop(tac_srv[server_idx].addr->ai_addr), cmd, strerror(error));
+    server_hold_down[server_idx] = time(NULL) + SERVER_HOLD_DOWN_SECONDS;
+}
+
+/*
+ * Connect to the first server of candidates that accept the connection.
+ * Connect to a candidate starts when the previous one failed or not finished in SERVER_CONNECT_STAGGER_MS,
+ * so an unreachable server only delay the command by the stagger time instead of tac_timeout.
+ * When several connects finished together, the candidate with higher priority is used.
+ */
+int tacacs_connect_race(const int *candidates, int count, const char *cmd)
+{
+    struct pollfd pfds[TAC_PLUS_MAXSERVERS];
+    long deadlines[TAC_PLUS_MAXSERVERS];
+    long now = tacacs_monotonic_ms(), next_start = now;
+    int started = 0, pending = 0, winner = -1, timeout, error, idx;
+    socklen_t len;
+
+    while (winner < 0 && (started < count || pending > 0)) {
+        if (started < count && (pending == 0 || now >= next_start)) {
+            pfds[started].fd = tacacs_connect_start(candidates[started]);
+            pfds[started].events = POLLOUT;
+            deadlines[started] = tac_timeout > 0 ? now + tac_timeout * 1000L : -1;
+            if (pfds[started].fd < 0) {
+                tacacs_connect_failed(candidates[started], cmd, errno);
+            }
+            else {
+                pending++;
+            }
+
+            started++;
+            next_start = now + SERVER_CONNECT_STAGGER_MS;
+            continue;
+        }
+
+        // wait until next candidate should start or a pending connect timeout
+        timeout = -1;
+        if (started < count) {
+            timeout = next_start - now;
+        }
+
+        for (idx = 0; idx < started; idx++) {
+            pfds[idx].revents = 0;
+            if (pfds[idx].fd >= 0 && deadlines[idx] >= 0 && (timeout < 0 || deadlines[idx] - now < timeout)) {
+                timeout = deadlines[idx] > now ? deadlines[idx] - now : 0;
+            }
+        }
+
+        if (poll(pfds, started, timeout) < 0 && errno != EINTR) {
+            output_error("Failed to wait connection to TACACS server(s): %s\n", strerror(errno));
+            break;
+        }
+
+        now = tacacs_monotonic_ms();
+        for (idx = 0; idx < started && winner < 0; idx++) {
+            if (pfds[idx].fd < 0) {
+                continue;
+            }
+
+            if (pfds[idx].revents) {
+                error = 0;
+                len = sizeof(error);
+                if (getsockopt(pfds[idx].fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+                    error = errno;
+                }
+
+                if (!error) {
+                    winner = idx;
+                    continue;
+                }
+            }
+            else if (deadlines[idx] >= 0 && now >= deadlines[idx]) {
+                error = ETIMEDOUT;
+            }
+            else {
+                continue;
+            }
+
+            close(pfds[idx].fd);
+            pfds[idx].fd = -1;
+            pending--;
+            tacacs_connect_failed(candidates[idx], cmd, error);
+
+            // next candidate not need to wait for the stagger time
+            next_start = now;
+        }
+    }
+
+    for (idx = 0; idx < started; idx++) {
+        if (idx == winner || pfds[idx].fd < 0) {
+            continue;
+        }
+
+        // higher priority server still not answered, hold it down so following commands reuse the connection
+        close(pfds[idx].fd);
+        if (idx < winner) {
+            output_debug("Connect to %s not finished in %d ms, skip it for %d seconds\n", tac_ntop(tac_srv[candidates[idx]].addr->ai_addr), SERVER_CONNECT_STAGGER_MS, SERVER_HOLD_DOWN_SECONDS);
+            server_hold_down[candidates[idx]] = time(NULL) + SERVER_HOLD_DOWN_SECONDS;
+        }
+    }
+
+    if (winner < 0) {
+        return -1;
+    }
+
+    idx = candidates[winner];
+    server_hold_down[idx] = 0;
+
+    // libtac read and write with blocking socket
+    fcntl(pfds[winner].fd, F_SETFL, fcntl(pfds[winner].fd, F_GETFL) & ~O_NONBLOCK);
+
+    // set current tac_secret, same as tac_connect_single
+    tac_encryption = 0;
+    if (*tac_srv[idx].key) {
+        tac_encryption = 1;
+        tac_secret = tac_srv[idx].key;
+    }
+
+    tacacs_session.fd = pfds[winner].fd;
+    tacacs_session.server_idx = idx;
+    tacacs_session.owner = getpid();
+    return tacacs_session.fd;
+}
+
+/*
+ * Get connection to the first reachable server of candidates, reuse the kept connection when possible.
+ */
+int tacacs_session_connect(const int *candidates, int count, const char *cmd, int *reused)
+{
+    *reused = 0;
+    if (tacacs_session.fd >= 0) {
+        // connection inherited by a subshell is still used by the parent shell, only close the copy
+        if (tacacs_session.owner == getpid() && tacacs_session.server_idx == candidates[0] && tacacs_session_alive()) {
+            *reused = 1;
+            return tacacs_session.fd;
+        }
+
+        tacacs_session_close();
+    }
+
+    return tacacs_connect_race(candidates, count, cmd);
+}
+
+/*
+ * Hash a string into FNV-1a hash, terminating NUL included so string boundaries are part of the hash.
+ */
+uint64_t authorization_cache_hash_string(uint64_t hash, const char *str)
+{
+    const unsigned char *ch = (const unsigned char *)str;
+
+    do {
+        hash ^= *ch;
+        hash *= 1099511628211ULL;
+    } while (*ch++);
+
+    return hash;
+}
+
+/*
+ * Hash user, tty, command and arguments with FNV-1a.
+ */
+uint64_t authorization_cache_hash(const char *user, const char *tty, const char *cmd, char **args, int argc)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    int i;
+
+    hash = authorization_cache_hash_string(hash, user);
+    hash = authorization_cache_hash_string(hash, tty);
+    hash = authorization_cache_hash_string(hash, cmd);
+    for(i=0; i<argc; i++) {
+        hash = authorization_cache_hash_string(hash, args[i]);
+    }
+
+    return hash;
+}
+
+/*
+ * Join arguments into one buffer with their terminating NUL, so different argument lists never compare equal.
+ */
+char *authorization_cache_join_args(char **args, int argc, size_t *len)
+{
+    size_t offset = 0;
+    char *joined;
+    int i;
+
+    *len = 0;
+    for(i=0; i<argc; i++) {
+        *len += strlen(args[i]) + 1;
+    }
+
+    // not return NULL for empty argument list, NULL means out of memory
+    joined = malloc(*len + 1);
+    if (joined == NULL) {
+        return NULL;
+    }
+
+    for(i=0; i<argc; i++) {
+        size_t arg_len = strlen(args[i]) + 1;
+        memcpy(joined + offset, args[i], arg_len);
+        offset += arg_len;
+    }
+
+    return joined;
+}
+
+/*
+ * Remove an authorization cache entry.
+ */
+void authorization_cache_entry_free(authorization_cache_entry_t *entry)
+{
+    free(entry->user);
+    free(entry->tty);
+    free(entry->cmd);
+    free(entry->args);
+    memset(entry, 0, sizeof(authorization_cache_entry_t));
+}
+
+/*
+ * Remove all authorization cache entries, log and reset statistics of the removed cache.
+ */
+void authorization_cache_clear()
+{
+    int i;
+
+    if (authorization_cache_hits || authorization_cache_misses) {
+        output_info("authorization cache hits: %lu, misses: %lu\n", authorization_cache_hits, authorization_cache_misses);
+        authorization_cache_hits = 0;
+        authorization_cache_misses = 0;
+    }
+
+    for(i=0; i<AUTHORIZATION_CACHE_SIZE_MAX; i++) {
+        if (authorization_cache[i].cmd != NULL) {
+            authorization_cache_entry_free(&authorization_cache[i]);
+        }
+    }
+}
+
+/*
+ * Get the cache slot of a hash, probe 0 is the hash slot itself.
+ */
+authorization_cache_entry_t *authorization_cache_slot(uint64_t hash, int probe)
+{
+    return &authorization_cache[(hash + probe) & (authorization_cache_size - 1)];
+}
+
+/*
+ * Check if command authorized by server recently, hash only select the slots, entry must match every field.
+ */
+int authorization_cache_lookup(const char *user, const char *tty, const char *cmd, const char *args, size_t args_len, uint64_t hash)
+{
+    time_t now = time(NULL);
+    int i;
+
+    for(i=0; i<AUTHORIZATION_CACHE_PROBE; i++) {
+        authorization_cache_entry_t *entry = authorization_cache_slot(hash, i);
+        if (entry->cmd == NULL || entry->hash != hash) {
+            continue;
+        }
+
+        if (entry->expire <= now) {
+            authorization_cache_entry_free(entry);
+            return 0;
+        }
+
+        if (strcmp(entry->cmd, cmd) == 0
+            && strcmp(entry->user, user) == 0
+            && strcmp(entry->tty, tty) == 0
+            && entry->args_len == args_len
+            && memcmp(entry->args, args, args_len) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Cache command authorized by server, replace expired or oldest entry of the probed slots when they are all used.
+ */
+void authorization_cache_add(const char *user, const char *tty, const char *cmd, const char *args, size_t args_len, uint64_t hash)
+{
+    authorization_cache_entry_t *entry = authorization_cache_slot(hash, 0);
+    int i;
+
+    for(i=0; i<AUTHORIZATION_CACHE_PROBE; i++) {
+        authorization_cache_entry_t *slot = authorization_cache_slot(hash, i);
+        if (slot->cmd == NULL || slot->hash == hash) {
+            entry = slot;
+            break;
+        }
+
+        if (slot->expire < entry->expire) {
+            entry = slot;
+        }
+    }
+
+    if (entry->cmd != NULL) {
+        authorization_cache_entry_free(entry);
+    }
+
+    entry->user = strdup(user);
+    entry->tty = strdup(tty);
+    entry->cmd = strdup(cmd);
+    entry->args = malloc(args_len + 1);
+    if (entry->user == NULL || entry->tty == NULL || entry->cmd == NULL || entry->args == NULL) {
+        authorization_cache_entry_free(entry);
+        return;
+    }
+
+    memcpy(entry->args, args, args_len);
+    entry->args_len = args_len;
+
+    entry->hash = hash;
+    entry->expire = time(NULL) + authorization_cache_ttl;
+}
+
+/*
+ * Load authorization cache setting, parsed from config file by parse_config_file.
+ */
+void load_authorization_cache_config()
+{
+    authorization_cache_ttl = tac_author_cache_ttl > 0 ? tac_author_cache_ttl : 0;
+
+    // table size is a power of 2, so hash slot is a mask of the hash
+    authorization_cache_size = AUTHORIZATION_CACHE_SIZE_DEFAULT;
+    if (tac_author_cache_size > 0) {
+        authorization_cache_size = AUTHORIZATION_CACHE_PROBE;
+        while (authorization_cache_size < tac_author_cache_size && authorization_cache_size < AUTHORIZATION_CACHE_SIZE_MAX) {
+            authorization_cache_size <<= 1;
+        }
+    }
+}
+
+/*
+ * Send tacacs authorization request.
+ * This method based on send_tacacs_auth in https://github.com/daveolson53/tacplus-auth/blob/master/tacplus-auth.c
+ */
+int tacacs_authorization(
+    const char *user,
+    const char *tty,
+    const char *host,
+    const char *cmd,
+    char **args,
+    int argc)
+{
+    int result = 1, server_idx, server_fd, connected_servers=0, reused, pass, first, candidate_count;
+    int held_down[TAC_PLUS_MAXSERVERS], candidates[TAC_PLUS_MAXSERVERS];
+    uint16_t task_id = (uint16_t)getpid();
+    time_t now = time(NULL);
+    uint64_t cache_hash = 0;
+    char *cache_args = NULL;
+    size_t cache_args_len = 0;
+
+    if (authorization_cache_ttl > 0) {
+        // not use cache when out of memory, command still authorized by server
+        cache_args = authorization_cache_join_args(args, argc, &cache_args_len);
+    }
+
+    if (cache_args != NULL) {
+        cache_hash = authorization_cache_hash(user, tty, cmd, args, argc);
+        if (authorization_cache_lookup(user, tty, cmd, cache_args, cache_args_len, cache_hash)) {
+            authorization_cache_hits++;
+            output_debug("%s authorized from cache, cache hits: %lu, misses: %lu\n", cmd, authorization_cache_hits, authorization_cache_misses);
+            free(cache_args);
+            return 0;
+        }
+
+        authorization_cache_misses++;
+    }
+
+    for(server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+        held_down[server_idx] = server_hold_down[server_idx] > now;
+    }
+
+    // first pass skip servers in hold down, only try them when no other server reachable
+    for(pass = 0; pass < 2 && !connected_servers; pass++) {
+        candidate_count = 0;
+        for(server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+            if (held_down[server_idx] == pass) {
+                candidates[candidate_count++] = server_idx;
+            }
+        }
+
+        for(first = 0; first < candidate_count; first++) {
+            server_fd = tacacs_session_connect(candidates + first, candidate_count - first, cmd, &reused);
+            if(server_fd < 0) {
+                // connect to all remaining servers failed, each failure logged by tacacs_connect_race
+                break;
+            }
+
+            // when not authorized, continue with the server after the connected one
+            server_idx = tacacs_session.server_idx;
+            while (candidates[first] != server_idx) {
+                first++;
+            }
+
+            // increase connected servers
+            connected_servers++;
+            result = send_authorization_message(server_fd, user, tty, host, task_id, cmd, args, argc);
+            if(result < 0 && reused) {
+                // kept connection closed by server, retry with a new connection
+                tacacs_session_close();
+                server_fd = tacacs_session_connect(&server_idx, 1, cmd, &reused);
+                if (server_fd >= 0) {
+                    result = send_authorization_message(server_fd, user, tty, host, task_id, cmd, args, argc);
+                }
+            }
+
+            if(result < 0) {
+                // connection in unknown state, not reuse it
+                tacacs_session_close();
+            }
+            else if(!reused && !tac_single_connect_granted) {
+                // server not accept single-connection mode in first reply, it will close the connection
+                tacacs_session_close();
+            }
+
+            if(result) {
+                // authorization failed
+                output_debug("%s not authorized from %s\n", cmd, tac_ntop(tac_srv[server_idx].addr->ai_addr));
+            }
+            else {
+                // authorization successed
+                output_debug("%s authorized from %s\n", cmd, tac_ntop(tac_srv[server_idx].addr->ai_addr));
+                break;
+            }
+        }
+    }
+
+    // can't connect to any server
+    if(!connected_servers) {
+        result = -2;
+        output_error("Failed to connect to TACACS server(s)\n");
+    }
+    else if(!result && cache_args != NULL) {
+        // only cache PASS_ADD/PASS_REPL result, deny and error always go to server again
+        authorization_cache_add(user, tty, cmd, cache_args, cache_args_len, cache_hash);
+    }
+
+    free(cache_args);
+    return result;
+}
+
+/*
+ * Send authorization request.
+ * This method based on build_auth_req in https://github.com/daveolson53/tacplus-auth/blob/master/tacplus-auth.c
+ */
+int authorization_with_host_and_tty(const char *user, const char *cmd, char **argv, int argc)
+{
+    // try get host name
+    char hostname[64];
+    memset(&hostname, 0, sizeof(hostname));
+
+    (void)gethostname(hostname, sizeof(hostname) -1);
+    if (!hostname[0]) {
+        snprintf(hostname, sizeof(hostname), "UNK");
+        output_error("Failed to determine hostname, passing %s\n", hostname);
+    }
+
+    // try get tty name
+    char ttyname[64];
+    memset(&ttyname, 0, sizeof(ttyname));
+
+    int i;
+    for(i=0; i<3; i++) {
+        int result;
+        if (isatty(i)) {
+            result = ttyname_r(i, ttyname, sizeof(ttyname) -1);
+            if (result) {
+                output_error("Failed to get tty name for fd %d: %s\n", i, strerror(result));
+            }
+            break;
+        }
+    }
+
+    if (!ttyname[0]) {
+        snprintf(ttyname, sizeof(ttyname), "UNK");
+        output_error("Failed to determine tty, passing %s\n", ttyname);
+    }
+
+    // send tacacs authorization request
+    return tacacs_authorization(user, ttyname, hostname, cmd, argv, argc);
+}
+
+/*
+ * Load tacacs config.
+ */
+void load_tacacs_config()
+{
+    // server list may change, drop kept connection and hold down state
+    tacacs_session_close();
+    memset(server_hold_down, 0, sizeof(server_hold_down));
+
+    // authorization policy may change, drop cached authorization result
+    authorization_cache_clear();
+
+    // load config file: tacacs_config_file
+    tacacs_ctrl = parse_config_file (tacacs_config_file);
+    load_authorization_cache_config();
+
+    // ask server to keep the connection open between commands, server accept it in first reply
+    tac_single_connect = 1;
+
+    output_debug("tacacs config updated:\n");
+    int server_idx;
+    for(server_idx = 0; server_idx < tac_srv_no; server_idx++) {
+        output_debug("Server %d, address:%s, key length:%d\n", server_idx, tac_ntop(tac_srv[server_idx].addr->ai_addr),strlen(tac_srv[server_idx].key));
+    }
+
+    output_debug("TACACS+ control flag: 0x%x\n", tacacs_ctrl);
+
+    if (tacacs_ctrl & AUTHORIZATION_FLAG_TACACS) {
+        output_debug("TACACS+ per-command authorization enabled.\n");
+    }
+
+    if (tacacs_ctrl & AUTHORIZATION_FLAG_LOCAL) {
+        output_debug("Local per-command authorization enabled.\n");
+    }
+
+    if (authorization_cache_ttl > 0) {
+        output_debug("TACACS+ authorization cache enabled, TTL: %d, size: %d\n", authorization_cache_ttl, authorization_cache_size);
+    }
+
+    if (tacacs_ctrl & PAM_TAC_DEBUG) {
+        output_debug("TACACS+ debug enabled.\n");
+    }
+}
+
+/*
+ * Load tacacs config.
+ */
+void check_and_load_changed_tacacs_config()
+{
+    struct stat attr;
+    // get config file stat, check if file changed
+    stat(tacacs_config_file, &attr);
+    char date[CONFIG_FILE_TIME_STAMP_LEN];
+    strftime(date, sizeof(date), CONFIG_FILE_TIME_STAMP_FORMAT, localtime(&(attr.st_mtime)));
+    if (difftime(attr.st_mtime, config_file_attr.st_mtime) == 0) {
+        output_debug("tacacs config file not change: last modified time: %s.\n", date);
+        return;
+    }
+
+    output_debug("tacacs config file changed: last modified time: %s.\n", date);
+
+    // config file changed, update file stat and reload config.
+    config_file_attr = attr;
+
+    // load config file
+    load_tacacs_config();
+}
+
+/*
+ * Tacacs plugin initialization.
+ */
+void plugin_init()
+{
+    // get config file stat, will use this to check config file changed
+    stat(tacacs_config_file, &config_file_attr);
+
+    // load config file: tacacs_config_file
+    load_tacacs_config();
+
+    output_debug("tacacs plugin initialized.\n");
+}
+
+/*
+ * Clear local user classification cache.
+ */
+void local_user_cache_clear()
+{
+    int i;
+    for(i=0; i<LOCAL_USER_CACHE_SIZE; i++) {
+        free(local_user_cache[i].user);
+        local_user_cache[i].user = NULL;
+    }
+
+    local_user_cache_next = 0;
+}
+
+/*
+ * Check passwd file with one stat call, clear cache when it changed.
+ * Return 0 when passwd file can't be checked, and cache should not be used.
+ */
+int local_user_cache_validate()
+{
+    struct stat attr;
+    if (stat(passwd_file, &attr) != 0) {
+        output_debug("stat passwd file %s failed, user classification not cached.\n", passwd_file);
+        local_user_cache_clear();
+        memset(&passwd_file_attr, 0, sizeof(passwd_file_attr));
+        return 0;
+    }
+
+    if (attr.st_ino != passwd_file_attr.st_ino
+        || attr.st_mtime != passwd_file_attr.st_mtime
+        || attr.st_size != passwd_file_attr.st_size) {
+        output_debug("passwd file %s changed, clear user classification cache.\n", passwd_file);
+        local_user_cache_clear();
+        passwd_file_attr = attr;
+    }
+
+    return 1;
+}
+
+/*
+ * Find user in local user classification cache, return ERROR_CHECK_LOCAL_USER when not found.
+ */
+int local_user_cache_lookup(const char *user)
+{
+    int i;
+    for(i=0; i<LOCAL_USER_CACHE_SIZE; i++) {
+        if (local_user_cache[i].user != NULL && strcmp(local_user_cache[i].user, user) == 0) {
+            return local_user_cache[i].result;
+        }
+    }
+
+    return ERROR_CHECK_LOCAL_USER;
+}
+
+/*
+ * Add user to local user classification cache.
+ */
+void local_user_cache_add(const char *user, int result)
+{
+    local_user_cache_entry_t *entry = &local_user_cache[local_user_cache_next];
+    local_user_cache_next = (local_user_cache_next + 1) % LOCAL_USER_CACHE_SIZE;
+
+    free(entry->user);
+    entry->user = strdup(user);
+    entry->result = result;
+}
+
+/*
+ * Tacacs plugin release.
+ */
+void plugin_uninit()
+{
+    output_debug("tacacs plugin un-initialize.\n");
+    tacacs_session_close();
+    authorization_cache_clear();
+    local_user_cache_clear();
+}
+
+/*
+ * Check if current user is local user.
+ */
+int is_local_user(char *user)
+{
+    if (user == unknown_username) {
+        // for unknown user name, when tacacs enabled, always authorization with tacacs.
+        return IS_REMOTE_USER;
+    }
+
+    int cache_valid = local_user_cache_validate();
+    if (cache_valid) {
+        int cached_result = local_user_cache_lookup(user);
+        if (cached_result != ERROR_CHECK_LOCAL_USER) {
+            return cached_result;
+        }
+    }
+
+    struct passwd pwd;
+    struct passwd *ppwd = NULL;
+    char buf[DEFAULT_GETPWNAM_SIZE_MAX];
+    int result = ERROR_CHECK_LOCAL_USER;
+    int pwdresult = getpwnam_r(user, &pwd, buf, sizeof(buf), &ppwd);
+    if (pwdresult == 0 && ppwd != NULL) {
+        // compare passwd entry, for remote user pw_gecos will start as 'remote_user'
+        if (ppwd->pw_gecos != NULL && strncmp(ppwd->pw_gecos, REMOTE_USER_GECOS_PREFIX, strlen(REMOTE_USER_GECOS_PREFIX)) == 0) {
+            output_debug("user: %s, UID: %d, GECOS: %s is remote user.\n", user, ppwd->pw_uid, ppwd->pw_gecos);
+            result = IS_REMOTE_USER;
+        }
+        else {
+            output_debug("user: %s, UID: %d, GECOS: %s is local user.\n", user, ppwd->pw_uid, ppwd->pw_gecos);
+            result = IS_LOCAL_USER;
+        }
+
+        if (cache_valid) {
+            local_user_cache_add(user, result);
+        }
+    }
+
+    if (result == ERROR_CHECK_LOCAL_USER) {
+        output_error("get user information user failed, user: %s not found\n", user);
+    }
+
+    return result;
+}
+
+/*
+ * Get user name.
+ */
+char* get_user_name(char *user)
+{
+    if (user != NULL && strlen(user) != 0) {
+        return user;
+    }
+
+    // uid is the real user id: https://man7.org/linux/man-pages/man2/geteuid.2.html
+    output_debug("Login user name is empty, try get user name by euid.\n");
+    uid_t uid = getuid();
+    struct passwd* userwd = getpwuid(uid);
+    if (userwd != NULL && userwd->pw_name != NULL) {
+        return userwd->pw_name;
+    }
+
+    // euid is the effective user name, may not match real user id: https://man7.org/linux/man-pages/man2/geteuid.2.html
+    output_debug("Login user name is empty, try get user name by euid.\n");
+    uid_t euid = geteuid();
+    struct passwd* euserwd = getpwuid(euid);
+    if (euserwd != NULL && euserwd->pw_name != NULL) {
+        return euserwd->pw_name;
+    }
+
+    // if can't find user name by both euid or ruid, return UNKNOWN.
+    return unknown_username;
+}
+
+/*
+ * Tacacs authorization.
+ */
+int on_shell_execve (char *user, int shell_level, char *cmd, char **argv)
+{
+    char* user_namd = get_user_name(user);
+    output_debug("Authorization parameters:\n");
+    output_debug("    Shell level: %d\n", shell_level);
+    output_debug("    Current user: %s\n", user_namd);
+    output_debug("    Command full path: %s\n", cmd);
+    output_debug("    Parameters:\n");
+    char **parameter_array_pointer = argv;
+    int argc = 0;
+    while (*parameter_array_pointer != NULL) {
+        // output parameter
+        output_debug("        %s\n", *parameter_array_pointer);
+
+        // move to next parameter
+        parameter_array_pointer++;
+        argc++;
+    }
+
+    if (shell_level > 2) {
+        // when shell_level > 1, it's a recursive command in shell script.
+        output_debug("Recursive command %s ignored.\n", cmd);
+        return 0;
+    }
+
+    // reload config file when tacacs config changed
+    check_and_load_changed_tacacs_config();
+
+    int check_local_user_result = is_local_user(user_namd);
+    if (check_local_user_result != IS_REMOTE_USER) {
+        /*
+            Return 0 to check with linux permission control in following 2 scenario:
+                1: ERROR_CHECK_LOCAL_USER: check if user is local user failed because can't get user information.
+                        In this case, as failback, check with linux permission control.
+                2: IS_LOCAL_USER: user login as local user.
+                        In this case, tacacs authorization disabled for local user.
+        */
+        output_debug("ignore TACACS+ authorization for current user, check with local permission.\n");
+        return 0;
+    }
+
+    if (tacacs_ctrl & AUTHORIZATION_FLAG_TACACS) {
+        output_debug("start TACACS+ authorization for command %s with given arguments\n", cmd);
+        int ret = authorization_with_host_and_tty(user_namd, cmd, argv, argc);
+        switch (ret) {
+            case 0:
+            break;
+            case -2:
+                // -2 means no servers, so not authorized
+                fprintf(stdout, "%s not authorized by TACACS+ with given arguments, not executing\n", cmd);
+            break;
+            default:
+                // when command reject by server, authorization will failed immediately
+                fprintf(stdout, "%s authorize failed by TACACS+ with given arguments, not executing\n", cmd);
+                return ret;
+        }
+
+        if ((tacacs_ctrl & AUTHORIZATION_FLAG_LOCAL) == 0) {
+            // when local authorization disabled, tacacs authorization failed will block user from run current command
+            output_debug("local authorization disabled, TACACS+ authorization result: %d\n", ret);
+            return ret;
+        }
+    }
+
+    // return 0, so bash will continue run user command and will check user permission with linux permission check.
+    output_debug("start local authorization for command %s with given arguments\n", cmd);
+    return 0;
+}
@@ -0,0 +1,146 @@
+/* authorization_bench.c -- commands per second of bash plugin authorization against tacacs_stub_server. */
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "tacacs_stub_server.h"
+
+#define BENCH_CONFIG_FILE_TEMPLATE      "/tmp/bash_tacplus_bench_conf.XXXXXX"
+#define BENCH_COMMAND_COUNT_DEFAULT     10000
+#define BENCH_SECRET                    "bench_secret"
+
+/* Address not answering connect, TEST-NET-1 of RFC 5737 */
+#define BENCH_UNREACHABLE_SERVER        "192.0.2.1:49"
+
+/* bash_tacplus.c methods and config file */
+extern const char *tacacs_config_file;
+extern void load_tacacs_config();
+extern void tacacs_session_close();
+extern int tacacs_authorization(const char *user, const char *tty, const char *host, const char *cmd, char **args, int argc);
+
+void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-n commands] [-s] [-d] [-u] [-w delay_ms]\n", name);
+    fprintf(stderr, "  -n  commands to authorize, default %d\n", BENCH_COMMAND_COUNT_DEFAULT);
+    fprintf(stderr, "  -s  stub server not accept single-connection mode\n");
+    fprintf(stderr, "  -d  stub server deny all commands\n");
+    fprintf(stderr, "  -u  add %s as first server, route to it must drop packets\n", BENCH_UNREACHABLE_SERVER);
+    fprintf(stderr, "  -w  stub server delay in milliseconds before each reply\n");
+}
+
+double elapsed_seconds(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    stub_server_config_t config = { BENCH_SECRET, 1, 0, 0 };
+    char config_file[] = BENCH_CONFIG_FILE_TEMPLATE;
+    char *args[] = { "arg1", "arg2" };
+    int count = BENCH_COMMAND_COUNT_DEFAULT, unreachable = 0, port = 0;
+    int opt, listen_fd, fd, idx, failed = 0;
+    struct timespec start;
+    double first_seconds, seconds;
+    FILE *file;
+    pid_t pid;
+
+    while ((opt = getopt(argc, argv, "n:sduw:")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 's':
+            config.single_connect = 0;
+            break;
+        case 'd':
+            config.deny = 1;
+            break;
+        case 'u':
+            unreachable = 1;
+            break;
+        case 'w':
+            config.delay_ms = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (count <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    listen_fd = stub_server_listen(&port);
+    if (listen_fd < 0) {
+        perror("listen");
+        return 1;
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        _exit(stub_server_run(listen_fd, &config) < 0);
+    }
+
+    close(listen_fd);
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    fd = mkstemp(config_file);
+    file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (file == NULL) {
+        perror("config file");
+        kill(pid, SIGTERM);
+        return 1;
+    }
+
+    fprintf(file, "secret=%s\n", BENCH_SECRET);
+    if (unreachable) {
+        fprintf(file, "server=%s\n", BENCH_UNREACHABLE_SERVER);
+    }
+
+    fprintf(file, "server=127.0.0.1:%d\ntimeout=5\n", port);
+    fclose(file);
+
+    tacacs_config_file = config_file;
+    load_tacacs_config();
+
+    // first command include connect to server
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    failed += tacacs_authorization("bench_user", "tty0", "bench_host", "bench_command", args, 2) != config.deny;
+    first_seconds = elapsed_seconds(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (idx = 1; idx < count; idx++) {
+        failed += tacacs_authorization("bench_user", "tty0", "bench_host", "bench_command", args, 2) != config.deny;
+    }
+
+    seconds = elapsed_seconds(&start);
+
+    tacacs_session_close();
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    unlink(config_file);
+
+    printf("single-connection: %s, first command: %.3f ms\n", config.single_connect ? "accepted" : "not accepted", first_seconds * 1000);
+    if (count > 1) {
+        printf("%d commands in %.3f s, %.0f commands/sec\n", count - 1, seconds, seconds > 0 ? (count - 1) / seconds : 0);
+    }
+
+    if (failed) {
+        printf("%d command(s) got unexpected result\n", failed);
+    }
+
+    return failed != 0;
+}
@@ -0,0 +1,424 @@
+/* mock_helper.c -- mock helper for bash plugin UT. */
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pwd.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+
+/* Tacacs+ lib */
+#include <libtac/libtac.h>
+
+#include "mock_helper.h"
+
+// define BASH_PLUGIN_UT_DEBUG to output UT debug message.
+#if defined (BASH_PLUGIN_UT_DEBUG)
+#define debug_printf printf
+#define debug_vprintf vprintf
+#else
+#define debug_printf
+#define debug_vprintf
+#endif
+
+/* Mock syslog buffer */
+char mock_syslog_message_buffer[1024];
+
+/* define test scenarios for mock functions return different value by scenario. */
+int test_scenario;
+
+/* Mock tac_netop method result buffer. */
+char tac_natop_result_buffer[128];
+
+/* Mock tacplus_server_t. */
+typedef struct {
+    struct addrinfo *addr;
+    char key[256];
+} tacplus_server_t;
+
+/* Mock VRF name. */
+char *__vrfname = "MOCK VRF name";
+
+/* Mock tac timeout setting. */
+int tac_timeout = 10;
+
+/* Mock TACACS servers. */
+int tac_srv_no = 3;
+tacplus_server_t tac_srv[TAC_PLUS_MAXSERVERS];
+struct addrinfo tac_srv_addr[TAC_PLUS_MAXSERVERS];
+struct sockaddr tac_sock_addr[TAC_PLUS_MAXSERVERS];
+
+/* Mock authorization cache setting. */
+int tac_author_cache_ttl;
+int tac_author_cache_size;
+
+/* Mock tac_source_addr. */
+struct addrinfo *tac_source_addr;
+
+/* Mock libtac encryption and single-connection state. */
+int tac_encryption;
+const char *tac_secret;
+int tac_single_connect;
+int tac_single_connect_granted;
+
+/* define memory allocate counter. */
+int memory_allocate_count;
+
+/* define tacacs server connect counter. */
+int connect_count;
+
+/* define authorization message send counter. */
+int send_count;
+
+/* define seconds added to current time. */
+int time_offset;
+
+/* define getpwnam_r call counter. */
+int getpwnam_count;
+
+/* Passwd file used by is_local_user */
+extern const char *passwd_file;
+
+/* Server side of mock connections, keep open so client side stay alive. */
+#define MOCK_CONNECTION_MAX   64
+int mock_server_fds[MOCK_CONNECTION_MAX];
+int mock_server_fd_count;
+
+/* Client side of last mock connection. */
+int mock_last_connection_fd = -1;
+
+/* Initialize tacacs servers for test*/
+void initialize_tacacs_servers()
+{
+	for (int idx=0; idx < tac_srv_no; idx++)
+	{
+		// generate address with index
+		struct addrinfo hints, *servers;
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), "1.2.3.%d", idx);
+		getaddrinfo(buffer, "49", &hints, &servers);
+		tac_srv[idx].addr = &(tac_srv_addr[idx]);
+		memcpy(tac_srv[idx].addr, servers, sizeof(struct addrinfo));
+
+        tac_srv[idx].addr->ai_addr = &(tac_sock_addr[idx]);
+        memcpy(tac_srv[idx].addr->ai_addr, servers->ai_addr, sizeof(struct sockaddr));
+
+		snprintf(tac_srv[idx].key, sizeof(tac_srv[idx].key), "key%d", idx);
+        freeaddrinfo(servers);
+
+		debug_printf("MOCK: initialize_tacacs_servers with index: %d, address: %p\n", idx, tac_srv[idx].addr);
+	}
+}
+
+/* Set test scenario for test*/
+void set_test_scenario(int scenario)
+{
+  test_scenario = scenario;
+}
+
+/* Get test scenario for test*/
+int get_test_scenario()
+{
+  return test_scenario;
+}
+
+/* Set memory allocate count for test*/
+void set_memory_allocate_count(int count)
+{
+  memory_allocate_count = count;
+}
+
+/* Get memory allocate count for test*/
+int get_memory_allocate_count()
+{
+  return memory_allocate_count;
+}
+
+/* Set tacacs server connect count for test*/
+void set_connect_count(int count)
+{
+  connect_count = count;
+}
+
+/* Get tacacs server connect count for test*/
+int get_connect_count()
+{
+  return connect_count;
+}
+
+/* Set authorization message send count for test*/
+void set_send_count(int count)
+{
+  send_count = count;
+}
+
+/* Get authorization message send count for test*/
+int get_send_count()
+{
+  return send_count;
+}
+
+/* Set seconds added to current time for test*/
+void set_time_offset(int offset)
+{
+  time_offset = offset;
+}
+
+/* Set getpwnam_r call count for test*/
+void set_getpwnam_count(int count)
+{
+  getpwnam_count = count;
+}
+
+/* Get getpwnam_r call count for test*/
+int get_getpwnam_count()
+{
+  return getpwnam_count;
+}
+
+/* Mock time method */
+time_t mock_time(time_t *tloc)
+{
+	time_t now = time(NULL) + time_offset;
+	if (tloc != NULL)
+	{
+		*tloc = now;
+	}
+
+	return now;
+}
+
+/* Get client side of the last mock connection */
+int get_last_connection_fd()
+{
+  return mock_last_connection_fd;
+}
+
+/* Close server side of all mock connections */
+void close_mock_connections()
+{
+	for (int idx=0; idx < mock_server_fd_count; idx++)
+	{
+		close(mock_server_fds[idx]);
+	}
+
+	mock_server_fd_count = 0;
+}
+
+/* Mock xcalloc method */
+void *xcalloc(size_t count, size_t size)
+{
+	memory_allocate_count++;
+	debug_printf("MOCK: xcalloc memory count: %d\n", memory_allocate_count);
+	return malloc(count*size);
+}
+
+/* Mock tac_free_attrib method */
+void tac_add_attrib(struct tac_attrib **attr, char *attrname, char *attrvalue)
+{
+	debug_printf("MOCK: tac_add_attrib add attribute: %s, value: %s\n", attrname, attrvalue);
+}
+
+/* Mock tac_free_attrib method */
+void tac_free_attrib(struct tac_attrib **attr)
+{
+	memory_allocate_count--;
+	debug_printf("MOCK: tac_free_attrib memory count: %d\n", memory_allocate_count);
+
+	// the mock code here only free first allocated memory, because the mock tac_add_attrib implementation not allocate new memory.
+	free(*attr);
+}
+
+/* Mock tac_author_send method */
+int tac_author_send(int tac_fd, const char *user, char *tty, char *host,struct tac_attrib *attr)
+{
+	debug_printf("MOCK: tac_author_send with fd: %d, user:%s, tty:%s, host:%s, attr:%p\n", tac_fd, user, tty, host, attr);
+	send_count++;
+	if(TEST_SCEANRIO_CONNECTION_SEND_FAILED_RESULT == test_scenario)
+	{
+		// send auth message failed
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Mock tac_author_read method */
+int tac_author_read(int tac_fd, struct areply *reply)
+{
+	// TODO: fill reply message here for test
+	debug_printf("MOCK: tac_author_read with fd: %d\n", tac_fd);
+	tac_single_connect_granted = tac_single_connect && TEST_SCEANRIO_SINGLE_CONNECTION_NOT_GRANTED != test_scenario;
+	if (TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_READ_FAILED == test_scenario)
+	{
+		return -1;
+	}
+
+	if (TEST_SCEANRIO_CONNECTION_SEND_DENINED_RESULT == test_scenario)
+	{
+		reply->status = AUTHOR_STATUS_FAIL;
+	}
+	else
+	{
+		reply->status = AUTHOR_STATUS_PASS_REPL;
+	}
+
+	return 0;
+}
+
+/* Mock socket method */
+int mock_socket(int domain, int type, int protocol)
+{
+	int fds[2];
+
+	debug_printf("MOCK: socket with domain: %d\n", domain);
+
+	// return a connected socket, so plugin can check if connection still alive.
+	if (mock_server_fd_count >= MOCK_CONNECTION_MAX || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+	{
+		return -1;
+	}
+
+	mock_server_fds[mock_server_fd_count++] = fds[1];
+	return fds[0];
+}
+
+/* Mock connect method */
+int mock_connect(int fd, const struct sockaddr *address, socklen_t address_len)
+{
+	int fds[2];
+
+	debug_printf("MOCK: connect with fd: %d, address: %p\n", fd, address);
+	connect_count++;
+
+	switch (test_scenario)
+	{
+		case TEST_SCEANRIO_CONNECTION_ALL_FAILED:
+			errno = ECONNREFUSED;
+			return -1;
+		case TEST_SCEANRIO_CONNECTION_FIRST_SERVER_FAILED:
+			if (address == &(tac_sock_addr[0]))
+			{
+				errno = ECONNREFUSED;
+				return -1;
+			}
+			break;
+		case TEST_SCEANRIO_CONNECTION_FIRST_SERVER_SLOW:
+			// read side of a pipe never become writable, same as a connect waiting for SYN-ACK
+			if (address == &(tac_sock_addr[0]) && mock_server_fd_count < MOCK_CONNECTION_MAX && pipe(fds) == 0)
+			{
+				dup2(fds[0], fd);
+				close(fds[0]);
+				mock_server_fds[mock_server_fd_count++] = fds[1];
+				errno = EINPROGRESS;
+				return -1;
+			}
+			break;
+	}
+
+	mock_last_connection_fd = fd;
+	return 0;
+}
+
+/* Mock tac_ntop method */
+char *tac_ntop(const struct sockaddr *address)
+{
+	for (int idx=0; idx < tac_srv_no; idx++)
+	{
+		if (address == &(tac_sock_addr[idx]))
+		{
+			snprintf(tac_natop_result_buffer, sizeof(tac_natop_result_buffer), "TestAddress%d", idx);
+			return tac_natop_result_buffer;
+		}
+	}
+
+	return "UnknownTestAddress";
+}
+
+/* Mock parse_config_file method */
+int parse_config_file(const char *file)
+{
+	debug_printf("MOCK: parse_config_file: %s\n", file);
+
+	tac_author_cache_ttl = 0;
+	tac_author_cache_size = 0;
+	if (TEST_SCEANRIO_LOAD_AUTHORIZATION_CACHE_CONFIG == test_scenario)
+	{
+		tac_author_cache_ttl = 30;
+		tac_author_cache_size = 100;
+	}
+}
+
+/* Mock syslog method */
+void mock_syslog(int priority, const char *format, ...)
+{
+  // set mock message data to buffer for UT.
+  memset(mock_syslog_message_buffer, 0, sizeof(mock_syslog_message_buffer));
+
+  va_list args;
+  va_start (args, format);
+  // save message to buffer to UT check later
+  vsnprintf(mock_syslog_message_buffer, sizeof(mock_syslog_message_buffer), format, args);
+  va_end (args);
+
+  debug_printf("MOCK: syslog: %s\n", mock_syslog_message_buffer);
+}
+
+/* Mock getpwnam_r method, lookup passwd_file for passwd file scenario */
+int mock_getpwnam_r(const char *name, struct passwd *restrict pwbuf,
+                      char *buf, size_t buflen,
+                      struct passwd **restrict pwbufp)
+{
+	static char* test_user = "test_user";
+	static char* root_user = "root";
+	static char* empty_gecos = "";
+	static char* remote_gecos = "remote_user";
+	FILE *fp;
+	*pwbufp = NULL;
+	getpwnam_count++;
+	switch (test_scenario)
+	{
+		case TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT:
+		case TEST_SCEANRIO_CONNECTION_SEND_DENINED_RESULT:
+		case TEST_SCEANRIO_CONNECTION_FIRST_SERVER_FAILED:
+		case TEST_SCEANRIO_IS_LOCAL_USER_REMOTE:
+			if (strcmp(name, test_user) != 0) {
+				return 0;
+			}
+			pwbuf->pw_name = test_user;
+			pwbuf->pw_gecos = remote_gecos;
+			pwbuf->pw_uid = 1000;
+			*pwbufp = pwbuf;
+			return 0;
+		case TEST_SCEANRIO_IS_LOCAL_USER_ROOT:
+			if (strcmp(name, root_user) != 0) {
+				return 0;
+			}
+			pwbuf->pw_name = root_user;
+			pwbuf->pw_gecos = empty_gecos;
+			pwbuf->pw_uid = 0;
+			*pwbufp = pwbuf;
+			return 0;
+		case TEST_SCEANRIO_IS_LOCAL_USER_PASSWD_FILE:
+			// same as nss files module, scan passwd file until user found.
+			fp = fopen(passwd_file, "r");
+			if (fp == NULL) {
+				return errno;
+			}
+			while (fgetpwent_r(fp, pwbuf, buf, buflen, pwbufp) == 0) {
+				if (strcmp((*pwbufp)->pw_name, name) == 0) {
+					break;
+				}
+				*pwbufp = NULL;
+			}
+			fclose(fp);
+			return 0;
+		case TEST_SCEANRIO_IS_LOCAL_USER_NOT_FOUND:
+			return 0;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,754 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <CUnit/CUnit.h>
+#include <CUnit/Basic.h>
+#include "mock_helper.h"
+#include <libtac/support.h>
+
+#define IS_LOCAL_USER              0
+#define IS_REMOTE_USER             1
+#define ERROR_CHECK_LOCAL_USER     2
+
+/* tacacs debug flag */
+extern int tacacs_ctrl;
+
+/* tacacs server hold down state */
+extern time_t server_hold_down[TAC_PLUS_MAXSERVERS];
+
+/* libtac single-connection mode request */
+extern int tac_single_connect;
+
+/* tacacs authorization cache setting and statistics */
+extern int authorization_cache_ttl;
+extern int authorization_cache_size;
+extern unsigned long authorization_cache_hits;
+extern unsigned long authorization_cache_misses;
+
+/* tacacs authorization cache methods, return types not int */
+extern char *authorization_cache_join_args(char **args, int argc, size_t *len);
+extern uint64_t authorization_cache_hash(const char *user, const char *tty, const char *cmd, char **args, int argc);
+
+/* tacacs config file attribute */
+extern struct stat config_file_attr;
+
+/* passwd file used by is_local_user */
+extern const char *passwd_file;
+
+/* synthetic passwd file for is_local_user test */
+#define TEST_PASSWD_FILE_TEMPLATE       "/tmp/bash_tacplus_ut_passwd.XXXXXX"
+#define TEST_PASSWD_FILE_LINES          50000
+#define TEST_PASSWD_LOOKUP_COUNT        100
+
+int clean_up() {
+  return 0;
+}
+
+int start_up() {
+  initialize_tacacs_servers();
+  tacacs_ctrl = PAM_TAC_DEBUG;
+
+  // plugin always load config before authorization, which request single-connection mode
+  tac_single_connect = 1;
+  return 0;
+}
+
+/* Test tacacs_authorization all tacacs server connect failed case */
+void testcase_tacacs_authorization_all_failed() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+
+	// test connection failed case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_ALL_FAILED);
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "Failed to connect to TACACS server(s)\n");
+
+	// check return value, -2 for all server not reachable
+	CU_ASSERT_EQUAL(result, -2);
+}
+
+/* Test tacacs_authorization get failed result case */
+void testcase_tacacs_authorization_faled() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	// test connection failed case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_FAILED_RESULT);
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+
+    // send auth message failed.
+	CU_ASSERT_EQUAL(result, -1);
+}
+
+/* Test tacacs_authorization read failed case */
+void testcase_tacacs_authorization_read_failed() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	// test connection failed case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_READ_FAILED);
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "test_command not authorized from TestAddress2\n");
+
+    // read auth message failed.
+	CU_ASSERT_EQUAL(result, -1);
+}
+
+/* Test tacacs_authorization get denined case */
+void testcase_tacacs_authorization_denined() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	// test connection denined case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_DENINED_RESULT);
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "test_command not authorized from TestAddress2\n");
+
+    // send auth message denined.
+	CU_ASSERT_EQUAL(result, 1);
+}
+
+/* Test tacacs_authorization get success case */
+void testcase_tacacs_authorization_success() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	// test connection success case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+
+	// wuthorization success
+	CU_ASSERT_EQUAL(result, 0);
+}
+
+/* Test tacacs_authorization reuse connection between commands */
+void testcase_tacacs_authorization_session_reuse() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	tacacs_session_close();
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	set_connect_count(0);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// second command use the kept connection
+	CU_ASSERT_EQUAL(get_connect_count(), 1);
+
+	// server closed connection, reconnect for next command
+	close_mock_connections();
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_connect_count(), 2);
+}
+
+/* Test tacacs_authorization skip unreachable server */
+void testcase_tacacs_authorization_server_hold_down() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	tacacs_session_close();
+	memset(server_hold_down, 0, sizeof(server_hold_down));
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_FIRST_SERVER_FAILED);
+	set_connect_count(0);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_connect_count(), 2);
+
+	// first server in hold down, not try it again
+	tacacs_session_close();
+	set_connect_count(0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_connect_count(), 1);
+
+	// all servers in hold down, still try them
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_ALL_FAILED);
+	tacacs_session_close();
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, -2);
+	set_connect_count(0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, -2);
+	CU_ASSERT_EQUAL(get_connect_count(), 3);
+
+	memset(server_hold_down, 0, sizeof(server_hold_down));
+}
+
+/* Test tacacs_authorization not wait tac_timeout on a server not answering */
+void testcase_tacacs_authorization_first_server_slow() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	tacacs_session_close();
+	memset(server_hold_down, 0, sizeof(server_hold_down));
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_FIRST_SERVER_SLOW);
+	set_connect_count(0);
+
+	time_t start = time(NULL);
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// second server connected after the stagger time, long before tac_timeout
+	CU_ASSERT_EQUAL(get_connect_count(), 2);
+	CU_ASSERT_TRUE(time(NULL) - start < tac_timeout);
+
+	// first server not answered in time, skip it so next command reuse the connection to second server
+	CU_ASSERT_NOT_EQUAL(server_hold_down[0], 0);
+	set_connect_count(0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_connect_count(), 0);
+
+	tacacs_session_close();
+	close_mock_connections();
+	memset(server_hold_down, 0, sizeof(server_hold_down));
+}
+
+/* Test tacacs_authorization not keep connection when server not accept single-connection mode */
+void testcase_tacacs_authorization_single_connection_not_granted() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	load_tacacs_config();
+	CU_ASSERT_EQUAL(tac_single_connect, 1);
+
+	set_test_scenario(TEST_SCEANRIO_SINGLE_CONNECTION_NOT_GRANTED);
+	set_connect_count(0);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// every command use a new connection
+	CU_ASSERT_EQUAL(get_connect_count(), 2);
+}
+
+/* Test tacacs_authorization cache result until TTL expired */
+void testcase_tacacs_authorization_cache_ttl() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 10;
+	authorization_cache_hits = 0;
+	set_time_offset(0);
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	set_send_count(0);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// second command authorized from cache
+	CU_ASSERT_EQUAL(get_send_count(), 1);
+	CU_ASSERT_EQUAL(authorization_cache_hits, 1);
+
+	// different arguments not match cache
+	testargv[1] = "arg3";
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_send_count(), 2);
+
+	// cache entry expired after TTL
+	set_time_offset(11);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_send_count(), 3);
+
+	set_time_offset(0);
+	authorization_cache_clear();
+	authorization_cache_ttl = 0;
+}
+
+/* Test authorization cache compare arguments, not only the hash of them */
+void testcase_authorization_cache_args_compare() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+	char *otherargv[1];
+	otherargv[0] = "arg1 arg2";
+	size_t args_len, other_len;
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 10;
+	set_time_offset(0);
+
+	char *args = authorization_cache_join_args(testargv, 2, &args_len);
+	char *other = authorization_cache_join_args(otherargv, 1, &other_len);
+	CU_ASSERT_PTR_NOT_NULL(args);
+	CU_ASSERT_PTR_NOT_NULL(other);
+	uint64_t hash = authorization_cache_hash("test_user", "tty0", "test_command", testargv, 2);
+	authorization_cache_add("test_user", "tty0", "test_command", args, args_len, hash);
+	CU_ASSERT_TRUE(authorization_cache_lookup("test_user", "tty0", "test_command", args, args_len, hash));
+
+	// same hash with different arguments, as after a hash collision, not match cache
+	CU_ASSERT_FALSE(authorization_cache_lookup("test_user", "tty0", "test_command", other, other_len, hash));
+	CU_ASSERT_FALSE(authorization_cache_lookup("test_user", "tty0", "test_command", args, args_len - 1, hash));
+	CU_ASSERT_FALSE(authorization_cache_lookup("test_user", "tty0", "test_command", args, 0, hash));
+
+	free(args);
+	free(other);
+	authorization_cache_clear();
+	authorization_cache_ttl = 0;
+}
+
+/* Test authorization cache statistics logged when cache cleared */
+void testcase_authorization_cache_statistics() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 10;
+	set_time_offset(0);
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// statistics logged and reset with the cache
+	authorization_cache_clear();
+	CU_ASSERT_PTR_NOT_NULL(strstr(mock_syslog_message_buffer, "authorization cache hits: 1, misses: 1\n"));
+	CU_ASSERT_EQUAL(authorization_cache_hits, 0);
+	CU_ASSERT_EQUAL(authorization_cache_misses, 0);
+
+	authorization_cache_ttl = 0;
+}
+
+/* Test tacacs_authorization not cache denied result */
+void testcase_tacacs_authorization_cache_denied() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 10;
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_DENINED_RESULT);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 1);
+
+	// denied result always check with server
+	set_send_count(0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 1);
+	CU_ASSERT_NOT_EQUAL(get_send_count(), 0);
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 0;
+}
+
+/* Test config file change invalidate authorization cache */
+void testcase_tacacs_authorization_cache_config_changed() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 10;
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// config file changed, cached result dropped
+	config_file_attr.st_mtime = 1;
+	check_and_load_changed_tacacs_config();
+	authorization_cache_ttl = 10;
+
+	set_send_count(0);
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_send_count(), 1);
+
+	authorization_cache_clear();
+	authorization_cache_ttl = 0;
+}
+
+/* Test authorization cache setting parsed with config file, and hashed cache lookup */
+void testcase_tacacs_authorization_cache_config() {
+	char *testargv[2];
+	char cmd[32];
+	int idx;
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	set_test_scenario(TEST_SCEANRIO_LOAD_AUTHORIZATION_CACHE_CONFIG);
+	config_file_attr.st_mtime = 1;
+	check_and_load_changed_tacacs_config();
+
+	// table size round up to power of 2
+	CU_ASSERT_EQUAL(authorization_cache_ttl, 30);
+	CU_ASSERT_EQUAL(authorization_cache_size, 128);
+
+	// commands authorized by server all found from cache
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	for (idx = 0; idx < 64; idx++) {
+		snprintf(cmd, sizeof(cmd), "test_command%d", idx);
+		tacacs_authorization("test_user","tty0","test_host",cmd,testargv,2);
+	}
+
+	set_send_count(0);
+	for (idx = 0; idx < 64; idx++) {
+		snprintf(cmd, sizeof(cmd), "test_command%d", idx);
+		CU_ASSERT_EQUAL(tacacs_authorization("test_user","tty0","test_host",cmd,testargv,2), 0);
+	}
+
+	CU_ASSERT_EQUAL(get_send_count(), 0);
+
+	// cache disabled when config file not set TTL
+	config_file_attr.st_mtime = 1;
+	check_and_load_changed_tacacs_config();
+	CU_ASSERT_EQUAL(authorization_cache_ttl, 0);
+	CU_ASSERT_EQUAL(authorization_cache_size, 64);
+}
+
+/* Test kept connection not inherited by commands, and not shared with subshells */
+void testcase_tacacs_authorization_session_owner() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	tacacs_session_close();
+	memset(server_hold_down, 0, sizeof(server_hold_down));
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	set_connect_count(0);
+
+	int result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+
+	// kept connection closed when shell exec a command
+	int flags = fcntl(get_last_connection_fd(), F_GETFD);
+	CU_ASSERT_TRUE(flags >= 0 && (flags & FD_CLOEXEC));
+
+	// subshell open its own connection, not send on the connection of parent shell
+	pid_t pid = fork();
+	if (pid == 0) {
+		result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+		_exit((result == 0 && get_connect_count() == 2) ? 0 : 1);
+	}
+
+	int status = -1;
+	CU_ASSERT_EQUAL(waitpid(pid, &status, 0), pid);
+	CU_ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	// parent shell still reuse its connection
+	result = tacacs_authorization("test_user","tty0","test_host","test_command",testargv,2);
+	CU_ASSERT_EQUAL(result, 0);
+	CU_ASSERT_EQUAL(get_connect_count(), 1);
+}
+
+/* Test authorization_with_host_and_tty get success case */
+void testcase_authorization_with_host_and_tty_success() {
+	char *testargv[2];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+
+	// test connection success case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	int result = authorization_with_host_and_tty("test_user","test_command",testargv,2);
+
+	// wuthorization success
+	CU_ASSERT_EQUAL(result, 0);
+}
+
+/* Test check_and_load_changed_tacacs_config */
+void testcase_check_and_load_changed_tacacs_config() {
+
+	set_test_scenario(TEST_SCEANRIO_LOAD_CHANGED_TACACS_CONFIG);
+
+	// test connection failed case
+	check_and_load_changed_tacacs_config();
+
+    // check server config updated.
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "Server 2, address:TestAddress2, key:key2\n");
+
+	// check and load file again.
+	check_and_load_changed_tacacs_config();
+
+    // check server config not update.
+	char* configNotChangeLog = "tacacs config file not change: last modified time";
+	CU_ASSERT_TRUE(strncmp(mock_syslog_message_buffer, configNotChangeLog, strlen(configNotChangeLog)) == 0);
+}
+
+/* Test on_shell_execve authorization successed */
+void testcase_on_shell_execve_success() {
+	char *testargv[3];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+	testargv[2] = 0;
+
+	// test connection failed case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_SUCCESS_RESULT);
+	on_shell_execve("test_user", 1, "test_command", testargv);
+
+    // check authorized success.
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "test_command authorize successed by TACACS+ with given arguments\n");
+}
+
+/* Test on_shell_execve authorization denined */
+void testcase_on_shell_execve_denined() {
+	char *testargv[3];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+	testargv[2] = 0;
+
+	// test connection failed case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_SEND_DENINED_RESULT);
+	on_shell_execve("test_user", 1, "test_command", testargv);
+
+    // check authorized failed.
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "test_command authorize failed by TACACS+ with given arguments, not executing\n");
+}
+
+/* Test on_shell_execve authorization failed */
+void testcase_on_shell_execve_failed() {
+	char *testargv[3];
+	testargv[0] = "arg1";
+	testargv[1] = "arg2";
+	testargv[2] = 0;
+
+	// test connection failed case
+	set_test_scenario(TEST_SCEANRIO_CONNECTION_ALL_FAILED);
+	on_shell_execve("test_user", 1, "test_command", testargv);
+
+    // check not authorized.
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "test_command not authorized by TACACS+ with given arguments, not executing\n");
+}
+
+/* Test is_local_user unknown user */
+void testcase_is_local_user_unknown() {
+	set_test_scenario(TEST_SCEANRIO_IS_LOCAL_USER_UNKNOWN);
+	int result = is_local_user("UNKNOWN");
+
+    // check unknown user is remote.
+	CU_ASSERT_EQUAL(result, IS_REMOTE_USER);
+}
+
+/* Test is_local_user not found user */
+void testcase_is_local_user_not_found() {
+	set_test_scenario(TEST_SCEANRIO_IS_LOCAL_USER_NOT_FOUND);
+	int result = is_local_user("notexist");
+
+    // check unknown user is remote.
+	CU_ASSERT_EQUAL(result, ERROR_CHECK_LOCAL_USER);
+	CU_ASSERT_STRING_EQUAL(mock_syslog_message_buffer, "get user information user failed, user: notexist not found\n");
+}
+
+/* Test is_local_user root user */
+void testcase_is_local_user_root() {
+	set_test_scenario(TEST_SCEANRIO_IS_LOCAL_USER_ROOT);
+	int result = is_local_user("root");
+
+    // check unknown user is remote.
+	CU_ASSERT_EQUAL(result, IS_LOCAL_USER);
+}
+
+/* Test is_local_user remote user */
+void testcase_is_local_user_remote() {
+	set_test_scenario(TEST_SCEANRIO_IS_LOCAL_USER_REMOTE);
+	int result = is_local_user("test_user");
+
+    // check unknown user is remote.
+	CU_ASSERT_EQUAL(result, IS_REMOTE_USER);
+}
+
+/* Synthetic passwd file, unique name so parallel UT runs not share it */
+char test_passwd_file[] = TEST_PASSWD_FILE_TEMPLATE;
+
+/* Create synthetic passwd file, and use it as passwd file of plugin */
+void create_test_passwd_file() {
+	strcpy(test_passwd_file, TEST_PASSWD_FILE_TEMPLATE);
+	int fd = mkstemp(test_passwd_file);
+	CU_ASSERT_TRUE_FATAL(fd >= 0);
+	close(fd);
+	passwd_file = test_passwd_file;
+}
+
+/* Write synthetic passwd file, the last entry is remote user test_user */
+void write_test_passwd_file(int lines) {
+	FILE *fp = fopen(test_passwd_file, "w");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+
+	fprintf(fp, "root:x:0:0:root:/root:/bin/bash\n");
+	int idx;
+	for (idx = 1; idx < lines - 1; idx++) {
+		fprintf(fp, "user%d:x:%d:%d:local user:/home/user%d:/bin/bash\n", idx, 2000 + idx, 2000 + idx, idx);
+	}
+
+	fprintf(fp, "test_user:x:1000:1000:remote_user:/home/test_user:/bin/bash\n");
+	fclose(fp);
+}
+
+/* Elapsed microseconds since given time */
+long elapsed_usec(struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000L;
+}
+
+/* Test is_local_user cache result until passwd file changed */
+void testcase_is_local_user_cache() {
+	set_test_scenario(TEST_SCEANRIO_IS_LOCAL_USER_PASSWD_FILE);
+	create_test_passwd_file();
+	write_test_passwd_file(10);
+	local_user_cache_clear();
+	set_getpwnam_count(0);
+
+	CU_ASSERT_EQUAL(is_local_user("test_user"), IS_REMOTE_USER);
+	CU_ASSERT_EQUAL(is_local_user("test_user"), IS_REMOTE_USER);
+	CU_ASSERT_EQUAL(is_local_user("root"), IS_LOCAL_USER);
+	CU_ASSERT_EQUAL(is_local_user("root"), IS_LOCAL_USER);
+
+	// second lookup of each user from cache
+	CU_ASSERT_EQUAL(get_getpwnam_count(), 2);
+
+	// not found user never cached
+	CU_ASSERT_EQUAL(is_local_user("notexist"), ERROR_CHECK_LOCAL_USER);
+	CU_ASSERT_EQUAL(is_local_user("notexist"), ERROR_CHECK_LOCAL_USER);
+	CU_ASSERT_EQUAL(get_getpwnam_count(), 4);
+
+	// passwd file changed, cached result dropped
+	write_test_passwd_file(20);
+	CU_ASSERT_EQUAL(is_local_user("test_user"), IS_REMOTE_USER);
+	CU_ASSERT_EQUAL(get_getpwnam_count(), 5);
+
+	// passwd file missing, cache not used
+	unlink(test_passwd_file);
+	CU_ASSERT_EQUAL(is_local_user("test_user"), ERROR_CHECK_LOCAL_USER);
+	CU_ASSERT_EQUAL(get_getpwnam_count(), 6);
+
+	local_user_cache_clear();
+	passwd_file = "/etc/passwd";
+}
+
+/* Benchmark is_local_user with large passwd file */
+void testcase_is_local_user_benchmark() {
+	struct timespec start;
+	long uncached_usec, cached_usec;
+	int idx;
+
+	set_test_scenario(TEST_SCEANRIO_IS_LOCAL_USER_PASSWD_FILE);
+	create_test_passwd_file();
+	write_test_passwd_file(TEST_PASSWD_FILE_LINES);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (idx = 0; idx < TEST_PASSWD_LOOKUP_COUNT; idx++) {
+		local_user_cache_clear();
+		CU_ASSERT_EQUAL(is_local_user("test_user"), IS_REMOTE_USER);
+	}
+	uncached_usec = elapsed_usec(&start);
+
+	local_user_cache_clear();
+	set_getpwnam_count(0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (idx = 0; idx < TEST_PASSWD_LOOKUP_COUNT; idx++) {
+		CU_ASSERT_EQUAL(is_local_user("test_user"), IS_REMOTE_USER);
+	}
+	cached_usec = elapsed_usec(&start);
+
+	printf("is_local_user with %d passwd entries, %d lookups: uncached %ld us, cached %ld us\n",
+			TEST_PASSWD_FILE_LINES, TEST_PASSWD_LOOKUP_COUNT, uncached_usec, cached_usec);
+
+	// only first lookup scan passwd file
+	CU_ASSERT_EQUAL(get_getpwnam_count(), 1);
+	CU_ASSERT(cached_usec < uncached_usec);
+
+	unlink(test_passwd_file);
+	local_user_cache_clear();
+	passwd_file = "/etc/passwd";
+}
+
+int main(void) {
+  if (CUE_SUCCESS != CU_initialize_registry()) {
+    return CU_get_error();
+  }
+
+  CU_pSuite ste = CU_add_suite("plugin_test", start_up, clean_up);
+  if (NULL == ste) {
+    CU_cleanup_registry();
+    return CU_get_error();
+  }
+
+  if (CU_get_error() != CUE_SUCCESS) {
+    fprintf(stderr, "Error creating suite: (%d)%s\n", CU_get_error(), CU_get_error_msg());
+    return CU_get_error();
+  }
+
+  if (!CU_add_test(ste, "Test testcase_tacacs_authorization_all_failed()...\n", testcase_tacacs_authorization_all_failed)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_faled()...\n", testcase_tacacs_authorization_faled)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_read_failed()...\n", testcase_tacacs_authorization_read_failed)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_denined()...\n", testcase_tacacs_authorization_denined)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_success()...\n", testcase_tacacs_authorization_success)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_session_reuse()...\n", testcase_tacacs_authorization_session_reuse)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_server_hold_down()...\n", testcase_tacacs_authorization_server_hold_down)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_first_server_slow()...\n", testcase_tacacs_authorization_first_server_slow)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_single_connection_not_granted()...\n", testcase_tacacs_authorization_single_connection_not_granted)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_session_owner()...\n", testcase_tacacs_authorization_session_owner)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_cache_config()...\n", testcase_tacacs_authorization_cache_config)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_cache_ttl()...\n", testcase_tacacs_authorization_cache_ttl)
+	  || !CU_add_test(ste, "Test testcase_authorization_cache_args_compare()...\n", testcase_authorization_cache_args_compare)
+	  || !CU_add_test(ste, "Test testcase_authorization_cache_statistics()...\n", testcase_authorization_cache_statistics)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_cache_denied()...\n", testcase_tacacs_authorization_cache_denied)
+	  || !CU_add_test(ste, "Test testcase_tacacs_authorization_cache_config_changed()...\n", testcase_tacacs_authorization_cache_config_changed)
+	  || !CU_add_test(ste, "Test testcase_authorization_with_host_and_tty_success()...\n", testcase_authorization_with_host_and_tty_success)
+	  || !CU_add_test(ste, "Test testcase_check_and_load_changed_tacacs_config()...\n", testcase_check_and_load_changed_tacacs_config)
+	  || !CU_add_test(ste, "Test testcase_on_shell_execve_success()...\n", testcase_on_shell_execve_success)
+	  || !CU_add_test(ste, "Test testcase_on_shell_execve_denined()...\n", testcase_on_shell_execve_denined)
+	  || !CU_add_test(ste, "Test testcase_on_shell_execve_failed()...\n", testcase_on_shell_execve_failed)
+	  || !CU_add_test(ste, "Test testcase_is_local_user_unknown()...\n", testcase_is_local_user_unknown)
+	  || !CU_add_test(ste, "Test testcase_is_local_user_not_found()...\n", testcase_is_local_user_not_found)
+	  || !CU_add_test(ste, "Test testcase_is_local_user_root()...\n", testcase_is_local_user_root)
+	  || !CU_add_test(ste, "Test testcase_is_local_user_remote()...\n", testcase_is_local_user_remote)
+	  || !CU_add_test(ste, "Test testcase_is_local_user_cache()...\n", testcase_is_local_user_cache)
+	  || !CU_add_test(ste, "Test testcase_is_local_user_benchmark()...\n", testcase_is_local_user_benchmark)) {
+    CU_cleanup_registry();
+    return CU_get_error();
+  }
+
+  if (CU_get_error() != CUE_SUCCESS) {
+    fprintf(stderr, "Error adding test: (%d)%s\n", CU_get_error(), CU_get_error_msg());
+  }
+
+  // run all test
+  CU_basic_set_mode(CU_BRM_VERBOSE);
+  CU_ErrorCode run_errors = CU_basic_run_suite(ste);
+  if (run_errors != CUE_SUCCESS) {
+    fprintf(stderr, "Error running tests: (%d)%s\n", run_errors, CU_get_error_msg());
+  }
+
+  CU_basic_show_failures(CU_get_failure_list());
+
+  // use failed UT count as return value
+  return CU_get_number_of_failure_records();
+}
\ No newline at end of file
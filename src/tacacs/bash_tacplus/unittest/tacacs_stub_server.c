@@ -0,0 +1,376 @@
+/* tacacs_stub_server.c -- minimal TACACS+ authorization server for bash plugin benchmark. */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "tacacs_stub_server.h"
+
+/* TACACS+ header, RFC 8907 section 4.1 */
+#define TAC_HEADER_LEN              12
+#define TAC_TYPE_AUTHOR             0x02
+#define TAC_FLAG_UNENCRYPTED        0x01
+#define TAC_FLAG_SINGLE_CONNECT     0x04
+
+/* Authorization reply status, RFC 8907 section 6.2 */
+#define TAC_AUTHOR_STATUS_PASS_ADD  0x01
+#define TAC_AUTHOR_STATUS_FAIL      0x10
+
+/* Max body accepted from client, authorization request is far smaller */
+#define STUB_BODY_MAX               65536
+
+/* Max clients served together */
+#define STUB_CLIENT_MAX             64
+
+/* MD5 context, RFC 1321 */
+typedef struct {
+    uint32_t state[4];
+    uint64_t count;
+    uint8_t buffer[64];
+} stub_md5_t;
+
+#define MD5_F(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define MD5_G(x, y, z) (((x) & (z)) | ((y) & ~(z)))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+#define MD5_ROTATE(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define MD5_STEP(f, a, b, c, d, x, s, t) \
+    (a) += f((b), (c), (d)) + (x) + (t); \
+    (a) = MD5_ROTATE((a), (s)) + (b);
+
+static void stub_md5_transform(uint32_t state[4], const uint8_t block[64])
+{
+    static const uint32_t t[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+    };
+    static const int s[4][4] = { { 7, 12, 17, 22 }, { 5, 9, 14, 20 }, { 4, 11, 16, 23 }, { 6, 10, 15, 21 } };
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], x[16], tmp;
+    int i, g;
+
+    for (i = 0; i < 16; i++) {
+        x[i] = block[i * 4] | (block[i * 4 + 1] << 8) | (block[i * 4 + 2] << 16) | ((uint32_t)block[i * 4 + 3] << 24);
+    }
+
+    for (i = 0; i < 64; i++) {
+        switch (i / 16) {
+        case 0:
+            g = i;
+            MD5_STEP(MD5_F, a, b, c, d, x[g], s[0][i % 4], t[i]);
+            break;
+        case 1:
+            g = (5 * i + 1) % 16;
+            MD5_STEP(MD5_G, a, b, c, d, x[g], s[1][i % 4], t[i]);
+            break;
+        case 2:
+            g = (3 * i + 5) % 16;
+            MD5_STEP(MD5_H, a, b, c, d, x[g], s[2][i % 4], t[i]);
+            break;
+        default:
+            g = (7 * i) % 16;
+            MD5_STEP(MD5_I, a, b, c, d, x[g], s[3][i % 4], t[i]);
+            break;
+        }
+
+        // rotate registers, so every step update a
+        tmp = d;
+        d = c;
+        c = b;
+        b = a;
+        a = tmp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+static void stub_md5_init(stub_md5_t *ctx)
+{
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->count = 0;
+}
+
+static void stub_md5_update(stub_md5_t *ctx, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    size_t used = ctx->count % 64;
+
+    ctx->count += len;
+    while (len > 0) {
+        size_t n = 64 - used < len ? 64 - used : len;
+        memcpy(ctx->buffer + used, p, n);
+        used += n;
+        p += n;
+        len -= n;
+        if (used == 64) {
+            stub_md5_transform(ctx->state, ctx->buffer);
+            used = 0;
+        }
+    }
+}
+
+static void stub_md5_final(stub_md5_t *ctx, uint8_t digest[16])
+{
+    uint64_t bits = ctx->count * 8;
+    uint8_t pad = 0x80, zero = 0, length[8];
+    int i;
+
+    stub_md5_update(ctx, &pad, 1);
+    while (ctx->count % 64 != 56) {
+        stub_md5_update(ctx, &zero, 1);
+    }
+
+    for (i = 0; i < 8; i++) {
+        length[i] = (uint8_t)(bits >> (8 * i));
+    }
+
+    stub_md5_update(ctx, length, 8);
+    for (i = 0; i < 4; i++) {
+        digest[i * 4] = (uint8_t)ctx->state[i];
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 3] = (uint8_t)(ctx->state[i] >> 24);
+    }
+}
+
+/*
+ * XOR body with the MD5 pseudo pad, RFC 8907 section 4.5, same operation encrypt and decrypt.
+ */
+static void stub_crypt(const uint8_t *header, const char *key, uint8_t *body, uint32_t len)
+{
+    uint8_t digest[16];
+    stub_md5_t ctx;
+    uint32_t i;
+
+    if (key == NULL || !*key || (header[3] & TAC_FLAG_UNENCRYPTED)) {
+        return;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (i % 16 == 0) {
+            // pad block = MD5(session_id, key, version, seq_no, previous pad block)
+            stub_md5_init(&ctx);
+            stub_md5_update(&ctx, header + 4, 4);
+            stub_md5_update(&ctx, key, strlen(key));
+            stub_md5_update(&ctx, header, 1);
+            stub_md5_update(&ctx, header + 2, 1);
+            if (i > 0) {
+                stub_md5_update(&ctx, digest, sizeof(digest));
+            }
+
+            stub_md5_final(&ctx, digest);
+        }
+
+        body[i] ^= digest[i % 16];
+    }
+}
+
+/*
+ * Read exactly len bytes, return 0 on success.
+ */
+static int stub_read_full(int fd, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            return -1;
+        }
+
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+/*
+ * Answer one authorization request, return 1 when connection kept for next request, 0 to close it.
+ */
+static int stub_serve_request(int fd, const stub_server_config_t *config, int *single_connect)
+{
+    static uint8_t body[STUB_BODY_MAX];
+    uint8_t header[TAC_HEADER_LEN], reply[TAC_HEADER_LEN + 6];
+    uint32_t len;
+
+    if (stub_read_full(fd, header, sizeof(header)) < 0) {
+        return 0;
+    }
+
+    len = ((uint32_t)header[8] << 24) | (header[9] << 16) | (header[10] << 8) | header[11];
+    if (header[1] != TAC_TYPE_AUTHOR || len > sizeof(body) || stub_read_full(fd, body, len) < 0) {
+        return 0;
+    }
+
+    // body is only decrypted to follow the protocol, every command get same result
+    stub_crypt(header, config->key, body, len);
+
+    // single-connection mode is negotiated by the first reply of a connection
+    if (*single_connect < 0) {
+        *single_connect = config->single_connect && (header[3] & TAC_FLAG_SINGLE_CONNECT);
+    }
+
+    if (config->delay_ms > 0) {
+        poll(NULL, 0, config->delay_ms);
+    }
+
+    memcpy(reply, header, 4);
+    reply[2] = header[2] + 1;
+    reply[3] = (header[3] & TAC_FLAG_UNENCRYPTED) | (*single_connect ? TAC_FLAG_SINGLE_CONNECT : 0);
+    memcpy(reply + 4, header + 4, 4);
+    reply[8] = reply[9] = reply[10] = 0;
+    reply[11] = 6;
+
+    // status, arg_cnt, server_msg_len, data_len
+    memset(reply + TAC_HEADER_LEN, 0, 6);
+    reply[TAC_HEADER_LEN] = config->deny ? TAC_AUTHOR_STATUS_FAIL : TAC_AUTHOR_STATUS_PASS_ADD;
+    stub_crypt(reply, config->key, reply + TAC_HEADER_LEN, 6);
+
+    if (write(fd, reply, sizeof(reply)) != sizeof(reply)) {
+        return 0;
+    }
+
+    return *single_connect;
+}
+
+/*
+ * Serve clients connected to listen_fd until killed.
+ */
+int stub_server_run(int listen_fd, const stub_server_config_t *config)
+{
+    struct pollfd pfds[STUB_CLIENT_MAX + 1];
+    int single_connect[STUB_CLIENT_MAX + 1];
+    int count = 1, idx;
+
+    signal(SIGPIPE, SIG_IGN);
+    pfds[0].fd = listen_fd;
+    pfds[0].events = POLLIN;
+
+    while (1) {
+        if (poll(pfds, count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            perror("poll");
+            return -1;
+        }
+
+        for (idx = count - 1; idx > 0; idx--) {
+            if (!pfds[idx].revents || stub_serve_request(pfds[idx].fd, config, &single_connect[idx])) {
+                continue;
+            }
+
+            // server close connection after reply when not in single-connection mode
+            close(pfds[idx].fd);
+            pfds[idx] = pfds[--count];
+            single_connect[idx] = single_connect[count];
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0 && count > STUB_CLIENT_MAX) {
+                close(fd);
+            }
+            else if (fd >= 0) {
+                pfds[count].fd = fd;
+                pfds[count].events = POLLIN;
+                single_connect[count] = -1;
+                count++;
+            }
+        }
+    }
+}
+
+/*
+ * Listen on 127.0.0.1:port, port 0 pick a free port, return the socket and set the port.
+ */
+int stub_server_listen(int *port)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd, on = 1;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(*port);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || listen(fd, STUB_CLIENT_MAX) < 0
+        || getsockname(fd, (struct sockaddr *)&addr, &len) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+#if !defined (STUB_SERVER_NO_MAIN)
+int main(int argc, char **argv)
+{
+    stub_server_config_t config = { "", 1, 0, 0 };
+    int port = 49, opt, fd;
+
+    while ((opt = getopt(argc, argv, "p:k:sdw:")) != -1) {
+        switch (opt) {
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 'k':
+            config.key = optarg;
+            break;
+        case 's':
+            config.single_connect = 0;
+            break;
+        case 'd':
+            config.deny = 1;
+            break;
+        case 'w':
+            config.delay_ms = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-p port] [-k key] [-s] [-d] [-w delay_ms]\n", argv[0]);
+            fprintf(stderr, "  -s  not accept single-connection mode\n  -d  deny all commands\n");
+            return 1;
+        }
+    }
+
+    fd = stub_server_listen(&port);
+    if (fd < 0) {
+        perror("listen");
+        return 1;
+    }
+
+    printf("TACACS+ stub server listening on 127.0.0.1:%d\n", port);
+    fflush(stdout);
+    return stub_server_run(fd, &config) < 0;
+}
+#endif
@@ -0,0 +1,20 @@
+/* tacacs_stub_server.h -- minimal TACACS+ authorization server for bash plugin benchmark. */
+
+#if !defined (_TACACS_STUB_SERVER_H_)
+#define _TACACS_STUB_SERVER_H_
+
+/* Stub server behavior */
+typedef struct {
+    const char *key;
+    int single_connect;
+    int deny;
+    int delay_ms;
+} stub_server_config_t;
+
+/* Listen on 127.0.0.1:port, port 0 pick a free port, return the socket and set the port. */
+int stub_server_listen(int *port);
+
+/* Serve clients connected to listen_fd until killed. */
+int stub_server_run(int listen_fd, const stub_server_config_t *config);
+
+#endif /* _TACACS_STUB_SERVER_H_ */